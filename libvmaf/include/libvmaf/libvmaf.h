@@ -45,6 +45,7 @@ enum VmafOutputFormat {
     VMAF_OUTPUT_FORMAT_JSON,
     VMAF_OUTPUT_FORMAT_CSV,
     VMAF_OUTPUT_FORMAT_SUB,
+    VMAF_OUTPUT_FORMAT_BIN,
 };
 
 enum VmafPoolingMethod {
@@ -151,6 +152,85 @@ int vmaf_use_feature(VmafContext *vmaf, const char *feature_name,
 int vmaf_import_feature_score(VmafContext *vmaf, const char *feature_name,
                               double value, unsigned index);
 
+/**
+ * Receives the scores released by a context with a score window,
+ * see `vmaf_set_score_window()`.
+ */
+typedef void (*VmafScoreConsumer)(void *cookie, const char *feature_name,
+                                  double score, unsigned index);
+
+/**
+ * Bound the memory held for per-picture scores, for unbounded or live input.
+ * Scores are kept for the last `window` to 2 * `window` pictures read. Older
+ * scores are released in batches: each is passed to `consumer` and then
+ * dropped. Flushing releases all remaining scores. The scores of the models
+ * registered via `vmaf_use_features_from_model()` are predicted before the
+ * features they use are released, so these models have to stay valid until
+ * the context is flushed.
+ *
+ * `vmaf_feature_score_pooled()` and `vmaf_score_pooled()` keep working for
+ * intervals which cover all released pictures, from running aggregates of
+ * the released scores. Other intervals have to lie within the kept pictures.
+ *
+ * This must be called before any feature extractor is registered.
+ *
+ * @param vmaf     The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param window   Minimum number of pictures to keep scores of.
+ *
+ * @param consumer Called with each released score, in picture order, or NULL.
+ *                 It runs with the scores of the context locked, and must
+ *                 not call back into libvmaf with the same context.
+ *
+ * @param cookie   Passed to `consumer`.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_set_score_window(VmafContext *vmaf, unsigned window,
+                          VmafScoreConsumer consumer, void *cookie);
+
+enum VmafFrameCallbackFlags {
+    VMAF_FRAME_CALLBACK_PREDICT = 1 << 0,
+};
+
+/**
+ * Called once the scores of a picture are complete,
+ * see `vmaf_set_frame_callback()`.
+ */
+typedef void (*VmafFrameCallback)(void *cookie, unsigned index);
+
+/**
+ * Get notified as soon as all scores of a picture are written, instead of
+ * polling for them. `callback` fires once for every picture read, after all
+ * registered feature extractors are done with it. Temporal feature
+ * extractors finish a picture while extracting the next one, so a picture
+ * completes once its successor is extracted, or the context is flushed.
+ *
+ * `callback` runs on the thread which completes the picture: one of the
+ * `n_threads` workers, or the caller of `vmaf_read_pictures()`. Pictures may
+ * complete out of order. From `callback`, the scores of the picture can be
+ * read with `vmaf_feature_score_at_index()` and `vmaf_score_at_index()`.
+ *
+ * This must be called before any picture is read.
+ *
+ * @param vmaf     The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param callback Called with the index of each completed picture.
+ *
+ * @param cookie   Passed to `callback`.
+ *
+ * @param flags    `VMAF_FRAME_CALLBACK_PREDICT`: predict the scores of the
+ *                 models registered via `vmaf_use_features_from_model()`
+ *                 before calling `callback`, for the pictures which are not
+ *                 skipped by `n_subsample`.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_set_frame_callback(VmafContext *vmaf, VmafFrameCallback callback,
+                            void *cookie, unsigned flags);
+
 /**
  * Read a pair of pictures and queue them for eventual feature extraction.
  * This should be called after feature extractors are registered via
@@ -175,6 +255,47 @@ int vmaf_import_feature_score(VmafContext *vmaf, const char *feature_name,
 int vmaf_read_pictures(VmafContext *vmaf, VmafPicture *ref, VmafPicture *dist,
                        unsigned index);
 
+/**
+ * Read one reference picture and `cnt` distorted pictures scored against
+ * it, one for each of `cnt` contexts, e.g. the renditions of an encoding
+ * ladder. Each context scores its distorted picture with its own feature
+ * extractors, feature collector and output, as with `vmaf_read_pictures()`.
+ * Data derived from the reference alone, like its float conversion, the
+ * motion blur, the CAMBI source score and the integer ADM wavelet
+ * transform, is computed once per picture and shared between the contexts.
+ * The reference statistics of VIF are not shared: the VIF kernels compute
+ * them in the same pass as the distorted and cross terms, so every context
+ * still filters the reference picture for VIF.
+ *
+ * The contexts take ownership of `ref` and of every picture in `dist`.
+ * When you're done reading pictures call this function again with both
+ * `ref` and `dist` set to NULL to flush all contexts.
+ *
+ * The contexts read their pictures in order. If `vmaf[i]` fails to read
+ * its pictures, `vmaf[0]` to `vmaf[i - 1]` have read picture `index` and
+ * go on scoring it, `vmaf[i]` is left as a failed `vmaf_read_pictures()`
+ * leaves it and the contexts after it have not seen picture `index` at all.
+ * `ref` and every picture in `dist` are released either way, except when
+ * the arguments themselves are invalid, in which case nothing is read or
+ * released.
+ *
+ * @param vmaf  `cnt` VMAF contexts allocated with `vmaf_init()`.
+ *
+ * @param cnt   Number of contexts and distorted pictures.
+ *
+ * @param ref   Reference picture.
+ *
+ * @param dist  `cnt` distorted pictures, `dist[i]` goes to `vmaf[i]`.
+ *
+ * @param index Picture index.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_read_pictures_multi(VmafContext **vmaf, unsigned cnt,
+                             VmafPicture *ref, VmafPicture *dist,
+                             unsigned index);
+
 /**
  * Predict VMAF score at specific index.
  *
@@ -309,6 +430,17 @@ int vmaf_close(VmafContext *vmaf);
 /**
  * Write VMAF stats to an output file.
  *
+ * `VMAF_OUTPUT_FORMAT_BIN` is a columnar format for tools which do not need
+ * text. All fields are little-endian:
+ *
+ *   - magic "VMAFBIN\0", then uint32 version (1), feature count F, frame
+ *     count N and pooling method count P
+ *   - F feature names, each a uint32 length and that many bytes
+ *   - N uint32 frame numbers
+ *   - F columns of N float64 scores, NaN where a frame has no score
+ *   - F rows of P float64 pooled scores, by `enum VmafPoolingMethod` from
+ *     `VMAF_POOL_METHOD_MIN`, NaN where pooling failed
+ *
  * @param vmaf         The VMAF context allocated with `vmaf_init()`.
  *
  * @param output_path  Output file path.
@@ -322,6 +454,30 @@ int vmaf_close(VmafContext *vmaf);
 int vmaf_write_output(VmafContext *vmaf, const char *output_path,
                       enum VmafOutputFormat fmt);
 
+/**
+ * Write per-picture scores to an output file while pictures are read, rather
+ * than all at once with `vmaf_write_output()`. A picture is written once it
+ * and all pictures with lower indices are complete, see
+ * `vmaf_set_frame_callback()`, and flushing the context finishes the file.
+ * The scores of the models registered via `vmaf_use_features_from_model()`
+ * are predicted before a picture is written. The columns are the features
+ * present when the first picture is written.
+ *
+ * This must be called before any picture is read.
+ *
+ * @param vmaf         The VMAF context allocated with `vmaf_init()`.
+ *
+ * @param output_path  Output file path.
+ *
+ * @param fmt          Output file format, one of the line-oriented
+ *                     `VMAF_OUTPUT_FORMAT_CSV` and `VMAF_OUTPUT_FORMAT_SUB`.
+ *
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_set_output_stream(VmafContext *vmaf, const char *output_path,
+                           enum VmafOutputFormat fmt);
+
 /**
  * Get libvmaf version.
  */
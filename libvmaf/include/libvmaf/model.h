@@ -87,6 +87,24 @@ int vmaf_model_collection_feature_overload(VmafModel *model,
 
 void vmaf_model_collection_destroy(VmafModelCollection *model_collection);
 
+/**
+ * Write a model, followed by the models of model_collection if it is not
+ * NULL, to a compiled binary model file. vmaf_model_load_from_path() and
+ * vmaf_model_collection_load_from_path() recognize these files and map
+ * them instead of parsing JSON. Only RBF kernel SVR models are supported.
+ *
+ * @param model            Model, or first model of a collection.
+ *
+ * @param model_collection Remaining models of a collection, or NULL.
+ *
+ * @param path             Output file path.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_model_write_binary(VmafModel *model,
+                            VmafModelCollection *model_collection,
+                            const char *path);
+
 #ifdef __cplusplus
 }
 #endif
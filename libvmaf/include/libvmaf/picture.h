@@ -49,6 +49,101 @@ int vmaf_picture_alloc(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
 
 int vmaf_picture_unref(VmafPicture *pic);
 
+typedef void (*VmafPictureReleaseCallback)(VmafPicture *pic, void *cookie);
+
+/**
+ * Wrap caller owned picture data in a `VmafPicture` without copying it.
+ * `release` is called with the wrapped picture and `cookie` once the last
+ * reference is dropped with `vmaf_picture_unref()`, which may happen on a
+ * worker thread, until then the data must stay valid and unchanged.
+ *
+ * The SIMD paths of the feature extractors read whole vectors from the
+ * picture, so the data is only wrapped as is if it has the layout of
+ * `vmaf_picture_alloc()`: every plane is 32-byte aligned, and its stride is
+ * a multiple of 32 bytes spanning the width rounded up to 32 samples.
+ * Other pictures are copied, and `release` is called before returning.
+ *
+ * @param     pic The picture to fill in.
+ *
+ * @param pix_fmt Pixel format of the data.
+ *
+ * @param     bpc Bitdepth of the data, samples wider than 8 bits take two
+ *                bytes.
+ *
+ * @param       w Width of the luma plane.
+ *
+ * @param       h Height of the luma plane.
+ *
+ * @param    data Plane pointers, only the first is used for
+ *                `VMAF_PIX_FMT_YUV400P`.
+ *
+ * @param  stride Plane strides in bytes.
+ *
+ * @param release Callback to hand the data back, may be NULL.
+ *
+ * @param  cookie Passed on to `release`.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error, in which
+ *         case the data stays with the caller and `release` is not called.
+ */
+int vmaf_picture_wrap(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
+                      unsigned bpc, unsigned w, unsigned h,
+                      void *const data[3], const ptrdiff_t stride[3],
+                      VmafPictureReleaseCallback release, void *cookie);
+
+typedef struct VmafPicturePool VmafPicturePool;
+
+/**
+ * Allocate a pool of `pic_cnt` pictures sharing the same format and size.
+ * Pictures taken from the pool go back to it when their last reference is
+ * dropped with `vmaf_picture_unref()`, so that their buffers are recycled
+ * instead of being allocated for every frame.
+ *
+ * @param     pool The pool to allocate.
+ *
+ * @param  pix_fmt Pixel format of the pictures.
+ *
+ * @param      bpc Bitdepth of the pictures.
+ *
+ * @param        w Width of the pictures.
+ *
+ * @param        h Height of the pictures.
+ *
+ * @param  pic_cnt Number of pictures in the pool, this is the most pictures
+ *                 that can be in flight at once.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_picture_pool_init(VmafPicturePool **pool,
+                           enum VmafPixelFormat pix_fmt, unsigned bpc,
+                           unsigned w, unsigned h, unsigned pic_cnt);
+
+/**
+ * Take a picture from the pool, waiting for one to be returned if all of
+ * them are in use. Unlike `vmaf_picture_alloc()`, the picture data is not
+ * cleared and holds whatever the previous user left there. A call waiting
+ * when the pool is closed returns -EINVAL.
+ *
+ * @param pool The pool to take the picture from.
+ *
+ * @param  pic The picture to fill in.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_picture_pool_get(VmafPicturePool *pool, VmafPicture *pic);
+
+/**
+ * Close a picture pool. Pictures that are still in use stay valid, the
+ * pool is freed once the last one of them is returned and every
+ * `vmaf_picture_pool_get()` waiting on it has returned. The pool must not
+ * be used after this call.
+ *
+ * @param pool The pool to close.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_picture_pool_close(VmafPicturePool *pool);
+
 #ifdef __cplusplus
 }
 #endif
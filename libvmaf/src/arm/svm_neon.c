@@ -0,0 +1,86 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+
+#include <arm_neon.h>
+
+#include "svm_neon.h"
+
+// Taylor coefficients of exp(r), 1 / 12! down to 1 / 0!
+static const double exp_coef[] = {
+    2.08767569878680989792e-9, 2.50521083854417187751e-8,
+    2.75573192239858906526e-7, 2.75573192239858906526e-6,
+    2.48015873015873015873e-5, 1.98412698412698412698e-4,
+    1.38888888888888888889e-3, 8.33333333333333333333e-3,
+    4.16666666666666666667e-2, 1.66666666666666666667e-1,
+    5.00000000000000000000e-1, 1.0, 1.0,
+};
+
+// exp(x) for x <= 0, within a few ulp, or nan for nan
+static inline float64x2_t exp_neg_f64(float64x2_t x)
+{
+    // below this, 2^n would be subnormal and the kernel term is negligible
+    x = vmaxq_f64(x, vdupq_n_f64(-708.));
+
+    const float64x2_t n =
+        vrndnq_f64(vmulq_f64(x, vdupq_n_f64(1.44269504088896341)));
+    float64x2_t r = vfmsq_f64(x, n, vdupq_n_f64(6.93145751953125e-1));
+    r = vfmsq_f64(r, n, vdupq_n_f64(1.42860682030941723212e-6));
+
+    float64x2_t p = vdupq_n_f64(exp_coef[0]);
+    for (unsigned k = 1; k < sizeof(exp_coef) / sizeof(exp_coef[0]); k++)
+        p = vfmaq_f64(vdupq_n_f64(exp_coef[k]), p, r);
+
+    const int64x2_t e =
+        vshlq_n_s64(vaddq_s64(vcvtq_s64_f64(n), vdupq_n_s64(1023)), 52);
+    return vmulq_f64(p, vreinterpretq_f64_s64(e));
+}
+
+void svm_rbf_neon(const double *sv_coef, const double *sv, unsigned dim,
+                  unsigned stride, double gamma, const double *x,
+                  unsigned cnt, double *y)
+{
+    const float64x2_t neg_gamma = vdupq_n_f64(-gamma);
+
+    for (unsigned c = 0; c < cnt; c++) {
+        const double *xc = &x[c * dim];
+        float64x2_t acc0 = vdupq_n_f64(0.);
+        float64x2_t acc1 = vdupq_n_f64(0.);
+
+        // stride is a multiple of 8, two blocks of 2 per iteration
+        for (unsigned i = 0; i < stride; i += 4) {
+            float64x2_t sum0 = vdupq_n_f64(0.);
+            float64x2_t sum1 = vdupq_n_f64(0.);
+            for (unsigned j = 0; j < dim; j++) {
+                const float64x2_t xj = vdupq_n_f64(xc[j]);
+                const float64x2_t d0 =
+                    vsubq_f64(xj, vld1q_f64(&sv[j * stride + i]));
+                const float64x2_t d1 =
+                    vsubq_f64(xj, vld1q_f64(&sv[j * stride + i + 2]));
+                sum0 = vfmaq_f64(sum0, d0, d0);
+                sum1 = vfmaq_f64(sum1, d1, d1);
+            }
+            const float64x2_t k0 = exp_neg_f64(vmulq_f64(neg_gamma, sum0));
+            const float64x2_t k1 = exp_neg_f64(vmulq_f64(neg_gamma, sum1));
+            acc0 = vfmaq_f64(acc0, vld1q_f64(&sv_coef[i]), k0);
+            acc1 = vfmaq_f64(acc1, vld1q_f64(&sv_coef[i + 2]), k1);
+        }
+
+        y[c] = vaddvq_f64(vaddq_f64(acc0, acc1));
+    }
+}
@@ -0,0 +1,27 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+
+#ifndef ARM_NEON_SVM_H_
+#define ARM_NEON_SVM_H_
+
+void svm_rbf_neon(const double *sv_coef, const double *sv, unsigned dim,
+                  unsigned stride, double gamma, const double *x,
+                  unsigned cnt, double *y);
+
+#endif /* ARM_NEON_SVM_H_ */
@@ -0,0 +1,700 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+
+#if HAVE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "libvmaf/model.h"
+#include "binary_model.h"
+#include "dict.h"
+#include "log.h"
+#include "mem.h"
+#include "model.h"
+#include "svm.h"
+
+#define BINARY_MODEL_ALIGN 64
+#define BINARY_MODEL_HEADER_SZ 24
+
+enum BinaryModelFlags {
+    BINARY_MODEL_SCORE_CLIP = 1 << 0,
+    BINARY_MODEL_TRANSFORM = 1 << 1,
+    BINARY_MODEL_TRANSFORM_ENABLED = 1 << 2,
+    BINARY_MODEL_P0 = 1 << 3,
+    BINARY_MODEL_P1 = 1 << 4,
+    BINARY_MODEL_P2 = 1 << 5,
+    BINARY_MODEL_KNOTS = 1 << 6,
+    BINARY_MODEL_OUT_LTE_IN = 1 << 7,
+    BINARY_MODEL_OUT_GTE_IN = 1 << 8,
+};
+
+struct VmafModelMap {
+    atomic_int ref_cnt;
+    const uint8_t *data;
+    size_t sz;
+    bool mapped;
+};
+
+static bool host_is_little_endian(void)
+{
+    const uint16_t one = 1;
+    return *(const uint8_t *) &one;
+}
+
+static int model_map_open(VmafModelMap **map, const char *path)
+{
+    FILE *in = fopen(path, "rb");
+    if (!in) return -EINVAL;
+
+    int err = 0;
+    VmafModelMap *const m = *map = malloc(sizeof(*m));
+    if (!m) {
+        err = -ENOMEM;
+        goto exit;
+    }
+    memset(m, 0, sizeof(*m));
+    atomic_init(&m->ref_cnt, 1);
+
+#if HAVE_MMAP
+    struct stat st;
+    if (!fstat(fileno(in), &st) && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE,
+                          fileno(in), 0);
+        if (data != MAP_FAILED) {
+            m->data = data;
+            m->sz = st.st_size;
+            m->mapped = true;
+            goto exit;
+        }
+    }
+#endif
+
+    // no mmap(), read the file into a buffer of the same alignment
+    long sz;
+    if (fseek(in, 0, SEEK_END) || (sz = ftell(in)) <= 0 ||
+        fseek(in, 0, SEEK_SET))
+    {
+        err = -EINVAL;
+        goto free_map;
+    }
+    uint8_t *data = aligned_malloc(sz, BINARY_MODEL_ALIGN);
+    if (!data) {
+        err = -ENOMEM;
+        goto free_map;
+    }
+    if (fread(data, 1, sz, in) != (size_t) sz) {
+        aligned_free(data);
+        err = -EIO;
+        goto free_map;
+    }
+    m->data = data;
+    m->sz = sz;
+    goto exit;
+
+free_map:
+    free(m);
+    *map = NULL;
+exit:
+    fclose(in);
+    return err;
+}
+
+void vmaf_model_map_unref(VmafModelMap *map)
+{
+    if (!map) return;
+    if (atomic_fetch_sub(&map->ref_cnt, 1) != 1) return;
+
+#if HAVE_MMAP
+    if (map->mapped)
+        munmap((void *) map->data, map->sz);
+    else
+#endif
+        aligned_free((void *) map->data);
+    free(map);
+}
+
+typedef struct BinaryReader {
+    const uint8_t *data;
+    size_t sz, pos;
+    int err;
+} BinaryReader;
+
+static const uint8_t *read_bytes(BinaryReader *r, size_t sz)
+{
+    if (r->err) return NULL;
+    if (sz > r->sz - r->pos) {
+        r->err = -EINVAL;
+        return NULL;
+    }
+    const uint8_t *b = r->data + r->pos;
+    r->pos += sz;
+    return b;
+}
+
+static uint32_t read_u32(BinaryReader *r)
+{
+    const uint8_t *b = read_bytes(r, 4);
+    if (!b) return 0;
+    return b[0] | b[1] << 8 | b[2] << 16 | (uint32_t) b[3] << 24;
+}
+
+static uint64_t read_u64(BinaryReader *r)
+{
+    const uint64_t lo = read_u32(r);
+    return lo | (uint64_t) read_u32(r) << 32;
+}
+
+static double read_f64(BinaryReader *r)
+{
+    const uint64_t bits = read_u64(r);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static char *read_str(BinaryReader *r)
+{
+    const uint32_t len = read_u32(r);
+    const uint8_t *b = read_bytes(r, len);
+    if (!b) return NULL;
+    char *str = malloc(len + 1);
+    if (!str) {
+        r->err = -ENOMEM;
+        return NULL;
+    }
+    memcpy(str, b, len);
+    str[len] = '\0';
+    return str;
+}
+
+static void read_align(BinaryReader *r)
+{
+    read_bytes(r, (BINARY_MODEL_ALIGN - r->pos % BINARY_MODEL_ALIGN) %
+                  BINARY_MODEL_ALIGN);
+}
+
+static int read_header(BinaryReader *r, unsigned *model_cnt)
+{
+    const uint8_t *magic = read_bytes(r, 8);
+    if (!magic || memcmp(magic, VMAF_BINARY_MODEL_MAGIC, 8))
+        return -EINVAL;
+    if (read_u32(r) != VMAF_BINARY_MODEL_VERSION) {
+        vmaf_log(VMAF_LOG_LEVEL_ERROR,
+                 "unsupported binary model version\n");
+        return -EINVAL;
+    }
+    *model_cnt = read_u32(r);
+    if (read_u64(r) != r->sz) return -EINVAL;
+    return r->err;
+}
+
+static int read_feature_opts(BinaryReader *r, VmafModelFeature *feature)
+{
+    const uint32_t cnt = read_u32(r);
+    for (unsigned i = 0; i < cnt && !r->err; i++) {
+        char *key = read_str(r);
+        char *val = read_str(r);
+        if (key && val) {
+            int err = vmaf_dictionary_set(&feature->opts_dict, key, val,
+                                          VMAF_DICT_DO_NOT_OVERWRITE);
+            if (err) r->err = err;
+        }
+        free(key);
+        free(val);
+    }
+    return r->err;
+}
+
+static int read_support_vectors(BinaryReader *r, VmafModel *model,
+                                VmafModelMap *map)
+{
+    const unsigned stride = model->sv_stride;
+    // the support vector count comes from the file
+    if (model->svm->l < 0) return -EINVAL;
+    if (!stride || stride % VMAF_MODEL_SV_ALIGN ||
+        stride < (unsigned) model->svm->l)
+        return -EINVAL;
+    if (stride > r->sz / 8 / (model->sv_dim + 1))
+        return -EINVAL;
+    const size_t cnt = (size_t) stride * (model->sv_dim + 1);
+
+    read_align(r);
+    const uint8_t *sv = read_bytes(r, sizeof(double) * cnt);
+    if (!sv) return r->err;
+
+    if (host_is_little_endian()) {
+        model->sv_coef = (const double *) sv;
+        model->sv = model->sv_coef + stride;
+        model->map = map;
+        atomic_fetch_add(&map->ref_cnt, 1);
+        return 0;
+    }
+
+    double *copy = aligned_malloc(sizeof(*copy) * cnt, BINARY_MODEL_ALIGN);
+    if (!copy) return -ENOMEM;
+    BinaryReader matrix = { .data = sv, .sz = sizeof(double) * cnt };
+    for (size_t i = 0; i < cnt; i++)
+        copy[i] = read_f64(&matrix);
+    model->sv_coef = copy;
+    model->sv = copy + stride;
+    return 0;
+}
+
+static int read_svm(VmafModel *model, int svm_type, unsigned sv_cnt,
+                    double gamma, double rho)
+{
+    struct svm_model *svm = model->svm = malloc(sizeof(*svm));
+    if (!svm) return -ENOMEM;
+    memset(svm, 0, sizeof(*svm));
+
+    svm->param.svm_type = svm_type;
+    svm->param.kernel_type = RBF;
+    svm->param.gamma = gamma;
+    svm->nr_class = 2;
+    svm->l = sv_cnt;
+
+    // the coefficients are read with the dense support vectors
+    svm->rho = malloc(sizeof(*svm->rho));
+    if (!svm->rho) return -ENOMEM;
+    svm->rho[0] = rho;
+
+    return 0;
+}
+
+static int read_model(VmafModel **model, VmafModelConfig *cfg,
+                      VmafModelMap *map, uint64_t offset)
+{
+    if (offset % BINARY_MODEL_ALIGN || offset > map->sz) return -EINVAL;
+    BinaryReader r = { .data = map->data, .sz = map->sz, .pos = offset };
+
+    VmafModel *const m = malloc(sizeof(*m));
+    if (!m) return -ENOMEM;
+    memset(m, 0, sizeof(*m));
+
+    int err = 0;
+    const uint32_t type = read_u32(&r);
+    const uint32_t norm_type = read_u32(&r);
+    const uint32_t svm_type = read_u32(&r);
+    const uint32_t n_features = read_u32(&r);
+    const uint32_t n_knots = read_u32(&r);
+    const uint32_t sv_cnt = read_u32(&r);
+    const uint32_t sv_dim = read_u32(&r);
+    const uint32_t sv_stride = read_u32(&r);
+    const uint32_t flags = read_u32(&r);
+    if (r.err) goto fail;
+
+    err = -EINVAL;
+    if (type > VMAF_MODEL_RESIDUE_BOOTSTRAP_SVM_NUSVR) goto fail;
+    if (norm_type > VMAF_MODEL_NORMALIZATION_TYPE_LINEAR_RESCALE) goto fail;
+    if (svm_type != NU_SVR && svm_type != EPSILON_SVR) goto fail;
+    if (!n_features || n_features > sv_dim) goto fail;
+    if (n_features > map->sz / 16 || n_knots > map->sz / 16) goto fail;
+    if (sv_dim > map->sz / 8) goto fail;
+    if (sv_cnt > INT32_MAX) goto fail;
+
+    m->type = type;
+    m->norm_type = norm_type;
+    m->slope = read_f64(&r);
+    m->intercept = read_f64(&r);
+    const double clip_min = read_f64(&r);
+    const double clip_max = read_f64(&r);
+    const double p0 = read_f64(&r);
+    const double p1 = read_f64(&r);
+    const double p2 = read_f64(&r);
+    const double gamma = read_f64(&r);
+    const double rho = read_f64(&r);
+
+    if ((flags & BINARY_MODEL_SCORE_CLIP) &&
+        !(cfg->flags & VMAF_MODEL_FLAG_DISABLE_CLIP))
+    {
+        m->score_clip.enabled = true;
+        m->score_clip.min = clip_min;
+        m->score_clip.max = clip_max;
+    }
+
+    m->score_transform.enabled = !!(flags & BINARY_MODEL_TRANSFORM_ENABLED);
+    if ((flags & BINARY_MODEL_TRANSFORM) &&
+        (cfg->flags & VMAF_MODEL_FLAG_ENABLE_TRANSFORM))
+    {
+        m->score_transform.enabled = true;
+    }
+    m->score_transform.p0.enabled = !!(flags & BINARY_MODEL_P0);
+    m->score_transform.p0.value = p0;
+    m->score_transform.p1.enabled = !!(flags & BINARY_MODEL_P1);
+    m->score_transform.p1.value = p1;
+    m->score_transform.p2.enabled = !!(flags & BINARY_MODEL_P2);
+    m->score_transform.p2.value = p2;
+    m->score_transform.knots.enabled = !!(flags & BINARY_MODEL_KNOTS);
+    m->score_transform.out_lte_in = !!(flags & BINARY_MODEL_OUT_LTE_IN);
+    m->score_transform.out_gte_in = !!(flags & BINARY_MODEL_OUT_GTE_IN);
+
+    err = -ENOMEM;
+    m->name = vmaf_model_generate_name(cfg);
+    if (!m->name) goto fail;
+    m->feature = malloc(sizeof(*m->feature) * n_features);
+    if (!m->feature) goto fail;
+    memset(m->feature, 0, sizeof(*m->feature) * n_features);
+    m->n_features = n_features;
+    m->score_transform.knots.list =
+        malloc(sizeof(VmafPoint) * (n_knots ? n_knots : 1));
+    if (!m->score_transform.knots.list) goto fail;
+    m->score_transform.knots.n_knots = n_knots;
+
+    for (unsigned i = 0; i < n_features; i++) {
+        m->feature[i].slope = read_f64(&r);
+        m->feature[i].intercept = read_f64(&r);
+    }
+    for (unsigned i = 0; i < n_knots; i++) {
+        m->score_transform.knots.list[i].x = read_f64(&r);
+        m->score_transform.knots.list[i].y = read_f64(&r);
+    }
+
+    err = read_svm(m, svm_type, sv_cnt, gamma, rho);
+    if (err) goto fail;
+
+    for (unsigned i = 0; i < n_features && !r.err; i++) {
+        m->feature[i].name = read_str(&r);
+        read_feature_opts(&r, &m->feature[i]);
+    }
+    err = r.err;
+    if (err) goto fail;
+
+    m->sv_dim = sv_dim;
+    m->sv_stride = sv_stride;
+    err = read_support_vectors(&r, m, map);
+    if (err) goto fail;
+
+    *model = m;
+    return 0;
+
+fail:
+    vmaf_model_destroy(m);
+    return err;
+}
+
+static int read_models(VmafModel **model,
+                       VmafModelCollection **model_collection,
+                       VmafModelConfig *cfg, const char *path)
+{
+    VmafModelMap *map;
+    int err = model_map_open(&map, path);
+    if (err) return err;
+
+    BinaryReader r = { .data = map->data, .sz = map->sz };
+    unsigned cnt;
+    err = read_header(&r, &cnt);
+    if (err) goto unref;
+    if (!cnt || (cnt > 1) != !!model_collection || cnt > map->sz / 8 ||
+        cnt > VMAF_BINARY_MODEL_MAX_CNT)
+    {
+        err = -EINVAL;
+        goto unref;
+    }
+
+    VmafModelConfig c = *cfg;
+    char *name = vmaf_model_generate_name(cfg);
+    if (!name) {
+        err = -ENOMEM;
+        goto unref;
+    }
+    // "_%04d" suffix, four digits since cnt <= VMAF_BINARY_MODEL_MAX_CNT
+    const size_t collection_name_sz = strlen(name) + 5 + 1;
+    char *collection_name = malloc(collection_name_sz);
+    if (!collection_name) {
+        err = -ENOMEM;
+        goto free_name;
+    }
+
+    VmafModel *first = NULL;
+    VmafModelCollection *mc = NULL;
+    for (unsigned i = 0; i < cnt; i++) {
+        // named like the models of a JSON collection, see read_json_model.c
+        if (i) {
+            snprintf(collection_name, collection_name_sz, "%s_%04d", name,
+                     i);
+        }
+        c.name = i ? collection_name : name;
+
+        const uint64_t offset = read_u64(&r);
+        if ((err = r.err)) goto fail;
+        VmafModel *m = NULL;
+        err = read_model(&m, &c, map, offset);
+        if (err) goto fail;
+        if (!i) {
+            first = m;
+            continue;
+        }
+        err = vmaf_model_collection_append(&mc, m);
+        if (err) {
+            vmaf_model_destroy(m);
+            goto fail;
+        }
+    }
+
+    *model = first;
+    if (model_collection) *model_collection = mc;
+    goto free_collection_name;
+
+fail:
+    vmaf_model_destroy(first);
+    vmaf_model_collection_destroy(mc);
+free_collection_name:
+    free(collection_name);
+free_name:
+    free(name);
+unref:
+    vmaf_model_map_unref(map);
+    return err;
+}
+
+bool vmaf_binary_model_probe(const char *path)
+{
+    FILE *in = fopen(path, "rb");
+    if (!in) return false;
+    char magic[8];
+    const bool match = fread(magic, 1, sizeof(magic), in) == sizeof(magic) &&
+                       !memcmp(magic, VMAF_BINARY_MODEL_MAGIC, sizeof(magic));
+    fclose(in);
+    return match;
+}
+
+int vmaf_read_binary_model_from_path(VmafModel **model, VmafModelConfig *cfg,
+                                     const char *path)
+{
+    return read_models(model, NULL, cfg, path);
+}
+
+int vmaf_read_binary_model_collection_from_path(VmafModel **model,
+                                         VmafModelCollection **model_collection,
+                                         VmafModelConfig *cfg,
+                                         const char *path)
+{
+    return read_models(model, model_collection, cfg, path);
+}
+
+typedef struct BinaryWriter {
+    FILE *outfile;
+    uint64_t pos;
+    int err;
+} BinaryWriter;
+
+static void write_bytes(BinaryWriter *w, const void *data, size_t sz)
+{
+    if (w->err) return;
+    if (fwrite(data, 1, sz, w->outfile) != sz)
+        w->err = -EIO;
+    w->pos += sz;
+}
+
+static void write_u32(BinaryWriter *w, uint32_t value)
+{
+    const uint8_t b[4] = { value, value >> 8, value >> 16, value >> 24 };
+    write_bytes(w, b, sizeof(b));
+}
+
+static void write_u64(BinaryWriter *w, uint64_t value)
+{
+    write_u32(w, value);
+    write_u32(w, value >> 32);
+}
+
+static void write_f64(BinaryWriter *w, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    write_u64(w, bits);
+}
+
+static void write_str(BinaryWriter *w, const char *str)
+{
+    const size_t len = strlen(str);
+    write_u32(w, len);
+    write_bytes(w, str, len);
+}
+
+static void write_align(BinaryWriter *w)
+{
+    static const uint8_t zero[BINARY_MODEL_ALIGN];
+    write_bytes(w, zero, (BINARY_MODEL_ALIGN - w->pos % BINARY_MODEL_ALIGN) %
+                         BINARY_MODEL_ALIGN);
+}
+
+static unsigned model_flags(const VmafModel *model)
+{
+    unsigned flags = 0;
+    if (model->score_clip.enabled)
+        flags |= BINARY_MODEL_SCORE_CLIP;
+    // the JSON model does not record a score_transform without any of these
+    if (model->score_transform.enabled || model->score_transform.p0.enabled ||
+        model->score_transform.p1.enabled || model->score_transform.p2.enabled ||
+        model->score_transform.knots.enabled ||
+        model->score_transform.out_lte_in || model->score_transform.out_gte_in)
+    {
+        flags |= BINARY_MODEL_TRANSFORM;
+    }
+    if (model->score_transform.enabled)
+        flags |= BINARY_MODEL_TRANSFORM_ENABLED;
+    if (model->score_transform.p0.enabled)
+        flags |= BINARY_MODEL_P0;
+    if (model->score_transform.p1.enabled)
+        flags |= BINARY_MODEL_P1;
+    if (model->score_transform.p2.enabled)
+        flags |= BINARY_MODEL_P2;
+    if (model->score_transform.knots.enabled)
+        flags |= BINARY_MODEL_KNOTS;
+    if (model->score_transform.out_lte_in)
+        flags |= BINARY_MODEL_OUT_LTE_IN;
+    if (model->score_transform.out_gte_in)
+        flags |= BINARY_MODEL_OUT_GTE_IN;
+    return flags;
+}
+
+static int write_model(BinaryWriter *w, VmafModel *model)
+{
+    const struct svm_model *svm = model->svm;
+    if (!svm || svm->param.kernel_type != RBF ||
+        (svm->param.svm_type != NU_SVR && svm->param.svm_type != EPSILON_SVR))
+    {
+        vmaf_log(VMAF_LOG_LEVEL_ERROR,
+                 "only RBF kernel SVR models can be compiled\n");
+        return -EINVAL;
+    }
+
+    double *packed = NULL;
+    const double *sv_coef = model->sv_coef;
+    unsigned sv_dim = model->sv_dim, sv_stride = model->sv_stride;
+    if (!model->sv) {
+        int err = vmaf_model_dense_support_vectors(model, &packed, &sv_dim,
+                                                   &sv_stride);
+        if (err) return err;
+        sv_coef = packed;
+    }
+
+    const unsigned n_knots = model->score_transform.knots.enabled ?
+                             model->score_transform.knots.n_knots : 0;
+
+    write_u32(w, model->type);
+    write_u32(w, model->norm_type);
+    write_u32(w, svm->param.svm_type);
+    write_u32(w, model->n_features);
+    write_u32(w, n_knots);
+    write_u32(w, svm->l);
+    write_u32(w, sv_dim);
+    write_u32(w, sv_stride);
+    write_u32(w, model_flags(model));
+
+    write_f64(w, model->slope);
+    write_f64(w, model->intercept);
+    write_f64(w, model->score_clip.min);
+    write_f64(w, model->score_clip.max);
+    write_f64(w, model->score_transform.p0.value);
+    write_f64(w, model->score_transform.p1.value);
+    write_f64(w, model->score_transform.p2.value);
+    write_f64(w, svm->param.gamma);
+    write_f64(w, svm->rho[0]);
+
+    for (unsigned i = 0; i < model->n_features; i++) {
+        write_f64(w, model->feature[i].slope);
+        write_f64(w, model->feature[i].intercept);
+    }
+    for (unsigned i = 0; i < n_knots; i++) {
+        write_f64(w, model->score_transform.knots.list[i].x);
+        write_f64(w, model->score_transform.knots.list[i].y);
+    }
+    for (unsigned i = 0; i < model->n_features; i++) {
+        const VmafDictionary *d = model->feature[i].opts_dict;
+        write_str(w, model->feature[i].name);
+        write_u32(w, d ? d->cnt : 0);
+        for (unsigned j = 0; d && j < d->cnt; j++) {
+            write_str(w, d->entry[j].key);
+            write_str(w, d->entry[j].val);
+        }
+    }
+
+    write_align(w);
+    for (size_t i = 0; i < (size_t) sv_stride * (sv_dim + 1); i++)
+        write_f64(w, sv_coef[i]);
+
+    if (packed) aligned_free(packed);
+    return w->err;
+}
+
+int vmaf_write_binary_model(VmafModel *model,
+                            VmafModelCollection *model_collection,
+                            const char *path)
+{
+    if (!model) return -EINVAL;
+    if (!path) return -EINVAL;
+
+    const unsigned cnt = 1 + (model_collection ? model_collection->cnt : 0);
+    uint64_t *offset = malloc(sizeof(*offset) * cnt);
+    if (!offset) return -ENOMEM;
+
+    int err = 0;
+    BinaryWriter w = { .outfile = fopen(path, "wb") };
+    if (!w.outfile) {
+        err = -EINVAL;
+        goto free_offset;
+    }
+
+    // offsets and size are written once the models are in place
+    write_bytes(&w, VMAF_BINARY_MODEL_MAGIC, 8);
+    write_u32(&w, VMAF_BINARY_MODEL_VERSION);
+    write_u32(&w, cnt);
+    write_u64(&w, 0);
+    for (unsigned i = 0; i < cnt; i++)
+        write_u64(&w, 0);
+
+    for (unsigned i = 0; i < cnt && !err; i++) {
+        write_align(&w);
+        offset[i] = w.pos;
+        err = write_model(&w, i ? model_collection->model[i - 1] : model);
+    }
+    if (err) goto close;
+
+    const uint64_t sz = w.pos;
+    if (fseek(w.outfile, BINARY_MODEL_HEADER_SZ - 8, SEEK_SET)) {
+        err = -EIO;
+        goto close;
+    }
+    write_u64(&w, sz);
+    for (unsigned i = 0; i < cnt; i++)
+        write_u64(&w, offset[i]);
+    err = w.err;
+
+close:
+    if (fclose(w.outfile) && !err)
+        err = -EIO;
+    if (err)
+        remove(path);
+free_offset:
+    free(offset);
+    return err;
+}
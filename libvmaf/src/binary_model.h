@@ -0,0 +1,77 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_BINARY_MODEL_H__
+#define __VMAF_BINARY_MODEL_H__
+
+#include <stdbool.h>
+
+#include "model.h"
+
+#define VMAF_BINARY_MODEL_MAGIC "VMAFMDL\0"
+#define VMAF_BINARY_MODEL_VERSION 2
+#define VMAF_BINARY_MODEL_MAX_CNT 10000
+
+/**
+ * Compiled model file, all values little-endian:
+ *
+ *   char[8]  magic, VMAF_BINARY_MODEL_MAGIC
+ *   u32      version, VMAF_BINARY_MODEL_VERSION
+ *   u32      model count, 1 for a model, more for a model collection,
+ *            at most VMAF_BINARY_MODEL_MAX_CNT
+ *   u64      file size
+ *   u64[]    file offset of each model record
+ *
+ * Model record, starting at a 64 byte boundary:
+ *
+ *   u32[9]   type, normalization type, svm type, feature count, knot count,
+ *            support vector count, support vector dimension and stride,
+ *            flags
+ *   f64[9]   slope, intercept, clip min and max, transform p0, p1 and p2,
+ *            rbf gamma, rho
+ *   f64[]    slope and intercept of each feature
+ *   f64[]    x and y of each knot
+ *   str[]    name of each feature, then the u32 count and key, value
+ *            pairs of its options; a str is a u32 length and its bytes
+ *   f64[]    stride coefficients, then one row of stride support vector
+ *            values per dimension, zero padded, starting at a 64 byte
+ *            boundary; see vmaf_model_dense_support_vectors()
+ *
+ * Only the RBF kernel SVR models the predictor evaluates densely can be
+ * compiled. The coefficients and support vectors are mapped and used in
+ * place.
+ */
+typedef struct VmafModelMap VmafModelMap;
+
+void vmaf_model_map_unref(VmafModelMap *map);
+
+bool vmaf_binary_model_probe(const char *path);
+
+int vmaf_read_binary_model_from_path(VmafModel **model, VmafModelConfig *cfg,
+                                     const char *path);
+
+int vmaf_read_binary_model_collection_from_path(VmafModel **model,
+                                         VmafModelCollection **model_collection,
+                                         VmafModelConfig *cfg,
+                                         const char *path);
+
+int vmaf_write_binary_model(VmafModel *model,
+                            VmafModelCollection *model_collection,
+                            const char *path);
+
+#endif /* __VMAF_BINARY_MODEL_H__ */
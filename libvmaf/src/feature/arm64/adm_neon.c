@@ -2,162 +2,722 @@
 
 #include <arm_neon.h>
 
-// Signed 32 Bits //
-// The macro instance int32x4_t accumulators and accumlates the multiplication of 4 int16x8_t vectors with a 4 elements filter.
-#define NEON_ADM_INSTANCE_ACCUM_AND_MACC_VEC_4_ELEMS_ARR_BY_4_ELEMENTS_FILTER_S32X4_LH(accum_name, init_vec, vec_name, filter_vec) \
-    int32x4_t accum_name##_l = vmlal_lane_s16(init_vec, vget_low_s16(vec_name[0]), filter_vec, 0);                                 \
-    int32x4_t accum_name##_h = vmlal_high_lane_s16(init_vec, vec_name[0], filter_vec, 0);                                          \
-    accum_name##_l = vmlal_lane_s16(accum_name##_l, vget_low_s16(vec_name[1]), filter_vec, 1);                                     \
-    accum_name##_h = vmlal_high_lane_s16(accum_name##_h, vec_name[1], filter_vec, 1);                                              \
-    accum_name##_l = vmlal_lane_s16(accum_name##_l, vget_low_s16(vec_name[2]), filter_vec, 2);                                     \
-    accum_name##_h = vmlal_high_lane_s16(accum_name##_h, vec_name[2], filter_vec, 2);                                              \
-    accum_name##_l = vmlal_lane_s16(accum_name##_l, vget_low_s16(vec_name[3]), filter_vec, 3);                                     \
-    accum_name##_h = vmlal_high_lane_s16(accum_name##_h, vec_name[3], filter_vec, 3);
-
-// The macro instance int32x4_t accumulators and accumlates the multiplication of 2 int16x8x2_t vectors with a 4 elements filter.
-#define NEON_ADM_INSTANCE_ACCUM_AND_MACC_PAIR_VEC_BY_4_ELEMENTS_FILTER_S32X4_LH(accum_name, vec_pair_1, vec_pair_2, init_vec, filter_vec) \
-    int32x4_t accum_name##_l = vmlal_lane_s16(init_vec, vget_low_s16(vec_pair_1.val[0]), filter_vec, 0);                                  \
-    int32x4_t accum_name##_h = vmlal_high_lane_s16(init_vec, vec_pair_1.val[0], filter_vec, 0);                                           \
-    accum_name##_l = vmlal_lane_s16(accum_name##_l, vget_low_s16(vec_pair_1.val[1]), filter_vec, 1);                                      \
-    accum_name##_h = vmlal_high_lane_s16(accum_name##_h, vec_pair_1.val[1], filter_vec, 1);                                               \
-    accum_name##_l = vmlal_lane_s16(accum_name##_l, vget_low_s16(vec_pair_2.val[0]), filter_vec, 2);                                      \
-    accum_name##_h = vmlal_high_lane_s16(accum_name##_h, vec_pair_2.val[0], filter_vec, 2);                                               \
-    accum_name##_l = vmlal_lane_s16(accum_name##_l, vget_low_s16(vec_pair_2.val[1]), filter_vec, 3);                                      \
-    accum_name##_h = vmlal_high_lane_s16(accum_name##_h, vec_pair_2.val[1], filter_vec, 3);
-
-// The macro takes low and high accumulators, shift them, unzip them into single int16x8_t vector, and stores it
-#define NEON_ADM_STORE_ZIPPED_ACCUM_LO_HI_WITH_RIGHT_SHIFT_S16x8(accum_name, shift_vec, store_pointer)  \
-    {                                                                                                   \
-        int16x8_t accum_name = vuzp1q_s16(vreinterpretq_s16_s32(vshlq_s32(accum_name##_l, shift_vec)),  \
-                                          vreinterpretq_s16_s32(vshlq_s32(accum_name##_h, shift_vec))); \
-        vst1q_s16(store_pointer, accum_name);                                                           \
-    }
-
-void adm_dwt2_8_neon(const uint8_t *src, const adm_dwt_band_t *dst,
-                     AdmBuffer *buf, int w, int h, int src_stride,
-                     int dst_stride)
-{
-    const int16_t shift_VP = 8;
-    const int16_t shift_HP = 16;
+void adm_dwt2_8_vert_neon(const uint8_t *src, int **ind_y, int i, int w,
+                          int src_stride, int16_t *tmplo, int16_t *tmphi)
+{
+    const uint8_t *p_src[4];
+    for (int k = 0; k < 4; k++)
+        p_src[k] = src + ind_y[k][i] * src_stride;
+
     const int32_t add_shift_VP = 128;
-    const int32_t add_shift_HP = 32768;
-
-    int **ind_y = buf->ind_y;
-    int **ind_x = buf->ind_x;
-
-    int16_t *tmplo = (int16_t *)buf->tmp_ref;
-    int16_t *tmphi = tmplo + w;
-
-    const int16x4_t filter_lo_vec = vld1_s16(dwt2_db2_coeffs_lo);
-    const int16x4_t filter_hi_vec = vld1_s16(dwt2_db2_coeffs_hi);
-    const int32x4_t normalize_vec_vp_lo = vdupq_n_s32((-1 * (int32_t)dwt2_db2_coeffs_lo_sum * add_shift_VP) + add_shift_VP);
-    const int32x4_t normalize_vec_vp_hi = vdupq_n_s32((-1 * (int32_t)dwt2_db2_coeffs_hi_sum * add_shift_VP) + add_shift_VP);
-    const int32x4_t shift_vp_vec = vdupq_n_s32(-shift_VP);
-    const int32x4_t add_shift_hp_vec = vdupq_n_s32(add_shift_HP);
-    const int32x4_t shift_hp_vec = vdupq_n_s32(-shift_HP);
-
-    for (int i = 0; i < (h + 1) / 2; ++i)
-    {
-        /* Vertical pass. */
-        const uint8_t *p_src_0 = src + ind_y[0][i] * src_stride;
-        const uint8_t *p_src_1 = src + ind_y[1][i] * src_stride;
-        const uint8_t *p_src_2 = src + ind_y[2][i] * src_stride;
-        const uint8_t *p_src_3 = src + ind_y[3][i] * src_stride;
-
-        for (int j = 0; j < w - 15; j += 16, p_src_0 += 16, p_src_1 += 16, p_src_2 += 16, p_src_3 += 16)
-        {
-            uint8x16_t u_8[4];
-            int16x8_t s_16_l[4], s_16_h[4];
-
-            u_8[0] = vld1q_u8(p_src_0);
-            u_8[1] = vld1q_u8(p_src_1);
-            u_8[2] = vld1q_u8(p_src_2);
-            u_8[3] = vld1q_u8(p_src_3);
-
-            s_16_l[0] = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(u_8[0])));
-            s_16_h[0] = vreinterpretq_s16_u16(vmovl_high_u8(u_8[0]));
-            s_16_l[1] = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(u_8[1])));
-            s_16_h[1] = vreinterpretq_s16_u16(vmovl_high_u8(u_8[1]));
-            s_16_l[2] = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(u_8[2])));
-            s_16_h[2] = vreinterpretq_s16_u16(vmovl_high_u8(u_8[2]));
-            s_16_l[3] = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(u_8[3])));
-            s_16_h[3] = vreinterpretq_s16_u16(vmovl_high_u8(u_8[3]));
-
-            NEON_ADM_INSTANCE_ACCUM_AND_MACC_VEC_4_ELEMS_ARR_BY_4_ELEMENTS_FILTER_S32X4_LH(accum_lo_l, normalize_vec_vp_lo, s_16_l, filter_lo_vec);
-            NEON_ADM_INSTANCE_ACCUM_AND_MACC_VEC_4_ELEMS_ARR_BY_4_ELEMENTS_FILTER_S32X4_LH(accum_lo_h, normalize_vec_vp_lo, s_16_h, filter_lo_vec);
-            NEON_ADM_INSTANCE_ACCUM_AND_MACC_VEC_4_ELEMS_ARR_BY_4_ELEMENTS_FILTER_S32X4_LH(accum_hi_l, normalize_vec_vp_hi, s_16_l, filter_hi_vec);
-            NEON_ADM_INSTANCE_ACCUM_AND_MACC_VEC_4_ELEMS_ARR_BY_4_ELEMENTS_FILTER_S32X4_LH(accum_hi_h, normalize_vec_vp_hi, s_16_h, filter_hi_vec);
-
-            NEON_ADM_STORE_ZIPPED_ACCUM_LO_HI_WITH_RIGHT_SHIFT_S16x8(accum_lo_l, shift_vp_vec, tmplo + j);
-            NEON_ADM_STORE_ZIPPED_ACCUM_LO_HI_WITH_RIGHT_SHIFT_S16x8(accum_lo_h, shift_vp_vec, tmplo + j + 8);
-            NEON_ADM_STORE_ZIPPED_ACCUM_LO_HI_WITH_RIGHT_SHIFT_S16x8(accum_hi_l, shift_vp_vec, tmphi + j);
-            NEON_ADM_STORE_ZIPPED_ACCUM_LO_HI_WITH_RIGHT_SHIFT_S16x8(accum_hi_h, shift_vp_vec, tmphi + j + 8);
+    const int32x4_t normalize_vec_lo =
+        vdupq_n_s32(add_shift_VP - dwt2_db2_coeffs_lo_sum * add_shift_VP);
+    const int32x4_t normalize_vec_hi =
+        vdupq_n_s32(add_shift_VP - dwt2_db2_coeffs_hi_sum * add_shift_VP);
+
+    int j = 0;
+    for (; j + 8 <= w; j += 8) {
+        int32x4_t lo_l = normalize_vec_lo, lo_h = normalize_vec_lo;
+        int32x4_t hi_l = normalize_vec_hi, hi_h = normalize_vec_hi;
+        for (int k = 0; k < 4; k++) {
+            const int16x8_t s =
+                vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p_src[k] + j)));
+            lo_l = vmlal_n_s16(lo_l, vget_low_s16(s), dwt2_db2_coeffs_lo[k]);
+            lo_h = vmlal_high_n_s16(lo_h, s, dwt2_db2_coeffs_lo[k]);
+            hi_l = vmlal_n_s16(hi_l, vget_low_s16(s), dwt2_db2_coeffs_hi[k]);
+            hi_h = vmlal_high_n_s16(hi_h, s, dwt2_db2_coeffs_hi[k]);
+        }
+        vst1q_s16(tmplo + j, vcombine_s16(vmovn_s32(vshrq_n_s32(lo_l, 8)),
+                                          vmovn_s32(vshrq_n_s32(lo_h, 8))));
+        vst1q_s16(tmphi + j, vcombine_s16(vmovn_s32(vshrq_n_s32(hi_l, 8)),
+                                          vmovn_s32(vshrq_n_s32(hi_h, 8))));
+    }
+
+    for (; j < w; ++j)
+        adm_dwt2_8_vert_px(src, ind_y, i, j, src_stride, tmplo, tmphi);
+}
+
+void adm_dwt2_16_vert_neon(const uint16_t *src, int **ind_y, int i, int w,
+                           int src_stride, int inp_size_bits, int16_t *tmplo,
+                           int16_t *tmphi)
+{
+    const uint16_t *p_src[4];
+    for (int k = 0; k < 4; k++)
+        p_src[k] = src + ind_y[k][i] * src_stride;
+
+    const int32_t add_shift_VP = 1 << (inp_size_bits - 1);
+    const int32x4_t normalize_vec_lo =
+        vdupq_n_s32(add_shift_VP - dwt2_db2_coeffs_lo_sum * add_shift_VP);
+    const int32x4_t normalize_vec_hi =
+        vdupq_n_s32(add_shift_VP - dwt2_db2_coeffs_hi_sum * add_shift_VP);
+    const int32x4_t shift_vec = vdupq_n_s32(-inp_size_bits);
+
+    int j = 0;
+    for (; j + 8 <= w; j += 8) {
+        int32x4_t lo_l = normalize_vec_lo, lo_h = normalize_vec_lo;
+        int32x4_t hi_l = normalize_vec_hi, hi_h = normalize_vec_hi;
+        for (int k = 0; k < 4; k++) {
+            // samples of up to 16 bits, multiplied in 32 bits like the
+            // scalar code
+            const uint16x8_t u = vld1q_u16(p_src[k] + j);
+            const int32x4_t s_l = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(u)));
+            const int32x4_t s_h = vreinterpretq_s32_u32(vmovl_high_u16(u));
+            lo_l = vmlaq_n_s32(lo_l, s_l, dwt2_db2_coeffs_lo[k]);
+            lo_h = vmlaq_n_s32(lo_h, s_h, dwt2_db2_coeffs_lo[k]);
+            hi_l = vmlaq_n_s32(hi_l, s_l, dwt2_db2_coeffs_hi[k]);
+            hi_h = vmlaq_n_s32(hi_h, s_h, dwt2_db2_coeffs_hi[k]);
+        }
+        vst1q_s16(tmplo + j, vcombine_s16(vmovn_s32(vshlq_s32(lo_l, shift_vec)),
+                                          vmovn_s32(vshlq_s32(lo_h, shift_vec))));
+        vst1q_s16(tmphi + j, vcombine_s16(vmovn_s32(vshlq_s32(hi_l, shift_vec)),
+                                          vmovn_s32(vshlq_s32(hi_h, shift_vec))));
+    }
+
+    for (; j < w; ++j) {
+        adm_dwt2_16_vert_px(src, ind_y, i, j, src_stride, inp_size_bits,
+                            tmplo, tmphi);
+    }
+}
+
+/*
+ * Outputs j to j + 7 of one horizontal pass, from the taps at 2j - 1 to
+ * 2j + 16 of tmp.
+ */
+static inline void dwt2_16_hori_8(const int16_t *tmp, int j, int16_t *dst_lo,
+                                  int16_t *dst_hi)
+{
+    const int32x4_t add_shift_hp_vec = vdupq_n_s32(32768);
+    // val[0] and val[1] of t01 hold the taps 2j - 1 and 2j of outputs j to
+    // j + 7, the ones of t23 the taps 2j + 1 and 2j + 2
+    const int16x8x2_t t01 = vld2q_s16(tmp + 2 * j - 1);
+    const int16x8x2_t t23 = vld2q_s16(tmp + 2 * j + 1);
+    const int16x8_t taps[4] = { t01.val[0], t01.val[1], t23.val[0],
+                                t23.val[1] };
+
+    int32x4_t lo_l = add_shift_hp_vec, lo_h = add_shift_hp_vec;
+    int32x4_t hi_l = add_shift_hp_vec, hi_h = add_shift_hp_vec;
+    for (int k = 0; k < 4; k++) {
+        lo_l = vmlal_n_s16(lo_l, vget_low_s16(taps[k]), dwt2_db2_coeffs_lo[k]);
+        lo_h = vmlal_high_n_s16(lo_h, taps[k], dwt2_db2_coeffs_lo[k]);
+        hi_l = vmlal_n_s16(hi_l, vget_low_s16(taps[k]), dwt2_db2_coeffs_hi[k]);
+        hi_h = vmlal_high_n_s16(hi_h, taps[k], dwt2_db2_coeffs_hi[k]);
+    }
+    vst1q_s16(dst_lo + j, vcombine_s16(vmovn_s32(vshrq_n_s32(lo_l, 16)),
+                                       vmovn_s32(vshrq_n_s32(lo_h, 16))));
+    vst1q_s16(dst_hi + j, vcombine_s16(vmovn_s32(vshrq_n_s32(hi_l, 16)),
+                                       vmovn_s32(vshrq_n_s32(hi_h, 16))));
+}
+
+void adm_dwt2_16_hori_neon(const int16_t *tmplo, const int16_t *tmphi,
+                           int **ind_x, int w, const adm_dwt_band_t *dst,
+                           size_t offset)
+{
+    // away from the borders, output j reads the taps 2j - 1 to 2j + 2
+    adm_dwt2_16_hori_px(tmplo, tmphi, ind_x, 0, dst, offset);
+    int j = 1;
+    for (; 2 * j + 16 < w; j += 8) {
+        dwt2_16_hori_8(tmplo, j, dst->band_a + offset, dst->band_v + offset);
+        dwt2_16_hori_8(tmphi, j, dst->band_h + offset, dst->band_d + offset);
+    }
+    for (; j < (w + 1) / 2; ++j)
+        adm_dwt2_16_hori_px(tmplo, tmphi, ind_x, j, dst, offset);
+}
+
+/*
+ * ((sum of the four 64-bit filter products of s) + add) >> shift, truncated
+ * to 32 bits.
+ */
+static inline int32x4_t filt4_round_s32(const int32x4_t *s, const int16_t *f,
+                                        int64x2_t add, int64x2_t shift)
+{
+    int64x2_t l = add, h = add;
+    for (int k = 0; k < 4; k++) {
+        l = vmlal_n_s32(l, vget_low_s32(s[k]), f[k]);
+        h = vmlal_high_n_s32(h, s[k], f[k]);
+    }
+    return vcombine_s32(vmovn_s64(vshlq_s64(l, shift)),
+                        vmovn_s64(vshlq_s64(h, shift)));
+}
+
+void adm_dwt2_s123_vert_neon(const int32_t *src, int **ind_y, int i, int w,
+                             int src_stride, int32_t add, int16_t shift,
+                             int32_t *tmplo, int32_t *tmphi)
+{
+    const int32_t *p_src[4];
+    for (int k = 0; k < 4; k++)
+        p_src[k] = src + ind_y[k][i] * src_stride;
+
+    const int64x2_t add_vec = vdupq_n_s64(add);
+    const int64x2_t shift_vec = vdupq_n_s64(-shift);
+
+    int j = 0;
+    for (; j + 4 <= w; j += 4) {
+        int32x4_t s[4];
+        for (int k = 0; k < 4; k++)
+            s[k] = vld1q_s32(p_src[k] + j);
+        vst1q_s32(tmplo + j, filt4_round_s32(s, dwt2_db2_coeffs_lo, add_vec,
+                                             shift_vec));
+        vst1q_s32(tmphi + j, filt4_round_s32(s, dwt2_db2_coeffs_hi, add_vec,
+                                             shift_vec));
+    }
+
+    for (; j < w; ++j) {
+        adm_dwt2_s123_vert_px(src, ind_y, i, j, src_stride, add, shift, tmplo,
+                              tmphi);
+    }
+}
+
+void adm_dwt2_s123_hori_neon(const int32_t *tmplo, const int32_t *tmphi,
+                             int **ind_x, int w, const i4_adm_dwt_band_t *dst,
+                             size_t offset, int32_t add, int16_t shift)
+{
+    const int64x2_t add_vec = vdupq_n_s64(add);
+    const int64x2_t shift_vec = vdupq_n_s64(-shift);
+
+    adm_dwt2_s123_hori_px(tmplo, tmphi, ind_x, 0, dst, offset, add, shift);
+    int j = 1;
+    for (; 2 * j + 8 < w; j += 4) {
+        int32x4x2_t t01 = vld2q_s32(tmplo + 2 * j - 1);
+        int32x4x2_t t23 = vld2q_s32(tmplo + 2 * j + 1);
+        int32x4_t s[4] = { t01.val[0], t01.val[1], t23.val[0], t23.val[1] };
+        vst1q_s32(dst->band_a + offset + j,
+                  filt4_round_s32(s, dwt2_db2_coeffs_lo, add_vec, shift_vec));
+        vst1q_s32(dst->band_v + offset + j,
+                  filt4_round_s32(s, dwt2_db2_coeffs_hi, add_vec, shift_vec));
+
+        t01 = vld2q_s32(tmphi + 2 * j - 1);
+        t23 = vld2q_s32(tmphi + 2 * j + 1);
+        s[0] = t01.val[0];
+        s[1] = t01.val[1];
+        s[2] = t23.val[0];
+        s[3] = t23.val[1];
+        vst1q_s32(dst->band_h + offset + j,
+                  filt4_round_s32(s, dwt2_db2_coeffs_lo, add_vec, shift_vec));
+        vst1q_s32(dst->band_d + offset + j,
+                  filt4_round_s32(s, dwt2_db2_coeffs_hi, add_vec, shift_vec));
+    }
+    for (; j < (w + 1) / 2; ++j)
+        adm_dwt2_s123_hori_px(tmplo, tmphi, ind_x, j, dst, offset, add, shift);
+}
+
+/*
+ * Rounds the 64-bit lanes of x to float like the scalar conversion of an
+ * int64_t does, which takes them to fit 53 bits, then divides by 4096.
+ */
+static inline float64x2_t cvt_scaled_f64(int64x2_t x)
+{
+    return vmulq_n_f64(vcvt_f64_f32(vcvt_f32_f64(vcvtq_f64_s64(x))),
+                       1.0 / 4096.0);
+}
+
+/* adm_decouple_angle_flag() of two pixels. */
+static inline uint32x2_t angle_flag_2(int32x2_t oh, int32x2_t ov, int32x2_t th,
+                                      int32x2_t tv, float64x2_t cos_1deg_sq)
+{
+    const float64x2_t ot_dp =
+        cvt_scaled_f64(vmlal_s32(vmull_s32(oh, th), ov, tv));
+    const float64x2_t o_mag_sq =
+        cvt_scaled_f64(vmlal_s32(vmull_s32(oh, oh), ov, ov));
+    const float64x2_t t_mag_sq =
+        cvt_scaled_f64(vmlal_s32(vmull_s32(th, th), tv, tv));
+
+    const float64x2_t lhs = vmulq_f64(ot_dp, ot_dp);
+    const float64x2_t rhs = vmulq_f64(vmulq_f64(cos_1deg_sq, o_mag_sq),
+                                      t_mag_sq);
+    const uint64x2_t flag = vandq_u64(vcgezq_f64(ot_dp), vcgeq_f64(lhs, rhs));
+    return vmovn_u64(flag);
+}
+
+static inline uint32x4_t angle_flag_4(int32x4_t oh, int32x4_t ov, int32x4_t th,
+                                      int32x4_t tv, float64x2_t cos_1deg_sq)
+{
+    return vcombine_u32(
+        angle_flag_2(vget_low_s32(oh), vget_low_s32(ov), vget_low_s32(th),
+                     vget_low_s32(tv), cos_1deg_sq),
+        angle_flag_2(vget_high_s32(oh), vget_high_s32(ov), vget_high_s32(th),
+                     vget_high_s32(tv), cos_1deg_sq));
+}
+
+/* div_lookup[idx + 32768] of the four lanes of idx. */
+static inline int32x4_t div_lookup_s32(int32x4_t idx)
+{
+    int32_t div[4];
+    div[0] = div_lookup[vgetq_lane_s32(idx, 0) + 32768];
+    div[1] = div_lookup[vgetq_lane_s32(idx, 1) + 32768];
+    div[2] = div_lookup[vgetq_lane_s32(idx, 2) + 32768];
+    div[3] = div_lookup[vgetq_lane_s32(idx, 3) + 32768];
+    return vld1q_s32(div);
+}
+
+/*
+ * Applies the enhancement gain limit to rst where the angle flag is set,
+ * pos and neg select the lanes of positive and negative rst_f.
+ */
+static inline int32x4_t decouple_gain(int32x4_t rst, int32x4_t t,
+                                      uint32x4_t pos, uint32x4_t neg,
+                                      float64x2_t egl)
+{
+    if (!vmaxvq_u32(vorrq_u32(pos, neg))) return rst;
+
+    const float64x2_t r_lo =
+        vmulq_f64(vcvtq_f64_s64(vmovl_s32(vget_low_s32(rst))), egl);
+    const float64x2_t r_hi = vmulq_f64(vcvtq_f64_s64(vmovl_high_s32(rst)), egl);
+    const float64x2_t t_lo = vcvtq_f64_s64(vmovl_s32(vget_low_s32(t)));
+    const float64x2_t t_hi = vcvtq_f64_s64(vmovl_high_s32(t));
+
+    const int32x4_t min =
+        vcombine_s32(vmovn_s64(vcvtq_s64_f64(vminq_f64(r_lo, t_lo))),
+                     vmovn_s64(vcvtq_s64_f64(vminq_f64(r_hi, t_hi))));
+    const int32x4_t max =
+        vcombine_s32(vmovn_s64(vcvtq_s64_f64(vmaxq_f64(r_lo, t_lo))),
+                     vmovn_s64(vcvtq_s64_f64(vmaxq_f64(r_hi, t_hi))));
+    rst = vbslq_s32(pos, min, rst);
+    return vbslq_s32(neg, max, rst);
+}
+
+/* adm_decouple_px() of one band of four pixels. */
+static inline int16x4x2_t decouple_band_4(int16x4_t o16, int16x4_t t16,
+                                          uint32x4_t angle_flag,
+                                          float64x2_t egl)
+{
+    const int32x4_t o = vmovl_s16(o16);
+    const int32x4_t t = vmovl_s16(t16);
+
+    // |div * t| < 2^45, the shifted value fits 32 bits
+    const int32x4_t div = div_lookup_s32(o);
+    const int64x2_t round = vdupq_n_s64(16384);
+    const int64x2_t k_l = vshrq_n_s64(vmlal_s32(round, vget_low_s32(div),
+                                                vget_low_s32(t)), 15);
+    const int64x2_t k_h = vshrq_n_s64(vmlal_high_s32(round, div, t), 15);
+    int32x4_t k = vcombine_s32(vmovn_s64(k_l), vmovn_s64(k_h));
+    k = vminq_s32(vmaxq_s32(k, vdupq_n_s32(0)), vdupq_n_s32(32768));
+    k = vbslq_s32(vceqzq_s32(o), vdupq_n_s32(32768), k);
+
+    // |rst| <= |o|, it fits the int16_t of the scalar code
+    int32x4_t rst = vshrq_n_s32(vmlaq_s32(vdupq_n_s32(16384), k, o), 15);
+
+    const uint32x4_t k_pos = vandq_u32(angle_flag, vcgtzq_s32(k));
+    const uint32x4_t pos = vandq_u32(k_pos, vcgtzq_s32(o));
+    const uint32x4_t neg = vandq_u32(k_pos, vcltzq_s32(o));
+    rst = decouple_gain(rst, t, pos, neg, egl);
+
+    int16x4x2_t ra;
+    ra.val[0] = vmovn_s32(rst);
+    ra.val[1] = vmovn_s32(vsubq_s32(t, rst));
+    return ra;
+}
+
+void adm_decouple_row_neon(const adm_dwt_band_t *ref, const adm_dwt_band_t *dis,
+                           const adm_dwt_band_t *r, const adm_dwt_band_t *a,
+                           size_t offset, int n, float cos_1deg_sq,
+                           double adm_enhn_gain_limit)
+{
+    const float64x2_t cos_sq = vdupq_n_f64(cos_1deg_sq);
+    const float64x2_t egl = vdupq_n_f64(adm_enhn_gain_limit);
+    const int16_t *o_angles[3] = { ref->band_h, ref->band_v, ref->band_d };
+    const int16_t *t_angles[3] = { dis->band_h, dis->band_v, dis->band_d };
+    int16_t *r_angles[3] = { r->band_h, r->band_v, r->band_d };
+    int16_t *a_angles[3] = { a->band_h, a->band_v, a->band_d };
+
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+        const size_t idx = offset + j;
+        const uint32x4_t flag =
+            angle_flag_4(vmovl_s16(vld1_s16(ref->band_h + idx)),
+                         vmovl_s16(vld1_s16(ref->band_v + idx)),
+                         vmovl_s16(vld1_s16(dis->band_h + idx)),
+                         vmovl_s16(vld1_s16(dis->band_v + idx)), cos_sq);
+        for (int theta = 0; theta < 3; theta++) {
+            const int16x4x2_t ra =
+                decouple_band_4(vld1_s16(o_angles[theta] + idx),
+                                vld1_s16(t_angles[theta] + idx), flag, egl);
+            vst1_s16(r_angles[theta] + idx, ra.val[0]);
+            vst1_s16(a_angles[theta] + idx, ra.val[1]);
+        }
+    }
+
+    for (; j < n; ++j) {
+        adm_decouple_pixel(ref, dis, r, a, offset + j, cos_1deg_sq,
+                           adm_enhn_gain_limit);
+    }
+}
+
+/* Clamps the signed 64-bit lanes of x to [0, 32768]. */
+static inline int64x2_t clamp_k_s64(int64x2_t x)
+{
+    const int64x2_t max = vdupq_n_s64(32768);
+    x = vbslq_s64(vcltzq_s64(x), vdupq_n_s64(0), x);
+    return vbslq_s64(vcgtq_s64(x, max), max, x);
+}
+
+/* i4_adm_decouple_px() of one band of four pixels. */
+static inline int32x4x2_t i4_decouple_band_4(int32x4_t o, int32x4_t t,
+                                             uint32x4_t angle_flag,
+                                             float64x2_t egl)
+{
+    // k_shift of get_best15_from32(), zero where abs_o fits the table
+    const uint32x4_t abs_o = vreinterpretq_u32_s32(vabsq_s32(o));
+    const uint32x4_t wide = vcgtq_u32(abs_o, vdupq_n_u32(32767));
+    const int32x4_t sh = vreinterpretq_s32_u32(vandq_u32(wide,
+        vsubq_u32(vdupq_n_u32(17), vclzq_u32(abs_o))));
+    const int32x4_t msb = vreinterpretq_s32_u32(vrshlq_u32(abs_o, vnegq_s32(sh)));
+
+    int32x4_t div = div_lookup_s32(msb);
+    div = vbslq_s32(vcltzq_s32(o), vnegq_s32(div), div);
+
+    const int64x2_t sh_l = vmovl_s32(vget_low_s32(sh));
+    const int64x2_t sh_h = vmovl_high_s32(sh);
+    const int64x2_t round = vdupq_n_s64(1 << 14);
+    const int64x2_t fifteen = vdupq_n_s64(15);
+    int64x2_t k_l = vmlal_s32(vshlq_s64(round, sh_l), vget_low_s32(div),
+                              vget_low_s32(t));
+    int64x2_t k_h = vmlal_high_s32(vshlq_s64(round, sh_h), div, t);
+    k_l = clamp_k_s64(vshlq_s64(k_l, vnegq_s64(vaddq_s64(sh_l, fifteen))));
+    k_h = clamp_k_s64(vshlq_s64(k_h, vnegq_s64(vaddq_s64(sh_h, fifteen))));
+    int32x4_t k = vcombine_s32(vmovn_s64(k_l), vmovn_s64(k_h));
+    k = vbslq_s32(vceqzq_s32(o), vdupq_n_s32(32768), k);
+
+    const int64x2_t round_rst = vdupq_n_s64(16384);
+    const int64x2_t rst_l = vshrq_n_s64(vmlal_s32(round_rst, vget_low_s32(k),
+                                                  vget_low_s32(o)), 15);
+    const int64x2_t rst_h = vshrq_n_s64(vmlal_high_s32(round_rst, k, o), 15);
+    int32x4_t rst = vcombine_s32(vmovn_s64(rst_l), vmovn_s64(rst_h));
+
+    const uint32x4_t k_pos = vandq_u32(angle_flag, vcgtzq_s32(k));
+    const uint32x4_t pos = vandq_u32(k_pos, vcgtzq_s32(o));
+    const uint32x4_t neg = vandq_u32(k_pos, vcltzq_s32(o));
+    rst = decouple_gain(rst, t, pos, neg, egl);
+
+    int32x4x2_t ra;
+    ra.val[0] = rst;
+    ra.val[1] = vsubq_s32(t, rst);
+    return ra;
+}
+
+void i4_adm_decouple_row_neon(const i4_adm_dwt_band_t *ref,
+                              const i4_adm_dwt_band_t *dis,
+                              const i4_adm_dwt_band_t *r,
+                              const i4_adm_dwt_band_t *a, size_t offset,
+                              int n, float cos_1deg_sq,
+                              double adm_enhn_gain_limit)
+{
+    const float64x2_t cos_sq = vdupq_n_f64(cos_1deg_sq);
+    const float64x2_t egl = vdupq_n_f64(adm_enhn_gain_limit);
+    const int32_t *o_angles[3] = { ref->band_h, ref->band_v, ref->band_d };
+    const int32_t *t_angles[3] = { dis->band_h, dis->band_v, dis->band_d };
+    int32_t *r_angles[3] = { r->band_h, r->band_v, r->band_d };
+    int32_t *a_angles[3] = { a->band_h, a->band_v, a->band_d };
+
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+        const size_t idx = offset + j;
+        const int32x4_t oh = vld1q_s32(ref->band_h + idx);
+        const int32x4_t ov = vld1q_s32(ref->band_v + idx);
+        const int32x4_t th = vld1q_s32(dis->band_h + idx);
+        const int32x4_t tv = vld1q_s32(dis->band_v + idx);
+
+        // the dot products only convert to double exactly up to 53 bits
+        const uint32x4_t mag = vorrq_u32(
+            vorrq_u32(vreinterpretq_u32_s32(vabsq_s32(oh)),
+                      vreinterpretq_u32_s32(vabsq_s32(ov))),
+            vorrq_u32(vreinterpretq_u32_s32(vabsq_s32(th)),
+                      vreinterpretq_u32_s32(vabsq_s32(tv))));
+        if (vmaxvq_u32(mag) >> 26) {
+            for (int jj = j; jj < j + 4; ++jj) {
+                i4_adm_decouple_pixel(ref, dis, r, a, offset + jj,
+                                      cos_1deg_sq, adm_enhn_gain_limit);
+            }
+            continue;
+        }
+
+        const uint32x4_t flag = angle_flag_4(oh, ov, th, tv, cos_sq);
+        for (int theta = 0; theta < 3; theta++) {
+            const int32x4x2_t ra =
+                i4_decouple_band_4(vld1q_s32(o_angles[theta] + idx),
+                                   vld1q_s32(t_angles[theta] + idx), flag,
+                                   egl);
+            vst1q_s32(r_angles[theta] + idx, ra.val[0]);
+            vst1q_s32(a_angles[theta] + idx, ra.val[1]);
+        }
+    }
+
+    for (; j < n; ++j) {
+        i4_adm_decouple_pixel(ref, dis, r, a, offset + j, cos_1deg_sq,
+                              adm_enhn_gain_limit);
+    }
+}
+
+void adm_csf_row_neon(const int16_t *src, int16_t *dst, int16_t *flt, int n,
+                      uint16_t i_rfactor, uint8_t i_shift,
+                      uint16_t i_shiftsadd)
+{
+    const int32x4_t add_vec = vdupq_n_s32(i_shiftsadd);
+    const int32x4_t shift_vec = vdupq_n_s32(-i_shift);
+
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        const int16x8_t s = vld1q_s16(src + j);
+        int32x4_t d_l = vmlaq_n_s32(add_vec, vmovl_s16(vget_low_s16(s)),
+                                    i_rfactor);
+        int32x4_t d_h = vmlaq_n_s32(add_vec, vmovl_high_s16(s), i_rfactor);
+        const int16x4_t d16_l = vmovn_s32(vshlq_s32(d_l, shift_vec));
+        const int16x4_t d16_h = vmovn_s32(vshlq_s32(d_h, shift_vec));
+        d_l = vabsq_s32(vmovl_s16(d16_l));
+        d_h = vabsq_s32(vmovl_s16(d16_h));
+        const int32x4_t f_l = vshrq_n_s32(vmlaq_n_s32(vdupq_n_s32(2048), d_l,
+                                                      4369), 12);
+        const int32x4_t f_h = vshrq_n_s32(vmlaq_n_s32(vdupq_n_s32(2048), d_h,
+                                                      4369), 12);
+        vst1q_s16(dst + j, vcombine_s16(d16_l, d16_h));
+        vst1q_s16(flt + j, vcombine_s16(vmovn_s32(f_l), vmovn_s32(f_h)));
+    }
+
+    for (; j < n; ++j)
+        adm_csf_px(src[j], i_rfactor, i_shift, i_shiftsadd, &dst[j], &flt[j]);
+}
+
+/* (int32_t)(((int64_t)a * b + add) >> shift) with b unsigned. */
+static inline int32x4_t mul_round_s32(int32x4_t a, uint32_t b, int64x2_t add,
+                                      int64x2_t shift)
+{
+    int64x2_t l = vmlal_n_s32(add, vget_low_s32(a), (int32_t)b);
+    int64x2_t h = vmlal_high_n_s32(add, a, (int32_t)b);
+    // the multiplication takes b as signed, add back a << 32 where it is not
+    if (b >> 31) {
+        l = vaddq_s64(l, vshll_n_s32(vget_low_s32(a), 32));
+        h = vaddq_s64(h, vshll_high_n_s32(a, 32));
+    }
+    return vcombine_s32(vmovn_s64(vshlq_s64(l, shift)),
+                        vmovn_s64(vshlq_s64(h, shift)));
+}
+
+void i4_adm_csf_row_neon(const int32_t *src, int32_t *dst, int32_t *flt,
+                         int n, uint32_t i_rfactor, int32_t add_bef_shift_dst,
+                         uint32_t shift_dst, int32_t add_bef_shift_flt,
+                         uint32_t shift_flt)
+{
+    const int64x2_t add_dst = vdupq_n_s64(add_bef_shift_dst);
+    const int64x2_t sh_dst = vdupq_n_s64(-(int64_t)shift_dst);
+    const int64x2_t add_flt = vdupq_n_s64(add_bef_shift_flt);
+    const int64x2_t sh_flt = vdupq_n_s64(-(int64_t)shift_flt);
+
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+        const int32x4_t d = mul_round_s32(vld1q_s32(src + j), i_rfactor,
+                                          add_dst, sh_dst);
+        const int32x4_t f = mul_round_s32(vabsq_s32(d), 143165577, add_flt,
+                                          sh_flt);
+        vst1q_s32(dst + j, d);
+        vst1q_s32(flt + j, f);
+    }
+
+    for (; j < n; ++j) {
+        i4_adm_csf_px(src[j], i_rfactor, add_bef_shift_dst, shift_dst,
+                      add_bef_shift_flt, shift_flt, &dst[j], &flt[j]);
+    }
+}
+
+uint64_t adm_csf_den_row_neon(const int16_t *src, int n)
+{
+    uint64x2_t acc = vdupq_n_u64(0);
+
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        const uint16x8_t x = vreinterpretq_u16_s16(vabsq_s16(vld1q_s16(src + j)));
+        const uint32x4_t x_sq_l = vmull_u16(vget_low_u16(x), vget_low_u16(x));
+        const uint32x4_t x_sq_h = vmull_high_u16(x, x);
+        const uint32x4_t x_l = vmovl_u16(vget_low_u16(x));
+        const uint32x4_t x_h = vmovl_high_u16(x);
+        acc = vmlal_u32(acc, vget_low_u32(x_sq_l), vget_low_u32(x_l));
+        acc = vmlal_high_u32(acc, x_sq_l, x_l);
+        acc = vmlal_u32(acc, vget_low_u32(x_sq_h), vget_low_u32(x_h));
+        acc = vmlal_high_u32(acc, x_sq_h, x_h);
+    }
+
+    uint64_t accum = vaddvq_u64(acc);
+    for (; j < n; ++j)
+        accum += adm_csf_den_px(src[j]);
+    return accum;
+}
+
+/* adm_csf_den_s123_px() of two pixels. */
+static inline uint64x2_t csf_den_s123_2(uint32x2_t x, uint64x2_t add_sq,
+                                        int64x2_t sh_sq, uint64x2_t add_cub,
+                                        int64x2_t sh_cub)
+{
+    const uint64x2_t q = vshlq_u64(vmlal_u32(add_sq, x, x), sh_sq);
+    // q may exceed 32 bits, the product wraps like the scalar one
+    uint64x2_t qx = vmull_u32(vmovn_u64(q), x);
+    qx = vaddq_u64(qx, vshlq_n_u64(vmull_u32(vshrn_n_u64(q, 32), x), 32));
+    return vshlq_u64(vaddq_u64(qx, add_cub), sh_cub);
+}
+
+uint64_t adm_csf_den_s123_row_neon(const int32_t *src, int n,
+                                   uint32_t add_shift_sq, uint32_t shift_sq,
+                                   uint32_t add_shift_cub, uint32_t shift_cub)
+{
+    const uint64x2_t add_sq = vdupq_n_u64(add_shift_sq);
+    const int64x2_t sh_sq = vdupq_n_s64(-(int64_t)shift_sq);
+    const uint64x2_t add_cub = vdupq_n_u64(add_shift_cub);
+    const int64x2_t sh_cub = vdupq_n_s64(-(int64_t)shift_cub);
+    uint64x2_t acc = vdupq_n_u64(0);
+
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+        const uint32x4_t x = vreinterpretq_u32_s32(vabsq_s32(vld1q_s32(src + j)));
+        acc = vaddq_u64(acc, csf_den_s123_2(vget_low_u32(x), add_sq, sh_sq,
+                                            add_cub, sh_cub));
+        acc = vaddq_u64(acc, csf_den_s123_2(vget_high_u32(x), add_sq, sh_sq,
+                                            add_cub, sh_cub));
+    }
+
+    uint64_t accum = vaddvq_u64(acc);
+    for (; j < n; ++j) {
+        accum += adm_csf_den_s123_px(src[j], add_shift_sq, shift_sq,
+                                     add_shift_cub, shift_cub);
+    }
+    return accum;
+}
+
+/*
+ * Adds ((x_sq * x) + add_cub) >> shift_cub of two pixels to acc, where
+ * x_sq = ((x * x) + add_sq) >> shift_sq truncated to 32 bits.
+ */
+static inline int64x2_t cm_accum_2(int64x2_t acc, int32x2_t x, int64x2_t add_sq,
+                                   int64x2_t shift_sq, int64x2_t add_cub,
+                                   int64x2_t shift_cub)
+{
+    const int32x2_t x_sq = vmovn_s64(vshlq_s64(vmlal_s32(add_sq, x, x),
+                                               shift_sq));
+    return vaddq_s64(acc, vshlq_s64(vmlal_s32(add_cub, x_sq, x), shift_cub));
+}
+
+void adm_cm_row_neon(const adm_dwt_band_t *src, const adm_dwt_band_t *csf_a,
+                     const adm_dwt_band_t *csf_f, int src_stride,
+                     int csf_a_stride, int i, int j_begin, int j_end,
+                     const uint16_t *i_rfactor, const uint32_t *add_shift_cub,
+                     const uint32_t *shift_cub, int64_t *accum)
+{
+    const int16_t *src_angles[3] = { src->band_h, src->band_v, src->band_d };
+    const int16_t *angles[3] = { csf_a->band_h, csf_a->band_v, csf_a->band_d };
+    const int16_t *flt_angles[3] =
+        { csf_f->band_h, csf_f->band_v, csf_f->band_d };
+    const int shift_xsq[3] = { 29, 29, 30 };
+    const int shift_xsub[3] = { 10, 10, 12 };
+
+    int64x2_t add_xsq[3], sh_xsq[3], add_xcub[3], sh_xcub[3];
+    int32x4_t sh_xsub[3];
+    for (int theta = 0; theta < 3; ++theta) {
+        add_xsq[theta] = vdupq_n_s64(1 << (shift_xsq[theta] - 1));
+        sh_xsq[theta] = vdupq_n_s64(-shift_xsq[theta]);
+        add_xcub[theta] = vdupq_n_s64(add_shift_cub[theta]);
+        sh_xcub[theta] = vdupq_n_s64(-(int64_t)shift_cub[theta]);
+        sh_xsub[theta] = vdupq_n_s32(shift_xsub[theta]);
+    }
+    int64x2_t acc[3] = { vdupq_n_s64(0), vdupq_n_s64(0), vdupq_n_s64(0) };
+
+    int j = j_begin;
+    for (; j + 4 <= j_end; j += 4) {
+        const int idx = i * csf_a_stride + j;
+        int32x4_t thr = vdupq_n_s32(0);
+        for (int theta = 0; theta < 3; ++theta) {
+            const int16_t *flt = flt_angles[theta] + idx;
+            const int16_t *above = flt - csf_a_stride;
+            const int16_t *below = flt + csf_a_stride;
+            const int32x4_t a = vabsq_s32(vmovl_s16(vld1_s16(angles[theta] + idx)));
+            const int32x4_t c = vshrq_n_s32(vmlaq_n_s32(vdupq_n_s32(2048), a,
+                                                        ONE_BY_15), 12);
+            thr = vaddq_s32(thr, vmovl_s16(vmovn_s32(c)));
+            thr = vaddw_s16(thr, vld1_s16(above - 1));
+            thr = vaddw_s16(thr, vld1_s16(above));
+            thr = vaddw_s16(thr, vld1_s16(above + 1));
+            thr = vaddw_s16(thr, vld1_s16(flt - 1));
+            thr = vaddw_s16(thr, vld1_s16(flt + 1));
+            thr = vaddw_s16(thr, vld1_s16(below - 1));
+            thr = vaddw_s16(thr, vld1_s16(below));
+            thr = vaddw_s16(thr, vld1_s16(below + 1));
         }
 
-        /* Horizontal pass (lo and hi). */
-        // j = 0 is a special case (entry src_ind_x[0][0] is mirrored 101 instead of -1).
-        // Note that j = ((w + 1) / 2) has same mirroring yet that value is ignored/overriden so no need to implement it seperatly.
-        /* from: dwt2_src_indices_filt()
-            src_ind_x[0][0] = 1;
-            src_ind_x[1][0] = 0;
-            src_ind_x[2][0] = 1;
-            src_ind_x[3][0] = 2;
-        */
-        int32_t accum_a = add_shift_HP;
-        int32_t accum_v = add_shift_HP;
-        int32_t accum_h = add_shift_HP;
-        int32_t accum_d = add_shift_HP;
-
-        for (int idx = 0; idx < 3; idx++)
-        {
-            int j_idx = ind_x[idx][0];
-            int16_t s_lo = tmplo[j_idx];
-            int16_t s_hi = tmphi[j_idx];
-            accum_a += (int32_t)dwt2_db2_coeffs_lo[idx] * s_lo;
-            accum_v += (int32_t)dwt2_db2_coeffs_hi[idx] * s_lo;
-            accum_h += (int32_t)dwt2_db2_coeffs_lo[idx] * s_hi;
-            accum_d += (int32_t)dwt2_db2_coeffs_hi[idx] * s_hi;
+        for (int theta = 0; theta < 3; ++theta) {
+            int32x4_t x = vmulq_n_s32(vmovl_s16(vld1_s16(
+                src_angles[theta] + i * src_stride + j)), i_rfactor[theta]);
+            x = vsubq_s32(vabsq_s32(x), vshlq_s32(thr, sh_xsub[theta]));
+            x = vmaxq_s32(x, vdupq_n_s32(0));
+            acc[theta] = cm_accum_2(acc[theta], vget_low_s32(x),
+                                    add_xsq[theta], sh_xsq[theta],
+                                    add_xcub[theta], sh_xcub[theta]);
+            acc[theta] = cm_accum_2(acc[theta], vget_high_s32(x),
+                                    add_xsq[theta], sh_xsq[theta],
+                                    add_xcub[theta], sh_xcub[theta]);
         }
+    }
+
+    for (int theta = 0; theta < 3; ++theta)
+        accum[theta] += vaddvq_s64(acc[theta]);
+    adm_cm_row(src, csf_a, csf_f, src_stride, csf_a_stride, i, j, j_end,
+               i_rfactor, add_shift_cub, shift_cub, accum);
+}
+
+void i4_adm_cm_row_neon(const i4_adm_dwt_band_t *src,
+                        const i4_adm_dwt_band_t *csf_a,
+                        const i4_adm_dwt_band_t *csf_f, int src_stride,
+                        int csf_a_stride, int i, int j_begin, int j_end,
+                        const uint32_t *rfactor, int32_t add_bef_shift_dst,
+                        uint32_t shift_dst, int32_t add_bef_shift_flt,
+                        uint32_t shift_flt, uint32_t add_shift_cub,
+                        uint32_t shift_cub, int64_t *accum)
+{
+    const int32_t *src_angles[3] = { src->band_h, src->band_v, src->band_d };
+    const int32_t *angles[3] = { csf_a->band_h, csf_a->band_v, csf_a->band_d };
+    const int32_t *flt_angles[3] =
+        { csf_f->band_h, csf_f->band_v, csf_f->band_d };
 
-        dst->band_a[i * dst_stride] = accum_a >> shift_HP;
-        dst->band_v[i * dst_stride] = accum_v >> shift_HP;
-        dst->band_h[i * dst_stride] = accum_h >> shift_HP;
-        dst->band_d[i * dst_stride] = accum_d >> shift_HP;
-
-        /* Vectorize code assumes w is even (assumption is valid as we call the whole function only in case !(w%8) )
-            As so the whole ind_x can be ignored as:
-                ind1 = 2 * j;
-                ind0 = ind1 - 1;
-                ind2 = ind1 + 1;
-                ind3 = ind1 + 2;
-                src_ind_x[0][j] = ind0; \\ 2*j-1
-                src_ind_x[1][j] = ind1; \\ 2*j
-                src_ind_x[2][j] = ind2; \\ 2*j+1
-                src_ind_x[3][j] = ind3; \\ 2*j+2
-         */
-
-        int16_t *p_low = tmplo + 2;  // 2*j (j=1) - 1 --> 2 -1 = 1
-        int16_t *p_high = tmphi + 2; // 2*j (j=1) - 1 --> 2 -1 = 1
-        int stride_h = i * dst_stride + 1;
-        for (int j = 1; j < ((w + 1) / 2); j += 8, p_low += 16, p_high += 16, stride_h += 8)
-        {
-            int16x8x2_t low_s0s1_vec_s16, low_s2s3_vec_s16;
-            int16x8x2_t high_s0s1_vec_s16, high_s2s3_vec_s16;
-
-            low_s0s1_vec_s16 = vld2q_s16(p_low - 1);
-            low_s2s3_vec_s16 = vld2q_s16(p_low + 1);
-            high_s0s1_vec_s16 = vld2q_s16(p_high - 1);
-            high_s2s3_vec_s16 = vld2q_s16(p_high + 1);
-
-            NEON_ADM_INSTANCE_ACCUM_AND_MACC_PAIR_VEC_BY_4_ELEMENTS_FILTER_S32X4_LH(low_accum_vec_lo, low_s0s1_vec_s16, low_s2s3_vec_s16, add_shift_hp_vec, filter_lo_vec);
-            NEON_ADM_INSTANCE_ACCUM_AND_MACC_PAIR_VEC_BY_4_ELEMENTS_FILTER_S32X4_LH(low_accum_vec_hi, low_s0s1_vec_s16, low_s2s3_vec_s16, add_shift_hp_vec, filter_hi_vec);
-            NEON_ADM_INSTANCE_ACCUM_AND_MACC_PAIR_VEC_BY_4_ELEMENTS_FILTER_S32X4_LH(high_accum_vec_lo, high_s0s1_vec_s16, high_s2s3_vec_s16, add_shift_hp_vec, filter_lo_vec);
-            NEON_ADM_INSTANCE_ACCUM_AND_MACC_PAIR_VEC_BY_4_ELEMENTS_FILTER_S32X4_LH(high_accum_vec_hi, high_s0s1_vec_s16, high_s2s3_vec_s16, add_shift_hp_vec, filter_hi_vec);
-
-            NEON_ADM_STORE_ZIPPED_ACCUM_LO_HI_WITH_RIGHT_SHIFT_S16x8(low_accum_vec_lo, shift_hp_vec, (dst->band_a + stride_h));
-            NEON_ADM_STORE_ZIPPED_ACCUM_LO_HI_WITH_RIGHT_SHIFT_S16x8(low_accum_vec_hi, shift_hp_vec, (dst->band_v + stride_h));
-            NEON_ADM_STORE_ZIPPED_ACCUM_LO_HI_WITH_RIGHT_SHIFT_S16x8(high_accum_vec_lo, shift_hp_vec, (dst->band_h + stride_h));
-            NEON_ADM_STORE_ZIPPED_ACCUM_LO_HI_WITH_RIGHT_SHIFT_S16x8(high_accum_vec_hi, shift_hp_vec, (dst->band_d + stride_h));
+    const int64x2_t add_dst = vdupq_n_s64(add_bef_shift_dst);
+    const int64x2_t sh_dst = vdupq_n_s64(-(int64_t)shift_dst);
+    const int64x2_t add_flt = vdupq_n_s64(add_bef_shift_flt);
+    const int64x2_t sh_flt = vdupq_n_s64(-(int64_t)shift_flt);
+    const int64x2_t add_sq = vdupq_n_s64(1 << 29);
+    const int64x2_t sh_sq = vdupq_n_s64(-30);
+    const int64x2_t add_cub = vdupq_n_s64(add_shift_cub);
+    const int64x2_t sh_cub = vdupq_n_s64(-(int64_t)shift_cub);
+    int64x2_t acc[3] = { vdupq_n_s64(0), vdupq_n_s64(0), vdupq_n_s64(0) };
+
+    int j = j_begin;
+    for (; j + 4 <= j_end; j += 4) {
+        const int idx = i * csf_a_stride + j;
+        int32x4_t thr = vdupq_n_s32(0);
+        for (int theta = 0; theta < 3; ++theta) {
+            const int32_t *flt = flt_angles[theta] + idx;
+            const int32_t *above = flt - csf_a_stride;
+            const int32_t *below = flt + csf_a_stride;
+            const int32x4_t a = vabsq_s32(vld1q_s32(angles[theta] + idx));
+            thr = vaddq_s32(thr, mul_round_s32(a, I4_ONE_BY_15, add_flt,
+                                               sh_flt));
+            thr = vaddq_s32(thr, vld1q_s32(above - 1));
+            thr = vaddq_s32(thr, vld1q_s32(above));
+            thr = vaddq_s32(thr, vld1q_s32(above + 1));
+            thr = vaddq_s32(thr, vld1q_s32(flt - 1));
+            thr = vaddq_s32(thr, vld1q_s32(flt + 1));
+            thr = vaddq_s32(thr, vld1q_s32(below - 1));
+            thr = vaddq_s32(thr, vld1q_s32(below));
+            thr = vaddq_s32(thr, vld1q_s32(below + 1));
+        }
+
+        for (int theta = 0; theta < 3; ++theta) {
+            int32x4_t x = mul_round_s32(
+                vld1q_s32(src_angles[theta] + i * src_stride + j),
+                rfactor[theta], add_dst, sh_dst);
+            x = vmaxq_s32(vsubq_s32(vabsq_s32(x), thr), vdupq_n_s32(0));
+            acc[theta] = cm_accum_2(acc[theta], vget_low_s32(x), add_sq,
+                                    sh_sq, add_cub, sh_cub);
+            acc[theta] = cm_accum_2(acc[theta], vget_high_s32(x), add_sq,
+                                    sh_sq, add_cub, sh_cub);
         }
     }
+
+    for (int theta = 0; theta < 3; ++theta)
+        accum[theta] += vaddvq_s64(acc[theta]);
+    i4_adm_cm_row(src, csf_a, csf_f, src_stride, csf_a_stride, i, j, j_end,
+                  rfactor, add_bef_shift_dst, shift_dst, add_bef_shift_flt,
+                  shift_flt, add_shift_cub, shift_cub, accum);
 }
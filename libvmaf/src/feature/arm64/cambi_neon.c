@@ -0,0 +1,184 @@
+#include <arm_neon.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cambi_neon.h"
+
+void cambi_increment_range_neon(uint16_t *arr, int left, int right) {
+    const uint16x8_t one = vdupq_n_u16(1);
+    int col = left;
+    for (; col + 7 < right; col += 8) {
+        vst1q_u16(&arr[col], vaddq_u16(vld1q_u16(&arr[col]), one));
+    }
+    for (; col < right; col++) {
+        arr[col]++;
+    }
+}
+
+void cambi_decrement_range_neon(uint16_t *arr, int left, int right) {
+    const uint16x8_t one = vdupq_n_u16(1);
+    int col = left;
+    for (; col + 7 < right; col += 8) {
+        vst1q_u16(&arr[col], vsubq_u16(vld1q_u16(&arr[col]), one));
+    }
+    for (; col < right; col++) {
+        arr[col]--;
+    }
+}
+
+static inline uint16_t mode3(uint16_t a, uint16_t b, uint16_t c) {
+    if (a == b || a == c) return a;
+    if (b == c) return b;
+    if (a <= b && a <= c) return a;
+    if (b <= c) return b;
+    return c;
+}
+
+/* There are no gathers, so the bins are looked up one lane at a time and
+ * only the arithmetic, with its division, is vectorized. */
+void cambi_c_values_row_neon(float *c_values, const uint16_t *histograms,
+                             const uint16_t *image, const uint16_t *mask,
+                             int width, uint16_t num_diffs,
+                             const uint16_t *tvi_for_diff,
+                             const int *diff_weights, const int *all_diffs) {
+    int col = 0;
+    for (; col + 3 < width; col += 4) {
+        uint32x4_t m = vmovl_u16(vld1_u16(&mask[col]));
+        if (!vmaxvq_u32(m)) continue;
+
+        uint32_t bin[4], p_0[4], p_1[4], p_2[4];
+        for (int k = 0; k < 4; k++) {
+            bin[k] = (image[col + k] + num_diffs) * width + col + k;
+            p_0[k] = histograms[bin[k]];
+        }
+        uint32x4_t value = vaddq_u32(vmovl_u16(vld1_u16(&image[col])), vdupq_n_u32(num_diffs));
+        uint32x4_t vp_0 = vld1q_u32(p_0);
+
+        float32x4_t c_value = vdupq_n_f32(0.0f);
+        for (uint16_t d = 0; d < num_diffs; d++) {
+            uint32x4_t in_tvi = vcleq_u32(value, vdupq_n_u32(tvi_for_diff[d]));
+            if (!vmaxvq_u32(vandq_u32(in_tvi, m))) continue;
+
+            const int off_1 = all_diffs[num_diffs + d + 1] * width;
+            const int off_2 = all_diffs[num_diffs - d - 1] * width;
+            for (int k = 0; k < 4; k++) {
+                p_1[k] = histograms[bin[k] + off_1];
+                p_2[k] = histograms[bin[k] + off_2];
+            }
+            uint32x4_t p = vmaxq_u32(vld1q_u32(p_1), vld1q_u32(p_2));
+
+            uint32x4_t num = vmulq_u32(vmulq_n_u32(vp_0, diff_weights[d]), p);
+            float32x4_t val = vdivq_f32(vcvtq_f32_s32(vreinterpretq_s32_u32(num)),
+                                        vcvtq_f32_u32(vaddq_u32(p, vp_0)));
+            uint32x4_t update = vandq_u32(in_tvi, vcgtq_f32(val, c_value));
+            c_value = vbslq_f32(update, val, c_value);
+        }
+
+        float32x4_t c = vld1q_f32(&c_values[col]);
+        vst1q_f32(&c_values[col], vbslq_f32(vtstq_u32(m, m), c_value, c));
+    }
+
+    for (; col < width; col++) {
+        if (!mask[col]) continue;
+        uint16_t value = image[col] + num_diffs;
+        uint16_t p_0 = histograms[value * width + col];
+        float val, c_value = 0.0;
+        for (uint16_t d = 0; d < num_diffs; d++) {
+            if (value <= tvi_for_diff[d]) {
+                uint16_t p_1 = histograms[(value + all_diffs[num_diffs + d + 1]) * width + col];
+                uint16_t p_2 = histograms[(value + all_diffs[num_diffs - d - 1]) * width + col];
+                uint16_t p = p_1 > p_2 ? p_1 : p_2;
+                val = (float)(diff_weights[d] * p_0 * p) / (p + p_0);
+                if (val > c_value) c_value = val;
+            }
+        }
+        c_values[col] = c_value;
+    }
+}
+
+void cambi_mode3_row_neon(uint16_t *dst, const uint16_t *a, const uint16_t *b,
+                          const uint16_t *c, int width) {
+    int col = 0;
+    for (; col + 7 < width; col += 8) {
+        uint16x8_t va = vld1q_u16(&a[col]);
+        uint16x8_t vb = vld1q_u16(&b[col]);
+        uint16x8_t vc = vld1q_u16(&c[col]);
+        uint16x8_t mode = vminq_u16(vminq_u16(va, vb), vc);
+        mode = vbslq_u16(vceqq_u16(vb, vc), vb, mode);
+        uint16x8_t a_eq = vorrq_u16(vceqq_u16(va, vb), vceqq_u16(va, vc));
+        mode = vbslq_u16(a_eq, va, mode);
+        vst1q_u16(&dst[col], mode);
+    }
+    for (; col < width; col++) {
+        dst[col] = mode3(a[col], b[col], c[col]);
+    }
+}
+
+/* dst may be src: the loads of each step are ahead of its stores. */
+void cambi_decimate_row_neon(uint16_t *dst, const uint16_t *src, int width) {
+    int col = 0;
+    for (; col + 8 < width; col += 8) {
+        vst1q_u16(&dst[col], vld2q_u16(&src[2 * col]).val[0]);
+    }
+    for (; col < width; col++) {
+        dst[col] = src[col << 1];
+    }
+}
+
+uint32_t cambi_mask_dp_row_neon(uint32_t *dp, const uint32_t *dp_prev,
+                                const uint16_t *image,
+                                const uint16_t *image_below, int width) {
+    const uint32x4_t zero = vdupq_n_u32(0);
+    const uint32x4_t one = vdupq_n_u32(1);
+    uint32x4_t sum = zero;
+
+    int col = 0;
+    for (; col + 4 < width; col += 4) {
+        uint32x4_t center = vmovl_u16(vld1_u16(&image[col]));
+        uint32x4_t zero_derivative = vceqq_u32(center, vmovl_u16(vld1_u16(&image[col + 1])));
+        if (image_below) {
+            uint32x4_t below = vmovl_u16(vld1_u16(&image_below[col]));
+            zero_derivative = vandq_u32(zero_derivative, vceqq_u32(center, below));
+        }
+        // inclusive prefix sum of the 4 lanes
+        uint32x4_t x = vandq_u32(zero_derivative, one);
+        x = vaddq_u32(x, vextq_u32(zero, x, 3));
+        x = vaddq_u32(x, vextq_u32(zero, x, 2));
+        sum = vaddq_u32(sum, x);
+        vst1q_u32(&dp[col], vaddq_u32(vld1q_u32(&dp_prev[col]), sum));
+        sum = vdupq_laneq_u32(sum, 3);
+    }
+
+    uint32_t s = vgetq_lane_u32(sum, 0);
+    for (; col < width; col++) {
+        s += (!image_below || image[col] == image_below[col]) &&
+             (col == width - 1 || image[col] == image[col + 1]);
+        dp[col] = dp_prev[col] + s;
+    }
+    return s;
+}
+
+void cambi_mask_row_neon(uint16_t *mask, const uint32_t *dp_bottom,
+                         const uint32_t *dp_top, int filter_size,
+                         uint16_t mask_index, int width) {
+    const int32x4_t index = vdupq_n_s32(mask_index);
+    const uint16x8_t one = vdupq_n_u16(1);
+
+    int col = 0;
+    for (; col + 7 < width; col += 8) {
+        uint16x4_t result[2];
+        for (int k = 0; k < 2; k++) {
+            const int j = col + 4 * k;
+            uint32x4_t sum = vsubq_u32(vld1q_u32(&dp_bottom[j + filter_size]), vld1q_u32(&dp_bottom[j]));
+            sum = vsubq_u32(sum, vld1q_u32(&dp_top[j + filter_size]));
+            sum = vaddq_u32(sum, vld1q_u32(&dp_top[j]));
+            result[k] = vmovn_u32(vcgtq_s32(vreinterpretq_s32_u32(sum), index));
+        }
+        vst1q_u16(&mask[col], vandq_u16(vcombine_u16(result[0], result[1]), one));
+    }
+    for (; col < width; col++) {
+        int result = dp_bottom[col + filter_size] - dp_bottom[col]
+                     - dp_top[col + filter_size] + dp_top[col];
+        mask[col] = (result > mask_index);
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef ARM64_CAMBI_H_
+#define ARM64_CAMBI_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+void cambi_increment_range_neon(uint16_t *arr, int left, int right);
+
+void cambi_decrement_range_neon(uint16_t *arr, int left, int right);
+
+void cambi_c_values_row_neon(float *c_values, const uint16_t *histograms,
+                             const uint16_t *image, const uint16_t *mask,
+                             int width, uint16_t num_diffs,
+                             const uint16_t *tvi_for_diff,
+                             const int *diff_weights, const int *all_diffs);
+
+void cambi_mode3_row_neon(uint16_t *dst, const uint16_t *a, const uint16_t *b,
+                          const uint16_t *c, int width);
+
+void cambi_decimate_row_neon(uint16_t *dst, const uint16_t *src, int width);
+
+uint32_t cambi_mask_dp_row_neon(uint32_t *dp, const uint32_t *dp_prev,
+                                const uint16_t *image,
+                                const uint16_t *image_below, int width);
+
+void cambi_mask_row_neon(uint16_t *mask, const uint32_t *dp_bottom,
+                         const uint32_t *dp_top, int filter_size,
+                         uint16_t mask_index, int width);
+
+#endif /* ARM64_CAMBI_H_ */
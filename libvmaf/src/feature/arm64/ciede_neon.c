@@ -0,0 +1,343 @@
+#include <arm_neon.h>
+#include <math.h>
+
+#include "ciede_neon.h"
+
+/*
+ * Single precision versions of the libm functions used by the scalar
+ * ciede2000(), following the cephes polynomials. See x86/ciede_avx2.c.
+ */
+
+static inline float32x4_t and_f32(uint32x4_t m, float32x4_t x)
+{
+    return vreinterpretq_f32_u32(vandq_u32(m, vreinterpretq_u32_f32(x)));
+}
+
+static inline float32x4_t poly_f32(float32x4_t y, float32x4_t x, float c)
+{
+    return vaddq_f32(vmulq_f32(y, x), vdupq_n_f32(c));
+}
+
+static inline float32x4_t log_f32(float32x4_t x)
+{
+    const float32x4_t one = vdupq_n_f32(1.f);
+    const uint32x4_t i = vreinterpretq_u32_f32(x);
+    float32x4_t e = vcvtq_f32_s32(vsubq_s32(
+        vreinterpretq_s32_u32(vshrq_n_u32(i, 23)), vdupq_n_s32(126)));
+    float32x4_t m = vreinterpretq_f32_u32(
+        vorrq_u32(vandq_u32(i, vdupq_n_u32(0x007fffff)),
+                  vdupq_n_u32(0x3f000000)));
+
+    // m in [sqrt(0.5), sqrt(2)), minus one
+    const uint32x4_t lt = vcltq_f32(m, vdupq_n_f32(0.707106781186547524f));
+    e = vsubq_f32(e, and_f32(lt, one));
+    m = vaddq_f32(vsubq_f32(m, one), and_f32(lt, m));
+
+    const float32x4_t z = vmulq_f32(m, m);
+    float32x4_t y = vdupq_n_f32(7.0376836292e-2f);
+    y = poly_f32(y, m, -1.1514610310e-1f);
+    y = poly_f32(y, m, 1.1676998740e-1f);
+    y = poly_f32(y, m, -1.2420140846e-1f);
+    y = poly_f32(y, m, 1.4249322787e-1f);
+    y = poly_f32(y, m, -1.6668057665e-1f);
+    y = poly_f32(y, m, 2.0000714765e-1f);
+    y = poly_f32(y, m, -2.4999993993e-1f);
+    y = poly_f32(y, m, 3.3333331174e-1f);
+    y = vmulq_f32(vmulq_f32(y, m), z);
+
+    y = vaddq_f32(y, vmulq_f32(e, vdupq_n_f32(-2.12194440e-4f)));
+    y = vsubq_f32(y, vmulq_f32(z, vdupq_n_f32(0.5f)));
+    return vaddq_f32(vaddq_f32(m, y), vmulq_f32(e, vdupq_n_f32(0.693359375f)));
+}
+
+static inline float32x4_t exp_f32(float32x4_t x)
+{
+    x = vminq_f32(x, vdupq_n_f32(88.3762626647949f));
+    x = vmaxq_f32(x, vdupq_n_f32(-87.3365447504f));
+
+    const float32x4_t n =
+        vrndnq_f32(vmulq_f32(x, vdupq_n_f32(1.44269504088896341f)));
+    x = vsubq_f32(x, vmulq_f32(n, vdupq_n_f32(0.693359375f)));
+    x = vsubq_f32(x, vmulq_f32(n, vdupq_n_f32(-2.12194440e-4f)));
+
+    const float32x4_t z = vmulq_f32(x, x);
+    float32x4_t y = vdupq_n_f32(1.9875691500e-4f);
+    y = poly_f32(y, x, 1.3981999507e-3f);
+    y = poly_f32(y, x, 8.3334519073e-3f);
+    y = poly_f32(y, x, 4.1665795894e-2f);
+    y = poly_f32(y, x, 1.6666665459e-1f);
+    y = poly_f32(y, x, 5.0000001201e-1f);
+    y = vaddq_f32(vmulq_f32(y, z), x);
+    y = vaddq_f32(y, vdupq_n_f32(1.f));
+
+    const int32x4_t e =
+        vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(n), vdupq_n_s32(127)), 23);
+    return vmulq_f32(y, vreinterpretq_f32_s32(e));
+}
+
+// sine and cosine of x >= 0
+static inline void sincos_f32(float32x4_t x, float32x4_t *s, float32x4_t *c)
+{
+    int32x4_t j = vcvtq_s32_f32(vmulq_f32(x, vdupq_n_f32(1.27323954473516f)));
+    j = vandq_s32(vaddq_s32(j, vdupq_n_s32(1)), vdupq_n_s32(~1));
+    const float32x4_t y = vcvtq_f32_s32(j);
+    x = vsubq_f32(x, vmulq_f32(y, vdupq_n_f32(0.78515625f)));
+    x = vsubq_f32(x, vmulq_f32(y, vdupq_n_f32(2.4187564849853515625e-4f)));
+    x = vsubq_f32(x, vmulq_f32(y, vdupq_n_f32(3.77489497744594108e-8f)));
+
+    const float32x4_t z = vmulq_f32(x, x);
+    float32x4_t ps = vdupq_n_f32(-1.9515295891e-4f);
+    ps = poly_f32(ps, z, 8.3321608736e-3f);
+    ps = poly_f32(ps, z, -1.6666654611e-1f);
+    ps = vaddq_f32(vmulq_f32(vmulq_f32(ps, z), x), x);
+    float32x4_t pc = vdupq_n_f32(2.443315711809948e-5f);
+    pc = poly_f32(pc, z, -1.388731625493765e-3f);
+    pc = poly_f32(pc, z, 4.166664568298827e-2f);
+    pc = vmulq_f32(vmulq_f32(pc, z), z);
+    pc = vsubq_f32(pc, vmulq_f32(z, vdupq_n_f32(0.5f)));
+    pc = vaddq_f32(pc, vdupq_n_f32(1.f));
+
+    // octant j in { 0, 2, 4, 6 } picks the polynomial and the signs
+    const uint32x4_t swap = vtstq_s32(j, vdupq_n_s32(2));
+    const uint32x4_t sign_s = vreinterpretq_u32_s32(
+        vshlq_n_s32(vandq_s32(j, vdupq_n_s32(4)), 29));
+    const uint32x4_t sign_c = vreinterpretq_u32_s32(vshlq_n_s32(
+        vandq_s32(vaddq_s32(j, vdupq_n_s32(2)), vdupq_n_s32(4)), 29));
+    *s = vreinterpretq_f32_u32(veorq_u32(
+        vreinterpretq_u32_f32(vbslq_f32(swap, pc, ps)), sign_s));
+    *c = vreinterpretq_f32_u32(veorq_u32(
+        vreinterpretq_u32_f32(vbslq_f32(swap, ps, pc)), sign_c));
+}
+
+// get_h_prime(): atan2(x, y) mapped to [0, 2 pi)
+static inline float32x4_t h_prime_f32(float32x4_t x, float32x4_t y)
+{
+    const float32x4_t zero = vdupq_n_f32(0.f);
+    const float32x4_t ax = vabsq_f32(x);
+    const float32x4_t ay = vabsq_f32(y);
+    const float32x4_t mx = vmaxq_f32(ax, ay);
+    float32x4_t t = vdivq_f32(vminq_f32(ax, ay), mx);
+
+    // atan(t) for t in [0, 1]
+    const uint32x4_t big = vcgtq_f32(t, vdupq_n_f32(0.4142135623730950f));
+    t = vbslq_f32(big, vdivq_f32(vsubq_f32(t, vdupq_n_f32(1.f)),
+                                 vaddq_f32(t, vdupq_n_f32(1.f))), t);
+    const float32x4_t z = vmulq_f32(t, t);
+    float32x4_t r = vdupq_n_f32(8.05374449538e-2f);
+    r = poly_f32(r, z, -1.38776856032e-1f);
+    r = poly_f32(r, z, 1.99777106478e-1f);
+    r = poly_f32(r, z, -3.33329491539e-1f);
+    r = vaddq_f32(vmulq_f32(vmulq_f32(r, z), t), t);
+    r = vaddq_f32(r, and_f32(big, vdupq_n_f32(M_PI / 4)));
+
+    r = vbslq_f32(vcgtq_f32(ax, ay), vsubq_f32(vdupq_n_f32(M_PI / 2), r), r);
+    r = vbslq_f32(vcltq_f32(y, zero), vsubq_f32(vdupq_n_f32(M_PI), r), r);
+    r = vbslq_f32(vcltq_f32(x, zero), vsubq_f32(vdupq_n_f32(2 * M_PI), r), r);
+    return vbslq_f32(vceqq_f32(mx, zero), zero, r);
+}
+
+// sqrt(c^7 / (c^7 + 25^7))
+static inline float32x4_t c7_f32(float32x4_t c)
+{
+    const float32x4_t c2 = vmulq_f32(c, c);
+    const float32x4_t c7 = vmulq_f32(vmulq_f32(c2, c2), vmulq_f32(c2, c));
+    return vsqrtq_f32(vdivq_f32(c7,
+                      vaddq_f32(c7, vdupq_n_f32(6103515625.f))));
+}
+
+// rgb_to_xyz_map()
+static inline float32x4_t linearize_f32(float32x4_t c)
+{
+    const float32x4_t p = exp_f32(vmulq_f32(vdupq_n_f32(2.4f), log_f32(
+        vmulq_f32(vaddq_f32(c, vdupq_n_f32(0.055f)),
+                  vdupq_n_f32(1. / 1.055)))));
+    return vbslq_f32(vcgtq_f32(c, vdupq_n_f32(10. / 255.)), p,
+                     vmulq_f32(c, vdupq_n_f32(1. / 12.92)));
+}
+
+// xyz_to_lab_map()
+static inline float32x4_t lab_map_f32(float32x4_t c)
+{
+    const float32x4_t p = exp_f32(vmulq_f32(log_f32(c), vdupq_n_f32(1. / 3.)));
+    const float32x4_t l = vmulq_f32(
+        vaddq_f32(vmulq_f32(c, vdupq_n_f32(24389. / 27.)), vdupq_n_f32(16.f)),
+        vdupq_n_f32(1. / 116.));
+    return vbslq_f32(vcgtq_f32(c, vdupq_n_f32(216. / 24389.)), p, l);
+}
+
+// get_lab_color(), on normalized components
+static inline void lab_f32(float32x4_t y, float32x4_t u, float32x4_t v,
+                           float32x4_t *l, float32x4_t *a, float32x4_t *b)
+{
+    const float32x4_t r = linearize_f32(
+        vaddq_f32(y, vmulq_f32(v, vdupq_n_f32(1.28033f))));
+    const float32x4_t g = linearize_f32(vsubq_f32(vsubq_f32(y,
+        vmulq_f32(u, vdupq_n_f32(0.21482f))),
+        vmulq_f32(v, vdupq_n_f32(0.38059f))));
+    const float32x4_t bl = linearize_f32(
+        vaddq_f32(y, vmulq_f32(u, vdupq_n_f32(2.12798f))));
+
+#define DOT(r0, r1, r2) \
+    vaddq_f32(vaddq_f32(vmulq_f32(r, vdupq_n_f32(r0)), \
+                        vmulq_f32(g, vdupq_n_f32(r1))), \
+              vmulq_f32(bl, vdupq_n_f32(r2)))
+    const float32x4_t fx = lab_map_f32(DOT(0.4124564390896921 / 0.95047,
+                                           0.357576077643909 / 0.95047,
+                                           0.18043748326639894 / 0.95047));
+    const float32x4_t fy = lab_map_f32(DOT(0.21267285140562248,
+                                           0.715152155287818,
+                                           0.07217499330655958));
+    const float32x4_t fz = lab_map_f32(DOT(0.019333895582329317 / 1.08883,
+                                           0.119192025881303 / 1.08883,
+                                           0.9503040785363677 / 1.08883));
+#undef DOT
+
+    *l = vsubq_f32(vmulq_f32(fy, vdupq_n_f32(116.f)), vdupq_n_f32(16.f));
+    *a = vmulq_f32(vsubq_f32(fx, fy), vdupq_n_f32(500.f));
+    *b = vmulq_f32(vsubq_f32(fy, fz), vdupq_n_f32(200.f));
+}
+
+// ciede2000() with the default ksub of the extractor
+static inline float32x4_t de00_f32(float32x4_t l1, float32x4_t a1,
+                                   float32x4_t b1, float32x4_t l2,
+                                   float32x4_t a2, float32x4_t b2)
+{
+    const float32x4_t zero = vdupq_n_f32(0.f);
+    const float32x4_t one = vdupq_n_f32(1.f);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    const float32x4_t pi = vdupq_n_f32(M_PI);
+    const float32x4_t two_pi = vdupq_n_f32(2 * M_PI);
+
+    const float32x4_t c1 = vsqrtq_f32(vaddq_f32(vmulq_f32(a1, a1),
+                                                vmulq_f32(b1, b1)));
+    const float32x4_t c2 = vsqrtq_f32(vaddq_f32(vmulq_f32(a2, a2),
+                                                vmulq_f32(b2, b2)));
+    const float32x4_t g = vmulq_f32(vsubq_f32(one,
+        c7_f32(vmulq_f32(vaddq_f32(c1, c2), half))), half);
+    const float32x4_t ap1 = vaddq_f32(a1, vmulq_f32(a1, g));
+    const float32x4_t ap2 = vaddq_f32(a2, vmulq_f32(a2, g));
+    const float32x4_t cp1 = vsqrtq_f32(vaddq_f32(vmulq_f32(ap1, ap1),
+                                                 vmulq_f32(b1, b1)));
+    const float32x4_t cp2 = vsqrtq_f32(vaddq_f32(vmulq_f32(ap2, ap2),
+                                                 vmulq_f32(b2, b2)));
+    const float32x4_t c_bar_p = vmulq_f32(vaddq_f32(cp1, cp2), half);
+
+    const float32x4_t dl = vsubq_f32(l2, l1);
+    const float32x4_t l_bar = vsubq_f32(vmulq_f32(vaddq_f32(l1, l2), half),
+                                        vdupq_n_f32(50.f));
+    const float32x4_t l_bar2 = vmulq_f32(l_bar, l_bar);
+    const float32x4_t s_l = vaddq_f32(one, vdivq_f32(
+        vmulq_f32(l_bar2, vdupq_n_f32(0.015f)),
+        vsqrtq_f32(vaddq_f32(l_bar2, vdupq_n_f32(20.f)))));
+    const float32x4_t s_c = vaddq_f32(one,
+        vmulq_f32(c_bar_p, vdupq_n_f32(0.045f)));
+
+    const float32x4_t h1 = h_prime_f32(b1, ap1);
+    const float32x4_t h2 = h_prime_f32(b2, ap2);
+    const uint32x4_t wrap = vcgtq_f32(vabsq_f32(vsubq_f32(h1, h2)), pi);
+
+    // get_delta_h_prime()
+    float32x4_t dh = vsubq_f32(h2, h1);
+    dh = vbslq_f32(wrap, vbslq_f32(vcleq_f32(h2, h1), vaddq_f32(dh, two_pi),
+                                   vsubq_f32(dh, two_pi)), dh);
+    dh = vbslq_f32(vorrq_u32(vceqq_f32(c1, zero), vceqq_f32(c2, zero)),
+                   zero, dh);
+    dh = vmulq_f32(dh, half);
+    float32x4_t sin_dh, cos_dh;
+    sincos_f32(vabsq_f32(dh), &sin_dh, &cos_dh);
+    sin_dh = vbslq_f32(vcltq_f32(dh, zero), vnegq_f32(sin_dh), sin_dh);
+    const float32x4_t dh_up = vmulq_f32(vmulq_f32(vdupq_n_f32(2.f),
+        vsqrtq_f32(vmulq_f32(cp1, cp2))), sin_dh);
+
+    // get_upcase_h_bar_prime() and get_upcase_t(), by multiple angles
+    const float32x4_t h_bar = vmulq_f32(vaddq_f32(vaddq_f32(h1, h2),
+                                        and_f32(wrap, two_pi)), half);
+    float32x4_t s1, k1;
+    sincos_f32(h_bar, &s1, &k1);
+    const float32x4_t k2 = vsubq_f32(vmulq_f32(vaddq_f32(k1, k1), k1), one);
+    const float32x4_t s2 = vmulq_f32(vaddq_f32(s1, s1), k1);
+    const float32x4_t k3 = vsubq_f32(vmulq_f32(vaddq_f32(k2, k2), k1), k1);
+    const float32x4_t s3 = vsubq_f32(vmulq_f32(vaddq_f32(k1, k1), s2), s1);
+    const float32x4_t k4 = vsubq_f32(vmulq_f32(vaddq_f32(k2, k2), k2), one);
+    const float32x4_t s4 = vmulq_f32(vaddq_f32(s2, s2), k2);
+
+#define COS_SUM(k, s, phi) \
+    vsubq_f32(vmulq_f32(k, vdupq_n_f32(cos(phi))), \
+              vmulq_f32(s, vdupq_n_f32(sin(phi))))
+    float32x4_t t = vsubq_f32(one, vmulq_f32(vdupq_n_f32(0.17f),
+                                             COS_SUM(k1, s1, -M_PI / 6.0)));
+    t = vaddq_f32(t, vmulq_f32(vdupq_n_f32(0.24f), k2));
+    t = vaddq_f32(t, vmulq_f32(vdupq_n_f32(0.32f),
+                               COS_SUM(k3, s3, M_PI / 30.0)));
+    t = vsubq_f32(t, vmulq_f32(vdupq_n_f32(0.20f),
+                               COS_SUM(k4, s4, -7.0 * M_PI / 20.0)));
+#undef COS_SUM
+    const float32x4_t s_h = vaddq_f32(one,
+        vmulq_f32(vmulq_f32(c_bar_p, vdupq_n_f32(0.015f)), t));
+
+    // get_r_sub_t()
+    const float32x4_t d = vmulq_f32(vsubq_f32(
+        vmulq_f32(h_bar, vdupq_n_f32(180.0 / M_PI)), vdupq_n_f32(275.f)),
+        vdupq_n_f32(1.0 / 25.0));
+    const float32x4_t angle = vmulq_f32(exp_f32(vnegq_f32(vmulq_f32(d, d))),
+                                        vdupq_n_f32(60.0 * M_PI / 180.0));
+    float32x4_t sin_angle, cos_angle;
+    sincos_f32(angle, &sin_angle, &cos_angle);
+    const float32x4_t r_t = vmulq_f32(vmulq_f32(vdupq_n_f32(-2.f),
+                                                c7_f32(c_bar_p)), sin_angle);
+
+    const float32x4_t lightness =
+        vdivq_f32(dl, vmulq_f32(s_l, vdupq_n_f32(0.65f)));
+    const float32x4_t chroma = vdivq_f32(vsubq_f32(cp2, cp1), s_c);
+    const float32x4_t hue =
+        vdivq_f32(dh_up, vmulq_f32(s_h, vdupq_n_f32(4.f)));
+
+    float32x4_t de = vaddq_f32(vmulq_f32(lightness, lightness),
+                               vmulq_f32(chroma, chroma));
+    de = vaddq_f32(de, vmulq_f32(hue, hue));
+    de = vaddq_f32(de, vmulq_f32(vmulq_f32(r_t, chroma), hue));
+    return vsqrtq_f32(vmaxq_f32(de, zero));
+}
+
+static inline float32x4_t de00_pixels(const float *ry, const float *ru,
+                                      const float *rv, const float *dy,
+                                      const float *du, const float *dv)
+{
+    float32x4_t l1, a1, b1, l2, a2, b2;
+    lab_f32(vld1q_f32(ry), vld1q_f32(ru), vld1q_f32(rv), &l1, &a1, &b1);
+    lab_f32(vld1q_f32(dy), vld1q_f32(du), vld1q_f32(dv), &l2, &a2, &b2);
+    return de00_f32(l1, a1, b1, l2, a2, b2);
+}
+
+void ciede_de00_row_neon(const float *const ref[3], const float *const dist[3],
+                         unsigned w, unsigned bpc, double *de00_sum)
+{
+    (void) bpc;
+
+    float64x2_t sum_lo = vdupq_n_f64(0.0), sum_hi = vdupq_n_f64(0.0);
+    unsigned j = 0;
+    for (; j + 4 <= w; j += 4) {
+        const float32x4_t de = de00_pixels(ref[0] + j, ref[1] + j, ref[2] + j,
+                                           dist[0] + j, dist[1] + j,
+                                           dist[2] + j);
+        sum_lo = vaddq_f64(sum_lo, vcvt_f64_f32(vget_low_f32(de)));
+        sum_hi = vaddq_f64(sum_hi, vcvt_high_f64_f32(de));
+    }
+
+    if (j < w) {
+        float tail[6][4] = { { 0 } };
+        for (unsigned k = 0; k < w - j; k++) {
+            for (unsigned p = 0; p < 3; p++) {
+                tail[p][k] = ref[p][j + k];
+                tail[p + 3][k] = dist[p][j + k];
+            }
+        }
+        // zero padding in both pictures yields a zero difference
+        const float32x4_t de = de00_pixels(tail[0], tail[1], tail[2],
+                                           tail[3], tail[4], tail[5]);
+        sum_lo = vaddq_f64(sum_lo, vcvt_f64_f32(vget_low_f32(de)));
+        sum_hi = vaddq_f64(sum_hi, vcvt_high_f64_f32(de));
+    }
+
+    *de00_sum += vaddvq_f64(sum_lo) + vaddvq_f64(sum_hi);
+}
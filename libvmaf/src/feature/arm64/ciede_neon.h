@@ -0,0 +1,7 @@
+#ifndef ARM64_CIEDE_H_
+#define ARM64_CIEDE_H_
+
+void ciede_de00_row_neon(const float *const ref[3], const float *const dist[3],
+                         unsigned w, unsigned bpc, double *de00_sum);
+
+#endif /* ARM64_CIEDE_H_ */
@@ -0,0 +1,167 @@
+#include <arm_neon.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "feature/integer_motion.h"
+#include "motion_neon.h"
+
+void x_convolution_16_neon(const uint16_t *src, uint16_t *dst, unsigned width,
+                           unsigned height, ptrdiff_t src_stride,
+                           ptrdiff_t dst_stride)
+{
+    const unsigned radius = filter_width / 2;
+    const unsigned left_edge = radius;
+    const unsigned right_edge = width - (filter_width - radius);
+    const unsigned shift_add_round = 32768;
+
+    for (unsigned i = 0; i < height; ++i) {
+        const uint16_t *src_p = src + i * src_stride;
+        uint16_t *dst_p = dst + i * dst_stride;
+
+        for (unsigned j = 0; j < left_edge; j++) {
+            dst_p[j] = (edge_16(true, src, width, height, src_stride, i, j) +
+                        shift_add_round) >> 16;
+        }
+
+        unsigned j = left_edge;
+        for (; j + 8 <= right_edge; j += 8) {
+            uint32x4_t accum_lo = vdupq_n_u32(0);
+            uint32x4_t accum_hi = vdupq_n_u32(0);
+            for (unsigned k = 0; k < filter_width; ++k) {
+                const uint16x8_t s = vld1q_u16(src_p + j - radius + k);
+                accum_lo = vmlal_n_u16(accum_lo, vget_low_u16(s), filter[k]);
+                accum_hi = vmlal_high_n_u16(accum_hi, s, filter[k]);
+            }
+            vst1q_u16(dst_p + j, vrshrn_high_n_u32(vrshrn_n_u32(accum_lo, 16),
+                                                   accum_hi, 16));
+        }
+
+        for (; j < right_edge; j++) {
+            uint32_t accum = 0;
+            for (unsigned k = 0; k < filter_width; ++k)
+                accum += filter[k] * src_p[j - radius + k];
+            dst_p[j] = (accum + shift_add_round) >> 16;
+        }
+
+        for (j = right_edge; j < width; j++) {
+            dst_p[j] = (edge_16(true, src, width, height, src_stride, i, j) +
+                        shift_add_round) >> 16;
+        }
+    }
+}
+
+// the 5 taps of 8 pixels, widened to 32 bits, rounded and shifted back
+static inline uint16x8_t y_convolution_px8(const uint16x8_t *src,
+                                           uint32x4_t add, int32x4_t shift)
+{
+    uint32x4_t accum_lo = add;
+    uint32x4_t accum_hi = add;
+
+    for (unsigned k = 0; k < filter_width; ++k) {
+        accum_lo = vmlal_n_u16(accum_lo, vget_low_u16(src[k]), filter[k]);
+        accum_hi = vmlal_high_n_u16(accum_hi, src[k], filter[k]);
+    }
+
+    return vmovn_high_u32(vmovn_u32(vshlq_u32(accum_lo, shift)),
+                          vshlq_u32(accum_hi, shift));
+}
+
+void y_convolution_8_neon(void *src, uint16_t *dst, unsigned width,
+                          unsigned height, ptrdiff_t src_stride,
+                          ptrdiff_t dst_stride, unsigned inp_size_bits,
+                          unsigned row_begin, unsigned row_end)
+{
+    (void) inp_size_bits;
+    const unsigned shift_var = 8;
+    const unsigned add_before_shift = 1u << (shift_var - 1);
+    const uint32x4_t add = vdupq_n_u32(add_before_shift);
+    const int32x4_t shift = vdupq_n_s32(-(int) shift_var);
+
+    for (unsigned i = row_begin; i < row_end; i++) {
+        int rows[5];
+        y_tap_rows(i, height, rows);
+        const uint8_t *src_p[5];
+        for (unsigned k = 0; k < filter_width; ++k)
+            src_p[k] = (const uint8_t *) src + rows[k] * src_stride;
+        uint16_t *dst_p = dst + (i - row_begin) * dst_stride;
+
+        unsigned j = 0;
+        for (; j + 8 <= width; j += 8) {
+            uint16x8_t s[5];
+            for (unsigned k = 0; k < filter_width; ++k)
+                s[k] = vmovl_u8(vld1_u8(src_p[k] + j));
+            vst1q_u16(dst_p + j, y_convolution_px8(s, add, shift));
+        }
+
+        for (; j < width; j++) {
+            uint32_t accum = 0;
+            for (unsigned k = 0; k < filter_width; ++k)
+                accum += filter[k] * src_p[k][j];
+            dst_p[j] = (accum + add_before_shift) >> shift_var;
+        }
+    }
+}
+
+void y_convolution_16_neon(void *src, uint16_t *dst, unsigned width,
+                           unsigned height, ptrdiff_t src_stride,
+                           ptrdiff_t dst_stride, unsigned inp_size_bits,
+                           unsigned row_begin, unsigned row_end)
+{
+    const unsigned shift_var = inp_size_bits;
+    const unsigned add_before_shift = 1u << (shift_var - 1);
+    const uint32x4_t add = vdupq_n_u32(add_before_shift);
+    const int32x4_t shift = vdupq_n_s32(-(int) shift_var);
+
+    for (unsigned i = row_begin; i < row_end; i++) {
+        int rows[5];
+        y_tap_rows(i, height, rows);
+        const uint16_t *src_p[5];
+        for (unsigned k = 0; k < filter_width; ++k)
+            src_p[k] = (const uint16_t *) src + rows[k] * src_stride;
+        uint16_t *dst_p = dst + (i - row_begin) * dst_stride;
+
+        unsigned j = 0;
+        for (; j + 8 <= width; j += 8) {
+            uint16x8_t s[5];
+            for (unsigned k = 0; k < filter_width; ++k)
+                s[k] = vld1q_u16(src_p[k] + j);
+            vst1q_u16(dst_p + j, y_convolution_px8(s, add, shift));
+        }
+
+        for (; j < width; j++) {
+            uint32_t accum = 0;
+            for (unsigned k = 0; k < filter_width; ++k)
+                accum += filter[k] * src_p[k][j];
+            dst_p[j] = (accum + add_before_shift) >> shift_var;
+        }
+    }
+}
+
+uint64_t sad_neon(const uint16_t *a, ptrdiff_t a_stride,
+                  const uint16_t *b, ptrdiff_t b_stride,
+                  unsigned w, unsigned h)
+{
+    uint64_t sad = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        // the row sums wrap around like the uint32_t ones of sad_c()
+        uint32x4_t row_sad = vdupq_n_u32(0);
+        unsigned j = 0;
+        for (; j + 8 <= w; j += 8) {
+            const uint16x8_t d = vabdq_u16(vld1q_u16(a + j), vld1q_u16(b + j));
+            row_sad = vpadalq_u16(row_sad, d);
+        }
+        uint32_t inner_sad = vaddvq_u32(row_sad);
+
+        for (; j < w; j++)
+            inner_sad += abs(a[j] - b[j]);
+
+        sad += inner_sad;
+        a += a_stride;
+        b += b_stride;
+    }
+
+    return sad;
+}
@@ -0,0 +1,25 @@
+#ifndef ARM64_MOTION_H_
+#define ARM64_MOTION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+void x_convolution_16_neon(const uint16_t *src, uint16_t *dst, unsigned width,
+                           unsigned height, ptrdiff_t src_stride,
+                           ptrdiff_t dst_stride);
+
+void y_convolution_8_neon(void *src, uint16_t *dst, unsigned width,
+                          unsigned height, ptrdiff_t src_stride,
+                          ptrdiff_t dst_stride, unsigned inp_size_bits,
+                          unsigned row_begin, unsigned row_end);
+
+void y_convolution_16_neon(void *src, uint16_t *dst, unsigned width,
+                           unsigned height, ptrdiff_t src_stride,
+                           ptrdiff_t dst_stride, unsigned inp_size_bits,
+                           unsigned row_begin, unsigned row_end);
+
+uint64_t sad_neon(const uint16_t *a, ptrdiff_t a_stride,
+                  const uint16_t *b, ptrdiff_t b_stride,
+                  unsigned w, unsigned h);
+
+#endif /* ARM64_MOTION_H_ */
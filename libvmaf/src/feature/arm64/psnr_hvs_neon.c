@@ -0,0 +1,206 @@
+#include <arm_neon.h>
+#include <stdint.h>
+
+#include "psnr_hvs_neon.h"
+
+/*
+ * Lane k of every vector below belongs to the 8x8 block k * step pixels to
+ * the right of src/dst. Each step repeats the scalar calc_block() per lane,
+ * with the same operations in the same order, so the results are bit-exact.
+ */
+
+#define OD_DCT_RSHIFT(a, b) \
+    vshrq_n_s32(vaddq_s32(vreinterpretq_s32_u32(vshrq_n_u32( \
+                vreinterpretq_u32_s32(a), 32 - (b))), a), b)
+
+#define OD_DCT_MUL(a, m, r, s) \
+    vshrq_n_s32(vaddq_s32(vmulq_s32(a, vdupq_n_s32(m)), vdupq_n_s32(r)), s)
+
+static inline void od_bin_fdct8(int32x4_t y[8], const int32x4_t *x,
+                                int xstride)
+{
+    int32x4_t t0 = x[0 * xstride];
+    int32x4_t t4 = x[1 * xstride];
+    int32x4_t t2 = x[2 * xstride];
+    int32x4_t t6 = x[3 * xstride];
+    int32x4_t t7 = x[4 * xstride];
+    int32x4_t t3 = x[5 * xstride];
+    int32x4_t t5 = x[6 * xstride];
+    int32x4_t t1 = x[7 * xstride];
+    int32x4_t t1h, t4h, t6h;
+
+    t1 = vsubq_s32(t0, t1);
+    t1h = OD_DCT_RSHIFT(t1, 1);
+    t0 = vsubq_s32(t0, t1h);
+    t4 = vaddq_s32(t4, t5);
+    t4h = OD_DCT_RSHIFT(t4, 1);
+    t5 = vsubq_s32(t5, t4h);
+    t3 = vsubq_s32(t2, t3);
+    t2 = vsubq_s32(t2, OD_DCT_RSHIFT(t3, 1));
+    t6 = vaddq_s32(t6, t7);
+    t6h = OD_DCT_RSHIFT(t6, 1);
+    t7 = vsubq_s32(t6h, t7);
+    t0 = vaddq_s32(t0, t6h);
+    t6 = vsubq_s32(t0, t6);
+    t2 = vsubq_s32(t4h, t2);
+    t4 = vsubq_s32(t2, t4);
+    t0 = vsubq_s32(t0, OD_DCT_MUL(t4, 13573, 16384, 15));
+    t4 = vaddq_s32(t4, OD_DCT_MUL(t0, 11585, 8192, 14));
+    t0 = vsubq_s32(t0, OD_DCT_MUL(t4, 13573, 16384, 15));
+    t6 = vsubq_s32(t6, OD_DCT_MUL(t2, 21895, 16384, 15));
+    t2 = vaddq_s32(t2, OD_DCT_MUL(t6, 15137, 8192, 14));
+    t6 = vsubq_s32(t6, OD_DCT_MUL(t2, 21895, 16384, 15));
+    t3 = vaddq_s32(t3, OD_DCT_MUL(t5, 19195, 16384, 15));
+    t5 = vaddq_s32(t5, OD_DCT_MUL(t3, 11585, 8192, 14));
+    t3 = vsubq_s32(t3, OD_DCT_MUL(t5, 7489, 4096, 13));
+    t7 = vsubq_s32(OD_DCT_RSHIFT(t5, 1), t7);
+    t5 = vsubq_s32(t5, t7);
+    t3 = vsubq_s32(t1h, t3);
+    t1 = vsubq_s32(t1, t3);
+    t7 = vaddq_s32(t7, OD_DCT_MUL(t1, 3227, 16384, 15));
+    t1 = vsubq_s32(t1, OD_DCT_MUL(t7, 6393, 16384, 15));
+    t7 = vaddq_s32(t7, OD_DCT_MUL(t1, 3227, 16384, 15));
+    t5 = vaddq_s32(t5, OD_DCT_MUL(t3, 2485, 4096, 13));
+    t3 = vsubq_s32(t3, OD_DCT_MUL(t5, 18205, 16384, 15));
+    t5 = vaddq_s32(t5, OD_DCT_MUL(t3, 2485, 4096, 13));
+    y[0] = t0;
+    y[1] = t1;
+    y[2] = t2;
+    y[3] = t3;
+    y[4] = t4;
+    y[5] = t5;
+    y[6] = t6;
+    y[7] = t7;
+}
+
+static inline void od_bin_fdct8x8(int32x4_t x[64])
+{
+    int32x4_t z[64];
+    for (int i = 0; i < 8; i++)
+        od_bin_fdct8(z + 8 * i, x + i, 8);
+    for (int i = 0; i < 8; i++)
+        od_bin_fdct8(x + 8 * i, z + i, 8);
+}
+
+static inline void load_blocks(int32x4_t x[64], const unsigned char *p,
+                               int stride, int depth, int step)
+{
+    const int lane_stride = depth > 8 ? 2 * step : step;
+    for (int i = 0; i < 8; i++) {
+        uint16x8_t r[4];
+        uint32x4_t a[4], b[4];
+        for (int k = 0; k < 4; k++) {
+            const unsigned char *q = p + i * stride + k * lane_stride;
+            r[k] = depth > 8 ? vld1q_u16((const uint16_t *)q) :
+                   vmovl_u8(vld1_u8(q));
+        }
+        a[0] = vreinterpretq_u32_u16(vzip1q_u16(r[0], r[1]));
+        a[1] = vreinterpretq_u32_u16(vzip2q_u16(r[0], r[1]));
+        a[2] = vreinterpretq_u32_u16(vzip1q_u16(r[2], r[3]));
+        a[3] = vreinterpretq_u32_u16(vzip2q_u16(r[2], r[3]));
+        b[0] = vzip1q_u32(a[0], a[2]);
+        b[1] = vzip2q_u32(a[0], a[2]);
+        b[2] = vzip1q_u32(a[1], a[3]);
+        b[3] = vzip2q_u32(a[1], a[3]);
+        for (int j = 0; j < 4; j++) {
+            const uint16x8_t c = vreinterpretq_u16_u32(b[j]);
+            x[i * 8 + 2 * j] =
+                vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(c)));
+            x[i * 8 + 2 * j + 1] =
+                vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(c)));
+        }
+    }
+}
+
+/*
+ * Transforms x in place and returns the contrast masking threshold,
+ * sqrt(sum(x^2 * mask) * var(x) / sum(var(quadrants))) / 32, of each lane.
+ */
+static inline float32x4_t block_mask(int32x4_t x[64], float mask[8][8])
+{
+    int32x4_t gsum = vdupq_n_s32(0);
+    int32x4_t sum[4];
+    float32x4_t gmean, means[4];
+    float32x4_t gvar = vdupq_n_f32(0.f);
+    float32x4_t vars[4];
+    float32x4_t m = vdupq_n_f32(0.f);
+
+    for (int n = 0; n < 4; n++) {
+        sum[n] = vdupq_n_s32(0);
+        vars[n] = vdupq_n_f32(0.f);
+    }
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 8; j++) {
+            const int sub = ((i & 12) >> 2) + ((j & 12) >> 1);
+            gsum = vaddq_s32(gsum, x[i * 8 + j]);
+            sum[sub] = vaddq_s32(sum[sub], x[i * 8 + j]);
+        }
+    }
+    // the sums are exact in float, as are the scalar running sums
+    gmean = vdivq_f32(vcvtq_f32_s32(gsum), vdupq_n_f32(64.f));
+    for (int n = 0; n < 4; n++)
+        means[n] = vdivq_f32(vcvtq_f32_s32(sum[n]), vdupq_n_f32(16.f));
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 8; j++) {
+            const int sub = ((i & 12) >> 2) + ((j & 12) >> 1);
+            const float32x4_t v = vcvtq_f32_s32(x[i * 8 + j]);
+            const float32x4_t dg = vsubq_f32(v, gmean);
+            const float32x4_t ds = vsubq_f32(v, means[sub]);
+            gvar = vaddq_f32(gvar, vmulq_f32(dg, dg));
+            vars[sub] = vaddq_f32(vars[sub], vmulq_f32(ds, ds));
+        }
+    }
+    gvar = vmulq_f32(gvar, vdupq_n_f32(1 / 63.f * 64));
+    for (int n = 0; n < 4; n++)
+        vars[n] = vmulq_f32(vars[n], vdupq_n_f32(1 / 15.f * 16));
+    const float32x4_t vsum =
+        vaddq_f32(vaddq_f32(vaddq_f32(vars[0], vars[1]), vars[2]), vars[3]);
+    gvar = vbslq_f32(vcgtq_f32(gvar, vdupq_n_f32(0.f)),
+                     vdivq_f32(vsum, gvar), gvar);
+
+    od_bin_fdct8x8(x);
+    for (int i = 0; i < 8; i++) {
+        for (int j = (i == 0); j < 8; j++) {
+            const float32x4_t sq =
+                vcvtq_f32_s32(vmulq_s32(x[i * 8 + j], x[i * 8 + j]));
+            m = vaddq_f32(m, vmulq_f32(sq, vdupq_n_f32(mask[i][j])));
+        }
+    }
+    // a double sqrt rounded to float equals sqrtf, and / 32 is exact
+    return vmulq_f32(vsqrtq_f32(vmulq_f32(m, gvar)), vdupq_n_f32(1 / 32.f));
+}
+
+void psnr_hvs_calc_blocks_neon(const unsigned char *src, int src_stride,
+                               const unsigned char *dst, int dst_stride,
+                               int depth, int step, float mask[8][8],
+                               float csf[8][8], float *ret)
+{
+    int32x4_t s[64], d[64];
+    float terms[64][4];
+
+    load_blocks(s, src, src_stride, depth, step);
+    load_blocks(d, dst, dst_stride, depth, step);
+    const float32x4_t s_mask = block_mask(s, mask);
+    const float32x4_t d_mask = block_mask(d, mask);
+    const float32x4_t m = vmaxq_f32(d_mask, s_mask);
+
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 8; j++) {
+            float32x4_t err = vcvtq_f32_u32(vreinterpretq_u32_s32(
+                vabdq_s32(s[i * 8 + j], d[i * 8 + j])));
+            if (i != 0 || j != 0) {
+                const float32x4_t t = vdivq_f32(m, vdupq_n_f32(mask[i][j]));
+                err = vbslq_f32(vcltq_f32(err, t), vdupq_n_f32(0.f),
+                                vsubq_f32(err, t));
+            }
+            err = vmulq_f32(err, vdupq_n_f32(csf[i][j]));
+            vst1q_f32(terms[i * 8 + j], vmulq_f32(err, err));
+        }
+    }
+
+    float r = *ret;
+    for (int k = 0; k < 4; k++)
+        for (int n = 0; n < 64; n++)
+            r += terms[n][k];
+    *ret = r;
+}
@@ -0,0 +1,9 @@
+#ifndef ARM64_PSNR_HVS_H_
+#define ARM64_PSNR_HVS_H_
+
+void psnr_hvs_calc_blocks_neon(const unsigned char *src, int src_stride,
+                               const unsigned char *dst, int dst_stride,
+                               int depth, int step, float mask[8][8],
+                               float csf[8][8], float *ret);
+
+#endif /* ARM64_PSNR_HVS_H_ */
@@ -0,0 +1,72 @@
+#include <arm_neon.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "psnr_neon.h"
+
+uint64_t psnr_sse_8_neon(const uint8_t *ref, ptrdiff_t ref_stride,
+                         const uint8_t *dis, ptrdiff_t dis_stride,
+                         unsigned w, unsigned h)
+{
+    uint64x2_t sse = vdupq_n_u64(0);
+    uint64_t sse_tail = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        // a 32 bit lane gains at most 4 * 255^2 per 16 pixels,
+        // so it holds rows of up to 250k pixels
+        uint32x4_t sse_row = vdupq_n_u32(0);
+        unsigned j = 0;
+        for (; j + 16 <= w; j += 16) {
+            const uint8x16_t e = vabdq_u8(vld1q_u8(ref + j), vld1q_u8(dis + j));
+            const uint16x8_t e_lo = vmull_u8(vget_low_u8(e), vget_low_u8(e));
+            const uint16x8_t e_hi = vmull_u8(vget_high_u8(e), vget_high_u8(e));
+            sse_row = vpadalq_u16(sse_row, e_lo);
+            sse_row = vpadalq_u16(sse_row, e_hi);
+        }
+        sse = vpadalq_u32(sse, sse_row);
+
+        uint32_t sse_inner = 0;
+        for (; j < w; j++) {
+            const int16_t e = ref[j] - dis[j];
+            sse_inner += e * e;
+        }
+        sse_tail += sse_inner;
+
+        ref += ref_stride;
+        dis += dis_stride;
+    }
+
+    return vaddvq_u64(sse) + sse_tail;
+}
+
+uint64_t psnr_sse_16_neon(const uint16_t *ref, ptrdiff_t ref_stride,
+                          const uint16_t *dis, ptrdiff_t dis_stride,
+                          unsigned w, unsigned h, unsigned bpc)
+{
+    (void) bpc;
+
+    uint64x2_t sse = vdupq_n_u64(0);
+    uint64_t sse_tail = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        unsigned j = 0;
+        // squares of up to 16 bit differences are exact in 32 bits
+        for (; j + 8 <= w; j += 8) {
+            const uint16x8_t e = vabdq_u16(vld1q_u16(ref + j), vld1q_u16(dis + j));
+            const uint32x4_t e_lo = vmull_u16(vget_low_u16(e), vget_low_u16(e));
+            const uint32x4_t e_hi = vmull_u16(vget_high_u16(e), vget_high_u16(e));
+            sse = vpadalq_u32(sse, e_lo);
+            sse = vpadalq_u32(sse, e_hi);
+        }
+
+        for (; j < w; j++) {
+            const uint32_t e = ref[j] > dis[j] ? ref[j] - dis[j] : dis[j] - ref[j];
+            sse_tail += e * e;
+        }
+
+        ref += ref_stride / 2;
+        dis += dis_stride / 2;
+    }
+
+    return vaddvq_u64(sse) + sse_tail;
+}
@@ -0,0 +1,15 @@
+#ifndef ARM64_PSNR_H_
+#define ARM64_PSNR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+uint64_t psnr_sse_8_neon(const uint8_t *ref, ptrdiff_t ref_stride,
+                         const uint8_t *dis, ptrdiff_t dis_stride,
+                         unsigned w, unsigned h);
+
+uint64_t psnr_sse_16_neon(const uint16_t *ref, ptrdiff_t ref_stride,
+                          const uint16_t *dis, ptrdiff_t dis_stride,
+                          unsigned w, unsigned h, unsigned bpc);
+
+#endif /* ARM64_PSNR_H_ */
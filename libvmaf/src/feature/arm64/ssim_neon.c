@@ -0,0 +1,160 @@
+#include <arm_neon.h>
+
+#include "feature/iqa/ssim_tools.h"
+#include "ssim_neon.h"
+
+/* Products are rounded to float and summed as double, like the C kernels */
+static inline void acc_f64(float64x2_t *lo, float64x2_t *hi, float32x4_t p)
+{
+    *lo = vaddq_f64(*lo, vcvt_f64_f32(vget_low_f32(p)));
+    *hi = vaddq_f64(*hi, vcvt_high_f64_f32(p));
+}
+
+static inline float32x4_t cvt_f32(float64x2_t lo, float64x2_t hi)
+{
+    return vcvt_high_f32_f64(vcvt_f32_f64(lo), hi);
+}
+
+void ssim_filter_h_neon(const float *ref, const float *cmp, int w,
+                        const float *k, int k_len,
+                        float *const dst[SSIM_MAP_CNT])
+{
+    int x = 0;
+    for (; x + 4 <= w; x += 4) {
+        float64x2_t lo[SSIM_MAP_CNT], hi[SSIM_MAP_CNT];
+        for (int m = 0; m < SSIM_MAP_CNT; m++)
+            lo[m] = hi[m] = vdupq_n_f64(0.0);
+
+        for (int u = 0; u < k_len; u++) {
+            const float32x4_t kv = vdupq_n_f32(k[u]);
+            const float32x4_t r = vld1q_f32(ref + x + u);
+            const float32x4_t c = vld1q_f32(cmp + x + u);
+            acc_f64(&lo[0], &hi[0], vmulq_f32(r, kv));
+            acc_f64(&lo[1], &hi[1], vmulq_f32(c, kv));
+            acc_f64(&lo[2], &hi[2], vmulq_f32(vmulq_f32(r, r), kv));
+            acc_f64(&lo[3], &hi[3], vmulq_f32(vmulq_f32(c, c), kv));
+            acc_f64(&lo[4], &hi[4], vmulq_f32(vmulq_f32(r, c), kv));
+        }
+
+        for (int m = 0; m < SSIM_MAP_CNT; m++)
+            vst1q_f32(dst[m] + x, cvt_f32(lo[m], hi[m]));
+    }
+
+    if (x < w) {
+        float *const tail[SSIM_MAP_CNT] = {
+            dst[0] + x, dst[1] + x, dst[2] + x, dst[3] + x, dst[4] + x,
+        };
+        _ssim_filter_h_c(ref + x, cmp + x, w - x, k, k_len, tail);
+    }
+}
+
+/* SSIM, luminance, contrast and structure of 2 pixels, in double */
+static inline void lcs_f64(float32x2_t ref_mu, float32x2_t cmp_mu,
+                           float32x2_t sigma_ref_sigma_cmp, float32x2_t l_den,
+                           float32x2_t c_den, float32x2_t s, const float C[3],
+                           double lcs[4][4], int i)
+{
+    const float64x2_t two = vdupq_n_f64(2.0);
+    const float64x2_t l_num =
+        vaddq_f64(vmulq_f64(vmulq_f64(two, vcvt_f64_f32(ref_mu)),
+                            vcvt_f64_f32(cmp_mu)),
+                  vdupq_n_f64(C[0]));
+    const float64x2_t c_num =
+        vaddq_f64(vmulq_f64(two, vcvt_f64_f32(sigma_ref_sigma_cmp)),
+                  vdupq_n_f64(C[1]));
+    const float64x2_t l = vdivq_f64(l_num, vcvt_f64_f32(l_den));
+    const float64x2_t c = vdivq_f64(c_num, vcvt_f64_f32(c_den));
+    const float64x2_t sd = vcvt_f64_f32(s);
+    vst1q_f64(&lcs[0][i], vmulq_f64(vmulq_f64(l, c), sd));
+    vst1q_f64(&lcs[1][i], l);
+    vst1q_f64(&lcs[2][i], c);
+    vst1q_f64(&lcs[3][i], sd);
+}
+
+void ssim_filter_v_neon(const float *const *src, int w,
+                        const float *k, int k_len,
+                        const float C[3], double sum[4])
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t c1 = vdupq_n_f32(C[0]);
+    const float32x4_t c2 = vdupq_n_f32(C[1]);
+    const float32x4_t c3 = vdupq_n_f32(C[2]);
+
+    for (int x = 0; x < w; x += 4) {
+        float32x4_t f[SSIM_MAP_CNT];
+        for (int m = 0; m < SSIM_MAP_CNT; m++) {
+            float64x2_t lo = vdupq_n_f64(0.0), hi = vdupq_n_f64(0.0);
+            for (int v = 0; v < k_len; v++) {
+                const float32x4_t p = vmulq_f32(vld1q_f32(src[m * k_len + v] + x),
+                                                vdupq_n_f32(k[v]));
+                acc_f64(&lo, &hi, p);
+            }
+            f[m] = cvt_f32(lo, hi);
+        }
+
+        const float32x4_t ref_mu = f[0];
+        const float32x4_t cmp_mu = f[1];
+        const float32x4_t ref_mu_sqd = vmulq_f32(ref_mu, ref_mu);
+        const float32x4_t cmp_mu_sqd = vmulq_f32(cmp_mu, cmp_mu);
+        float32x4_t ref_sigma_sqd = vsubq_f32(f[2], ref_mu_sqd);
+        float32x4_t cmp_sigma_sqd = vsubq_f32(f[3], cmp_mu_sqd);
+        /* unlike vmaxq_f32(), keeps the signed zeros of MAX(0.0f, x) in C */
+        ref_sigma_sqd = vbslq_f32(vcgtq_f32(zero, ref_sigma_sqd), zero, ref_sigma_sqd);
+        cmp_sigma_sqd = vbslq_f32(vcgtq_f32(zero, cmp_sigma_sqd), zero, cmp_sigma_sqd);
+        const float32x4_t sigma_both = vsubq_f32(f[4], vmulq_f32(ref_mu, cmp_mu));
+        const float32x4_t sigma_ref_sigma_cmp =
+            vsqrtq_f32(vmulq_f32(ref_sigma_sqd, cmp_sigma_sqd));
+
+        const float32x4_t l_den = vaddq_f32(vaddq_f32(ref_mu_sqd, cmp_mu_sqd), c1);
+        const float32x4_t c_den = vaddq_f32(vaddq_f32(ref_sigma_sqd, cmp_sigma_sqd), c2);
+        const uint32x4_t clamp = vandq_u32(vcltq_f32(sigma_both, zero),
+                                           vcleq_f32(sigma_ref_sigma_cmp, zero));
+        const float32x4_t s = vdivq_f32(vaddq_f32(vbslq_f32(clamp, zero, sigma_both), c3),
+                                        vaddq_f32(sigma_ref_sigma_cmp, c3));
+
+        double lcs[4][4];
+        lcs_f64(vget_low_f32(ref_mu), vget_low_f32(cmp_mu),
+                vget_low_f32(sigma_ref_sigma_cmp), vget_low_f32(l_den),
+                vget_low_f32(c_den), vget_low_f32(s), C, lcs, 0);
+        lcs_f64(vget_high_f32(ref_mu), vget_high_f32(cmp_mu),
+                vget_high_f32(sigma_ref_sigma_cmp), vget_high_f32(l_den),
+                vget_high_f32(c_den), vget_high_f32(s), C, lcs, 2);
+
+        /* summed in pixel order, as in the C kernel */
+        const int n = w - x < 4 ? w - x : 4;
+        for (int i = 0; i < n; i++) {
+            sum[0] += lcs[0][i];
+            sum[1] += lcs[1][i];
+            sum[2] += lcs[2][i];
+            sum[3] += lcs[3][i];
+        }
+    }
+}
+
+void ssim_decimate_row_neon(const float *img, int w,
+                            const struct _kernel *k, int y,
+                            int x0, int x1, float *dst)
+{
+    const int uc = k->w / 2;
+    const int vc = k->h / 2;
+    const int u_end = uc - !(k->w & 1);
+    const int v_end = vc - !(k->h & 1);
+
+    int x = x0;
+    /* the even columns of 8 floats per tap, all within the row */
+    for (; x + 4 <= x1 && 2 * x + 7 + u_end < w; x += 4) {
+        float64x2_t lo = vdupq_n_f64(0.0), hi = vdupq_n_f64(0.0);
+        const float *kernel = k->kernel;
+        for (int v = -vc; v <= v_end; v++) {
+            const float *row = img + (2 * y + v) * w + 2 * x;
+            for (int u = -uc; u <= u_end; u++) {
+                const float32x4_t even = vld2q_f32(row + u).val[0];
+                acc_f64(&lo, &hi, vmulq_f32(even, vdupq_n_f32(*kernel++)));
+            }
+        }
+        vst1q_f32(dst + x, cvt_f32(lo, hi));
+    }
+
+    if (x < x1)
+        _ssim_decimate_row_c(img, w, k, y, x, x1, dst);
+}
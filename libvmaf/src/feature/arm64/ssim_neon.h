@@ -0,0 +1,18 @@
+#ifndef ARM64_SSIM_H_
+#define ARM64_SSIM_H_
+
+#include "feature/iqa/ssim_tools.h"
+
+void ssim_filter_h_neon(const float *ref, const float *cmp, int w,
+                        const float *k, int k_len,
+                        float *const dst[SSIM_MAP_CNT]);
+
+void ssim_filter_v_neon(const float *const *src, int w,
+                        const float *k, int k_len,
+                        const float C[3], double sum[4]);
+
+void ssim_decimate_row_neon(const float *img, int w,
+                            const struct _kernel *k, int y,
+                            int x0, int x1, float *dst);
+
+#endif /* ARM64_SSIM_H_ */
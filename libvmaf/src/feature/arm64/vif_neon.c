@@ -505,7 +505,7 @@ void vif_subsample_rd_16_neon(VifBuffer buf, unsigned int w, unsigned int h, int
 }
 
 
-void vif_statistic_8_neon(struct VifPublicState *s, float *num, float *den, unsigned w, unsigned h)
+void vif_statistic_8_neon(struct VifPublicState *s, VifResiduals *residuals_out, unsigned w, unsigned h)
 {
     const unsigned int uiw15 = (w > 15 ? w - 15 : 0);
     const unsigned int uiw7 = (w > 7 ? w - 7 : 0);
@@ -767,11 +767,13 @@ void vif_statistic_8_neon(struct VifPublicState *s, float *num, float *den, unsi
             }
         }
     }
-    num[0] = accum_num_log / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
-    den[0] = accum_den_log / 2048.0 + accum_den_non_log;
+    residuals_out->accum_num_log = accum_num_log;
+    residuals_out->accum_den_log = accum_den_log;
+    residuals_out->accum_num_non_log = accum_num_non_log;
+    residuals_out->accum_den_non_log = accum_den_non_log;
 }
 
-void vif_statistic_16_neon(struct VifPublicState *s, float *num, float *den, unsigned w, unsigned h, int bpc, int scale)
+void vif_statistic_16_neon(struct VifPublicState *s, VifResiduals *residuals_out, unsigned w, unsigned h, int bpc, int scale)
 {
     const unsigned int uiw7 = (w > 7 ? w - 7 : 0);
     const unsigned int fwidth = vif_filter1d_width[scale];
@@ -1060,7 +1062,9 @@ void vif_statistic_16_neon(struct VifPublicState *s, float *num, float *den, uns
             accum_den_non_log += residuals.accum_den_non_log;
         }
     }
-    num[0] = accum_num_log / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
-    den[0] = accum_den_log / 2048.0 + accum_den_non_log;
+    residuals_out->accum_num_log = accum_num_log;
+    residuals_out->accum_den_log = accum_den_log;
+    residuals_out->accum_num_non_log = accum_num_non_log;
+    residuals_out->accum_den_non_log = accum_den_non_log;
 }
 
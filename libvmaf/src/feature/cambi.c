@@ -29,9 +29,15 @@
 #include "mem.h"
 #include "mkdirp.h"
 #include "picture.h"
+#include "picture_cache.h"
 
 #if ARCH_X86
 #include "x86/cambi_avx2.h"
+#if HAVE_AVX512
+#include "x86/cambi_avx512.h"
+#endif
+#elif ARCH_AARCH64
+#include "arm64/cambi_neon.h"
 #endif
 
 /* Ratio of pixels for computation, must be 0 < topk <= 1.0 */
@@ -79,7 +85,9 @@ static const int g_contrast_weights[32] = {1, 2, 3, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7
 typedef struct CambiBuffers {
     float *c_values;
     uint32_t *mask_dp;
+    size_t mask_dp_size;
     uint16_t *c_values_histograms;
+    size_t c_values_histograms_size;
     uint16_t *filter_mode_buffer;
     uint16_t *diffs_to_consider;
     uint16_t *tvi_for_diff;
@@ -88,6 +96,31 @@ typedef struct CambiBuffers {
 } CambiBuffers;
 
 typedef void (*VmafRangeUpdater)(uint16_t *arr, int left, int right);
+typedef void (*VmafCValuesRow)(float *c_values, const uint16_t *histograms,
+                               const uint16_t *image, const uint16_t *mask,
+                               int width, uint16_t num_diffs,
+                               const uint16_t *tvi_for_diff,
+                               const int *diff_weights, const int *all_diffs);
+typedef void (*VmafMode3Row)(uint16_t *dst, const uint16_t *a,
+                             const uint16_t *b, const uint16_t *c, int width);
+typedef void (*VmafDecimateRow)(uint16_t *dst, const uint16_t *src, int width);
+typedef uint32_t (*VmafMaskDpRow)(uint32_t *dp, const uint32_t *dp_prev,
+                                  const uint16_t *image,
+                                  const uint16_t *image_below, int width);
+typedef void (*VmafMaskRow)(uint16_t *mask, const uint32_t *dp_bottom,
+                            const uint32_t *dp_top, int filter_size,
+                            uint16_t mask_index, int width);
+
+/* Row kernels of the banding detection, see the scalar versions below. */
+typedef struct CambiKernels {
+    VmafRangeUpdater inc_range;
+    VmafRangeUpdater dec_range;
+    VmafCValuesRow c_values_row;
+    VmafMode3Row mode3_row;
+    VmafDecimateRow decimate_row;
+    VmafMaskDpRow mask_dp_row;
+    VmafMaskRow mask_row;
+} CambiKernels;
 
 typedef struct CambiState {
     VmafPicture pics[PICS_BUFFER_SIZE];
@@ -105,9 +138,9 @@ typedef struct CambiState {
     char *eotf;
     bool full_ref;
     FILE *heatmaps_files[NUM_SCALES];
-    VmafRangeUpdater inc_range_callback;
-    VmafRangeUpdater dec_range_callback;
+    CambiKernels kernels;
     CambiBuffers buffers;
+    unsigned band_cnt;
 } CambiState;
 
 static const VmafOption options[] = {
@@ -322,6 +355,145 @@ static void decrement_range(uint16_t *arr, int left, int right) {
     }
 }
 
+static void decimate_row(uint16_t *dst, const uint16_t *src, int width) {
+    for (int j = 0; j < width; j++) {
+        dst[j] = src[j << 1];
+    }
+}
+
+static inline uint16_t min3(uint16_t a, uint16_t b, uint16_t c) {
+    if (a <= b && a <= c) return a;
+    if (b <= c) return b;
+    return c;
+}
+
+static inline uint16_t mode3(uint16_t a, uint16_t b, uint16_t c) {
+    if (a == b || a == c) return a;
+    if (b == c) return b;
+    return min3(a, b, c);
+}
+
+static void mode3_row(uint16_t *dst, const uint16_t *a, const uint16_t *b,
+                      const uint16_t *c, int width) {
+    for (int j = 0; j < width; j++) {
+        dst[j] = mode3(a[j], b[j], c[j]);
+    }
+}
+
+/*
+* One row of the square sum dp: adds the running sum of zero_derivative along the row
+* to the dp row above. image_below is NULL on the last row of the image.
+* Returns the zero_derivative sum of the whole row.
+*/
+static uint32_t get_spatial_mask_dp_row(uint32_t *dp, const uint32_t *dp_prev,
+                                        const uint16_t *image, const uint16_t *image_below,
+                                        int width) {
+    uint32_t sum = 0;
+    for (int j = 0; j < width; j++) {
+        sum += (!image_below || image[j] == image_below[j]) &&
+               (j == width - 1 || image[j] == image[j + 1]);
+        dp[j] = dp_prev[j] + sum;
+    }
+    return sum;
+}
+
+static void get_spatial_mask_row(uint16_t *mask, const uint32_t *dp_bottom,
+                                 const uint32_t *dp_top, int filter_size,
+                                 uint16_t mask_index, int width) {
+    for (int j = 0; j < width; j++) {
+        int result =
+            dp_bottom[j + filter_size]
+            - dp_bottom[j]
+            - dp_top[j + filter_size]
+            + dp_top[j];
+        mask[j] = (result > mask_index);
+    }
+}
+
+static float c_value_pixel(const uint16_t *histograms, uint16_t value, const int *diff_weights,
+                           const int *diffs, uint16_t num_diffs, const uint16_t *tvi_thresholds, int histogram_col, int histogram_width) {
+    uint16_t p_0 = histograms[value * histogram_width + histogram_col];
+    float val, c_value = 0.0;
+    for (uint16_t d = 0; d < num_diffs; d++) {
+        if (value <= tvi_thresholds[d]) {
+            uint16_t p_1 = histograms[(value + diffs[num_diffs + d + 1]) * histogram_width + histogram_col];
+            uint16_t p_2 = histograms[(value + diffs[num_diffs - d - 1]) * histogram_width + histogram_col];
+            if (p_1 > p_2) {
+                val = (float)(diff_weights[d] * p_0 * p_1) / (p_1 + p_0);
+            }
+            else {
+                val = (float)(diff_weights[d] * p_0 * p_2) / (p_2 + p_0);
+            }
+
+            if (val > c_value) {
+                c_value = val;
+            }
+        }
+    }
+
+    return c_value;
+}
+
+static void calculate_c_values_row(float *c_values, const uint16_t *histograms, const uint16_t *image,
+                                   const uint16_t *mask, int width, const uint16_t num_diffs,
+                                   const uint16_t *tvi_for_diff, const int *diff_weights,
+                                   const int *all_diffs) {
+    for (int col = 0; col < width; col++) {
+        if (mask[col]) {
+            c_values[col] = c_value_pixel(
+                histograms, image[col] + num_diffs, diff_weights, all_diffs, num_diffs, tvi_for_diff, col, width
+            );
+        }
+    }
+}
+
+static const CambiKernels cambi_kernels_c = {
+    .inc_range = increment_range,
+    .dec_range = decrement_range,
+    .c_values_row = calculate_c_values_row,
+    .mode3_row = mode3_row,
+    .decimate_row = decimate_row,
+    .mask_dp_row = get_spatial_mask_dp_row,
+    .mask_row = get_spatial_mask_row,
+};
+
+static void init_kernels(CambiKernels *k) {
+    *k = cambi_kernels_c;
+
+#if ARCH_X86
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_X86_CPU_FLAG_AVX2) {
+        k->inc_range = cambi_increment_range_avx2;
+        k->dec_range = cambi_decrement_range_avx2;
+        k->c_values_row = cambi_c_values_row_avx2;
+        k->mode3_row = cambi_mode3_row_avx2;
+        k->decimate_row = cambi_decimate_row_avx2;
+        k->mask_dp_row = cambi_mask_dp_row_avx2;
+        k->mask_row = cambi_mask_row_avx2;
+    }
+#if HAVE_AVX512
+    if (flags & VMAF_X86_CPU_FLAG_AVX512) {
+        k->inc_range = cambi_increment_range_avx512;
+        k->dec_range = cambi_decrement_range_avx512;
+        k->c_values_row = cambi_c_values_row_avx512;
+        k->mode3_row = cambi_mode3_row_avx512;
+        k->decimate_row = cambi_decimate_row_avx512;
+    }
+#endif
+#elif ARCH_AARCH64
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_ARM_CPU_FLAG_NEON) {
+        k->inc_range = cambi_increment_range_neon;
+        k->dec_range = cambi_decrement_range_neon;
+        k->c_values_row = cambi_c_values_row_neon;
+        k->mode3_row = cambi_mode3_row_neon;
+        k->decimate_row = cambi_decimate_row_neon;
+        k->mask_dp_row = cambi_mask_dp_row_neon;
+        k->mask_row = cambi_mask_row_neon;
+    }
+#endif
+}
+
 #ifdef _WIN32
     #define PATH_SEPARATOR '\\'
 #else
@@ -393,15 +565,21 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     s->buffers.c_values = aligned_malloc(ALIGN_CEIL(alloc_w * sizeof(float)) * alloc_h, 32);
     if (!s->buffers.c_values) return -ENOMEM;
 
+    // the spatial mask and the c-values of every band have their own dp and histograms
+    s->band_cnt = vmaf_feature_extractor_band_cnt(fex, alloc_h);
+
     const uint16_t num_bins = 1024 + (s->buffers.all_diffs[2 * num_diffs] - s->buffers.all_diffs[0]);
-    s->buffers.c_values_histograms = aligned_malloc(ALIGN_CEIL(alloc_w * num_bins * sizeof(uint16_t)), 32);
+    s->buffers.c_values_histograms_size = ALIGN_CEIL(alloc_w * num_bins * sizeof(uint16_t)) / sizeof(uint16_t);
+    s->buffers.c_values_histograms =
+        aligned_malloc(s->buffers.c_values_histograms_size * sizeof(uint16_t) * s->band_cnt, 32);
     if (!s->buffers.c_values_histograms) return -ENOMEM;
 
     int pad_size = MASK_FILTER_SIZE >> 1;
     int dp_width = alloc_w + 2 * pad_size + 1;
     int dp_height = 2 * pad_size + 2;
 
-    s->buffers.mask_dp = aligned_malloc(ALIGN_CEIL(dp_height * dp_width * sizeof(uint32_t)), 32);
+    s->buffers.mask_dp_size = ALIGN_CEIL(dp_height * dp_width * sizeof(uint32_t)) / sizeof(uint32_t);
+    s->buffers.mask_dp = aligned_malloc(s->buffers.mask_dp_size * sizeof(uint32_t) * s->band_cnt, 32);
     if (!s->buffers.mask_dp) return -ENOMEM;
     s->buffers.filter_mode_buffer = aligned_malloc(ALIGN_CEIL(3 * alloc_w * sizeof(uint16_t)), 32);
     if (!s->buffers.filter_mode_buffer) return -ENOMEM;
@@ -426,16 +604,7 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
         }
     }
 
-    s->inc_range_callback = increment_range;
-    s->dec_range_callback = decrement_range;
-
-#if ARCH_X86
-    unsigned flags = vmaf_get_cpu_flags();
-    if (flags & VMAF_X86_CPU_FLAG_AVX2) {
-        s->inc_range_callback = cambi_increment_range_avx2;
-        s->dec_range_callback = cambi_decrement_range_avx2;
-    }
-#endif
+    init_kernels(&s->kernels);
 
     return err;
 }
@@ -613,43 +782,34 @@ static int cambi_preprocessing(const VmafPicture *image, VmafPicture *preprocess
 }
 
 /* Banding detection functions */
-static void decimate(VmafPicture *image, unsigned width, unsigned height) {
+static void decimate(VmafPicture *image, unsigned width, unsigned height,
+                     const CambiKernels *kernels) {
     uint16_t *data = image->data[0];
     ptrdiff_t stride = image->stride[0] >> 1;
     for (unsigned i = 0; i < height; i++) {
-        for (unsigned j = 0; j < width; j++) {
-            data[i * stride + j] = data[(i << 1) * stride + (j << 1)];
-        }
+        kernels->decimate_row(&data[i * stride], &data[(i << 1) * stride], width);
     }
 }
 
-static inline uint16_t min3(uint16_t a, uint16_t b, uint16_t c) {
-    if (a <= b && a <= c) return a;
-    if (b <= c) return b;
-    return c;
-}
-
-static inline uint16_t mode3(uint16_t a, uint16_t b, uint16_t c) {
-    if (a == b || a == c) return a;
-    if (b == c) return b;
-    return min3(a, b, c);
-}
-
-static void filter_mode(const VmafPicture *image, int width, int height, uint16_t *buffer) {
+/*
+* The mode of 3 values does not depend on their order, so both the horizontal
+* and the vertical filter are mode3_row() calls: on the neighbours of a row,
+* and on the three filtered rows around it.
+*/
+static void filter_mode(const VmafPicture *image, int width, int height, uint16_t *buffer,
+                        const CambiKernels *kernels) {
     uint16_t *data = image->data[0];
     ptrdiff_t stride = image->stride[0] >> 1;
     for (int i = 0; i < height; i++) {
         int curr_line = i % 3;
-        buffer[curr_line * width + 0] = data[i * stride + 0];
-        for (int j = 1; j < width - 1; j++) {
-            buffer[curr_line * width + j] = mode3(data[i * stride + j - 1], data[i * stride + j], data[i * stride + j + 1]);
-        }
-        buffer[curr_line * width + width - 1] = data[i * stride + width - 1];
+        uint16_t *row = &data[i * stride];
+        buffer[curr_line * width + 0] = row[0];
+        kernels->mode3_row(&buffer[curr_line * width + 1], &row[0], &row[1], &row[2], width - 2);
+        buffer[curr_line * width + width - 1] = row[width - 1];
 
         if (i > 1) {
-            for (int j = 0; j < width; j++) {
-                data[(i - 1) * stride + j] = mode3(buffer[0 * width + j], buffer[1 * width + j], buffer[2 * width + j]);
-            }
+            kernels->mode3_row(&data[(i - 1) * stride], &buffer[0 * width],
+                               &buffer[1 * width], &buffer[2 * width], width);
         }
     }
 }
@@ -673,11 +833,6 @@ static FORCE_INLINE inline uint16_t get_mask_index(unsigned input_width, unsigne
     return (filter_size * filter_size + 3 * (ceil_log2(shifted_wh) - 11) - 1)>>1;
 }
 
-static FORCE_INLINE inline bool get_derivative_data(const uint16_t *data, int width, int height, int i, int j, ptrdiff_t stride) {
-    return (i == height - 1 || (data[i * stride + j] == data[(i + 1) * stride + j])) &&
-           (j == width - 1 || (data[i * stride + j] == data[i * stride + j + 1]));
-}
-
 /*
 * This function calculates the horizontal and vertical derivatives of the image using 2x1 and 1x2 kernels.
 * We say a pixel has zero_derivative=1 if it's equal to its right and bottom neighbours, and =0 otherwise (edges also count as "equal").
@@ -685,10 +840,13 @@ static FORCE_INLINE inline bool get_derivative_data(const uint16_t *data, int wi
 * and stores 1 into the corresponding mask index iff this number is larger than mask_index.
 * To calculate the square sums, it uses a dynamic programming algorithm based on inclusion-exclusion.
 * To save memory, it uses a DP matrix of only the necessary size, rather than the full matrix, and indexes its rows cyclically.
+* Only the mask rows [row_begin, row_end) are computed. The square sums only take differences of the dp,
+* so the dp may start from zero pad_size rows above row_begin rather than at the top of the image.
 */
 static void get_spatial_mask_for_index(const VmafPicture *image, VmafPicture *mask,
                                        uint32_t *dp, uint16_t mask_index, uint16_t filter_size,
-                                       int width, int height) {
+                                       int width, int height, int row_begin, int row_end,
+                                       const CambiKernels *kernels) {
     uint16_t pad_size = filter_size >> 1;
     uint16_t *image_data = image->data[0];
     uint16_t *mask_data = mask->data[0];
@@ -698,163 +856,105 @@ static void get_spatial_mask_for_index(const VmafPicture *image, VmafPicture *ma
     int dp_height = 2 * pad_size + 2;
     memset(dp, 0, dp_width * dp_height * sizeof(uint32_t));
 
-    // Initial computation: fill dp except for the last row
-    for (int i = 0; i < pad_size; i++) {
-        for (int j = 0; j < width + pad_size; j++) {
-            int value = (i < height && j < width ? get_derivative_data(image_data, width, height, i, j, stride) : 0);
-            int curr_row = i + pad_size + 1;
-            int curr_col = j + pad_size + 1;
-            dp[curr_row * dp_width + curr_col] =
-                value
-                + dp[(curr_row - 1) * dp_width + curr_col]
-                + dp[curr_row * dp_width + curr_col - 1]
-                - dp[(curr_row - 1) * dp_width + curr_col - 1];
+    // dp row of image row i, the rows above the image are zero
+    #define DP_ROW(i) (&dp[(((i) + pad_size + 1) % dp_height) * dp_width])
+
+    for (int i = MAX(row_begin - pad_size, 0); i < row_end + pad_size; i++) {
+        // First compute the values of dp for row i, starting at the column of pixel 0
+        uint32_t *curr = DP_ROW(i) + pad_size + 1;
+        const uint32_t *prev = DP_ROW(i + dp_height - 1) + pad_size + 1;
+        uint32_t sum = 0;
+        if (i < height) {
+            const uint16_t *row = &image_data[i * stride];
+            sum = kernels->mask_dp_row(curr, prev, row, i == height - 1 ? NULL : row + stride, width);
         }
-    }
-
-    // Start from the last row in the dp matrix
-    int curr_row = dp_height - 1;
-    int curr_compute = pad_size + 1;
-    for (int i = pad_size; i < height + pad_size; i++) {
-        // First compute the values of dp for curr_row
-        for (int j = 0; j < width + pad_size; j++) {
-            int value = (i < height && j < width ? get_derivative_data(image_data, width, height, i, j, stride) : 0);
-            int curr_col = j + pad_size + 1;
-            int prev_row = (curr_row + dp_height - 1) % dp_height;
-            dp[curr_row * dp_width + curr_col] =
-                value
-                + dp[prev_row * dp_width + curr_col]
-                + dp[curr_row * dp_width + curr_col - 1]
-                - dp[prev_row * dp_width + curr_col - 1];
+        else {
+            for (int j = 0; j < width; j++) {
+                curr[j] = prev[j];
+            }
         }
-        curr_row = (curr_row + 1) % dp_height;
-
-        // Then use the values to compute the square sum for the curr_compute row.
-        for (int j = 0; j < width; j++) {
-            int curr_col = j + pad_size + 1;
-            int bottom = (curr_compute + pad_size) % dp_height;
-            int top = (curr_compute + dp_height - pad_size - 1) % dp_height;
-            int right = curr_col + pad_size;
-            int left = curr_col - pad_size - 1;
-            int result =
-                dp[bottom * dp_width + right]
-                - dp[bottom * dp_width + left]
-                - dp[top * dp_width + right]
-                + dp[top * dp_width + left];
-            mask_data[(i - pad_size) * stride + j] = (result > mask_index);
+        for (int j = width; j < width + pad_size; j++) {
+            curr[j] = prev[j] + sum;
         }
-        curr_compute = (curr_compute + 1) % dp_height;
-    }
-}
-
-static void get_spatial_mask(const VmafPicture *image, VmafPicture *mask,
-                             uint32_t *dp, unsigned width, unsigned height) {
-    uint16_t mask_index = get_mask_index(width, height, MASK_FILTER_SIZE);
-    get_spatial_mask_for_index(image, mask, dp, mask_index, MASK_FILTER_SIZE, width, height);
-}
-
-static float c_value_pixel(const uint16_t *histograms, uint16_t value, const int *diff_weights,
-                           const int *diffs, uint16_t num_diffs, const uint16_t *tvi_thresholds, int histogram_col, int histogram_width) {
-    uint16_t p_0 = histograms[value * histogram_width + histogram_col];
-    float val, c_value = 0.0;
-    for (uint16_t d = 0; d < num_diffs; d++) {
-        if (value <= tvi_thresholds[d]) {
-            uint16_t p_1 = histograms[(value + diffs[num_diffs + d + 1]) * histogram_width + histogram_col];
-            uint16_t p_2 = histograms[(value + diffs[num_diffs - d - 1]) * histogram_width + histogram_col];
-            if (p_1 > p_2) {
-                val = (float)(diff_weights[d] * p_0 * p_1) / (p_1 + p_0);
-            }
-            else {
-                val = (float)(diff_weights[d] * p_0 * p_2) / (p_2 + p_0);
-            }
 
-            if (val > c_value) {
-                c_value = val;
-            }
+        // Then use the values to compute the square sum for row i - pad_size.
+        if (i - pad_size >= row_begin) {
+            kernels->mask_row(&mask_data[(i - pad_size) * stride], DP_ROW(i),
+                              DP_ROW(i + 1), 2 * pad_size + 1, mask_index, width);
         }
     }
 
-    return c_value;
+    #undef DP_ROW
 }
 
-static FORCE_INLINE inline void update_histogram_subtract_edge(uint16_t *histograms, uint16_t *image, uint16_t *mask,
-                                                          int i, int j, int width, ptrdiff_t stride, uint16_t pad_size,
-                                                          const uint16_t num_diffs, VmafRangeUpdater dec_range_callback) {
-    uint16_t mask_val = mask[(i - pad_size - 1) * stride + j];
-    if (mask_val) {
-        uint16_t val = image[(i - pad_size - 1) * stride + j] + num_diffs;
-        dec_range_callback(&histograms[val * width], MAX(j - pad_size, 0), MIN(j + pad_size + 1, width));
-    }
-}
-
-static FORCE_INLINE inline void update_histogram_subtract(uint16_t *histograms, uint16_t *image, uint16_t *mask,
-                                                          int i, int j, int width, ptrdiff_t stride, uint16_t pad_size,
-                                                          const uint16_t num_diffs, VmafRangeUpdater dec_range_callback) {
-    uint16_t mask_val = mask[(i - pad_size - 1) * stride + j];
-    if (mask_val) {
-        uint16_t val = image[(i - pad_size - 1) * stride + j] + num_diffs;
-        dec_range_callback(&histograms[val * width], j - pad_size, j + pad_size + 1);
-    }
+typedef struct CambiSpatialMaskJob {
+    const VmafPicture *image;
+    VmafPicture *mask;
+    const CambiBuffers *buffers;
+    const CambiKernels *kernels;
+    uint16_t mask_index;
+    int width, height;
+} CambiSpatialMaskJob;
+
+static void get_spatial_mask_band(void *data, unsigned band, unsigned row_begin, unsigned row_end) {
+    CambiSpatialMaskJob *job = data;
+    get_spatial_mask_for_index(job->image, job->mask, &job->buffers->mask_dp[band * job->buffers->mask_dp_size],
+                               job->mask_index, MASK_FILTER_SIZE, job->width, job->height, row_begin, row_end,
+                               job->kernels);
 }
 
-static FORCE_INLINE inline void update_histogram_add_edge(uint16_t *histograms, uint16_t *image, uint16_t *mask,
-                                                     int i, int j, int width, ptrdiff_t stride, uint16_t pad_size,
-                                                     const uint16_t num_diffs, VmafRangeUpdater inc_range_callback) {
-    uint16_t mask_val = mask[(i + pad_size) * stride + j];
-    if (mask_val) {
-        uint16_t val = image[(i + pad_size) * stride + j] + num_diffs;
-        inc_range_callback(&histograms[val * width], MAX(j - pad_size, 0), MIN(j + pad_size + 1, width));
-    }
-}
-
-static FORCE_INLINE inline void update_histogram_add(uint16_t *histograms, uint16_t *image, uint16_t *mask,
-                                                     int i, int j, int width, ptrdiff_t stride, uint16_t pad_size,
-                                                     const uint16_t num_diffs, VmafRangeUpdater inc_range_callback) {
-    uint16_t mask_val = mask[(i + pad_size) * stride + j];
-    if (mask_val) {
-        uint16_t val = image[(i + pad_size) * stride + j] + num_diffs;
-        inc_range_callback(&histograms[val * width], j - pad_size, j + pad_size + 1);
-    }
+static int get_spatial_mask(VmafFeatureExtractor *fex, const VmafPicture *image, VmafPicture *mask,
+                            unsigned width, unsigned height) {
+    CambiState *s = fex->priv;
+    CambiSpatialMaskJob job = {
+        .image = image,
+        .mask = mask,
+        .buffers = &s->buffers,
+        .kernels = &s->kernels,
+        .mask_index = get_mask_index(width, height, MASK_FILTER_SIZE),
+        .width = width,
+        .height = height,
+    };
+    return vmaf_feature_extractor_run_bands(fex, height, s->band_cnt, get_spatial_mask_band, &job);
 }
 
-static FORCE_INLINE inline void update_histogram_add_edge_first_pass(uint16_t *histograms, uint16_t *image, uint16_t *mask,
-                                                     int i, int j, int width, ptrdiff_t stride, uint16_t pad_size,
-                                                     const uint16_t num_diffs, VmafRangeUpdater inc_range_callback) {
-    uint16_t mask_val = mask[i * stride + j];
-    if (mask_val) {
-        uint16_t val = image[i * stride + j] + num_diffs;
-        inc_range_callback(&histograms[val * width], MAX(j - pad_size, 0), MIN(j + pad_size + 1, width));
+/*
+* Adds (or removes, depending on range_callback) the masked pixels of an image row
+* to the histograms of the columns within pad_size of them.
+*/
+static void update_histogram_row(uint16_t *histograms, const uint16_t *image, const uint16_t *mask,
+                                 int width, uint16_t pad_size, const uint16_t num_diffs,
+                                 VmafRangeUpdater range_callback) {
+    for (int j = 0; j < MIN(pad_size, width); j++) {
+        if (mask[j]) {
+            uint16_t val = image[j] + num_diffs;
+            range_callback(&histograms[val * width], MAX(j - pad_size, 0), MIN(j + pad_size + 1, width));
+        }
     }
-}
-
-static FORCE_INLINE inline void update_histogram_add_first_pass(uint16_t *histograms, uint16_t *image, uint16_t *mask,
-                                                     int i, int j, int width, ptrdiff_t stride, uint16_t pad_size,
-                                                     const uint16_t num_diffs, VmafRangeUpdater inc_range_callback) {
-    uint16_t mask_val = mask[i * stride + j];
-    if (mask_val) {
-        uint16_t val = image[i * stride + j] + num_diffs;
-        inc_range_callback(&histograms[val * width], j - pad_size, j + pad_size + 1);
+    for (int j = pad_size; j < width - pad_size - 1; j++) {
+        if (mask[j]) {
+            uint16_t val = image[j] + num_diffs;
+            range_callback(&histograms[val * width], j - pad_size, j + pad_size + 1);
+        }
     }
-}
-
-static FORCE_INLINE inline void calculate_c_values_row(float *c_values, uint16_t *histograms, uint16_t *image,
-                                                       uint16_t *mask, int row, int width, ptrdiff_t stride,
-                                                       const uint16_t num_diffs, const uint16_t *tvi_for_diff,
-                                                       const int *diff_weights, const int *all_diffs) {
-    for (int col = 0; col < width; col++) {
-        if (mask[row * stride + col]) {
-            c_values[row * width + col] = c_value_pixel(
-                histograms, image[row * stride + col] + num_diffs, diff_weights, all_diffs, num_diffs, tvi_for_diff, col, width
-            );
+    for (int j = MAX(width - pad_size - 1, pad_size); j < width; j++) {
+        if (mask[j]) {
+            uint16_t val = image[j] + num_diffs;
+            range_callback(&histograms[val * width], MAX(j - pad_size, 0), MIN(j + pad_size + 1, width));
         }
     }
 }
 
+/*
+* Computes the c-values of rows [row_begin, row_end). The histograms of a row hold the
+* masked pixels of the window around it, so a band first warms them up with the pad_size
+* rows above row_begin, and then slides them down one row at a time.
+*/
 static void calculate_c_values(VmafPicture *pic, const VmafPicture *mask_pic,
                                float *c_values, uint16_t *histograms, uint16_t window_size,
                                const uint16_t num_diffs, const uint16_t *tvi_for_diff,
                                const int *diff_weights, const int *all_diffs, int width, int height,
-                               VmafRangeUpdater inc_range_callback, VmafRangeUpdater dec_range_callback) {
+                               int row_begin, int row_end, const CambiKernels *kernels) {
 
     uint16_t pad_size = window_size >> 1;
     const uint16_t num_bins = 1024 + (all_diffs[2*num_diffs] - all_diffs[0]);
@@ -863,72 +963,62 @@ static void calculate_c_values(VmafPicture *pic, const VmafPicture *mask_pic,
     uint16_t *mask = mask_pic->data[0];
     ptrdiff_t stride = pic->stride[0] >> 1;
 
-    memset(c_values, 0.0, sizeof(float) * width * height);
+    memset(&c_values[row_begin * width], 0.0, sizeof(float) * width * (row_end - row_begin));
 
     // Use a histogram for each pixel in width
     // histograms[i * width + j] accesses the j'th histogram, i'th value
     // This is done for cache optimization reasons
     memset(histograms, 0, width * num_bins * sizeof(uint16_t));
 
-    // First pass: first pad_size rows
-    for (int i = 0; i < pad_size; i++) {
-        for (int j = 0; j < pad_size; j++) {
-            update_histogram_add_edge_first_pass(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, inc_range_callback);
-        }
-        for (int j = pad_size; j < width - pad_size - 1; j++) {
-            update_histogram_add_first_pass(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, inc_range_callback);
-        }
-        for (int j = MAX(width - pad_size - 1, pad_size); j < width; j++) {
-            update_histogram_add_edge_first_pass(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, inc_range_callback);
-        }
+    for (int i = MAX(row_begin - pad_size, 0); i < MIN(row_begin + pad_size, height); i++) {
+        update_histogram_row(histograms, &image[i * stride], &mask[i * stride], width, pad_size,
+                             num_diffs, kernels->inc_range);
     }
 
-    // Iterate over all rows, unrolled into 3 loops to avoid conditions
-    for (int i = 0; i < pad_size + 1; i++) {
-        if (i + pad_size < height) {
-            for (int j = 0; j < pad_size; j++) {
-                update_histogram_add_edge(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, inc_range_callback);
-            }
-            for (int j = pad_size; j < width - pad_size - 1; j++) {
-                update_histogram_add(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, inc_range_callback);
-            }
-            for (int j = MAX(width - pad_size - 1, pad_size); j < width; j++) {
-                update_histogram_add_edge(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, inc_range_callback);
-            }
-        }
-        calculate_c_values_row(c_values, histograms, image, mask, i, width, stride, num_diffs, tvi_for_diff, diff_weights, all_diffs);
-    }
-    for (int i = pad_size + 1; i < height - pad_size; i++) {
-        for (int j = 0; j < pad_size; j++) {
-            update_histogram_subtract_edge(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, dec_range_callback);
-            update_histogram_add_edge(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, inc_range_callback);
+    for (int i = row_begin; i < row_end; i++) {
+        int top = i - pad_size - 1;
+        int bottom = i + pad_size;
+        if (i > row_begin && top >= 0) {
+            update_histogram_row(histograms, &image[top * stride], &mask[top * stride], width, pad_size,
+                                 num_diffs, kernels->dec_range);
         }
-        for (int j = pad_size; j < width - pad_size - 1; j++) {
-            update_histogram_subtract(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, dec_range_callback);
-            update_histogram_add(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, inc_range_callback);
-        }
-        for (int j = MAX(width - pad_size - 1, pad_size); j < width; j++) {
-            update_histogram_subtract_edge(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, dec_range_callback);
-            update_histogram_add_edge(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, inc_range_callback);
-        }
-        calculate_c_values_row(c_values, histograms, image, mask, i, width, stride, num_diffs, tvi_for_diff, diff_weights, all_diffs);
-    }
-    for (int i = height - pad_size; i < height; i++) {
-        if (i - pad_size - 1 >= 0) {
-            for (int j = 0; j < pad_size; j++) {
-                update_histogram_subtract_edge(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, dec_range_callback);
-            }
-            for (int j = pad_size; j < width - pad_size - 1; j++) {
-                update_histogram_subtract(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, dec_range_callback);
-            }
-            for (int j = MAX(width - pad_size - 1, pad_size); j < width; j++) {
-                update_histogram_subtract_edge(histograms, image, mask, i, j, width, stride, pad_size, num_diffs, dec_range_callback);
-            }
+        if (bottom < height) {
+            update_histogram_row(histograms, &image[bottom * stride], &mask[bottom * stride], width, pad_size,
+                                 num_diffs, kernels->inc_range);
         }
-        calculate_c_values_row(c_values, histograms, image, mask, i, width, stride, num_diffs, tvi_for_diff, diff_weights, all_diffs);
+        kernels->c_values_row(&c_values[i * width], histograms, &image[i * stride], &mask[i * stride],
+                              width, num_diffs, tvi_for_diff, diff_weights, all_diffs);
     }
 }
 
+typedef struct CambiCValuesJob {
+    VmafPicture *image;
+    const VmafPicture *mask;
+    const CambiBuffers *buffers;
+    const CambiKernels *kernels;
+    uint16_t window_size, num_diffs;
+    const uint16_t *tvi_for_diff;
+    int width, height;
+} CambiCValuesJob;
+
+static void calculate_c_values_band(void *data, unsigned band, unsigned row_begin, unsigned row_end) {
+    CambiCValuesJob *job = data;
+    const CambiBuffers *b = job->buffers;
+    calculate_c_values(job->image, job->mask, b->c_values,
+                       &b->c_values_histograms[band * b->c_values_histograms_size],
+                       job->window_size, job->num_diffs, job->tvi_for_diff, b->diff_weights,
+                       b->all_diffs, job->width, job->height, row_begin, row_end, job->kernels);
+}
+
+/*
+* Every band warms its histograms up with the half window above it,
+* so the bands are kept at least two windows tall.
+*/
+static unsigned c_values_band_cnt(unsigned band_cnt, uint16_t window_size, int height) {
+    unsigned max_cnt = height / (2 * MAX(window_size, 1));
+    return MAX(MIN(band_cnt, max_cnt), 1);
+}
+
 static double average_topk_elements(const float *arr, int topk_elements) {
     double sum = 0;
     for (int i = 0; i < topk_elements; i++)
@@ -1014,11 +1104,12 @@ static int dump_c_values(FILE *heatmaps_files[], const float *c_values, int widt
     return 0;
 }
 
-static int cambi_score(VmafPicture *pics, uint16_t window_size, double topk,
+static int cambi_score(VmafFeatureExtractor *fex, VmafPicture *pics, uint16_t window_size, double topk,
                        const uint16_t num_diffs, const uint16_t *tvi_for_diff,
-                       CambiBuffers buffers, VmafRangeUpdater inc_range_callback, VmafRangeUpdater dec_range_callback,
+                       CambiBuffers buffers, const CambiKernels *kernels,
                        double *score, bool write_heatmaps, FILE *heatmaps_files[],
                        int width, int height, int frame) {
+    CambiState *s = fex->priv;
     double scores_per_scale[NUM_SCALES];
     VmafPicture *image = &pics[0];
     VmafPicture *mask = &pics[1];
@@ -1026,20 +1117,33 @@ static int cambi_score(VmafPicture *pics, uint16_t window_size, double topk,
     int scaled_width = width;
     int scaled_height = height;
 
-    get_spatial_mask(image, mask, buffers.mask_dp, width, height);
+    int err = get_spatial_mask(fex, image, mask, width, height);
+    if (err) return err;
     for (unsigned scale = 0; scale < NUM_SCALES; scale++) {
         if (scale > 0) {
             scaled_width = (scaled_width + 1) >> 1;
             scaled_height = (scaled_height + 1) >> 1;
-            decimate(image, scaled_width, scaled_height);
-            decimate(mask, scaled_width, scaled_height);
+            decimate(image, scaled_width, scaled_height, kernels);
+            decimate(mask, scaled_width, scaled_height, kernels);
         }
 
-        filter_mode(image, scaled_width, scaled_height, buffers.filter_mode_buffer);
-
-        calculate_c_values(image, mask, buffers.c_values, buffers.c_values_histograms, window_size,
-                           num_diffs, tvi_for_diff, buffers.diff_weights, buffers.all_diffs, scaled_width, scaled_height,
-                           inc_range_callback, dec_range_callback);
+        filter_mode(image, scaled_width, scaled_height, buffers.filter_mode_buffer, kernels);
+
+        CambiCValuesJob job = {
+            .image = image,
+            .mask = mask,
+            .buffers = &buffers,
+            .kernels = kernels,
+            .window_size = window_size,
+            .num_diffs = num_diffs,
+            .tvi_for_diff = tvi_for_diff,
+            .width = scaled_width,
+            .height = scaled_height,
+        };
+        err = vmaf_feature_extractor_run_bands(fex, scaled_height,
+                                               c_values_band_cnt(s->band_cnt, window_size, scaled_height),
+                                               calculate_c_values_band, &job);
+        if (err) return err;
 
         if (write_heatmaps) {
             int err = dump_c_values(heatmaps_files, buffers.c_values, scaled_width, scaled_height, scale, window_size,
@@ -1056,7 +1160,8 @@ static int cambi_score(VmafPicture *pics, uint16_t window_size, double topk,
     return 0;
 }
 
-static int preprocess_and_extract_cambi(CambiState *s, VmafPicture *pic, double *score, bool is_src, int frame) {
+static int preprocess_and_extract_cambi(VmafFeatureExtractor *fex, VmafPicture *pic, double *score, bool is_src, int frame) {
+    CambiState *s = fex->priv;
     int width = is_src ? s->src_width : s->enc_width;
     int height = is_src ? s->src_height : s->enc_height;
     int window_size = is_src ? s->src_window_size : s->window_size;
@@ -1066,13 +1171,63 @@ static int preprocess_and_extract_cambi(CambiState *s, VmafPicture *pic, double
     if (err) return err;
 
     bool write_heatmaps = s->heatmaps_path && !is_src;
-    err = cambi_score(s->pics, window_size, s->topk, num_diffs, s->buffers.tvi_for_diff,
-                      s->buffers, s->inc_range_callback, s->dec_range_callback, score, write_heatmaps, s->heatmaps_files, width, height, frame);
+    err = cambi_score(fex, s->pics, window_size, s->topk, num_diffs, s->buffers.tvi_for_diff,
+                      s->buffers, &s->kernels, score, write_heatmaps, s->heatmaps_files, width, height, frame);
     if (err) return err;
 
     return 0;
 }
 
+/* Everything the source score depends on besides the picture. Contexts
+ * scoring several distorted pictures against one source share the score
+ * when their options agree, see vmaf_read_pictures_multi(). */
+typedef struct CambiSourceKey {
+    unsigned width, height, bitdepth;
+    uint16_t window_size, max_log_contrast;
+    double topk, tvi_threshold;
+    char eotf[16];
+} CambiSourceKey;
+
+typedef struct CambiSource {
+    CambiSourceKey key;
+    double score;
+} CambiSource;
+
+static void cambi_source_key(CambiState *s, CambiSourceKey *key) {
+    memset(key, 0, sizeof(*key));
+    key->width = s->src_width;
+    key->height = s->src_height;
+    key->bitdepth = s->enc_bitdepth;
+    key->window_size = s->src_window_size;
+    key->max_log_contrast = s->max_log_contrast;
+    key->topk = s->topk;
+    key->tvi_threshold = s->tvi_threshold;
+    if (s->eotf) strncpy(key->eotf, s->eotf, sizeof(key->eotf) - 1);
+}
+
+static int fill_cambi_source(VmafPicture *pic, int param, void *data, void *cookie) {
+    VmafFeatureExtractor *fex = cookie;
+    CambiSource *src = data;
+    (void)param;
+
+    cambi_source_key(fex->priv, &src->key);
+    return preprocess_and_extract_cambi(fex, pic, &src->score, true, 0);
+}
+
+static int extract_cambi_source(VmafFeatureExtractor *fex, VmafPicture *pic, double *score, int frame) {
+    CambiSourceKey key;
+    cambi_source_key(fex->priv, &key);
+
+    const CambiSource *src =
+        vmaf_picture_cache_get(pic, VMAF_PICTURE_CACHE_CAMBI_SOURCE, 0, sizeof(*src), fill_cambi_source, fex);
+    if (src && !memcmp(&src->key, &key, sizeof(key))) {
+        *score = src->score;
+        return 0;
+    }
+
+    return preprocess_and_extract_cambi(fex, pic, score, true, frame);
+}
+
 static double combine_dist_src_scores(double dist_score, double src_score) {
     return MAX(0, dist_score - src_score);
 }
@@ -1086,7 +1241,7 @@ static int extract(VmafFeatureExtractor *fex,
 
     CambiState *s = fex->priv;
     double dist_score;
-    int err = preprocess_and_extract_cambi(s, dist_pic, &dist_score, false, index);
+    int err = preprocess_and_extract_cambi(fex, dist_pic, &dist_score, false, index);
     if (err) return err;
 
     err = vmaf_feature_collector_append(feature_collector, "cambi", dist_score, index);
@@ -1094,7 +1249,7 @@ static int extract(VmafFeatureExtractor *fex,
 
     if (s->full_ref) {
         double src_score;
-        int err = preprocess_and_extract_cambi(s, ref_pic, &src_score, true, index);
+        int err = extract_cambi_source(fex, ref_pic, &src_score, index);
         if (err) return err;
 
         err = vmaf_feature_collector_append(feature_collector, "cambi_source", src_score, index);
@@ -45,85 +45,30 @@ SOFTWARE.
 #include <errno.h>
 #include <math.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "cpu.h"
 #include "feature_collector.h"
 #include "feature_extractor.h"
 #include "mem.h"
 #include "opt.h"
 
+#if ARCH_X86
+#include "x86/ciede_avx2.h"
+#elif ARCH_AARCH64
+#include "arm64/ciede_neon.h"
+#endif
+
 typedef struct CiedeState {
-    VmafPicture ref;
-    VmafPicture dist;
-    void (*scale_chroma_planes)(VmafPicture *in, VmafPicture *out);
+    float *lut[2];
+    float *buf;
+    float *ref[3];
+    float *dist[3];
+    void (*de00_row)(const float *const ref[3], const float *const dist[3],
+                     unsigned w, unsigned bpc, double *de00_sum);
 } CiedeState;
 
-static void scale_chroma_planes_hbd(VmafPicture *in, VmafPicture *out)
-{
-    const int ss_hor = in->pix_fmt != VMAF_PIX_FMT_YUV444P;
-    const int ss_ver = in->pix_fmt == VMAF_PIX_FMT_YUV420P;
-
-    for (unsigned p = 0; p < 3; p++) {
-        uint16_t *in_buf = in->data[p];
-        uint16_t *out_buf = out->data[p];
-        for (unsigned i = 0; i < out->h[p]; i++) {
-            for (unsigned j = 0; j < out->w[p]; j++) {
-                out_buf[j] = in_buf[(j / ((p && ss_ver) ? 2 : 1))];
-            }
-            in_buf += (((p && ss_hor) ? i % 2 : 1) * in->stride[p]) / 2;
-            out_buf += out->stride[p] / 2;
-        }
-    }
-}
-
-static void scale_chroma_planes(VmafPicture *in, VmafPicture *out)
-{
-    const int ss_hor = in->pix_fmt != VMAF_PIX_FMT_YUV444P;
-    const int ss_ver = in->pix_fmt == VMAF_PIX_FMT_YUV420P;
-
-    for (unsigned p = 0; p < 3; p++) {
-        uint8_t *in_buf = in->data[p];
-        uint8_t *out_buf = out->data[p];
-        for (unsigned i = 0; i < out->h[p]; i++) {
-            for (unsigned j = 0; j < out->w[p]; j++) {
-                out_buf[j] = in_buf[(j / ((p && ss_ver) ? 2 : 1))];
-            }
-            in_buf += ((p && ss_hor) ? i % 2 : 1) * in->stride[p];
-            out_buf += out->stride[p];
-        }
-    }
-}
-
-static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
-                unsigned bpc, unsigned w, unsigned h)
-{
-    CiedeState *s = fex->priv;
-    int err = 0;
-
-    if (pix_fmt == VMAF_PIX_FMT_YUV400P)
-        return -EINVAL;
-
-    if (pix_fmt == VMAF_PIX_FMT_YUV444P)
-        return 0;
-
-    switch (bpc) {
-    case 8:
-        s->scale_chroma_planes = scale_chroma_planes;
-        break;
-    case 10:
-    case 12:
-    case 16:
-        s->scale_chroma_planes = scale_chroma_planes_hbd;
-        break;
-    default:
-        return -EINVAL;
-    }
-
-    err |= vmaf_picture_alloc(&s->ref, VMAF_PIX_FMT_YUV444P, bpc, w, h);
-    err |= vmaf_picture_alloc(&s->dist, VMAF_PIX_FMT_YUV444P, bpc, w, h);
-    return err;
-}
-
 static float get_h_prime(const float x, const float y)
 {
     if ((x == 0.0) && (y == 0.0))
@@ -307,6 +252,136 @@ static LABColor get_lab_color(double y, double u, double v, unsigned bpc)
     return lab_color;
 }
 
+static void de00_row(const float *const ref[3], const float *const dist[3],
+                     unsigned w, unsigned bpc, double *de00_sum)
+{
+    const KSubArgs default_ksub = { .l = 0.65, .c = 1.0, .h = 4.0 };
+
+    for (unsigned j = 0; j < w; j++) {
+        const LABColor color_1 =
+            get_lab_color(ref[0][j], ref[1][j], ref[2][j], bpc);
+        const LABColor color_2 =
+            get_lab_color(dist[0][j], dist[1][j], dist[2][j], bpc);
+        const float de00 = ciede2000(color_1, color_2, default_ksub);
+        *de00_sum += de00;
+    }
+}
+
+/*
+ * Loads row i of pic into dst through the luma and chroma luts, upsampling
+ * the chroma planes to full resolution on the way. Odd luma dimensions
+ * repeat the last chroma column and row.
+ */
+static void load_row(CiedeState *s, VmafPicture *pic, unsigned i,
+                     float *const dst[3])
+{
+    const int ss_hor = pic->pix_fmt != VMAF_PIX_FMT_YUV444P;
+    const int ss_ver = pic->pix_fmt == VMAF_PIX_FMT_YUV420P;
+
+    for (unsigned p = 0; p < 3; p++) {
+        const float *lut = s->lut[p ? 1 : 0];
+        const unsigned shift = p ? ss_hor : 0;
+        unsigned row = p ? i >> ss_ver : i;
+        if (row >= pic->h[p]) row = pic->h[p] - 1;
+        const unsigned w = pic->w[p] << shift;
+        float *out = dst[p];
+
+        unsigned j;
+        if (pic->bpc == 8) {
+            const uint8_t *in =
+                (uint8_t *) pic->data[p] + row * pic->stride[p];
+            for (j = 0; j < w; j++)
+                out[j] = lut[in[j >> shift]];
+        } else {
+            const uint16_t *in =
+                (uint16_t *) pic->data[p] + row * (pic->stride[p] / 2);
+            for (j = 0; j < w; j++)
+                out[j] = lut[in[j >> shift]];
+        }
+        for (; j < pic->w[0]; j++)
+            out[j] = out[w - 1];
+    }
+}
+
+static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
+                unsigned bpc, unsigned w, unsigned h)
+{
+    CiedeState *s = fex->priv;
+
+    if (pix_fmt == VMAF_PIX_FMT_YUV400P)
+        return -EINVAL;
+    // every chroma plane needs at least one sample, see load_row()
+    if (pix_fmt != VMAF_PIX_FMT_YUV444P && w < 2)
+        return -EINVAL;
+    if (pix_fmt == VMAF_PIX_FMT_YUV420P && h < 2)
+        return -EINVAL;
+
+    switch (bpc) {
+    case 8:
+    case 10:
+    case 12:
+    case 16:
+        break;
+    default:
+        return -EINVAL;
+    }
+
+    /*
+     * The SIMD kernels evaluate get_lab_color() and ciede2000() in single
+     * precision, with polynomial approximations of the libm functions.
+     * Per pixel they stay within 5e-4 of the scalar de00, which keeps the
+     * ciede2000 score within 1e-5 of the scalar one. They take normalized
+     * components where the scalar path takes code values, the luts map
+     * code values to either.
+     */
+    s->de00_row = de00_row;
+    float y_scale = 1.f, y_offset = 0.f, c_scale = 1.f, c_offset = 0.f;
+
+#if ARCH_X86
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_X86_CPU_FLAG_AVX2)
+        s->de00_row = ciede_de00_row_avx2;
+#elif ARCH_AARCH64
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_ARM_CPU_FLAG_NEON)
+        s->de00_row = ciede_de00_row_neon;
+#endif
+
+    if (s->de00_row != de00_row) {
+        const double scale = 1 << (bpc - 8);
+        y_scale = 1. / (219. * scale);
+        y_offset = 16. * scale;
+        c_scale = 1. / (224. * scale);
+        c_offset = 128. * scale;
+    }
+
+    // samples are not range checked, so the luts cover the whole container
+    const unsigned lut_sz = bpc == 8 ? 1 << 8 : 1 << 16;
+    const unsigned buf_stride = ALIGN_CEIL(w);
+    s->lut[0] = malloc(sizeof(float) * lut_sz);
+    s->lut[1] = malloc(sizeof(float) * lut_sz);
+    s->buf = aligned_malloc(sizeof(float) * buf_stride * 6, MAX_ALIGN);
+    if (!s->lut[0] || !s->lut[1] || !s->buf)
+        goto fail;
+
+    for (unsigned i = 0; i < lut_sz; i++) {
+        s->lut[0][i] = (i - y_offset) * y_scale;
+        s->lut[1][i] = (i - c_offset) * c_scale;
+    }
+    for (unsigned p = 0; p < 3; p++) {
+        s->ref[p] = s->buf + buf_stride * p;
+        s->dist[p] = s->buf + buf_stride * (p + 3);
+    }
+
+    return 0;
+
+fail:
+    free(s->lut[0]);
+    free(s->lut[1]);
+    aligned_free(s->buf);
+    return -ENOMEM;
+}
+
 static int extract(VmafFeatureExtractor *fex,
                    VmafPicture *ref_pic, VmafPicture *ref_pic_90,
                    VmafPicture *dist_pic, VmafPicture *dist_pic_90,
@@ -316,48 +391,13 @@ static int extract(VmafFeatureExtractor *fex,
     (void) ref_pic_90;
     (void) dist_pic_90;
 
-    if (ref_pic->pix_fmt == VMAF_PIX_FMT_YUV444P) {
-        s->ref = *ref_pic;
-        s->dist = *dist_pic;
-    } else {
-        s->scale_chroma_planes(ref_pic, &s->ref);
-        s->scale_chroma_planes(dist_pic, &s->dist);
-    }
-
     double de00_sum = 0.;
-    for (unsigned i = 0; i < s->ref.h[0]; i++) {
-        for (unsigned j = 0; j < s->ref.w[0]; j++) {
-            float r_y, r_u, r_v, d_y, d_u, d_v;
-
-            switch (s->ref.bpc) {
-            case 8:
-                r_y = ((uint8_t*)s->ref.data[0])[i * s->ref.stride[0] + j];
-                r_u = ((uint8_t*)s->ref.data[1])[i * s->ref.stride[1] + j];
-                r_v = ((uint8_t*)s->ref.data[2])[i * s->ref.stride[2] + j];
-                d_y = ((uint8_t*)s->dist.data[0])[i * s->dist.stride[0] + j];
-                d_u = ((uint8_t*)s->dist.data[1])[i * s->dist.stride[1] + j];
-                d_v = ((uint8_t*)s->dist.data[2])[i * s->dist.stride[2] + j];
-                break;
-            case 10:
-            case 12:
-            case 16:
-                r_y = ((uint16_t*)s->ref.data[0])[i * (s->ref.stride[0] / 2) + j];
-                r_u = ((uint16_t*)s->ref.data[1])[i * (s->ref.stride[1] / 2) + j];
-                r_v = ((uint16_t*)s->ref.data[2])[i * (s->ref.stride[2] / 2) + j];
-                d_y = ((uint16_t*)s->dist.data[0])[i * (s->dist.stride[0] / 2) + j];
-                d_u = ((uint16_t*)s->dist.data[1])[i * (s->dist.stride[1] / 2) + j];
-                d_v = ((uint16_t*)s->dist.data[2])[i * (s->dist.stride[2] / 2) + j];
-                break;
-            default:
-                return -EINVAL;
-            }
-
-            const LABColor color_1 = get_lab_color(r_y, r_u, r_v, s->ref.bpc);
-            const LABColor color_2 = get_lab_color(d_y, d_u, d_v, s->dist.bpc);
-            const KSubArgs default_ksub = { .l = 0.65, .c = 1.0, .h = 4.0 };
-            const float de00 = ciede2000(color_1, color_2, default_ksub);
-            de00_sum += de00;
-        }
+    for (unsigned i = 0; i < ref_pic->h[0]; i++) {
+        load_row(s, ref_pic, i, s->ref);
+        load_row(s, dist_pic, i, s->dist);
+        s->de00_row((const float *const *) s->ref,
+                    (const float *const *) s->dist,
+                    ref_pic->w[0], ref_pic->bpc, &de00_sum);
     }
 
     const double score = 45. - 20. *
@@ -369,8 +409,9 @@ static int extract(VmafFeatureExtractor *fex,
 static int close(VmafFeatureExtractor *fex)
 {
     CiedeState *s = fex->priv;
-    vmaf_picture_unref(&s->ref);
-    vmaf_picture_unref(&s->dist);
+    free(s->lut[0]);
+    free(s->lut[1]);
+    aligned_free(s->buf);
     return 0;
 }
 
@@ -17,6 +17,7 @@
  */
 
 #include <errno.h>
+#include <limits.h>
 #include <pthread.h>
 #include <stdarg.h>
 #include <stdbool.h>
@@ -137,6 +138,23 @@ unlock:
     return err;
 }
 
+static int feature_vector_grow(FeatureVector *feature_vector)
+{
+    const unsigned capacity = atomic_load(&feature_vector->capacity);
+    unsigned offset;
+    const unsigned segment = feature_segment(capacity, &offset);
+    if (segment >= FEATURE_SEGMENT_CNT) return -ENOMEM;
+
+    const unsigned segment_sz = segment ? capacity : 8;
+    const size_t sz = sizeof(*(feature_vector->segment[segment])) * segment_sz;
+    FeatureScore *score = malloc(sz);
+    if (!score) return -ENOMEM;
+    memset(score, 0, sz);
+    feature_vector->segment[segment] = score;
+    atomic_store(&feature_vector->capacity, capacity + segment_sz);
+    return 0;
+}
+
 static int feature_vector_init(FeatureVector **const feature_vector,
                                const char *name)
 {
@@ -149,10 +167,8 @@ static int feature_vector_init(FeatureVector **const feature_vector,
     fv->name = malloc(strlen(name) + 1);
     if (!fv->name) goto free_fv;
     strcpy(fv->name, name);
-    fv->capacity = 8;
-    fv->score = malloc(sizeof(fv->score[0]) * fv->capacity);
-    if (!fv->score) goto free_name;
-    memset(fv->score, 0, sizeof(fv->score[0]) * fv->capacity);
+    atomic_init(&fv->capacity, 0);
+    if (feature_vector_grow(fv)) goto free_name;
     return 0;
 
 free_name:
@@ -163,42 +179,150 @@ fail:
     return -ENOMEM;
 }
 
+static int feature_vector_init_ring(FeatureVector *feature_vector,
+                                    unsigned ring_sz)
+{
+    const size_t sz = sizeof(*(feature_vector->ring)) * ring_sz;
+    feature_vector->ring = malloc(sz);
+    if (!feature_vector->ring) return -ENOMEM;
+    memset(feature_vector->ring, 0, sz);
+    feature_vector->ring_mask = ring_sz - 1;
+    return 0;
+}
+
+static void feature_score_pool_destroy(FeatureScorePool *pool)
+{
+    if (!pool) return;
+    free(pool->sum);
+    free(pool->i_sum);
+    for (unsigned l = 0; l < FEATURE_POOL_LEVEL_CNT; l++) {
+        free(pool->min[l]);
+        free(pool->max[l]);
+        free(pool->block_sum[l]);
+        free(pool->block_i_sum[l]);
+    }
+    free(pool);
+}
+
 static void feature_vector_destroy(FeatureVector *feature_vector)
 {
     if (!feature_vector) return;
     free(feature_vector->name);
-    free(feature_vector->score);
+    free(feature_vector->ring);
+    feature_score_pool_destroy(feature_vector->pool);
+    for (unsigned i = 0; i < FEATURE_SEGMENT_CNT; i++)
+        free(feature_vector->segment[i]);
     free(feature_vector);
 }
 
-static int feature_vector_append(FeatureVector *feature_vector,
-                                 unsigned index, double score)
+static int feature_vector_reserve(FeatureVector *feature_vector,
+                                  unsigned index, pthread_mutex_t *lock)
+{
+    if (index < atomic_load(&feature_vector->capacity)) return 0;
+
+    int err = 0;
+    if (lock) pthread_mutex_lock(lock);
+    while (!err && index >= atomic_load(&feature_vector->capacity))
+        err = feature_vector_grow(feature_vector);
+    if (lock) pthread_mutex_unlock(lock);
+    return err;
+}
+
+static int feature_vector_append_locked(FeatureVector *feature_vector,
+                                        unsigned index, double score,
+                                        pthread_mutex_t *lock)
 {
     if (!feature_vector) return -EINVAL;
 
-    while (index >= feature_vector->capacity) {
-        size_t initial_size =
-            sizeof(feature_vector->score[0]) * feature_vector->capacity;
-        void *score = realloc(feature_vector->score, initial_size * 2);
-        if (!score) return -ENOMEM;
-        memset((char*)score + initial_size, 0, initial_size);
-        feature_vector->score = score;
-        feature_vector->capacity *= 2;
-    }
+    int err = feature_vector_reserve(feature_vector, index, lock);
+    if (err) return err;
+
+    unsigned offset;
+    const unsigned segment = feature_segment(index, &offset);
+    FeatureScore *s = &feature_vector->segment[segment][offset];
 
-    if (feature_vector->score[index].written) {
+    if (atomic_fetch_add(&s->claimed, 1)) {
         vmaf_log(VMAF_LOG_LEVEL_WARNING,
                  "feature \"%s\" cannot be overwritten at index %d\n",
                  feature_vector->name, index);
         return -EINVAL;
     }
 
-    feature_vector->score[index].written = true;
-    feature_vector->score[index].value = score;
+    s->value = score;
+    atomic_store(&s->written, 1);
 
     return 0;
 }
 
+// scores are folded in index order
+static void stats_fold(FeatureScoreStats *stats, double score, unsigned index)
+{
+    if (!stats->cnt || score < stats->min)
+        stats->min = score;
+    if (!stats->cnt || score > stats->max)
+        stats->max = score;
+    if (!stats->cnt || index < stats->index_low)
+        stats->index_low = index;
+    if (!stats->cnt || index > stats->index_high)
+        stats->index_high = index;
+    stats->sum += score;
+    stats->i_sum += 1. / (score + 1.);
+    stats->cnt++;
+}
+
+static void release_score(VmafFeatureCollector *fc, FeatureVector *fv,
+                          double score, unsigned index)
+{
+    if (fc->stream.consumer)
+        fc->stream.consumer(fc->stream.cookie, fv->name, score, index);
+
+    if ((fc->stream.subsample > 1) && (index % fc->stream.subsample))
+        return;
+
+    stats_fold(&fv->released, score, index);
+}
+
+static int feature_vector_append_stream(VmafFeatureCollector *fc,
+                                        FeatureVector *fv, unsigned index,
+                                        double score)
+{
+    int err = 0;
+    pthread_mutex_lock(&(fc->lock));
+
+    if (index < fc->stream.released) {
+        release_score(fc, fv, score, index);
+        goto unlock;
+    }
+
+    if (index - fc->stream.released >= fc->stream.capacity) {
+        vmaf_log(VMAF_LOG_LEVEL_WARNING,
+                 "feature \"%s\" at index %d is too far ahead of the "
+                 "released index %d\n", fv->name, index, fc->stream.released);
+        err = -EINVAL;
+        goto unlock;
+    }
+
+    // the indices not released yet all map to different slots
+    FeatureScore *s = &fv->ring[index & fv->ring_mask];
+    if (atomic_load(&s->written)) {
+        vmaf_log(VMAF_LOG_LEVEL_WARNING,
+                 "feature \"%s\" cannot be overwritten at index %d\n",
+                 fv->name, index);
+        err = -EINVAL;
+        goto unlock;
+    }
+
+    // tag the slot before its value changes, see feature_vector_get_score()
+    atomic_store(&s->index, index);
+    atomic_thread_fence(memory_order_release);
+    s->value = score;
+    atomic_store(&s->written, 1);
+
+unlock:
+    pthread_mutex_unlock(&(fc->lock));
+    return err;
+}
+
 int vmaf_feature_collector_init(VmafFeatureCollector **const feature_collector)
 {
     if (!feature_collector) return -EINVAL;
@@ -207,10 +331,11 @@ int vmaf_feature_collector_init(VmafFeatureCollector **const feature_collector)
     VmafFeatureCollector *const fc = *feature_collector = malloc(sizeof(*fc));
     if (!fc) goto fail;
     memset(fc, 0, sizeof(*fc));
+    atomic_init(&fc->cnt, 0);
     fc->capacity = 8;
-    fc->feature_vector = malloc(sizeof(*(fc->feature_vector)) * fc->capacity);
-    if (!fc->feature_vector) goto free_fc;
-    memset(fc->feature_vector, 0, sizeof(*(fc->feature_vector)) * fc->capacity);
+    fc->feature_vector[0] = malloc(sizeof(*(fc->feature_vector[0])) * fc->capacity);
+    if (!fc->feature_vector[0]) goto free_fc;
+    memset(fc->feature_vector[0], 0, sizeof(*(fc->feature_vector[0])) * fc->capacity);
     err = aggregate_vector_init(&fc->aggregate_vector);
     if (err) goto free_feature_vector;
     err = pthread_mutex_init(&(fc->lock), NULL);
@@ -220,33 +345,46 @@ int vmaf_feature_collector_init(VmafFeatureCollector **const feature_collector)
 free_aggregate_vector:
     aggregate_vector_destroy(&(fc->aggregate_vector));
 free_feature_vector:
-    free(fc->feature_vector);
+    free(fc->feature_vector[0]);
 free_fc:
     free(fc);
 fail:
     return -ENOMEM;
 }
 
-static FeatureVector *find_feature_vector(VmafFeatureCollector *fc,
-                                          const char *feature_name)
+static int find_feature_vector(VmafFeatureCollector *fc,
+                               const char *feature_name, unsigned *id)
 {
-    FeatureVector *feature_vector = NULL;
-    for (unsigned i = 0; i < fc->cnt; i++) {
-        FeatureVector *fv = fc->feature_vector[i];
+    const unsigned cnt = atomic_load(&fc->cnt);
+    for (unsigned i = 0; i < cnt; i++) {
+        FeatureVector *fv = vmaf_feature_collector_get_vector(fc, i);
         if (!strcmp(fv->name, feature_name)) {
-            feature_vector = fv;
-            break;
+            *id = i;
+            return 0;
         }
     }
-    return feature_vector;
+    return -EINVAL;
 }
 
-int vmaf_feature_collector_append(VmafFeatureCollector *feature_collector,
-                                  const char *feature_name, double score,
-                                  unsigned picture_index)
+int vmaf_feature_collector_get_id(VmafFeatureCollector *feature_collector,
+                                  const char *feature_name, unsigned *id)
+{
+    if (!feature_collector) return -EINVAL;
+    if (!feature_name) return -EINVAL;
+    if (!id) return -EINVAL;
+
+    return find_feature_vector(feature_collector, feature_name, id);
+}
+
+int vmaf_feature_collector_register(VmafFeatureCollector *feature_collector,
+                                    const char *feature_name, unsigned *id)
 {
     if (!feature_collector) return -EINVAL;
     if (!feature_name) return -EINVAL;
+    if (!id) return -EINVAL;
+
+    if (!find_feature_vector(feature_collector, feature_name, id))
+        return 0;
 
     pthread_mutex_lock(&(feature_collector->lock));
     int err = 0;
@@ -254,39 +392,98 @@ int vmaf_feature_collector_append(VmafFeatureCollector *feature_collector,
     if (!feature_collector->timer.begin)
         feature_collector->timer.begin = clock();
 
-    FeatureVector *feature_vector =
-        find_feature_vector(feature_collector, feature_name);
+    if (!find_feature_vector(feature_collector, feature_name, id))
+        goto unlock;
 
-    if (!feature_vector) {
-        err = feature_vector_init(&feature_vector, feature_name);
-        if (err) goto unlock;
-        if (feature_collector->cnt + 1 > feature_collector->capacity) {
-            size_t initial_size = sizeof(feature_collector->feature_vector[0]) *
-                feature_vector->capacity;
-            FeatureVector **fv =
-                realloc(feature_collector->feature_vector,
-                sizeof(*(feature_collector->feature_vector)) *
-                initial_size * 2);
-            if (!fv) {
-                err = -ENOMEM;
-                goto unlock;
-            }
-            memset(fv + feature_collector->capacity, 0, initial_size);
-            feature_collector->feature_vector = fv;
-            feature_collector->capacity *= 2;
+    const unsigned cnt = atomic_load(&feature_collector->cnt);
+    if (cnt >= feature_collector->capacity) {
+        unsigned offset;
+        const unsigned segment = feature_segment(cnt, &offset);
+        if (segment >= FEATURE_SEGMENT_CNT) {
+            err = -ENOMEM;
+            goto unlock;
+        }
+        const size_t sz = sizeof(*(feature_collector->feature_vector[0])) *
+                          feature_collector->capacity;
+        FeatureVector **fv = malloc(sz);
+        if (!fv) {
+            err = -ENOMEM;
+            goto unlock;
+        }
+        memset(fv, 0, sz);
+        feature_collector->feature_vector[segment] = fv;
+        feature_collector->capacity *= 2;
+    }
+
+    FeatureVector *feature_vector;
+    err = feature_vector_init(&feature_vector, feature_name);
+    if (err) goto unlock;
+    if (feature_collector->stream.capacity) {
+        err = feature_vector_init_ring(feature_vector,
+                                       feature_collector->stream.ring_sz);
+        if (err) {
+            feature_vector_destroy(feature_vector);
+            goto unlock;
         }
-        feature_collector->feature_vector[feature_collector->cnt++]
-            = feature_vector;
     }
 
-    err = feature_vector_append(feature_vector, picture_index, score);
+    unsigned offset;
+    const unsigned segment = feature_segment(cnt, &offset);
+    feature_collector->feature_vector[segment][offset] = feature_vector;
+    atomic_store(&feature_collector->cnt, cnt + 1);
+    *id = cnt;
 
 unlock:
-    feature_collector->timer.end = clock();
     pthread_mutex_unlock(&(feature_collector->lock));
     return err;
 }
 
+int vmaf_feature_collector_register_with_dict(VmafFeatureCollector *fc,
+        VmafDictionary *dict, const char *feature_name, unsigned *id)
+{
+    if (!fc) return -EINVAL;
+    if (!dict) return -EINVAL;
+
+    VmafDictionaryEntry *entry = vmaf_dictionary_get(&dict, feature_name, 0);
+    const char *fn = entry ? entry->val : feature_name;
+    return vmaf_feature_collector_register(fc, fn, id);
+}
+
+int vmaf_feature_collector_append_by_id(VmafFeatureCollector *feature_collector,
+                                        unsigned id, double score,
+                                        unsigned picture_index)
+{
+    if (!feature_collector) return -EINVAL;
+    if (id >= atomic_load(&feature_collector->cnt)) return -EINVAL;
+
+    FeatureVector *feature_vector =
+        vmaf_feature_collector_get_vector(feature_collector, id);
+
+    if (feature_vector->ring) {
+        return feature_vector_append_stream(feature_collector, feature_vector,
+                                            picture_index, score);
+    }
+
+    return feature_vector_append_locked(feature_vector, picture_index, score,
+                                        &(feature_collector->lock));
+}
+
+int vmaf_feature_collector_append(VmafFeatureCollector *feature_collector,
+                                  const char *feature_name, double score,
+                                  unsigned picture_index)
+{
+    if (!feature_collector) return -EINVAL;
+    if (!feature_name) return -EINVAL;
+
+    unsigned id;
+    int err = vmaf_feature_collector_register(feature_collector, feature_name,
+                                              &id);
+    if (err) return err;
+
+    return vmaf_feature_collector_append_by_id(feature_collector, id, score,
+                                               picture_index);
+}
+
 int vmaf_feature_collector_append_with_dict(VmafFeatureCollector *fc,
         VmafDictionary *dict, const char *feature_name, double score,
         unsigned index)
@@ -307,24 +504,302 @@ int vmaf_feature_collector_get_score(VmafFeatureCollector *feature_collector,
     if (!feature_name) return -EINVAL;
     if (!score) return -EINVAL;
 
-    pthread_mutex_lock(&(feature_collector->lock));
-    int err = 0;
+    unsigned id;
+    int err = find_feature_vector(feature_collector, feature_name, &id);
+    if (err) return err;
 
     FeatureVector *feature_vector =
-        find_feature_vector(feature_collector, feature_name);
+        vmaf_feature_collector_get_vector(feature_collector, id);
+    if (!feature_vector_get_score(feature_vector, index, score))
+        return -EINVAL;
+
+    return 0;
+}
+
+int vmaf_feature_collector_set_stream(VmafFeatureCollector *feature_collector,
+                                      unsigned capacity, unsigned subsample,
+                                      VmafFeatureScoreConsumer consumer,
+                                      void *cookie)
+{
+    if (!feature_collector) return -EINVAL;
+    if (!capacity) return -EINVAL;
+    if (capacity > (1u << 31)) return -EINVAL;
+
+    pthread_mutex_lock(&(feature_collector->lock));
+    int err = 0;
 
-    if (!feature_vector || index >= feature_vector->capacity) {
+    if (atomic_load(&feature_collector->cnt)) {
         err = -EINVAL;
         goto unlock;
     }
 
-    if (!feature_vector->score[index].written) {
-        err = -EINVAL;
-        goto unlock;
+    unsigned ring_sz = 1;
+    while (ring_sz < capacity)
+        ring_sz <<= 1;
+    feature_collector->stream.capacity = capacity;
+    feature_collector->stream.ring_sz = ring_sz;
+    feature_collector->stream.subsample = subsample;
+    feature_collector->stream.consumer = consumer;
+    feature_collector->stream.cookie = cookie;
+
+unlock:
+    pthread_mutex_unlock(&(feature_collector->lock));
+    return err;
+}
+
+int vmaf_feature_collector_release(VmafFeatureCollector *feature_collector,
+                                   unsigned index)
+{
+    if (!feature_collector) return -EINVAL;
+    if (!feature_collector->stream.capacity) return -EINVAL;
+
+    pthread_mutex_lock(&(feature_collector->lock));
+
+    const unsigned released = feature_collector->stream.released;
+    const unsigned cnt = atomic_load(&feature_collector->cnt);
+    // scores are only held for capacity indices from released
+    const unsigned n = index <= released ? 0 :
+        index - released < feature_collector->stream.capacity ?
+        index - released : feature_collector->stream.capacity;
+
+    for (unsigned i = released; i < released + n; i++) {
+        for (unsigned j = 0; j < cnt; j++) {
+            FeatureVector *fv =
+                vmaf_feature_collector_get_vector(feature_collector, j);
+            FeatureScore *s = &fv->ring[i & fv->ring_mask];
+            if (!atomic_load(&s->written) || atomic_load(&s->index) != i)
+                continue;
+            release_score(feature_collector, fv, s->value, i);
+            atomic_store(&s->written, 0);
+        }
+    }
+    if (index > released)
+        feature_collector->stream.released = index;
+
+    pthread_mutex_unlock(&(feature_collector->lock));
+    return 0;
+}
+
+int vmaf_feature_collector_get_released(VmafFeatureCollector *feature_collector,
+                                        const char *feature_name,
+                                        FeatureScoreStats *stats)
+{
+    if (!feature_collector) return -EINVAL;
+    if (!feature_name) return -EINVAL;
+    if (!stats) return -EINVAL;
+
+    unsigned id;
+    int err = find_feature_vector(feature_collector, feature_name, &id);
+    if (err) return err;
+
+    FeatureVector *feature_vector =
+        vmaf_feature_collector_get_vector(feature_collector, id);
+    pthread_mutex_lock(&(feature_collector->lock));
+    *stats = feature_vector->released;
+    pthread_mutex_unlock(&(feature_collector->lock));
+    return 0;
+}
+
+static int feature_score_pool_grow(FeatureScorePool *pool)
+{
+    const unsigned capacity = pool->capacity ? 2 * pool->capacity : 64;
+
+    double *sum = realloc(pool->sum, sizeof(*sum) * (capacity + 1));
+    if (!sum) return -ENOMEM;
+    pool->sum = sum;
+    double *i_sum = realloc(pool->i_sum, sizeof(*i_sum) * (capacity + 1));
+    if (!i_sum) return -ENOMEM;
+    pool->i_sum = i_sum;
+
+    for (unsigned l = 0; l < FEATURE_POOL_LEVEL_CNT && capacity >> l; l++) {
+        const size_t sz = sizeof(double) * (capacity >> l);
+        double *min = realloc(pool->min[l], sz);
+        if (!min) return -ENOMEM;
+        pool->min[l] = min;
+        double *max = realloc(pool->max[l], sz);
+        if (!max) return -ENOMEM;
+        pool->max[l] = max;
+        double *block_sum = realloc(pool->block_sum[l], sz);
+        if (!block_sum) return -ENOMEM;
+        pool->block_sum[l] = block_sum;
+        double *block_i_sum = realloc(pool->block_i_sum[l], sz);
+        if (!block_i_sum) return -ENOMEM;
+        pool->block_i_sum[l] = block_i_sum;
     }
 
-    *score = feature_vector->score[index].value;
+    pool->capacity = capacity;
+    return 0;
+}
 
+static int feature_score_pool_init(FeatureScorePool **const pool,
+                                   unsigned step)
+{
+    FeatureScorePool *const p = *pool = malloc(sizeof(*p));
+    if (!p) return -ENOMEM;
+    memset(p, 0, sizeof(*p));
+    p->step = step;
+
+    int err = feature_score_pool_grow(p);
+    if (err) {
+        feature_score_pool_destroy(p);
+        *pool = NULL;
+        return err;
+    }
+    p->sum[0] = p->i_sum[0] = 0.;
+    return 0;
+}
+
+// cover the blocks written since the last update
+static int feature_vector_update_pool(FeatureVector *fv, unsigned step)
+{
+    if (fv->pool && fv->pool->step != step) {
+        feature_score_pool_destroy(fv->pool);
+        fv->pool = NULL;
+    }
+    if (!fv->pool) {
+        int err = feature_score_pool_init(&fv->pool, step);
+        if (err) return err;
+    }
+
+    FeatureScorePool *pool = fv->pool;
+    const unsigned block_cnt = UINT_MAX / step / FEATURE_POOL_BLOCK_SZ;
+
+    while (pool->cnt < block_cnt) {
+        const unsigned b = pool->cnt;
+        double sum = pool->sum[b], i_sum = pool->i_sum[b], min = 0., max = 0.;
+        double block_sum = 0., block_i_sum = 0.;
+        for (unsigned k = 0; k < FEATURE_POOL_BLOCK_SZ; k++) {
+            const unsigned index = (b * FEATURE_POOL_BLOCK_SZ + k) * step;
+            double score;
+            if (!feature_vector_get_score(fv, index, &score)) return 0;
+            sum += score;
+            i_sum += 1. / (score + 1.);
+            block_sum += score;
+            block_i_sum += 1. / (score + 1.);
+            if (!k || score < min) min = score;
+            if (!k || score > max) max = score;
+        }
+
+        if (b == pool->capacity) {
+            int err = feature_score_pool_grow(pool);
+            if (err) return err;
+        }
+
+        pool->sum[b + 1] = sum;
+        pool->i_sum[b + 1] = i_sum;
+        pool->min[0][b] = min;
+        pool->max[0][b] = max;
+        pool->block_sum[0][b] = block_sum;
+        pool->block_i_sum[0][b] = block_i_sum;
+        for (unsigned l = 1; l < FEATURE_POOL_LEVEL_CNT; l++) {
+            if ((b + 1) & ((1u << l) - 1)) break;
+            const unsigned j = ((b + 1) >> l) - 1;
+            const double *min_l = pool->min[l - 1], *max_l = pool->max[l - 1];
+            pool->min[l][j] = min_l[2 * j] < min_l[2 * j + 1] ?
+                              min_l[2 * j] : min_l[2 * j + 1];
+            pool->max[l][j] = max_l[2 * j] > max_l[2 * j + 1] ?
+                              max_l[2 * j] : max_l[2 * j + 1];
+            const double *sum_l = pool->block_sum[l - 1];
+            const double *i_sum_l = pool->block_i_sum[l - 1];
+            pool->block_sum[l][j] = sum_l[2 * j] + sum_l[2 * j + 1];
+            pool->block_i_sum[l][j] = i_sum_l[2 * j] + i_sum_l[2 * j + 1];
+        }
+        pool->cnt++;
+    }
+
+    return 0;
+}
+
+// fold the covered blocks [block_low, block_high) into stats
+static void feature_score_pool_fold(FeatureScorePool *pool,
+                                    unsigned block_low, unsigned block_high,
+                                    FeatureScoreStats *stats)
+{
+    const unsigned step = pool->step;
+    bool first = !stats->cnt;
+
+    if (first) stats->index_low = block_low * FEATURE_POOL_BLOCK_SZ * step;
+    stats->index_high = (block_high * FEATURE_POOL_BLOCK_SZ - 1) * step;
+    stats->cnt += (block_high - block_low) * FEATURE_POOL_BLOCK_SZ;
+    // the running sums add up the scores from 0 in index order
+    if (!block_low) {
+        stats->sum += pool->sum[block_high];
+        stats->i_sum += pool->i_sum[block_high];
+    }
+
+    // greedy decomposition into aligned runs of 2^l blocks
+    for (unsigned b = block_low; b < block_high; first = false) {
+        unsigned l = b ? __builtin_ctz(b) : FEATURE_POOL_LEVEL_CNT - 1;
+        while ((1ull << l) > block_high - b) l--;
+        const double min = pool->min[l][b >> l], max = pool->max[l][b >> l];
+        if (first || min < stats->min) stats->min = min;
+        if (first || max > stats->max) stats->max = max;
+        if (block_low) {
+            stats->sum += pool->block_sum[l][b >> l];
+            stats->i_sum += pool->block_i_sum[l][b >> l];
+        }
+        b += 1u << l;
+    }
+}
+
+static int feature_vector_pool(FeatureVector *fv, unsigned index_low,
+                               unsigned index_high, unsigned step,
+                               FeatureScoreStats *stats)
+{
+    unsigned k = index_low / step + !!(index_low % step);
+    const unsigned last = index_high / step;
+    FeatureScorePool *pool = fv->pool;
+
+    if (pool) {
+        for (; k <= last && k % FEATURE_POOL_BLOCK_SZ; k++) {
+            double score;
+            if (!feature_vector_get_score(fv, k * step, &score))
+                return -EINVAL;
+            stats_fold(stats, score, k * step);
+        }
+        const unsigned block_low = k / FEATURE_POOL_BLOCK_SZ;
+        unsigned block_high = (last + 1) / FEATURE_POOL_BLOCK_SZ;
+        if (block_high > pool->cnt) block_high = pool->cnt;
+        if (block_low < block_high) {
+            feature_score_pool_fold(pool, block_low, block_high, stats);
+            k = block_high * FEATURE_POOL_BLOCK_SZ;
+        }
+    }
+
+    for (; k <= last; k++) {
+        double score;
+        if (!feature_vector_get_score(fv, k * step, &score)) return -EINVAL;
+        stats_fold(stats, score, k * step);
+    }
+
+    return 0;
+}
+
+int vmaf_feature_collector_pool(VmafFeatureCollector *feature_collector,
+                                const char *feature_name, unsigned index_low,
+                                unsigned index_high, unsigned step,
+                                FeatureScoreStats *stats)
+{
+    if (!feature_collector) return -EINVAL;
+    if (!feature_name) return -EINVAL;
+    if (index_low > index_high) return -EINVAL;
+    if (!step) return -EINVAL;
+    if (!stats) return -EINVAL;
+
+    unsigned id;
+    int err = find_feature_vector(feature_collector, feature_name, &id);
+    if (err) return err;
+
+    FeatureVector *feature_vector =
+        vmaf_feature_collector_get_vector(feature_collector, id);
+    pthread_mutex_lock(&(feature_collector->lock));
+    // streaming collectors only hold a window of scores, which are scanned
+    if (!feature_vector->ring) {
+        err = feature_vector_update_pool(feature_vector, step);
+        if (err) goto unlock;
+    }
+    err = feature_vector_pool(feature_vector, index_low, index_high, step,
+                              stats);
 unlock:
     pthread_mutex_unlock(&(feature_collector->lock));
     return err;
@@ -336,9 +811,13 @@ void vmaf_feature_collector_destroy(VmafFeatureCollector *feature_collector)
 
     pthread_mutex_lock(&(feature_collector->lock));
     aggregate_vector_destroy(&(feature_collector->aggregate_vector));
-    for (unsigned i = 0; i < feature_collector->cnt; i++)
-        feature_vector_destroy(feature_collector->feature_vector[i]);
-    free(feature_collector->feature_vector);
+    const unsigned cnt = atomic_load(&feature_collector->cnt);
+    for (unsigned i = 0; i < cnt; i++) {
+        feature_vector_destroy(
+            vmaf_feature_collector_get_vector(feature_collector, i));
+    }
+    for (unsigned i = 0; i < FEATURE_SEGMENT_CNT; i++)
+        free(feature_collector->feature_vector[i]);
     pthread_mutex_unlock(&(feature_collector->lock));
     pthread_mutex_destroy(&(feature_collector->lock));
     free(feature_collector);
@@ -20,20 +20,77 @@
 #define __VMAF_FEATURE_COLLECTOR_H__
 
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <time.h>
 
 #include "dict.h"
 
+/**
+ * Scores and feature vectors are stored in segments which are never moved
+ * once allocated, so that appends from multiple threads do not need to take
+ * the collector lock. Segment 0 holds 8 entries, segment k > 0 holds
+ * 8 << (k - 1) entries, so capacity still doubles on every allocation.
+ */
+#define FEATURE_SEGMENT_CNT 30
+
+typedef struct {
+    double value;
+    // only set in ring slots, see FeatureVector.ring
+    atomic_uint index;
+    atomic_int claimed, written;
+} FeatureScore;
+
+/**
+ * Running aggregates of the scores a streaming collector has released,
+ * see vmaf_feature_collector_set_stream(). Like pooling, they skip the
+ * indices which are not a multiple of the subsample factor.
+ */
+typedef struct {
+    unsigned cnt;
+    unsigned index_low, index_high;
+    double sum, i_sum, min, max;
+} FeatureScoreStats;
+
+#define FEATURE_POOL_BLOCK_SZ 8
+#define FEATURE_POOL_LEVEL_CNT 32
+
+/*
+ * Pooling index over the scores at multiples of step, in blocks of
+ * FEATURE_POOL_BLOCK_SZ. Covers the leading blocks which are fully written:
+ * sum[b] and i_sum[b] are the running sums of the scores before block b,
+ * which pool the ranges from 0 in index order. min[l][j], max[l][j],
+ * block_sum[l][j] and block_i_sum[l][j] aggregate blocks j << l to
+ * ((j + 1) << l) - 1, and pool the other ranges: a difference of running
+ * sums would cancel most of its digits late in a long sequence.
+ * Scores are written once, so covered blocks never change.
+ */
+typedef struct {
+    unsigned step;
+    unsigned cnt, capacity;
+    double *sum, *i_sum;
+    double *min[FEATURE_POOL_LEVEL_CNT], *max[FEATURE_POOL_LEVEL_CNT];
+    double *block_sum[FEATURE_POOL_LEVEL_CNT];
+    double *block_i_sum[FEATURE_POOL_LEVEL_CNT];
+} FeatureScorePool;
+
 typedef struct {
     char *name;
-    struct {
-        bool written;
-        double value;
-    } *score;
-    unsigned capacity;
+    FeatureScore *segment[FEATURE_SEGMENT_CNT];
+    atomic_uint capacity;
+    // streaming collectors keep the scores of index i in ring[i & ring_mask]
+    FeatureScore *ring;
+    unsigned ring_mask;
+    FeatureScoreStats released;
+    FeatureScorePool *pool;
 } FeatureVector;
 
+/**
+ * Receives the scores released by a streaming collector.
+ */
+typedef void (*VmafFeatureScoreConsumer)(void *cookie, const char *feature_name,
+                                         double score, unsigned index);
+
 typedef struct {
     struct {
         char *name;
@@ -43,19 +100,91 @@ typedef struct {
 } AggregateVector;
 
 typedef struct VmafFeatureCollector {
-    FeatureVector **feature_vector;
+    FeatureVector **feature_vector[FEATURE_SEGMENT_CNT];
     AggregateVector aggregate_vector;
-    unsigned cnt, capacity;
+    atomic_uint cnt;
+    unsigned capacity;
     struct { clock_t begin, end; } timer;
+    struct {
+        unsigned capacity, ring_sz, subsample;
+        unsigned released;
+        VmafFeatureScoreConsumer consumer;
+        void *cookie;
+    } stream;
     pthread_mutex_t lock;
 } VmafFeatureCollector;
 
+static inline unsigned feature_segment(unsigned index, unsigned *offset)
+{
+    const unsigned i = index >> 3;
+    if (!i) {
+        *offset = index;
+        return 0;
+    }
+    const unsigned segment = 32 - __builtin_clz(i);
+    *offset = index - (8u << (segment - 1));
+    return segment;
+}
+
+static inline FeatureVector *
+vmaf_feature_collector_get_vector(VmafFeatureCollector *fc, unsigned id)
+{
+    unsigned offset;
+    const unsigned segment = feature_segment(id, &offset);
+    return fc->feature_vector[segment][offset];
+}
+
+/*
+ * Reads the score at index into *score, which may be NULL, and returns
+ * whether it has been written. A released ring slot is reused by the append
+ * at index + ring_sz, which may race with this read: the slot is tagged
+ * with its index before its value is written, so the tag is checked again
+ * after reading the value.
+ */
+static inline bool
+feature_vector_get_score(FeatureVector *feature_vector, unsigned index,
+                         double *score)
+{
+    if (feature_vector->ring) {
+        FeatureScore *s =
+            &feature_vector->ring[index & feature_vector->ring_mask];
+        if (!atomic_load(&s->written) || atomic_load(&s->index) != index)
+            return false;
+        const double value = s->value;
+        atomic_thread_fence(memory_order_acquire);
+        if (!atomic_load(&s->written) || atomic_load(&s->index) != index)
+            return false;
+        if (score) *score = value;
+        return true;
+    }
+    if (index >= atomic_load(&feature_vector->capacity)) return false;
+    unsigned offset;
+    const unsigned segment = feature_segment(index, &offset);
+    FeatureScore *s = &feature_vector->segment[segment][offset];
+    if (!atomic_load(&s->written)) return false;
+    if (score) *score = s->value;
+    return true;
+}
+
 int vmaf_feature_collector_init(VmafFeatureCollector **const feature_collector);
 
+int vmaf_feature_collector_register(VmafFeatureCollector *feature_collector,
+                                    const char *feature_name, unsigned *id);
+
+int vmaf_feature_collector_get_id(VmafFeatureCollector *feature_collector,
+                                  const char *feature_name, unsigned *id);
+
+int vmaf_feature_collector_register_with_dict(VmafFeatureCollector *fc,
+        VmafDictionary *dict, const char *feature_name, unsigned *id);
+
 int vmaf_feature_collector_append(VmafFeatureCollector *feature_collector,
                                   const char *feature_name, double score,
                                   unsigned index);
 
+int vmaf_feature_collector_append_by_id(VmafFeatureCollector *feature_collector,
+                                        unsigned id, double score,
+                                        unsigned index);
+
 int vmaf_feature_collector_append_with_dict(VmafFeatureCollector *fc,
         VmafDictionary *dict, const char *feature_name, double score,
         unsigned index);
@@ -72,6 +201,51 @@ int vmaf_feature_collector_get_aggregate(VmafFeatureCollector *feature_collector
                                          const char *feature_name,
                                          double *score);
 
+/**
+ * Switch the collector to streaming, which bounds the memory held for
+ * scores. Scores are kept for at most capacity indices starting at the
+ * oldest index which has not been released; appends beyond that fail.
+ * vmaf_feature_collector_release() hands scores to consumer and folds them
+ * into FeatureVector.released. Only valid before any feature is registered.
+ *
+ * @param feature_collector Collector to switch.
+ * @param capacity          Number of indices to hold scores for.
+ * @param subsample         Subsample factor of the pooled indices.
+ * @param consumer          Optional, called with each released score, with
+ *                          the collector lock held. Scores appended at an
+ *                          index which has been released already are
+ *                          released right away, on the appending thread.
+ * @param cookie            Passed to consumer.
+ */
+int vmaf_feature_collector_set_stream(VmafFeatureCollector *feature_collector,
+                                      unsigned capacity, unsigned subsample,
+                                      VmafFeatureScoreConsumer consumer,
+                                      void *cookie);
+
+/**
+ * Release the scores of all indices below index, in index order.
+ */
+int vmaf_feature_collector_release(VmafFeatureCollector *feature_collector,
+                                   unsigned index);
+
+/**
+ * Running aggregates of the released scores of a feature.
+ */
+int vmaf_feature_collector_get_released(VmafFeatureCollector *feature_collector,
+                                        const char *feature_name,
+                                        FeatureScoreStats *stats);
+
+/**
+ * Fold the scores of a feature at the indices in [index_low, index_high]
+ * which are multiples of step into stats, in index order. Fails if any of
+ * them is missing. Takes O(log n) once the scores are written, see
+ * FeatureScorePool.
+ */
+int vmaf_feature_collector_pool(VmafFeatureCollector *feature_collector,
+                                const char *feature_name, unsigned index_low,
+                                unsigned index_high, unsigned step,
+                                FeatureScoreStats *stats);
+
 void vmaf_feature_collector_destroy(VmafFeatureCollector *feature_collector);
 
 #endif /* __VMAF_FEATURE_COLLECTOR_H__ */
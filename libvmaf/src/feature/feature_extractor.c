@@ -25,6 +25,7 @@
 #include "feature_extractor.h"
 #include "feature_name.h"
 #include "log.h"
+#include "picture.h"
 
 #if VMAF_FLOAT_FEATURES
 extern VmafFeatureExtractor vmaf_fex_float_psnr;
@@ -145,6 +146,8 @@ int vmaf_feature_extractor_context_create(VmafFeatureExtractorContext **fex_ctx,
         f->fex->priv = priv;
     }
 
+    pthread_mutex_init(&f->pipeline.lock, NULL);
+
     f->opts_dict = opts_dict;
     if (f->fex->options && f->fex->priv) {
         int err = vmaf_fex_ctx_parse_options(f);
@@ -177,6 +180,38 @@ int vmaf_feature_extractor_context_init(VmafFeatureExtractorContext *fex_ctx,
     return 0;
 }
 
+static int run_extract(VmafFeatureExtractorContext *fex_ctx,
+                       VmafPicture *ref, VmafPicture *ref_90,
+                       VmafPicture *dist, VmafPicture *dist_90,
+                       unsigned pic_index, VmafFeatureCollector *vfc)
+{
+    VmafFeatureExtractor *fex = fex_ctx->fex;
+    int err = 0;
+
+    if (fex->prepare && fex->reduce) {
+        VmafPicture prepared;
+        err = fex->prepare(fex, ref, dist, pic_index, &prepared);
+        if (!err) {
+            err = fex->reduce(fex, &prepared, pic_index, vfc);
+            err |= vmaf_picture_unref(&prepared);
+        }
+    } else {
+        err = fex->extract(fex, ref, ref_90, dist, dist_90, pic_index, vfc);
+    }
+
+    if (err) {
+        vmaf_log(VMAF_LOG_LEVEL_WARNING,
+                 "problem with feature extractor \"%s\" at index %d\n",
+                 fex->name, pic_index);
+    }
+    return err;
+}
+
+static bool has_extract(VmafFeatureExtractor *fex)
+{
+    return fex->extract || (fex->prepare && fex->reduce);
+}
+
 int vmaf_feature_extractor_context_extract(VmafFeatureExtractorContext *fex_ctx,
                                            VmafPicture *ref, VmafPicture *ref_90,
                                            VmafPicture *dist, VmafPicture *dist_90,
@@ -187,7 +222,7 @@ int vmaf_feature_extractor_context_extract(VmafFeatureExtractorContext *fex_ctx,
     if (!ref) return -EINVAL;
     if (!dist) return -EINVAL;
     if (!vfc) return -EINVAL;
-    if (!fex_ctx->fex->extract) return -EINVAL;
+    if (!has_extract(fex_ctx->fex)) return -EINVAL;
 
 
     if (!fex_ctx->is_initialized) {
@@ -197,16 +232,164 @@ int vmaf_feature_extractor_context_extract(VmafFeatureExtractorContext *fex_ctx,
         if (err) return err;
     }
 
-    int err = fex_ctx->fex->extract(fex_ctx->fex, ref, ref_90, dist, dist_90,
-                                    pic_index, vfc);
-    if (err) {
+    return run_extract(fex_ctx, ref, ref_90, dist, dist_90, pic_index, vfc);
+}
+
+typedef struct VmafPendingFrame {
+    unsigned seq, index;
+    int err;
+    bool ready;
+    VmafPicture ref, dist, prepared;
+    VmafFeatureCollector *vfc;
+    VmafFeatureExtractorDone done;
+    void *cookie;
+    struct VmafPendingFrame *next;
+} VmafPendingFrame;
+
+int vmaf_feature_extractor_context_submit(VmafFeatureExtractorContext *fex_ctx,
+                                          VmafPicture *ref, VmafPicture *dist,
+                                          unsigned *seq)
+{
+    if (!fex_ctx) return -EINVAL;
+    if (!ref) return -EINVAL;
+    if (!dist) return -EINVAL;
+    if (!seq) return -EINVAL;
+    if (!has_extract(fex_ctx->fex)) return -EINVAL;
+
+    if (!fex_ctx->is_initialized) {
+        int err =
+            vmaf_feature_extractor_context_init(fex_ctx, ref->pix_fmt, ref->bpc,
+                                                ref->w[0], ref->h[0]);
+        if (err) return err;
+    }
+
+    // the slot is queued along with its sequence number, so that the
+    // ordered stage can always get past it, whatever happens to it later
+    VmafPendingFrame *f = malloc(sizeof(*f));
+    if (!f) return -ENOMEM;
+    memset(f, 0, sizeof(*f));
+
+    pthread_mutex_lock(&fex_ctx->pipeline.lock);
+    f->seq = *seq = fex_ctx->pipeline.submitted++;
+    VmafPendingFrame **p = &fex_ctx->pipeline.pending;
+    while (*p) p = &(*p)->next;
+    *p = f;
+    pthread_mutex_unlock(&fex_ctx->pipeline.lock);
+    return 0;
+}
+
+static VmafPendingFrame *pending_frame_find(VmafFeatureExtractorContext *fex_ctx,
+                                            unsigned seq)
+{
+    pthread_mutex_lock(&fex_ctx->pipeline.lock);
+    VmafPendingFrame *f = fex_ctx->pipeline.pending;
+    while (f && f->seq != seq) f = f->next;
+    // a ready slot may be run and freed as soon as the lock is dropped
+    if (f && f->ready) f = NULL;
+    pthread_mutex_unlock(&fex_ctx->pipeline.lock);
+    return f;
+}
+
+static void pending_frame_run(VmafFeatureExtractorContext *fex_ctx,
+                              VmafPendingFrame *f)
+{
+    VmafFeatureExtractor *fex = fex_ctx->fex;
+
+    if (f->prepared.ref) {
+        if (!f->err) f->err = fex->reduce(fex, &f->prepared, f->index, f->vfc);
+        vmaf_picture_unref(&f->prepared);
+    } else if (f->ref.ref) {
+        f->err = fex->extract(fex, &f->ref, NULL, &f->dist, NULL, f->index,
+                              f->vfc);
+        vmaf_picture_unref(&f->ref);
+        vmaf_picture_unref(&f->dist);
+    }
+
+    if (f->err) {
         vmaf_log(VMAF_LOG_LEVEL_WARNING,
                  "problem with feature extractor \"%s\" at index %d\n",
-                 fex_ctx->fex->name, pic_index);
+                 fex->name, f->index);
+    }
+
+    if (f->done) f->done(f->cookie);
+}
+
+// marks a slot as ready, and runs the ready slots at the head of the queue
+// unless another thread is already at it
+static int pending_frame_finish(VmafFeatureExtractorContext *fex_ctx,
+                                VmafPendingFrame *slot)
+{
+    int err = slot->err;
+
+    pthread_mutex_lock(&fex_ctx->pipeline.lock);
+    slot->ready = true;
+    if (fex_ctx->pipeline.draining) {
+        pthread_mutex_unlock(&fex_ctx->pipeline.lock);
+        return err;
+    }
+
+    VmafPendingFrame *f;
+    fex_ctx->pipeline.draining = true;
+    while ((f = fex_ctx->pipeline.pending) && f->ready) {
+        fex_ctx->pipeline.pending = f->next;
+        pthread_mutex_unlock(&fex_ctx->pipeline.lock);
+        pending_frame_run(fex_ctx, f);
+        if (f == slot) err = f->err;
+        free(f);
+        pthread_mutex_lock(&fex_ctx->pipeline.lock);
     }
+    fex_ctx->pipeline.draining = false;
+    pthread_mutex_unlock(&fex_ctx->pipeline.lock);
+
     return err;
 }
 
+int vmaf_feature_extractor_context_extract_ordered(VmafFeatureExtractorContext *fex_ctx,
+                                                   VmafPicture *ref, VmafPicture *dist,
+                                                   unsigned pic_index, unsigned seq,
+                                                   VmafFeatureCollector *vfc,
+                                                   VmafFeatureExtractorDone done,
+                                                   void *cookie)
+{
+    if (!fex_ctx) return -EINVAL;
+    VmafPendingFrame *f = pending_frame_find(fex_ctx, seq);
+    if (!f) {
+        if (done) done(cookie);
+        return -EINVAL;
+    }
+
+    f->index = pic_index;
+    f->vfc = vfc;
+    f->done = done;
+    f->cookie = cookie;
+
+    // a slot with bad arguments still completes, so that later slots
+    // get reduced
+    VmafFeatureExtractor *fex = fex_ctx->fex;
+    if (!ref || !dist || !vfc) {
+        f->err = -EINVAL;
+    } else if (fex->prepare && fex->reduce) {
+        f->err = fex->prepare(fex, ref, dist, pic_index, &f->prepared);
+    } else {
+        vmaf_picture_ref(&f->ref, ref);
+        vmaf_picture_ref(&f->dist, dist);
+    }
+
+    return pending_frame_finish(fex_ctx, f);
+}
+
+int vmaf_feature_extractor_context_cancel(VmafFeatureExtractorContext *fex_ctx,
+                                          unsigned seq)
+{
+    if (!fex_ctx) return -EINVAL;
+    VmafPendingFrame *f = pending_frame_find(fex_ctx, seq);
+    if (!f) return -EINVAL;
+
+    f->err = -ECANCELED;
+    pending_frame_finish(fex_ctx, f);
+    return 0;
+}
+
 int vmaf_feature_extractor_context_flush(VmafFeatureExtractorContext *fex_ctx,
                                          VmafFeatureCollector *vfc)
 {
@@ -244,10 +427,72 @@ int vmaf_feature_extractor_context_destroy(VmafFeatureExtractorContext *fex_ctx)
     }
     if (fex_ctx->opts_dict)
         vmaf_dictionary_free(&fex_ctx->opts_dict);
+    for (VmafPendingFrame *f = fex_ctx->pipeline.pending, *next; f; f = next) {
+        next = f->next;
+        if (f->prepared.ref) vmaf_picture_unref(&f->prepared);
+        if (f->ref.ref) vmaf_picture_unref(&f->ref);
+        if (f->dist.ref) vmaf_picture_unref(&f->dist);
+        free(f);
+    }
+    pthread_mutex_destroy(&fex_ctx->pipeline.lock);
     free(fex_ctx);
     return 0;
 }
 
+#define BAND_MIN_ROWS 32
+
+unsigned vmaf_feature_extractor_band_cnt(VmafFeatureExtractor *fex,
+                                         unsigned h)
+{
+    if (!fex || !fex->thread_pool) return 1;
+
+    const unsigned n_threads = vmaf_thread_pool_n_threads(fex->thread_pool);
+    const unsigned max_cnt = h / BAND_MIN_ROWS;
+    const unsigned band_cnt = n_threads < max_cnt ? n_threads : max_cnt;
+    return band_cnt ? band_cnt : 1;
+}
+
+typedef struct BandJob {
+    VmafFeatureExtractorBandFunc func;
+    void *data;
+    unsigned h, band_cnt;
+} BandJob;
+
+static void run_band(void *data, unsigned band)
+{
+    BandJob *job = data;
+    const unsigned row_begin = (uint64_t) job->h * band / job->band_cnt;
+    const unsigned row_end = (uint64_t) job->h * (band + 1) / job->band_cnt;
+    job->func(job->data, band, row_begin, row_end);
+}
+
+int vmaf_feature_extractor_run_bands(VmafFeatureExtractor *fex, unsigned h,
+                                     unsigned band_cnt,
+                                     VmafFeatureExtractorBandFunc func,
+                                     void *data)
+{
+    if (!fex) return -EINVAL;
+    if (!func) return -EINVAL;
+    if (!band_cnt) return -EINVAL;
+
+    const unsigned max_cnt = h / BAND_MIN_ROWS;
+    if (band_cnt > max_cnt) band_cnt = max_cnt ? max_cnt : 1;
+
+    if (!fex->thread_pool || band_cnt == 1) {
+        func(data, 0, 0, h);
+        return 0;
+    }
+
+    BandJob job = {
+        .func = func,
+        .data = data,
+        .h = h,
+        .band_cnt = band_cnt,
+    };
+    return vmaf_thread_pool_parallel_for(fex->thread_pool, band_cnt,
+                                         run_band, &job);
+}
+
 int vmaf_fex_ctx_pool_create(VmafFeatureExtractorContextPool **pool,
                              unsigned n_threads)
 {
@@ -342,6 +587,24 @@ int vmaf_fex_ctx_pool_aquire(VmafFeatureExtractorContextPool *pool,
         goto unlock;
     }
 
+    // temporal feature extractors share a single context, which orders its
+    // own work, see vmaf_feature_extractor_context_extract_ordered()
+    if (fex->flags & VMAF_FEATURE_EXTRACTOR_TEMPORAL) {
+        if (!entry->ctx_list[0].fex_ctx) {
+            VmafDictionary *d = NULL;
+            if (opts_dict) {
+                err = vmaf_dictionary_copy(&opts_dict, &d);
+                if (err) goto unlock;
+            }
+            VmafFeatureExtractorContext *f;
+            err = vmaf_feature_extractor_context_create(&f, entry->fex, d);
+            if (err) goto unlock;
+            entry->ctx_list[0].fex_ctx = f;
+        }
+        *fex_ctx = entry->ctx_list[0].fex_ctx;
+        goto unlock;
+    }
+
     while (atomic_load(&entry->capacity) == atomic_load(&entry->in_use))
         pthread_cond_wait(&(entry->full), &(pool->lock));
 
@@ -395,6 +658,9 @@ int vmaf_fex_ctx_pool_release(VmafFeatureExtractorContextPool *pool,
         goto unlock;
     }
 
+    if (fex->flags & VMAF_FEATURE_EXTRACTOR_TEMPORAL)
+        goto unlock;
+
     for (int i = 0; i < atomic_load(&entry->capacity); i++) {
         if (fex_ctx == entry->ctx_list[i].fex_ctx) {
             entry->ctx_list[i].in_use = false;
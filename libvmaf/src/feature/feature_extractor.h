@@ -26,6 +26,7 @@
 #include "dict.h"
 #include "feature_collector.h"
 #include "opt.h"
+#include "thread_pool.h"
 
 #include "libvmaf/picture.h"
 
@@ -64,6 +65,33 @@ typedef struct VmafFeatureExtractor {
                    VmafPicture *ref_pic, VmafPicture *ref_pic_90,
                    VmafPicture *dist_pic, VmafPicture *dist_pic_90,
                    unsigned index, VmafFeatureCollector *feature_collector);
+    /**
+     * Frame-parallel stage of a temporal feature extractor. Optional, but
+     * must be set together with reduce(), which then replaces extract().
+     * Called for every pair of pictures, possibly concurrently and in any
+     * order, so it may only read fex->priv. The result is handed to reduce().
+     *
+     * @param      fex self.
+     * @param  ref_pic Reference VmafPicture.
+     * @param dist_pic Distorted VmafPicture.
+     * @param    index Picture index.
+     * @param prepared Output, allocated by the callback.
+     */
+    int (*prepare)(struct VmafFeatureExtractor *fex,
+                   VmafPicture *ref_pic, VmafPicture *dist_pic,
+                   unsigned index, VmafPicture *prepared);
+    /**
+     * Ordered stage of a temporal feature extractor. Optional, see prepare().
+     * Called once for every pair of pictures, in submission order.
+     *
+     * @param               fex self.
+     * @param          prepared Output of prepare() for this picture index,
+     *                          take a reference to keep it around.
+     * @param             index Picture index.
+     * @param feature_collector VmafFeatureCollector used to write out scores.
+     */
+    int (*reduce)(struct VmafFeatureExtractor *fex, VmafPicture *prepared,
+                  unsigned index, VmafFeatureCollector *feature_collector);
     /**
      * Buffer flush callback. Optional.
      * Called only when the VMAF_FEATURE_EXTRACTOR_TEMPORAL flag is set.
@@ -84,8 +112,54 @@ typedef struct VmafFeatureExtractor {
     size_t priv_size; ///< sizeof private data.
     uint64_t flags; ///< Feauture extraction flags, binary or'd.
     const char **provided_features; ///< Provided feature list, NULL terminated.
+    VmafThreadPool *thread_pool; ///< Optional, set by libvmaf for intra-frame parallelism.
 } VmafFeatureExtractor;
 
+/**
+ * Row band callback, see vmaf_feature_extractor_run_bands().
+ *
+ * @param      data User data.
+ * @param      band Band index, less than the band count passed in.
+ * @param row_begin First row of the band.
+ * @param   row_end One past the last row of the band.
+ */
+typedef void (*VmafFeatureExtractorBandFunc)(void *data, unsigned band,
+                                             unsigned row_begin,
+                                             unsigned row_end);
+
+/**
+ * Number of row bands worth splitting a plane of height h into. Extractors
+ * call this from init() to size per-band scratch buffers.
+ *
+ * @param fex self.
+ * @param   h Plane height.
+ *
+ * @return 1 when fex has no thread pool.
+ */
+unsigned vmaf_feature_extractor_band_cnt(VmafFeatureExtractor *fex,
+                                         unsigned h);
+
+/**
+ * Split rows [0, h) into at most band_cnt contiguous bands and call func once
+ * for every band, in parallel on fex->thread_pool when it is set. The calling
+ * thread takes part and this returns once every band is done. Bands are
+ * assigned deterministically from (h, band_cnt), so per-band partial results
+ * reduced in band order do not depend on scheduling.
+ *
+ * @param      fex self.
+ * @param        h Plane height.
+ * @param band_cnt Maximum number of bands, usually from
+ *                 vmaf_feature_extractor_band_cnt().
+ * @param     func Band callback.
+ * @param     data User data passed to func.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_feature_extractor_run_bands(VmafFeatureExtractor *fex, unsigned h,
+                                     unsigned band_cnt,
+                                     VmafFeatureExtractorBandFunc func,
+                                     void *data);
+
 VmafFeatureExtractor *vmaf_get_feature_extractor_by_name(const char *name);
 VmafFeatureExtractor *vmaf_get_feature_extractor_by_feature_name(const char *name);
 
@@ -97,6 +171,12 @@ typedef struct VmafFeatureExtractorContext {
     bool is_initialized, is_closed;
     VmafDictionary *opts_dict;
     VmafFeatureExtractor *fex;
+    struct {
+        pthread_mutex_t lock;
+        unsigned submitted;
+        bool draining;
+        struct VmafPendingFrame *pending;
+    } pipeline;
 } VmafFeatureExtractorContext;
 
 int vmaf_feature_extractor_context_create(VmafFeatureExtractorContext **fex_ctx,
@@ -113,6 +193,70 @@ int vmaf_feature_extractor_context_extract(VmafFeatureExtractorContext *fex_ctx,
                                            unsigned pic_index,
                                            VmafFeatureCollector *vfc);
 
+/**
+ * Called once the work of a slot is done, see
+ * vmaf_feature_extractor_context_extract_ordered().
+ */
+typedef void (*VmafFeatureExtractorDone)(void *cookie);
+
+/**
+ * Reserve the next slot of a temporal feature extractor context for
+ * vmaf_feature_extractor_context_extract_ordered(). Call this from a single
+ * thread, in picture order. Initializes the context on first use. Every
+ * reserved slot must be passed to either
+ * vmaf_feature_extractor_context_extract_ordered() or
+ * vmaf_feature_extractor_context_cancel().
+ *
+ * @param fex_ctx self.
+ * @param     ref Reference VmafPicture.
+ * @param    dist Distorted VmafPicture.
+ * @param     seq Output, sequence number of the reserved slot.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_feature_extractor_context_submit(VmafFeatureExtractorContext *fex_ctx,
+                                          VmafPicture *ref, VmafPicture *dist,
+                                          unsigned *seq);
+
+/**
+ * Extract features for the slot reserved as seq. May be called concurrently
+ * for different slots. The prepare() stage runs right away; reduce(), or
+ * extract() for feature extractors without prepare(), runs once all earlier
+ * slots are done, on whichever thread completes the sequence.
+ *
+ * @param   fex_ctx self.
+ * @param       ref Reference VmafPicture.
+ * @param      dist Distorted VmafPicture.
+ * @param pic_index Picture index.
+ * @param       seq Sequence number from vmaf_feature_extractor_context_submit().
+ * @param       vfc VmafFeatureCollector used to write out scores.
+ * @param      done Called once the scores of the slot are written, or the
+ *                  slot failed, on the thread which did it. May be NULL.
+ * @param    cookie Passed to done.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error. The slot
+ *         is completed either way.
+ */
+int vmaf_feature_extractor_context_extract_ordered(VmafFeatureExtractorContext *fex_ctx,
+                                                   VmafPicture *ref, VmafPicture *dist,
+                                                   unsigned pic_index, unsigned seq,
+                                                   VmafFeatureCollector *vfc,
+                                                   VmafFeatureExtractorDone done,
+                                                   void *cookie);
+
+/**
+ * Give up on a slot reserved with vmaf_feature_extractor_context_submit()
+ * which will never be extracted, so that the slots after it still get
+ * reduced.
+ *
+ * @param fex_ctx self.
+ * @param     seq Sequence number from vmaf_feature_extractor_context_submit().
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error.
+ */
+int vmaf_feature_extractor_context_cancel(VmafFeatureExtractorContext *fex_ctx,
+                                          unsigned seq);
+
 int vmaf_feature_extractor_context_flush(VmafFeatureExtractorContext *fex_ctx,
                                          VmafFeatureCollector *vfc);
 
@@ -32,8 +32,6 @@
 
 typedef struct AdmState {
     size_t float_stride;
-    float *ref;
-    float *dist;
     bool debug;
     double adm_enhn_gain_limit;
     double adm_norm_view_dist;
@@ -103,13 +101,10 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
 {
     (void)pix_fmt;
     (void)bpc;
+    (void)h;
 
     AdmState *s = fex->priv;
     s->float_stride = ALIGN_CEIL(w * sizeof(float));
-    s->ref = aligned_malloc(s->float_stride * h, 32);
-    if (!s->ref) goto fail;
-    s->dist = aligned_malloc(s->float_stride * h, 32);
-    if (!s->dist) goto fail;
 
     s->feature_name_dict =
         vmaf_feature_name_dict_from_provided_features(fex->provided_features,
@@ -119,8 +114,6 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     return 0;
 
 fail:
-    if (s->ref) aligned_free(s->ref);
-    if (s->dist) aligned_free(s->dist);
     vmaf_dictionary_free(&s->feature_name_dict);
     return -ENOMEM;
 }
@@ -136,12 +129,13 @@ static int extract(VmafFeatureExtractor *fex,
     (void) ref_pic_90;
     (void) dist_pic_90;
 
-    picture_copy(s->ref, s->float_stride, ref_pic, -128, ref_pic->bpc);
-    picture_copy(s->dist, s->float_stride, dist_pic, -128, dist_pic->bpc);
+    const float *ref = picture_copy_cached(ref_pic, -128);
+    const float *dist = picture_copy_cached(dist_pic, -128);
+    if (!ref || !dist) return -ENOMEM;
 
     double score, score_num, score_den;
     double scores[8];
-    err = compute_adm(s->ref, s->dist, ref_pic->w[0], ref_pic->h[0],
+    err = compute_adm(ref, dist, ref_pic->w[0], ref_pic->h[0],
                       s->float_stride, s->float_stride, &score, &score_num,
                       &score_den, scores, ADM_BORDER_FACTOR,
                       s->adm_enhn_gain_limit,
@@ -209,8 +203,6 @@ static int extract(VmafFeatureExtractor *fex,
 static int close(VmafFeatureExtractor *fex)
 {
     AdmState *s = fex->priv;
-    if (s->ref) aligned_free(s->ref);
-    if (s->dist) aligned_free(s->dist);
     vmaf_dictionary_free(&s->feature_name_dict);
     return 0;
 }
@@ -32,7 +32,6 @@
 
 typedef struct MotionState {
     size_t float_stride;
-    float *ref;
     float *tmp;
     float *blur[3];
     unsigned index;
@@ -71,12 +70,11 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     MotionState *s = fex->priv;
 
     s->float_stride = ALIGN_CEIL(w * sizeof(float));
-    s->ref = aligned_malloc(s->float_stride * h, 32);
     s->tmp = aligned_malloc(s->float_stride * h, 32);
     s->blur[0] = aligned_malloc(s->float_stride * h, 32);
     s->blur[1] = aligned_malloc(s->float_stride * h, 32);
     s->blur[2] = aligned_malloc(s->float_stride * h, 32);
-    if (!s->ref || !s->tmp || !s->blur[0] || !s->blur[1] || !s->blur[2])
+    if (!s->tmp || !s->blur[0] || !s->blur[1] || !s->blur[2])
         goto fail;
     if (s->motion_force_zero)
         fex->flush = NULL;
@@ -90,7 +88,6 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     return 0;
 
 fail:
-    if (s->ref) aligned_free(s->ref);
     if (s->blur[0]) aligned_free(s->blur[0]);
     if (s->blur[1]) aligned_free(s->blur[1]);
     if (s->blur[2]) aligned_free(s->blur[2]);
@@ -146,8 +143,9 @@ static int extract(VmafFeatureExtractor *fex,
     unsigned blur_idx_1 = (index + 1) % 3;
     unsigned blur_idx_2 = (index + 2) % 3;
 
-    picture_copy(s->ref, s->float_stride, ref_pic, -128, ref_pic->bpc);
-    convolution_f32_c_s(FILTER_5_s, 5, s->ref, s->blur[blur_idx_0], s->tmp,
+    const float *ref = picture_copy_cached(ref_pic, -128);
+    if (!ref) return -ENOMEM;
+    convolution_f32_c_s(FILTER_5_s, 5, ref, s->blur[blur_idx_0], s->tmp,
                         ref_pic->w[0], ref_pic->h[0],
                         s->float_stride / sizeof(float),
                         s->float_stride / sizeof(float));
@@ -199,7 +197,6 @@ static int close(VmafFeatureExtractor *fex)
 {
     MotionState *s = fex->priv;
 
-    if (s->ref) aligned_free(s->ref);
     if (s->blur[0]) aligned_free(s->blur[0]);
     if (s->blur[1]) aligned_free(s->blur[1]);
     if (s->blur[2]) aligned_free(s->blur[2]);
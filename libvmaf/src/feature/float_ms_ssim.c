@@ -20,21 +20,31 @@
 #include <math.h>
 #include <stddef.h>
 
+#include "cpu.h"
 #include "feature_collector.h"
 #include "feature_extractor.h"
 
 #include "mem.h"
 #include "ms_ssim.h"
 #include "picture_copy.h"
+#include "iqa/ssim_tools.h"
+
+#if ARCH_X86
+#include "x86/ssim_avx2.h"
+#if HAVE_AVX512
+#include "x86/ssim_avx512.h"
+#endif
+#elif ARCH_AARCH64
+#include "arm64/ssim_neon.h"
+#endif
 
 typedef struct MsSsimState {
     size_t float_stride;
-    float *ref;
-    float *dist;
     bool enable_lcs;
     bool enable_db;
     bool clip_db;
     double max_db;
+    struct _ssim_engine engine;
 } MsSsimState;
 
 static const VmafOption options[] = {
@@ -78,17 +88,34 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     }
 
     s->float_stride = ALIGN_CEIL(w * sizeof(float));
-    s->ref = aligned_malloc(s->float_stride * h, 32);
-    if (!s->ref) goto fail;
-    s->dist = aligned_malloc(s->float_stride * h, 32);
-    if (!s->dist) goto free_ref;
 
-    return 0;
+    int err = _iqa_ssim_engine_init(&s->engine, w, h);
+    if (err) return err;
+
+#if ARCH_X86
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_X86_CPU_FLAG_AVX2) {
+        s->engine.filter_h = ssim_filter_h_avx2;
+        s->engine.filter_v = ssim_filter_v_avx2;
+        s->engine.decimate_row = ssim_decimate_row_avx2;
+    }
+#if HAVE_AVX512
+    if (flags & VMAF_X86_CPU_FLAG_AVX512) {
+        s->engine.filter_h = ssim_filter_h_avx512;
+        s->engine.filter_v = ssim_filter_v_avx512;
+        s->engine.decimate_row = ssim_decimate_row_avx512;
+    }
+#endif
+#elif ARCH_AARCH64
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_ARM_CPU_FLAG_NEON) {
+        s->engine.filter_h = ssim_filter_h_neon;
+        s->engine.filter_v = ssim_filter_v_neon;
+        s->engine.decimate_row = ssim_decimate_row_neon;
+    }
+#endif
 
-free_ref:
-    free(s->ref);
-fail:
-    return -ENOMEM;
+    return 0;
 }
 
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
@@ -109,11 +136,13 @@ static int extract(VmafFeatureExtractor *fex,
     (void) ref_pic_90;
     (void) dist_pic_90;
 
-    picture_copy(s->ref, s->float_stride, ref_pic, 0, ref_pic->bpc);
-    picture_copy(s->dist, s->float_stride, dist_pic, 0, dist_pic->bpc);
+    const float *ref = picture_copy_cached(ref_pic, 0);
+    const float *dist = picture_copy_cached(dist_pic, 0);
+    if (!ref || !dist) return -ENOMEM;
 
     double score, l_scores[5], c_scores[5], s_scores[5];
-    err = compute_ms_ssim(s->ref, s->dist, ref_pic->w[0], ref_pic->h[0],
+    err = compute_ms_ssim(&s->engine, ref, dist,
+                          ref_pic->w[0], ref_pic->h[0],
                           s->float_stride, s->float_stride,
                           &score, l_scores, c_scores, s_scores);
     if (err) return err;
@@ -164,8 +193,7 @@ static int extract(VmafFeatureExtractor *fex,
 static int close(VmafFeatureExtractor *fex)
 {
     MsSsimState *s = fex->priv;
-    if (s->ref) aligned_free(s->ref);
-    if (s->dist) aligned_free(s->dist);
+    _iqa_ssim_engine_close(&s->engine);
     return 0;
 }
 
@@ -178,8 +206,8 @@ VmafFeatureExtractor vmaf_fex_float_ms_ssim = {
     .name = "float_ms_ssim",
     .init = init,
     .extract = extract,
-    .options = options,
     .close = close,
+    .options = options,
     .priv_size = sizeof(MsSsimState),
     .provided_features = provided_features,
 };
@@ -23,14 +23,20 @@
 #include "feature_name.h"
 #include "integer_adm.h"
 #include "log.h"
+#include "picture_cache.h"
 
 #if ARCH_X86
 #include "x86/adm_avx2.h"
+#if HAVE_AVX512
+#include "x86/adm_avx512.h"
+#endif
 #elif ARCH_AARCH64
 #include "arm64/adm_neon.h"
 #include <arm_neon.h>
 #endif
 
+int32_t div_lookup[65537];
+
 typedef struct AdmState {
     size_t integer_stride;
     AdmBuffer buf;
@@ -38,12 +44,84 @@ typedef struct AdmState {
     double adm_enhn_gain_limit;
     double adm_norm_view_dist;
     int adm_ref_display_height;
-    void (*dwt2_8)(const uint8_t *src, const adm_dwt_band_t *dst,
-                   AdmBuffer *buf, int w, int h, int src_stride,
-                   int dst_stride);
+    void (*dwt2_8_vert)(const uint8_t *src, int **ind_y, int i, int w,
+                        int src_stride, int16_t *tmplo, int16_t *tmphi);
+    void (*dwt2_16_vert)(const uint16_t *src, int **ind_y, int i, int w,
+                         int src_stride, int inp_size_bits, int16_t *tmplo,
+                         int16_t *tmphi);
+    void (*dwt2_16_hori)(const int16_t *tmplo, const int16_t *tmphi,
+                         int **ind_x, int w, const adm_dwt_band_t *dst,
+                         size_t offset);
+    void (*dwt2_s123_vert)(const int32_t *src, int **ind_y, int i, int w,
+                           int src_stride, int32_t add, int16_t shift,
+                           int32_t *tmplo, int32_t *tmphi);
+    void (*dwt2_s123_hori)(const int32_t *tmplo, const int32_t *tmphi,
+                           int **ind_x, int w, const i4_adm_dwt_band_t *dst,
+                           size_t offset, int32_t add, int16_t shift);
+    void (*decouple_row)(const adm_dwt_band_t *ref, const adm_dwt_band_t *dis,
+                         const adm_dwt_band_t *r, const adm_dwt_band_t *a,
+                         size_t offset, int n, float cos_1deg_sq,
+                         double adm_enhn_gain_limit);
+    void (*i4_decouple_row)(const i4_adm_dwt_band_t *ref,
+                            const i4_adm_dwt_band_t *dis,
+                            const i4_adm_dwt_band_t *r,
+                            const i4_adm_dwt_band_t *a, size_t offset, int n,
+                            float cos_1deg_sq, double adm_enhn_gain_limit);
+    void (*csf_row)(const int16_t *src, int16_t *dst, int16_t *flt, int n,
+                    uint16_t i_rfactor, uint8_t i_shift, uint16_t i_shiftsadd);
+    void (*i4_csf_row)(const int32_t *src, int32_t *dst, int32_t *flt, int n,
+                       uint32_t i_rfactor, int32_t add_bef_shift_dst,
+                       uint32_t shift_dst, int32_t add_bef_shift_flt,
+                       uint32_t shift_flt);
+    uint64_t (*csf_den_row)(const int16_t *src, int n);
+    uint64_t (*csf_den_s123_row)(const int32_t *src, int n,
+                                 uint32_t add_shift_sq, uint32_t shift_sq,
+                                 uint32_t add_shift_cub, uint32_t shift_cub);
+    void (*cm_row)(const adm_dwt_band_t *src, const adm_dwt_band_t *csf_a,
+                   const adm_dwt_band_t *csf_f, int src_stride,
+                   int csf_a_stride, int i, int j_begin, int j_end,
+                   const uint16_t *i_rfactor, const uint32_t *add_shift_cub,
+                   const uint32_t *shift_cub, int64_t *accum);
+    void (*i4_cm_row)(const i4_adm_dwt_band_t *src,
+                      const i4_adm_dwt_band_t *csf_a,
+                      const i4_adm_dwt_band_t *csf_f, int src_stride,
+                      int csf_a_stride, int i, int j_begin, int j_end,
+                      const uint32_t *rfactor, int32_t add_bef_shift_dst,
+                      uint32_t shift_dst, int32_t add_bef_shift_flt,
+                      uint32_t shift_flt, uint32_t add_shift_cub,
+                      uint32_t shift_cub, int64_t *accum);
+    unsigned band_cnt;
+    int strip_rows;
+    int h;
+    AdmBuffer *band_buf;
+    int32_t *i4_ref_a[2], *i4_dis_a[2];
+    uint64_t (*band_den)[3];
+    int64_t (*band_num)[3];
     VmafDictionary *feature_name_dict;
+    VmafFeatureCollector *feature_collector;
+    unsigned feature_id[16];
 } AdmState;
 
+static const char *adm_feature_name[] = {
+    "VMAF_integer_feature_adm2_score",
+    "integer_adm_scale0",
+    "integer_adm_scale1",
+    "integer_adm_scale2",
+    "integer_adm_scale3",
+    /* debug */
+    "integer_adm",
+    "integer_adm_num",
+    "integer_adm_den",
+    "integer_adm_num_scale0",
+    "integer_adm_den_scale0",
+    "integer_adm_num_scale1",
+    "integer_adm_den_scale1",
+    "integer_adm_num_scale2",
+    "integer_adm_den_scale2",
+    "integer_adm_num_scale3",
+    "integer_adm_den_scale3",
+};
+
 static const VmafOption options[] = {
     {
         .name = "debug",
@@ -654,10 +732,21 @@ static void dwt2_src_indices_filt(int **src_ind_y, int **src_ind_x, int w, int h
     }
 }
 
-#define MIN(x, y) (((x) < (y)) ? (x) : (y))
-#define MAX(x, y) (((x) > (y)) ? (x) : (y))
+static void adm_decouple_row(const adm_dwt_band_t *ref,
+                             const adm_dwt_band_t *dis,
+                             const adm_dwt_band_t *r, const adm_dwt_band_t *a,
+                             size_t offset, int n, float cos_1deg_sq,
+                             double adm_enhn_gain_limit)
+{
+    for (int j = 0; j < n; ++j) {
+        adm_decouple_pixel(ref, dis, r, a, offset + j, cos_1deg_sq,
+                           adm_enhn_gain_limit);
+    }
+}
 
-static void adm_decouple(AdmBuffer *buf, int w, int h, int stride,
+static void adm_decouple(const AdmState *s, AdmBuffer *buf, int w, int h,
+                         int stride, int buf_row,
+                         int row_begin, int row_end,
                          double adm_enhn_gain_limit)
 {
     const float cos_1deg_sq = cos(1.0 * M_PI / 180.0) * cos(1.0 * M_PI / 180.0);
@@ -684,109 +773,32 @@ static void adm_decouple(AdmBuffer *buf, int w, int h, int stride,
     if (bottom > h) {
         bottom = h;
     }
-
-    int64_t ot_dp, o_mag_sq, t_mag_sq;
+    top = MAX(top, row_begin);
+    bottom = MIN(bottom, row_end);
 
     for (int i = top; i < bottom; ++i) {
-        for (int j = left; j < right; ++j) {
-            int16_t oh = ref->band_h[i * stride + j];
-            int16_t ov = ref->band_v[i * stride + j];
-            int16_t od = ref->band_d[i * stride + j];
-            int16_t th = dis->band_h[i * stride + j];
-            int16_t tv = dis->band_v[i * stride + j];
-            int16_t td = dis->band_d[i * stride + j];
-            int16_t rst_h, rst_v, rst_d;
-
-            /* Determine if angle between (oh,ov) and (th,tv) is less than 1 degree.
-             * Given that u is the angle (oh,ov) and v is the angle (th,tv), this can
-             * be done by testing the inequvality.
-             *
-             * { (u.v.) >= 0 } AND { (u.v)^2 >= cos(1deg)^2 * ||u||^2 * ||v||^2 }
-             *
-             * Proof:
-             *
-             * cos(theta) = (u.v) / (||u|| * ||v||)
-             *
-             * IF u.v >= 0 THEN
-             *   cos(theta)^2 = (u.v)^2 / (||u||^2 * ||v||^2)
-             *   (u.v)^2 = cos(theta)^2 * ||u||^2 * ||v||^2
-             *
-             *   IF |theta| < 1deg THEN
-             *     (u.v)^2 >= cos(1deg)^2 * ||u||^2 * ||v||^2
-             *   END
-             * ELSE
-             *   |theta| > 90deg
-             * END
-             */
-            ot_dp = (int64_t)oh * th + (int64_t)ov * tv;
-            o_mag_sq = (int64_t)oh * oh + (int64_t)ov * ov;
-            t_mag_sq = (int64_t)th * th + (int64_t)tv * tv;
-
-            /**
-             * angle_flag is calculated in floating-point by converting fixed-point variables back to
-             * floating-point
-             */
-            int angle_flag = (((float)ot_dp / 4096.0) >= 0.0f) &&
-                (((float)ot_dp / 4096.0) * ((float)ot_dp / 4096.0) >=
-                    cos_1deg_sq * ((float)o_mag_sq / 4096.0) * ((float)t_mag_sq / 4096.0));
-
-            /**
-             * Division th/oh is carried using lookup table and converted to multiplication
-             */
-
-            int32_t tmp_kh = (oh == 0) ?
-                32768 : (((int64_t)div_lookup[oh + 32768] * th) + 16384) >> 15;
-            int32_t tmp_kv = (ov == 0) ?
-                32768 : (((int64_t)div_lookup[ov + 32768] * tv) + 16384) >> 15;
-            int32_t tmp_kd = (od == 0) ?
-                32768 : (((int64_t)div_lookup[od + 32768] * td) + 16384) >> 15;
-
-            int32_t kh = tmp_kh < 0 ? 0 : (tmp_kh > 32768 ? 32768 : tmp_kh);
-            int32_t kv = tmp_kv < 0 ? 0 : (tmp_kv > 32768 ? 32768 : tmp_kv);
-            int32_t kd = tmp_kd < 0 ? 0 : (tmp_kd > 32768 ? 32768 : tmp_kd);
-
-            /**
-             * kh,kv,kd are in Q15 type and oh,ov,od are in Q16 type hence shifted by
-             * 15 to make result Q16
-             */
-            rst_h = ((kh * oh) + 16384) >> 15;
-            rst_v = ((kv * ov) + 16384) >> 15;
-            rst_d = ((kd * od) + 16384) >> 15;
-
-            const float rst_h_f = ((float)kh / 32768) * ((float)oh / 64);
-            const float rst_v_f = ((float)kv / 32768) * ((float)ov / 64);
-            const float rst_d_f = ((float)kd / 32768) * ((float)od / 64);
-
-            if (angle_flag && (rst_h_f > 0.)) rst_h = MIN((rst_h * adm_enhn_gain_limit), th);
-            if (angle_flag && (rst_h_f < 0.)) rst_h = MAX((rst_h * adm_enhn_gain_limit), th);
-
-            if (angle_flag && (rst_v_f > 0.)) rst_v = MIN(rst_v * adm_enhn_gain_limit, tv);
-            if (angle_flag && (rst_v_f < 0.)) rst_v = MAX(rst_v * adm_enhn_gain_limit, tv);
-
-            if (angle_flag && (rst_d_f > 0.)) rst_d = MIN(rst_d * adm_enhn_gain_limit, td);
-            if (angle_flag && (rst_d_f < 0.)) rst_d = MAX(rst_d * adm_enhn_gain_limit, td);
-
-            r->band_h[i * stride + j] = rst_h;
-            r->band_v[i * stride + j] = rst_v;
-            r->band_d[i * stride + j] = rst_d;
-
-            a->band_h[i * stride + j] = th - rst_h;
-            a->band_v[i * stride + j] = tv - rst_v;
-            a->band_d[i * stride + j] = td - rst_d;
-        }
+        s->decouple_row(ref, dis, r, a, (i - buf_row) * stride + left,
+                        right - left,
+                        cos_1deg_sq, adm_enhn_gain_limit);
     }
 }
 
-static inline uint16_t get_best15_from32(uint32_t temp, int *x)
+static void i4_adm_decouple_row(const i4_adm_dwt_band_t *ref,
+                                const i4_adm_dwt_band_t *dis,
+                                const i4_adm_dwt_band_t *r,
+                                const i4_adm_dwt_band_t *a, size_t offset,
+                                int n, float cos_1deg_sq,
+                                double adm_enhn_gain_limit)
 {
-    int k = __builtin_clz(temp);    //built in for intel
-    k = 17 - k;
-    temp = (temp + (1 << (k - 1))) >> k;
-    *x = k;
-    return temp;
+    for (int j = 0; j < n; ++j) {
+        i4_adm_decouple_pixel(ref, dis, r, a, offset + j, cos_1deg_sq,
+                              adm_enhn_gain_limit);
+    }
 }
 
-static void adm_decouple_s123(AdmBuffer *buf, int w, int h, int stride,
+static void adm_decouple_s123(const AdmState *s, AdmBuffer *buf, int w, int h,
+                              int stride, int buf_row,
+                              int row_begin, int row_end,
                               double adm_enhn_gain_limit)
 {
     const float cos_1deg_sq = cos(1.0 * M_PI / 180.0) * cos(1.0 * M_PI / 180.0);
@@ -814,122 +826,27 @@ static void adm_decouple_s123(AdmBuffer *buf, int w, int h, int stride,
     if (bottom > h) {
         bottom = h;
     }
-
-    int64_t ot_dp, o_mag_sq, t_mag_sq;
+    top = MAX(top, row_begin);
+    bottom = MIN(bottom, row_end);
 
     for (int i = top; i < bottom; ++i)
     {
-        for (int j = left; j < right; ++j)
-        {
-            int32_t oh = ref->band_h[i * stride + j];
-            int32_t ov = ref->band_v[i * stride + j];
-            int32_t od = ref->band_d[i * stride + j];
-            int32_t th = dis->band_h[i * stride + j];
-            int32_t tv = dis->band_v[i * stride + j];
-            int32_t td = dis->band_d[i * stride + j];
-            int32_t rst_h, rst_v, rst_d;
-
-            /* Determine if angle between (oh,ov) and (th,tv) is less than 1 degree.
-             * Given that u is the angle (oh,ov) and v is the angle (th,tv), this can
-             * be done by testing the inequvality.
-             *
-             * { (u.v.) >= 0 } AND { (u.v)^2 >= cos(1deg)^2 * ||u||^2 * ||v||^2 }
-             *
-             * Proof:
-             *
-             * cos(theta) = (u.v) / (||u|| * ||v||)
-             *
-             * IF u.v >= 0 THEN
-             *   cos(theta)^2 = (u.v)^2 / (||u||^2 * ||v||^2)
-             *   (u.v)^2 = cos(theta)^2 * ||u||^2 * ||v||^2
-             *
-             *   IF |theta| < 1deg THEN
-             *     (u.v)^2 >= cos(1deg)^2 * ||u||^2 * ||v||^2
-             *   END
-             * ELSE
-             *   |theta| > 90deg
-             * END
-             */
-            ot_dp = (int64_t)oh * th + (int64_t)ov * tv;
-            o_mag_sq = (int64_t)oh * oh + (int64_t)ov * ov;
-            t_mag_sq = (int64_t)th * th + (int64_t)tv * tv;
-
-            int angle_flag = (((float)ot_dp / 4096.0) >= 0.0f) &&
-                (((float)ot_dp / 4096.0) * ((float)ot_dp / 4096.0) >=
-                    cos_1deg_sq * ((float)o_mag_sq / 4096.0) * ((float)t_mag_sq / 4096.0));
-
-            /**
-             * Division th/oh is carried using lookup table and converted to multiplication
-             * int64 / int32 is converted to multiplication using following method
-             * num /den :
-             * DenAbs = Abs(den)
-             * MSBDen = MSB(DenAbs)     (gives position of first 1 bit form msb side)
-             * If (DenAbs < (1 << 15))
-             *      Round = (1<<14)
-             *      Score = (num *  div_lookup[den] + Round ) >> 15
-             * else
-             *      RoundD  = (1<< (16 - MSBDen))
-             *      Round   = (1<< (14 + (17 - MSBDen))
-             *      Score   = (num * div_lookup[(DenAbs + RoundD )>>(17 - MSBDen)]*sign(Denominator) + Round)
-             *                  >> ((15 + (17 - MSBDen))
-             */
-
-            int32_t kh_shift = 0;
-            int32_t kv_shift = 0;
-            int32_t kd_shift = 0;
-
-            uint32_t abs_oh = abs(oh);
-            uint32_t abs_ov = abs(ov);
-            uint32_t abs_od = abs(od);
-
-            int8_t kh_sign = (oh < 0 ? -1 : 1);
-            int8_t kv_sign = (ov < 0 ? -1 : 1);
-            int8_t kd_sign = (od < 0 ? -1 : 1);
-
-            uint16_t kh_msb = (abs_oh < (32768) ? abs_oh : get_best15_from32(abs_oh, &kh_shift));
-            uint16_t kv_msb = (abs_ov < (32768) ? abs_ov : get_best15_from32(abs_ov, &kv_shift));
-            uint16_t kd_msb = (abs_od < (32768) ? abs_od : get_best15_from32(abs_od, &kd_shift));
-
-            int64_t tmp_kh = (oh == 0) ? 32768 : (((int64_t)div_lookup[kh_msb + 32768] * th)*(kh_sign) +
-                (1 << (14 + kh_shift))) >> (15 + kh_shift);
-            int64_t tmp_kv = (ov == 0) ? 32768 : (((int64_t)div_lookup[kv_msb + 32768] * tv)*(kv_sign) +
-                (1 << (14 + kv_shift))) >> (15 + kv_shift);
-            int64_t tmp_kd = (od == 0) ? 32768 : (((int64_t)div_lookup[kd_msb + 32768] * td)*(kd_sign) +
-                (1 << (14 + kd_shift))) >> (15 + kd_shift);
-
-            int64_t kh = tmp_kh < 0 ? 0 : (tmp_kh > 32768 ? 32768 : tmp_kh);
-            int64_t kv = tmp_kv < 0 ? 0 : (tmp_kv > 32768 ? 32768 : tmp_kv);
-            int64_t kd = tmp_kd < 0 ? 0 : (tmp_kd > 32768 ? 32768 : tmp_kd);
-
-            rst_h = ((kh * oh) + 16384) >> 15;
-            rst_v = ((kv * ov) + 16384) >> 15;
-            rst_d = ((kd * od) + 16384) >> 15;
-
-            const float rst_h_f = ((float)kh / 32768) * ((float)oh / 64);
-            const float rst_v_f = ((float)kv / 32768) * ((float)ov / 64);
-            const float rst_d_f = ((float)kd / 32768) * ((float)od / 64);
-
-            if (angle_flag && (rst_h_f > 0.)) rst_h = MIN((rst_h * adm_enhn_gain_limit), th);
-            if (angle_flag && (rst_h_f < 0.)) rst_h = MAX((rst_h * adm_enhn_gain_limit), th);
-
-            if (angle_flag && (rst_v_f > 0.)) rst_v = MIN(rst_v * adm_enhn_gain_limit, tv);
-            if (angle_flag && (rst_v_f < 0.)) rst_v = MAX(rst_v * adm_enhn_gain_limit, tv);
-
-            if (angle_flag && (rst_d_f > 0.)) rst_d = MIN(rst_d * adm_enhn_gain_limit, td);
-            if (angle_flag && (rst_d_f < 0.)) rst_d = MAX(rst_d * adm_enhn_gain_limit, td);
-
-            r->band_h[i * stride + j] = rst_h;
-            r->band_v[i * stride + j] = rst_v;
-            r->band_d[i * stride + j] = rst_d;
-
-            a->band_h[i * stride + j] = th - rst_h;
-            a->band_v[i * stride + j] = tv - rst_v;
-            a->band_d[i * stride + j] = td - rst_d;
-        }
+        s->i4_decouple_row(ref, dis, r, a, (i - buf_row) * stride + left,
+                           right - left, cos_1deg_sq, adm_enhn_gain_limit);
     }
 }
 
-static void adm_csf(AdmBuffer *buf, int w, int h, int stride,
+static void adm_csf_row(const int16_t *src, int16_t *dst, int16_t *flt, int n,
+                        uint16_t i_rfactor, uint8_t i_shift,
+                        uint16_t i_shiftsadd)
+{
+    for (int j = 0; j < n; ++j)
+        adm_csf_px(src[j], i_rfactor, i_shift, i_shiftsadd, &dst[j], &flt[j]);
+}
+
+static void adm_csf(const AdmState *s, AdmBuffer *buf, int w, int h,
+                    int stride, int buf_row,
+                    int row_begin, int row_end,
                     double adm_norm_view_dist, int adm_ref_display_height)
 {
     const adm_dwt_band_t *src = &buf->decouple_a;
@@ -979,7 +896,6 @@ static void adm_csf(AdmBuffer *buf, int w, int h, int stride,
      */
     uint8_t i_shifts[3] = { 15,15,17 };
     uint16_t i_shiftsadd[3] = { 16384, 16384, 65535 };
-    uint16_t FIX_ONE_BY_30 = 4369; //(1/30)*2^17
     /* The computation of the csf values is not required for the regions which
      *lie outside the frame borders
      */
@@ -1000,6 +916,8 @@ static void adm_csf(AdmBuffer *buf, int w, int h, int stride,
     if (bottom > h) {
         bottom = h;
     }
+    top = MAX(top, row_begin);
+    bottom = MIN(bottom, row_end);
 
     for (int theta = 0; theta < 3; ++theta) {
         const int16_t *src_ptr = src_angles[theta];
@@ -1007,21 +925,30 @@ static void adm_csf(AdmBuffer *buf, int w, int h, int stride,
         int16_t *flt_ptr = flt_angles[theta];
 
         for (int i = top; i < bottom; ++i) {
-            int src_offset = i * stride;
-            int dst_offset = i * stride;
-
-            for (int j = left; j < right; ++j) {
-                int32_t dst_val = i_rfactor[theta] * (int32_t)src_ptr[src_offset + j];
-                int16_t i16_dst_val = ((int16_t)((dst_val + i_shiftsadd[theta]) >> i_shifts[theta]));
-                dst_ptr[dst_offset + j] = i16_dst_val;
-                flt_ptr[dst_offset + j] = ((int16_t)(((FIX_ONE_BY_30 * abs((int32_t)i16_dst_val))
-                    + 2048) >> 12));
-            }
+            int src_offset = (i - buf_row) * stride;
+            int dst_offset = (i - buf_row) * stride;
+
+            s->csf_row(src_ptr + src_offset + left, dst_ptr + dst_offset + left,
+                       flt_ptr + dst_offset + left, right - left,
+                       i_rfactor[theta], i_shifts[theta], i_shiftsadd[theta]);
         }
     }
 }
 
-static void i4_adm_csf(AdmBuffer *buf, int scale, int w, int h, int stride,
+static void i4_adm_csf_row(const int32_t *src, int32_t *dst, int32_t *flt,
+                           int n, uint32_t i_rfactor,
+                           int32_t add_bef_shift_dst, uint32_t shift_dst,
+                           int32_t add_bef_shift_flt, uint32_t shift_flt)
+{
+    for (int j = 0; j < n; ++j) {
+        i4_adm_csf_px(src[j], i_rfactor, add_bef_shift_dst, shift_dst,
+                      add_bef_shift_flt, shift_flt, &dst[j], &flt[j]);
+    }
+}
+
+static void i4_adm_csf(const AdmState *s, AdmBuffer *buf, int scale, int w,
+                       int h, int stride, int buf_row,
+                       int row_begin, int row_end,
                        double adm_norm_view_dist, int adm_ref_display_height)
 {
     const i4_adm_dwt_band_t *src = &buf->i4_decouple_a;
@@ -1044,7 +971,6 @@ static void i4_adm_csf(AdmBuffer *buf, int scale, int w, int h, int stride,
                                     (uint32_t)(rfactor1[1] * pow2_32),
                                     (uint32_t)(rfactor1[2] * pow2_32) };
 
-    const uint32_t FIX_ONE_BY_30 = 143165577;
     const uint32_t shift_dst[3] = { 28, 28, 28 };
     const uint32_t shift_flt[3] = { 32, 32, 32 };
     int32_t add_bef_shift_dst[3], add_bef_shift_flt[3];
@@ -1074,6 +1000,8 @@ static void i4_adm_csf(AdmBuffer *buf, int scale, int w, int h, int stride,
     if (bottom > h) {
         bottom = h;
     }
+    top = MAX(top, row_begin);
+    bottom = MIN(bottom, row_end);
 
     for (int theta = 0; theta < 3; ++theta)
     {
@@ -1083,31 +1011,31 @@ static void i4_adm_csf(AdmBuffer *buf, int scale, int w, int h, int stride,
 
         for (int i = top; i < bottom; ++i)
         {
-            int src_offset = i * stride;
-            int dst_offset = i * stride;
-
-            for (int j = left; j < right; ++j)
-            {
-                int32_t dst_val = (int32_t)(((i_rfactor[theta] * (int64_t)src_ptr[src_offset + j]) +
-                    add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-                dst_ptr[dst_offset + j] = dst_val;
-                flt_ptr[dst_offset + j] = (int32_t)((((int64_t)FIX_ONE_BY_30 * abs(dst_val)) +
-                    add_bef_shift_flt[scale - 1]) >> shift_flt[scale - 1]);
-            }
+            int src_offset = (i - buf_row) * stride;
+            int dst_offset = (i - buf_row) * stride;
+
+            s->i4_csf_row(src_ptr + src_offset + left,
+                          dst_ptr + dst_offset + left,
+                          flt_ptr + dst_offset + left, right - left,
+                          i_rfactor[theta], add_bef_shift_dst[scale - 1],
+                          shift_dst[scale - 1], add_bef_shift_flt[scale - 1],
+                          shift_flt[scale - 1]);
         }
     }
 }
 
-static float adm_csf_den_scale(const adm_dwt_band_t *src, int w, int h,
-                               int src_stride,
-                               double adm_norm_view_dist, int adm_ref_display_height)
+static uint64_t adm_csf_den_row(const int16_t *src, int n)
 {
-    // for ADM: scales goes from 0 to 3 but in noise floor paper, it goes from
-    // 1 to 4 (from finest scale to coarsest scale).
-    const float factor1 = dwt_quant_step(&dwt_7_9_YCbCr_threshold[0], 0, 1, adm_norm_view_dist, adm_ref_display_height);
-    const float factor2 = dwt_quant_step(&dwt_7_9_YCbCr_threshold[0], 0, 2, adm_norm_view_dist, adm_ref_display_height);
-    const float rfactor[3] = { 1.0f / factor1, 1.0f / factor1, 1.0f / factor2 };
+    uint64_t accum = 0;
+    for (int j = 0; j < n; ++j)
+        accum += adm_csf_den_px(src[j]);
+    return accum;
+}
 
+static void adm_csf_den_scale(const AdmState *s, const adm_dwt_band_t *src,
+                              int w, int h, int src_stride, int buf_row,
+                              int row_begin, int row_end, uint64_t *accum)
+{
     uint64_t accum_h = 0, accum_v = 0, accum_d = 0;
 
     /* The computation of the denominator scales is not required for the regions
@@ -1117,6 +1045,8 @@ static float adm_csf_den_scale(const adm_dwt_band_t *src, int w, int h,
     const int top = h * ADM_BORDER_FACTOR - 0.5;
     const int right = w - left;
     const int bottom = h - top;
+    const int band_top = MAX(top, row_begin);
+    const int band_bottom = MIN(bottom, row_end);
 
     int32_t shift_accum = (int32_t)ceil(log2((bottom - top)*(right - left)) - 20);
     shift_accum = shift_accum > 0 ? shift_accum : 0;
@@ -1128,25 +1058,13 @@ static float adm_csf_den_scale(const adm_dwt_band_t *src, int w, int h,
      * Because d+ = (a[i]^3)*(r^3)
      * is equivalent to d+=a[i]^3 and d=d*(r^3)
      */
-    int16_t *src_h = src->band_h + top * src_stride;
-    int16_t *src_v = src->band_v + top * src_stride;
-    int16_t *src_d = src->band_d + top * src_stride;
-    for (int i = top; i < bottom; ++i) {
-        uint64_t accum_inner_h = 0;
-        uint64_t accum_inner_v = 0;
-        uint64_t accum_inner_d = 0;
-        for (int j = left; j < right; ++j) {
-            uint16_t h = (uint16_t)abs(src_h[j]);
-            uint16_t v = (uint16_t)abs(src_v[j]);
-            uint16_t d = (uint16_t)abs(src_d[j]);
-
-            uint64_t val = ((uint64_t)h * h) * h;
-            accum_inner_h += val;
-            val = ((uint64_t)v * v) * v;
-            accum_inner_v += val;
-            val = ((uint64_t)d * d) * d;
-            accum_inner_d += val;
-        }
+    int16_t *src_h = src->band_h + (band_top - buf_row) * src_stride;
+    int16_t *src_v = src->band_v + (band_top - buf_row) * src_stride;
+    int16_t *src_d = src->band_d + (band_top - buf_row) * src_stride;
+    for (int i = band_top; i < band_bottom; ++i) {
+        uint64_t accum_inner_h = s->csf_den_row(src_h + left, right - left);
+        uint64_t accum_inner_v = s->csf_den_row(src_v + left, right - left);
+        uint64_t accum_inner_d = s->csf_den_row(src_d + left, right - left);
         /**
          * max_value of h^3, v^3, d^3 is 1.205624776 * —10^13
          * accum_h can hold till 1.844674407 * —10^19
@@ -1160,6 +1078,30 @@ static float adm_csf_den_scale(const adm_dwt_band_t *src, int w, int h,
         src_v += src_stride;
         src_d += src_stride;
     }
+
+    accum[0] += accum_h;
+    accum[1] += accum_v;
+    accum[2] += accum_d;
+}
+
+static float adm_csf_den_scale_score(const uint64_t *accum, int w, int h,
+                                     double adm_norm_view_dist,
+                                     int adm_ref_display_height)
+{
+    // for ADM: scales goes from 0 to 3 but in noise floor paper, it goes from
+    // 1 to 4 (from finest scale to coarsest scale).
+    const float factor1 = dwt_quant_step(&dwt_7_9_YCbCr_threshold[0], 0, 1, adm_norm_view_dist, adm_ref_display_height);
+    const float factor2 = dwt_quant_step(&dwt_7_9_YCbCr_threshold[0], 0, 2, adm_norm_view_dist, adm_ref_display_height);
+    const float rfactor[3] = { 1.0f / factor1, 1.0f / factor1, 1.0f / factor2 };
+
+    const int left = w * ADM_BORDER_FACTOR - 0.5;
+    const int top = h * ADM_BORDER_FACTOR - 0.5;
+    const int right = w - left;
+    const int bottom = h - top;
+
+    int32_t shift_accum = (int32_t)ceil(log2((bottom - top)*(right - left)) - 20);
+    shift_accum = shift_accum > 0 ? shift_accum : 0;
+
     /**
      * rfactor is multiplied after cubing
      * accum_h,v,d is converted to floating-point for score calculation
@@ -1168,9 +1110,9 @@ static float adm_csf_den_scale(const adm_dwt_band_t *src, int w, int h,
      * Hence final shift is 18-shift_accum
      */
     double shift_csf = pow(2, (18 - shift_accum));
-    double csf_h = (double)(accum_h / shift_csf) * pow(rfactor[0], 3);
-    double csf_v = (double)(accum_v / shift_csf) * pow(rfactor[1], 3);
-    double csf_d = (double)(accum_d / shift_csf) * pow(rfactor[2], 3);
+    double csf_h = (double)(accum[0] / shift_csf) * pow(rfactor[0], 3);
+    double csf_v = (double)(accum[1] / shift_csf) * pow(rfactor[1], 3);
+    double csf_d = (double)(accum[2] / shift_csf) * pow(rfactor[2], 3);
 
     float powf_add = powf((bottom - top) * (right - left) / 32.0f, 1.0f / 3.0f);
     float den_scale_h = powf(csf_h, 1.0f / 3.0f) + powf_add;
@@ -1181,19 +1123,26 @@ static float adm_csf_den_scale(const adm_dwt_band_t *src, int w, int h,
 
 }
 
-static float adm_csf_den_s123(const i4_adm_dwt_band_t *src, int scale, int w, int h,
-                              int src_stride,
-                              double adm_norm_view_dist, int adm_ref_display_height)
+static uint64_t adm_csf_den_s123_row(const int32_t *src, int n,
+                                     uint32_t add_shift_sq, uint32_t shift_sq,
+                                     uint32_t add_shift_cub,
+                                     uint32_t shift_cub)
 {
-    // for ADM: scales goes from 0 to 3 but in noise floor paper, it goes from
-    // 1 to 4 (from finest scale to coarsest scale).
-    float factor1 = dwt_quant_step(&dwt_7_9_YCbCr_threshold[0], scale, 1, adm_norm_view_dist, adm_ref_display_height);
-    float factor2 = dwt_quant_step(&dwt_7_9_YCbCr_threshold[0], scale, 2, adm_norm_view_dist, adm_ref_display_height);
-    const float rfactor[3] = { 1.0f / factor1, 1.0f / factor1, 1.0f / factor2 };
+    uint64_t accum = 0;
+    for (int j = 0; j < n; ++j) {
+        accum += adm_csf_den_s123_px(src[j], add_shift_sq, shift_sq,
+                                     add_shift_cub, shift_cub);
+    }
+    return accum;
+}
 
+static void adm_csf_den_s123(const AdmState *s, const i4_adm_dwt_band_t *src,
+                             int scale, int w, int h, int src_stride,
+                             int buf_row, int row_begin, int row_end,
+                             uint64_t *accum)
+{
     uint64_t accum_h = 0, accum_v = 0, accum_d = 0;
     const uint32_t shift_sq[3] = { 31, 30, 31 };
-    const uint32_t accum_convert_float[3] = { 32, 27, 23 };
     const uint32_t add_shift_sq[3] =
         { 1u << shift_sq[0], 1u << shift_sq[1], 1u << shift_sq[2] };
 
@@ -1204,39 +1153,31 @@ static float adm_csf_den_s123(const i4_adm_dwt_band_t *src, int scale, int w, in
     const int top = h * ADM_BORDER_FACTOR - 0.5;
     const int right = w - left;
     const int bottom = h - top;
+    const int band_top = MAX(top, row_begin);
+    const int band_bottom = MIN(bottom, row_end);
 
     uint32_t shift_cub = (uint32_t)ceil(log2(right - left));
     uint32_t add_shift_cub = (uint32_t)pow(2, (shift_cub - 1));
     uint32_t shift_accum = (uint32_t)ceil(log2(bottom - top));
     uint32_t add_shift_accum = (uint32_t)pow(2, (shift_accum - 1));
 
-    int32_t *src_h = src->band_h + top * src_stride;
-    int32_t *src_v = src->band_v + top * src_stride;
-    int32_t *src_d = src->band_d + top * src_stride;
-    for (int i = top; i < bottom; ++i)
+    int32_t *src_h = src->band_h + (band_top - buf_row) * src_stride;
+    int32_t *src_v = src->band_v + (band_top - buf_row) * src_stride;
+    int32_t *src_d = src->band_d + (band_top - buf_row) * src_stride;
+    for (int i = band_top; i < band_bottom; ++i)
     {
-        uint64_t accum_inner_h = 0;
-        uint64_t accum_inner_v = 0;
-        uint64_t accum_inner_d = 0;
-        for (int j = left; j < right; ++j)
-        {
-            uint32_t h = (uint32_t)abs(src_h[j]);
-            uint32_t v = (uint32_t)abs(src_v[j]);
-            uint32_t d = (uint32_t)abs(src_d[j]);
-
-            uint64_t val = ((((((uint64_t)h * h) + add_shift_sq[scale - 1]) >>
-                shift_sq[scale - 1]) * h) + add_shift_cub) >> shift_cub;
-
-            accum_inner_h += val;
-
-            val = ((((((uint64_t)v * v) + add_shift_sq[scale - 1]) >>
-                shift_sq[scale - 1]) * v) + add_shift_cub) >> shift_cub;
-            accum_inner_v += val;
-
-            val = ((((((uint64_t)d * d) + add_shift_sq[scale - 1]) >>
-                shift_sq[scale - 1]) * d) + add_shift_cub) >> shift_cub;
-            accum_inner_d += val;
-        }
+        uint64_t accum_inner_h =
+            s->csf_den_s123_row(src_h + left, right - left,
+                                add_shift_sq[scale - 1], shift_sq[scale - 1],
+                                add_shift_cub, shift_cub);
+        uint64_t accum_inner_v =
+            s->csf_den_s123_row(src_v + left, right - left,
+                                add_shift_sq[scale - 1], shift_sq[scale - 1],
+                                add_shift_cub, shift_cub);
+        uint64_t accum_inner_d =
+            s->csf_den_s123_row(src_d + left, right - left,
+                                add_shift_sq[scale - 1], shift_sq[scale - 1],
+                                add_shift_cub, shift_cub);
 
         accum_h += (accum_inner_h + add_shift_accum) >> shift_accum;
         accum_v += (accum_inner_v + add_shift_accum) >> shift_accum;
@@ -1246,14 +1187,40 @@ static float adm_csf_den_s123(const i4_adm_dwt_band_t *src, int scale, int w, in
         src_v += src_stride;
         src_d += src_stride;
     }
+
+    accum[0] += accum_h;
+    accum[1] += accum_v;
+    accum[2] += accum_d;
+}
+
+static float adm_csf_den_s123_score(const uint64_t *accum, int scale, int w,
+                                    int h, double adm_norm_view_dist,
+                                    int adm_ref_display_height)
+{
+    // for ADM: scales goes from 0 to 3 but in noise floor paper, it goes from
+    // 1 to 4 (from finest scale to coarsest scale).
+    float factor1 = dwt_quant_step(&dwt_7_9_YCbCr_threshold[0], scale, 1, adm_norm_view_dist, adm_ref_display_height);
+    float factor2 = dwt_quant_step(&dwt_7_9_YCbCr_threshold[0], scale, 2, adm_norm_view_dist, adm_ref_display_height);
+    const float rfactor[3] = { 1.0f / factor1, 1.0f / factor1, 1.0f / factor2 };
+
+    const uint32_t accum_convert_float[3] = { 32, 27, 23 };
+
+    const int left = w * ADM_BORDER_FACTOR - 0.5;
+    const int top = h * ADM_BORDER_FACTOR - 0.5;
+    const int right = w - left;
+    const int bottom = h - top;
+
+    uint32_t shift_cub = (uint32_t)ceil(log2(right - left));
+    uint32_t shift_accum = (uint32_t)ceil(log2(bottom - top));
+
     /**
      * All the results are converted to floating-point to calculate the scores
      * For all scales the final shift is 3*shifts from dwt - total shifts done here
      */
     double shift_csf = pow(2, (accum_convert_float[scale - 1] - shift_accum - shift_cub));
-    double csf_h = (double)(accum_h / shift_csf) * pow(rfactor[0], 3);
-    double csf_v = (double)(accum_v / shift_csf) * pow(rfactor[1], 3);
-    double csf_d = (double)(accum_d / shift_csf) * pow(rfactor[2], 3);
+    double csf_h = (double)(accum[0] / shift_csf) * pow(rfactor[0], 3);
+    double csf_v = (double)(accum[1] / shift_csf) * pow(rfactor[1], 3);
+    double csf_d = (double)(accum[2] / shift_csf) * pow(rfactor[2], 3);
 
     float powf_add = powf((bottom - top) * (right - left) / 32.0f, 1.0f / 3.0f);
     float den_scale_h = powf(csf_h, 1.0f / 3.0f) + powf_add;
@@ -1263,8 +1230,54 @@ static float adm_csf_den_s123(const i4_adm_dwt_band_t *src, int scale, int w, in
     return (den_scale_h + den_scale_v + den_scale_d);
 }
 
-static float adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stride,
-                    double adm_norm_view_dist, int adm_ref_display_height)
+void adm_cm_row(const adm_dwt_band_t *src, const adm_dwt_band_t *csf_a,
+                const adm_dwt_band_t *csf_f, int src_stride, int csf_a_stride,
+                int i, int j_begin, int j_end, const uint16_t *i_rfactor,
+                const uint32_t *add_shift_cub, const uint32_t *shift_cub,
+                int64_t *accum)
+{
+    const int32_t shift_xhsq = 29;
+    const int32_t shift_xvsq = 29;
+    const int32_t shift_xdsq = 30;
+    const int32_t add_shift_xhsq = 268435456;
+    const int32_t add_shift_xvsq = 268435456;
+    const int32_t add_shift_xdsq = 536870912;
+
+    const int32_t shift_xhsub = 10;
+    const int32_t shift_xvsub = 10;
+    const int32_t shift_xdsub = 12;
+
+    int16_t *angles[3] = { csf_a->band_h, csf_a->band_v, csf_a->band_d };
+    int16_t *flt_angles[3] = { csf_f->band_h, csf_f->band_v, csf_f->band_d };
+
+    int64_t val;
+    int32_t xh, xv, xd, thr;
+    int32_t xh_sq, xv_sq, xd_sq;
+    int64_t accum_inner_h = 0, accum_inner_v = 0, accum_inner_d = 0;
+
+    for (int j = j_begin; j < j_end; ++j) {
+        xh = src->band_h[i * src_stride + j] * i_rfactor[0];
+        xv = src->band_v[i * src_stride + j] * i_rfactor[1];
+        xd = src->band_d[i * src_stride + j] * i_rfactor[2];
+        ADM_CM_THRESH_S_I_J(angles, flt_angles, csf_a_stride, &thr, 0, 0, i, j);
+
+        ADM_CM_ACCUM_ROUND(xh, thr, shift_xhsub, xh_sq, add_shift_xhsq, shift_xhsq, val,
+                           add_shift_cub[0], shift_cub[0], accum_inner_h);
+        ADM_CM_ACCUM_ROUND(xv, thr, shift_xvsub, xv_sq, add_shift_xvsq, shift_xvsq, val,
+                           add_shift_cub[1], shift_cub[1], accum_inner_v);
+        ADM_CM_ACCUM_ROUND(xd, thr, shift_xdsub, xd_sq, add_shift_xdsq, shift_xdsq, val,
+                           add_shift_cub[2], shift_cub[2], accum_inner_d);
+    }
+
+    accum[0] += accum_inner_h;
+    accum[1] += accum_inner_v;
+    accum[2] += accum_inner_d;
+}
+
+static void adm_cm(const AdmState *s, AdmBuffer *buf, int w, int h,
+                   int src_stride, int csf_a_stride, int buf_row, int row_begin,
+                   int row_end, int64_t *accum, double adm_norm_view_dist,
+                   int adm_ref_display_height)
 {
     const adm_dwt_band_t *src   = &buf->decouple_r;
     const adm_dwt_band_t *csf_f = &buf->csf_f;
@@ -1314,6 +1327,10 @@ static float adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stri
     const uint32_t shift_xdcub = (uint32_t)ceil(log2(w) - 3);
     const uint32_t add_shift_xdcub = (uint32_t)pow(2, (shift_xdcub - 1));
 
+    const uint32_t shift_xcub[3] = { shift_xhcub, shift_xvcub, shift_xdcub };
+    const uint32_t add_shift_xcub[3] =
+        { add_shift_xhcub, add_shift_xvcub, add_shift_xdcub };
+
     const uint32_t shift_inner_accum = (uint32_t)ceil(log2(h));
     const uint32_t add_shift_inner_accum = (uint32_t)pow(2, (shift_inner_accum - 1));
 
@@ -1336,6 +1353,10 @@ static float adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stri
     const int end_col = (right < (w - 1)) ? right : (w - 1);
     const int start_row = (top > 1) ? top : 1;
     const int end_row = (bottom < (h - 1)) ? bottom : (h - 1);
+    const int band_start_row = MAX(start_row, row_begin);
+    const int band_end_row = MIN(end_row, row_end);
+    const bool first_row = (top <= 0) && (row_begin == 0);
+    const bool last_row = (bottom > (h - 1)) && (row_end == h);
 
     int i, j;
     int64_t val;
@@ -1345,7 +1366,7 @@ static float adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stri
     int64_t accum_inner_h = 0, accum_inner_v = 0, accum_inner_d = 0;
 
     /* i=0,j=0 */
-    if ((top <= 0) && (left <= 0))
+    if (first_row && (left <= 0))
     {
         xh = (int32_t)src->band_h[0] * i_rfactor[0];
         xv = (int32_t)src->band_v[0] * i_rfactor[1];
@@ -1374,7 +1395,7 @@ static float adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stri
     }
 
     /* i=0, j */
-    if (top <= 0) {
+    if (first_row) {
         for (j = start_col; j < end_col; ++j) {
             xh = src->band_h[j] * i_rfactor[0];
             xv = src->band_v[j] * i_rfactor[1];
@@ -1391,7 +1412,7 @@ static float adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stri
     }
 
     /* i=0,j=w-1 */
-    if ((top <= 0) && (right > (w - 1)))
+    if (first_row && (right > (w - 1)))
     {
         xh = src->band_h[w - 1] * i_rfactor[0];
         xv = src->band_v[w - 1] * i_rfactor[1];
@@ -1412,23 +1433,17 @@ static float adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stri
 
     if ((left > 0) && (right <= (w - 1))) /* Completely within frame */
     {
-        for (i = start_row; i < end_row; ++i) {
+        for (i = band_start_row; i < band_end_row; ++i) {
             accum_inner_h = 0;
             accum_inner_v = 0;
             accum_inner_d = 0;
-            for (j = start_col; j < end_col; ++j) {
-                xh = src->band_h[i * src_stride + j] * i_rfactor[0];
-                xv = src->band_v[i * src_stride + j] * i_rfactor[1];
-                xd = src->band_d[i * src_stride + j] * i_rfactor[2];
-                ADM_CM_THRESH_S_I_J(angles, flt_angles, csf_a_stride, &thr, w, h, i, j);
-
-                ADM_CM_ACCUM_ROUND(xh, thr, shift_xhsub, xh_sq, add_shift_xhsq, shift_xhsq, val,
-                                   add_shift_xhcub, shift_xhcub, accum_inner_h);
-                ADM_CM_ACCUM_ROUND(xv, thr, shift_xvsub, xv_sq, add_shift_xvsq, shift_xvsq, val,
-                                   add_shift_xvcub, shift_xvcub, accum_inner_v);
-                ADM_CM_ACCUM_ROUND(xd, thr, shift_xdsub, xd_sq, add_shift_xdsq, shift_xdsq, val,
-                                   add_shift_xdcub, shift_xdcub, accum_inner_d);
-            }
+            int64_t row_accum[3] = { 0 };
+            s->cm_row(src, csf_a, csf_f, src_stride, csf_a_stride, i - buf_row,
+                      start_col, end_col, i_rfactor, add_shift_xcub,
+                      shift_xcub, row_accum);
+            accum_inner_h += row_accum[0];
+            accum_inner_v += row_accum[1];
+            accum_inner_d += row_accum[2];
             accum_h += (accum_inner_h + add_shift_inner_accum) >> shift_inner_accum;
             accum_v += (accum_inner_v + add_shift_inner_accum) >> shift_inner_accum;
             accum_d += (accum_inner_d + add_shift_inner_accum) >> shift_inner_accum;
@@ -1436,16 +1451,16 @@ static float adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stri
     }
     else if ((left <= 0) && (right <= (w - 1))) /* Right border within frame, left outside */
     {
-        for (i = start_row; i < end_row; ++i) {
+        for (i = band_start_row; i < band_end_row; ++i) {
             accum_inner_h = 0;
             accum_inner_v = 0;
             accum_inner_d = 0;
 
             /* j = 0 */
-            xh = src->band_h[i * src_stride] * i_rfactor[0];
-            xv = src->band_v[i * src_stride] * i_rfactor[1];
-            xd = src->band_d[i * src_stride] * i_rfactor[2];
-            ADM_CM_THRESH_S_I_0(angles, flt_angles, csf_a_stride, &thr, w, h, i, 0);
+            xh = src->band_h[(i - buf_row) * src_stride] * i_rfactor[0];
+            xv = src->band_v[(i - buf_row) * src_stride] * i_rfactor[1];
+            xd = src->band_d[(i - buf_row) * src_stride] * i_rfactor[2];
+            ADM_CM_THRESH_S_I_0(angles, flt_angles, csf_a_stride, &thr, w, h, i - buf_row, 0);
 
             ADM_CM_ACCUM_ROUND(xh, thr, shift_xhsub, xh_sq, add_shift_xhsq, shift_xhsq, val,
                                add_shift_xhcub, shift_xhcub, accum_inner_h);
@@ -1455,19 +1470,13 @@ static float adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stri
                                add_shift_xdcub, shift_xdcub, accum_inner_d);
 
             /* j within frame */
-            for (j = start_col; j < end_col; ++j) {
-                xh = src->band_h[i * src_stride + j] * i_rfactor[0];
-                xv = src->band_v[i * src_stride + j] * i_rfactor[1];
-                xd = src->band_d[i * src_stride + j] * i_rfactor[2];
-                ADM_CM_THRESH_S_I_J(angles, flt_angles, csf_a_stride, &thr, w, h, i, j);
-
-                ADM_CM_ACCUM_ROUND(xh, thr, shift_xhsub, xh_sq, add_shift_xhsq, shift_xhsq, val,
-                                   add_shift_xhcub, shift_xhcub, accum_inner_h);
-                ADM_CM_ACCUM_ROUND(xv, thr, shift_xvsub, xv_sq, add_shift_xvsq, shift_xvsq, val,
-                                   add_shift_xvcub, shift_xvcub, accum_inner_v);
-                ADM_CM_ACCUM_ROUND(xd, thr, shift_xdsub, xd_sq, add_shift_xdsq, shift_xdsq, val,
-                                   add_shift_xdcub, shift_xdcub, accum_inner_d);
-            }
+            int64_t row_accum[3] = { 0 };
+            s->cm_row(src, csf_a, csf_f, src_stride, csf_a_stride, i - buf_row,
+                      start_col, end_col, i_rfactor, add_shift_xcub,
+                      shift_xcub, row_accum);
+            accum_inner_h += row_accum[0];
+            accum_inner_v += row_accum[1];
+            accum_inner_d += row_accum[2];
             accum_h += (accum_inner_h + add_shift_inner_accum) >> shift_inner_accum;
             accum_v += (accum_inner_v + add_shift_inner_accum) >> shift_inner_accum;
             accum_d += (accum_inner_d + add_shift_inner_accum) >> shift_inner_accum;
@@ -1475,29 +1484,23 @@ static float adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stri
     }
     else if ((left > 0) && (right > (w - 1))) /* Left border within frame, right outside */
     {
-        for (i = start_row; i < end_row; ++i) {
+        for (i = band_start_row; i < band_end_row; ++i) {
             accum_inner_h = 0;
             accum_inner_v = 0;
             accum_inner_d = 0;
             /* j within frame */
-            for (j = start_col; j < end_col; ++j) {
-                xh = src->band_h[i * src_stride + j] * i_rfactor[0];
-                xv = src->band_v[i * src_stride + j] * i_rfactor[1];
-                xd = src->band_d[i * src_stride + j] * i_rfactor[2];
-                ADM_CM_THRESH_S_I_J(angles, flt_angles, csf_a_stride, &thr, w, h, i, j);
-
-                ADM_CM_ACCUM_ROUND(xh, thr, shift_xhsub, xh_sq, add_shift_xhsq, shift_xhsq, val,
-                                   add_shift_xhcub, shift_xhcub, accum_inner_h);
-                ADM_CM_ACCUM_ROUND(xv, thr, shift_xvsub, xv_sq, add_shift_xvsq, shift_xvsq, val,
-                                   add_shift_xvcub, shift_xvcub, accum_inner_v);
-                ADM_CM_ACCUM_ROUND(xd, thr, shift_xdsub, xd_sq, add_shift_xdsq, shift_xdsq, val,
-                                   add_shift_xdcub, shift_xdcub, accum_inner_d);
-            }
+            int64_t row_accum[3] = { 0 };
+            s->cm_row(src, csf_a, csf_f, src_stride, csf_a_stride, i - buf_row,
+                      start_col, end_col, i_rfactor, add_shift_xcub,
+                      shift_xcub, row_accum);
+            accum_inner_h += row_accum[0];
+            accum_inner_v += row_accum[1];
+            accum_inner_d += row_accum[2];
             /* j = w-1 */
-            xh = src->band_h[i * src_stride + w - 1] * i_rfactor[0];
-            xv = src->band_v[i * src_stride + w - 1] * i_rfactor[1];
-            xd = src->band_d[i * src_stride + w - 1] * i_rfactor[2];
-            ADM_CM_THRESH_S_I_W_M_1(angles, flt_angles, csf_a_stride, &thr, w, h, i, (w - 1));
+            xh = src->band_h[(i - buf_row) * src_stride + w - 1] * i_rfactor[0];
+            xv = src->band_v[(i - buf_row) * src_stride + w - 1] * i_rfactor[1];
+            xd = src->band_d[(i - buf_row) * src_stride + w - 1] * i_rfactor[2];
+            ADM_CM_THRESH_S_I_W_M_1(angles, flt_angles, csf_a_stride, &thr, w, h, i - buf_row, (w - 1));
 
             ADM_CM_ACCUM_ROUND(xh, thr, shift_xhsub, xh_sq, add_shift_xhsq, shift_xhsq, val,
                                add_shift_xhcub, shift_xhcub, accum_inner_h);
@@ -1514,16 +1517,16 @@ static float adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stri
     }
     else /* Both borders outside frame */
     {
-        for (i = start_row; i < end_row; ++i) {
+        for (i = band_start_row; i < band_end_row; ++i) {
             accum_inner_h = 0;
             accum_inner_v = 0;
             accum_inner_d = 0;
 
             /* j = 0 */
-            xh = src->band_h[i * src_stride] * i_rfactor[0];
-            xv = src->band_v[i * src_stride] * i_rfactor[1];
-            xd = src->band_d[i * src_stride] * i_rfactor[2];
-            ADM_CM_THRESH_S_I_0(angles, flt_angles, csf_a_stride, &thr, w, h, i, 0);
+            xh = src->band_h[(i - buf_row) * src_stride] * i_rfactor[0];
+            xv = src->band_v[(i - buf_row) * src_stride] * i_rfactor[1];
+            xd = src->band_d[(i - buf_row) * src_stride] * i_rfactor[2];
+            ADM_CM_THRESH_S_I_0(angles, flt_angles, csf_a_stride, &thr, w, h, i - buf_row, 0);
 
             ADM_CM_ACCUM_ROUND(xh, thr, shift_xhsub, xh_sq, add_shift_xhsq, shift_xhsq, val,
                                add_shift_xhcub, shift_xhcub, accum_inner_h);
@@ -1533,24 +1536,18 @@ static float adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stri
                                add_shift_xdcub, shift_xdcub, accum_inner_d);
 
             /* j within frame */
-            for (j = start_col; j < end_col; ++j) {
-                xh = src->band_h[i * src_stride + j] * i_rfactor[0];
-                xv = src->band_v[i * src_stride + j] * i_rfactor[1];
-                xd = src->band_d[i * src_stride + j] * i_rfactor[2];
-                ADM_CM_THRESH_S_I_J(angles, flt_angles, csf_a_stride, &thr, w, h, i, j);
-
-                ADM_CM_ACCUM_ROUND(xh, thr, shift_xhsub, xh_sq, add_shift_xhsq, shift_xhsq, val,
-                                   add_shift_xhcub, shift_xhcub, accum_inner_h);
-                ADM_CM_ACCUM_ROUND(xv, thr, shift_xvsub, xv_sq, add_shift_xvsq, shift_xvsq, val,
-                                   add_shift_xvcub, shift_xvcub, accum_inner_v);
-                ADM_CM_ACCUM_ROUND(xd, thr, shift_xdsub, xd_sq, add_shift_xdsq, shift_xdsq, val,
-                                   add_shift_xdcub, shift_xdcub, accum_inner_d);
-            }
+            int64_t row_accum[3] = { 0 };
+            s->cm_row(src, csf_a, csf_f, src_stride, csf_a_stride, i - buf_row,
+                      start_col, end_col, i_rfactor, add_shift_xcub,
+                      shift_xcub, row_accum);
+            accum_inner_h += row_accum[0];
+            accum_inner_v += row_accum[1];
+            accum_inner_d += row_accum[2];
             /* j = w-1 */
-            xh = src->band_h[i * src_stride + w - 1] * i_rfactor[0];
-            xv = src->band_v[i * src_stride + w - 1] * i_rfactor[1];
-            xd = src->band_d[i * src_stride + w - 1] * i_rfactor[2];
-            ADM_CM_THRESH_S_I_W_M_1(angles, flt_angles, csf_a_stride, &thr, w, h, i, (w - 1));
+            xh = src->band_h[(i - buf_row) * src_stride + w - 1] * i_rfactor[0];
+            xv = src->band_v[(i - buf_row) * src_stride + w - 1] * i_rfactor[1];
+            xd = src->band_d[(i - buf_row) * src_stride + w - 1] * i_rfactor[2];
+            ADM_CM_THRESH_S_I_W_M_1(angles, flt_angles, csf_a_stride, &thr, w, h, i - buf_row, (w - 1));
 
             ADM_CM_ACCUM_ROUND(xh, thr, shift_xhsub, xh_sq, add_shift_xhsq, shift_xhsq, val,
                                add_shift_xhcub, shift_xhcub, accum_inner_h);
@@ -1569,12 +1566,12 @@ static float adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stri
     accum_inner_d = 0;
 
     /* i=h-1,j=0 */
-    if ((bottom > (h - 1)) && (left <= 0))
+    if (last_row && (left <= 0))
     {
-        xh = src->band_h[(h - 1) * src_stride] * i_rfactor[0];
-        xv = src->band_v[(h - 1) * src_stride] * i_rfactor[1];
-        xd = src->band_d[(h - 1) * src_stride] * i_rfactor[2];
-        ADM_CM_THRESH_S_H_M_1_0(angles, flt_angles, csf_a_stride, &thr, w, h, (h - 1), 0);
+        xh = src->band_h[(h - 1 - buf_row) * src_stride] * i_rfactor[0];
+        xv = src->band_v[(h - 1 - buf_row) * src_stride] * i_rfactor[1];
+        xd = src->band_d[(h - 1 - buf_row) * src_stride] * i_rfactor[2];
+        ADM_CM_THRESH_S_H_M_1_0(angles, flt_angles, csf_a_stride, &thr, w, h - buf_row, (h - 1 - buf_row), 0);
 
         ADM_CM_ACCUM_ROUND(xh, thr, shift_xhsub, xh_sq, add_shift_xhsq, shift_xhsq, val,
                            add_shift_xhcub, shift_xhcub, accum_inner_h);
@@ -1585,12 +1582,12 @@ static float adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stri
     }
 
     /* i=h-1,j */
-    if (bottom > (h - 1)) {
+    if (last_row) {
         for (j = start_col; j < end_col; ++j) {
-            xh = src->band_h[(h - 1) * src_stride + j] * i_rfactor[0];
-            xv = src->band_v[(h - 1) * src_stride + j] * i_rfactor[1];
-            xd = src->band_d[(h - 1) * src_stride + j] * i_rfactor[2];
-            ADM_CM_THRESH_S_H_M_1_J(angles, flt_angles, csf_a_stride, &thr, w, h, (h - 1), j);
+            xh = src->band_h[(h - 1 - buf_row) * src_stride + j] * i_rfactor[0];
+            xv = src->band_v[(h - 1 - buf_row) * src_stride + j] * i_rfactor[1];
+            xd = src->band_d[(h - 1 - buf_row) * src_stride + j] * i_rfactor[2];
+            ADM_CM_THRESH_S_H_M_1_J(angles, flt_angles, csf_a_stride, &thr, w, h - buf_row, (h - 1 - buf_row), j);
 
             ADM_CM_ACCUM_ROUND(xh, thr, shift_xhsub, xh_sq, add_shift_xhsq, shift_xhsq, val,
                                add_shift_xhcub, shift_xhcub, accum_inner_h);
@@ -1602,13 +1599,13 @@ static float adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stri
     }
 
     /* i-h-1,j=w-1 */
-    if ((bottom > (h - 1)) && (right > (w - 1)))
+    if (last_row && (right > (w - 1)))
     {
-        xh = src->band_h[(h - 1) * src_stride + w - 1] * i_rfactor[0];
-        xv = src->band_v[(h - 1) * src_stride + w - 1] * i_rfactor[1];
-        xd = src->band_d[(h - 1) * src_stride + w - 1] * i_rfactor[2];
-        ADM_CM_THRESH_S_H_M_1_W_M_1(angles, flt_angles, csf_a_stride, &thr, w, h,
-            (h - 1), (w - 1));
+        xh = src->band_h[(h - 1 - buf_row) * src_stride + w - 1] * i_rfactor[0];
+        xv = src->band_v[(h - 1 - buf_row) * src_stride + w - 1] * i_rfactor[1];
+        xd = src->band_d[(h - 1 - buf_row) * src_stride + w - 1] * i_rfactor[2];
+        ADM_CM_THRESH_S_H_M_1_W_M_1(angles, flt_angles, csf_a_stride, &thr, w, h - buf_row,
+            (h - 1 - buf_row), (w - 1));
 
         ADM_CM_ACCUM_ROUND(xh, thr, shift_xhsub, xh_sq, add_shift_xhsq, shift_xhsq, val,
                            add_shift_xhcub, shift_xhcub, accum_inner_h);
@@ -1621,6 +1618,23 @@ static float adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stri
     accum_v += (accum_inner_v + add_shift_inner_accum) >> shift_inner_accum;
     accum_d += (accum_inner_d + add_shift_inner_accum) >> shift_inner_accum;
 
+    accum[0] += accum_h;
+    accum[1] += accum_v;
+    accum[2] += accum_d;
+}
+
+static float adm_cm_score(const int64_t *accum, int w, int h)
+{
+    const uint32_t shift_xhcub = (uint32_t)ceil(log2(w) - 4);
+    const uint32_t shift_xvcub = (uint32_t)ceil(log2(w) - 4);
+    const uint32_t shift_xdcub = (uint32_t)ceil(log2(w) - 3);
+    const uint32_t shift_inner_accum = (uint32_t)ceil(log2(h));
+
+    const int left = w * ADM_BORDER_FACTOR - 0.5;
+    const int top = h * ADM_BORDER_FACTOR - 0.5;
+    const int right = w - left;
+    const int bottom = h - top;
+
     /**
      * For h and v total shifts pending from last stage is 6 rfactor[0,1] has 21 shifts
      * => after cubing (6+21)*3=81 after squaring shifted by 29
@@ -1630,9 +1644,9 @@ static float adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stri
      * => after cubing (6+23)*3=87 after squaring shifted by 30
      * hence pending is 57-shift's done based on width and height
      */
-    float f_accum_h = (float)(accum_h / pow(2, (52 - shift_xhcub - shift_inner_accum)));
-    float f_accum_v = (float)(accum_v / pow(2, (52 - shift_xvcub - shift_inner_accum)));
-    float f_accum_d = (float)(accum_d / pow(2, (57 - shift_xdcub - shift_inner_accum)));
+    float f_accum_h = (float)(accum[0] / pow(2, (52 - shift_xhcub - shift_inner_accum)));
+    float f_accum_v = (float)(accum[1] / pow(2, (52 - shift_xvcub - shift_inner_accum)));
+    float f_accum_d = (float)(accum[2] / pow(2, (57 - shift_xdcub - shift_inner_accum)));
 
     float num_scale_h = powf(f_accum_h, 1.0f / 3.0f) + powf((bottom - top) *
                         (right - left) / 32.0f, 1.0f / 3.0f);
@@ -1644,8 +1658,53 @@ static float adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stri
     return (num_scale_h + num_scale_v + num_scale_d);
 }
 
-static float i4_adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_stride, int scale,
-                       double adm_norm_view_dist, int adm_ref_display_height)
+void i4_adm_cm_row(const i4_adm_dwt_band_t *src,
+                   const i4_adm_dwt_band_t *csf_a,
+                   const i4_adm_dwt_band_t *csf_f, int src_stride,
+                   int csf_a_stride, int i, int j_begin, int j_end,
+                   const uint32_t *rfactor, int32_t add_bef_shift_dst,
+                   uint32_t shift_dst, int32_t add_bef_shift_flt,
+                   uint32_t shift_flt, uint32_t add_shift_cub,
+                   uint32_t shift_cub, int64_t *accum)
+{
+    const int32_t shift_sq = 30;
+    const int32_t add_shift_sq = 536870912; //2^29
+    const int32_t shift_sub = 0;
+    int32_t *angles[3] = { csf_a->band_h, csf_a->band_v, csf_a->band_d };
+    int32_t *flt_angles[3] = { csf_f->band_h, csf_f->band_v, csf_f->band_d };
+
+    int32_t xh, xv, xd, thr;
+    int32_t xh_sq, xv_sq, xd_sq;
+    int64_t val;
+    int64_t accum_inner_h = 0, accum_inner_v = 0, accum_inner_d = 0;
+
+    for (int j = j_begin; j < j_end; ++j) {
+        xh = (int32_t)((((int64_t)src->band_h[i * src_stride + j] * rfactor[0]) +
+            add_bef_shift_dst) >> shift_dst);
+        xv = (int32_t)((((int64_t)src->band_v[i * src_stride + j] * rfactor[1]) +
+            add_bef_shift_dst) >> shift_dst);
+        xd = (int32_t)((((int64_t)src->band_d[i * src_stride + j] * rfactor[2]) +
+            add_bef_shift_dst) >> shift_dst);
+        I4_ADM_CM_THRESH_S_I_J(angles, flt_angles, csf_a_stride, &thr, 0, 0, i, j,
+                               add_bef_shift_flt, shift_flt);
+
+        I4_ADM_CM_ACCUM_ROUND(xh, thr, shift_sub, xh_sq, add_shift_sq, shift_sq, val,
+                              add_shift_cub, shift_cub, accum_inner_h);
+        I4_ADM_CM_ACCUM_ROUND(xv, thr, shift_sub, xv_sq, add_shift_sq, shift_sq, val,
+                              add_shift_cub, shift_cub, accum_inner_v);
+        I4_ADM_CM_ACCUM_ROUND(xd, thr, shift_sub, xd_sq, add_shift_sq, shift_sq, val,
+                              add_shift_cub, shift_cub, accum_inner_d);
+    }
+
+    accum[0] += accum_inner_h;
+    accum[1] += accum_inner_v;
+    accum[2] += accum_inner_d;
+}
+
+static void i4_adm_cm(const AdmState *s, AdmBuffer *buf, int w, int h,
+                      int src_stride, int csf_a_stride, int buf_row, int scale,
+                      int row_begin, int row_end, int64_t *accum,
+                      double adm_norm_view_dist, int adm_ref_display_height)
 {
     const i4_adm_dwt_band_t *src = &buf->i4_decouple_r;
     const i4_adm_dwt_band_t *csf_f = &buf->i4_csf_f;
@@ -1677,10 +1736,6 @@ static float i4_adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_s
     uint32_t shift_inner_accum = (uint32_t)ceil(log2(h));
     uint32_t add_shift_inner_accum = (uint32_t)pow(2, (shift_inner_accum - 1));
 
-    float final_shift[3] = { pow(2,(45 - shift_cub - shift_inner_accum)),
-                             pow(2,(39 - shift_cub - shift_inner_accum)),
-                             pow(2,(36 - shift_cub - shift_inner_accum)) };
-
     const int32_t shift_sq = 30;
     const int32_t add_shift_sq = 536870912; //2^29
     const int32_t shift_sub = 0;
@@ -1699,6 +1754,10 @@ static float i4_adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_s
     const int end_col = (right < (w - 1)) ? right : (w - 1);
     const int start_row = (top > 1) ? top : 1;
     const int end_row = (bottom < (h - 1)) ? bottom : (h - 1);
+    const int band_start_row = MAX(start_row, row_begin);
+    const int band_end_row = MIN(end_row, row_end);
+    const bool first_row = (top <= 0) && (row_begin == 0);
+    const bool last_row = (bottom > (h - 1)) && (row_end == h);
 
     int i, j;
     int32_t xh, xv, xd, thr;
@@ -1707,7 +1766,7 @@ static float i4_adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_s
     int64_t accum_h = 0, accum_v = 0, accum_d = 0;
     int64_t accum_inner_h = 0, accum_inner_v = 0, accum_inner_d = 0;
     /* i=0,j=0 */
-    if ((top <= 0) && (left <= 0))
+    if (first_row && (left <= 0))
     {
         xh = (int32_t)((((int64_t)src->band_h[0] * rfactor[0]) + add_bef_shift_dst[scale - 1])
             >> shift_dst[scale - 1]);
@@ -1727,7 +1786,7 @@ static float i4_adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_s
     }
 
     /* i=0, j */
-    if (top <= 0)
+    if (first_row)
     {
         for (j = start_col; j < end_col; ++j)
         {
@@ -1750,7 +1809,7 @@ static float i4_adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_s
     }
 
     /* i=0,j=w-1 */
-    if ((top <= 0) && (right > (w - 1)))
+    if (first_row && (right > (w - 1)))
     {
         xh = (int32_t)((((int64_t)src->band_h[w - 1] * rfactor[0]) +
             add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
@@ -1775,30 +1834,20 @@ static float i4_adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_s
 
     if ((left > 0) && (right <= (w - 1))) /* Completely within frame */
     {
-        for (i = start_row; i < end_row; ++i)
+        for (i = band_start_row; i < band_end_row; ++i)
         {
             accum_inner_h = 0;
             accum_inner_v = 0;
             accum_inner_d = 0;
-            for (j = start_col; j < end_col; ++j)
-            {
-
-                xh = (int32_t)((((int64_t)src->band_h[i * src_stride + j] * rfactor[0]) +
-                    add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-                xv = (int32_t)((((int64_t)src->band_v[i * src_stride + j] * rfactor[1]) +
-                    add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-                xd = (int32_t)((((int64_t)src->band_d[i * src_stride + j] * rfactor[2]) +
-                    add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-                I4_ADM_CM_THRESH_S_I_J(angles, flt_angles, csf_a_stride, &thr, w, h, i, j,
-                                               add_bef_shift_flt[scale - 1], shift_flt[scale - 1]);
-
-                I4_ADM_CM_ACCUM_ROUND(xh, thr, shift_sub, xh_sq, add_shift_sq, shift_sq, val,
-                                      add_shift_cub, shift_cub, accum_inner_h);
-                I4_ADM_CM_ACCUM_ROUND(xv, thr, shift_sub, xv_sq, add_shift_sq, shift_sq, val,
-                                      add_shift_cub, shift_cub, accum_inner_v);
-                I4_ADM_CM_ACCUM_ROUND(xd, thr, shift_sub, xd_sq, add_shift_sq, shift_sq, val,
-                                      add_shift_cub, shift_cub, accum_inner_d);
-            }
+            int64_t row_accum[3] = { 0 };
+            s->i4_cm_row(src, csf_a, csf_f, src_stride, csf_a_stride, i - buf_row,
+                         start_col, end_col, rfactor,
+                         add_bef_shift_dst[scale - 1], shift_dst[scale - 1],
+                         add_bef_shift_flt[scale - 1], shift_flt[scale - 1],
+                         add_shift_cub, shift_cub, row_accum);
+            accum_inner_h += row_accum[0];
+            accum_inner_v += row_accum[1];
+            accum_inner_d += row_accum[2];
             accum_h += (accum_inner_h + add_shift_inner_accum) >> shift_inner_accum;
             accum_v += (accum_inner_v + add_shift_inner_accum) >> shift_inner_accum;
             accum_d += (accum_inner_d + add_shift_inner_accum) >> shift_inner_accum;
@@ -1806,20 +1855,20 @@ static float i4_adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_s
     }
     else if ((left <= 0) && (right <= (w - 1))) /* Right border within frame, left outside */
     {
-        for (i = start_row; i < end_row; ++i)
+        for (i = band_start_row; i < band_end_row; ++i)
         {
             accum_inner_h = 0;
             accum_inner_v = 0;
             accum_inner_d = 0;
 
             /* j = 0 */
-            xh = (int32_t)((((int64_t)src->band_h[i * src_stride] * rfactor[0]) +
+            xh = (int32_t)((((int64_t)src->band_h[(i - buf_row) * src_stride] * rfactor[0]) +
                 add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-            xv = (int32_t)((((int64_t)src->band_v[i * src_stride] * rfactor[1]) +
+            xv = (int32_t)((((int64_t)src->band_v[(i - buf_row) * src_stride] * rfactor[1]) +
                 add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-            xd = (int32_t)((((int64_t)src->band_d[i * src_stride] * rfactor[2]) +
+            xd = (int32_t)((((int64_t)src->band_d[(i - buf_row) * src_stride] * rfactor[2]) +
                 add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-            I4_ADM_CM_THRESH_S_I_0(angles, flt_angles, csf_a_stride, &thr, w, h, i, 0,
+            I4_ADM_CM_THRESH_S_I_0(angles, flt_angles, csf_a_stride, &thr, w, h, i - buf_row, 0,
                                            add_bef_shift_flt[scale - 1], shift_flt[scale - 1]);
 
             I4_ADM_CM_ACCUM_ROUND(xh, thr, shift_sub, xh_sq, add_shift_sq, shift_sq, val,
@@ -1830,24 +1879,15 @@ static float i4_adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_s
                                   add_shift_cub, shift_cub, accum_inner_d);
 
             /* j within frame */
-            for (j = start_col; j < end_col; ++j)
-            {
-                xh = (int32_t)((((int64_t)src->band_h[i * src_stride + j] * rfactor[0]) +
-                    add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-                xv = (int32_t)((((int64_t)src->band_v[i * src_stride + j] * rfactor[1]) +
-                    add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-                xd = (int32_t)((((int64_t)src->band_d[i * src_stride + j] * rfactor[2]) +
-                    add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-                I4_ADM_CM_THRESH_S_I_J(angles, flt_angles, csf_a_stride, &thr, w, h, i, j,
-                                               add_bef_shift_flt[scale - 1], shift_flt[scale - 1]);
-
-                I4_ADM_CM_ACCUM_ROUND(xh, thr, shift_sub, xh_sq, add_shift_sq, shift_sq, val,
-                                      add_shift_cub, shift_cub, accum_inner_h);
-                I4_ADM_CM_ACCUM_ROUND(xv, thr, shift_sub, xv_sq, add_shift_sq, shift_sq, val,
-                                      add_shift_cub, shift_cub, accum_inner_v);
-                I4_ADM_CM_ACCUM_ROUND(xd, thr, shift_sub, xd_sq, add_shift_sq, shift_sq, val,
-                                      add_shift_cub, shift_cub, accum_inner_d);
-            }
+            int64_t row_accum[3] = { 0 };
+            s->i4_cm_row(src, csf_a, csf_f, src_stride, csf_a_stride, i - buf_row,
+                         start_col, end_col, rfactor,
+                         add_bef_shift_dst[scale - 1], shift_dst[scale - 1],
+                         add_bef_shift_flt[scale - 1], shift_flt[scale - 1],
+                         add_shift_cub, shift_cub, row_accum);
+            accum_inner_h += row_accum[0];
+            accum_inner_v += row_accum[1];
+            accum_inner_d += row_accum[2];
             accum_h += (accum_inner_h + add_shift_inner_accum) >> shift_inner_accum;
             accum_v += (accum_inner_v + add_shift_inner_accum) >> shift_inner_accum;
             accum_d += (accum_inner_d + add_shift_inner_accum) >> shift_inner_accum;
@@ -1855,38 +1895,29 @@ static float i4_adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_s
     }
     else if ((left > 0) && (right > (w - 1))) /* Left border within frame, right outside */
     {
-        for (i = start_row; i < end_row; ++i)
+        for (i = band_start_row; i < band_end_row; ++i)
         {
             accum_inner_h = 0;
             accum_inner_v = 0;
             accum_inner_d = 0;
             /* j within frame */
-            for (j = start_col; j < end_col; ++j)
-            {
-                xh = (int32_t)((((int64_t)src->band_h[i * src_stride + j] * rfactor[0]) +
-                    add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-                xv = (int32_t)((((int64_t)src->band_v[i * src_stride + j] * rfactor[1]) +
-                    add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-                xd = (int32_t)((((int64_t)src->band_d[i * src_stride + j] * rfactor[2]) +
-                    add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-                I4_ADM_CM_THRESH_S_I_J(angles, flt_angles, csf_a_stride, &thr, w, h, i, j,
-                                               add_bef_shift_flt[scale - 1], shift_flt[scale - 1]);
-
-                I4_ADM_CM_ACCUM_ROUND(xh, thr, shift_sub, xh_sq, add_shift_sq, shift_sq, val,
-                                      add_shift_cub, shift_cub, accum_inner_h);
-                I4_ADM_CM_ACCUM_ROUND(xv, thr, shift_sub, xv_sq, add_shift_sq, shift_sq, val,
-                                      add_shift_cub, shift_cub, accum_inner_v);
-                I4_ADM_CM_ACCUM_ROUND(xd, thr, shift_sub, xd_sq, add_shift_sq, shift_sq, val,
-                                      add_shift_cub, shift_cub, accum_inner_d);
-            }
+            int64_t row_accum[3] = { 0 };
+            s->i4_cm_row(src, csf_a, csf_f, src_stride, csf_a_stride, i - buf_row,
+                         start_col, end_col, rfactor,
+                         add_bef_shift_dst[scale - 1], shift_dst[scale - 1],
+                         add_bef_shift_flt[scale - 1], shift_flt[scale - 1],
+                         add_shift_cub, shift_cub, row_accum);
+            accum_inner_h += row_accum[0];
+            accum_inner_v += row_accum[1];
+            accum_inner_d += row_accum[2];
             /* j = w-1 */
-            xh = (int32_t)((((int64_t)src->band_h[i * src_stride + w - 1] * rfactor[i * src_stride + w - 1])
+            xh = (int32_t)((((int64_t)src->band_h[(i - buf_row) * src_stride + w - 1] * rfactor[(i - buf_row) * src_stride + w - 1])
                 + add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-            xv = (int32_t)((((int64_t)src->band_v[i * src_stride + w - 1] * rfactor[i * src_stride + w - 1])
+            xv = (int32_t)((((int64_t)src->band_v[(i - buf_row) * src_stride + w - 1] * rfactor[(i - buf_row) * src_stride + w - 1])
                 + add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-            xd = (int32_t)((((int64_t)src->band_d[i * src_stride + w - 1] * rfactor[i * src_stride + w - 1])
+            xd = (int32_t)((((int64_t)src->band_d[(i - buf_row) * src_stride + w - 1] * rfactor[(i - buf_row) * src_stride + w - 1])
                 + add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-            I4_ADM_CM_THRESH_S_I_W_M_1(angles, flt_angles, csf_a_stride, &thr, w, h, i, (w - 1),
+            I4_ADM_CM_THRESH_S_I_W_M_1(angles, flt_angles, csf_a_stride, &thr, w, h, i - buf_row, (w - 1),
                                                add_bef_shift_flt[scale - 1], shift_flt[scale - 1]);
 
             I4_ADM_CM_ACCUM_ROUND(xh, thr, shift_sub, xh_sq, add_shift_sq, shift_sq, val,
@@ -1903,20 +1934,20 @@ static float i4_adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_s
     }
     else /* Both borders outside frame */
     {
-        for (i = start_row; i < end_row; ++i)
+        for (i = band_start_row; i < band_end_row; ++i)
         {
             accum_inner_h = 0;
             accum_inner_v = 0;
             accum_inner_d = 0;
 
             /* j = 0 */
-            xh = (int32_t)((((int64_t)src->band_h[i * src_stride] * rfactor[0]) +
+            xh = (int32_t)((((int64_t)src->band_h[(i - buf_row) * src_stride] * rfactor[0]) +
                 add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-            xv = (int32_t)((((int64_t)src->band_v[i * src_stride] * rfactor[1]) +
+            xv = (int32_t)((((int64_t)src->band_v[(i - buf_row) * src_stride] * rfactor[1]) +
                 add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-            xd = (int32_t)((((int64_t)src->band_d[i * src_stride] * rfactor[2]) +
+            xd = (int32_t)((((int64_t)src->band_d[(i - buf_row) * src_stride] * rfactor[2]) +
                 add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-            I4_ADM_CM_THRESH_S_I_0(angles, flt_angles, csf_a_stride, &thr, w, h, i, 0,
+            I4_ADM_CM_THRESH_S_I_0(angles, flt_angles, csf_a_stride, &thr, w, h, i - buf_row, 0,
                                            add_bef_shift_flt[scale - 1], shift_flt[scale - 1]);
 
             I4_ADM_CM_ACCUM_ROUND(xh, thr, shift_sub, xh_sq, add_shift_sq, shift_sq, val,
@@ -1927,32 +1958,23 @@ static float i4_adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_s
                                   add_shift_cub, shift_cub, accum_inner_d);
 
             /* j within frame */
-            for (j = start_col; j < end_col; ++j)
-            {
-                xh = (int32_t)((((int64_t)src->band_h[i * src_stride + j] * rfactor[0]) +
-                    add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-                xv = (int32_t)((((int64_t)src->band_v[i * src_stride + j] * rfactor[1]) +
-                    add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-                xd = (int32_t)((((int64_t)src->band_d[i * src_stride + j] * rfactor[2]) +
-                    add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-                I4_ADM_CM_THRESH_S_I_J(angles, flt_angles, csf_a_stride, &thr, w, h, i, j,
-                                               add_bef_shift_flt[scale - 1], shift_flt[scale - 1]);
-
-                I4_ADM_CM_ACCUM_ROUND(xh, thr, shift_sub, xh_sq, add_shift_sq, shift_sq, val,
-                                      add_shift_cub, shift_cub, accum_inner_h);
-                I4_ADM_CM_ACCUM_ROUND(xv, thr, shift_sub, xv_sq, add_shift_sq, shift_sq, val,
-                                      add_shift_cub, shift_cub, accum_inner_v);
-                I4_ADM_CM_ACCUM_ROUND(xd, thr, shift_sub, xd_sq, add_shift_sq, shift_sq, val,
-                                      add_shift_cub, shift_cub, accum_inner_d);
-            }
+            int64_t row_accum[3] = { 0 };
+            s->i4_cm_row(src, csf_a, csf_f, src_stride, csf_a_stride, i - buf_row,
+                         start_col, end_col, rfactor,
+                         add_bef_shift_dst[scale - 1], shift_dst[scale - 1],
+                         add_bef_shift_flt[scale - 1], shift_flt[scale - 1],
+                         add_shift_cub, shift_cub, row_accum);
+            accum_inner_h += row_accum[0];
+            accum_inner_v += row_accum[1];
+            accum_inner_d += row_accum[2];
             /* j = w-1 */
-            xh = (int32_t)((((int64_t)src->band_h[i * src_stride + w - 1] * rfactor[0]) +
+            xh = (int32_t)((((int64_t)src->band_h[(i - buf_row) * src_stride + w - 1] * rfactor[0]) +
                 add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-            xv = (int32_t)((((int64_t)src->band_v[i * src_stride + w - 1] * rfactor[1]) +
+            xv = (int32_t)((((int64_t)src->band_v[(i - buf_row) * src_stride + w - 1] * rfactor[1]) +
                 add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-            xd = (int32_t)((((int64_t)src->band_d[i * src_stride + w - 1] * rfactor[2]) +
+            xd = (int32_t)((((int64_t)src->band_d[(i - buf_row) * src_stride + w - 1] * rfactor[2]) +
                 add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-            I4_ADM_CM_THRESH_S_I_W_M_1(angles, flt_angles, csf_a_stride, &thr, w, h, i, (w - 1),
+            I4_ADM_CM_THRESH_S_I_W_M_1(angles, flt_angles, csf_a_stride, &thr, w, h, i - buf_row, (w - 1),
                                                add_bef_shift_flt[scale - 1], shift_flt[scale - 1]);
 
             I4_ADM_CM_ACCUM_ROUND(xh, thr, shift_sub, xh_sq, add_shift_sq, shift_sq, val,
@@ -1972,15 +1994,15 @@ static float i4_adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_s
     accum_inner_d = 0;
 
     /* i=h-1,j=0 */
-    if ((bottom > (h - 1)) && (left <= 0))
+    if (last_row && (left <= 0))
     {
-        xh = (int32_t)((((int64_t)src->band_h[(h - 1) * src_stride] * rfactor[0]) +
+        xh = (int32_t)((((int64_t)src->band_h[(h - 1 - buf_row) * src_stride] * rfactor[0]) +
             add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-        xv = (int32_t)((((int64_t)src->band_v[(h - 1) * src_stride] * rfactor[1]) +
+        xv = (int32_t)((((int64_t)src->band_v[(h - 1 - buf_row) * src_stride] * rfactor[1]) +
             add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-        xd = (int32_t)((((int64_t)src->band_d[(h - 1) * src_stride] * rfactor[2]) +
+        xd = (int32_t)((((int64_t)src->band_d[(h - 1 - buf_row) * src_stride] * rfactor[2]) +
             add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-        I4_ADM_CM_THRESH_S_H_M_1_0(angles, flt_angles, csf_a_stride, &thr, w, h, (h - 1), 0,
+        I4_ADM_CM_THRESH_S_H_M_1_0(angles, flt_angles, csf_a_stride, &thr, w, h - buf_row, (h - 1 - buf_row), 0,
                                            add_bef_shift_flt[scale - 1], shift_flt[scale - 1]);
 
         I4_ADM_CM_ACCUM_ROUND(xh, thr, shift_sub, xh_sq, add_shift_sq, shift_sq, val,
@@ -1992,17 +2014,17 @@ static float i4_adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_s
     }
 
     /* i=h-1,j */
-    if (bottom > (h - 1))
+    if (last_row)
     {
         for (j = start_col; j < end_col; ++j)
         {
-            xh = (int32_t)((((int64_t)src->band_h[(h - 1) * src_stride + j] * rfactor[0]) +
+            xh = (int32_t)((((int64_t)src->band_h[(h - 1 - buf_row) * src_stride + j] * rfactor[0]) +
                 add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-            xv = (int32_t)((((int64_t)src->band_v[(h - 1) * src_stride + j] * rfactor[1]) +
+            xv = (int32_t)((((int64_t)src->band_v[(h - 1 - buf_row) * src_stride + j] * rfactor[1]) +
                 add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-            xd = (int32_t)((((int64_t)src->band_d[(h - 1) * src_stride + j] * rfactor[2]) +
+            xd = (int32_t)((((int64_t)src->band_d[(h - 1 - buf_row) * src_stride + j] * rfactor[2]) +
                 add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-            I4_ADM_CM_THRESH_S_H_M_1_J(angles, flt_angles, csf_a_stride, &thr, w, h, (h - 1), j,
+            I4_ADM_CM_THRESH_S_H_M_1_J(angles, flt_angles, csf_a_stride, &thr, w, h - buf_row, (h - 1 - buf_row), j,
                                                add_bef_shift_flt[scale - 1], shift_flt[scale - 1]);
 
             I4_ADM_CM_ACCUM_ROUND(xh, thr, shift_sub, xh_sq, add_shift_sq, shift_sq, val,
@@ -2015,15 +2037,15 @@ static float i4_adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_s
     }
 
     /* i-h-1,j=w-1 */
-    if ((bottom > (h - 1)) && (right > (w - 1)))
+    if (last_row && (right > (w - 1)))
     {
-        xh = (int32_t)((((int64_t)src->band_h[(h - 1) * src_stride + w - 1] * rfactor[0]) +
+        xh = (int32_t)((((int64_t)src->band_h[(h - 1 - buf_row) * src_stride + w - 1] * rfactor[0]) +
             add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-        xv = (int32_t)((((int64_t)src->band_v[(h - 1) * src_stride + w - 1] * rfactor[1]) +
+        xv = (int32_t)((((int64_t)src->band_v[(h - 1 - buf_row) * src_stride + w - 1] * rfactor[1]) +
             add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-        xd = (int32_t)((((int64_t)src->band_d[(h - 1) * src_stride + w - 1] * rfactor[2]) +
+        xd = (int32_t)((((int64_t)src->band_d[(h - 1 - buf_row) * src_stride + w - 1] * rfactor[2]) +
             add_bef_shift_dst[scale - 1]) >> shift_dst[scale - 1]);
-        I4_ADM_CM_THRESH_S_H_M_1_W_M_1(angles, flt_angles, csf_a_stride, &thr, w, h, (h - 1),
+        I4_ADM_CM_THRESH_S_H_M_1_W_M_1(angles, flt_angles, csf_a_stride, &thr, w, h - buf_row, (h - 1 - buf_row),
                                                (w - 1), add_bef_shift_flt[scale - 1], shift_flt[scale - 1]);
 
         I4_ADM_CM_ACCUM_ROUND(xh, thr, shift_sub, xh_sq, add_shift_sq, shift_sq, val,
@@ -2037,13 +2059,32 @@ static float i4_adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_s
     accum_v += (accum_inner_v + add_shift_inner_accum) >> shift_inner_accum;
     accum_d += (accum_inner_d + add_shift_inner_accum) >> shift_inner_accum;
 
+    accum[0] += accum_h;
+    accum[1] += accum_v;
+    accum[2] += accum_d;
+}
+
+static float i4_adm_cm_score(const int64_t *accum, int w, int h, int scale)
+{
+    uint32_t shift_cub = (uint32_t)ceil(log2(w));
+    uint32_t shift_inner_accum = (uint32_t)ceil(log2(h));
+
+    float final_shift[3] = { pow(2,(45 - shift_cub - shift_inner_accum)),
+                             pow(2,(39 - shift_cub - shift_inner_accum)),
+                             pow(2,(36 - shift_cub - shift_inner_accum)) };
+
+    const int left = w * ADM_BORDER_FACTOR - 0.5;
+    const int top = h * ADM_BORDER_FACTOR - 0.5;
+    const int right = w - left;
+    const int bottom = h - top;
+
     /**
      * Converted to floating-point for calculating the final scores
      * Final shifts is calculated from 3*(shifts_from_previous_stage(i.e src comes from dwt)+32)-total_shifts_done_in_this_function
      */
-    float f_accum_h = (float)(accum_h / final_shift[scale - 1]);
-    float f_accum_v = (float)(accum_v / final_shift[scale - 1]);
-    float f_accum_d = (float)(accum_d / final_shift[scale - 1]);
+    float f_accum_h = (float)(accum[0] / final_shift[scale - 1]);
+    float f_accum_v = (float)(accum[1] / final_shift[scale - 1]);
+    float f_accum_d = (float)(accum[2] / final_shift[scale - 1]);
 
     float num_scale_h = powf(f_accum_h, 1.0f / 3.0f) + powf((bottom - top) * (right - left) / 32.0f, 1.0f / 3.0f);
     float num_scale_v = powf(f_accum_v, 1.0f / 3.0f) + powf((bottom - top) * (right - left) / 32.0f, 1.0f / 3.0f);
@@ -2052,7 +2093,7 @@ static float i4_adm_cm(AdmBuffer *buf, int w, int h, int src_stride, int csf_a_s
     return (num_scale_h + num_scale_v + num_scale_d);
 }
 
-static void i16_to_i32(adm_dwt_band_t *src, i4_adm_dwt_band_t *dst,
+static void i16_to_i32(const adm_dwt_band_t *src, i4_adm_dwt_band_t *dst,
                        int w, int h, int stride)
 {
     for (int i = 0; i < (h + 1) / 2; ++i) {
@@ -2064,474 +2105,135 @@ static void i16_to_i32(adm_dwt_band_t *src, i4_adm_dwt_band_t *dst,
     }
 }
 
-static void adm_dwt2_8(const uint8_t *src, const adm_dwt_band_t *dst,
-                       AdmBuffer *buf, int w, int h, int src_stride,
-                       int dst_stride)
+static void adm_dwt2_8_vert(const uint8_t *src, int **ind_y, int i, int w,
+                            int src_stride, int16_t *tmplo, int16_t *tmphi)
+{
+    for (int j = 0; j < w; ++j)
+        adm_dwt2_8_vert_px(src, ind_y, i, j, src_stride, tmplo, tmphi);
+}
+
+static void adm_dwt2_16_vert(const uint16_t *src, int **ind_y, int i, int w,
+                             int src_stride, int inp_size_bits,
+                             int16_t *tmplo, int16_t *tmphi)
 {
-    const int16_t *filter_lo = dwt2_db2_coeffs_lo;
-    const int16_t *filter_hi = dwt2_db2_coeffs_hi;
+    for (int j = 0; j < w; ++j) {
+        adm_dwt2_16_vert_px(src, ind_y, i, j, src_stride, inp_size_bits,
+                            tmplo, tmphi);
+    }
+}
 
-    const int16_t shift_VP = 8;
-    const int16_t shift_HP = 16;
-    const int32_t add_shift_VP = 128;
-    const int32_t add_shift_HP = 32768;
+static void adm_dwt2_16_hori(const int16_t *tmplo, const int16_t *tmphi,
+                             int **ind_x, int w, const adm_dwt_band_t *dst,
+                             size_t offset)
+{
+    for (int j = 0; j < (w + 1) / 2; ++j)
+        adm_dwt2_16_hori_px(tmplo, tmphi, ind_x, j, dst, offset);
+}
 
+static void adm_dwt2_16(const AdmState *s, const uint16_t *src,
+                        const adm_dwt_band_t *dst, AdmBuffer *buf, int w,
+                        int h, int src_stride, int dst_stride,
+                        int inp_size_bits)
+{
     int **ind_y = buf->ind_y;
     int **ind_x = buf->ind_x;
 
     int16_t *tmplo = (int16_t *)buf->tmp_ref;
     int16_t *tmphi = tmplo + w;
-    int32_t accum;
 
     for (int i = 0; i < (h + 1) / 2; ++i) {
         /* Vertical pass. */
-        for (int j = 0; j < w; ++j) {
-            uint16_t u_s0 = src[ind_y[0][i] * src_stride + j];
-            uint16_t u_s1 = src[ind_y[1][i] * src_stride + j];
-            uint16_t u_s2 = src[ind_y[2][i] * src_stride + j];
-            uint16_t u_s3 = src[ind_y[3][i] * src_stride + j];
-
-            accum = 0;
-            accum += (int32_t)filter_lo[0] * (int32_t)u_s0;
-            accum += (int32_t)filter_lo[1] * (int32_t)u_s1;
-            accum += (int32_t)filter_lo[2] * (int32_t)u_s2;
-            accum += (int32_t)filter_lo[3] * (int32_t)u_s3;
-
-            /* normalizing is done for range from(0 to N) to (-N/2 to N/2) */
-            accum -= (int32_t)dwt2_db2_coeffs_lo_sum * add_shift_VP;
-
-            tmplo[j] = (accum + add_shift_VP) >> shift_VP;
-
-            accum = 0;
-            accum += (int32_t)filter_hi[0] * (int32_t)u_s0;
-            accum += (int32_t)filter_hi[1] * (int32_t)u_s1;
-            accum += (int32_t)filter_hi[2] * (int32_t)u_s2;
-            accum += (int32_t)filter_hi[3] * (int32_t)u_s3;
-
-            /* normalizing is done for range from(0 to N) to (-N/2 to N/2) */
-            accum -= (int32_t)dwt2_db2_coeffs_hi_sum * add_shift_VP;
-
-            tmphi[j] = (accum + add_shift_VP) >> shift_VP;
-        }
+        s->dwt2_16_vert(src, ind_y, i, w, src_stride, inp_size_bits, tmplo,
+                        tmphi);
 
         /* Horizontal pass (lo and hi). */
-        for (int j = 0; j < (w + 1) / 2; ++j) {
-            int j0 = ind_x[0][j];
-            int j1 = ind_x[1][j];
-            int j2 = ind_x[2][j];
-            int j3 = ind_x[3][j];
-
-            int16_t s0 = tmplo[j0];
-            int16_t s1 = tmplo[j1];
-            int16_t s2 = tmplo[j2];
-            int16_t s3 = tmplo[j3];
-
-            accum = 0;
-            accum += (int32_t)filter_lo[0] * s0;
-            accum += (int32_t)filter_lo[1] * s1;
-            accum += (int32_t)filter_lo[2] * s2;
-            accum += (int32_t)filter_lo[3] * s3;
-            dst->band_a[i * dst_stride + j] = (accum + add_shift_HP) >> shift_HP;
-
-            accum = 0;
-            accum += (int32_t)filter_hi[0] * s0;
-            accum += (int32_t)filter_hi[1] * s1;
-            accum += (int32_t)filter_hi[2] * s2;
-            accum += (int32_t)filter_hi[3] * s3;
-            dst->band_v[i * dst_stride + j] = (accum + add_shift_HP) >> shift_HP;
-
-            s0 = tmphi[j0];
-            s1 = tmphi[j1];
-            s2 = tmphi[j2];
-            s3 = tmphi[j3];
-
-            accum = 0;
-            accum += (int32_t)filter_lo[0] * s0;
-            accum += (int32_t)filter_lo[1] * s1;
-            accum += (int32_t)filter_lo[2] * s2;
-            accum += (int32_t)filter_lo[3] * s3;
-            dst->band_h[i * dst_stride + j] = (accum + add_shift_HP) >> shift_HP;
-
-            accum = 0;
-            accum += (int32_t)filter_hi[0] * s0;
-            accum += (int32_t)filter_hi[1] * s1;
-            accum += (int32_t)filter_hi[2] * s2;
-            accum += (int32_t)filter_hi[3] * s3;
-            dst->band_d[i * dst_stride + j] = (accum + add_shift_HP) >> shift_HP;
-        }
+        s->dwt2_16_hori(tmplo, tmphi, ind_x, w, dst, i * dst_stride);
     }
 }
 
-static void adm_dwt2_16(const uint16_t *src, const adm_dwt_band_t *dst, AdmBuffer *buf, int w, int h,
-                        int src_stride, int dst_stride, int inp_size_bits)
+static void adm_dwt2_8(const AdmState *s, const uint8_t *src,
+                       const adm_dwt_band_t *dst, AdmBuffer *buf, int w,
+                       int h, int src_stride, int dst_stride)
 {
-    const int16_t *filter_lo = dwt2_db2_coeffs_lo;
-    const int16_t *filter_hi = dwt2_db2_coeffs_hi;
-
-    const int16_t shift_VP = inp_size_bits;
-    const int16_t shift_HP = 16;
-    const int32_t add_shift_VP = 1 << (inp_size_bits - 1);
-    const int32_t add_shift_HP = 32768;
-
     int **ind_y = buf->ind_y;
     int **ind_x = buf->ind_x;
 
     int16_t *tmplo = (int16_t *)buf->tmp_ref;
     int16_t *tmphi = tmplo + w;
-    int32_t accum;
 
     for (int i = 0; i < (h + 1) / 2; ++i) {
         /* Vertical pass. */
-        for (int j = 0; j < w; ++j) {
-            uint16_t u_s0 = src[ind_y[0][i] * src_stride + j];
-            uint16_t u_s1 = src[ind_y[1][i] * src_stride + j];
-            uint16_t u_s2 = src[ind_y[2][i] * src_stride + j];
-            uint16_t u_s3 = src[ind_y[3][i] * src_stride + j];
-
-            accum = 0;
-            accum += (int32_t)filter_lo[0] * (int32_t)u_s0;
-            accum += (int32_t)filter_lo[1] * (int32_t)u_s1;
-            accum += (int32_t)filter_lo[2] * (int32_t)u_s2;
-            accum += (int32_t)filter_lo[3] * (int32_t)u_s3;
+        s->dwt2_8_vert(src, ind_y, i, w, src_stride, tmplo, tmphi);
 
-            /* normalizing is done for range from(0 to N) to (-N/2 to N/2) */
-            accum -= (int32_t)dwt2_db2_coeffs_lo_sum * add_shift_VP;
-
-            tmplo[j] = (accum + add_shift_VP) >> shift_VP;
-
-            accum = 0;
-            accum += (int32_t)filter_hi[0] * (int32_t)u_s0;
-            accum += (int32_t)filter_hi[1] * (int32_t)u_s1;
-            accum += (int32_t)filter_hi[2] * (int32_t)u_s2;
-            accum += (int32_t)filter_hi[3] * (int32_t)u_s3;
+        /* Horizontal pass (lo and hi), the same as for 16-bit input. */
+        s->dwt2_16_hori(tmplo, tmphi, ind_x, w, dst, i * dst_stride);
+    }
+}
 
-            /* normalizing is done for range from(0 to N) to (-N/2 to N/2) */
-            accum -= (int32_t)dwt2_db2_coeffs_hi_sum * add_shift_VP;
+static void adm_dwt2_s123_vert(const int32_t *src, int **ind_y, int i, int w,
+                               int src_stride, int32_t add, int16_t shift,
+                               int32_t *tmplo, int32_t *tmphi)
+{
+    for (int j = 0; j < w; ++j) {
+        adm_dwt2_s123_vert_px(src, ind_y, i, j, src_stride, add, shift, tmplo,
+                              tmphi);
+    }
+}
 
-            tmphi[j] = (accum + add_shift_VP) >> shift_VP;
-        }
+static void adm_dwt2_s123_hori(const int32_t *tmplo, const int32_t *tmphi,
+                               int **ind_x, int w,
+                               const i4_adm_dwt_band_t *dst, size_t offset,
+                               int32_t add, int16_t shift)
+{
+    for (int j = 0; j < (w + 1) / 2; ++j) {
+        adm_dwt2_s123_hori_px(tmplo, tmphi, ind_x, j, dst, offset, add,
+                              shift);
+    }
+}
 
-        /* Horizontal pass (lo and hi). */
-        for (int j = 0; j < (w + 1) / 2; ++j) {
-            int j0 = ind_x[0][j];
-            int j1 = ind_x[1][j];
-            int j2 = ind_x[2][j];
-            int j3 = ind_x[3][j];
-
-            int16_t s0 = tmplo[j0];
-            int16_t s1 = tmplo[j1];
-            int16_t s2 = tmplo[j2];
-            int16_t s3 = tmplo[j3];
-
-            accum = 0;
-            accum += (int32_t)filter_lo[0] * s0;
-            accum += (int32_t)filter_lo[1] * s1;
-            accum += (int32_t)filter_lo[2] * s2;
-            accum += (int32_t)filter_lo[3] * s3;
-            dst->band_a[i * dst_stride + j] = (accum + add_shift_HP) >> shift_HP;
-
-            accum = 0;
-            accum += (int32_t)filter_hi[0] * s0;
-            accum += (int32_t)filter_hi[1] * s1;
-            accum += (int32_t)filter_hi[2] * s2;
-            accum += (int32_t)filter_hi[3] * s3;
-            dst->band_v[i * dst_stride + j] = (accum + add_shift_HP) >> shift_HP;
-
-            s0 = tmphi[j0];
-            s1 = tmphi[j1];
-            s2 = tmphi[j2];
-            s3 = tmphi[j3];
-
-            accum = 0;
-            accum += (int32_t)filter_lo[0] * s0;
-            accum += (int32_t)filter_lo[1] * s1;
-            accum += (int32_t)filter_lo[2] * s2;
-            accum += (int32_t)filter_lo[3] * s3;
-            dst->band_h[i * dst_stride + j] = (accum + add_shift_HP) >> shift_HP;
-
-            accum = 0;
-            accum += (int32_t)filter_hi[0] * s0;
-            accum += (int32_t)filter_hi[1] * s1;
-            accum += (int32_t)filter_hi[2] * s2;
-            accum += (int32_t)filter_hi[3] * s3;
-            dst->band_d[i * dst_stride + j] = (accum + add_shift_HP) >> shift_HP;
-        }
+static void adm_dwt2_s0(const AdmState *s, VmafPicture *pic,
+                        const adm_dwt_band_t *dst, AdmBuffer *buf, int w,
+                        int h, int dst_stride)
+{
+    if (pic->bpc == 8) {
+        adm_dwt2_8(s, pic->data[0], dst, buf, w, h, pic->stride[0],
+                   dst_stride);
+    }
+    else {
+        adm_dwt2_16(s, pic->data[0], dst, buf, w, h, pic->stride[0] >> 1,
+                    dst_stride, pic->bpc);
     }
 }
 
-static void adm_dwt2_s123_combined(const int32_t *i4_ref_scale, const int32_t *i4_curr_dis,
-                                   AdmBuffer *buf, int w, int h, int ref_stride,
-                                   int dis_stride, int dst_stride, int scale)
+static void adm_dwt2_s123(const AdmState *s, const int32_t *src,
+                          const i4_adm_dwt_band_t *dst, AdmBuffer *buf, int w,
+                          int h, int src_stride, int dst_stride, int scale)
 {
-    const i4_adm_dwt_band_t *i4_ref_dwt2 = &buf->i4_ref_dwt2;
-    const i4_adm_dwt_band_t *i4_dis_dwt2 = &buf->i4_dis_dwt2;
     int **ind_y = buf->ind_y;
     int **ind_x = buf->ind_x;
 
-    const int16_t *filter_lo = dwt2_db2_coeffs_lo;
-    const int16_t *filter_hi = dwt2_db2_coeffs_hi;
-
     const int32_t add_bef_shift_round_VP[3] = { 0, 32768, 32768 };
     const int32_t add_bef_shift_round_HP[3] = { 16384, 32768, 16384 };
     const int16_t shift_VerticalPass[3] = { 0, 16, 16 };
     const int16_t shift_HorizontalPass[3] = { 15, 16, 15 };
 
-    int32_t *tmplo_ref = buf->tmp_ref;
-    int32_t *tmphi_ref = tmplo_ref + w;
-    int32_t *tmplo_dis = tmphi_ref + w;
-    int32_t *tmphi_dis = tmplo_dis + w;
-    int32_t s10, s11, s12, s13;
-
-    int64_t accum_ref;
+    int32_t *tmplo = buf->tmp_ref;
+    int32_t *tmphi = tmplo + w;
 
     for (int i = 0; i < (h + 1) / 2; ++i)
     {
         /* Vertical pass. */
-        for (int j = 0; j < w; ++j)
-        {
-            s10 = i4_ref_scale[ind_y[0][i] * ref_stride + j];
-            s11 = i4_ref_scale[ind_y[1][i] * ref_stride + j];
-            s12 = i4_ref_scale[ind_y[2][i] * ref_stride + j];
-            s13 = i4_ref_scale[ind_y[3][i] * ref_stride + j];
-            accum_ref = 0;
-            accum_ref += (int64_t)filter_lo[0] * s10;
-            accum_ref += (int64_t)filter_lo[1] * s11;
-            accum_ref += (int64_t)filter_lo[2] * s12;
-            accum_ref += (int64_t)filter_lo[3] * s13;
-            tmplo_ref[j] = (int32_t)((accum_ref + add_bef_shift_round_VP[scale - 1])
-                >> shift_VerticalPass[scale - 1]);
-            accum_ref = 0;
-            accum_ref += (int64_t)filter_hi[0] * s10;
-            accum_ref += (int64_t)filter_hi[1] * s11;
-            accum_ref += (int64_t)filter_hi[2] * s12;
-            accum_ref += (int64_t)filter_hi[3] * s13;
-            tmphi_ref[j] = (int32_t)((accum_ref + add_bef_shift_round_VP[scale - 1])
-                >> shift_VerticalPass[scale - 1]);
-
-            s10 = i4_curr_dis[ind_y[0][i] * dis_stride + j];
-            s11 = i4_curr_dis[ind_y[1][i] * dis_stride + j];
-            s12 = i4_curr_dis[ind_y[2][i] * dis_stride + j];
-            s13 = i4_curr_dis[ind_y[3][i] * dis_stride + j];
-            accum_ref = 0;
-            accum_ref += (int64_t)filter_lo[0] * s10;
-            accum_ref += (int64_t)filter_lo[1] * s11;
-            accum_ref += (int64_t)filter_lo[2] * s12;
-            accum_ref += (int64_t)filter_lo[3] * s13;
-            tmplo_dis[j] = (int32_t)((accum_ref + add_bef_shift_round_VP[scale - 1])
-                >> shift_VerticalPass[scale - 1]);
-            accum_ref = 0;
-            accum_ref += (int64_t)filter_hi[0] * s10;
-            accum_ref += (int64_t)filter_hi[1] * s11;
-            accum_ref += (int64_t)filter_hi[2] * s12;
-            accum_ref += (int64_t)filter_hi[3] * s13;
-            tmphi_dis[j] = (int32_t)((accum_ref + add_bef_shift_round_VP[scale - 1])
-                >> shift_VerticalPass[scale - 1]);
-        }
+        s->dwt2_s123_vert(src, ind_y, i, w, src_stride,
+                          add_bef_shift_round_VP[scale - 1],
+                          shift_VerticalPass[scale - 1], tmplo, tmphi);
+
         /* Horizontal pass (lo and hi). */
-        for (int j = 0; j < (w + 1) / 2; ++j)
-        {
-            int j0 = ind_x[0][j];
-            int j1 = ind_x[1][j];
-            int j2 = ind_x[2][j];
-            int j3 = ind_x[3][j];
-
-            s10 = tmplo_ref[j0];
-            s11 = tmplo_ref[j1];
-            s12 = tmplo_ref[j2];
-            s13 = tmplo_ref[j3];
-
-            accum_ref = 0;
-            accum_ref += (int64_t)filter_lo[0] * s10;
-            accum_ref += (int64_t)filter_lo[1] * s11;
-            accum_ref += (int64_t)filter_lo[2] * s12;
-            accum_ref += (int64_t)filter_lo[3] * s13;
-            i4_ref_dwt2->band_a[i * dst_stride + j] = (int32_t)((accum_ref +
-                add_bef_shift_round_HP[scale - 1]) >> shift_HorizontalPass[scale - 1]);
-
-            accum_ref = 0;
-            accum_ref += (int64_t)filter_hi[0] * s10;
-            accum_ref += (int64_t)filter_hi[1] * s11;
-            accum_ref += (int64_t)filter_hi[2] * s12;
-            accum_ref += (int64_t)filter_hi[3] * s13;
-            i4_ref_dwt2->band_v[i * dst_stride + j] = (int32_t)((accum_ref +
-                add_bef_shift_round_HP[scale - 1]) >> shift_HorizontalPass[scale - 1]);
-
-            s10 = tmphi_ref[j0];
-            s11 = tmphi_ref[j1];
-            s12 = tmphi_ref[j2];
-            s13 = tmphi_ref[j3];
-
-            accum_ref = 0;
-            accum_ref += (int64_t)filter_lo[0] * s10;
-            accum_ref += (int64_t)filter_lo[1] * s11;
-            accum_ref += (int64_t)filter_lo[2] * s12;
-            accum_ref += (int64_t)filter_lo[3] * s13;
-            i4_ref_dwt2->band_h[i * dst_stride + j] = (int32_t)((accum_ref +
-                add_bef_shift_round_HP[scale - 1]) >> shift_HorizontalPass[scale - 1]);
-
-            accum_ref = 0;
-            accum_ref += (int64_t)filter_hi[0] * s10;
-            accum_ref += (int64_t)filter_hi[1] * s11;
-            accum_ref += (int64_t)filter_hi[2] * s12;
-            accum_ref += (int64_t)filter_hi[3] * s13;
-            i4_ref_dwt2->band_d[i * dst_stride + j] = (int32_t)((accum_ref +
-                add_bef_shift_round_HP[scale - 1]) >> shift_HorizontalPass[scale - 1]);
-
-            s10 = tmplo_dis[j0];
-            s11 = tmplo_dis[j1];
-            s12 = tmplo_dis[j2];
-            s13 = tmplo_dis[j3];
-
-            accum_ref = 0;
-            accum_ref += (int64_t)filter_lo[0] * s10;
-            accum_ref += (int64_t)filter_lo[1] * s11;
-            accum_ref += (int64_t)filter_lo[2] * s12;
-            accum_ref += (int64_t)filter_lo[3] * s13;
-            i4_dis_dwt2->band_a[i * dst_stride + j] = (int32_t)((accum_ref +
-                add_bef_shift_round_HP[scale - 1]) >> shift_HorizontalPass[scale - 1]);
-
-            accum_ref = 0;
-            accum_ref += (int64_t)filter_hi[0] * s10;
-            accum_ref += (int64_t)filter_hi[1] * s11;
-            accum_ref += (int64_t)filter_hi[2] * s12;
-            accum_ref += (int64_t)filter_hi[3] * s13;
-            i4_dis_dwt2->band_v[i * dst_stride + j] = (int32_t)((accum_ref +
-                add_bef_shift_round_HP[scale - 1]) >> shift_HorizontalPass[scale - 1]);
-
-            s10 = tmphi_dis[j0];
-            s11 = tmphi_dis[j1];
-            s12 = tmphi_dis[j2];
-            s13 = tmphi_dis[j3];
-
-            accum_ref = 0;
-            accum_ref += (int64_t)filter_lo[0] * s10;
-            accum_ref += (int64_t)filter_lo[1] * s11;
-            accum_ref += (int64_t)filter_lo[2] * s12;
-            accum_ref += (int64_t)filter_lo[3] * s13;
-            i4_dis_dwt2->band_h[i * dst_stride + j] = (int32_t)((accum_ref +
-                add_bef_shift_round_HP[scale - 1]) >> shift_HorizontalPass[scale - 1]);
-
-            accum_ref = 0;
-            accum_ref += (int64_t)filter_hi[0] * s10;
-            accum_ref += (int64_t)filter_hi[1] * s11;
-            accum_ref += (int64_t)filter_hi[2] * s12;
-            accum_ref += (int64_t)filter_hi[3] * s13;
-            i4_dis_dwt2->band_d[i * dst_stride + j] = (int32_t)((accum_ref +
-                add_bef_shift_round_HP[scale - 1]) >> shift_HorizontalPass[scale - 1]);
-        }
+        s->dwt2_s123_hori(tmplo, tmphi, ind_x, w, dst, i * dst_stride,
+                          add_bef_shift_round_HP[scale - 1],
+                          shift_HorizontalPass[scale - 1]);
     }
 }
 
-void integer_compute_adm(AdmState *s, VmafPicture *ref_pic, VmafPicture *dis_pic,
-                         double *score, double *score_num, double *score_den, double *scores, AdmBuffer *buf,
-                         double adm_enhn_gain_limit,
-                         double adm_norm_view_dist, int adm_ref_display_height)
-{
-    int w = ref_pic->w[0];
-    int h = ref_pic->h[0];
-
-    const double numden_limit = 1e-10 * (w * h) / (1920.0 * 1080.0);
-
-    size_t curr_ref_stride;
-    size_t curr_dis_stride;
-    size_t buf_stride = buf->ind_size_x >> 2;
-
-    int32_t *i4_curr_ref_scale = NULL;
-    int32_t *i4_curr_dis_scale = NULL;
-
-    if (ref_pic->bpc == 8) {
-        curr_ref_stride = ref_pic->stride[0];
-        curr_dis_stride = dis_pic->stride[0];
-    }
-    else {
-        curr_ref_stride = ref_pic->stride[0] >> 1;
-        curr_dis_stride = dis_pic->stride[0] >> 1;
-    }
-
-    double num = 0;
-    double den = 0;
-	for (unsigned scale = 0; scale < 4; ++scale) {
-		float num_scale = 0.0;
-		float den_scale = 0.0;
-
-        dwt2_src_indices_filt(buf->ind_y, buf->ind_x, w, h);
-		if(scale==0) {
-            if (ref_pic->bpc == 8) {
-                s->dwt2_8(ref_pic->data[0], &buf->ref_dwt2, buf, w, h,
-                          curr_ref_stride, buf_stride);
-                s->dwt2_8(dis_pic->data[0], &buf->dis_dwt2, buf, w, h,
-                          curr_dis_stride, buf_stride);
-            }
-            else {
-                adm_dwt2_16(ref_pic->data[0], &buf->ref_dwt2, buf, w, h,
-                            curr_ref_stride, buf_stride, ref_pic->bpc);
-                adm_dwt2_16(dis_pic->data[0], &buf->dis_dwt2, buf, w, h,
-                            curr_dis_stride, buf_stride, dis_pic->bpc);
-            }
-
-			i16_to_i32(&buf->ref_dwt2, &buf->i4_ref_dwt2, w, h, buf_stride);
-			i16_to_i32(&buf->dis_dwt2, &buf->i4_dis_dwt2, w, h, buf_stride);
-
-			w = (w + 1) / 2;
-			h = (h + 1) / 2;
-
-			adm_decouple(buf, w, h, buf_stride, adm_enhn_gain_limit);
-
-			den_scale = adm_csf_den_scale(&buf->ref_dwt2, w, h, buf_stride,
-                                 adm_norm_view_dist, adm_ref_display_height);
-
-			adm_csf(buf, w, h, buf_stride, adm_norm_view_dist, adm_ref_display_height);
-
-			num_scale = adm_cm(buf, w, h, buf_stride, buf_stride,
-                               adm_norm_view_dist, adm_ref_display_height);
-		}
-		else {
-            adm_dwt2_s123_combined(i4_curr_ref_scale, i4_curr_dis_scale, buf, w, h, curr_ref_stride,
-                                   curr_dis_stride, buf_stride, scale);
-
-			w = (w + 1) / 2;
-			h = (h + 1) / 2;
-
-			adm_decouple_s123(buf, w, h, buf_stride, adm_enhn_gain_limit);
-
-			den_scale = adm_csf_den_s123(
-			        &buf->i4_ref_dwt2, scale, w, h, buf_stride,
-			        adm_norm_view_dist, adm_ref_display_height);
-
-			i4_adm_csf(buf, scale, w, h, buf_stride,
-              adm_norm_view_dist, adm_ref_display_height);
-
-			num_scale = i4_adm_cm(buf, w, h, buf_stride, buf_stride, scale,
-                         adm_norm_view_dist, adm_ref_display_height);
-		}
-
-		num += num_scale;
-		den += den_scale;
-
-		i4_curr_ref_scale = buf->i4_ref_dwt2.band_a;
-		i4_curr_dis_scale = buf->i4_dis_dwt2.band_a;
-
-		curr_ref_stride = buf_stride;
-		curr_dis_stride = buf_stride;
-
-		scores[2 * scale + 0] = num_scale;
-		scores[2 * scale + 1] = den_scale;
-	}
-
-	num = num < numden_limit ? 0 : num;
-	den = den < numden_limit ? 0 : den;
-
-	if (den == 0.0) {
-		*score = 1.0f;
-	}
-	else {
-		*score = num / den;
-	}
-    *score_num = num;
-    *score_den = den;
-
-}
-
 static inline void *init_dwt_band(adm_dwt_band_t *band, char *data_top, size_t stride)
 {
     band->band_a = (int16_t *)data_top; data_top += stride;
@@ -2577,6 +2279,430 @@ static inline void *i4_init_dwt_band_hvd(i4_adm_dwt_band_t *band, char *data_top
     return data_top;
 }
 
+static adm_dwt_band_t adm_band_at(const adm_dwt_band_t *band, size_t offset)
+{
+    const adm_dwt_band_t at = {
+        .band_a = band->band_a + offset,
+        .band_v = band->band_v + offset,
+        .band_h = band->band_h + offset,
+        .band_d = band->band_d + offset,
+    };
+    return at;
+}
+
+static i4_adm_dwt_band_t i4_adm_band_at(const i4_adm_dwt_band_t *band,
+                                        size_t offset)
+{
+    const i4_adm_dwt_band_t at = {
+        .band_a = band->band_a + offset,
+        .band_v = band->band_v + offset,
+        .band_h = band->band_h + offset,
+        .band_d = band->band_d + offset,
+    };
+    return at;
+}
+
+/*
+ * The dwt of the reference at all scales. It only depends on the reference
+ * picture, so when several contexts score distorted pictures against it,
+ * see vmaf_read_pictures_multi(), it goes through the picture cache and is
+ * computed once for all of them. Planes have the stride of the windows and
+ * a spare row for the SIMD dwt kernels, see below.
+ */
+typedef struct AdmRefDwt {
+    adm_dwt_band_t s0;
+    i4_adm_dwt_band_t s123[3];
+} AdmRefDwt;
+
+static size_t adm_ref_dwt_plane_sz(const AdmState *s, int scale)
+{
+    int h = s->h;
+    for (int i = 0; i <= scale; i++)
+        h = (h + 1) / 2;
+    const size_t row_sz = scale ? s->buf.ind_size_x : s->buf.ind_size_x / 2;
+    return ALIGN_CEIL(row_sz * (h + 1));
+}
+
+static size_t adm_ref_dwt_sz(const AdmState *s)
+{
+    size_t sz = 0;
+    for (int scale = 0; scale < 4; scale++)
+        sz += 4 * adm_ref_dwt_plane_sz(s, scale);
+    return sz;
+}
+
+static AdmRefDwt adm_ref_dwt_at(const AdmState *s, const void *data)
+{
+    AdmRefDwt dwt;
+    char *data_top = (char *) data;
+    data_top = init_dwt_band(&dwt.s0, data_top, adm_ref_dwt_plane_sz(s, 0));
+    for (int scale = 1; scale < 4; scale++) {
+        data_top = i4_init_dwt_band(&dwt.s123[scale - 1], data_top,
+                                    adm_ref_dwt_plane_sz(s, scale));
+    }
+    return dwt;
+}
+
+typedef struct AdmRefDwtJob {
+    AdmState *s;
+    VmafPicture *pic;
+    const AdmRefDwt *dwt;
+    int w; // of the input of the scale
+    int scale;
+    int buf_stride;
+} AdmRefDwtJob;
+
+static void adm_ref_dwt_band(void *data, unsigned band,
+                             unsigned row_begin, unsigned row_end)
+{
+    AdmRefDwtJob *job = data;
+    AdmState *s = job->s;
+    const int stride = job->buf_stride;
+    const int rows = row_end - row_begin;
+    const size_t offset = row_begin * stride;
+
+    AdmBuffer view = s->band_buf[band];
+    for (unsigned k = 0; k < 4; k++)
+        view.ind_y[k] = s->buf.ind_y[k] + row_begin;
+
+    if (job->scale == 0) {
+        const adm_dwt_band_t dst = adm_band_at(&job->dwt->s0, offset);
+        adm_dwt2_s0(s, job->pic, &dst, &view, job->w, 2 * rows, stride);
+        // band a in 32 bits is the input of scale 1
+        i4_adm_dwt_band_t i4_a = { .band_a = s->i4_ref_a[0] + offset };
+        i16_to_i32(&dst, &i4_a, job->w, 2 * rows, stride);
+    }
+    else {
+        const int32_t *src = job->scale == 1 ? s->i4_ref_a[0] :
+                             job->dwt->s123[job->scale - 2].band_a;
+        const i4_adm_dwt_band_t dst =
+            i4_adm_band_at(&job->dwt->s123[job->scale - 1], offset);
+        adm_dwt2_s123(s, src, &dst, &view, job->w, 2 * rows, stride, stride,
+                      job->scale);
+    }
+}
+
+static int fill_ref_dwt(VmafPicture *pic, int param, void *data,
+                        void *cookie)
+{
+    VmafFeatureExtractor *fex = cookie;
+    AdmState *s = fex->priv;
+    (void) param;
+
+    const AdmRefDwt dwt = adm_ref_dwt_at(s, data);
+    AdmRefDwtJob job = {
+        .s = s,
+        .pic = pic,
+        .dwt = &dwt,
+        .buf_stride = s->buf.ind_size_x >> 2,
+    };
+
+    int w = pic->w[0];
+    int h = pic->h[0];
+    for (int scale = 0; scale < 4; scale++) {
+        dwt2_src_indices_filt(s->buf.ind_y, s->buf.ind_x, w, h);
+        job.scale = scale;
+        job.w = w;
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+        int err = vmaf_feature_extractor_run_bands(fex, h, s->band_cnt,
+                                                   adm_ref_dwt_band, &job);
+        if (err) return err;
+    }
+
+    return 0;
+}
+
+typedef struct AdmBandJob {
+    AdmState *s;
+    VmafPicture *ref_pic, *dis_pic;
+    const AdmRefDwt *ref_dwt; // of a shared reference, NULL otherwise
+    int w, h; // of the input of the scale
+    int scale;
+    int buf_stride;
+    // band a of the previous scale, the input of scales 1-3, and of this
+    // scale, which the last scale has no use for
+    const int32_t *i4_ref_src, *i4_dis_src;
+    int32_t *i4_ref_dst, *i4_dis_dst;
+} AdmBandJob;
+
+/*
+ * A band goes through its rows a strip at a time, all the stages of a strip
+ * one after the other, so that each stage finds the output of the previous
+ * one still in cache. The window of a band holds the planes of a strip, the
+ * row above and below it which cm reads, and a spare row for the SIMD dwt
+ * kernels, which store up to one vector past the end of each output row.
+ */
+#define ADM_WINDOW_PLANES 20
+#define ADM_STRIP_BYTES (512 * 1024)
+#define ADM_STRIP_ROWS_MIN 4
+#define ADM_STRIP_ROWS_MAX 64
+
+// rows [row_begin, row_end) of the output of the scale into the window,
+// with band a of these rows into the output of the scale when keep is set.
+// A shared reference is done already.
+static void adm_dwt2_rows(const AdmBandJob *job, AdmBuffer *win, int buf_row,
+                          int row_begin, int row_end, bool keep)
+{
+    AdmState *s = job->s;
+    const int stride = job->buf_stride;
+    const int rows = row_end - row_begin;
+    const size_t offset = (row_begin - buf_row) * stride;
+
+    if (rows <= 0) return;
+
+    // a view of the window whose row indices and destinations start there
+    AdmBuffer view = *win;
+    for (unsigned k = 0; k < 4; k++)
+        view.ind_y[k] = win->ind_y[k] + row_begin;
+
+    if (job->scale == 0) {
+        const adm_dwt_band_t ref_dwt2 = adm_band_at(&win->ref_dwt2, offset);
+        const adm_dwt_band_t dis_dwt2 = adm_band_at(&win->dis_dwt2, offset);
+
+        if (!job->ref_dwt) {
+            adm_dwt2_s0(s, job->ref_pic, &ref_dwt2, &view, job->w, 2 * rows,
+                        stride);
+        }
+        adm_dwt2_s0(s, job->dis_pic, &dis_dwt2, &view, job->w, 2 * rows,
+                    stride);
+
+        if (!keep) return;
+        if (!job->ref_dwt) {
+            i4_adm_dwt_band_t i4_ref_a = {
+                .band_a = job->i4_ref_dst + row_begin * stride,
+            };
+            i16_to_i32(&ref_dwt2, &i4_ref_a, job->w, 2 * rows, stride);
+        }
+        i4_adm_dwt_band_t i4_dis_a = {
+            .band_a = job->i4_dis_dst + row_begin * stride,
+        };
+        i16_to_i32(&dis_dwt2, &i4_dis_a, job->w, 2 * rows, stride);
+    }
+    else {
+        i4_adm_dwt_band_t i4_ref_dwt2 =
+            i4_adm_band_at(&win->i4_ref_dwt2, offset);
+        i4_adm_dwt_band_t i4_dis_dwt2 =
+            i4_adm_band_at(&win->i4_dis_dwt2, offset);
+        if (keep) {
+            i4_ref_dwt2.band_a = job->i4_ref_dst + row_begin * stride;
+            i4_dis_dwt2.band_a = job->i4_dis_dst + row_begin * stride;
+        }
+        if (!job->ref_dwt) {
+            adm_dwt2_s123(s, job->i4_ref_src, &i4_ref_dwt2, &view, job->w,
+                          2 * rows, stride, stride, job->scale);
+        }
+        adm_dwt2_s123(s, job->i4_dis_src, &i4_dis_dwt2, &view, job->w,
+                      2 * rows, stride, stride, job->scale);
+    }
+}
+
+// moves rows row and row + 1 of the planes read by cm to the top of the window
+static void adm_window_slide(AdmBuffer *win, int scale, int stride, int row)
+{
+    if (scale == 0) {
+        int16_t *planes[9] = {
+            win->decouple_r.band_h, win->decouple_r.band_v,
+            win->decouple_r.band_d, win->csf_a.band_h, win->csf_a.band_v,
+            win->csf_a.band_d, win->csf_f.band_h, win->csf_f.band_v,
+            win->csf_f.band_d,
+        };
+        for (unsigned k = 0; k < 9; k++) {
+            memmove(planes[k], planes[k] + row * stride,
+                    2 * stride * sizeof(int16_t));
+        }
+    }
+    else {
+        int32_t *planes[9] = {
+            win->i4_decouple_r.band_h, win->i4_decouple_r.band_v,
+            win->i4_decouple_r.band_d, win->i4_csf_a.band_h,
+            win->i4_csf_a.band_v, win->i4_csf_a.band_d, win->i4_csf_f.band_h,
+            win->i4_csf_f.band_v, win->i4_csf_f.band_d,
+        };
+        for (unsigned k = 0; k < 9; k++) {
+            memmove(planes[k], planes[k] + row * stride,
+                    2 * stride * sizeof(int32_t));
+        }
+    }
+}
+
+static void adm_scale_band(void *data, unsigned band,
+                           unsigned row_begin, unsigned row_end)
+{
+    AdmBandJob *job = data;
+    AdmState *s = job->s;
+    AdmBuffer *win = &s->band_buf[band];
+    const int scale = job->scale;
+    const int stride = job->buf_stride;
+    const int w = (job->w + 1) / 2;
+    const int h = (job->h + 1) / 2;
+    const int strip_rows = s->strip_rows;
+    const bool keep = job->i4_dis_dst != NULL;
+
+    // the window holds rows [buf_row, buf_row + strip_rows + 2) of the
+    // output of the scale, of which rows [buf_row, next) are done
+    int buf_row = row_begin ? row_begin - 1 : 0;
+    int next = buf_row;
+
+    for (int r0 = row_begin, r1; r0 < (int) row_end; r0 = r1) {
+        r1 = MIN(r0 + strip_rows, (int) row_end);
+        const int last = MIN(r1 + 1, h);
+
+        // cm of rows [r0, r1) reads rows [r0 - 1, r1 + 1), of which the
+        // first two are done by the previous strip
+        if (last - buf_row > strip_rows + 2) {
+            adm_window_slide(win, scale, stride, next - 2 - buf_row);
+            buf_row = next - 2;
+        }
+
+        // band a of the rows of the neighbouring bands stays in the window
+        const int own_begin = MAX(next, (int) row_begin);
+        const int own_end = MIN(last, (int) row_end);
+        adm_dwt2_rows(job, win, buf_row, next, own_begin, false);
+        adm_dwt2_rows(job, win, buf_row, own_begin, own_end, keep);
+        adm_dwt2_rows(job, win, buf_row, own_end, last, false);
+
+        // the reference planes of the strip, from the shared reference if
+        // there is one
+        AdmBuffer ref_view = *win;
+        if (job->ref_dwt && scale == 0) {
+            ref_view.ref_dwt2 = adm_band_at(&job->ref_dwt->s0,
+                                            buf_row * stride);
+        }
+        else if (job->ref_dwt) {
+            ref_view.i4_ref_dwt2 =
+                i4_adm_band_at(&job->ref_dwt->s123[scale - 1],
+                               buf_row * stride);
+        }
+
+        if (scale == 0) {
+            adm_decouple(s, &ref_view, w, h, stride, buf_row, next, last,
+                         s->adm_enhn_gain_limit);
+            adm_csf_den_scale(s, &ref_view.ref_dwt2, w, h, stride, buf_row,
+                              own_begin, own_end, s->band_den[band]);
+            adm_csf(s, win, w, h, stride, buf_row, next, last,
+                    s->adm_norm_view_dist, s->adm_ref_display_height);
+            adm_cm(s, win, w, h, stride, stride, buf_row, r0, r1,
+                   s->band_num[band], s->adm_norm_view_dist,
+                   s->adm_ref_display_height);
+        }
+        else {
+            adm_decouple_s123(s, &ref_view, w, h, stride, buf_row, next, last,
+                              s->adm_enhn_gain_limit);
+            adm_csf_den_s123(s, &ref_view.i4_ref_dwt2, scale, w, h, stride,
+                             buf_row, own_begin, own_end, s->band_den[band]);
+            i4_adm_csf(s, win, scale, w, h, stride, buf_row, next, last,
+                       s->adm_norm_view_dist, s->adm_ref_display_height);
+            i4_adm_cm(s, win, w, h, stride, stride, buf_row, scale, r0, r1,
+                      s->band_num[band], s->adm_norm_view_dist,
+                      s->adm_ref_display_height);
+        }
+
+        next = last;
+    }
+}
+
+int integer_compute_adm(VmafFeatureExtractor *fex, VmafPicture *ref_pic,
+                        VmafPicture *dis_pic, double *score,
+                        double *score_num, double *score_den, double *scores)
+{
+    AdmState *s = fex->priv;
+    AdmBuffer *buf = &s->buf;
+    int err = 0;
+
+    int w = ref_pic->w[0];
+    int h = ref_pic->h[0];
+
+    const double numden_limit = 1e-10 * (w * h) / (1920.0 * 1080.0);
+
+    AdmBandJob job = {
+        .s = s,
+        .ref_pic = ref_pic,
+        .dis_pic = dis_pic,
+        .buf_stride = buf->ind_size_x >> 2,
+    };
+
+    // keeping the dwt of the reference whole only pays off when several
+    // contexts read it, otherwise it is done strip by strip like the rest
+    AdmRefDwt ref_dwt;
+    if (vmaf_picture_cache_shared(ref_pic)) {
+        const void *data =
+            vmaf_picture_cache_get(ref_pic, VMAF_PICTURE_CACHE_ADM_REF_DWT, 0,
+                                   adm_ref_dwt_sz(s), fill_ref_dwt, fex);
+        if (!data) return -ENOMEM;
+        ref_dwt = adm_ref_dwt_at(s, data);
+        job.ref_dwt = &ref_dwt;
+    }
+
+    double num = 0;
+    double den = 0;
+	for (unsigned scale = 0; scale < 4; ++scale) {
+		float num_scale = 0.0;
+		float den_scale = 0.0;
+
+        dwt2_src_indices_filt(buf->ind_y, buf->ind_x, w, h);
+        job.scale = scale;
+        job.w = w;
+        job.h = h;
+        // band a goes to the half and the quarter resolution planes in turn
+        job.i4_ref_dst = scale < 3 && !job.ref_dwt ?
+                         s->i4_ref_a[scale % 2] : NULL;
+        job.i4_dis_dst = scale < 3 ? s->i4_dis_a[scale % 2] : NULL;
+
+		w = (w + 1) / 2;
+		h = (h + 1) / 2;
+
+        memset(s->band_den, 0, sizeof(*s->band_den) * s->band_cnt);
+        memset(s->band_num, 0, sizeof(*s->band_num) * s->band_cnt);
+        err = vmaf_feature_extractor_run_bands(fex, h, s->band_cnt,
+                                               adm_scale_band, &job);
+        if (err) return err;
+
+        uint64_t accum_den[3] = { 0 };
+        int64_t accum_num[3] = { 0 };
+        for (unsigned i = 0; i < s->band_cnt; i++) {
+            for (unsigned j = 0; j < 3; j++) {
+                accum_den[j] += s->band_den[i][j];
+                accum_num[j] += s->band_num[i][j];
+            }
+        }
+
+		if(scale==0) {
+			den_scale = adm_csf_den_scale_score(accum_den, w, h,
+                                 s->adm_norm_view_dist, s->adm_ref_display_height);
+			num_scale = adm_cm_score(accum_num, w, h);
+		}
+		else {
+			den_scale = adm_csf_den_s123_score(accum_den, scale, w, h,
+			        s->adm_norm_view_dist, s->adm_ref_display_height);
+			num_scale = i4_adm_cm_score(accum_num, w, h, scale);
+		}
+
+		num += num_scale;
+		den += den_scale;
+
+        job.i4_ref_src = job.i4_ref_dst;
+        job.i4_dis_src = job.i4_dis_dst;
+
+		scores[2 * scale + 0] = num_scale;
+		scores[2 * scale + 1] = den_scale;
+	}
+
+	num = num < numden_limit ? 0 : num;
+	den = den < numden_limit ? 0 : den;
+
+	if (den == 0.0) {
+		*score = 1.0f;
+	}
+	else {
+		*score = num / den;
+	}
+    *score_num = num;
+    *score_den = den;
+
+    return 0;
+}
+
 static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
                 unsigned bpc, unsigned w, unsigned h)
 {
@@ -2592,54 +2718,145 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
         return -EINVAL;
     }
 
-    s->dwt2_8 = adm_dwt2_8;
+    s->dwt2_8_vert = adm_dwt2_8_vert;
+    s->dwt2_16_vert = adm_dwt2_16_vert;
+    s->dwt2_16_hori = adm_dwt2_16_hori;
+    s->dwt2_s123_vert = adm_dwt2_s123_vert;
+    s->dwt2_s123_hori = adm_dwt2_s123_hori;
+    s->decouple_row = adm_decouple_row;
+    s->i4_decouple_row = i4_adm_decouple_row;
+    s->csf_row = adm_csf_row;
+    s->i4_csf_row = i4_adm_csf_row;
+    s->csf_den_row = adm_csf_den_row;
+    s->csf_den_s123_row = adm_csf_den_s123_row;
+    s->cm_row = adm_cm_row;
+    s->i4_cm_row = i4_adm_cm_row;
 
 #if ARCH_X86
     unsigned flags = vmaf_get_cpu_flags();
     if (flags & VMAF_X86_CPU_FLAG_AVX2) {
-        if (!(w % 8)) s->dwt2_8 = adm_dwt2_8_avx2;
+        s->dwt2_8_vert = adm_dwt2_8_vert_avx2;
+        s->dwt2_16_vert = adm_dwt2_16_vert_avx2;
+        s->dwt2_16_hori = adm_dwt2_16_hori_avx2;
+        s->dwt2_s123_vert = adm_dwt2_s123_vert_avx2;
+        s->dwt2_s123_hori = adm_dwt2_s123_hori_avx2;
+        s->decouple_row = adm_decouple_row_avx2;
+        s->i4_decouple_row = i4_adm_decouple_row_avx2;
+        s->csf_row = adm_csf_row_avx2;
+        s->i4_csf_row = i4_adm_csf_row_avx2;
+        s->csf_den_row = adm_csf_den_row_avx2;
+        s->csf_den_s123_row = adm_csf_den_s123_row_avx2;
+        s->cm_row = adm_cm_row_avx2;
+        s->i4_cm_row = i4_adm_cm_row_avx2;
+    }
+#if HAVE_AVX512
+    if (flags & VMAF_X86_CPU_FLAG_AVX512) {
+        s->dwt2_8_vert = adm_dwt2_8_vert_avx512;
+        s->dwt2_16_vert = adm_dwt2_16_vert_avx512;
+        s->dwt2_16_hori = adm_dwt2_16_hori_avx512;
+        s->dwt2_s123_vert = adm_dwt2_s123_vert_avx512;
+        s->dwt2_s123_hori = adm_dwt2_s123_hori_avx512;
+        s->decouple_row = adm_decouple_row_avx512;
+        s->i4_decouple_row = i4_adm_decouple_row_avx512;
+        s->csf_row = adm_csf_row_avx512;
+        s->i4_csf_row = i4_adm_csf_row_avx512;
+        s->csf_den_row = adm_csf_den_row_avx512;
+        s->csf_den_s123_row = adm_csf_den_s123_row_avx512;
+        s->cm_row = adm_cm_row_avx512;
+        s->i4_cm_row = i4_adm_cm_row_avx512;
     }
+#endif
 #elif ARCH_AARCH64
     unsigned flags = vmaf_get_cpu_flags();
     if (flags & VMAF_ARM_CPU_FLAG_NEON) {
-        if (!(w % 8)) s->dwt2_8 = adm_dwt2_8_neon;
+        s->dwt2_8_vert = adm_dwt2_8_vert_neon;
+        s->dwt2_16_vert = adm_dwt2_16_vert_neon;
+        s->dwt2_16_hori = adm_dwt2_16_hori_neon;
+        s->dwt2_s123_vert = adm_dwt2_s123_vert_neon;
+        s->dwt2_s123_hori = adm_dwt2_s123_hori_neon;
+        s->decouple_row = adm_decouple_row_neon;
+        s->i4_decouple_row = i4_adm_decouple_row_neon;
+        s->csf_row = adm_csf_row_neon;
+        s->i4_csf_row = i4_adm_csf_row_neon;
+        s->csf_den_row = adm_csf_den_row_neon;
+        s->csf_den_s123_row = adm_csf_den_s123_row_neon;
+        s->cm_row = adm_cm_row_neon;
+        s->i4_cm_row = i4_adm_cm_row_neon;
     }
 #endif
 
     s->integer_stride   = ALIGN_CEIL(w * sizeof(int32_t));
     s->buf.ind_size_x   = ALIGN_CEIL(((w + 1) / 2) * sizeof(int32_t));
     s->buf.ind_size_y   = ALIGN_CEIL(((h + 1) / 2) * sizeof(int32_t));
-    size_t buf_sz_one   = s->buf.ind_size_x * ((h + 1) / 2);
+    size_t buf_sz_half  = s->buf.ind_size_x * ((h + 1) / 2);
+    size_t buf_sz_quart = s->buf.ind_size_x * ((h + 3) / 4);
+    s->h = h;
 
-    s->buf.data_buf     = aligned_malloc(buf_sz_one * NUM_BUFS_ADM, MAX_ALIGN);
+    s->buf.data_buf     = aligned_malloc((buf_sz_half + buf_sz_quart) * 2,
+                                         MAX_ALIGN);
     if (!s->buf.data_buf) goto fail;
-    s->buf.tmp_ref      = aligned_malloc(s->integer_stride * 4, MAX_ALIGN);
-    if (!s->buf.tmp_ref) goto fail;
     s->buf.buf_x_orig   = aligned_malloc(s->buf.ind_size_x * 4, MAX_ALIGN);
     if (!s->buf.buf_x_orig) goto fail;
     s->buf.buf_y_orig   = aligned_malloc(s->buf.ind_size_y * 4, MAX_ALIGN);
     if (!s->buf.buf_y_orig) goto fail;
 
-    void *data_top = s->buf.data_buf;
-    data_top = init_dwt_band(&s->buf.ref_dwt2, data_top, buf_sz_one / 2);
-    data_top = init_dwt_band(&s->buf.dis_dwt2, data_top, buf_sz_one / 2);
-    data_top = init_dwt_band_hvd(&s->buf.decouple_r, data_top, buf_sz_one / 2);
-    data_top = init_dwt_band_hvd(&s->buf.decouple_a, data_top, buf_sz_one / 2);
-    data_top = init_dwt_band_hvd(&s->buf.csf_a, data_top, buf_sz_one / 2);
-    data_top = init_dwt_band_hvd(&s->buf.csf_f, data_top, buf_sz_one / 2);
-
-    data_top = i4_init_dwt_band(&s->buf.i4_ref_dwt2, data_top, buf_sz_one);
-    data_top = i4_init_dwt_band(&s->buf.i4_dis_dwt2, data_top, buf_sz_one);
-    data_top = i4_init_dwt_band_hvd(&s->buf.i4_decouple_r, data_top, buf_sz_one);
-    data_top = i4_init_dwt_band_hvd(&s->buf.i4_decouple_a, data_top, buf_sz_one);
-    data_top = i4_init_dwt_band_hvd(&s->buf.i4_csf_a, data_top, buf_sz_one);
-    data_top = i4_init_dwt_band_hvd(&s->buf.i4_csf_f, data_top, buf_sz_one);
-
     void *ind_buf_y = s->buf.buf_y_orig;
     init_index(s->buf.ind_y, ind_buf_y, s->buf.ind_size_y);
     void *ind_buf_x = s->buf.buf_x_orig;
     init_index(s->buf.ind_x, ind_buf_x, s->buf.ind_size_x);
 
+    char *data_top = s->buf.data_buf;
+    s->i4_ref_a[0] = (int32_t *)data_top; data_top += buf_sz_half;
+    s->i4_dis_a[0] = (int32_t *)data_top; data_top += buf_sz_half;
+    s->i4_ref_a[1] = (int32_t *)data_top; data_top += buf_sz_quart;
+    s->i4_dis_a[1] = (int32_t *)data_top; data_top += buf_sz_quart;
+
+    s->band_cnt = vmaf_feature_extractor_band_cnt(fex, (h + 1) / 2);
+    s->band_den = malloc(sizeof(*s->band_den) * s->band_cnt);
+    if (!s->band_den) goto fail;
+    s->band_num = malloc(sizeof(*s->band_num) * s->band_cnt);
+    if (!s->band_num) goto fail;
+    s->band_buf = calloc(s->band_cnt, sizeof(*s->band_buf));
+    if (!s->band_buf) goto fail;
+
+    // the rows of scale 0 are the widest, 16 bits for each of the planes
+    s->strip_rows = ADM_STRIP_BYTES /
+                    (ADM_WINDOW_PLANES * (s->buf.ind_size_x / 2));
+    s->strip_rows = MAX(s->strip_rows, ADM_STRIP_ROWS_MIN);
+    s->strip_rows = MIN(s->strip_rows, ADM_STRIP_ROWS_MAX);
+    const size_t win_sz_one = s->buf.ind_size_x * (s->strip_rows + 3);
+
+    for (unsigned i = 0; i < s->band_cnt; i++) {
+        AdmBuffer *win = &s->band_buf[i];
+        memcpy(win->ind_y, s->buf.ind_y, sizeof(win->ind_y));
+        memcpy(win->ind_x, s->buf.ind_x, sizeof(win->ind_x));
+        win->ind_size_x = s->buf.ind_size_x;
+        win->ind_size_y = s->buf.ind_size_y;
+        win->data_buf = aligned_malloc(win_sz_one * ADM_WINDOW_PLANES,
+                                       MAX_ALIGN);
+        if (!win->data_buf) goto fail;
+        win->tmp_ref = aligned_malloc(s->integer_stride * 4, MAX_ALIGN);
+        if (!win->tmp_ref) goto fail;
+
+        // 16 bit planes for scale 0 and 32 bit planes for scales 1-3
+        // share the memory of the window
+        void *win_top = win->data_buf;
+        win_top = init_dwt_band(&win->ref_dwt2, win_top, win_sz_one);
+        win_top = init_dwt_band(&win->dis_dwt2, win_top, win_sz_one);
+        win_top = init_dwt_band_hvd(&win->decouple_r, win_top, win_sz_one);
+        win_top = init_dwt_band_hvd(&win->decouple_a, win_top, win_sz_one);
+        win_top = init_dwt_band_hvd(&win->csf_a, win_top, win_sz_one);
+        win_top = init_dwt_band_hvd(&win->csf_f, win_top, win_sz_one);
+
+        win_top = win->data_buf;
+        win_top = i4_init_dwt_band(&win->i4_ref_dwt2, win_top, win_sz_one);
+        win_top = i4_init_dwt_band(&win->i4_dis_dwt2, win_top, win_sz_one);
+        win_top = i4_init_dwt_band_hvd(&win->i4_decouple_r, win_top, win_sz_one);
+        win_top = i4_init_dwt_band_hvd(&win->i4_decouple_a, win_top, win_sz_one);
+        win_top = i4_init_dwt_band_hvd(&win->i4_csf_a, win_top, win_sz_one);
+        win_top = i4_init_dwt_band_hvd(&win->i4_csf_f, win_top, win_sz_one);
+    }
+
     div_lookup_generator();
 
     s->feature_name_dict =
@@ -2651,13 +2868,36 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
 
 fail:
     if (s->buf.data_buf)    aligned_free(s->buf.data_buf);
-    if (s->buf.tmp_ref)     aligned_free(s->buf.tmp_ref);
     if (s->buf.buf_x_orig)  aligned_free(s->buf.buf_x_orig);
     if (s->buf.buf_y_orig)  aligned_free(s->buf.buf_y_orig);
+    for (unsigned i = 0; s->band_buf && i < s->band_cnt; i++) {
+        if (s->band_buf[i].data_buf) aligned_free(s->band_buf[i].data_buf);
+        if (s->band_buf[i].tmp_ref)  aligned_free(s->band_buf[i].tmp_ref);
+    }
+    free(s->band_buf);
+    free(s->band_den);
+    free(s->band_num);
     vmaf_dictionary_free(&s->feature_name_dict);
     return -ENOMEM;
 }
 
+static int register_features(VmafFeatureCollector *feature_collector,
+                             AdmState *s)
+{
+    if (s->feature_collector == feature_collector) return 0;
+
+    const unsigned cnt = s->debug ? 16 : 5;
+    for (unsigned i = 0; i < cnt; i++) {
+        int err = vmaf_feature_collector_register_with_dict(feature_collector,
+                        s->feature_name_dict, adm_feature_name[i],
+                        &s->feature_id[i]);
+        if (err) return err;
+    }
+
+    s->feature_collector = feature_collector;
+    return 0;
+}
+
 static int extract(VmafFeatureExtractor *fex,
                    VmafPicture *ref_pic, VmafPicture *ref_pic_90,
                    VmafPicture *dist_pic, VmafPicture *dist_pic_90,
@@ -2679,65 +2919,36 @@ static int extract(VmafFeatureExtractor *fex,
         return -EINVAL;
     }
 
-    integer_compute_adm(s, ref_pic, dist_pic, &score, &score_num, &score_den,
-                        scores, &s->buf,
-                        s->adm_enhn_gain_limit,
-                        s->adm_norm_view_dist, s->adm_ref_display_height);
+    err = integer_compute_adm(fex, ref_pic, dist_pic, &score, &score_num,
+                              &score_den, scores);
+    if (err) return err;
 
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "VMAF_integer_feature_adm2_score", score,
-            index);
+    err = register_features(feature_collector, s);
+    if (err) return err;
 
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_scale0", scores[0] / scores[1],
-            index);
+    const unsigned *id = s->feature_id;
 
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_scale1", scores[2] / scores[3],
-            index);
+    err |= vmaf_feature_collector_append_by_id(feature_collector, id[0],
+                                               score, index);
 
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_scale2", scores[4] / scores[5],
-            index);
-
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_scale3", scores[6] / scores[7],
-            index);
+    for (unsigned i = 0; i < 4; i++) {
+        err |= vmaf_feature_collector_append_by_id(feature_collector,
+                id[1 + i], scores[2 * i] / scores[2 * i + 1], index);
+    }
 
     if (!s->debug) return err;
 
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm", score, index);
-
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_num", score_num, index);
-
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_den", score_den, index);
-
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_num_scale0", scores[0], index);
-
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_den_scale0", scores[1], index);
-
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_num_scale1", scores[2], index);
+    err |= vmaf_feature_collector_append_by_id(feature_collector, id[5],
+                                               score, index);
+    err |= vmaf_feature_collector_append_by_id(feature_collector, id[6],
+                                               score_num, index);
+    err |= vmaf_feature_collector_append_by_id(feature_collector, id[7],
+                                               score_den, index);
 
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_den_scale1", scores[3], index);
-
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_num_scale2", scores[4], index);
-
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_den_scale2", scores[5], index);
-
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_num_scale3", scores[6], index);
-
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_adm_den_scale3", scores[7], index);
+    for (unsigned i = 0; i < 8; i++) {
+        err |= vmaf_feature_collector_append_by_id(feature_collector,
+                id[8 + i], scores[i], index);
+    }
 
     return err;
 }
@@ -2747,9 +2958,15 @@ static int close(VmafFeatureExtractor *fex)
     AdmState *s = fex->priv;
 
     if (s->buf.data_buf)    aligned_free(s->buf.data_buf);
-    if (s->buf.tmp_ref)     aligned_free(s->buf.tmp_ref);
     if (s->buf.buf_x_orig)  aligned_free(s->buf.buf_x_orig);
     if (s->buf.buf_y_orig)  aligned_free(s->buf.buf_y_orig);
+    for (unsigned i = 0; s->band_buf && i < s->band_cnt; i++) {
+        if (s->band_buf[i].data_buf) aligned_free(s->band_buf[i].data_buf);
+        if (s->band_buf[i].tmp_ref)  aligned_free(s->band_buf[i].tmp_ref);
+    }
+    free(s->band_buf);
+    free(s->band_den);
+    free(s->band_num);
     vmaf_dictionary_free(&s->feature_name_dict);
 
     return 0;
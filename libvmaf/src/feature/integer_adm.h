@@ -6,9 +6,10 @@
 #include <errno.h>
 #include <math.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
-static int32_t div_lookup[65537];
+extern int32_t div_lookup[65537];
 static const int32_t div_Q_factor = 1073741824; // 2^30
 
 static inline void div_lookup_generator() {
@@ -56,10 +57,6 @@ typedef struct AdmBuffer {
     i4_adm_dwt_band_t i4_csf_f;
 } AdmBuffer;
 
-#ifndef NUM_BUFS_ADM
-#define NUM_BUFS_ADM 30
-#endif
-
 #ifndef M_PI
 #define M_PI 3.14159265358979323846264338327
 #endif // M_PI
@@ -155,4 +152,450 @@ static const float dwt_7_9_basis_function_amplitudes[6][4] = {
     {0.045943, 0.059758, 0.077727, 0.059758},
     {0.023013, 0.030018, 0.039156, 0.030018}};
 
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#define MAX(x, y) (((x) > (y)) ? (x) : (y))
+
+/* ================================================ */
+/* Per-pixel kernels, shared by the scalar code and */
+/* the columns the SIMD kernels leave over          */
+/* ================================================ */
+
+/* Vertical pass of adm_dwt2_8() for column j of output row i. */
+static inline void adm_dwt2_8_vert_px(const uint8_t *src, int **ind_y, int i,
+                                      int j, int src_stride, int16_t *tmplo,
+                                      int16_t *tmphi)
+{
+    const int16_t *filter_lo = dwt2_db2_coeffs_lo;
+    const int16_t *filter_hi = dwt2_db2_coeffs_hi;
+    const int16_t shift_VP = 8;
+    const int32_t add_shift_VP = 128;
+
+    uint16_t u_s0 = src[ind_y[0][i] * src_stride + j];
+    uint16_t u_s1 = src[ind_y[1][i] * src_stride + j];
+    uint16_t u_s2 = src[ind_y[2][i] * src_stride + j];
+    uint16_t u_s3 = src[ind_y[3][i] * src_stride + j];
+
+    int32_t accum = 0;
+    accum += (int32_t)filter_lo[0] * (int32_t)u_s0;
+    accum += (int32_t)filter_lo[1] * (int32_t)u_s1;
+    accum += (int32_t)filter_lo[2] * (int32_t)u_s2;
+    accum += (int32_t)filter_lo[3] * (int32_t)u_s3;
+
+    /* normalizing is done for range from(0 to N) to (-N/2 to N/2) */
+    accum -= (int32_t)dwt2_db2_coeffs_lo_sum * add_shift_VP;
+
+    tmplo[j] = (accum + add_shift_VP) >> shift_VP;
+
+    accum = 0;
+    accum += (int32_t)filter_hi[0] * (int32_t)u_s0;
+    accum += (int32_t)filter_hi[1] * (int32_t)u_s1;
+    accum += (int32_t)filter_hi[2] * (int32_t)u_s2;
+    accum += (int32_t)filter_hi[3] * (int32_t)u_s3;
+
+    /* normalizing is done for range from(0 to N) to (-N/2 to N/2) */
+    accum -= (int32_t)dwt2_db2_coeffs_hi_sum * add_shift_VP;
+
+    tmphi[j] = (accum + add_shift_VP) >> shift_VP;
+}
+
+/* Vertical pass of adm_dwt2_16() for column j of output row i. */
+static inline void adm_dwt2_16_vert_px(const uint16_t *src, int **ind_y,
+                                       int i, int j, int src_stride,
+                                       int inp_size_bits, int16_t *tmplo,
+                                       int16_t *tmphi)
+{
+    const int16_t *filter_lo = dwt2_db2_coeffs_lo;
+    const int16_t *filter_hi = dwt2_db2_coeffs_hi;
+    const int16_t shift_VP = inp_size_bits;
+    const int32_t add_shift_VP = 1 << (inp_size_bits - 1);
+
+    uint16_t u_s0 = src[ind_y[0][i] * src_stride + j];
+    uint16_t u_s1 = src[ind_y[1][i] * src_stride + j];
+    uint16_t u_s2 = src[ind_y[2][i] * src_stride + j];
+    uint16_t u_s3 = src[ind_y[3][i] * src_stride + j];
+
+    int32_t accum = 0;
+    accum += (int32_t)filter_lo[0] * (int32_t)u_s0;
+    accum += (int32_t)filter_lo[1] * (int32_t)u_s1;
+    accum += (int32_t)filter_lo[2] * (int32_t)u_s2;
+    accum += (int32_t)filter_lo[3] * (int32_t)u_s3;
+
+    /* normalizing is done for range from(0 to N) to (-N/2 to N/2) */
+    accum -= (int32_t)dwt2_db2_coeffs_lo_sum * add_shift_VP;
+
+    tmplo[j] = (accum + add_shift_VP) >> shift_VP;
+
+    accum = 0;
+    accum += (int32_t)filter_hi[0] * (int32_t)u_s0;
+    accum += (int32_t)filter_hi[1] * (int32_t)u_s1;
+    accum += (int32_t)filter_hi[2] * (int32_t)u_s2;
+    accum += (int32_t)filter_hi[3] * (int32_t)u_s3;
+
+    /* normalizing is done for range from(0 to N) to (-N/2 to N/2) */
+    accum -= (int32_t)dwt2_db2_coeffs_hi_sum * add_shift_VP;
+
+    tmphi[j] = (accum + add_shift_VP) >> shift_VP;
+}
+
+/* Horizontal pass of adm_dwt2_16() for column j, dst points at its row. */
+static inline void adm_dwt2_16_hori_px(const int16_t *tmplo,
+                                       const int16_t *tmphi, int **ind_x,
+                                       int j, const adm_dwt_band_t *dst,
+                                       size_t offset)
+{
+    const int16_t *filter_lo = dwt2_db2_coeffs_lo;
+    const int16_t *filter_hi = dwt2_db2_coeffs_hi;
+    const int16_t shift_HP = 16;
+    const int32_t add_shift_HP = 32768;
+
+    int j0 = ind_x[0][j];
+    int j1 = ind_x[1][j];
+    int j2 = ind_x[2][j];
+    int j3 = ind_x[3][j];
+
+    int16_t s0 = tmplo[j0];
+    int16_t s1 = tmplo[j1];
+    int16_t s2 = tmplo[j2];
+    int16_t s3 = tmplo[j3];
+
+    int32_t accum = 0;
+    accum += (int32_t)filter_lo[0] * s0;
+    accum += (int32_t)filter_lo[1] * s1;
+    accum += (int32_t)filter_lo[2] * s2;
+    accum += (int32_t)filter_lo[3] * s3;
+    dst->band_a[offset + j] = (accum + add_shift_HP) >> shift_HP;
+
+    accum = 0;
+    accum += (int32_t)filter_hi[0] * s0;
+    accum += (int32_t)filter_hi[1] * s1;
+    accum += (int32_t)filter_hi[2] * s2;
+    accum += (int32_t)filter_hi[3] * s3;
+    dst->band_v[offset + j] = (accum + add_shift_HP) >> shift_HP;
+
+    s0 = tmphi[j0];
+    s1 = tmphi[j1];
+    s2 = tmphi[j2];
+    s3 = tmphi[j3];
+
+    accum = 0;
+    accum += (int32_t)filter_lo[0] * s0;
+    accum += (int32_t)filter_lo[1] * s1;
+    accum += (int32_t)filter_lo[2] * s2;
+    accum += (int32_t)filter_lo[3] * s3;
+    dst->band_h[offset + j] = (accum + add_shift_HP) >> shift_HP;
+
+    accum = 0;
+    accum += (int32_t)filter_hi[0] * s0;
+    accum += (int32_t)filter_hi[1] * s1;
+    accum += (int32_t)filter_hi[2] * s2;
+    accum += (int32_t)filter_hi[3] * s3;
+    dst->band_d[offset + j] = (accum + add_shift_HP) >> shift_HP;
+}
+
+/*
+ * Vertical pass of adm_dwt2_s123_combined() for column j of output row i,
+ * add and shift are the rounding of the pass at the current scale.
+ */
+static inline void adm_dwt2_s123_vert_px(const int32_t *src, int **ind_y,
+                                         int i, int j, int src_stride,
+                                         int32_t add, int16_t shift,
+                                         int32_t *tmplo, int32_t *tmphi)
+{
+    const int16_t *filter_lo = dwt2_db2_coeffs_lo;
+    const int16_t *filter_hi = dwt2_db2_coeffs_hi;
+
+    int32_t s10 = src[ind_y[0][i] * src_stride + j];
+    int32_t s11 = src[ind_y[1][i] * src_stride + j];
+    int32_t s12 = src[ind_y[2][i] * src_stride + j];
+    int32_t s13 = src[ind_y[3][i] * src_stride + j];
+
+    int64_t accum = 0;
+    accum += (int64_t)filter_lo[0] * s10;
+    accum += (int64_t)filter_lo[1] * s11;
+    accum += (int64_t)filter_lo[2] * s12;
+    accum += (int64_t)filter_lo[3] * s13;
+    tmplo[j] = (int32_t)((accum + add) >> shift);
+
+    accum = 0;
+    accum += (int64_t)filter_hi[0] * s10;
+    accum += (int64_t)filter_hi[1] * s11;
+    accum += (int64_t)filter_hi[2] * s12;
+    accum += (int64_t)filter_hi[3] * s13;
+    tmphi[j] = (int32_t)((accum + add) >> shift);
+}
+
+/* Horizontal pass of adm_dwt2_s123_combined() for column j. */
+static inline void adm_dwt2_s123_hori_px(const int32_t *tmplo,
+                                         const int32_t *tmphi, int **ind_x,
+                                         int j, const i4_adm_dwt_band_t *dst,
+                                         size_t offset, int32_t add,
+                                         int16_t shift)
+{
+    const int16_t *filter_lo = dwt2_db2_coeffs_lo;
+    const int16_t *filter_hi = dwt2_db2_coeffs_hi;
+
+    int j0 = ind_x[0][j];
+    int j1 = ind_x[1][j];
+    int j2 = ind_x[2][j];
+    int j3 = ind_x[3][j];
+
+    int32_t s10 = tmplo[j0];
+    int32_t s11 = tmplo[j1];
+    int32_t s12 = tmplo[j2];
+    int32_t s13 = tmplo[j3];
+
+    int64_t accum = 0;
+    accum += (int64_t)filter_lo[0] * s10;
+    accum += (int64_t)filter_lo[1] * s11;
+    accum += (int64_t)filter_lo[2] * s12;
+    accum += (int64_t)filter_lo[3] * s13;
+    dst->band_a[offset + j] = (int32_t)((accum + add) >> shift);
+
+    accum = 0;
+    accum += (int64_t)filter_hi[0] * s10;
+    accum += (int64_t)filter_hi[1] * s11;
+    accum += (int64_t)filter_hi[2] * s12;
+    accum += (int64_t)filter_hi[3] * s13;
+    dst->band_v[offset + j] = (int32_t)((accum + add) >> shift);
+
+    s10 = tmphi[j0];
+    s11 = tmphi[j1];
+    s12 = tmphi[j2];
+    s13 = tmphi[j3];
+
+    accum = 0;
+    accum += (int64_t)filter_lo[0] * s10;
+    accum += (int64_t)filter_lo[1] * s11;
+    accum += (int64_t)filter_lo[2] * s12;
+    accum += (int64_t)filter_lo[3] * s13;
+    dst->band_h[offset + j] = (int32_t)((accum + add) >> shift);
+
+    accum = 0;
+    accum += (int64_t)filter_hi[0] * s10;
+    accum += (int64_t)filter_hi[1] * s11;
+    accum += (int64_t)filter_hi[2] * s12;
+    accum += (int64_t)filter_hi[3] * s13;
+    dst->band_d[offset + j] = (int32_t)((accum + add) >> shift);
+}
+
+/*
+ * Determine if angle between (oh,ov) and (th,tv) is less than 1 degree.
+ * Given that u is the angle (oh,ov) and v is the angle (th,tv), this can
+ * be done by testing the inequvality.
+ *
+ * { (u.v.) >= 0 } AND { (u.v)^2 >= cos(1deg)^2 * ||u||^2 * ||v||^2 }
+ *
+ * Proof:
+ *
+ * cos(theta) = (u.v) / (||u|| * ||v||)
+ *
+ * IF u.v >= 0 THEN
+ *   cos(theta)^2 = (u.v)^2 / (||u||^2 * ||v||^2)
+ *   (u.v)^2 = cos(theta)^2 * ||u||^2 * ||v||^2
+ *
+ *   IF |theta| < 1deg THEN
+ *     (u.v)^2 >= cos(1deg)^2 * ||u||^2 * ||v||^2
+ *   END
+ * ELSE
+ *   |theta| > 90deg
+ * END
+ *
+ * angle_flag is calculated in floating-point by converting fixed-point
+ * variables back to floating-point
+ */
+static inline int adm_decouple_angle_flag(int32_t oh, int32_t ov, int32_t th,
+                                          int32_t tv, float cos_1deg_sq)
+{
+    const int64_t ot_dp = (int64_t)oh * th + (int64_t)ov * tv;
+    const int64_t o_mag_sq = (int64_t)oh * oh + (int64_t)ov * ov;
+    const int64_t t_mag_sq = (int64_t)th * th + (int64_t)tv * tv;
+
+    return (((float)ot_dp / 4096.0) >= 0.0f) &&
+        (((float)ot_dp / 4096.0) * ((float)ot_dp / 4096.0) >=
+            cos_1deg_sq * ((float)o_mag_sq / 4096.0) * ((float)t_mag_sq / 4096.0));
+}
+
+/* Decouples one band of one pixel of scale 0 into restored and additive. */
+static inline void adm_decouple_px(int16_t o, int16_t t, int angle_flag,
+                                   double adm_enhn_gain_limit, int16_t *r,
+                                   int16_t *a)
+{
+    /**
+     * Division t/o is carried using lookup table and converted to multiplication
+     */
+    int32_t tmp_k = (o == 0) ?
+        32768 : (((int64_t)div_lookup[o + 32768] * t) + 16384) >> 15;
+    int32_t k = tmp_k < 0 ? 0 : (tmp_k > 32768 ? 32768 : tmp_k);
+
+    /**
+     * k is in Q15 type and o is in Q16 type hence shifted by
+     * 15 to make result Q16
+     */
+    int16_t rst = ((k * o) + 16384) >> 15;
+    const float rst_f = ((float)k / 32768) * ((float)o / 64);
+
+    if (angle_flag && (rst_f > 0.)) rst = MIN((rst * adm_enhn_gain_limit), t);
+    if (angle_flag && (rst_f < 0.)) rst = MAX((rst * adm_enhn_gain_limit), t);
+
+    *r = rst;
+    *a = t - rst;
+}
+
+static inline uint16_t get_best15_from32(uint32_t temp, int *x)
+{
+    int k = __builtin_clz(temp);    //built in for intel
+    k = 17 - k;
+    temp = (temp + (1 << (k - 1))) >> k;
+    *x = k;
+    return temp;
+}
+
+/* Decouples one band of one pixel of scales 1-3. */
+static inline void i4_adm_decouple_px(int32_t o, int32_t t, int angle_flag,
+                                      double adm_enhn_gain_limit, int32_t *r,
+                                      int32_t *a)
+{
+    /**
+     * Division t/o is carried using lookup table and converted to multiplication
+     * int64 / int32 is converted to multiplication using following method
+     * num /den :
+     * DenAbs = Abs(den)
+     * MSBDen = MSB(DenAbs)     (gives position of first 1 bit form msb side)
+     * If (DenAbs < (1 << 15))
+     *      Round = (1<<14)
+     *      Score = (num *  div_lookup[den] + Round ) >> 15
+     * else
+     *      RoundD  = (1<< (16 - MSBDen))
+     *      Round   = (1<< (14 + (17 - MSBDen))
+     *      Score   = (num * div_lookup[(DenAbs + RoundD )>>(17 - MSBDen)]*sign(Denominator) + Round)
+     *                  >> ((15 + (17 - MSBDen))
+     */
+    int32_t k_shift = 0;
+    uint32_t abs_o = abs(o);
+    int8_t k_sign = (o < 0 ? -1 : 1);
+    uint16_t k_msb = (abs_o < (32768) ? abs_o : get_best15_from32(abs_o, &k_shift));
+
+    int64_t tmp_k = (o == 0) ? 32768 : (((int64_t)div_lookup[k_msb + 32768] * t)*(k_sign) +
+        (1 << (14 + k_shift))) >> (15 + k_shift);
+    int64_t k = tmp_k < 0 ? 0 : (tmp_k > 32768 ? 32768 : tmp_k);
+
+    int32_t rst = ((k * o) + 16384) >> 15;
+    const float rst_f = ((float)k / 32768) * ((float)o / 64);
+
+    if (angle_flag && (rst_f > 0.)) rst = MIN((rst * adm_enhn_gain_limit), t);
+    if (angle_flag && (rst_f < 0.)) rst = MAX((rst * adm_enhn_gain_limit), t);
+
+    *r = rst;
+    *a = t - rst;
+}
+
+/* Decouples the h, v and d bands of the pixel at idx of scale 0. */
+static inline void adm_decouple_pixel(const adm_dwt_band_t *ref,
+                                      const adm_dwt_band_t *dis,
+                                      const adm_dwt_band_t *r,
+                                      const adm_dwt_band_t *a, size_t idx,
+                                      float cos_1deg_sq,
+                                      double adm_enhn_gain_limit)
+{
+    const int angle_flag =
+        adm_decouple_angle_flag(ref->band_h[idx], ref->band_v[idx],
+                                dis->band_h[idx], dis->band_v[idx],
+                                cos_1deg_sq);
+
+    adm_decouple_px(ref->band_h[idx], dis->band_h[idx], angle_flag,
+                    adm_enhn_gain_limit, &r->band_h[idx], &a->band_h[idx]);
+    adm_decouple_px(ref->band_v[idx], dis->band_v[idx], angle_flag,
+                    adm_enhn_gain_limit, &r->band_v[idx], &a->band_v[idx]);
+    adm_decouple_px(ref->band_d[idx], dis->band_d[idx], angle_flag,
+                    adm_enhn_gain_limit, &r->band_d[idx], &a->band_d[idx]);
+}
+
+/* Decouples the h, v and d bands of the pixel at idx of scales 1-3. */
+static inline void i4_adm_decouple_pixel(const i4_adm_dwt_band_t *ref,
+                                         const i4_adm_dwt_band_t *dis,
+                                         const i4_adm_dwt_band_t *r,
+                                         const i4_adm_dwt_band_t *a,
+                                         size_t idx, float cos_1deg_sq,
+                                         double adm_enhn_gain_limit)
+{
+    const int angle_flag =
+        adm_decouple_angle_flag(ref->band_h[idx], ref->band_v[idx],
+                                dis->band_h[idx], dis->band_v[idx],
+                                cos_1deg_sq);
+
+    i4_adm_decouple_px(ref->band_h[idx], dis->band_h[idx], angle_flag,
+                       adm_enhn_gain_limit, &r->band_h[idx], &a->band_h[idx]);
+    i4_adm_decouple_px(ref->band_v[idx], dis->band_v[idx], angle_flag,
+                       adm_enhn_gain_limit, &r->band_v[idx], &a->band_v[idx]);
+    i4_adm_decouple_px(ref->band_d[idx], dis->band_d[idx], angle_flag,
+                       adm_enhn_gain_limit, &r->band_d[idx], &a->band_d[idx]);
+}
+
+/* Contrast sensitivity of one coefficient of scale 0, and its masking. */
+static inline void adm_csf_px(int16_t src, uint16_t i_rfactor, uint8_t i_shift,
+                              uint16_t i_shiftsadd, int16_t *dst, int16_t *flt)
+{
+    const uint16_t FIX_ONE_BY_30 = 4369; //(1/30)*2^17
+
+    int32_t dst_val = i_rfactor * (int32_t)src;
+    int16_t i16_dst_val = ((int16_t)((dst_val + i_shiftsadd) >> i_shift));
+    *dst = i16_dst_val;
+    *flt = ((int16_t)(((FIX_ONE_BY_30 * abs((int32_t)i16_dst_val))
+        + 2048) >> 12));
+}
+
+/* Contrast sensitivity of one coefficient of scales 1-3, and its masking. */
+static inline void i4_adm_csf_px(int32_t src, uint32_t i_rfactor,
+                                 int32_t add_bef_shift_dst, uint32_t shift_dst,
+                                 int32_t add_bef_shift_flt, uint32_t shift_flt,
+                                 int32_t *dst, int32_t *flt)
+{
+    const uint32_t FIX_ONE_BY_30 = 143165577;
+
+    int32_t dst_val = (int32_t)(((i_rfactor * (int64_t)src) +
+        add_bef_shift_dst) >> shift_dst);
+    *dst = dst_val;
+    *flt = (int32_t)((((int64_t)FIX_ONE_BY_30 * abs(dst_val)) +
+        add_bef_shift_flt) >> shift_flt);
+}
+
+/* Cubed magnitude of one coefficient of scale 0, for the denominator. */
+static inline uint64_t adm_csf_den_px(int16_t src)
+{
+    uint16_t x = (uint16_t)abs(src);
+    return ((uint64_t)x * x) * x;
+}
+
+/* Cubed magnitude of one coefficient of scales 1-3, for the denominator. */
+static inline uint64_t adm_csf_den_s123_px(int32_t src, uint32_t add_shift_sq,
+                                           uint32_t shift_sq,
+                                           uint32_t add_shift_cub,
+                                           uint32_t shift_cub)
+{
+    uint32_t x = (uint32_t)abs(src);
+    return ((((((uint64_t)x * x) + add_shift_sq) >> shift_sq) * x) +
+        add_shift_cub) >> shift_cub;
+}
+
+/*
+ * Contrast masking of row i of scale 0, for the columns [j_begin, j_end)
+ * whose 3x3 neighbourhood lies inside the band. Adds the rounded cubes of
+ * the h, v and d bands to accum.
+ */
+void adm_cm_row(const adm_dwt_band_t *src, const adm_dwt_band_t *csf_a,
+                const adm_dwt_band_t *csf_f, int src_stride, int csf_a_stride,
+                int i, int j_begin, int j_end, const uint16_t *i_rfactor,
+                const uint32_t *add_shift_cub, const uint32_t *shift_cub,
+                int64_t *accum);
+
+/* Contrast masking of row i of scales 1-3, see adm_cm_row(). */
+void i4_adm_cm_row(const i4_adm_dwt_band_t *src,
+                   const i4_adm_dwt_band_t *csf_a,
+                   const i4_adm_dwt_band_t *csf_f, int src_stride,
+                   int csf_a_stride, int i, int j_begin, int j_end,
+                   const uint32_t *rfactor, int32_t add_bef_shift_dst,
+                   uint32_t shift_dst, int32_t add_bef_shift_flt,
+                   uint32_t shift_flt, uint32_t add_shift_cub,
+                   uint32_t shift_cub, int64_t *accum);
+
 #endif /* _FEATURE_ADM_H_ */
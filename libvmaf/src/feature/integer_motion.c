@@ -18,6 +18,8 @@
 
 #include <errno.h>
 #include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "cpu.h"
@@ -29,31 +31,61 @@
 #include "integer_motion.h"
 #include "mem.h"
 #include "picture.h"
+#include "picture_cache.h"
 
 #if ARCH_X86
 #include "x86/motion_avx2.h"
 #if HAVE_AVX512
 #include "x86/motion_avx512.h"
 #endif
+#elif ARCH_AARCH64
+#include "arm64/motion_neon.h"
 #endif
 
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#define MAX(x, y) (((x) > (y)) ? (x) : (y))
+
+// each band blurs its rows in strips of this many rows, through a strip of
+// scratch rows small enough to stay in cache
+#define MOTION_STRIP_ROWS 16
+
 typedef struct MotionState {
-    VmafPicture tmp;
     VmafPicture blur[3];
     unsigned index;
     double score;
     bool debug;
     bool motion_force_zero;
+    bool fused_sad;
+    VmafPicturePool *blur_pool;
+    pthread_mutex_t scratch_lock;
+    void *scratch;
+    size_t scratch_size;
+    ptrdiff_t strip_stride;
+    uint64_t last_sad;
+    // writes rows [row_begin, row_end), dst points at row row_begin
     void (*y_convolution)(void *src, uint16_t *dst, unsigned width,
                           unsigned height, ptrdiff_t src_stride,
-                          ptrdiff_t dst_stride, unsigned inp_size_bits);
+                          ptrdiff_t dst_stride, unsigned inp_size_bits,
+                          unsigned row_begin, unsigned row_end);
     void (*x_convolution)(const uint16_t *src, uint16_t *dst, unsigned width,
                           unsigned height, ptrdiff_t src_stride,
                           ptrdiff_t dst_stride);
-    void (*sad)(VmafPicture *pic_a, VmafPicture *pic_b, uint64_t *sad);
+    uint64_t (*sad)(const uint16_t *a, ptrdiff_t a_stride,
+                    const uint16_t *b, ptrdiff_t b_stride,
+                    unsigned w, unsigned h);
+    unsigned band_cnt;
+    uint64_t (*band_sad)[2];
     VmafDictionary *feature_name_dict;
+    VmafFeatureCollector *feature_collector;
+    unsigned feature_id[2];
 } MotionState;
 
+static const char *motion_feature_name[] = {
+    "VMAF_integer_feature_motion2_score",
+    /* debug */
+    "VMAF_integer_feature_motion_score",
+};
+
 static const VmafOption options[] = {
     {
         .name = "debug",
@@ -71,6 +103,16 @@ static const VmafOption options[] = {
         .default_val.b = false,
         .flags = VMAF_OPT_FLAG_FEATURE_PARAM,
     },
+    {
+        .name = "fused_sad",
+        .help = "blur the reference pictures in picture order, and take the "
+                "SAD of each strip of rows against the previous blurred "
+                "picture right after blurring it, instead of blurring "
+                "pictures ahead in parallel",
+        .offset = offsetof(MotionState, fused_sad),
+        .type = VMAF_OPT_TYPE_BOOL,
+        .default_val.b = false,
+    },
     { 0 }
 };
 
@@ -117,7 +159,8 @@ x_convolution_16(const uint16_t *src, uint16_t *dst, unsigned width,
 static inline void
 y_convolution_16(void *src, uint16_t *dst, unsigned width,
                  unsigned height, ptrdiff_t src_stride,
-                 ptrdiff_t dst_stride, unsigned inp_size_bits)
+                 ptrdiff_t dst_stride, unsigned inp_size_bits,
+                 unsigned row_begin, unsigned row_end)
 {
     const unsigned radius = filter_width / 2;
     const unsigned top_edge = vmaf_ceiln(radius, 1);
@@ -125,16 +168,17 @@ y_convolution_16(void *src, uint16_t *dst, unsigned width,
     const unsigned add_before_shift = (int) pow(2, (inp_size_bits - 1));
     const unsigned shift_var = inp_size_bits;
 
-    uint16_t *src_p = (uint16_t*) src + (top_edge - radius) * src_stride;
-    for (unsigned i = 0; i < top_edge; i++) {
+    for (unsigned i = row_begin; i < MIN(top_edge, row_end); i++) {
         for (unsigned j = 0; j < width; ++j) {
-            dst[i * dst_stride + j] =
+            dst[(i - row_begin) * dst_stride + j] =
                 (edge_16(false, src, width, height, src_stride, i, j) +
                  add_before_shift) >> shift_var;
         }
     }
 
-    for (unsigned i = top_edge; i < bottom_edge; i++) {
+    const unsigned mid_begin = MAX(top_edge, row_begin);
+    uint16_t *src_p = (uint16_t*) src + (mid_begin - radius) * src_stride;
+    for (unsigned i = mid_begin; i < MIN(bottom_edge, row_end); i++) {
         uint16_t *src_p1 = src_p;
         for (unsigned j = 0; j < width; ++j) {
             uint16_t *src_p2 = src_p1;
@@ -143,15 +187,16 @@ y_convolution_16(void *src, uint16_t *dst, unsigned width,
                 accum += filter[k] * (*src_p2);
                 src_p2 += src_stride;
             }
-            dst[i * dst_stride + j] = (accum + add_before_shift) >> shift_var;
+            dst[(i - row_begin) * dst_stride + j] =
+                (accum + add_before_shift) >> shift_var;
             src_p1++;
         }
         src_p += src_stride;
     }
 
-    for (unsigned i = bottom_edge; i < height; i++) {
+    for (unsigned i = MAX(bottom_edge, row_begin); i < row_end; i++) {
         for (unsigned j = 0; j < width; ++j) {
-            dst[i * dst_stride + j] =
+            dst[(i - row_begin) * dst_stride + j] =
                 (edge_16(false, src, width, height, src_stride, i, j) +
                  add_before_shift) >> shift_var;
         }
@@ -182,7 +227,7 @@ edge_8(const uint8_t *src, int height, int stride, int i, int j)
 static inline void
 y_convolution_8(void *src, uint16_t *dst, unsigned width,
                 unsigned height, ptrdiff_t src_stride, ptrdiff_t dst_stride,
-                unsigned inp_size_bits)
+                unsigned inp_size_bits, unsigned row_begin, unsigned row_end)
 {
     (void) inp_size_bits;
     const unsigned radius = filter_width / 2;
@@ -191,16 +236,17 @@ y_convolution_8(void *src, uint16_t *dst, unsigned width,
     const unsigned shift_var = 8;
     const unsigned add_before_shift = (int) pow(2, (shift_var - 1));
 
-    for (unsigned i = 0; i < top_edge; i++) {
+    for (unsigned i = row_begin; i < MIN(top_edge, row_end); i++) {
         for (unsigned j = 0; j < width; ++j) {
-            dst[i * dst_stride + j] =
+            dst[(i - row_begin) * dst_stride + j] =
                 (edge_8(src, height, src_stride, i, j) +
                  add_before_shift) >> shift_var;
         }
     }
 
-    uint8_t *src_p = (uint8_t*) src + (top_edge - radius) * src_stride;
-    for (unsigned i = top_edge; i < bottom_edge; i++) {
+    const unsigned mid_begin = MAX(top_edge, row_begin);
+    uint8_t *src_p = (uint8_t*) src + (mid_begin - radius) * src_stride;
+    for (unsigned i = mid_begin; i < MIN(bottom_edge, row_end); i++) {
         uint8_t *src_p1 = src_p;
         for (unsigned j = 0; j < width; ++j) {
             uint8_t *src_p2 = src_p1;
@@ -209,36 +255,38 @@ y_convolution_8(void *src, uint16_t *dst, unsigned width,
                 accum += filter[k] * (*src_p2);
                 src_p2 += src_stride;
             }
-            dst[i * dst_stride + j] = (accum + add_before_shift) >> shift_var;
+            dst[(i - row_begin) * dst_stride + j] =
+                (accum + add_before_shift) >> shift_var;
             src_p1++;
         }
         src_p += src_stride;
     }
 
-    for (unsigned i = bottom_edge; i < height; i++) {
+    for (unsigned i = MAX(bottom_edge, row_begin); i < row_end; i++) {
         for (unsigned j = 0; j < width; ++j) {
-            dst[i * dst_stride + j] =
+            dst[(i - row_begin) * dst_stride + j] =
                 (edge_8(src, height, src_stride, i, j) +
                  add_before_shift) >> shift_var;
         }
     }
 }
 
-static void sad_c(VmafPicture *pic_a, VmafPicture *pic_b, uint64_t *sad)
+static uint64_t sad_c(const uint16_t *a, ptrdiff_t a_stride,
+                      const uint16_t *b, ptrdiff_t b_stride,
+                      unsigned w, unsigned h)
 {
-    *sad = 0;
+    uint64_t sad = 0;
 
-    uint16_t *a = pic_a->data[0];
-    uint16_t *b = pic_b->data[0];
-    for (unsigned i = 0; i < pic_a->h[0]; i++) {
+    for (unsigned i = 0; i < h; i++) {
         uint32_t inner_sad = 0;
-        for (unsigned j = 0; j < pic_a->w[0]; j++) {
+        for (unsigned j = 0; j < w; j++) {
             inner_sad += abs(a[j] - b[j]);
         }
-        *sad += inner_sad;
-        a += (pic_a->stride[0] / 2);
-        b += (pic_b->stride[0] / 2);
+        sad += inner_sad;
+        a += a_stride;
+        b += b_stride;
     }
+    return sad;
 }
 
 static int extract_force_zero(VmafFeatureExtractor *fex,
@@ -269,6 +317,12 @@ static int extract_force_zero(VmafFeatureExtractor *fex,
     return err;
 }
 
+static int extract_fused(VmafFeatureExtractor *fex,
+                         VmafPicture *ref_pic, VmafPicture *ref_pic_90,
+                         VmafPicture *dist_pic, VmafPicture *dist_pic_90,
+                         unsigned index,
+                         VmafFeatureCollector *feature_collector);
+
 static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
                 unsigned bpc, unsigned w, unsigned h)
 {
@@ -282,42 +336,101 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
 
     if (s->motion_force_zero) {
         fex->extract = extract_force_zero;
+        fex->prepare = NULL;
+        fex->reduce = NULL;
         fex->flush = NULL;
         fex->close = NULL;
         return 0;
     }
 
-    err |= vmaf_picture_alloc(&s->tmp, VMAF_PIX_FMT_YUV400P, 16, w, h);
-    err |= vmaf_picture_alloc(&s->blur[0], VMAF_PIX_FMT_YUV400P, 16, w, h);
-    err |= vmaf_picture_alloc(&s->blur[1], VMAF_PIX_FMT_YUV400P, 16, w, h);
-    err |= vmaf_picture_alloc(&s->blur[2], VMAF_PIX_FMT_YUV400P, 16, w, h);
-    if (err) goto fail;
-
     s->y_convolution = bpc == 8 ? y_convolution_8 : y_convolution_16;
     s->x_convolution = x_convolution_16;
+    s->sad = sad_c;
 
 #if ARCH_X86
     unsigned flags = vmaf_get_cpu_flags();
-    if (flags & VMAF_X86_CPU_FLAG_AVX2)
+    if (flags & VMAF_X86_CPU_FLAG_AVX2) {
+        s->y_convolution =
+            bpc == 8 ? y_convolution_8_avx2 : y_convolution_16_avx2;
         s->x_convolution = x_convolution_16_avx2;
+        s->sad = sad_avx2;
+    }
 #if HAVE_AVX512
-    if (flags & VMAF_X86_CPU_FLAG_AVX512)
+    if (flags & VMAF_X86_CPU_FLAG_AVX512) {
+        s->y_convolution =
+            bpc == 8 ? y_convolution_8_avx512 : y_convolution_16_avx512;
         s->x_convolution = x_convolution_16_avx512;
+        s->sad = sad_avx512;
+    }
 #endif
+#elif ARCH_AARCH64
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_ARM_CPU_FLAG_NEON) {
+        s->y_convolution =
+            bpc == 8 ? y_convolution_8_neon : y_convolution_16_neon;
+        s->x_convolution = x_convolution_16_neon;
+        s->sad = sad_neon;
+    }
 #endif
 
-    s->sad = sad_c;
     s->score = 0.;
 
+    s->band_cnt = vmaf_feature_extractor_band_cnt(fex, h);
+    s->band_sad = malloc(sizeof(*s->band_sad) * s->band_cnt);
+    if (!s->band_sad) goto fail;
+
+    pthread_mutex_init(&s->scratch_lock, NULL);
+    s->strip_stride = ALIGN_CEIL(w * sizeof(uint16_t)) / sizeof(uint16_t);
+    s->scratch_size =
+        s->band_cnt * MOTION_STRIP_ROWS * s->strip_stride * sizeof(uint16_t);
+
+    if (s->fused_sad) {
+        // the blurred pictures are kept here rather than in the picture
+        // cache, and computed in extract_fused() instead of prepare()
+        for (unsigned i = 0; i < 3; i++) {
+            err = vmaf_picture_alloc(&s->blur[i], VMAF_PIX_FMT_YUV400P, 16,
+                                     w, h);
+            if (err) goto free_lock;
+        }
+        fex->extract = extract_fused;
+        fex->prepare = NULL;
+        fex->reduce = NULL;
+    } else {
+        // the three blurred pictures reduce() holds on to, and one for each
+        // picture which may be in prepare() at the same time
+        const unsigned n_threads = vmaf_thread_pool_n_threads(fex->thread_pool);
+        err = vmaf_picture_pool_init(&s->blur_pool, VMAF_PIX_FMT_YUV400P, 16,
+                                     w, h, 3 + MAX(n_threads, 1));
+        if (err) goto free_lock;
+    }
+
     return 0;
 
+free_lock:
+    pthread_mutex_destroy(&s->scratch_lock);
 fail:
-    err |= vmaf_picture_unref(&s->blur[0]);
-    err |= vmaf_picture_unref(&s->blur[1]);
-    err |= vmaf_picture_unref(&s->blur[2]);
-    err |= vmaf_picture_unref(&s->tmp);
+    for (unsigned i = 0; i < 3; i++) {
+        if (s->blur[i].ref) vmaf_picture_unref(&s->blur[i]);
+    }
+    free(s->band_sad);
     err |= vmaf_dictionary_free(&s->feature_name_dict);
-    return err;
+    return err ? err : -ENOMEM;
+}
+
+static int register_features(VmafFeatureCollector *feature_collector,
+                             MotionState *s)
+{
+    if (s->feature_collector == feature_collector) return 0;
+
+    const unsigned cnt = s->debug ? 2 : 1;
+    for (unsigned i = 0; i < cnt; i++) {
+        int err = vmaf_feature_collector_register(feature_collector,
+                        motion_feature_name[i], &s->feature_id[i]);
+        if (err) return err;
+    }
+
+    s->feature_collector = feature_collector;
+    return 0;
 }
 
 static int flush(VmafFeatureExtractor *fex,
@@ -327,9 +440,11 @@ static int flush(VmafFeatureExtractor *fex,
     int ret = 0;
 
     if (s->index > 0) {
-        ret = vmaf_feature_collector_append(feature_collector,
-                                            "VMAF_integer_feature_motion2_score",
-                                            s->score, s->index);
+        ret = register_features(feature_collector, s);
+        if (ret) return ret;
+        ret = vmaf_feature_collector_append_by_id(feature_collector,
+                                                  s->feature_id[0],
+                                                  s->score, s->index);
     }
 
     return (ret < 0) ? ret : !ret;
@@ -341,82 +456,354 @@ static inline double normalize_and_scale_sad(uint64_t sad,
     return (float) (sad / 256.) / (w * h);
 }
 
-static int extract(VmafFeatureExtractor *fex,
-                   VmafPicture *ref_pic, VmafPicture *ref_pic_90,
-                   VmafPicture *dist_pic, VmafPicture *dist_pic_90,
-                   unsigned index, VmafFeatureCollector *feature_collector)
+static inline VmafPicture band_view(VmafPicture *pic, unsigned row_begin,
+                                     unsigned row_end)
+{
+    VmafPicture view = *pic;
+    view.data[0] = (uint8_t *) pic->data[0] + row_begin * pic->stride[0];
+    view.h[0] = row_end - row_begin;
+    return view;
+}
+
+// the scratch strips of all bands, one set for each picture being blurred at
+// the same time; unused sets are kept in a list threaded through them
+static uint16_t *scratch_get(MotionState *s)
 {
+    pthread_mutex_lock(&s->scratch_lock);
+    void *scratch = s->scratch;
+    if (scratch) s->scratch = *(void **) scratch;
+    pthread_mutex_unlock(&s->scratch_lock);
+
+    return scratch ? scratch : aligned_malloc(s->scratch_size, 32);
+}
+
+static void scratch_put(MotionState *s, uint16_t *scratch)
+{
+    pthread_mutex_lock(&s->scratch_lock);
+    *(void **) scratch = s->scratch;
+    s->scratch = scratch;
+    pthread_mutex_unlock(&s->scratch_lock);
+}
+
+static inline uint16_t *band_strip(MotionState *s, uint16_t *scratch,
+                                   unsigned band)
+{
+    return scratch + band * MOTION_STRIP_ROWS * s->strip_stride;
+}
+
+typedef struct MotionBlurJob {
+    MotionState *s;
+    VmafPicture *ref_pic, *blur;
+    uint16_t *scratch;
+} MotionBlurJob;
+
+// rows [row_begin, row_end) are at most MOTION_STRIP_ROWS
+static void motion_blur_rows(MotionState *s, VmafPicture *ref_pic,
+                             uint16_t *strip, VmafPicture *blur_pic,
+                             unsigned row_begin, unsigned row_end)
+{
+    const ptrdiff_t y_src_stride =
+        ref_pic->bpc == 8 ? ref_pic->stride[0] : ref_pic->stride[0] / 2;
+
+    s->y_convolution(ref_pic->data[0], strip, ref_pic->w[0], ref_pic->h[0],
+                     y_src_stride, s->strip_stride, ref_pic->bpc, row_begin,
+                     row_end);
+
+    VmafPicture blur = band_view(blur_pic, row_begin, row_end);
+    s->x_convolution(strip, blur.data[0], blur.w[0], blur.h[0],
+                     s->strip_stride, blur.stride[0] / 2);
+}
+
+static void motion_blur_band(void *data, unsigned band,
+                             unsigned row_begin, unsigned row_end)
+{
+    MotionBlurJob *job = data;
+    uint16_t *strip = band_strip(job->s, job->scratch, band);
+
+    for (unsigned r0 = row_begin, r1; r0 < row_end; r0 = r1) {
+        r1 = MIN(r0 + MOTION_STRIP_ROWS, row_end);
+        motion_blur_rows(job->s, job->ref_pic, strip, job->blur, r0, r1);
+    }
+}
+
+static int fill_blur(VmafPicture *ref_pic, int param, void *data,
+                     void *cookie)
+{
+    VmafFeatureExtractor *fex = cookie;
     MotionState *s = fex->priv;
+    VmafPicture *blur = data;
     int err = 0;
 
+    (void) param;
+
+    const unsigned w = ref_pic->w[0], h = ref_pic->h[0];
+    // with more pictures in flight than the pool holds, waiting for one to
+    // come back could wait on reduce(), which may be waiting on this picture
+    err = vmaf_picture_pool_try_get(s->blur_pool, blur);
+    if (err == -EAGAIN)
+        err = vmaf_picture_alloc(blur, VMAF_PIX_FMT_YUV400P, 16, w, h);
+    if (err) return err;
+
+    uint16_t *scratch = scratch_get(s);
+    if (!scratch) {
+        vmaf_picture_unref(blur);
+        return -ENOMEM;
+    }
+
+    MotionBlurJob job = {
+        .s = s,
+        .ref_pic = ref_pic,
+        .blur = blur,
+        .scratch = scratch,
+    };
+    err = vmaf_feature_extractor_run_bands(fex, h, s->band_cnt,
+                                           motion_blur_band, &job);
+    scratch_put(s, scratch);
+    if (err) vmaf_picture_unref(blur);
+
+    return err;
+}
+
+static int prepare(VmafFeatureExtractor *fex,
+                   VmafPicture *ref_pic, VmafPicture *dist_pic,
+                   unsigned index, VmafPicture *blur)
+{
     (void) dist_pic;
-    (void) ref_pic_90;
-    (void) dist_pic_90;
+    (void) index;
+
+    // the blur only depends on the reference, contexts scoring several
+    // distorted pictures against it share one, see vmaf_read_pictures_multi()
+    const VmafPicture *cached =
+        vmaf_picture_cache_get(ref_pic, VMAF_PICTURE_CACHE_MOTION_BLUR, 0,
+                               sizeof(*blur), fill_blur, fex);
+    if (!cached) return -ENOMEM;
+    return vmaf_picture_ref(blur, (VmafPicture *) cached);
+}
 
-    s->index = index;
-    const unsigned blur_idx_0 = (index + 0) % 3;
-    const unsigned blur_idx_1 = (index + 1) % 3;
-    const unsigned blur_idx_2 = (index + 2) % 3;
+static uint64_t motion_sad(MotionState *s, VmafPicture *pic_a,
+                           VmafPicture *pic_b, unsigned row_begin,
+                           unsigned row_end)
+{
+    const ptrdiff_t a_stride = pic_a->stride[0] / 2;
+    const ptrdiff_t b_stride = pic_b->stride[0] / 2;
 
-    const ptrdiff_t y_src_stride =
-        ref_pic->bpc == 8 ? ref_pic->stride[0] : ref_pic->stride[0] / 2;
+    return s->sad((uint16_t *) pic_a->data[0] + row_begin * a_stride, a_stride,
+                  (uint16_t *) pic_b->data[0] + row_begin * b_stride, b_stride,
+                  pic_a->w[0], row_end - row_begin);
+}
 
-    s->y_convolution(ref_pic->data[0], s->tmp.data[0], ref_pic->w[0],
-                     ref_pic->h[0], y_src_stride, s->tmp.stride[0] / 2,
-                     ref_pic->bpc);
+// motion2 of the previous picture also needs the sad between it and the one
+// before, which is the sad the previous picture index has taken already
+static bool have_sad2(MotionState *s, unsigned index)
+{
+    return index > 1 && s->index == index - 1;
+}
 
-    s->x_convolution(s->tmp.data[0], s->blur[blur_idx_0].data[0],
-                     s->tmp.w[0], s->tmp.h[0], s->tmp.stride[0] / 2,
-                     s->blur[blur_idx_0].stride[0] / 2);
+static int append_scores(MotionState *s,
+                         VmafFeatureCollector *feature_collector,
+                         unsigned index, uint64_t sad, uint64_t sad2,
+                         unsigned w, unsigned h)
+{
+    int err = 0;
+
+    s->index = index;
 
     if (index == 0) {
-        err = vmaf_feature_collector_append(feature_collector,
-                                            "VMAF_integer_feature_motion2_score",
-                                            0., index);
+        err = vmaf_feature_collector_append_by_id(feature_collector,
+                                                  s->feature_id[0], 0., index);
         if (s->debug) {
-            err |= vmaf_feature_collector_append(feature_collector,
-                                                 "VMAF_integer_feature_motion_score",
-                                                 0., index);
+            err |= vmaf_feature_collector_append_by_id(feature_collector,
+                                                       s->feature_id[1], 0.,
+                                                       index);
         }
         return err;
     }
 
-    uint64_t sad;
-    s->sad(&s->blur[blur_idx_2], &s->blur[blur_idx_0], &sad);
-    double score = s->score =
-        normalize_and_scale_sad(sad, ref_pic->w[0], ref_pic->h[0]);
+    s->last_sad = sad;
+    double score = s->score = normalize_and_scale_sad(sad, w, h);
 
     if (s->debug) {
-        err |= vmaf_feature_collector_append(feature_collector,
-                                             "VMAF_integer_feature_motion_score",
-                                             score, index);
+        err |= vmaf_feature_collector_append_by_id(feature_collector,
+                                                   s->feature_id[1], score,
+                                                   index);
     }
     if (err) return err;
 
     if (index == 1)
         return 0;
 
-    uint64_t sad2;
-    s->sad(&s->blur[blur_idx_2], &s->blur[blur_idx_1], &sad2);
-    double score2 = normalize_and_scale_sad(sad2, ref_pic->w[0], ref_pic->h[0]);
+    double score2 = normalize_and_scale_sad(sad2, w, h);
 
     score2 = score2 < score ? score2 : score;
-    err = vmaf_feature_collector_append(feature_collector,
-                                        "VMAF_integer_feature_motion2_score",
-                                        score2, index - 1);
+    err = vmaf_feature_collector_append_by_id(feature_collector,
+                                              s->feature_id[0], score2,
+                                              index - 1);
     return err;
 }
 
+typedef struct MotionSadJob {
+    MotionState *s;
+    VmafPicture *blur[3];
+    bool sad2;
+} MotionSadJob;
+
+static void motion_sad_band(void *data, unsigned band,
+                            unsigned row_begin, unsigned row_end)
+{
+    MotionSadJob *job = data;
+    MotionState *s = job->s;
+
+    s->band_sad[band][0] =
+        motion_sad(s, job->blur[2], job->blur[0], row_begin, row_end);
+
+    if (!job->sad2) return;
+
+    s->band_sad[band][1] =
+        motion_sad(s, job->blur[2], job->blur[1], row_begin, row_end);
+}
+
+static int reduce(VmafFeatureExtractor *fex, VmafPicture *blur,
+                  unsigned index, VmafFeatureCollector *feature_collector)
+{
+    MotionState *s = fex->priv;
+    int err = 0;
+
+    err = register_features(feature_collector, s);
+    if (err) return err;
+
+    const unsigned blur_idx_0 = (index + 0) % 3;
+    const unsigned blur_idx_1 = (index + 1) % 3;
+    const unsigned blur_idx_2 = (index + 2) % 3;
+
+    if (s->blur[blur_idx_0].ref) {
+        err = vmaf_picture_unref(&s->blur[blur_idx_0]);
+        if (err) return err;
+    }
+    err = vmaf_picture_ref(&s->blur[blur_idx_0], blur);
+    if (err) return err;
+
+    if (index == 0) {
+        return append_scores(s, feature_collector, index, 0, 0, blur->w[0],
+                             blur->h[0]);
+    }
+
+    memset(s->band_sad, 0, sizeof(*s->band_sad) * s->band_cnt);
+    MotionSadJob job = {
+        .s = s,
+        .sad2 = index > 1 && !have_sad2(s, index),
+        .blur = {
+            &s->blur[blur_idx_0], &s->blur[blur_idx_1], &s->blur[blur_idx_2],
+        },
+    };
+    err = vmaf_feature_extractor_run_bands(fex, blur->h[0], s->band_cnt,
+                                           motion_sad_band, &job);
+    if (err) return err;
+
+    uint64_t sad = 0, sad2 = job.sad2 ? 0 : s->last_sad;
+    for (unsigned i = 0; i < s->band_cnt; i++) {
+        sad += s->band_sad[i][0];
+        sad2 += s->band_sad[i][1];
+    }
+
+    return append_scores(s, feature_collector, index, sad, sad2, blur->w[0],
+                         blur->h[0]);
+}
+
+typedef struct MotionFusedJob {
+    MotionState *s;
+    VmafPicture *ref_pic;
+    uint16_t *scratch;
+    VmafPicture *blur[3];
+    unsigned index;
+    bool sad2;
+} MotionFusedJob;
+
+static void motion_fused_band(void *data, unsigned band,
+                              unsigned row_begin, unsigned row_end)
+{
+    MotionFusedJob *job = data;
+    MotionState *s = job->s;
+    uint16_t *strip = band_strip(s, job->scratch, band);
+
+    // the blurred rows of a strip are still in cache when their sad is taken
+    for (unsigned r0 = row_begin, r1; r0 < row_end; r0 = r1) {
+        r1 = MIN(r0 + MOTION_STRIP_ROWS, row_end);
+        motion_blur_rows(s, job->ref_pic, strip, job->blur[0], r0, r1);
+        if (job->index == 0) continue;
+        s->band_sad[band][0] +=
+            motion_sad(s, job->blur[2], job->blur[0], r0, r1);
+        if (!job->sad2) continue;
+        s->band_sad[band][1] +=
+            motion_sad(s, job->blur[2], job->blur[1], r0, r1);
+    }
+}
+
+static int extract_fused(VmafFeatureExtractor *fex,
+                         VmafPicture *ref_pic, VmafPicture *ref_pic_90,
+                         VmafPicture *dist_pic, VmafPicture *dist_pic_90,
+                         unsigned index,
+                         VmafFeatureCollector *feature_collector)
+{
+    MotionState *s = fex->priv;
+    int err = 0;
+
+    (void) ref_pic_90;
+    (void) dist_pic;
+    (void) dist_pic_90;
+
+    err = register_features(feature_collector, s);
+    if (err) return err;
+
+    uint16_t *scratch = scratch_get(s);
+    if (!scratch) return -ENOMEM;
+
+    memset(s->band_sad, 0, sizeof(*s->band_sad) * s->band_cnt);
+    MotionFusedJob job = {
+        .s = s,
+        .ref_pic = ref_pic,
+        .scratch = scratch,
+        .index = index,
+        .sad2 = index > 1 && !have_sad2(s, index),
+        .blur = {
+            &s->blur[(index + 0) % 3], &s->blur[(index + 1) % 3],
+            &s->blur[(index + 2) % 3],
+        },
+    };
+    err = vmaf_feature_extractor_run_bands(fex, ref_pic->h[0], s->band_cnt,
+                                           motion_fused_band, &job);
+    scratch_put(s, scratch);
+    if (err) return err;
+
+    uint64_t sad = 0, sad2 = job.sad2 ? 0 : s->last_sad;
+    for (unsigned i = 0; i < s->band_cnt; i++) {
+        sad += s->band_sad[i][0];
+        sad2 += s->band_sad[i][1];
+    }
+
+    return append_scores(s, feature_collector, index, sad, sad2,
+                         ref_pic->w[0], ref_pic->h[0]);
+}
+
 static int close(VmafFeatureExtractor *fex)
 {
     MotionState *s = fex->priv;
 
     int err = 0;
-    err |= vmaf_picture_unref(&s->blur[0]);
-    err |= vmaf_picture_unref(&s->blur[1]);
-    err |= vmaf_picture_unref(&s->blur[2]);
-    err |= vmaf_picture_unref(&s->tmp);
+    for (unsigned i = 0; i < 3; i++) {
+        if (s->blur[i].ref)
+            err |= vmaf_picture_unref(&s->blur[i]);
+    }
+    // blurred pictures still cached on reference pictures keep the pool
+    // alive, see vmaf_picture_pool_close()
+    if (s->blur_pool)
+        err |= vmaf_picture_pool_close(s->blur_pool);
+    for (void *scratch = s->scratch, *next; scratch; scratch = next) {
+        next = *(void **) scratch;
+        aligned_free(scratch);
+    }
+    pthread_mutex_destroy(&s->scratch_lock);
     err |= vmaf_dictionary_free(&s->feature_name_dict);
+    free(s->band_sad);
     return err;
 }
 
@@ -428,7 +815,8 @@ static const char *provided_features[] = {
 VmafFeatureExtractor vmaf_fex_integer_motion = {
     .name = "motion",
     .init = init,
-    .extract = extract,
+    .prepare = prepare,
+    .reduce = reduce,
     .flush = flush,
     .close = close,
     .options = options,
@@ -53,4 +53,24 @@ edge_16(bool horizontal, const uint16_t *src, int width,
     return accum;
 }
 
+/*
+ * Source rows of the vertical filter taps of output row i, mirrored at the
+ * top and bottom edges like edge_16().
+ */
+static inline void
+y_tap_rows(int i, int height, int *rows)
+{
+    const int radius = filter_width / 2;
+
+    for (int k = 0; k < filter_width; ++k) {
+        int i_tap = i - radius + k;
+
+        if (i_tap < 0)
+            i_tap = -i_tap;
+        else if (i_tap >= height)
+            i_tap = height - (i_tap - height + 1);
+        rows[k] = i_tap;
+    }
+}
+
 #endif /* _FEATURE_MOTION_H_ */
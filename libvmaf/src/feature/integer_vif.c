@@ -43,14 +43,40 @@
 
 typedef struct VifState {
     VifPublicState public;
+    uint16_t log2_table[65537];
+    unsigned band_cnt;
+    void *band_data;
+    VifBuffer *band_buf;
+    VifResiduals *band_residuals;
     bool debug;
     void (*subsample_rd_8)(VifBuffer buf, unsigned w, unsigned h);
     void (*subsample_rd_16)(VifBuffer buf, unsigned w, unsigned h, int scale, int bpc);
-    void (*vif_statistic_8)(VifPublicState *s, float *num, float *den, unsigned w, unsigned h);
-    void (*vif_statistic_16)(VifPublicState *s, float *num, float *den, unsigned w, unsigned h, int bpc, int scale);
+    void (*vif_statistic_8)(VifPublicState *s, VifResiduals *residuals_out, unsigned w, unsigned h);
+    void (*vif_statistic_16)(VifPublicState *s, VifResiduals *residuals_out, unsigned w, unsigned h, int bpc, int scale);
     VmafDictionary *feature_name_dict;
+    VmafFeatureCollector *feature_collector;
+    unsigned feature_id[15];
 } VifState;
 
+static const char *vif_feature_name[] = {
+    "VMAF_integer_feature_vif_scale0_score",
+    "VMAF_integer_feature_vif_scale1_score",
+    "VMAF_integer_feature_vif_scale2_score",
+    "VMAF_integer_feature_vif_scale3_score",
+    /* debug */
+    "integer_vif",
+    "integer_vif_num",
+    "integer_vif_den",
+    "integer_vif_num_scale0",
+    "integer_vif_den_scale0",
+    "integer_vif_num_scale1",
+    "integer_vif_den_scale1",
+    "integer_vif_num_scale2",
+    "integer_vif_den_scale2",
+    "integer_vif_num_scale3",
+    "integer_vif_den_scale3",
+};
+
 static const VmafOption options[] = {
     {
         .name = "debug",
@@ -219,7 +245,7 @@ static inline void log_generate(uint16_t *log2_table)
     }
 }
 
-void vif_statistic_8(struct VifPublicState *s, float *num, float *den, unsigned w, unsigned h) {
+void vif_statistic_8(struct VifPublicState *s, VifResiduals *residuals_out, unsigned w, unsigned h) {
     const unsigned fwidth = vif_filter1d_width[0];
     const uint16_t *vif_filt_s0 = vif_filter1d_table[0];
     VifBuffer buf = s->buf;
@@ -338,11 +364,13 @@ void vif_statistic_8(struct VifPublicState *s, float *num, float *den, unsigned
             }
         }
     }
-    num[0] = accum_num_log / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
-    den[0] = accum_den_log / 2048.0 + accum_den_non_log;
+    residuals_out->accum_num_log = accum_num_log;
+    residuals_out->accum_den_log = accum_den_log;
+    residuals_out->accum_num_non_log = accum_num_non_log;
+    residuals_out->accum_den_non_log = accum_den_non_log;
 }
 
-void vif_statistic_16(struct VifPublicState *s, float *num, float *den, unsigned w, unsigned h, int bpc, int scale) {
+void vif_statistic_16(struct VifPublicState *s, VifResiduals *residuals_out, unsigned w, unsigned h, int bpc, int scale) {
     const unsigned fwidth = vif_filter1d_width[scale];
     const uint16_t *vif_filt = vif_filter1d_table[scale];
     VifBuffer buf = s->buf;
@@ -481,8 +509,10 @@ void vif_statistic_16(struct VifPublicState *s, float *num, float *den, unsigned
             }
         }
     }
-    num[0] = accum_num_log / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
-    den[0] = accum_den_log / 2048.0 + accum_den_non_log;
+    residuals_out->accum_num_log = accum_num_log;
+    residuals_out->accum_den_log = accum_den_log;
+    residuals_out->accum_num_non_log = accum_num_non_log;
+    residuals_out->accum_den_non_log = accum_den_non_log;
 }
 
 VifResiduals vif_compute_line_residuals(VifPublicState *s, unsigned from,
@@ -592,6 +622,47 @@ VifResiduals vif_compute_line_residuals(VifPublicState *s, unsigned from,
 }
 
 
+static void vif_residuals_to_score(const VifResiduals *r, float *num,
+                                   float *den)
+{
+    num[0] = r->accum_num_log / 2048.0 + (r->accum_den_non_log -
+             ((r->accum_num_non_log) / 16384.0) / (65025.0));
+    den[0] = r->accum_den_log / 2048.0 + r->accum_den_non_log;
+}
+
+static int init_bands(VmafFeatureExtractor *fex, VifState *s, unsigned h)
+{
+    s->band_cnt = vmaf_feature_extractor_band_cnt(fex, h);
+    s->band_buf = malloc(sizeof(*s->band_buf) * s->band_cnt);
+    if (!s->band_buf) return -ENOMEM;
+    s->band_residuals = malloc(sizeof(*s->band_residuals) * s->band_cnt);
+    if (!s->band_residuals) return -ENOMEM;
+
+    s->band_buf[0] = s->public.buf;
+    if (s->band_cnt == 1) return 0;
+
+    // each extra band gets its own row buffers, with a leading guard row
+    // for the left padding written by PADDING_SQ_DATA()
+    const size_t band_sz = 6 * s->public.buf.stride_tmp;
+    const size_t data_sz = (s->band_cnt - 1) * band_sz;
+    char *data = s->band_data = aligned_malloc(data_sz, MAX_ALIGN);
+    if (!data) return -ENOMEM;
+    memset(data, 0, data_sz);
+
+    for (unsigned i = 1; i < s->band_cnt; i++) {
+        VifBuffer *buf = &s->band_buf[i];
+        *buf = s->public.buf;
+        data += buf->stride_tmp;
+        buf->tmp.mu1 = (uint32_t *) data; data += buf->stride_tmp;
+        buf->tmp.mu2 = (uint32_t *) data; data += buf->stride_tmp;
+        buf->tmp.ref = (uint32_t *) data; data += buf->stride_tmp;
+        buf->tmp.dis = (uint32_t *) data; data += buf->stride_tmp;
+        buf->tmp.ref_dis = (uint32_t *) data; data += buf->stride_tmp;
+    }
+
+    return 0;
+}
+
 static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
                 unsigned bpc, unsigned w, unsigned h)
 {
@@ -628,6 +699,7 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     }
 #endif
 
+    s->public.log2_table = s->log2_table;
     log_generate(s->public.log2_table);
 
     (void)pix_fmt;
@@ -665,6 +737,8 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     s->public.buf.tmp.ref_convol = data; data += s->public.buf.stride_tmp;
     s->public.buf.tmp.dis_convol = data;
 
+    if (init_bands(fex, s, h)) goto fail;
+
     s->feature_name_dict =
         vmaf_feature_name_dict_from_provided_features(fex->provided_features,
                 fex->options, s);
@@ -673,7 +747,10 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
     return 0;
 
 fail:
-    if (data) aligned_free(data);
+    if (s->public.buf.data) aligned_free(s->public.buf.data);
+    if (s->band_data) aligned_free(s->band_data);
+    free(s->band_buf);
+    free(s->band_residuals);
     vmaf_dictionary_free(&s->feature_name_dict);
     return -ENOMEM;
 }
@@ -685,26 +762,35 @@ typedef struct VifScore {
     } scale[4];
 } VifScore;
 
-static int write_scores(VmafFeatureCollector *feature_collector, unsigned index,
-                        VifScore vif, VifState *s)
+static int register_features(VmafFeatureCollector *feature_collector,
+                             VifState *s)
 {
-    int err = 0;
+    if (s->feature_collector == feature_collector) return 0;
+
+    const unsigned cnt = s->debug ? 15 : 4;
+    for (unsigned i = 0; i < cnt; i++) {
+        int err = vmaf_feature_collector_register_with_dict(feature_collector,
+                        s->feature_name_dict, vif_feature_name[i],
+                        &s->feature_id[i]);
+        if (err) return err;
+    }
 
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "VMAF_integer_feature_vif_scale0_score",
-            vif.scale[0].num / vif.scale[0].den, index);
+    s->feature_collector = feature_collector;
+    return 0;
+}
 
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "VMAF_integer_feature_vif_scale1_score",
-            vif.scale[1].num / vif.scale[1].den, index);
+static int write_scores(VmafFeatureCollector *feature_collector, unsigned index,
+                        VifScore vif, VifState *s)
+{
+    int err = register_features(feature_collector, s);
+    if (err) return err;
 
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "VMAF_integer_feature_vif_scale2_score",
-            vif.scale[2].num / vif.scale[2].den, index);
+    const unsigned *id = s->feature_id;
 
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "VMAF_integer_feature_vif_scale3_score",
-            vif.scale[3].num / vif.scale[3].den, index);
+    for (unsigned i = 0; i < 4; i++) {
+        err |= vmaf_feature_collector_append_by_id(feature_collector, id[i],
+                vif.scale[i].num / vif.scale[i].den, index);
+    }
 
     if (!s->debug) return err;
 
@@ -719,48 +805,77 @@ static int write_scores(VmafFeatureCollector *feature_collector, unsigned index,
     const double score =
         score_den == 0.0 ? 1.0f : score_num / score_den;
 
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif", score, index);
-
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_num", score_num, index);
-
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_den", score_den, index);
-
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_num_scale0", vif.scale[0].num,
-            index);
-
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_den_scale0", vif.scale[0].den,
-            index);
-
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_num_scale1", vif.scale[1].num,
-            index);
-
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_den_scale1", vif.scale[1].den,
-            index);
-
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_num_scale2", vif.scale[2].num,
-            index);
+    err |= vmaf_feature_collector_append_by_id(feature_collector, id[4],
+                                               score, index);
+    err |= vmaf_feature_collector_append_by_id(feature_collector, id[5],
+                                               score_num, index);
+    err |= vmaf_feature_collector_append_by_id(feature_collector, id[6],
+                                               score_den, index);
+
+    for (unsigned i = 0; i < 4; i++) {
+        err |= vmaf_feature_collector_append_by_id(feature_collector,
+                id[7 + 2 * i], vif.scale[i].num, index);
+        err |= vmaf_feature_collector_append_by_id(feature_collector,
+                id[8 + 2 * i], vif.scale[i].den, index);
+    }
 
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_den_scale2", vif.scale[2].den,
-            index);
+    return err;
+}
 
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_num_scale3", vif.scale[3].num,
-            index);
+typedef struct VifBandJob {
+    VifState *s;
+    unsigned w, h;
+    int bpc, scale;
+    VifResiduals *residuals;
+} VifBandJob;
 
-    err |= vmaf_feature_collector_append_with_dict(feature_collector,
-            s->feature_name_dict, "integer_vif_den_scale3", vif.scale[3].den,
-            index);
+static void vif_statistic_band(void *data, unsigned band,
+                               unsigned row_begin, unsigned row_end)
+{
+    VifBandJob *job = data;
+    VifState *s = job->s;
+
+    VifPublicState p = s->public;
+    p.buf.tmp = s->band_buf[band].tmp;
+    p.buf.ref = (uint8_t *) p.buf.ref + row_begin * p.buf.stride;
+    p.buf.dis = (uint8_t *) p.buf.dis + row_begin * p.buf.stride;
+
+    const unsigned h = row_end - row_begin;
+    if (job->bpc == 8 && job->scale == 0)
+        s->vif_statistic_8(&p, &job->residuals[band], job->w, h);
+    else
+        s->vif_statistic_16(&p, &job->residuals[band], job->w, h, job->bpc,
+                            job->scale);
+}
 
-    return err;
+static int vif_statistic(VmafFeatureExtractor *fex, VifState *s,
+                         float *num, float *den, unsigned w, unsigned h,
+                         int bpc, int scale)
+{
+    VifResiduals *residuals = s->band_residuals;
+    memset(residuals, 0, sizeof(*residuals) * s->band_cnt);
+
+    VifBandJob job = {
+        .s = s,
+        .w = w,
+        .h = h,
+        .bpc = bpc,
+        .scale = scale,
+        .residuals = residuals,
+    };
+    int err = vmaf_feature_extractor_run_bands(fex, h, s->band_cnt,
+                                               vif_statistic_band, &job);
+    if (err) return err;
+
+    VifResiduals total = { 0 };
+    for (unsigned i = 0; i < s->band_cnt; i++) {
+        total.accum_num_log += residuals[i].accum_num_log;
+        total.accum_den_log += residuals[i].accum_den_log;
+        total.accum_num_non_log += residuals[i].accum_num_non_log;
+        total.accum_den_non_log += residuals[i].accum_den_non_log;
+    }
+    vif_residuals_to_score(&total, num, den);
+    return 0;
 }
 
 static int extract(VmafFeatureExtractor *fex,
@@ -769,6 +884,7 @@ static int extract(VmafFeatureExtractor *fex,
                    unsigned index, VmafFeatureCollector *feature_collector)
 {
     VifState *s = fex->priv;
+    int err = 0;
 
     (void)ref_pic_90;
     (void)dist_pic_90;
@@ -802,13 +918,10 @@ static int extract(VmafFeatureExtractor *fex,
             w /= 2; h /= 2;
         }
 
-        if (ref_pic->bpc == 8 && scale == 0) {
-            s->vif_statistic_8(&s->public, &vif_score.scale[scale].num, &vif_score.scale[scale].den, w, h);
-        }
-        else {
-            s->vif_statistic_16(&s->public, &vif_score.scale[scale].num, &vif_score.scale[scale].den, w, h, ref_pic->bpc, scale);
-        }
-
+        err = vif_statistic(fex, s, &vif_score.scale[scale].num,
+                            &vif_score.scale[scale].den, w, h, ref_pic->bpc,
+                            scale);
+        if (err) return err;
     }
 
     return write_scores(feature_collector, index, vif_score, s);
@@ -818,6 +931,9 @@ static int close(VmafFeatureExtractor *fex)
 {
     VifState *s = fex->priv;
     if (s->public.buf.data) aligned_free(s->public.buf.data);
+    if (s->band_data) aligned_free(s->band_data);
+    free(s->band_buf);
+    free(s->band_residuals);
     return 0;
 }
 
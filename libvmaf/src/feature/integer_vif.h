@@ -75,7 +75,7 @@ typedef struct VifResiduals {
 
 typedef struct VifPublicState {
     VifBuffer buf;
-    uint16_t log2_table[65537];
+    uint16_t *log2_table;
     double vif_enhn_gain_limit;
 } VifPublicState;
 
@@ -115,8 +115,8 @@ static inline void PADDING_SQ_DATA_2(VifBuffer buf, int w, unsigned fwidth_half)
     }
 }
 
-void vif_statistic_8(struct VifPublicState *s, float *num, float *den, unsigned w, unsigned h);
-void vif_statistic_16(struct VifPublicState *s, float *num, float *den, unsigned w, unsigned h, int bpc, int scale);
+void vif_statistic_8(struct VifPublicState *s, VifResiduals *residuals_out, unsigned w, unsigned h);
+void vif_statistic_16(struct VifPublicState *s, VifResiduals *residuals_out, unsigned w, unsigned h, int bpc, int scale);
 
 /*
  * Compute vif residuals on a vertically filtered line 
@@ -34,11 +34,14 @@
  * contrast and structure.
  */
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <assert.h> /* zli-nflx */
 
+#include "mem.h"
 #include "iqa.h"
 #include "convolve.h"
 #include "ssim_tools.h"
@@ -250,3 +253,201 @@ float _iqa_ssim(float *ref, float *cmp, int w, int h, const struct _kernel *k,
     return mr->reduce(w, h, mr->context);
 }
 
+
+void _ssim_filter_h_c(const float *ref, const float *cmp, int w,
+                      const float *k, int k_len,
+                      float *const dst[SSIM_MAP_CNT])
+{
+    int x,u,m;
+    for (x=0; x<w; ++x) {
+        double sum[SSIM_MAP_CNT] = { 0.0 };
+        for (u=0; u<k_len; ++u) {
+            const float r = ref[x+u];
+            const float c = cmp[x+u];
+            sum[0] += r * k[u];
+            sum[1] += c * k[u];
+            sum[2] += (r * r) * k[u];
+            sum[3] += (c * c) * k[u];
+            sum[4] += (r * c) * k[u];
+        }
+        for (m=0; m<SSIM_MAP_CNT; ++m)
+            dst[m][x] = (float)sum[m];
+    }
+}
+
+void _ssim_filter_v_c(const float *const *src, int w,
+                      const float *k, int k_len,
+                      const float C[3], double sum[4])
+{
+    int x,v,m;
+    for (x=0; x<w; ++x) {
+        float f[SSIM_MAP_CNT];
+        for (m=0; m<SSIM_MAP_CNT; ++m) {
+            double acc = 0.0;
+            for (v=0; v<k_len; ++v)
+                acc += src[m*k_len + v][x] * k[v];
+            f[m] = (float)acc;
+        }
+
+        /* same operations and rounding as the default case of _iqa_ssim() */
+        const float ref_mu = f[0];
+        const float cmp_mu = f[1];
+        float ref_sigma_sqd = f[2] - ref_mu * ref_mu;
+        float cmp_sigma_sqd = f[3] - cmp_mu * cmp_mu;
+        ref_sigma_sqd = MAX(0.0f, ref_sigma_sqd);
+        cmp_sigma_sqd = MAX(0.0f, cmp_sigma_sqd);
+        const float sigma_both = f[4] - ref_mu * cmp_mu;
+
+        const float sigma_ref_sigma_cmp = sqrt(ref_sigma_sqd * cmp_sigma_sqd);
+        const double l = (2.0 * ref_mu * cmp_mu + C[0]) / (ref_mu*ref_mu + cmp_mu*cmp_mu + C[0]);
+        const double c = (2.0 * sigma_ref_sigma_cmp + C[1]) / (ref_sigma_sqd + cmp_sigma_sqd + C[1]);
+        const float clamped_sigma_both = (sigma_both < 0.0f &&
+                sigma_ref_sigma_cmp <= 0.0f) ? 0.0f : sigma_both;
+        const double s = (clamped_sigma_both + C[2]) / (sigma_ref_sigma_cmp + C[2]);
+
+        sum[0] += l * c * s;
+        sum[1] += l;
+        sum[2] += c;
+        sum[3] += s;
+    }
+}
+
+void _ssim_decimate_row_c(const float *img, int w, const struct _kernel *k,
+                          int y, int x0, int x1, float *dst)
+{
+    int x,u,v,k_offset;
+    const int uc = k->w/2;
+    const int vc = k->h/2;
+    const int kw_even = (k->w&1)?0:1;
+    const int kh_even = (k->h&1)?0:1;
+    for (x=x0; x<x1; ++x) {
+        double sum = 0.0;
+        k_offset = 0;
+        for (v=-vc; v<=vc-kh_even; ++v) {
+            const float *row = img + (2*y + v)*w + 2*x;
+            for (u=-uc; u<=uc-kw_even; ++u, ++k_offset)
+                sum += row[u] * k->kernel[k_offset];
+        }
+        dst[x] = (float)sum;
+    }
+}
+
+int _iqa_ssim_engine_init(struct _ssim_engine *e, int w, int h)
+{
+    size_t img_sz = 0;
+    int idx;
+    int cur_w = w;
+    int cur_h = h;
+    for (idx=0; idx<SCALES; ++idx) {
+        img_sz += (size_t)cur_w * cur_h;
+        cur_w = cur_w/2 + (cur_w&1);
+        cur_h = cur_h/2 + (cur_h&1);
+    }
+
+    memset(e, 0, sizeof(*e));
+    e->filter_h = _ssim_filter_h_c;
+    e->filter_v = _ssim_filter_v_c;
+    e->decimate_row = _ssim_decimate_row_c;
+    e->w = w;
+    e->h = h;
+    e->row_stride = (w + 15) & ~15;
+
+    const size_t rows_sz =
+        (size_t)SSIM_MAP_CNT * GAUSSIAN_LEN * e->row_stride * sizeof(float);
+    e->rows = aligned_malloc(rows_sz, 64);
+    e->ref = aligned_malloc(img_sz * sizeof(float), 64);
+    e->cmp = aligned_malloc(img_sz * sizeof(float), 64);
+    if (!e->rows || !e->ref || !e->cmp) {
+        _iqa_ssim_engine_close(e);
+        return -ENOMEM;
+    }
+    memset(e->rows, 0, rows_sz);
+    return 0;
+}
+
+void _iqa_ssim_engine_close(struct _ssim_engine *e)
+{
+    if (e->rows) aligned_free(e->rows);
+    if (e->ref) aligned_free(e->ref);
+    if (e->cmp) aligned_free(e->cmp);
+    e->rows = e->ref = e->cmp = NULL;
+}
+
+float _iqa_ssim_fused(struct _ssim_engine *e, const float *ref,
+                      const float *cmp, int w, int h, int stride,
+                      const struct _kernel *k,
+                      float *l_mean, float *c_mean, float *s_mean)
+{
+    const int L = 255;
+    const float K1 = 0.01f, K2 = 0.03f;
+    const float C1 = (K1*L)*(K1*L);
+    const float C2 = (K2*L)*(K2*L);
+    const float C[3] = { C1, C2, C2 / 2.0f };
+    const int dst_w = w - k->w + 1;
+    const int dst_h = h - k->h + 1;
+    float *dst[SSIM_MAP_CNT];
+    const float *src[SSIM_MAP_CNT * GAUSSIAN_LEN];
+    double sum[4] = { 0.0 };
+    int y,v,m;
+
+    if (!k->normalized || k->w > GAUSSIAN_LEN || k->h > GAUSSIAN_LEN ||
+        w > e->row_stride)
+        return INFINITY;
+
+    /* Filter each row horizontally into a ring of k->h rows per map. Once
+     * the ring is full, it holds the rows of the next output row. */
+    for (y=0; y<h; ++y) {
+        for (m=0; m<SSIM_MAP_CNT; ++m)
+            dst[m] = e->rows + (m*GAUSSIAN_LEN + y % k->h) * e->row_stride;
+        e->filter_h(ref + y*stride, cmp + y*stride, dst_w, k->kernel_h, k->w,
+                    dst);
+        if (y < k->h - 1)
+            continue;
+
+        const int top = y - k->h + 1;
+        for (m=0; m<SSIM_MAP_CNT; ++m) {
+            for (v=0; v<k->h; ++v) {
+                src[m*k->h + v] =
+                    e->rows + (m*GAUSSIAN_LEN + (top+v) % k->h) * e->row_stride;
+            }
+        }
+        e->filter_v(src, dst_w, k->kernel_v, k->h, C, sum);
+    }
+
+    *l_mean = (float)(sum[1] / (double)(dst_w*dst_h));
+    *c_mean = (float)(sum[2] / (double)(dst_w*dst_h));
+    *s_mean = (float)(sum[3] / (double)(dst_w*dst_h));
+    return (float)(sum[0] / (double)(dst_w*dst_h));
+}
+
+int _iqa_ssim_decimate(struct _ssim_engine *e, const float *img, int w, int h,
+                       const struct _kernel *k, float *result,
+                       int *rw, int *rh)
+{
+    int x,y;
+    const int sw = w/2 + (w&1);
+    const int sh = h/2 + (h&1);
+    const int uc = k->w/2;
+    const int vc = k->h/2;
+    /* columns whose kernel fits in img, see _iqa_filter_pixel() */
+    const int x0 = MIN((uc + 1) / 2, sw);
+    const int x1 = MIN(MAX(x0, (w - uc + 1) / 2), sw);
+
+    for (y=0; y<sh; ++y) {
+        float *dst = result + y*sw;
+        if (2*y < vc || 2*y >= h-vc) {
+            for (x=0; x<sw; ++x)
+                dst[x] = _iqa_filter_pixel(img, w, h, 2*x, 2*y, k, 1.0f);
+            continue;
+        }
+        for (x=0; x<x0; ++x)
+            dst[x] = _iqa_filter_pixel(img, w, h, 2*x, 2*y, k, 1.0f);
+        e->decimate_row(img, w, k, y, x0, x1, dst);
+        for (x=x1; x<sw; ++x)
+            dst[x] = _iqa_filter_pixel(img, w, h, 2*x, 2*y, k, 1.0f);
+    }
+
+    if (rw) *rw = sw;
+    if (rh) *rh = sh;
+    return 0;
+}
@@ -118,4 +118,83 @@ float _iqa_ssim(float *ref, float *cmp, int w, int h, const struct _kernel *k,
 		, float *l_mean, float *c_mean, float *s_mean /* zli-nflx */
 		);
 
+/* Maps filtered by the fused SSIM engine: ref, cmp, ref^2, cmp^2, ref*cmp */
+#define SSIM_MAP_CNT 5
+
+/*
+ * Row kernels of the fused SSIM engine.
+ *
+ * _ssim_filter_h filters one row of ref and cmp horizontally into the
+ * SSIM_MAP_CNT maps, producing w values per map.
+ *
+ * _ssim_filter_v filters k_len rows of each map vertically, src holding the
+ * row pointers map by map, and adds the SSIM, luminance, contrast and
+ * structure of the w resulting pixels to sum[0..3]. It may compute, but does
+ * not sum, padding pixels up to w rounded up to 16.
+ *
+ * The SIMD versions round exactly like the C versions, which in turn match
+ * _iqa_convolve() and the default case of _iqa_ssim().
+ */
+typedef void (*_ssim_filter_h)(const float *ref, const float *cmp, int w,
+                               const float *k, int k_len,
+                               float *const dst[SSIM_MAP_CNT]);
+typedef void (*_ssim_filter_v)(const float *const *src, int w,
+                               const float *k, int k_len,
+                               const float C[3], double sum[4]);
+
+/*
+ * _ssim_decimate_row computes pixels x0 to x1-1 of row y of img decimated by
+ * 2, for pixels where the kernel fits in img. Rounds like _iqa_filter_pixel().
+ */
+typedef void (*_ssim_decimate_row)(const float *img, int w,
+                                   const struct _kernel *k, int y,
+                                   int x0, int x1, float *dst);
+
+void _ssim_filter_h_c(const float *ref, const float *cmp, int w,
+                      const float *k, int k_len,
+                      float *const dst[SSIM_MAP_CNT]);
+void _ssim_filter_v_c(const float *const *src, int w,
+                      const float *k, int k_len,
+                      const float C[3], double sum[4]);
+void _ssim_decimate_row_c(const float *img, int w, const struct _kernel *k,
+                          int y, int x0, int x1, float *dst);
+
+/*
+ * Scratch buffers and row kernels of the fused SSIM engine, allocated once
+ * for a given frame size and reused for every frame.
+ */
+struct _ssim_engine {
+    _ssim_filter_h filter_h;
+    _ssim_filter_v filter_v;
+    _ssim_decimate_row decimate_row;
+    float *rows;    /* ring of GAUSSIAN_LEN horizontally filtered rows per map */
+    int row_stride; /* in floats, a multiple of 16 */
+    float *ref;     /* packed (and downscaled) copies of ref and cmp, with */
+    float *cmp;     /* room for all SCALES of ms_ssim */
+    int w;
+    int h;
+};
+
+/* Returns 0 on success, -ENOMEM otherwise. Selects the C kernels. */
+int _iqa_ssim_engine_init(struct _ssim_engine *e, int w, int h);
+void _iqa_ssim_engine_close(struct _ssim_engine *e);
+
+/*
+ * Same as the default case of _iqa_ssim() (args and mr set to 0), computing
+ * the means, variances and covariance of each output row in a single pass
+ * over the rows of ref and cmp. Works on strided input and needs no
+ * allocations.
+ */
+float _iqa_ssim_fused(struct _ssim_engine *e, const float *ref,
+                      const float *cmp, int w, int h, int stride,
+                      const struct _kernel *k,
+                      float *l_mean, float *c_mean, float *s_mean);
+
+/*
+ * Same as _iqa_decimate() with a factor of 2 and a separate result buffer.
+ */
+int _iqa_ssim_decimate(struct _ssim_engine *e, const float *img, int w, int h,
+                       const struct _kernel *k, float *result,
+                       int *rw, int *rh);
+
 #endif /* _SSIM_TOOLS_H_ */
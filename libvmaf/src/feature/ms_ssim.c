@@ -87,35 +87,9 @@ float _ms_ssim_reduce(int w, int h, void *ctx)
     return (float)(ms_ctx->l * ms_ctx->c * ms_ctx->s);
 }
 
-/* Releases the scaled buffers */
-void _free_buffers(float **buf, int scales)
-{
-    int idx;
-    for (idx=0; idx<scales; ++idx)
-        free(buf[idx]);
-}
-
-/* Allocates the scaled buffers. If error, all buffers are free'd */
-int _alloc_buffers(float **buf, int w, int h, int scales)
-{
-    int idx;
-    int cur_w = w;
-    int cur_h = h;
-    for (idx=0; idx<scales; ++idx) {
-        buf[idx] = (float*)malloc(cur_w*cur_h*sizeof(float));
-        if (!buf[idx]) {
-            _free_buffers(buf, idx);
-            return 1;
-        }
-        cur_w = cur_w/2 + (cur_w&1);
-        cur_h = cur_h/2 + (cur_h&1);
-    }
-    return 0;
-}
-
-int compute_ms_ssim(const float *ref, const float *cmp, int w, int h,
-        int ref_stride, int cmp_stride, double *score,
-        double* l_scores, double* c_scores, double* s_scores)
+int compute_ms_ssim(struct _ssim_engine *engine, const float *ref,
+        const float *cmp, int w, int h, int ref_stride, int cmp_stride,
+        double *score, double* l_scores, double* c_scores, double* s_scores)
 {
 
     int ret = 1;
@@ -126,7 +100,7 @@ int compute_ms_ssim(const float *ref, const float *cmp, int w, int h,
     const float *alphas=g_alphas, *betas=g_betas, *gammas=g_gammas;
     int idx,x,y,cur_w,cur_h;
     int offset,src_offset;
-    float **ref_imgs, **cmp_imgs; /* Array of pointers to scaled images */
+    float *ref_imgs[SCALES], *cmp_imgs[SCALES]; /* Scaled images */
     double msssim;
     float l, c, s;
     struct _kernel lpf, window;
@@ -151,7 +125,7 @@ int compute_ms_ssim(const float *ref, const float *cmp, int w, int h,
     if (args) {
         wang   = args->wang;
         gauss  = args->gaussian;
-        scales = args->scales;
+        scales = _min(args->scales, SCALES);
         if (args->alphas)
             alphas = args->alphas;
         if (args->betas)
@@ -189,30 +163,16 @@ int compute_ms_ssim(const float *ref, const float *cmp, int w, int h,
     mr.map     = _ms_ssim_map;
     mr.reduce  = _ms_ssim_reduce;
 
-    /* allocate the scaled image buffers */
-    ref_imgs = (float**)malloc(scales*sizeof(float*));
-    cmp_imgs = (float**)malloc(scales*sizeof(float*));
-    if (!ref_imgs || !cmp_imgs) {
-        if (ref_imgs) free(ref_imgs);
-        if (cmp_imgs) free(cmp_imgs);
-        printf("error: unable to malloc ref_imgs or cmp_imgs.\n");
-        fflush(stdout);
-        goto fail_or_end;
-    }
-    if (_alloc_buffers(ref_imgs, w, h, scales)) {
-        free(ref_imgs);
-        free(cmp_imgs);
-        printf("error: unable to _alloc_buffers on ref_imgs.\n");
-        fflush(stdout);
-        goto fail_or_end;
-    }
-    if (_alloc_buffers(cmp_imgs, w, h, scales)) {
-        _free_buffers(ref_imgs, scales);
-        free(ref_imgs);
-        free(cmp_imgs);
-        printf("error: unable to _alloc_buffers on cmp_imgs.\n");
-        fflush(stdout);
-        goto fail_or_end;
+    /* the scaled images live in the engine, one after the other */
+    ref_imgs[0] = engine->ref;
+    cmp_imgs[0] = engine->cmp;
+    cur_w = w;
+    cur_h = h;
+    for (idx=1; idx<scales; ++idx) {
+        ref_imgs[idx] = ref_imgs[idx-1] + cur_w*cur_h;
+        cmp_imgs[idx] = cmp_imgs[idx-1] + cur_w*cur_h;
+        cur_w = cur_w/2 + (cur_w&1);
+        cur_h = cur_h/2 + (cur_h&1);
     }
 
     /* copy original images into first scale buffer, forcing stride = width. */
@@ -235,13 +195,9 @@ int compute_ms_ssim(const float *ref, const float *cmp, int w, int h,
     lpf.normalized = 1;
     lpf.bnd_opt = KBND_SYMMETRIC;
     for (idx=1; idx<scales; ++idx) {
-        if (_iqa_decimate(ref_imgs[idx-1], cur_w, cur_h, 2, &lpf, ref_imgs[idx], 0, 0) ||
-            _iqa_decimate(cmp_imgs[idx-1], cur_w, cur_h, 2, &lpf, cmp_imgs[idx], &cur_w, &cur_h))
+        if (_iqa_ssim_decimate(engine, ref_imgs[idx-1], cur_w, cur_h, &lpf, ref_imgs[idx], 0, 0) ||
+            _iqa_ssim_decimate(engine, cmp_imgs[idx-1], cur_w, cur_h, &lpf, cmp_imgs[idx], &cur_w, &cur_h))
         {
-            _free_buffers(ref_imgs, scales);
-            _free_buffers(cmp_imgs, scales);
-            free(ref_imgs);
-            free(cmp_imgs);
             printf("error: decimation fails on ref_imgs or cmp_imgs.\n");
             fflush(stdout);
             goto fail_or_end;
@@ -287,7 +243,7 @@ int compute_ms_ssim(const float *ref, const float *cmp, int w, int h,
             */
 
             /* above is equivalent to passing default parameter: */
-            _iqa_ssim(ref_imgs[idx], cmp_imgs[idx], cur_w, cur_h, &window, NULL, NULL, &l, &c, &s);
+            _iqa_ssim_fused(engine, ref_imgs[idx], cmp_imgs[idx], cur_w, cur_h, cur_w, &window, &l, &c, &s);
 
         }
 
@@ -297,10 +253,6 @@ int compute_ms_ssim(const float *ref, const float *cmp, int w, int h,
         s_scores[idx] = s;
 
         if (msssim == INFINITY) {
-            _free_buffers(ref_imgs, scales);
-            _free_buffers(cmp_imgs, scales);
-            free(ref_imgs);
-            free(cmp_imgs);
             printf("error: ms_ssim is INFINITY.\n");
             fflush(stdout);
             goto fail_or_end;
@@ -309,11 +261,6 @@ int compute_ms_ssim(const float *ref, const float *cmp, int w, int h,
         cur_h = cur_h/2 + (cur_h&1);
     }
 
-    _free_buffers(ref_imgs, scales);
-    _free_buffers(cmp_imgs, scales);
-    free(ref_imgs);
-    free(cmp_imgs);
-
     *score = msssim;
 
     ret = 0;
@@ -20,6 +20,10 @@
 
 #include <libvmaf/picture.h>
 
+#include "mem.h"
+#include "picture_cache.h"
+#include "picture_copy.h"
+
 void picture_copy_hbd(float *dst, ptrdiff_t dst_stride,
                       VmafPicture *src, int offset, float scaler)
 {
@@ -59,3 +63,19 @@ void picture_copy(float *dst, ptrdiff_t dst_stride,
 
     return;
 }
+
+static int fill_float_luma(VmafPicture *pic, int offset, void *data,
+                           void *cookie)
+{
+    (void) cookie;
+    picture_copy(data, ALIGN_CEIL(pic->w[0] * sizeof(float)), pic, offset,
+                 pic->bpc);
+    return 0;
+}
+
+const float *picture_copy_cached(VmafPicture *pic, int offset)
+{
+    const size_t stride = ALIGN_CEIL(pic->w[0] * sizeof(float));
+    return vmaf_picture_cache_get(pic, VMAF_PICTURE_CACHE_FLOAT_LUMA, offset,
+                                  stride * pic->h[0], fill_float_luma, NULL);
+}
@@ -19,3 +19,10 @@
 
 void picture_copy(float *dst, ptrdiff_t dst_stride, VmafPicture *src,
                   int offset, unsigned bpc);
+
+/**
+ * Luma of pic as written by picture_copy() with a stride of
+ * ALIGN_CEIL(w * sizeof(float)), converted once per picture and shared by
+ * every feature extractor asking for the same offset. NULL on ENOMEM.
+ */
+const float *picture_copy_cached(VmafPicture *pic, int offset);
@@ -31,10 +31,25 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdint.h>
 #include <string.h>
 
+#include "cpu.h"
 #include "feature_collector.h"
 #include "feature_extractor.h"
 #include "log.h"
 
+#if ARCH_X86
+#include "x86/psnr_hvs_avx2.h"
+#elif ARCH_AARCH64
+#include "arm64/psnr_hvs_neon.h"
+#endif
+
+typedef struct PsnrHvsState {
+    void (*calc_blocks)(const unsigned char *src, int src_stride,
+                        const unsigned char *dst, int dst_stride, int depth,
+                        int step, float mask[8][8], float csf[8][8],
+                        float *ret);
+    unsigned block_cnt;
+} PsnrHvsState;
+
 typedef int32_t od_coeff;
 
 #define OD_DCT_OVERFLOW_CHECK(val, scale, offset, idx)
@@ -200,19 +215,119 @@ static float csf_cr420[8][8] = {
     {0.593906509971, 0.802254508198, 0.706020324706, 0.587716619023, 0.478717061273, 0.393021669543, 0.330555063063, 0.285345396658}
 };
 
+/*
+ * Adds the masked and weighted squared errors of the 8x8 block at
+ * _src/_dst to *ret, in raster order.
+ */
+static void calc_block(const unsigned char *_src, int _systride,
+                       const unsigned char *_dst, int _dystride,
+                       int depth, float mask[8][8], float _csf[8][8],
+                       float *ret)
+{
+    od_coeff dct_s[8 * 8];
+    od_coeff dct_d[8 * 8];
+    int i;
+    int j;
+    float s_means[4];
+    float d_means[4];
+    float s_vars[4];
+    float d_vars[4];
+    float s_gmean = 0;
+    float d_gmean = 0;
+    float s_gvar = 0;
+    float d_gvar = 0;
+    float s_mask = 0;
+    float d_mask = 0;
+    for (i = 0; i < 4; i++)
+        s_means[i] = d_means[i] = s_vars[i] = d_vars[i] = 0;
+    for (i = 0; i < 8; i++) {
+        for (j = 0; j < 8; j++) {
+            int sub = ((i & 12) >> 2) + ((j & 12) >> 1);
+            if (depth > 8) {
+                dct_s[i * 8 + j] =
+                    _src[i * _systride + j * 2] +
+                    (_src[i * _systride + j * 2 + 1] << 8);
+                dct_d[i * 8 + j] =
+                    _dst[i * _dystride + j * 2] +
+                    (_dst[i * _dystride + j * 2 + 1] << 8);
+            } else {
+                dct_s[i * 8 + j] = _src[i * _systride + j];
+                dct_d[i * 8 + j] = _dst[i * _dystride + j];
+            }
+            s_gmean += dct_s[i * 8 + j];
+            d_gmean += dct_d[i * 8 + j];
+            s_means[sub] += dct_s[i * 8 + j];
+            d_means[sub] += dct_d[i * 8 + j];
+        }
+    }
+    s_gmean /= 64.f;
+    d_gmean /= 64.f;
+    for (i = 0; i < 4; i++)
+        s_means[i] /= 16.f;
+    for (i = 0; i < 4; i++)
+        d_means[i] /= 16.f;
+    for (i = 0; i < 8; i++) {
+        for (j = 0; j < 8; j++) {
+            int sub = ((i & 12) >> 2) + ((j & 12) >> 1);
+            s_gvar += (dct_s[i * 8 + j] - s_gmean) *
+                      (dct_s[i * 8 + j] - s_gmean);
+            d_gvar += (dct_d[i * 8 + j] - d_gmean) *
+                      (dct_d[i * 8 + j] - d_gmean);
+            s_vars[sub] += (dct_s[i * 8 + j] - s_means[sub]) *
+                           (dct_s[i * 8 + j] - s_means[sub]);
+            d_vars[sub] += (dct_d[i * 8 + j] - d_means[sub]) *
+                           (dct_d[i * 8 + j] - d_means[sub]);
+        }
+    }
+    s_gvar *= 1 / 63.f * 64;
+    d_gvar *= 1 / 63.f * 64;
+    for (i = 0; i < 4; i++)
+        s_vars[i] *= 1 / 15.f * 16;
+    for (i = 0; i < 4; i++)
+        d_vars[i] *= 1 / 15.f * 16;
+    if (s_gvar > 0)
+        s_gvar =
+            (s_vars[0] + s_vars[1] + s_vars[2] + s_vars[3]) / s_gvar;
+    if (d_gvar > 0)
+        d_gvar =
+            (d_vars[0] + d_vars[1] + d_vars[2] + d_vars[3]) / d_gvar;
+    od_bin_fdct8x8(dct_s, 8, dct_s, 8);
+    od_bin_fdct8x8(dct_d, 8, dct_d, 8);
+    for (i = 0; i < 8; i++)
+        for (j = (i == 0); j < 8; j++)
+            s_mask += dct_s[i * 8 + j] * dct_s[i * 8 + j] * mask[i][j];
+    for (i = 0; i < 8; i++)
+        for (j = (i == 0); j < 8; j++)
+            d_mask += dct_d[i * 8 + j] * dct_d[i * 8 + j] * mask[i][j];
+    s_mask = sqrt(s_mask * s_gvar) / 32.f;
+    d_mask = sqrt(d_mask * d_gvar) / 32.f;
+    if (d_mask > s_mask)
+        s_mask = d_mask;
+    for (i = 0; i < 8; i++) {
+        for (j = 0; j < 8; j++) {
+            float err;
+            err = abs(dct_s[i * 8 + j] - dct_d[i * 8 + j]);
+            if (i != 0 || j != 0)
+                err = err < s_mask / mask[i][j]
+                          ? 0
+                          : err - s_mask / mask[i][j];
+            *ret += (err * _csf[i][j]) * (err * _csf[i][j]);
+        }
+    }
+}
+
 static double calc_psnrhvs(const unsigned char *_src, int _systride,
                            const unsigned char *_dst, int _dystride,
                            double _par, int depth, int _w, int _h, int _step,
-                           float _csf[8][8])
+                           float _csf[8][8], const PsnrHvsState *s)
 {
     float ret;
-    od_coeff dct_s[8 * 8];
-    od_coeff dct_d[8 * 8];
     float mask[8][8];
     int pixels;
     int x;
     int y;
     int32_t samplemax;
+    const int bytes = depth > 8 ? 2 : 1;
     (void)_par;
     ret = pixels = 0;
     /*
@@ -239,96 +354,24 @@ static double calc_psnrhvs(const unsigned char *_src, int _systride,
                          (_csf[x][y] * 0.3885746225901003);
 
     for (y = 0; y < _h - 7; y += _step) {
-        for (x = 0; x < _w - 7; x += _step) {
-            int i;
-            int j;
-            float s_means[4];
-            float d_means[4];
-            float s_vars[4];
-            float d_vars[4];
-            float s_gmean = 0;
-            float d_gmean = 0;
-            float s_gvar = 0;
-            float d_gvar = 0;
-            float s_mask = 0;
-            float d_mask = 0;
-            for (i = 0; i < 4; i++)
-                s_means[i] = d_means[i] = s_vars[i] = d_vars[i] = 0;
-            for (i = 0; i < 8; i++) {
-                for (j = 0; j < 8; j++) {
-                    int sub = ((i & 12) >> 2) + ((j & 12) >> 1);
-                    if (depth > 8) {
-                        dct_s[i * 8 + j] =
-                            _src[(y + i) * _systride + (j + x) * 2] +
-                            (_src[(y + i) * _systride + (j + x) * 2 + 1] << 8);
-                        dct_d[i * 8 + j] =
-                            _dst[(y + i) * _dystride + (j + x) * 2] +
-                            (_dst[(y + i) * _dystride + (j + x) * 2 + 1] << 8);
-                    } else {
-                        dct_s[i * 8 + j] = _src[(y + i) * _systride + (j + x)];
-                        dct_d[i * 8 + j] = _dst[(y + i) * _dystride + (j + x)];
-                    }
-                    s_gmean += dct_s[i * 8 + j];
-                    d_gmean += dct_d[i * 8 + j];
-                    s_means[sub] += dct_s[i * 8 + j];
-                    d_means[sub] += dct_d[i * 8 + j];
-                }
-            }
-            s_gmean /= 64.f;
-            d_gmean /= 64.f;
-            for (i = 0; i < 4; i++)
-                s_means[i] /= 16.f;
-            for (i = 0; i < 4; i++)
-                d_means[i] /= 16.f;
-            for (i = 0; i < 8; i++) {
-                for (j = 0; j < 8; j++) {
-                    int sub = ((i & 12) >> 2) + ((j & 12) >> 1);
-                    s_gvar += (dct_s[i * 8 + j] - s_gmean) *
-                              (dct_s[i * 8 + j] - s_gmean);
-                    d_gvar += (dct_d[i * 8 + j] - d_gmean) *
-                              (dct_d[i * 8 + j] - d_gmean);
-                    s_vars[sub] += (dct_s[i * 8 + j] - s_means[sub]) *
-                                   (dct_s[i * 8 + j] - s_means[sub]);
-                    d_vars[sub] += (dct_d[i * 8 + j] - d_means[sub]) *
-                                   (dct_d[i * 8 + j] - d_means[sub]);
-                }
-            }
-            s_gvar *= 1 / 63.f * 64;
-            d_gvar *= 1 / 63.f * 64;
-            for (i = 0; i < 4; i++)
-                s_vars[i] *= 1 / 15.f * 16;
-            for (i = 0; i < 4; i++)
-                d_vars[i] *= 1 / 15.f * 16;
-            if (s_gvar > 0)
-                s_gvar =
-                    (s_vars[0] + s_vars[1] + s_vars[2] + s_vars[3]) / s_gvar;
-            if (d_gvar > 0)
-                d_gvar =
-                    (d_vars[0] + d_vars[1] + d_vars[2] + d_vars[3]) / d_gvar;
-            od_bin_fdct8x8(dct_s, 8, dct_s, 8);
-            od_bin_fdct8x8(dct_d, 8, dct_d, 8);
-            for (i = 0; i < 8; i++)
-                for (j = (i == 0); j < 8; j++)
-                    s_mask += dct_s[i * 8 + j] * dct_s[i * 8 + j] * mask[i][j];
-            for (i = 0; i < 8; i++)
-                for (j = (i == 0); j < 8; j++)
-                    d_mask += dct_d[i * 8 + j] * dct_d[i * 8 + j] * mask[i][j];
-            s_mask = sqrt(s_mask * s_gvar) / 32.f;
-            d_mask = sqrt(d_mask * d_gvar) / 32.f;
-            if (d_mask > s_mask)
-                s_mask = d_mask;
-            for (i = 0; i < 8; i++) {
-                for (j = 0; j < 8; j++) {
-                    float err;
-                    err = abs(dct_s[i * 8 + j] - dct_d[i * 8 + j]);
-                    if (i != 0 || j != 0)
-                        err = err < s_mask / mask[i][j]
-                                  ? 0
-                                  : err - s_mask / mask[i][j];
-                    ret += (err * _csf[i][j]) * (err * _csf[i][j]);
-                    pixels++;
-                }
+        for (x = 0; x < _w - 7;) {
+            const unsigned char *src = _src + y * _systride + x * bytes;
+            const unsigned char *dst = _dst + y * _dystride + x * bytes;
+            const int left = (_w - 7 - x + _step - 1) / _step;
+            int cnt;
+            /*The SIMD kernels run calc_block() on several blocks of a row at
+              once, one block per lane, and add to ret in block order.*/
+            if (s->calc_blocks && left >= (int)s->block_cnt) {
+                cnt = s->block_cnt;
+                s->calc_blocks(src, _systride, dst, _dystride, depth, _step,
+                               mask, _csf, &ret);
+            } else {
+                cnt = 1;
+                calc_block(src, _systride, dst, _dystride, depth, mask, _csf,
+                           &ret);
             }
+            pixels += 64 * cnt;
+            x += _step * cnt;
         }
     }
     ret /= pixels;
@@ -345,8 +388,7 @@ static double convert_score_db(double _score, double _weight)
 static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
                 unsigned bpc, unsigned w, unsigned h)
 {
-    (void) fex;
-    (void) bpc;
+    PsnrHvsState *s = fex->priv;
     (void) w;
     (void) h;
 
@@ -360,8 +402,22 @@ static int init(VmafFeatureExtractor *fex, enum VmafPixelFormat pix_fmt,
 
     if (pix_fmt == VMAF_PIX_FMT_YUV400P)
         return -EINVAL;
-    else
-        return 0;
+
+#if ARCH_X86
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_X86_CPU_FLAG_AVX2) {
+        s->calc_blocks = psnr_hvs_calc_blocks_avx2;
+        s->block_cnt = 8;
+    }
+#elif ARCH_AARCH64
+    unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_ARM_CPU_FLAG_NEON) {
+        s->calc_blocks = psnr_hvs_calc_blocks_neon;
+        s->block_cnt = 4;
+    }
+#endif
+
+    return 0;
 }
 
 static int extract(VmafFeatureExtractor *fex, VmafPicture *ref_pic,
@@ -369,6 +425,7 @@ static int extract(VmafFeatureExtractor *fex, VmafPicture *ref_pic,
                    VmafPicture *dist_pic_90, unsigned index,
                    VmafFeatureCollector *feature_collector)
 {
+    PsnrHvsState *s = fex->priv;
     int err = 0;
 
     (void)ref_pic_90;
@@ -380,7 +437,7 @@ static int extract(VmafFeatureExtractor *fex, VmafPicture *ref_pic,
             calc_psnrhvs(ref_pic->data[i], ref_pic->stride[i],
                          dist_pic->data[i], dist_pic->stride[i], 1.0,
                          ref_pic->bpc, ref_pic->w[i], ref_pic->h[i], 7,
-                         i == 0 ? csf_y : i == 1 ? csf_cb420 : csf_cr420);
+                         i == 0 ? csf_y : i == 1 ? csf_cb420 : csf_cr420, s);
 
         err |= vmaf_feature_collector_append(feature_collector,
                                              fex->provided_features[i],
@@ -404,5 +461,6 @@ VmafFeatureExtractor vmaf_fex_psnr_hvs = {
     .name = "psnr_hvs",
     .init = init,
     .extract = extract,
+    .priv_size = sizeof(PsnrHvsState),
     .provided_features = provided_features,
 };
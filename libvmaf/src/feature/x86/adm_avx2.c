@@ -20,256 +20,908 @@
 
 #include <immintrin.h>
 
-void adm_dwt2_8_avx2(const uint8_t *src, const adm_dwt_band_t *dst,
-                     AdmBuffer *buf, int w, int h, int src_stride,
-                     int dst_stride)
-{
-    const int16_t *filter_lo = dwt2_db2_coeffs_lo;
-    const int16_t *filter_hi = dwt2_db2_coeffs_hi;
-
-    const int16_t shift_HP = 16;
-    const int32_t add_shift_HP = 32768;
-    int **ind_y = buf->ind_y;
-    int **ind_x = buf->ind_x;
-
-    int16_t *tmplo = (int16_t *)buf->tmp_ref;
-    int16_t *tmphi = tmplo + w;
-    int32_t accum;
-
-    __m256i dwt2_db2_coeffs_lo_sum_const = _mm256_set1_epi32(5931776);
-    __m256i fl0 =
-        _mm256_broadcastd_epi32(_mm_loadu_si128((__m128i *)filter_lo));
-    __m256i fl1 =
-        _mm256_broadcastd_epi32(_mm_loadu_si128((__m128i *)(filter_lo + 2)));
-    __m256i fh0 =
-        _mm256_broadcastd_epi32(_mm_loadu_si128((__m128i *)filter_hi));
-    __m256i fh1 =
-        _mm256_broadcastd_epi32(_mm_loadu_si128((__m128i *)(filter_hi + 2)));
-    __m256i add_shift_VP_vex = _mm256_set1_epi32(128);
-    __m256i pad_register = _mm256_setzero_si256();
-    __m256i add_shift_HP_vex = _mm256_set1_epi32(32768);
-
-    for (int i = 0; i < (h + 1) / 2; ++i) {
-        /* Vertical pass. */
-
-        for (int j = 0; j < w; j = j + 16) {
-
-            __m256i accum_mu2_lo, accum_mu2_hi, accum_mu1_lo, accum_mu1_hi;
-            accum_mu2_lo = accum_mu2_hi = accum_mu1_lo = accum_mu1_hi =
-                _mm256_setzero_si256();
-            __m256i s0, s1, s2, s3;
-
-            s0 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(src + (ind_y[0][i] * src_stride) + j)));
-            s1 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(src + (ind_y[1][i] * src_stride) + j)));
-            s2 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(src + (ind_y[2][i] * src_stride) + j)));
-            s3 = _mm256_cvtepu8_epi16(_mm_loadu_si128(
-                (__m128i *)(src + (ind_y[3][i] * src_stride) + j)));
-
-            __m256i s0lo = _mm256_unpacklo_epi16(s0, s1);
-            __m256i s0hi = _mm256_unpackhi_epi16(s0, s1);
-            accum_mu2_lo =
-                _mm256_add_epi32(accum_mu2_lo, _mm256_madd_epi16(s0lo, fl0));
-            accum_mu2_hi =
-                _mm256_add_epi32(accum_mu2_hi, _mm256_madd_epi16(s0hi, fl0));
-
-            __m256i s1lo = _mm256_unpacklo_epi16(s2, s3);
-            __m256i s1hi = _mm256_unpackhi_epi16(s2, s3);
-            accum_mu2_lo =
-                _mm256_add_epi32(accum_mu2_lo, _mm256_madd_epi16(s1lo, fl1));
-            accum_mu2_hi =
-                _mm256_add_epi32(accum_mu2_hi, _mm256_madd_epi16(s1hi, fl1));
-
-            accum_mu2_lo =
-                _mm256_sub_epi32(accum_mu2_lo, dwt2_db2_coeffs_lo_sum_const);
-            accum_mu2_hi =
-                _mm256_sub_epi32(accum_mu2_hi, dwt2_db2_coeffs_lo_sum_const);
-
-            accum_mu2_lo = _mm256_add_epi32(accum_mu2_lo, add_shift_VP_vex);
-            accum_mu2_lo = _mm256_srli_epi32(accum_mu2_lo, 0x08);
-            accum_mu2_hi = _mm256_add_epi32(accum_mu2_hi, add_shift_VP_vex);
-            accum_mu2_hi = _mm256_srli_epi32(accum_mu2_hi, 0x08);
-            accum_mu2_lo = _mm256_blend_epi16(accum_mu2_lo, pad_register, 0xAA);
-            accum_mu2_hi = _mm256_blend_epi16(accum_mu2_hi, pad_register, 0xAA);
-
-            accum_mu2_hi = _mm256_packus_epi32(accum_mu2_lo, accum_mu2_hi);
-            _mm256_storeu_si256((__m256i *)(tmplo + j), accum_mu2_hi);
-
-            accum_mu1_lo =
-                _mm256_add_epi32(accum_mu1_lo, _mm256_madd_epi16(s0lo, fh0));
-            accum_mu1_hi =
-                _mm256_add_epi32(accum_mu1_hi, _mm256_madd_epi16(s0hi, fh0));
-            accum_mu1_lo =
-                _mm256_add_epi32(accum_mu1_lo, _mm256_madd_epi16(s1lo, fh1));
-            accum_mu1_hi =
-                _mm256_add_epi32(accum_mu1_hi, _mm256_madd_epi16(s1hi, fh1));
-
-            accum_mu1_lo = _mm256_add_epi32(accum_mu1_lo, add_shift_VP_vex);
-            accum_mu1_lo = _mm256_srli_epi32(accum_mu1_lo, 0x08);
-            accum_mu1_hi = _mm256_add_epi32(accum_mu1_hi, add_shift_VP_vex);
-            accum_mu1_hi = _mm256_srli_epi32(accum_mu1_hi, 0x08);
-            accum_mu1_lo = _mm256_blend_epi16(accum_mu1_lo, pad_register, 0xAA);
-            accum_mu1_hi = _mm256_blend_epi16(accum_mu1_hi, pad_register, 0xAA);
-            accum_mu1_hi = _mm256_packus_epi32(accum_mu1_lo, accum_mu1_hi);
-            _mm256_storeu_si256((__m256i *)(tmphi + j), accum_mu1_hi);
-            // for( int k =0; k<16;k++){
-            //     fprintf(stderr, "actual value hi tmp is %d \n",tmphi[j +k]);
-            // }
+static inline __m256i sra_epi64(__m256i x, __m128i cnt)
+{
+    const __m256i sign = _mm256_cmpgt_epi64(_mm256_setzero_si256(), x);
+    return _mm256_xor_si256(_mm256_srl_epi64(_mm256_xor_si256(x, sign), cnt),
+                            sign);
+}
+
+static inline __m256i srav_epi64(__m256i x, __m256i cnt)
+{
+    const __m256i sign = _mm256_cmpgt_epi64(_mm256_setzero_si256(), x);
+    return _mm256_xor_si256(_mm256_srlv_epi64(_mm256_xor_si256(x, sign), cnt),
+                            sign);
+}
+
+/* Interleaves the low dwords of the 64-bit lanes of even and odd. */
+static inline __m256i merge_epi64_lo(__m256i even, __m256i odd)
+{
+    return _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+}
+
+/* Packs 16 int32 to int16, truncating like a C cast would. */
+static inline __m256i trunc_pack_epi32(__m256i lo, __m256i hi)
+{
+    lo = _mm256_srai_epi32(_mm256_slli_epi32(lo, 16), 16);
+    hi = _mm256_srai_epi32(_mm256_slli_epi32(hi, 16), 16);
+    return _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+}
+
+static inline __m256i load_epi16_epi32(const int16_t *p)
+{
+    return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)p));
+}
+
+static inline void store_epi32_epi16(int16_t *p, __m256i x)
+{
+    x = _mm256_srai_epi32(_mm256_slli_epi32(x, 16), 16);
+    x = _mm256_permute4x64_epi64(_mm256_packs_epi32(x, x), 0x08);
+    _mm_storeu_si128((__m128i *)p, _mm256_castsi256_si128(x));
+}
+
+/*
+ * Signed 64-bit products of the int32 lanes of a with the uint32 lanes of
+ * b, for the even (lo) and odd (hi) lanes.
+ */
+static inline void mul_epi32_epu32(__m256i a, __m256i b, __m256i *even,
+                                   __m256i *odd)
+{
+    const __m256i a_odd = _mm256_srli_epi64(a, 32);
+    const __m256i b_odd = _mm256_srli_epi64(b, 32);
+    *even = _mm256_mul_epi32(a, b);
+    *odd = _mm256_mul_epi32(a_odd, b_odd);
+    // mul_epi32 takes b as signed, add back a << 32 where it is not
+    const __m256i b_neg = _mm256_cmpgt_epi32(_mm256_setzero_si256(), b);
+    const __m256i fix = _mm256_and_si256(a, b_neg);
+    *even = _mm256_add_epi64(*even, _mm256_slli_epi64(fix, 32));
+    *odd = _mm256_add_epi64(*odd,
+                            _mm256_and_si256(fix, _mm256_set1_epi64x(
+                                             (int64_t)0xFFFFFFFF00000000)));
+}
+
+/* (int32_t)(((int64_t)a * b + add) >> shift) with b unsigned. */
+static inline __m256i mul_round_epi32(__m256i a, __m256i b, __m256i add,
+                                      __m128i shift)
+{
+    __m256i even, odd;
+    mul_epi32_epu32(a, b, &even, &odd);
+    even = sra_epi64(_mm256_add_epi64(even, add), shift);
+    odd = sra_epi64(_mm256_add_epi64(odd, add), shift);
+    return merge_epi64_lo(even, odd);
+}
+
+static inline __m256i load_epu8_epi16(const uint8_t *p)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p));
+}
+
+/*
+ * Vertical pass of 16 columns from their samples u0 to u3 in the four input
+ * rows, which must fit an int16 for madd.
+ */
+static inline void dwt2_vert_16(__m256i u0, __m256i u1, __m256i u2,
+                                __m256i u3, __m256i add_lo, __m256i add_hi,
+                                __m128i shift, int16_t *tmplo, int16_t *tmphi)
+{
+    const __m256i f01_lo = _mm256_set1_epi32(
+        (uint16_t)dwt2_db2_coeffs_lo[0] | (dwt2_db2_coeffs_lo[1] << 16));
+    const __m256i f23_lo = _mm256_set1_epi32(
+        (uint16_t)dwt2_db2_coeffs_lo[2] | (dwt2_db2_coeffs_lo[3] << 16));
+    const __m256i f01_hi = _mm256_set1_epi32(
+        (uint16_t)dwt2_db2_coeffs_hi[0] | (dwt2_db2_coeffs_hi[1] << 16));
+    const __m256i f23_hi = _mm256_set1_epi32(
+        (uint16_t)dwt2_db2_coeffs_hi[2] | (dwt2_db2_coeffs_hi[3] << 16));
+
+    const __m256i u01l = _mm256_unpacklo_epi16(u0, u1);
+    const __m256i u01h = _mm256_unpackhi_epi16(u0, u1);
+    const __m256i u23l = _mm256_unpacklo_epi16(u2, u3);
+    const __m256i u23h = _mm256_unpackhi_epi16(u2, u3);
+
+    __m256i lo_l = _mm256_add_epi32(_mm256_madd_epi16(u01l, f01_lo),
+                                    _mm256_madd_epi16(u23l, f23_lo));
+    __m256i lo_h = _mm256_add_epi32(_mm256_madd_epi16(u01h, f01_lo),
+                                    _mm256_madd_epi16(u23h, f23_lo));
+    __m256i hi_l = _mm256_add_epi32(_mm256_madd_epi16(u01l, f01_hi),
+                                    _mm256_madd_epi16(u23l, f23_hi));
+    __m256i hi_h = _mm256_add_epi32(_mm256_madd_epi16(u01h, f01_hi),
+                                    _mm256_madd_epi16(u23h, f23_hi));
+    lo_l = _mm256_sra_epi32(_mm256_add_epi32(lo_l, add_lo), shift);
+    lo_h = _mm256_sra_epi32(_mm256_add_epi32(lo_h, add_lo), shift);
+    hi_l = _mm256_sra_epi32(_mm256_add_epi32(hi_l, add_hi), shift);
+    hi_h = _mm256_sra_epi32(_mm256_add_epi32(hi_h, add_hi), shift);
+
+    // unpack and pack both work within 128-bit lanes, which leaves the
+    // columns in order
+    lo_l = _mm256_srai_epi32(_mm256_slli_epi32(lo_l, 16), 16);
+    lo_h = _mm256_srai_epi32(_mm256_slli_epi32(lo_h, 16), 16);
+    hi_l = _mm256_srai_epi32(_mm256_slli_epi32(hi_l, 16), 16);
+    hi_h = _mm256_srai_epi32(_mm256_slli_epi32(hi_h, 16), 16);
+    _mm256_storeu_si256((__m256i *)tmplo, _mm256_packs_epi32(lo_l, lo_h));
+    _mm256_storeu_si256((__m256i *)tmphi, _mm256_packs_epi32(hi_l, hi_h));
+}
+
+void adm_dwt2_8_vert_avx2(const uint8_t *src, int **ind_y, int i, int w,
+                          int src_stride, int16_t *tmplo, int16_t *tmphi)
+{
+    const uint8_t *s0 = src + ind_y[0][i] * src_stride;
+    const uint8_t *s1 = src + ind_y[1][i] * src_stride;
+    const uint8_t *s2 = src + ind_y[2][i] * src_stride;
+    const uint8_t *s3 = src + ind_y[3][i] * src_stride;
+
+    const int32_t add_shift_VP = 128;
+    const __m256i add_lo = _mm256_set1_epi32(add_shift_VP -
+        dwt2_db2_coeffs_lo_sum * add_shift_VP);
+    const __m256i add_hi = _mm256_set1_epi32(add_shift_VP -
+        dwt2_db2_coeffs_hi_sum * add_shift_VP);
+    const __m128i shift = _mm_cvtsi32_si128(8);
+
+    int j = 0;
+    for (; j + 16 <= w; j += 16) {
+        dwt2_vert_16(load_epu8_epi16(s0 + j), load_epu8_epi16(s1 + j),
+                     load_epu8_epi16(s2 + j), load_epu8_epi16(s3 + j),
+                     add_lo, add_hi, shift, tmplo + j, tmphi + j);
+    }
+
+    for (; j < w; ++j)
+        adm_dwt2_8_vert_px(src, ind_y, i, j, src_stride, tmplo, tmphi);
+}
+
+void adm_dwt2_16_vert_avx2(const uint16_t *src, int **ind_y, int i, int w,
+                           int src_stride, int inp_size_bits, int16_t *tmplo,
+                           int16_t *tmphi)
+{
+    const uint16_t *s0 = src + ind_y[0][i] * src_stride;
+    const uint16_t *s1 = src + ind_y[1][i] * src_stride;
+    const uint16_t *s2 = src + ind_y[2][i] * src_stride;
+    const uint16_t *s3 = src + ind_y[3][i] * src_stride;
+
+    const int32_t add_shift_VP = 1 << (inp_size_bits - 1);
+    const __m256i add_lo = _mm256_set1_epi32(add_shift_VP -
+        dwt2_db2_coeffs_lo_sum * add_shift_VP);
+    const __m256i add_hi = _mm256_set1_epi32(add_shift_VP -
+        dwt2_db2_coeffs_hi_sum * add_shift_VP);
+    const __m128i shift = _mm_cvtsi32_si128(inp_size_bits);
+
+    int j = 0;
+    // samples must fit an int16 for madd
+    if (inp_size_bits <= 15) {
+        for (; j + 16 <= w; j += 16) {
+            dwt2_vert_16(_mm256_loadu_si256((const __m256i *)(s0 + j)),
+                         _mm256_loadu_si256((const __m256i *)(s1 + j)),
+                         _mm256_loadu_si256((const __m256i *)(s2 + j)),
+                         _mm256_loadu_si256((const __m256i *)(s3 + j)),
+                         add_lo, add_hi, shift, tmplo + j, tmphi + j);
         }
+    }
 
-        int j0 = ind_x[0][0];
-        int j1 = ind_x[1][0];
-        int j2 = ind_x[2][0];
-        int j3 = ind_x[3][0];
-
-        int16_t s0 = tmplo[j0];
-        int16_t s1 = tmplo[j1];
-        int16_t s2 = tmplo[j2];
-        int16_t s3 = tmplo[j3];
-
-        accum = 0;
-        accum += (int32_t)filter_lo[0] * s0;
-        accum += (int32_t)filter_lo[1] * s1;
-        accum += (int32_t)filter_lo[2] * s2;
-        accum += (int32_t)filter_lo[3] * s3;
-        dst->band_a[i * dst_stride] = (accum + add_shift_HP) >> shift_HP;
-
-        accum = 0;
-        accum += (int32_t)filter_hi[0] * s0;
-        accum += (int32_t)filter_hi[1] * s1;
-        accum += (int32_t)filter_hi[2] * s2;
-        accum += (int32_t)filter_hi[3] * s3;
-        dst->band_v[i * dst_stride] = (accum + add_shift_HP) >> shift_HP;
-
-        s0 = tmphi[j0];
-        s1 = tmphi[j1];
-        s2 = tmphi[j2];
-        s3 = tmphi[j3];
-
-        accum = 0;
-        accum += (int32_t)filter_lo[0] * s0;
-        accum += (int32_t)filter_lo[1] * s1;
-        accum += (int32_t)filter_lo[2] * s2;
-        accum += (int32_t)filter_lo[3] * s3;
-        dst->band_h[i * dst_stride] = (accum + add_shift_HP) >> shift_HP;
-
-        accum = 0;
-        accum += (int32_t)filter_hi[0] * s0;
-        accum += (int32_t)filter_hi[1] * s1;
-        accum += (int32_t)filter_hi[2] * s2;
-        accum += (int32_t)filter_hi[3] * s3;
-        dst->band_d[i * dst_stride] = (accum + add_shift_HP) >> shift_HP;
-
-        for (int j = 1; j < (w + 1) / 2; j = j + 16) {
-            {
-                __m256i accum_mu2_lo, accum_mu2_hi, accum_mu1_lo, accum_mu1_hi;
-                accum_mu2_lo = accum_mu2_hi = accum_mu1_lo = accum_mu1_hi =
-                    _mm256_setzero_si256();
-
-                __m256i s00, s22, s33, s44;
-
-                s00 = _mm256_loadu_si256((__m256i *)(tmplo + ind_x[0][j]));
-                s22 = _mm256_loadu_si256((__m256i *)(tmplo + ind_x[2][j]));
-                s33 = _mm256_loadu_si256((__m256i *)(tmplo + 16 + ind_x[0][j]));
-                s44 = _mm256_loadu_si256((__m256i *)(tmplo + 16 + ind_x[2][j]));
-
-                accum_mu2_lo =
-                    _mm256_add_epi32(accum_mu2_lo, _mm256_madd_epi16(s00, fl0));
-                accum_mu2_hi =
-                    _mm256_add_epi32(accum_mu2_hi, _mm256_madd_epi16(s33, fl0));
-                accum_mu2_lo =
-                    _mm256_add_epi32(accum_mu2_lo, _mm256_madd_epi16(s22, fl1));
-                accum_mu2_hi =
-                    _mm256_add_epi32(accum_mu2_hi, _mm256_madd_epi16(s44, fl1));
-
-                accum_mu2_lo = _mm256_add_epi32(accum_mu2_lo, add_shift_HP_vex);
-                accum_mu2_lo = _mm256_srli_epi32(accum_mu2_lo, 0x10);
-                accum_mu2_hi = _mm256_add_epi32(accum_mu2_hi, add_shift_HP_vex);
-                accum_mu2_hi = _mm256_srli_epi32(accum_mu2_hi, 0x10);
-
-                accum_mu2_hi = _mm256_packus_epi32(accum_mu2_lo, accum_mu2_hi);
-                accum_mu2_hi = _mm256_permute4x64_epi64(accum_mu2_hi, 0xD8);
-                _mm256_storeu_si256(
-                    (__m256i *)(dst->band_a + i * dst_stride + j),
-                    accum_mu2_hi);
-
-                accum_mu1_lo =
-                    _mm256_add_epi32(accum_mu1_lo, _mm256_madd_epi16(s00, fh0));
-                accum_mu1_hi =
-                    _mm256_add_epi32(accum_mu1_hi, _mm256_madd_epi16(s33, fh0));
-                accum_mu1_lo =
-                    _mm256_add_epi32(accum_mu1_lo, _mm256_madd_epi16(s22, fh1));
-                accum_mu1_hi =
-                    _mm256_add_epi32(accum_mu1_hi, _mm256_madd_epi16(s44, fh1));
-
-                accum_mu1_lo = _mm256_add_epi32(accum_mu1_lo, add_shift_HP_vex);
-                accum_mu1_lo = _mm256_srli_epi32(accum_mu1_lo, 0x10);
-                accum_mu1_hi = _mm256_add_epi32(accum_mu1_hi, add_shift_HP_vex);
-                accum_mu1_hi = _mm256_srli_epi32(accum_mu1_hi, 0x10);
-
-                accum_mu1_hi = _mm256_packus_epi32(accum_mu1_lo, accum_mu1_hi);
-                accum_mu1_hi = _mm256_permute4x64_epi64(accum_mu1_hi, 0xD8);
-                _mm256_storeu_si256(
-                    (__m256i *)(dst->band_v + i * dst_stride + j),
-                    accum_mu1_hi);
-            }
+    for (; j < w; ++j) {
+        adm_dwt2_16_vert_px(src, ind_y, i, j, src_stride, inp_size_bits,
+                            tmplo, tmphi);
+    }
+}
+
+/*
+ * Outputs j to j + 15 of one horizontal pass, from the taps at 2j - 1 to
+ * 2j + 32 of tmp.
+ */
+static inline void dwt2_16_hori_16(const int16_t *tmp, int j, __m256i f01_lo,
+                                   __m256i f23_lo, __m256i f01_hi,
+                                   __m256i f23_hi, int16_t *dst_lo,
+                                   int16_t *dst_hi)
+{
+    const __m256i add = _mm256_set1_epi32(32768);
+    const __m256i t0 = _mm256_loadu_si256((const __m256i *)(tmp + 2 * j - 1));
+    const __m256i t1 = _mm256_loadu_si256((const __m256i *)(tmp + 2 * j + 1));
+    const __m256i t2 = _mm256_loadu_si256((const __m256i *)(tmp + 2 * j + 15));
+    const __m256i t3 = _mm256_loadu_si256((const __m256i *)(tmp + 2 * j + 17));
+
+    __m256i lo0 = _mm256_add_epi32(_mm256_madd_epi16(t0, f01_lo),
+                                   _mm256_madd_epi16(t1, f23_lo));
+    __m256i lo1 = _mm256_add_epi32(_mm256_madd_epi16(t2, f01_lo),
+                                   _mm256_madd_epi16(t3, f23_lo));
+    __m256i hi0 = _mm256_add_epi32(_mm256_madd_epi16(t0, f01_hi),
+                                   _mm256_madd_epi16(t1, f23_hi));
+    __m256i hi1 = _mm256_add_epi32(_mm256_madd_epi16(t2, f01_hi),
+                                   _mm256_madd_epi16(t3, f23_hi));
+    lo0 = _mm256_srai_epi32(_mm256_add_epi32(lo0, add), 16);
+    lo1 = _mm256_srai_epi32(_mm256_add_epi32(lo1, add), 16);
+    hi0 = _mm256_srai_epi32(_mm256_add_epi32(hi0, add), 16);
+    hi1 = _mm256_srai_epi32(_mm256_add_epi32(hi1, add), 16);
+
+    _mm256_storeu_si256((__m256i *)(dst_lo + j), trunc_pack_epi32(lo0, lo1));
+    _mm256_storeu_si256((__m256i *)(dst_hi + j), trunc_pack_epi32(hi0, hi1));
+}
+
+void adm_dwt2_16_hori_avx2(const int16_t *tmplo, const int16_t *tmphi,
+                           int **ind_x, int w, const adm_dwt_band_t *dst,
+                           size_t offset)
+{
+    const __m256i f01_lo = _mm256_set1_epi32(
+        (uint16_t)dwt2_db2_coeffs_lo[0] | (dwt2_db2_coeffs_lo[1] << 16));
+    const __m256i f23_lo = _mm256_set1_epi32(
+        (uint16_t)dwt2_db2_coeffs_lo[2] | (dwt2_db2_coeffs_lo[3] << 16));
+    const __m256i f01_hi = _mm256_set1_epi32(
+        (uint16_t)dwt2_db2_coeffs_hi[0] | (dwt2_db2_coeffs_hi[1] << 16));
+    const __m256i f23_hi = _mm256_set1_epi32(
+        (uint16_t)dwt2_db2_coeffs_hi[2] | (dwt2_db2_coeffs_hi[3] << 16));
+
+    // away from the borders, output j reads the taps 2j - 1 to 2j + 2
+    adm_dwt2_16_hori_px(tmplo, tmphi, ind_x, 0, dst, offset);
+    int j = 1;
+    for (; 2 * j + 32 < w; j += 16) {
+        dwt2_16_hori_16(tmplo, j, f01_lo, f23_lo, f01_hi, f23_hi,
+                        dst->band_a + offset, dst->band_v + offset);
+        dwt2_16_hori_16(tmphi, j, f01_lo, f23_lo, f01_hi, f23_hi,
+                        dst->band_h + offset, dst->band_d + offset);
+    }
+    for (; j < (w + 1) / 2; ++j)
+        adm_dwt2_16_hori_px(tmplo, tmphi, ind_x, j, dst, offset);
+}
+
+/* Sum of the four 64-bit filter products of the int32 lanes of s0 to s3. */
+static inline __m256i filt4_epi64(__m256i s0, __m256i s1, __m256i s2,
+                                  __m256i s3, const int16_t *f)
+{
+    __m256i acc = _mm256_mul_epi32(s0, _mm256_set1_epi64x(f[0]));
+    acc = _mm256_add_epi64(acc, _mm256_mul_epi32(s1, _mm256_set1_epi64x(f[1])));
+    acc = _mm256_add_epi64(acc, _mm256_mul_epi32(s2, _mm256_set1_epi64x(f[2])));
+    acc = _mm256_add_epi64(acc, _mm256_mul_epi32(s3, _mm256_set1_epi64x(f[3])));
+    return acc;
+}
+
+void adm_dwt2_s123_vert_avx2(const int32_t *src, int **ind_y, int i, int w,
+                             int src_stride, int32_t add, int16_t shift,
+                             int32_t *tmplo, int32_t *tmphi)
+{
+    const int32_t *p0 = src + ind_y[0][i] * src_stride;
+    const int32_t *p1 = src + ind_y[1][i] * src_stride;
+    const int32_t *p2 = src + ind_y[2][i] * src_stride;
+    const int32_t *p3 = src + ind_y[3][i] * src_stride;
+
+    const __m256i add64 = _mm256_set1_epi64x(add);
+    const __m128i cnt = _mm_cvtsi32_si128(shift);
+
+    int j = 0;
+    for (; j + 8 <= w; j += 8) {
+        const __m256i s0 = _mm256_loadu_si256((const __m256i *)(p0 + j));
+        const __m256i s1 = _mm256_loadu_si256((const __m256i *)(p1 + j));
+        const __m256i s2 = _mm256_loadu_si256((const __m256i *)(p2 + j));
+        const __m256i s3 = _mm256_loadu_si256((const __m256i *)(p3 + j));
+        const __m256i s0o = _mm256_srli_epi64(s0, 32);
+        const __m256i s1o = _mm256_srli_epi64(s1, 32);
+        const __m256i s2o = _mm256_srli_epi64(s2, 32);
+        const __m256i s3o = _mm256_srli_epi64(s3, 32);
+
+        // the results are truncated to 32 bits, whose sign the shift
+        // does not reach for shifts up to 32
+        __m256i even = filt4_epi64(s0, s1, s2, s3, dwt2_db2_coeffs_lo);
+        __m256i odd = filt4_epi64(s0o, s1o, s2o, s3o, dwt2_db2_coeffs_lo);
+        even = _mm256_srl_epi64(_mm256_add_epi64(even, add64), cnt);
+        odd = _mm256_srl_epi64(_mm256_add_epi64(odd, add64), cnt);
+        _mm256_storeu_si256((__m256i *)(tmplo + j), merge_epi64_lo(even, odd));
+
+        even = filt4_epi64(s0, s1, s2, s3, dwt2_db2_coeffs_hi);
+        odd = filt4_epi64(s0o, s1o, s2o, s3o, dwt2_db2_coeffs_hi);
+        even = _mm256_srl_epi64(_mm256_add_epi64(even, add64), cnt);
+        odd = _mm256_srl_epi64(_mm256_add_epi64(odd, add64), cnt);
+        _mm256_storeu_si256((__m256i *)(tmphi + j), merge_epi64_lo(even, odd));
+    }
+
+    for (; j < w; ++j) {
+        adm_dwt2_s123_vert_px(src, ind_y, i, j, src_stride, add, shift, tmplo,
+                              tmphi);
+    }
+}
+
+/*
+ * Outputs j to j + 7 of one horizontal pass, from the taps at 2j - 1 to
+ * 2j + 16 of tmp.
+ */
+static inline void dwt2_s123_hori_8(const int32_t *tmp, int j, __m256i add,
+                                    __m128i cnt, int32_t *dst_lo,
+                                    int32_t *dst_hi)
+{
+    const __m256i order = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    // the 64-bit lanes of x hold the taps 2j - 1 and 2j of outputs j to
+    // j + 3, the ones of y the taps 2j + 1 and 2j + 2
+    const __m256i x0 = _mm256_loadu_si256((const __m256i *)(tmp + 2 * j - 1));
+    const __m256i y0 = _mm256_loadu_si256((const __m256i *)(tmp + 2 * j + 1));
+    const __m256i x1 = _mm256_loadu_si256((const __m256i *)(tmp + 2 * j + 7));
+    const __m256i y1 = _mm256_loadu_si256((const __m256i *)(tmp + 2 * j + 9));
+    const __m256i x0o = _mm256_srli_epi64(x0, 32);
+    const __m256i y0o = _mm256_srli_epi64(y0, 32);
+    const __m256i x1o = _mm256_srli_epi64(x1, 32);
+    const __m256i y1o = _mm256_srli_epi64(y1, 32);
+
+    __m256i r0 = filt4_epi64(x0, x0o, y0, y0o, dwt2_db2_coeffs_lo);
+    __m256i r1 = filt4_epi64(x1, x1o, y1, y1o, dwt2_db2_coeffs_lo);
+    r0 = _mm256_srl_epi64(_mm256_add_epi64(r0, add), cnt);
+    r1 = _mm256_srl_epi64(_mm256_add_epi64(r1, add), cnt);
+    _mm256_storeu_si256((__m256i *)(dst_lo + j),
+        _mm256_permutevar8x32_epi32(merge_epi64_lo(r0, r1), order));
+
+    r0 = filt4_epi64(x0, x0o, y0, y0o, dwt2_db2_coeffs_hi);
+    r1 = filt4_epi64(x1, x1o, y1, y1o, dwt2_db2_coeffs_hi);
+    r0 = _mm256_srl_epi64(_mm256_add_epi64(r0, add), cnt);
+    r1 = _mm256_srl_epi64(_mm256_add_epi64(r1, add), cnt);
+    _mm256_storeu_si256((__m256i *)(dst_hi + j),
+        _mm256_permutevar8x32_epi32(merge_epi64_lo(r0, r1), order));
+}
+
+void adm_dwt2_s123_hori_avx2(const int32_t *tmplo, const int32_t *tmphi,
+                             int **ind_x, int w, const i4_adm_dwt_band_t *dst,
+                             size_t offset, int32_t add, int16_t shift)
+{
+    const __m256i add64 = _mm256_set1_epi64x(add);
+    const __m128i cnt = _mm_cvtsi32_si128(shift);
+
+    adm_dwt2_s123_hori_px(tmplo, tmphi, ind_x, 0, dst, offset, add, shift);
+    int j = 1;
+    for (; 2 * j + 16 < w; j += 8) {
+        dwt2_s123_hori_8(tmplo, j, add64, cnt, dst->band_a + offset,
+                         dst->band_v + offset);
+        dwt2_s123_hori_8(tmphi, j, add64, cnt, dst->band_h + offset,
+                         dst->band_d + offset);
+    }
+    for (; j < (w + 1) / 2; ++j)
+        adm_dwt2_s123_hori_px(tmplo, tmphi, ind_x, j, dst, offset, add, shift);
+}
+
+static inline int64_t hsum_epi64(__m256i x)
+{
+    const __m128i s = _mm_add_epi64(_mm256_castsi256_si128(x),
+                                    _mm256_extracti128_si256(x, 1));
+    return _mm_cvtsi128_si64(s) + _mm_extract_epi64(s, 1);
+}
+
+/* Clamps the signed 64-bit lanes of x to [0, 32768]. */
+static inline __m256i clamp_k_epi64(__m256i x)
+{
+    const __m256i max = _mm256_set1_epi64x(32768);
+    x = _mm256_andnot_si256(_mm256_cmpgt_epi64(_mm256_setzero_si256(), x), x);
+    return _mm256_blendv_epi8(x, max, _mm256_cmpgt_epi64(x, max));
+}
+
+/*
+ * adm_decouple_angle_flag() of four pixels. The dot products are exact in
+ * double as long as the inputs fit 26 bits, the float conversion of the
+ * scalar code is then a rounding of the double.
+ */
+static inline __m128i angle_flag_4(__m128i oh, __m128i ov, __m128i th,
+                                   __m128i tv, __m256d cos_1deg_sq)
+{
+    const __m256d one_by_4096 = _mm256_set1_pd(1.0 / 4096.0);
+    const __m256d ohd = _mm256_cvtepi32_pd(oh);
+    const __m256d ovd = _mm256_cvtepi32_pd(ov);
+    const __m256d thd = _mm256_cvtepi32_pd(th);
+    const __m256d tvd = _mm256_cvtepi32_pd(tv);
+
+    __m256d ot_dp = _mm256_add_pd(_mm256_mul_pd(ohd, thd),
+                                  _mm256_mul_pd(ovd, tvd));
+    __m256d o_mag_sq = _mm256_add_pd(_mm256_mul_pd(ohd, ohd),
+                                     _mm256_mul_pd(ovd, ovd));
+    __m256d t_mag_sq = _mm256_add_pd(_mm256_mul_pd(thd, thd),
+                                     _mm256_mul_pd(tvd, tvd));
+    ot_dp = _mm256_mul_pd(_mm256_cvtps_pd(_mm256_cvtpd_ps(ot_dp)),
+                          one_by_4096);
+    o_mag_sq = _mm256_mul_pd(_mm256_cvtps_pd(_mm256_cvtpd_ps(o_mag_sq)),
+                             one_by_4096);
+    t_mag_sq = _mm256_mul_pd(_mm256_cvtps_pd(_mm256_cvtpd_ps(t_mag_sq)),
+                             one_by_4096);
+
+    const __m256d lhs = _mm256_mul_pd(ot_dp, ot_dp);
+    const __m256d rhs = _mm256_mul_pd(_mm256_mul_pd(cos_1deg_sq, o_mag_sq),
+                                      t_mag_sq);
+    const __m256d flag = _mm256_and_pd(
+        _mm256_cmp_pd(ot_dp, _mm256_setzero_pd(), _CMP_GE_OQ),
+        _mm256_cmp_pd(lhs, rhs, _CMP_GE_OQ));
+
+    const __m256i order = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    return _mm256_castsi256_si128(
+        _mm256_permutevar8x32_epi32(_mm256_castpd_si256(flag), order));
+}
+
+static inline __m256i angle_flag_8(__m256i oh, __m256i ov, __m256i th,
+                                   __m256i tv, __m256d cos_1deg_sq)
+{
+    const __m128i lo = angle_flag_4(_mm256_castsi256_si128(oh),
+                                    _mm256_castsi256_si128(ov),
+                                    _mm256_castsi256_si128(th),
+                                    _mm256_castsi256_si128(tv), cos_1deg_sq);
+    const __m128i hi = angle_flag_4(_mm256_extracti128_si256(oh, 1),
+                                    _mm256_extracti128_si256(ov, 1),
+                                    _mm256_extracti128_si256(th, 1),
+                                    _mm256_extracti128_si256(tv, 1),
+                                    cos_1deg_sq);
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+/*
+ * Applies the enhancement gain limit to rst where the angle flag is set,
+ * pos and neg select the lanes of positive and negative rst_f.
+ */
+static inline __m256i decouple_gain(__m256i rst, __m256i t, __m256i pos,
+                                    __m256i neg, __m256d egl)
+{
+    const __m256i any = _mm256_or_si256(pos, neg);
+    if (_mm256_testz_si256(any, any)) return rst;
+
+    const __m256d r_lo =
+        _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(rst)), egl);
+    const __m256d r_hi =
+        _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(rst, 1)), egl);
+    const __m256d t_lo = _mm256_cvtepi32_pd(_mm256_castsi256_si128(t));
+    const __m256d t_hi = _mm256_cvtepi32_pd(_mm256_extracti128_si256(t, 1));
+
+    const __m256i min = _mm256_inserti128_si256(_mm256_castsi128_si256(
+        _mm256_cvttpd_epi32(_mm256_min_pd(r_lo, t_lo))),
+        _mm256_cvttpd_epi32(_mm256_min_pd(r_hi, t_hi)), 1);
+    const __m256i max = _mm256_inserti128_si256(_mm256_castsi128_si256(
+        _mm256_cvttpd_epi32(_mm256_max_pd(r_lo, t_lo))),
+        _mm256_cvttpd_epi32(_mm256_max_pd(r_hi, t_hi)), 1);
+    rst = _mm256_blendv_epi8(rst, min, pos);
+    return _mm256_blendv_epi8(rst, max, neg);
+}
+
+/* adm_decouple_px() of one band of eight pixels. */
+static inline void decouple_band_8(const int16_t *o_ptr, const int16_t *t_ptr,
+                                   int16_t *r_ptr, int16_t *a_ptr,
+                                   __m256i angle_flag, __m256d egl)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i o = load_epi16_epi32(o_ptr);
+    const __m256i t = load_epi16_epi32(t_ptr);
+
+    // |div * t| < 2^45, the low 32 bits of the shift need no sign
+    const __m256i div = _mm256_i32gather_epi32(div_lookup,
+        _mm256_add_epi32(o, _mm256_set1_epi32(32768)), 4);
+    const __m256i round = _mm256_set1_epi64x(16384);
+    __m256i even = _mm256_mul_epi32(div, t);
+    __m256i odd = _mm256_mul_epi32(_mm256_srli_epi64(div, 32),
+                                   _mm256_srli_epi64(t, 32));
+    even = _mm256_srli_epi64(_mm256_add_epi64(even, round), 15);
+    odd = _mm256_srli_epi64(_mm256_add_epi64(odd, round), 15);
+    __m256i k = merge_epi64_lo(even, odd);
+    k = _mm256_min_epi32(_mm256_max_epi32(k, zero), _mm256_set1_epi32(32768));
+    k = _mm256_blendv_epi8(k, _mm256_set1_epi32(32768),
+                           _mm256_cmpeq_epi32(o, zero));
+
+    __m256i rst = _mm256_mullo_epi32(k, o);
+    rst = _mm256_srai_epi32(_mm256_add_epi32(rst, _mm256_set1_epi32(16384)),
+                            15);
+    rst = _mm256_srai_epi32(_mm256_slli_epi32(rst, 16), 16);
+
+    const __m256i k_pos = _mm256_and_si256(angle_flag,
+                                           _mm256_cmpgt_epi32(k, zero));
+    const __m256i pos = _mm256_and_si256(k_pos, _mm256_cmpgt_epi32(o, zero));
+    const __m256i neg = _mm256_and_si256(k_pos, _mm256_cmpgt_epi32(zero, o));
+    rst = decouple_gain(rst, t, pos, neg, egl);
+
+    store_epi32_epi16(r_ptr, rst);
+    store_epi32_epi16(a_ptr, _mm256_sub_epi32(t, rst));
+}
+
+void adm_decouple_row_avx2(const adm_dwt_band_t *ref, const adm_dwt_band_t *dis,
+                           const adm_dwt_band_t *r, const adm_dwt_band_t *a,
+                           size_t offset, int n, float cos_1deg_sq,
+                           double adm_enhn_gain_limit)
+{
+    const __m256d cos_sq = _mm256_set1_pd(cos_1deg_sq);
+    const __m256d egl = _mm256_set1_pd(adm_enhn_gain_limit);
+
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        const size_t idx = offset + j;
+        const __m256i flag = angle_flag_8(load_epi16_epi32(ref->band_h + idx),
+                                          load_epi16_epi32(ref->band_v + idx),
+                                          load_epi16_epi32(dis->band_h + idx),
+                                          load_epi16_epi32(dis->band_v + idx),
+                                          cos_sq);
+        decouple_band_8(ref->band_h + idx, dis->band_h + idx, r->band_h + idx,
+                        a->band_h + idx, flag, egl);
+        decouple_band_8(ref->band_v + idx, dis->band_v + idx, r->band_v + idx,
+                        a->band_v + idx, flag, egl);
+        decouple_band_8(ref->band_d + idx, dis->band_d + idx, r->band_d + idx,
+                        a->band_d + idx, flag, egl);
+    }
+
+    for (; j < n; ++j) {
+        adm_decouple_pixel(ref, dis, r, a, offset + j, cos_1deg_sq,
+                           adm_enhn_gain_limit);
+    }
+}
+
+/* i4_adm_decouple_px() of one band of eight pixels. */
+static inline void i4_decouple_band_8(const int32_t *o_ptr,
+                                      const int32_t *t_ptr, int32_t *r_ptr,
+                                      int32_t *a_ptr, __m256i angle_flag,
+                                      __m256d egl)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i o = _mm256_loadu_si256((const __m256i *)o_ptr);
+    const __m256i t = _mm256_loadu_si256((const __m256i *)t_ptr);
+
+    // k_shift of get_best15_from32(), from the exponent of the exact float
+    // conversion of abs_o >> 8, zero where abs_o fits the table as is
+    const __m256i abs_o = _mm256_abs_epi32(o);
+    const __m256 abs_o_f = _mm256_cvtepi32_ps(_mm256_srli_epi32(abs_o, 8));
+    __m256i sh = _mm256_sub_epi32(
+        _mm256_srli_epi32(_mm256_castps_si256(abs_o_f), 23),
+        _mm256_set1_epi32(127 + 14 - 8));
+    sh = _mm256_andnot_si256(
+        _mm256_cmpeq_epi32(_mm256_srli_epi32(abs_o, 15), zero), sh);
+    // the rounding term vanishes for sh = 0, as the shift count wraps
+    const __m256i msb = _mm256_srlv_epi32(_mm256_add_epi32(abs_o,
+        _mm256_sllv_epi32(one, _mm256_sub_epi32(sh, one))), sh);
+
+    const __m256i div = _mm256_i32gather_epi32(div_lookup,
+        _mm256_add_epi32(msb, _mm256_set1_epi32(32768)), 4);
+    const __m256i sdiv = _mm256_sign_epi32(div, o);
+
+    const __m256i sh_even = _mm256_blend_epi32(sh, zero, 0xAA);
+    const __m256i sh_odd = _mm256_srli_epi64(sh, 32);
+    const __m256i round = _mm256_set1_epi64x(1 << 14);
+    const __m256i fifteen = _mm256_set1_epi64x(15);
+    __m256i even = _mm256_mul_epi32(sdiv, t);
+    __m256i odd = _mm256_mul_epi32(_mm256_srli_epi64(sdiv, 32),
+                                   _mm256_srli_epi64(t, 32));
+    even = _mm256_add_epi64(even, _mm256_sllv_epi64(round, sh_even));
+    odd = _mm256_add_epi64(odd, _mm256_sllv_epi64(round, sh_odd));
+    even = clamp_k_epi64(srav_epi64(even, _mm256_add_epi64(sh_even, fifteen)));
+    odd = clamp_k_epi64(srav_epi64(odd, _mm256_add_epi64(sh_odd, fifteen)));
+    __m256i k = merge_epi64_lo(even, odd);
+    k = _mm256_blendv_epi8(k, _mm256_set1_epi32(32768),
+                           _mm256_cmpeq_epi32(o, zero));
+
+    const __m256i round_rst = _mm256_set1_epi64x(16384);
+    even = _mm256_mul_epi32(k, o);
+    odd = _mm256_mul_epi32(_mm256_srli_epi64(k, 32), _mm256_srli_epi64(o, 32));
+    even = _mm256_srli_epi64(_mm256_add_epi64(even, round_rst), 15);
+    odd = _mm256_srli_epi64(_mm256_add_epi64(odd, round_rst), 15);
+    __m256i rst = merge_epi64_lo(even, odd);
+
+    const __m256i k_pos = _mm256_and_si256(angle_flag,
+                                           _mm256_cmpgt_epi32(k, zero));
+    const __m256i pos = _mm256_and_si256(k_pos, _mm256_cmpgt_epi32(o, zero));
+    const __m256i neg = _mm256_and_si256(k_pos, _mm256_cmpgt_epi32(zero, o));
+    rst = decouple_gain(rst, t, pos, neg, egl);
+
+    _mm256_storeu_si256((__m256i *)r_ptr, rst);
+    _mm256_storeu_si256((__m256i *)a_ptr, _mm256_sub_epi32(t, rst));
+}
 
-            {
-                __m256i accum_mu2_lo, accum_mu2_hi, accum_mu1_lo, accum_mu1_hi;
-                accum_mu2_lo = accum_mu2_hi = accum_mu1_lo = accum_mu1_hi =
-                    _mm256_setzero_si256();
-
-                __m256i s00, s22, s33, s44;
-
-                __m256i add_shift_HP_vex = _mm256_set1_epi32(32768);
-
-                s00 = _mm256_loadu_si256((__m256i *)(tmphi + ind_x[0][j]));
-                s22 = _mm256_loadu_si256((__m256i *)(tmphi + ind_x[2][j]));
-                s33 = _mm256_loadu_si256((__m256i *)(tmphi + 16 + ind_x[0][j]));
-                s44 = _mm256_loadu_si256((__m256i *)(tmphi + 16 + ind_x[2][j]));
-
-                accum_mu2_lo =
-                    _mm256_add_epi32(accum_mu2_lo, _mm256_madd_epi16(s00, fl0));
-                accum_mu2_hi =
-                    _mm256_add_epi32(accum_mu2_hi, _mm256_madd_epi16(s33, fl0));
-                accum_mu2_lo =
-                    _mm256_add_epi32(accum_mu2_lo, _mm256_madd_epi16(s22, fl1));
-                accum_mu2_hi =
-                    _mm256_add_epi32(accum_mu2_hi, _mm256_madd_epi16(s44, fl1));
-
-                accum_mu2_lo = _mm256_add_epi32(accum_mu2_lo, add_shift_HP_vex);
-                accum_mu2_lo = _mm256_srli_epi32(accum_mu2_lo, 0x10);
-                accum_mu2_hi = _mm256_add_epi32(accum_mu2_hi, add_shift_HP_vex);
-                accum_mu2_hi = _mm256_srli_epi32(accum_mu2_hi, 0x10);
-
-                accum_mu2_hi = _mm256_packus_epi32(accum_mu2_lo, accum_mu2_hi);
-                accum_mu2_hi = _mm256_permute4x64_epi64(accum_mu2_hi, 0xD8);
-                _mm256_storeu_si256(
-                    (__m256i *)(dst->band_h + i * dst_stride + j),
-                    accum_mu2_hi);
-
-                accum_mu1_lo =
-                    _mm256_add_epi32(accum_mu1_lo, _mm256_madd_epi16(s00, fh0));
-                accum_mu1_hi =
-                    _mm256_add_epi32(accum_mu1_hi, _mm256_madd_epi16(s33, fh0));
-                accum_mu1_lo =
-                    _mm256_add_epi32(accum_mu1_lo, _mm256_madd_epi16(s22, fh1));
-                accum_mu1_hi =
-                    _mm256_add_epi32(accum_mu1_hi, _mm256_madd_epi16(s44, fh1));
-
-                accum_mu1_lo = _mm256_add_epi32(accum_mu1_lo, add_shift_HP_vex);
-                accum_mu1_lo = _mm256_srli_epi32(accum_mu1_lo, 0x10);
-                accum_mu1_hi = _mm256_add_epi32(accum_mu1_hi, add_shift_HP_vex);
-                accum_mu1_hi = _mm256_srli_epi32(accum_mu1_hi, 0x10);
-
-                accum_mu1_hi = _mm256_packus_epi32(accum_mu1_lo, accum_mu1_hi);
-                accum_mu1_hi = _mm256_permute4x64_epi64(accum_mu1_hi, 0xD8);
-                _mm256_storeu_si256(
-                    (__m256i *)(dst->band_d + i * dst_stride + j),
-                    accum_mu1_hi);
+void i4_adm_decouple_row_avx2(const i4_adm_dwt_band_t *ref,
+                              const i4_adm_dwt_band_t *dis,
+                              const i4_adm_dwt_band_t *r,
+                              const i4_adm_dwt_band_t *a, size_t offset,
+                              int n, float cos_1deg_sq,
+                              double adm_enhn_gain_limit)
+{
+    const __m256d cos_sq = _mm256_set1_pd(cos_1deg_sq);
+    const __m256d egl = _mm256_set1_pd(adm_enhn_gain_limit);
+
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        const size_t idx = offset + j;
+        const __m256i oh = _mm256_loadu_si256((const __m256i *)(ref->band_h + idx));
+        const __m256i ov = _mm256_loadu_si256((const __m256i *)(ref->band_v + idx));
+        const __m256i th = _mm256_loadu_si256((const __m256i *)(dis->band_h + idx));
+        const __m256i tv = _mm256_loadu_si256((const __m256i *)(dis->band_v + idx));
+
+        // the angle in double is only exact for inputs up to 26 bits
+        const __m256i mag = _mm256_or_si256(
+            _mm256_or_si256(_mm256_abs_epi32(oh), _mm256_abs_epi32(ov)),
+            _mm256_or_si256(_mm256_abs_epi32(th), _mm256_abs_epi32(tv)));
+        const __m256i wide = _mm256_srli_epi32(mag, 26);
+        if (!_mm256_testz_si256(wide, wide)) {
+            for (int jj = j; jj < j + 8; ++jj) {
+                i4_adm_decouple_pixel(ref, dis, r, a, offset + jj,
+                                      cos_1deg_sq, adm_enhn_gain_limit);
             }
+            continue;
+        }
+
+        const __m256i flag = angle_flag_8(oh, ov, th, tv, cos_sq);
+        i4_decouple_band_8(ref->band_h + idx, dis->band_h + idx,
+                           r->band_h + idx, a->band_h + idx, flag, egl);
+        i4_decouple_band_8(ref->band_v + idx, dis->band_v + idx,
+                           r->band_v + idx, a->band_v + idx, flag, egl);
+        i4_decouple_band_8(ref->band_d + idx, dis->band_d + idx,
+                           r->band_d + idx, a->band_d + idx, flag, egl);
+    }
+
+    for (; j < n; ++j) {
+        i4_adm_decouple_pixel(ref, dis, r, a, offset + j, cos_1deg_sq,
+                              adm_enhn_gain_limit);
+    }
+}
+
+void adm_csf_row_avx2(const int16_t *src, int16_t *dst, int16_t *flt, int n,
+                      uint16_t i_rfactor, uint8_t i_shift,
+                      uint16_t i_shiftsadd)
+{
+    const __m256i rfactor = _mm256_set1_epi32(i_rfactor);
+    const __m256i add = _mm256_set1_epi32(i_shiftsadd);
+    const __m128i shift = _mm_cvtsi32_si128(i_shift);
+    const __m256i one_by_30 = _mm256_set1_epi32(4369);
+    const __m256i add_flt = _mm256_set1_epi32(2048);
+
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m256i d = _mm256_mullo_epi32(load_epi16_epi32(src + j), rfactor);
+        d = _mm256_sra_epi32(_mm256_add_epi32(d, add), shift);
+        d = _mm256_srai_epi32(_mm256_slli_epi32(d, 16), 16);
+        __m256i f = _mm256_mullo_epi32(_mm256_abs_epi32(d), one_by_30);
+        f = _mm256_srai_epi32(_mm256_add_epi32(f, add_flt), 12);
+        store_epi32_epi16(dst + j, d);
+        store_epi32_epi16(flt + j, f);
+    }
+
+    for (; j < n; ++j)
+        adm_csf_px(src[j], i_rfactor, i_shift, i_shiftsadd, &dst[j], &flt[j]);
+}
+
+void i4_adm_csf_row_avx2(const int32_t *src, int32_t *dst, int32_t *flt,
+                         int n, uint32_t i_rfactor, int32_t add_bef_shift_dst,
+                         uint32_t shift_dst, int32_t add_bef_shift_flt,
+                         uint32_t shift_flt)
+{
+    const __m256i rfactor = _mm256_set1_epi32(i_rfactor);
+    const __m256i add_dst = _mm256_set1_epi64x(add_bef_shift_dst);
+    const __m128i sh_dst = _mm_cvtsi32_si128(shift_dst);
+    const __m256i one_by_30 = _mm256_set1_epi32(143165577);
+    const __m256i add_flt = _mm256_set1_epi64x(add_bef_shift_flt);
+    const __m128i sh_flt = _mm_cvtsi32_si128(shift_flt);
+
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        const __m256i s = _mm256_loadu_si256((const __m256i *)(src + j));
+        const __m256i d = mul_round_epi32(s, rfactor, add_dst, sh_dst);
+        const __m256i f = mul_round_epi32(_mm256_abs_epi32(d), one_by_30,
+                                          add_flt, sh_flt);
+        _mm256_storeu_si256((__m256i *)(dst + j), d);
+        _mm256_storeu_si256((__m256i *)(flt + j), f);
+    }
+
+    for (; j < n; ++j) {
+        i4_adm_csf_px(src[j], i_rfactor, add_bef_shift_dst, shift_dst,
+                      add_bef_shift_flt, shift_flt, &dst[j], &flt[j]);
+    }
+}
+
+uint64_t adm_csf_den_row_avx2(const int16_t *src, int n)
+{
+    __m256i acc = _mm256_setzero_si256();
+
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        const __m256i x = _mm256_abs_epi32(load_epi16_epi32(src + j));
+        const __m256i x_sq = _mm256_mullo_epi32(x, x);
+        const __m256i even = _mm256_mul_epu32(x_sq, x);
+        const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(x_sq, 32),
+                                             _mm256_srli_epi64(x, 32));
+        acc = _mm256_add_epi64(acc, _mm256_add_epi64(even, odd));
+    }
+
+    uint64_t accum = hsum_epi64(acc);
+    for (; j < n; ++j)
+        accum += adm_csf_den_px(src[j]);
+    return accum;
+}
+
+/* adm_csf_den_s123_px() of the low dwords of the 64-bit lanes of x. */
+static inline __m256i csf_den_s123_4(__m256i x, __m256i add_sq, __m128i sh_sq,
+                                     __m256i add_cub, __m128i sh_cub)
+{
+    const __m256i q = _mm256_srl_epi64(
+        _mm256_add_epi64(_mm256_mul_epu32(x, x), add_sq), sh_sq);
+    // q may exceed 32 bits, the product wraps like the scalar one
+    __m256i qx = _mm256_mul_epu32(q, x);
+    qx = _mm256_add_epi64(qx, _mm256_slli_epi64(
+        _mm256_mul_epu32(_mm256_srli_epi64(q, 32), x), 32));
+    return _mm256_srl_epi64(_mm256_add_epi64(qx, add_cub), sh_cub);
+}
+
+uint64_t adm_csf_den_s123_row_avx2(const int32_t *src, int n,
+                                   uint32_t add_shift_sq, uint32_t shift_sq,
+                                   uint32_t add_shift_cub, uint32_t shift_cub)
+{
+    const __m256i add_sq = _mm256_set1_epi64x(add_shift_sq);
+    const __m128i sh_sq = _mm_cvtsi32_si128(shift_sq);
+    const __m256i add_cub = _mm256_set1_epi64x(add_shift_cub);
+    const __m128i sh_cub = _mm_cvtsi32_si128(shift_cub);
+    __m256i acc = _mm256_setzero_si256();
+
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        const __m256i x =
+            _mm256_abs_epi32(_mm256_loadu_si256((const __m256i *)(src + j)));
+        acc = _mm256_add_epi64(acc, csf_den_s123_4(x, add_sq, sh_sq, add_cub,
+                                                   sh_cub));
+        acc = _mm256_add_epi64(acc, csf_den_s123_4(_mm256_srli_epi64(x, 32),
+                                                   add_sq, sh_sq, add_cub,
+                                                   sh_cub));
+    }
+
+    uint64_t accum = hsum_epi64(acc);
+    for (; j < n; ++j) {
+        accum += adm_csf_den_s123_px(src[j], add_shift_sq, shift_sq,
+                                     add_shift_cub, shift_cub);
+    }
+    return accum;
+}
+
+/*
+ * Adds ((x_sq * x) + add_cub) >> shift_cub of eight pixels to acc, where
+ * x_sq = ((x * x) + add_sq) >> shift_sq truncated to 32 bits.
+ */
+static inline __m256i cm_accum_8(__m256i acc, __m256i x, __m256i add_sq,
+                                 int shift_sq, __m256i add_cub,
+                                 __m128i shift_cub)
+{
+    const __m128i sh_sq = _mm_cvtsi32_si128(shift_sq);
+    const __m256i x_odd = _mm256_srli_epi64(x, 32);
+    // mul_epi32 only reads the low dword of x_sq, which truncates it
+    __m256i sq = _mm256_srl_epi64(
+        _mm256_add_epi64(_mm256_mul_epu32(x, x), add_sq), sh_sq);
+    acc = _mm256_add_epi64(acc, sra_epi64(_mm256_add_epi64(
+        _mm256_mul_epi32(sq, x), add_cub), shift_cub));
+    sq = _mm256_srl_epi64(
+        _mm256_add_epi64(_mm256_mul_epu32(x_odd, x_odd), add_sq), sh_sq);
+    return _mm256_add_epi64(acc, sra_epi64(_mm256_add_epi64(
+        _mm256_mul_epi32(sq, x_odd), add_cub), shift_cub));
+}
+
+/* Sum of the eight flt neighbours of eight pixels of one band. */
+static inline __m256i cm_flt_sum_8(const int16_t *flt, int stride)
+{
+    const int16_t *above = flt - stride;
+    const int16_t *below = flt + stride;
+    __m256i sum = _mm256_add_epi32(load_epi16_epi32(above - 1),
+                                   load_epi16_epi32(above));
+    sum = _mm256_add_epi32(sum, load_epi16_epi32(above + 1));
+    sum = _mm256_add_epi32(sum, load_epi16_epi32(flt - 1));
+    sum = _mm256_add_epi32(sum, load_epi16_epi32(flt + 1));
+    sum = _mm256_add_epi32(sum, load_epi16_epi32(below - 1));
+    sum = _mm256_add_epi32(sum, load_epi16_epi32(below));
+    return _mm256_add_epi32(sum, load_epi16_epi32(below + 1));
+}
+
+void adm_cm_row_avx2(const adm_dwt_band_t *src, const adm_dwt_band_t *csf_a,
+                     const adm_dwt_band_t *csf_f, int src_stride,
+                     int csf_a_stride, int i, int j_begin, int j_end,
+                     const uint16_t *i_rfactor, const uint32_t *add_shift_cub,
+                     const uint32_t *shift_cub, int64_t *accum)
+{
+    const int16_t *src_angles[3] = { src->band_h, src->band_v, src->band_d };
+    const int16_t *angles[3] = { csf_a->band_h, csf_a->band_v, csf_a->band_d };
+    const int16_t *flt_angles[3] =
+        { csf_f->band_h, csf_f->band_v, csf_f->band_d };
+    const int shift_xsq[3] = { 29, 29, 30 };
+    const int shift_xsub[3] = { 10, 10, 12 };
+
+    __m256i rfactor[3], add_xsq[3], add_xcub[3];
+    __m128i shift_xcub[3];
+    for (int theta = 0; theta < 3; ++theta) {
+        rfactor[theta] = _mm256_set1_epi32(i_rfactor[theta]);
+        add_xsq[theta] = _mm256_set1_epi64x(1 << (shift_xsq[theta] - 1));
+        add_xcub[theta] = _mm256_set1_epi64x(add_shift_cub[theta]);
+        shift_xcub[theta] = _mm_cvtsi32_si128(shift_cub[theta]);
+    }
+    const __m256i one_by_15 = _mm256_set1_epi32(ONE_BY_15);
+    const __m256i add_thr = _mm256_set1_epi32(2048);
+    __m256i acc[3] = { _mm256_setzero_si256(), _mm256_setzero_si256(),
+                       _mm256_setzero_si256() };
+
+    int j = j_begin;
+    for (; j + 8 <= j_end; j += 8) {
+        const int idx = i * csf_a_stride + j;
+        __m256i thr = _mm256_setzero_si256();
+        for (int theta = 0; theta < 3; ++theta) {
+            __m256i c = _mm256_mullo_epi32(
+                _mm256_abs_epi32(load_epi16_epi32(angles[theta] + idx)),
+                one_by_15);
+            c = _mm256_srai_epi32(_mm256_add_epi32(c, add_thr), 12);
+            c = _mm256_srai_epi32(_mm256_slli_epi32(c, 16), 16);
+            thr = _mm256_add_epi32(thr, c);
+            thr = _mm256_add_epi32(thr, cm_flt_sum_8(flt_angles[theta] + idx,
+                                                     csf_a_stride));
+        }
+
+        for (int theta = 0; theta < 3; ++theta) {
+            __m256i x = _mm256_mullo_epi32(load_epi16_epi32(
+                src_angles[theta] + i * src_stride + j), rfactor[theta]);
+            x = _mm256_sub_epi32(_mm256_abs_epi32(x),
+                                 _mm256_slli_epi32(thr, shift_xsub[theta]));
+            x = _mm256_max_epi32(x, _mm256_setzero_si256());
+            acc[theta] = cm_accum_8(acc[theta], x, add_xsq[theta],
+                                    shift_xsq[theta], add_xcub[theta],
+                                    shift_xcub[theta]);
         }
     }
+
+    for (int theta = 0; theta < 3; ++theta)
+        accum[theta] += hsum_epi64(acc[theta]);
+    adm_cm_row(src, csf_a, csf_f, src_stride, csf_a_stride, i, j, j_end,
+               i_rfactor, add_shift_cub, shift_cub, accum);
+}
+
+/* Sum of the eight flt neighbours of eight pixels of one band. */
+static inline __m256i i4_cm_flt_sum_8(const int32_t *flt, int stride)
+{
+    const int32_t *above = flt - stride;
+    const int32_t *below = flt + stride;
+    __m256i sum = _mm256_add_epi32(
+        _mm256_loadu_si256((const __m256i *)(above - 1)),
+        _mm256_loadu_si256((const __m256i *)above));
+    sum = _mm256_add_epi32(sum,
+        _mm256_loadu_si256((const __m256i *)(above + 1)));
+    sum = _mm256_add_epi32(sum, _mm256_loadu_si256((const __m256i *)(flt - 1)));
+    sum = _mm256_add_epi32(sum, _mm256_loadu_si256((const __m256i *)(flt + 1)));
+    sum = _mm256_add_epi32(sum,
+        _mm256_loadu_si256((const __m256i *)(below - 1)));
+    sum = _mm256_add_epi32(sum, _mm256_loadu_si256((const __m256i *)below));
+    return _mm256_add_epi32(sum,
+        _mm256_loadu_si256((const __m256i *)(below + 1)));
+}
+
+void i4_adm_cm_row_avx2(const i4_adm_dwt_band_t *src,
+                        const i4_adm_dwt_band_t *csf_a,
+                        const i4_adm_dwt_band_t *csf_f, int src_stride,
+                        int csf_a_stride, int i, int j_begin, int j_end,
+                        const uint32_t *rfactor, int32_t add_bef_shift_dst,
+                        uint32_t shift_dst, int32_t add_bef_shift_flt,
+                        uint32_t shift_flt, uint32_t add_shift_cub,
+                        uint32_t shift_cub, int64_t *accum)
+{
+    const int32_t *src_angles[3] = { src->band_h, src->band_v, src->band_d };
+    const int32_t *angles[3] = { csf_a->band_h, csf_a->band_v, csf_a->band_d };
+    const int32_t *flt_angles[3] =
+        { csf_f->band_h, csf_f->band_v, csf_f->band_d };
+
+    __m256i rf[3];
+    for (int theta = 0; theta < 3; ++theta)
+        rf[theta] = _mm256_set1_epi32(rfactor[theta]);
+    const __m256i add_dst = _mm256_set1_epi64x(add_bef_shift_dst);
+    const __m128i sh_dst = _mm_cvtsi32_si128(shift_dst);
+    const __m256i one_by_15 = _mm256_set1_epi32(I4_ONE_BY_15);
+    const __m256i add_flt = _mm256_set1_epi64x(add_bef_shift_flt);
+    const __m128i sh_flt = _mm_cvtsi32_si128(shift_flt);
+    const __m256i add_sq = _mm256_set1_epi64x(1 << 29);
+    const __m256i add_cub = _mm256_set1_epi64x(add_shift_cub);
+    const __m128i sh_cub = _mm_cvtsi32_si128(shift_cub);
+    __m256i acc[3] = { _mm256_setzero_si256(), _mm256_setzero_si256(),
+                       _mm256_setzero_si256() };
+
+    int j = j_begin;
+    for (; j + 8 <= j_end; j += 8) {
+        const int idx = i * csf_a_stride + j;
+        __m256i thr = _mm256_setzero_si256();
+        for (int theta = 0; theta < 3; ++theta) {
+            const __m256i a = _mm256_abs_epi32(
+                _mm256_loadu_si256((const __m256i *)(angles[theta] + idx)));
+            thr = _mm256_add_epi32(thr, mul_round_epi32(a, one_by_15, add_flt,
+                                                        sh_flt));
+            thr = _mm256_add_epi32(thr, i4_cm_flt_sum_8(
+                flt_angles[theta] + idx, csf_a_stride));
+        }
+
+        for (int theta = 0; theta < 3; ++theta) {
+            const __m256i s = _mm256_loadu_si256(
+                (const __m256i *)(src_angles[theta] + i * src_stride + j));
+            __m256i x = mul_round_epi32(s, rf[theta], add_dst, sh_dst);
+            x = _mm256_sub_epi32(_mm256_abs_epi32(x), thr);
+            x = _mm256_max_epi32(x, _mm256_setzero_si256());
+            acc[theta] = cm_accum_8(acc[theta], x, add_sq, 30, add_cub,
+                                    sh_cub);
+        }
+    }
+
+    for (int theta = 0; theta < 3; ++theta)
+        accum[theta] += hsum_epi64(acc[theta]);
+    i4_adm_cm_row(src, csf_a, csf_f, src_stride, csf_a_stride, i, j, j_end,
+                  rfactor, add_bef_shift_dst, shift_dst, add_bef_shift_flt,
+                  shift_flt, add_shift_cub, shift_cub, accum);
 }
@@ -0,0 +1,860 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include "feature/integer_adm.h"
+
+#include <immintrin.h>
+
+static inline __m512i load_epi16_epi32(const int16_t *p)
+{
+    return _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i *)p));
+}
+
+/* Stores 16 int32 as int16, truncating like a C cast would. */
+static inline void store_epi32_epi16(int16_t *p, __m512i x)
+{
+    _mm256_storeu_si256((__m256i *)p, _mm512_cvtepi32_epi16(x));
+}
+
+/* Interleaves the low dwords of the 64-bit lanes of even and odd. */
+static inline __m512i merge_epi64_lo(__m512i even, __m512i odd)
+{
+    return _mm512_mask_blend_epi32(0xAAAA, even, _mm512_slli_epi64(odd, 32));
+}
+
+/* (int32_t)(((int64_t)a * b + add) >> shift) with b unsigned. */
+static inline __m512i mul_round_epi32(__m512i a, __m512i b, __m512i add,
+                                      __m128i shift)
+{
+    const __m512i a_odd = _mm512_srli_epi64(a, 32);
+    const __m512i b_odd = _mm512_srli_epi64(b, 32);
+    // mul_epi32 takes b as signed, add back a << 32 where it is not
+    const __mmask16 b_neg = _mm512_movepi32_mask(b);
+    const __m512i fix = _mm512_maskz_mov_epi32(b_neg, a);
+    __m512i even = _mm512_add_epi64(_mm512_mul_epi32(a, b),
+                                    _mm512_slli_epi64(fix, 32));
+    __m512i odd = _mm512_add_epi64(_mm512_mul_epi32(a_odd, b_odd),
+        _mm512_maskz_mov_epi32(0xAAAA, fix));
+    even = _mm512_sra_epi64(_mm512_add_epi64(even, add), shift);
+    odd = _mm512_sra_epi64(_mm512_add_epi64(odd, add), shift);
+    return merge_epi64_lo(even, odd);
+}
+
+static inline __m512i load_epu8_epi16(const uint8_t *p)
+{
+    return _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)p));
+}
+
+/*
+ * Vertical pass of 32 columns from their samples u0 to u3 in the four input
+ * rows, which must fit an int16 for madd.
+ */
+static inline void dwt2_vert_32(__m512i u0, __m512i u1, __m512i u2,
+                                __m512i u3, __m512i add_lo, __m512i add_hi,
+                                __m128i shift, int16_t *tmplo, int16_t *tmphi)
+{
+    const __m512i f01_lo = _mm512_set1_epi32(
+        (uint16_t)dwt2_db2_coeffs_lo[0] | (dwt2_db2_coeffs_lo[1] << 16));
+    const __m512i f23_lo = _mm512_set1_epi32(
+        (uint16_t)dwt2_db2_coeffs_lo[2] | (dwt2_db2_coeffs_lo[3] << 16));
+    const __m512i f01_hi = _mm512_set1_epi32(
+        (uint16_t)dwt2_db2_coeffs_hi[0] | (dwt2_db2_coeffs_hi[1] << 16));
+    const __m512i f23_hi = _mm512_set1_epi32(
+        (uint16_t)dwt2_db2_coeffs_hi[2] | (dwt2_db2_coeffs_hi[3] << 16));
+
+    const __m512i u01l = _mm512_unpacklo_epi16(u0, u1);
+    const __m512i u01h = _mm512_unpackhi_epi16(u0, u1);
+    const __m512i u23l = _mm512_unpacklo_epi16(u2, u3);
+    const __m512i u23h = _mm512_unpackhi_epi16(u2, u3);
+
+    __m512i lo_l = _mm512_add_epi32(_mm512_madd_epi16(u01l, f01_lo),
+                                    _mm512_madd_epi16(u23l, f23_lo));
+    __m512i lo_h = _mm512_add_epi32(_mm512_madd_epi16(u01h, f01_lo),
+                                    _mm512_madd_epi16(u23h, f23_lo));
+    __m512i hi_l = _mm512_add_epi32(_mm512_madd_epi16(u01l, f01_hi),
+                                    _mm512_madd_epi16(u23l, f23_hi));
+    __m512i hi_h = _mm512_add_epi32(_mm512_madd_epi16(u01h, f01_hi),
+                                    _mm512_madd_epi16(u23h, f23_hi));
+    lo_l = _mm512_sra_epi32(_mm512_add_epi32(lo_l, add_lo), shift);
+    lo_h = _mm512_sra_epi32(_mm512_add_epi32(lo_h, add_lo), shift);
+    hi_l = _mm512_sra_epi32(_mm512_add_epi32(hi_l, add_hi), shift);
+    hi_h = _mm512_sra_epi32(_mm512_add_epi32(hi_h, add_hi), shift);
+
+    // unpack and pack both work within 128-bit lanes, which leaves the
+    // columns in order
+    lo_l = _mm512_srai_epi32(_mm512_slli_epi32(lo_l, 16), 16);
+    lo_h = _mm512_srai_epi32(_mm512_slli_epi32(lo_h, 16), 16);
+    hi_l = _mm512_srai_epi32(_mm512_slli_epi32(hi_l, 16), 16);
+    hi_h = _mm512_srai_epi32(_mm512_slli_epi32(hi_h, 16), 16);
+    _mm512_storeu_si512(tmplo, _mm512_packs_epi32(lo_l, lo_h));
+    _mm512_storeu_si512(tmphi, _mm512_packs_epi32(hi_l, hi_h));
+}
+
+void adm_dwt2_8_vert_avx512(const uint8_t *src, int **ind_y, int i, int w,
+                            int src_stride, int16_t *tmplo, int16_t *tmphi)
+{
+    const uint8_t *s0 = src + ind_y[0][i] * src_stride;
+    const uint8_t *s1 = src + ind_y[1][i] * src_stride;
+    const uint8_t *s2 = src + ind_y[2][i] * src_stride;
+    const uint8_t *s3 = src + ind_y[3][i] * src_stride;
+
+    const int32_t add_shift_VP = 128;
+    const __m512i add_lo = _mm512_set1_epi32(add_shift_VP -
+        dwt2_db2_coeffs_lo_sum * add_shift_VP);
+    const __m512i add_hi = _mm512_set1_epi32(add_shift_VP -
+        dwt2_db2_coeffs_hi_sum * add_shift_VP);
+    const __m128i shift = _mm_cvtsi32_si128(8);
+
+    int j = 0;
+    for (; j + 32 <= w; j += 32) {
+        dwt2_vert_32(load_epu8_epi16(s0 + j), load_epu8_epi16(s1 + j),
+                     load_epu8_epi16(s2 + j), load_epu8_epi16(s3 + j),
+                     add_lo, add_hi, shift, tmplo + j, tmphi + j);
+    }
+
+    for (; j < w; ++j)
+        adm_dwt2_8_vert_px(src, ind_y, i, j, src_stride, tmplo, tmphi);
+}
+
+void adm_dwt2_16_vert_avx512(const uint16_t *src, int **ind_y, int i, int w,
+                             int src_stride, int inp_size_bits,
+                             int16_t *tmplo, int16_t *tmphi)
+{
+    const uint16_t *s0 = src + ind_y[0][i] * src_stride;
+    const uint16_t *s1 = src + ind_y[1][i] * src_stride;
+    const uint16_t *s2 = src + ind_y[2][i] * src_stride;
+    const uint16_t *s3 = src + ind_y[3][i] * src_stride;
+
+    const int32_t add_shift_VP = 1 << (inp_size_bits - 1);
+    const __m512i add_lo = _mm512_set1_epi32(add_shift_VP -
+        dwt2_db2_coeffs_lo_sum * add_shift_VP);
+    const __m512i add_hi = _mm512_set1_epi32(add_shift_VP -
+        dwt2_db2_coeffs_hi_sum * add_shift_VP);
+    const __m128i shift = _mm_cvtsi32_si128(inp_size_bits);
+
+    int j = 0;
+    // samples must fit an int16 for madd
+    if (inp_size_bits <= 15) {
+        for (; j + 32 <= w; j += 32) {
+            dwt2_vert_32(_mm512_loadu_si512(s0 + j),
+                         _mm512_loadu_si512(s1 + j),
+                         _mm512_loadu_si512(s2 + j),
+                         _mm512_loadu_si512(s3 + j),
+                         add_lo, add_hi, shift, tmplo + j, tmphi + j);
+        }
+    }
+
+    for (; j < w; ++j) {
+        adm_dwt2_16_vert_px(src, ind_y, i, j, src_stride, inp_size_bits,
+                            tmplo, tmphi);
+    }
+}
+
+/*
+ * Outputs j to j + 31 of one horizontal pass, from the taps at 2j - 1 to
+ * 2j + 64 of tmp.
+ */
+static inline void dwt2_16_hori_32(const int16_t *tmp, int j, __m512i f01_lo,
+                                   __m512i f23_lo, __m512i f01_hi,
+                                   __m512i f23_hi, int16_t *dst_lo,
+                                   int16_t *dst_hi)
+{
+    const __m512i add = _mm512_set1_epi32(32768);
+    const __m512i t0 = _mm512_loadu_si512(tmp + 2 * j - 1);
+    const __m512i t1 = _mm512_loadu_si512(tmp + 2 * j + 1);
+    const __m512i t2 = _mm512_loadu_si512(tmp + 2 * j + 31);
+    const __m512i t3 = _mm512_loadu_si512(tmp + 2 * j + 33);
+
+    __m512i lo0 = _mm512_add_epi32(_mm512_madd_epi16(t0, f01_lo),
+                                   _mm512_madd_epi16(t1, f23_lo));
+    __m512i lo1 = _mm512_add_epi32(_mm512_madd_epi16(t2, f01_lo),
+                                   _mm512_madd_epi16(t3, f23_lo));
+    __m512i hi0 = _mm512_add_epi32(_mm512_madd_epi16(t0, f01_hi),
+                                   _mm512_madd_epi16(t1, f23_hi));
+    __m512i hi1 = _mm512_add_epi32(_mm512_madd_epi16(t2, f01_hi),
+                                   _mm512_madd_epi16(t3, f23_hi));
+    lo0 = _mm512_srai_epi32(_mm512_add_epi32(lo0, add), 16);
+    lo1 = _mm512_srai_epi32(_mm512_add_epi32(lo1, add), 16);
+    hi0 = _mm512_srai_epi32(_mm512_add_epi32(hi0, add), 16);
+    hi1 = _mm512_srai_epi32(_mm512_add_epi32(hi1, add), 16);
+
+    store_epi32_epi16(dst_lo + j, lo0);
+    store_epi32_epi16(dst_lo + j + 16, lo1);
+    store_epi32_epi16(dst_hi + j, hi0);
+    store_epi32_epi16(dst_hi + j + 16, hi1);
+}
+
+void adm_dwt2_16_hori_avx512(const int16_t *tmplo, const int16_t *tmphi,
+                             int **ind_x, int w, const adm_dwt_band_t *dst,
+                             size_t offset)
+{
+    const __m512i f01_lo = _mm512_set1_epi32(
+        (uint16_t)dwt2_db2_coeffs_lo[0] | (dwt2_db2_coeffs_lo[1] << 16));
+    const __m512i f23_lo = _mm512_set1_epi32(
+        (uint16_t)dwt2_db2_coeffs_lo[2] | (dwt2_db2_coeffs_lo[3] << 16));
+    const __m512i f01_hi = _mm512_set1_epi32(
+        (uint16_t)dwt2_db2_coeffs_hi[0] | (dwt2_db2_coeffs_hi[1] << 16));
+    const __m512i f23_hi = _mm512_set1_epi32(
+        (uint16_t)dwt2_db2_coeffs_hi[2] | (dwt2_db2_coeffs_hi[3] << 16));
+
+    // away from the borders, output j reads the taps 2j - 1 to 2j + 2
+    adm_dwt2_16_hori_px(tmplo, tmphi, ind_x, 0, dst, offset);
+    int j = 1;
+    for (; 2 * j + 64 < w; j += 32) {
+        dwt2_16_hori_32(tmplo, j, f01_lo, f23_lo, f01_hi, f23_hi,
+                        dst->band_a + offset, dst->band_v + offset);
+        dwt2_16_hori_32(tmphi, j, f01_lo, f23_lo, f01_hi, f23_hi,
+                        dst->band_h + offset, dst->band_d + offset);
+    }
+    for (; j < (w + 1) / 2; ++j)
+        adm_dwt2_16_hori_px(tmplo, tmphi, ind_x, j, dst, offset);
+}
+
+/* Sum of the four 64-bit filter products of the int32 lanes of s0 to s3. */
+static inline __m512i filt4_epi64(__m512i s0, __m512i s1, __m512i s2,
+                                  __m512i s3, const int16_t *f)
+{
+    __m512i acc = _mm512_mul_epi32(s0, _mm512_set1_epi64(f[0]));
+    acc = _mm512_add_epi64(acc, _mm512_mul_epi32(s1, _mm512_set1_epi64(f[1])));
+    acc = _mm512_add_epi64(acc, _mm512_mul_epi32(s2, _mm512_set1_epi64(f[2])));
+    acc = _mm512_add_epi64(acc, _mm512_mul_epi32(s3, _mm512_set1_epi64(f[3])));
+    return acc;
+}
+
+void adm_dwt2_s123_vert_avx512(const int32_t *src, int **ind_y, int i, int w,
+                               int src_stride, int32_t add, int16_t shift,
+                               int32_t *tmplo, int32_t *tmphi)
+{
+    const int32_t *p0 = src + ind_y[0][i] * src_stride;
+    const int32_t *p1 = src + ind_y[1][i] * src_stride;
+    const int32_t *p2 = src + ind_y[2][i] * src_stride;
+    const int32_t *p3 = src + ind_y[3][i] * src_stride;
+
+    const __m512i add64 = _mm512_set1_epi64(add);
+    const __m128i cnt = _mm_cvtsi32_si128(shift);
+
+    int j = 0;
+    for (; j + 16 <= w; j += 16) {
+        const __m512i s0 = _mm512_loadu_si512(p0 + j);
+        const __m512i s1 = _mm512_loadu_si512(p1 + j);
+        const __m512i s2 = _mm512_loadu_si512(p2 + j);
+        const __m512i s3 = _mm512_loadu_si512(p3 + j);
+        const __m512i s0o = _mm512_srli_epi64(s0, 32);
+        const __m512i s1o = _mm512_srli_epi64(s1, 32);
+        const __m512i s2o = _mm512_srli_epi64(s2, 32);
+        const __m512i s3o = _mm512_srli_epi64(s3, 32);
+
+        __m512i even = filt4_epi64(s0, s1, s2, s3, dwt2_db2_coeffs_lo);
+        __m512i odd = filt4_epi64(s0o, s1o, s2o, s3o, dwt2_db2_coeffs_lo);
+        even = _mm512_sra_epi64(_mm512_add_epi64(even, add64), cnt);
+        odd = _mm512_sra_epi64(_mm512_add_epi64(odd, add64), cnt);
+        _mm512_storeu_si512(tmplo + j, merge_epi64_lo(even, odd));
+
+        even = filt4_epi64(s0, s1, s2, s3, dwt2_db2_coeffs_hi);
+        odd = filt4_epi64(s0o, s1o, s2o, s3o, dwt2_db2_coeffs_hi);
+        even = _mm512_sra_epi64(_mm512_add_epi64(even, add64), cnt);
+        odd = _mm512_sra_epi64(_mm512_add_epi64(odd, add64), cnt);
+        _mm512_storeu_si512(tmphi + j, merge_epi64_lo(even, odd));
+    }
+
+    for (; j < w; ++j) {
+        adm_dwt2_s123_vert_px(src, ind_y, i, j, src_stride, add, shift, tmplo,
+                              tmphi);
+    }
+}
+
+/*
+ * Outputs j to j + 15 of one horizontal pass, from the taps at 2j - 1 to
+ * 2j + 32 of tmp.
+ */
+static inline void dwt2_s123_hori_16(const int32_t *tmp, int j, __m512i add,
+                                     __m128i cnt, int32_t *dst_lo,
+                                     int32_t *dst_hi)
+{
+    // the 64-bit lanes of x hold the taps 2j - 1 and 2j of outputs j to
+    // j + 7, the ones of y the taps 2j + 1 and 2j + 2
+    const __m512i x0 = _mm512_loadu_si512(tmp + 2 * j - 1);
+    const __m512i y0 = _mm512_loadu_si512(tmp + 2 * j + 1);
+    const __m512i x1 = _mm512_loadu_si512(tmp + 2 * j + 15);
+    const __m512i y1 = _mm512_loadu_si512(tmp + 2 * j + 17);
+    const __m512i x0o = _mm512_srli_epi64(x0, 32);
+    const __m512i y0o = _mm512_srli_epi64(y0, 32);
+    const __m512i x1o = _mm512_srli_epi64(x1, 32);
+    const __m512i y1o = _mm512_srli_epi64(y1, 32);
+
+    __m512i r0 = filt4_epi64(x0, x0o, y0, y0o, dwt2_db2_coeffs_lo);
+    __m512i r1 = filt4_epi64(x1, x1o, y1, y1o, dwt2_db2_coeffs_lo);
+    r0 = _mm512_sra_epi64(_mm512_add_epi64(r0, add), cnt);
+    r1 = _mm512_sra_epi64(_mm512_add_epi64(r1, add), cnt);
+    _mm256_storeu_si256((__m256i *)(dst_lo + j), _mm512_cvtepi64_epi32(r0));
+    _mm256_storeu_si256((__m256i *)(dst_lo + j + 8), _mm512_cvtepi64_epi32(r1));
+
+    r0 = filt4_epi64(x0, x0o, y0, y0o, dwt2_db2_coeffs_hi);
+    r1 = filt4_epi64(x1, x1o, y1, y1o, dwt2_db2_coeffs_hi);
+    r0 = _mm512_sra_epi64(_mm512_add_epi64(r0, add), cnt);
+    r1 = _mm512_sra_epi64(_mm512_add_epi64(r1, add), cnt);
+    _mm256_storeu_si256((__m256i *)(dst_hi + j), _mm512_cvtepi64_epi32(r0));
+    _mm256_storeu_si256((__m256i *)(dst_hi + j + 8), _mm512_cvtepi64_epi32(r1));
+}
+
+void adm_dwt2_s123_hori_avx512(const int32_t *tmplo, const int32_t *tmphi,
+                               int **ind_x, int w,
+                               const i4_adm_dwt_band_t *dst, size_t offset,
+                               int32_t add, int16_t shift)
+{
+    const __m512i add64 = _mm512_set1_epi64(add);
+    const __m128i cnt = _mm_cvtsi32_si128(shift);
+
+    adm_dwt2_s123_hori_px(tmplo, tmphi, ind_x, 0, dst, offset, add, shift);
+    int j = 1;
+    for (; 2 * j + 32 < w; j += 16) {
+        dwt2_s123_hori_16(tmplo, j, add64, cnt, dst->band_a + offset,
+                          dst->band_v + offset);
+        dwt2_s123_hori_16(tmphi, j, add64, cnt, dst->band_h + offset,
+                          dst->band_d + offset);
+    }
+    for (; j < (w + 1) / 2; ++j)
+        adm_dwt2_s123_hori_px(tmplo, tmphi, ind_x, j, dst, offset, add, shift);
+}
+
+/*
+ * Rounds the 64-bit lanes of x to float like the scalar conversion of an
+ * int64_t does, then divides by 4096.
+ */
+static inline __m512d cvt_scaled_pd(__m512i x)
+{
+    return _mm512_mul_pd(_mm512_cvtps_pd(_mm512_cvtepi64_ps(x)),
+                         _mm512_set1_pd(1.0 / 4096.0));
+}
+
+/* adm_decouple_angle_flag() of eight pixels, held in 64-bit lanes. */
+static inline __mmask8 angle_flag_8(__m512i oh, __m512i ov, __m512i th,
+                                    __m512i tv, __m512d cos_1deg_sq)
+{
+    const __m512i ot_dp = _mm512_add_epi64(_mm512_mul_epi32(oh, th),
+                                           _mm512_mul_epi32(ov, tv));
+    const __m512i o_mag_sq = _mm512_add_epi64(_mm512_mul_epi32(oh, oh),
+                                              _mm512_mul_epi32(ov, ov));
+    const __m512i t_mag_sq = _mm512_add_epi64(_mm512_mul_epi32(th, th),
+                                              _mm512_mul_epi32(tv, tv));
+
+    const __m512d ot = cvt_scaled_pd(ot_dp);
+    const __m512d lhs = _mm512_mul_pd(ot, ot);
+    const __m512d rhs = _mm512_mul_pd(_mm512_mul_pd(cos_1deg_sq,
+                                                    cvt_scaled_pd(o_mag_sq)),
+                                      cvt_scaled_pd(t_mag_sq));
+    return _mm512_cmp_pd_mask(ot, _mm512_setzero_pd(), _CMP_GE_OQ) &
+           _mm512_cmp_pd_mask(lhs, rhs, _CMP_GE_OQ);
+}
+
+/*
+ * adm_decouple_angle_flag() of sixteen pixels, from the exact 64-bit dot
+ * products.
+ */
+static inline __mmask16 angle_flag_16(__m512i oh, __m512i ov, __m512i th,
+                                      __m512i tv, __m512d cos_1deg_sq)
+{
+    const __mmask8 lo = angle_flag_8(
+        _mm512_cvtepi32_epi64(_mm512_castsi512_si256(oh)),
+        _mm512_cvtepi32_epi64(_mm512_castsi512_si256(ov)),
+        _mm512_cvtepi32_epi64(_mm512_castsi512_si256(th)),
+        _mm512_cvtepi32_epi64(_mm512_castsi512_si256(tv)), cos_1deg_sq);
+    const __mmask8 hi = angle_flag_8(
+        _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(oh, 1)),
+        _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(ov, 1)),
+        _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(th, 1)),
+        _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(tv, 1)),
+        cos_1deg_sq);
+    return _mm512_kunpackb(hi, lo);
+}
+
+/*
+ * Applies the enhancement gain limit to rst where the angle flag is set,
+ * pos and neg select the lanes of positive and negative rst_f.
+ */
+static inline __m512i decouple_gain(__m512i rst, __m512i t, __mmask16 pos,
+                                    __mmask16 neg, __m512d egl)
+{
+    if (!(pos | neg)) return rst;
+
+    const __m512d r_lo =
+        _mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_castsi512_si256(rst)), egl);
+    const __m512d r_hi = _mm512_mul_pd(
+        _mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(rst, 1)), egl);
+    const __m512d t_lo = _mm512_cvtepi32_pd(_mm512_castsi512_si256(t));
+    const __m512d t_hi = _mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(t, 1));
+
+    const __m512i min = _mm512_inserti64x4(_mm512_castsi256_si512(
+        _mm512_cvttpd_epi32(_mm512_min_pd(r_lo, t_lo))),
+        _mm512_cvttpd_epi32(_mm512_min_pd(r_hi, t_hi)), 1);
+    const __m512i max = _mm512_inserti64x4(_mm512_castsi256_si512(
+        _mm512_cvttpd_epi32(_mm512_max_pd(r_lo, t_lo))),
+        _mm512_cvttpd_epi32(_mm512_max_pd(r_hi, t_hi)), 1);
+    rst = _mm512_mask_mov_epi32(rst, pos, min);
+    return _mm512_mask_mov_epi32(rst, neg, max);
+}
+
+/* adm_decouple_px() of one band of sixteen pixels. */
+static inline void decouple_band_16(const int16_t *o_ptr,
+                                    const int16_t *t_ptr, int16_t *r_ptr,
+                                    int16_t *a_ptr, __mmask16 angle_flag,
+                                    __m512d egl)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i o = load_epi16_epi32(o_ptr);
+    const __m512i t = load_epi16_epi32(t_ptr);
+
+    // |div * t| < 2^45, the low 32 bits of the shift need no sign
+    const __m512i div = _mm512_i32gather_epi32(
+        _mm512_add_epi32(o, _mm512_set1_epi32(32768)), div_lookup, 4);
+    const __m512i round = _mm512_set1_epi64(16384);
+    __m512i even = _mm512_mul_epi32(div, t);
+    __m512i odd = _mm512_mul_epi32(_mm512_srli_epi64(div, 32),
+                                   _mm512_srli_epi64(t, 32));
+    even = _mm512_srli_epi64(_mm512_add_epi64(even, round), 15);
+    odd = _mm512_srli_epi64(_mm512_add_epi64(odd, round), 15);
+    __m512i k = merge_epi64_lo(even, odd);
+    k = _mm512_min_epi32(_mm512_max_epi32(k, zero), _mm512_set1_epi32(32768));
+    k = _mm512_mask_mov_epi32(k, _mm512_cmpeq_epi32_mask(o, zero),
+                              _mm512_set1_epi32(32768));
+
+    __m512i rst = _mm512_mullo_epi32(k, o);
+    rst = _mm512_srai_epi32(_mm512_add_epi32(rst, _mm512_set1_epi32(16384)),
+                            15);
+    rst = _mm512_srai_epi32(_mm512_slli_epi32(rst, 16), 16);
+
+    const __mmask16 k_pos = angle_flag & _mm512_cmpgt_epi32_mask(k, zero);
+    const __mmask16 pos = k_pos & _mm512_cmpgt_epi32_mask(o, zero);
+    const __mmask16 neg = k_pos & _mm512_cmplt_epi32_mask(o, zero);
+    rst = decouple_gain(rst, t, pos, neg, egl);
+
+    store_epi32_epi16(r_ptr, rst);
+    store_epi32_epi16(a_ptr, _mm512_sub_epi32(t, rst));
+}
+
+void adm_decouple_row_avx512(const adm_dwt_band_t *ref,
+                             const adm_dwt_band_t *dis,
+                             const adm_dwt_band_t *r, const adm_dwt_band_t *a,
+                             size_t offset, int n, float cos_1deg_sq,
+                             double adm_enhn_gain_limit)
+{
+    const __m512d cos_sq = _mm512_set1_pd(cos_1deg_sq);
+    const __m512d egl = _mm512_set1_pd(adm_enhn_gain_limit);
+
+    int j = 0;
+    for (; j + 16 <= n; j += 16) {
+        const size_t idx = offset + j;
+        const __mmask16 flag =
+            angle_flag_16(load_epi16_epi32(ref->band_h + idx),
+                          load_epi16_epi32(ref->band_v + idx),
+                          load_epi16_epi32(dis->band_h + idx),
+                          load_epi16_epi32(dis->band_v + idx), cos_sq);
+        decouple_band_16(ref->band_h + idx, dis->band_h + idx,
+                         r->band_h + idx, a->band_h + idx, flag, egl);
+        decouple_band_16(ref->band_v + idx, dis->band_v + idx,
+                         r->band_v + idx, a->band_v + idx, flag, egl);
+        decouple_band_16(ref->band_d + idx, dis->band_d + idx,
+                         r->band_d + idx, a->band_d + idx, flag, egl);
+    }
+
+    for (; j < n; ++j) {
+        adm_decouple_pixel(ref, dis, r, a, offset + j, cos_1deg_sq,
+                           adm_enhn_gain_limit);
+    }
+}
+
+/* Clamps the signed 64-bit lanes of x to [0, 32768]. */
+static inline __m512i clamp_k_epi64(__m512i x)
+{
+    return _mm512_min_epi64(_mm512_max_epi64(x, _mm512_setzero_si512()),
+                            _mm512_set1_epi64(32768));
+}
+
+/* i4_adm_decouple_px() of one band of sixteen pixels. */
+static inline void i4_decouple_band_16(const int32_t *o_ptr,
+                                       const int32_t *t_ptr, int32_t *r_ptr,
+                                       int32_t *a_ptr, __mmask16 angle_flag,
+                                       __m512d egl)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i o = _mm512_loadu_si512(o_ptr);
+    const __m512i t = _mm512_loadu_si512(t_ptr);
+
+    // k_shift of get_best15_from32(), zero where abs_o fits the table
+    const __m512i abs_o = _mm512_abs_epi32(o);
+    const __mmask16 wide = _mm512_cmpgt_epu32_mask(abs_o,
+                                                   _mm512_set1_epi32(32767));
+    const __m512i sh = _mm512_maskz_sub_epi32(wide, _mm512_set1_epi32(17),
+                                              _mm512_lzcnt_epi32(abs_o));
+    // the rounding term vanishes for sh = 0, as the shift count wraps
+    const __m512i msb = _mm512_srlv_epi32(_mm512_add_epi32(abs_o,
+        _mm512_sllv_epi32(one, _mm512_sub_epi32(sh, one))), sh);
+
+    const __m512i div = _mm512_i32gather_epi32(
+        _mm512_add_epi32(msb, _mm512_set1_epi32(32768)), div_lookup, 4);
+    const __m512i sdiv = _mm512_mask_sub_epi32(div,
+        _mm512_cmplt_epi32_mask(o, zero), zero, div);
+
+    const __m512i sh_even = _mm512_maskz_mov_epi32(0x5555, sh);
+    const __m512i sh_odd = _mm512_srli_epi64(sh, 32);
+    const __m512i round = _mm512_set1_epi64(1 << 14);
+    const __m512i fifteen = _mm512_set1_epi64(15);
+    __m512i even = _mm512_mul_epi32(sdiv, t);
+    __m512i odd = _mm512_mul_epi32(_mm512_srli_epi64(sdiv, 32),
+                                   _mm512_srli_epi64(t, 32));
+    even = _mm512_add_epi64(even, _mm512_sllv_epi64(round, sh_even));
+    odd = _mm512_add_epi64(odd, _mm512_sllv_epi64(round, sh_odd));
+    even = clamp_k_epi64(_mm512_srav_epi64(even,
+                         _mm512_add_epi64(sh_even, fifteen)));
+    odd = clamp_k_epi64(_mm512_srav_epi64(odd,
+                        _mm512_add_epi64(sh_odd, fifteen)));
+    __m512i k = merge_epi64_lo(even, odd);
+    k = _mm512_mask_mov_epi32(k, _mm512_cmpeq_epi32_mask(o, zero),
+                              _mm512_set1_epi32(32768));
+
+    const __m512i round_rst = _mm512_set1_epi64(16384);
+    even = _mm512_mul_epi32(k, o);
+    odd = _mm512_mul_epi32(_mm512_srli_epi64(k, 32), _mm512_srli_epi64(o, 32));
+    even = _mm512_srli_epi64(_mm512_add_epi64(even, round_rst), 15);
+    odd = _mm512_srli_epi64(_mm512_add_epi64(odd, round_rst), 15);
+    __m512i rst = merge_epi64_lo(even, odd);
+
+    const __mmask16 k_pos = angle_flag & _mm512_cmpgt_epi32_mask(k, zero);
+    const __mmask16 pos = k_pos & _mm512_cmpgt_epi32_mask(o, zero);
+    const __mmask16 neg = k_pos & _mm512_cmplt_epi32_mask(o, zero);
+    rst = decouple_gain(rst, t, pos, neg, egl);
+
+    _mm512_storeu_si512(r_ptr, rst);
+    _mm512_storeu_si512(a_ptr, _mm512_sub_epi32(t, rst));
+}
+
+void i4_adm_decouple_row_avx512(const i4_adm_dwt_band_t *ref,
+                                const i4_adm_dwt_band_t *dis,
+                                const i4_adm_dwt_band_t *r,
+                                const i4_adm_dwt_band_t *a, size_t offset,
+                                int n, float cos_1deg_sq,
+                                double adm_enhn_gain_limit)
+{
+    const __m512d cos_sq = _mm512_set1_pd(cos_1deg_sq);
+    const __m512d egl = _mm512_set1_pd(adm_enhn_gain_limit);
+
+    int j = 0;
+    for (; j + 16 <= n; j += 16) {
+        const size_t idx = offset + j;
+        const __mmask16 flag =
+            angle_flag_16(_mm512_loadu_si512(ref->band_h + idx),
+                          _mm512_loadu_si512(ref->band_v + idx),
+                          _mm512_loadu_si512(dis->band_h + idx),
+                          _mm512_loadu_si512(dis->band_v + idx), cos_sq);
+        i4_decouple_band_16(ref->band_h + idx, dis->band_h + idx,
+                            r->band_h + idx, a->band_h + idx, flag, egl);
+        i4_decouple_band_16(ref->band_v + idx, dis->band_v + idx,
+                            r->band_v + idx, a->band_v + idx, flag, egl);
+        i4_decouple_band_16(ref->band_d + idx, dis->band_d + idx,
+                            r->band_d + idx, a->band_d + idx, flag, egl);
+    }
+
+    for (; j < n; ++j) {
+        i4_adm_decouple_pixel(ref, dis, r, a, offset + j, cos_1deg_sq,
+                              adm_enhn_gain_limit);
+    }
+}
+
+void adm_csf_row_avx512(const int16_t *src, int16_t *dst, int16_t *flt, int n,
+                        uint16_t i_rfactor, uint8_t i_shift,
+                        uint16_t i_shiftsadd)
+{
+    const __m512i rfactor = _mm512_set1_epi32(i_rfactor);
+    const __m512i add = _mm512_set1_epi32(i_shiftsadd);
+    const __m128i shift = _mm_cvtsi32_si128(i_shift);
+    const __m512i one_by_30 = _mm512_set1_epi32(4369);
+    const __m512i add_flt = _mm512_set1_epi32(2048);
+
+    int j = 0;
+    for (; j + 16 <= n; j += 16) {
+        __m512i d = _mm512_mullo_epi32(load_epi16_epi32(src + j), rfactor);
+        d = _mm512_sra_epi32(_mm512_add_epi32(d, add), shift);
+        d = _mm512_srai_epi32(_mm512_slli_epi32(d, 16), 16);
+        __m512i f = _mm512_mullo_epi32(_mm512_abs_epi32(d), one_by_30);
+        f = _mm512_srai_epi32(_mm512_add_epi32(f, add_flt), 12);
+        store_epi32_epi16(dst + j, d);
+        store_epi32_epi16(flt + j, f);
+    }
+
+    for (; j < n; ++j)
+        adm_csf_px(src[j], i_rfactor, i_shift, i_shiftsadd, &dst[j], &flt[j]);
+}
+
+void i4_adm_csf_row_avx512(const int32_t *src, int32_t *dst, int32_t *flt,
+                           int n, uint32_t i_rfactor,
+                           int32_t add_bef_shift_dst, uint32_t shift_dst,
+                           int32_t add_bef_shift_flt, uint32_t shift_flt)
+{
+    const __m512i rfactor = _mm512_set1_epi32(i_rfactor);
+    const __m512i add_dst = _mm512_set1_epi64(add_bef_shift_dst);
+    const __m128i sh_dst = _mm_cvtsi32_si128(shift_dst);
+    const __m512i one_by_30 = _mm512_set1_epi32(143165577);
+    const __m512i add_flt = _mm512_set1_epi64(add_bef_shift_flt);
+    const __m128i sh_flt = _mm_cvtsi32_si128(shift_flt);
+
+    int j = 0;
+    for (; j + 16 <= n; j += 16) {
+        const __m512i s = _mm512_loadu_si512(src + j);
+        const __m512i d = mul_round_epi32(s, rfactor, add_dst, sh_dst);
+        const __m512i f = mul_round_epi32(_mm512_abs_epi32(d), one_by_30,
+                                          add_flt, sh_flt);
+        _mm512_storeu_si512(dst + j, d);
+        _mm512_storeu_si512(flt + j, f);
+    }
+
+    for (; j < n; ++j) {
+        i4_adm_csf_px(src[j], i_rfactor, add_bef_shift_dst, shift_dst,
+                      add_bef_shift_flt, shift_flt, &dst[j], &flt[j]);
+    }
+}
+
+uint64_t adm_csf_den_row_avx512(const int16_t *src, int n)
+{
+    __m512i acc = _mm512_setzero_si512();
+
+    int j = 0;
+    for (; j + 16 <= n; j += 16) {
+        const __m512i x = _mm512_abs_epi32(load_epi16_epi32(src + j));
+        const __m512i x_sq = _mm512_mullo_epi32(x, x);
+        const __m512i even = _mm512_mul_epu32(x_sq, x);
+        const __m512i odd = _mm512_mul_epu32(_mm512_srli_epi64(x_sq, 32),
+                                             _mm512_srli_epi64(x, 32));
+        acc = _mm512_add_epi64(acc, _mm512_add_epi64(even, odd));
+    }
+
+    uint64_t accum = _mm512_reduce_add_epi64(acc);
+    for (; j < n; ++j)
+        accum += adm_csf_den_px(src[j]);
+    return accum;
+}
+
+/* adm_csf_den_s123_px() of the low dwords of the 64-bit lanes of x. */
+static inline __m512i csf_den_s123_8(__m512i x, __m512i add_sq, __m128i sh_sq,
+                                     __m512i add_cub, __m128i sh_cub)
+{
+    const __m512i q = _mm512_srl_epi64(
+        _mm512_add_epi64(_mm512_mul_epu32(x, x), add_sq), sh_sq);
+    // q may exceed 32 bits, the product wraps like the scalar one
+    const __m512i qx = _mm512_mullo_epi64(q, _mm512_maskz_mov_epi32(0x5555, x));
+    return _mm512_srl_epi64(_mm512_add_epi64(qx, add_cub), sh_cub);
+}
+
+uint64_t adm_csf_den_s123_row_avx512(const int32_t *src, int n,
+                                     uint32_t add_shift_sq, uint32_t shift_sq,
+                                     uint32_t add_shift_cub,
+                                     uint32_t shift_cub)
+{
+    const __m512i add_sq = _mm512_set1_epi64(add_shift_sq);
+    const __m128i sh_sq = _mm_cvtsi32_si128(shift_sq);
+    const __m512i add_cub = _mm512_set1_epi64(add_shift_cub);
+    const __m128i sh_cub = _mm_cvtsi32_si128(shift_cub);
+    __m512i acc = _mm512_setzero_si512();
+
+    int j = 0;
+    for (; j + 16 <= n; j += 16) {
+        const __m512i x = _mm512_abs_epi32(_mm512_loadu_si512(src + j));
+        acc = _mm512_add_epi64(acc, csf_den_s123_8(x, add_sq, sh_sq, add_cub,
+                                                   sh_cub));
+        acc = _mm512_add_epi64(acc, csf_den_s123_8(_mm512_srli_epi64(x, 32),
+                                                   add_sq, sh_sq, add_cub,
+                                                   sh_cub));
+    }
+
+    uint64_t accum = _mm512_reduce_add_epi64(acc);
+    for (; j < n; ++j) {
+        accum += adm_csf_den_s123_px(src[j], add_shift_sq, shift_sq,
+                                     add_shift_cub, shift_cub);
+    }
+    return accum;
+}
+
+/*
+ * Adds ((x_sq * x) + add_cub) >> shift_cub of sixteen pixels to acc, where
+ * x_sq = ((x * x) + add_sq) >> shift_sq truncated to 32 bits.
+ */
+static inline __m512i cm_accum_16(__m512i acc, __m512i x, __m512i add_sq,
+                                  int shift_sq, __m512i add_cub,
+                                  __m128i shift_cub)
+{
+    const __m128i sh_sq = _mm_cvtsi32_si128(shift_sq);
+    const __m512i x_odd = _mm512_srli_epi64(x, 32);
+    // mul_epi32 only reads the low dword of x_sq, which truncates it
+    __m512i sq = _mm512_srl_epi64(
+        _mm512_add_epi64(_mm512_mul_epu32(x, x), add_sq), sh_sq);
+    acc = _mm512_add_epi64(acc, _mm512_sra_epi64(_mm512_add_epi64(
+        _mm512_mul_epi32(sq, x), add_cub), shift_cub));
+    sq = _mm512_srl_epi64(
+        _mm512_add_epi64(_mm512_mul_epu32(x_odd, x_odd), add_sq), sh_sq);
+    return _mm512_add_epi64(acc, _mm512_sra_epi64(_mm512_add_epi64(
+        _mm512_mul_epi32(sq, x_odd), add_cub), shift_cub));
+}
+
+/* Sum of the eight flt neighbours of sixteen pixels of one band. */
+static inline __m512i cm_flt_sum_16(const int16_t *flt, int stride)
+{
+    const int16_t *above = flt - stride;
+    const int16_t *below = flt + stride;
+    __m512i sum = _mm512_add_epi32(load_epi16_epi32(above - 1),
+                                   load_epi16_epi32(above));
+    sum = _mm512_add_epi32(sum, load_epi16_epi32(above + 1));
+    sum = _mm512_add_epi32(sum, load_epi16_epi32(flt - 1));
+    sum = _mm512_add_epi32(sum, load_epi16_epi32(flt + 1));
+    sum = _mm512_add_epi32(sum, load_epi16_epi32(below - 1));
+    sum = _mm512_add_epi32(sum, load_epi16_epi32(below));
+    return _mm512_add_epi32(sum, load_epi16_epi32(below + 1));
+}
+
+void adm_cm_row_avx512(const adm_dwt_band_t *src, const adm_dwt_band_t *csf_a,
+                       const adm_dwt_band_t *csf_f, int src_stride,
+                       int csf_a_stride, int i, int j_begin, int j_end,
+                       const uint16_t *i_rfactor,
+                       const uint32_t *add_shift_cub,
+                       const uint32_t *shift_cub, int64_t *accum)
+{
+    const int16_t *src_angles[3] = { src->band_h, src->band_v, src->band_d };
+    const int16_t *angles[3] = { csf_a->band_h, csf_a->band_v, csf_a->band_d };
+    const int16_t *flt_angles[3] =
+        { csf_f->band_h, csf_f->band_v, csf_f->band_d };
+    const int shift_xsq[3] = { 29, 29, 30 };
+    const int shift_xsub[3] = { 10, 10, 12 };
+
+    __m512i rfactor[3], add_xsq[3], add_xcub[3];
+    __m128i shift_xcub[3];
+    for (int theta = 0; theta < 3; ++theta) {
+        rfactor[theta] = _mm512_set1_epi32(i_rfactor[theta]);
+        add_xsq[theta] = _mm512_set1_epi64(1 << (shift_xsq[theta] - 1));
+        add_xcub[theta] = _mm512_set1_epi64(add_shift_cub[theta]);
+        shift_xcub[theta] = _mm_cvtsi32_si128(shift_cub[theta]);
+    }
+    const __m512i one_by_15 = _mm512_set1_epi32(ONE_BY_15);
+    const __m512i add_thr = _mm512_set1_epi32(2048);
+    __m512i acc[3] = { _mm512_setzero_si512(), _mm512_setzero_si512(),
+                       _mm512_setzero_si512() };
+
+    int j = j_begin;
+    for (; j + 16 <= j_end; j += 16) {
+        const int idx = i * csf_a_stride + j;
+        __m512i thr = _mm512_setzero_si512();
+        for (int theta = 0; theta < 3; ++theta) {
+            __m512i c = _mm512_mullo_epi32(
+                _mm512_abs_epi32(load_epi16_epi32(angles[theta] + idx)),
+                one_by_15);
+            c = _mm512_srai_epi32(_mm512_add_epi32(c, add_thr), 12);
+            c = _mm512_srai_epi32(_mm512_slli_epi32(c, 16), 16);
+            thr = _mm512_add_epi32(thr, c);
+            thr = _mm512_add_epi32(thr, cm_flt_sum_16(flt_angles[theta] + idx,
+                                                      csf_a_stride));
+        }
+
+        for (int theta = 0; theta < 3; ++theta) {
+            __m512i x = _mm512_mullo_epi32(load_epi16_epi32(
+                src_angles[theta] + i * src_stride + j), rfactor[theta]);
+            x = _mm512_sub_epi32(_mm512_abs_epi32(x),
+                _mm512_sll_epi32(thr, _mm_cvtsi32_si128(shift_xsub[theta])));
+            x = _mm512_max_epi32(x, _mm512_setzero_si512());
+            acc[theta] = cm_accum_16(acc[theta], x, add_xsq[theta],
+                                     shift_xsq[theta], add_xcub[theta],
+                                     shift_xcub[theta]);
+        }
+    }
+
+    for (int theta = 0; theta < 3; ++theta)
+        accum[theta] += _mm512_reduce_add_epi64(acc[theta]);
+    adm_cm_row(src, csf_a, csf_f, src_stride, csf_a_stride, i, j, j_end,
+               i_rfactor, add_shift_cub, shift_cub, accum);
+}
+
+/* Sum of the eight flt neighbours of sixteen pixels of one band. */
+static inline __m512i i4_cm_flt_sum_16(const int32_t *flt, int stride)
+{
+    const int32_t *above = flt - stride;
+    const int32_t *below = flt + stride;
+    __m512i sum = _mm512_add_epi32(_mm512_loadu_si512(above - 1),
+                                   _mm512_loadu_si512(above));
+    sum = _mm512_add_epi32(sum, _mm512_loadu_si512(above + 1));
+    sum = _mm512_add_epi32(sum, _mm512_loadu_si512(flt - 1));
+    sum = _mm512_add_epi32(sum, _mm512_loadu_si512(flt + 1));
+    sum = _mm512_add_epi32(sum, _mm512_loadu_si512(below - 1));
+    sum = _mm512_add_epi32(sum, _mm512_loadu_si512(below));
+    return _mm512_add_epi32(sum, _mm512_loadu_si512(below + 1));
+}
+
+void i4_adm_cm_row_avx512(const i4_adm_dwt_band_t *src,
+                          const i4_adm_dwt_band_t *csf_a,
+                          const i4_adm_dwt_band_t *csf_f, int src_stride,
+                          int csf_a_stride, int i, int j_begin, int j_end,
+                          const uint32_t *rfactor, int32_t add_bef_shift_dst,
+                          uint32_t shift_dst, int32_t add_bef_shift_flt,
+                          uint32_t shift_flt, uint32_t add_shift_cub,
+                          uint32_t shift_cub, int64_t *accum)
+{
+    const int32_t *src_angles[3] = { src->band_h, src->band_v, src->band_d };
+    const int32_t *angles[3] = { csf_a->band_h, csf_a->band_v, csf_a->band_d };
+    const int32_t *flt_angles[3] =
+        { csf_f->band_h, csf_f->band_v, csf_f->band_d };
+
+    __m512i rf[3];
+    for (int theta = 0; theta < 3; ++theta)
+        rf[theta] = _mm512_set1_epi32(rfactor[theta]);
+    const __m512i add_dst = _mm512_set1_epi64(add_bef_shift_dst);
+    const __m128i sh_dst = _mm_cvtsi32_si128(shift_dst);
+    const __m512i one_by_15 = _mm512_set1_epi32(I4_ONE_BY_15);
+    const __m512i add_flt = _mm512_set1_epi64(add_bef_shift_flt);
+    const __m128i sh_flt = _mm_cvtsi32_si128(shift_flt);
+    const __m512i add_sq = _mm512_set1_epi64(1 << 29);
+    const __m512i add_cub = _mm512_set1_epi64(add_shift_cub);
+    const __m128i sh_cub = _mm_cvtsi32_si128(shift_cub);
+    __m512i acc[3] = { _mm512_setzero_si512(), _mm512_setzero_si512(),
+                       _mm512_setzero_si512() };
+
+    int j = j_begin;
+    for (; j + 16 <= j_end; j += 16) {
+        const int idx = i * csf_a_stride + j;
+        __m512i thr = _mm512_setzero_si512();
+        for (int theta = 0; theta < 3; ++theta) {
+            const __m512i a =
+                _mm512_abs_epi32(_mm512_loadu_si512(angles[theta] + idx));
+            thr = _mm512_add_epi32(thr, mul_round_epi32(a, one_by_15, add_flt,
+                                                        sh_flt));
+            thr = _mm512_add_epi32(thr, i4_cm_flt_sum_16(
+                flt_angles[theta] + idx, csf_a_stride));
+        }
+
+        for (int theta = 0; theta < 3; ++theta) {
+            const __m512i s =
+                _mm512_loadu_si512(src_angles[theta] + i * src_stride + j);
+            __m512i x = mul_round_epi32(s, rf[theta], add_dst, sh_dst);
+            x = _mm512_sub_epi32(_mm512_abs_epi32(x), thr);
+            x = _mm512_max_epi32(x, _mm512_setzero_si512());
+            acc[theta] = cm_accum_16(acc[theta], x, add_sq, 30, add_cub,
+                                     sh_cub);
+        }
+    }
+
+    for (int theta = 0; theta < 3; ++theta)
+        accum[theta] += _mm512_reduce_add_epi64(acc[theta]);
+    i4_adm_cm_row(src, csf_a, csf_f, src_stride, csf_a_stride, i, j, j_end,
+                  rfactor, add_bef_shift_dst, shift_dst, add_bef_shift_flt,
+                  shift_flt, add_shift_cub, shift_cub, accum);
+}
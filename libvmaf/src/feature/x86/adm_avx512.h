@@ -0,0 +1,89 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef X86_AVX512_ADM_H_
+#define X86_AVX512_ADM_H_
+
+#include "feature/integer_adm.h"
+
+void adm_dwt2_8_vert_avx512(const uint8_t *src, int **ind_y, int i, int w,
+                            int src_stride, int16_t *tmplo, int16_t *tmphi);
+
+void adm_dwt2_16_vert_avx512(const uint16_t *src, int **ind_y, int i, int w,
+                             int src_stride, int inp_size_bits,
+                             int16_t *tmplo, int16_t *tmphi);
+
+void adm_dwt2_16_hori_avx512(const int16_t *tmplo, const int16_t *tmphi,
+                             int **ind_x, int w, const adm_dwt_band_t *dst,
+                             size_t offset);
+
+void adm_dwt2_s123_vert_avx512(const int32_t *src, int **ind_y, int i, int w,
+                               int src_stride, int32_t add, int16_t shift,
+                               int32_t *tmplo, int32_t *tmphi);
+
+void adm_dwt2_s123_hori_avx512(const int32_t *tmplo, const int32_t *tmphi,
+                               int **ind_x, int w,
+                               const i4_adm_dwt_band_t *dst, size_t offset,
+                               int32_t add, int16_t shift);
+
+void adm_decouple_row_avx512(const adm_dwt_band_t *ref,
+                             const adm_dwt_band_t *dis,
+                             const adm_dwt_band_t *r, const adm_dwt_band_t *a,
+                             size_t offset, int n, float cos_1deg_sq,
+                             double adm_enhn_gain_limit);
+
+void i4_adm_decouple_row_avx512(const i4_adm_dwt_band_t *ref,
+                                const i4_adm_dwt_band_t *dis,
+                                const i4_adm_dwt_band_t *r,
+                                const i4_adm_dwt_band_t *a, size_t offset,
+                                int n, float cos_1deg_sq,
+                                double adm_enhn_gain_limit);
+
+void adm_csf_row_avx512(const int16_t *src, int16_t *dst, int16_t *flt, int n,
+                        uint16_t i_rfactor, uint8_t i_shift,
+                        uint16_t i_shiftsadd);
+
+void i4_adm_csf_row_avx512(const int32_t *src, int32_t *dst, int32_t *flt,
+                           int n, uint32_t i_rfactor,
+                           int32_t add_bef_shift_dst, uint32_t shift_dst,
+                           int32_t add_bef_shift_flt, uint32_t shift_flt);
+
+uint64_t adm_csf_den_row_avx512(const int16_t *src, int n);
+
+uint64_t adm_csf_den_s123_row_avx512(const int32_t *src, int n,
+                                     uint32_t add_shift_sq, uint32_t shift_sq,
+                                     uint32_t add_shift_cub,
+                                     uint32_t shift_cub);
+
+void adm_cm_row_avx512(const adm_dwt_band_t *src, const adm_dwt_band_t *csf_a,
+                       const adm_dwt_band_t *csf_f, int src_stride,
+                       int csf_a_stride, int i, int j_begin, int j_end,
+                       const uint16_t *i_rfactor,
+                       const uint32_t *add_shift_cub,
+                       const uint32_t *shift_cub, int64_t *accum);
+
+void i4_adm_cm_row_avx512(const i4_adm_dwt_band_t *src,
+                          const i4_adm_dwt_band_t *csf_a,
+                          const i4_adm_dwt_band_t *csf_f, int src_stride,
+                          int csf_a_stride, int i, int j_begin, int j_end,
+                          const uint32_t *rfactor, int32_t add_bef_shift_dst,
+                          uint32_t shift_dst, int32_t add_bef_shift_flt,
+                          uint32_t shift_flt, uint32_t add_shift_cub,
+                          uint32_t shift_cub, int64_t *accum);
+
+#endif /* X86_AVX512_ADM_H_ */
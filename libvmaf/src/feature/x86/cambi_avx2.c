@@ -44,3 +44,177 @@ void cambi_decrement_range_avx2(uint16_t *arr, int left, int right) {
         arr[col]--;
     } 
 }
+
+static inline uint16_t mode3(uint16_t a, uint16_t b, uint16_t c) {
+    if (a == b || a == c) return a;
+    if (b == c) return b;
+    if (a <= b && a <= c) return a;
+    if (b <= c) return b;
+    return c;
+}
+
+/* The 32 bit gathers also read the bin after the one wanted, so the last
+ * column of the row, whose next bin may lie past the histograms, is left to
+ * the scalar loop. */
+void cambi_c_values_row_avx2(float *c_values, const uint16_t *histograms,
+                             const uint16_t *image, const uint16_t *mask,
+                             int width, uint16_t num_diffs,
+                             const uint16_t *tvi_for_diff,
+                             const int *diff_weights, const int *all_diffs) {
+    const int *hist = (const int *) histograms;
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i bin_mask = _mm256_set1_epi32(0xffff);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i vwidth = _mm256_set1_epi32(width);
+    const __m256i vnum_diffs = _mm256_set1_epi32(num_diffs);
+
+    int col = 0;
+    for (; col + 8 < width; col += 8) {
+        __m256i m = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) &mask[col]));
+        __m256i masked = _mm256_cmpeq_epi32(m, zero);
+        if (_mm256_movemask_epi8(masked) == -1) continue;
+
+        __m256i value = _mm256_add_epi32(
+            _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) &image[col])), vnum_diffs);
+        __m256i idx_0 = _mm256_add_epi32(_mm256_mullo_epi32(value, vwidth),
+                                         _mm256_add_epi32(_mm256_set1_epi32(col), lane));
+        __m256i p_0 = _mm256_and_si256(_mm256_i32gather_epi32(hist, idx_0, 2), bin_mask);
+
+        __m256 c_value = _mm256_setzero_ps();
+        for (uint16_t d = 0; d < num_diffs; d++) {
+            __m256i in_tvi = _mm256_cmpgt_epi32(_mm256_set1_epi32(tvi_for_diff[d] + 1), value);
+            __m256i idx_1 = _mm256_add_epi32(idx_0, _mm256_set1_epi32(all_diffs[num_diffs + d + 1] * width));
+            __m256i idx_2 = _mm256_add_epi32(idx_0, _mm256_set1_epi32(all_diffs[num_diffs - d - 1] * width));
+            __m256i p_1 = _mm256_and_si256(_mm256_i32gather_epi32(hist, idx_1, 2), bin_mask);
+            __m256i p_2 = _mm256_and_si256(_mm256_i32gather_epi32(hist, idx_2, 2), bin_mask);
+            __m256i p = _mm256_max_epi32(p_1, p_2);
+
+            __m256i num = _mm256_mullo_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(diff_weights[d]), p_0), p);
+            __m256 val = _mm256_div_ps(_mm256_cvtepi32_ps(num),
+                                       _mm256_cvtepi32_ps(_mm256_add_epi32(p, p_0)));
+            __m256 update = _mm256_and_ps(_mm256_castsi256_ps(in_tvi),
+                                          _mm256_cmp_ps(val, c_value, _CMP_GT_OQ));
+            c_value = _mm256_blendv_ps(c_value, val, update);
+        }
+
+        __m256 c = _mm256_loadu_ps(&c_values[col]);
+        _mm256_storeu_ps(&c_values[col], _mm256_blendv_ps(c_value, c, _mm256_castsi256_ps(masked)));
+    }
+
+    for (; col < width; col++) {
+        if (!mask[col]) continue;
+        uint16_t value = image[col] + num_diffs;
+        uint16_t p_0 = histograms[value * width + col];
+        float val, c_value = 0.0;
+        for (uint16_t d = 0; d < num_diffs; d++) {
+            if (value <= tvi_for_diff[d]) {
+                uint16_t p_1 = histograms[(value + all_diffs[num_diffs + d + 1]) * width + col];
+                uint16_t p_2 = histograms[(value + all_diffs[num_diffs - d - 1]) * width + col];
+                uint16_t p = p_1 > p_2 ? p_1 : p_2;
+                val = (float)(diff_weights[d] * p_0 * p) / (p + p_0);
+                if (val > c_value) c_value = val;
+            }
+        }
+        c_values[col] = c_value;
+    }
+}
+
+void cambi_mode3_row_avx2(uint16_t *dst, const uint16_t *a, const uint16_t *b,
+                          const uint16_t *c, int width) {
+    int col = 0;
+    for (; col + 15 < width; col += 16) {
+        __m256i va = _mm256_loadu_si256((const __m256i*) &a[col]);
+        __m256i vb = _mm256_loadu_si256((const __m256i*) &b[col]);
+        __m256i vc = _mm256_loadu_si256((const __m256i*) &c[col]);
+        __m256i mode = _mm256_min_epu16(_mm256_min_epu16(va, vb), vc);
+        mode = _mm256_blendv_epi8(mode, vb, _mm256_cmpeq_epi16(vb, vc));
+        __m256i a_eq = _mm256_or_si256(_mm256_cmpeq_epi16(va, vb), _mm256_cmpeq_epi16(va, vc));
+        mode = _mm256_blendv_epi8(mode, va, a_eq);
+        _mm256_storeu_si256((__m256i*) &dst[col], mode);
+    }
+    for (; col < width; col++) {
+        dst[col] = mode3(a[col], b[col], c[col]);
+    }
+}
+
+/* dst may be src: the loads of each step are ahead of its stores. */
+void cambi_decimate_row_avx2(uint16_t *dst, const uint16_t *src, int width) {
+    const __m256i even = _mm256_set1_epi32(0xffff);
+    int col = 0;
+    for (; col + 16 < width; col += 16) {
+        __m256i lo = _mm256_and_si256(_mm256_loadu_si256((const __m256i*) &src[2 * col]), even);
+        __m256i hi = _mm256_and_si256(_mm256_loadu_si256((const __m256i*) &src[2 * col + 16]), even);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xd8);
+        _mm256_storeu_si256((__m256i*) &dst[col], packed);
+    }
+    for (; col < width; col++) {
+        dst[col] = src[col << 1];
+    }
+}
+
+/* Inclusive prefix sum of the 8 lanes. */
+static inline __m256i prefix_sum_epi32(__m256i x) {
+    x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+    x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+    __m256i carry = _mm256_shuffle_epi32(x, 0xff);
+    return _mm256_add_epi32(x, _mm256_permute2x128_si256(carry, carry, 0x08));
+}
+
+uint32_t cambi_mask_dp_row_avx2(uint32_t *dp, const uint32_t *dp_prev,
+                                const uint16_t *image,
+                                const uint16_t *image_below, int width) {
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i last = _mm256_set1_epi32(7);
+    __m256i sum = _mm256_setzero_si256();
+
+    int col = 0;
+    for (; col + 8 < width; col += 8) {
+        __m256i center = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) &image[col]));
+        __m256i right = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) &image[col + 1]));
+        __m256i zero_derivative = _mm256_cmpeq_epi32(center, right);
+        if (image_below) {
+            __m256i below = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) &image_below[col]));
+            zero_derivative = _mm256_and_si256(zero_derivative, _mm256_cmpeq_epi32(center, below));
+        }
+        sum = _mm256_add_epi32(sum, prefix_sum_epi32(_mm256_and_si256(zero_derivative, one)));
+        __m256i prev = _mm256_loadu_si256((const __m256i*) &dp_prev[col]);
+        _mm256_storeu_si256((__m256i*) &dp[col], _mm256_add_epi32(prev, sum));
+        sum = _mm256_permutevar8x32_epi32(sum, last);
+    }
+
+    uint32_t s = _mm256_cvtsi256_si32(sum);
+    for (; col < width; col++) {
+        s += (!image_below || image[col] == image_below[col]) &&
+             (col == width - 1 || image[col] == image[col + 1]);
+        dp[col] = dp_prev[col] + s;
+    }
+    return s;
+}
+
+void cambi_mask_row_avx2(uint16_t *mask, const uint32_t *dp_bottom,
+                         const uint32_t *dp_top, int filter_size,
+                         uint16_t mask_index, int width) {
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i index = _mm256_set1_epi32(mask_index);
+
+    int col = 0;
+    for (; col + 15 < width; col += 16) {
+        __m256i result[2];
+        for (int k = 0; k < 2; k++) {
+            const int j = col + 8 * k;
+            __m256i br = _mm256_loadu_si256((const __m256i*) &dp_bottom[j + filter_size]);
+            __m256i bl = _mm256_loadu_si256((const __m256i*) &dp_bottom[j]);
+            __m256i tr = _mm256_loadu_si256((const __m256i*) &dp_top[j + filter_size]);
+            __m256i tl = _mm256_loadu_si256((const __m256i*) &dp_top[j]);
+            __m256i sum = _mm256_add_epi32(_mm256_sub_epi32(_mm256_sub_epi32(br, bl), tr), tl);
+            result[k] = _mm256_and_si256(_mm256_cmpgt_epi32(sum, index), one);
+        }
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(result[0], result[1]), 0xd8);
+        _mm256_storeu_si256((__m256i*) &mask[col], packed);
+    }
+    for (; col < width; col++) {
+        int result = dp_bottom[col + filter_size] - dp_bottom[col]
+                     - dp_top[col + filter_size] + dp_top[col];
+        mask[col] = (result > mask_index);
+    }
+}
@@ -0,0 +1,155 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <immintrin.h>
+#include <stdint.h>
+
+#include "cambi_avx512.h"
+
+/* The window of a pixel is at most a few hundred columns wide, so its
+ * remainder is handled with a masked load and store rather than a loop. */
+static inline __mmask32 tail_mask(int n) {
+    return n >= 32 ? 0xffffffff : ((__mmask32) 1 << n) - 1;
+}
+
+void cambi_increment_range_avx512(uint16_t *arr, int left, int right) {
+    const __m512i one = _mm512_set1_epi16(1);
+    for (int col = left; col < right; col += 32) {
+        __mmask32 m = tail_mask(right - col);
+        __m512i data = _mm512_maskz_loadu_epi16(m, &arr[col]);
+        _mm512_mask_storeu_epi16(&arr[col], m, _mm512_add_epi16(data, one));
+    }
+}
+
+void cambi_decrement_range_avx512(uint16_t *arr, int left, int right) {
+    const __m512i one = _mm512_set1_epi16(1);
+    for (int col = left; col < right; col += 32) {
+        __mmask32 m = tail_mask(right - col);
+        __m512i data = _mm512_maskz_loadu_epi16(m, &arr[col]);
+        _mm512_mask_storeu_epi16(&arr[col], m, _mm512_sub_epi16(data, one));
+    }
+}
+
+static inline uint16_t mode3(uint16_t a, uint16_t b, uint16_t c) {
+    if (a == b || a == c) return a;
+    if (b == c) return b;
+    if (a <= b && a <= c) return a;
+    if (b <= c) return b;
+    return c;
+}
+
+/* The 32 bit gathers also read the bin after the one wanted, so the last
+ * column of the row, whose next bin may lie past the histograms, is left to
+ * the scalar loop. */
+void cambi_c_values_row_avx512(float *c_values, const uint16_t *histograms,
+                               const uint16_t *image, const uint16_t *mask,
+                               int width, uint16_t num_diffs,
+                               const uint16_t *tvi_for_diff,
+                               const int *diff_weights, const int *all_diffs) {
+    const int *hist = (const int *) histograms;
+    const __m512i lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                                           8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i bin_mask = _mm512_set1_epi32(0xffff);
+    const __m512i vwidth = _mm512_set1_epi32(width);
+    const __m512i vnum_diffs = _mm512_set1_epi32(num_diffs);
+
+    int col = 0;
+    for (; col + 16 < width; col += 16) {
+        __mmask16 masked = _mm256_test_epi16_mask(
+            _mm256_loadu_si256((const __m256i*) &mask[col]),
+            _mm256_set1_epi16(-1));
+        if (!masked) continue;
+
+        __m512i value = _mm512_add_epi32(
+            _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*) &image[col])), vnum_diffs);
+        __m512i idx_0 = _mm512_add_epi32(_mm512_mullo_epi32(value, vwidth),
+                                         _mm512_add_epi32(_mm512_set1_epi32(col), lane));
+        __m512i p_0 = _mm512_and_si512(_mm512_i32gather_epi32(idx_0, hist, 2), bin_mask);
+
+        __m512 c_value = _mm512_setzero_ps();
+        for (uint16_t d = 0; d < num_diffs; d++) {
+            __mmask16 in_tvi = _mm512_cmple_epu32_mask(value, _mm512_set1_epi32(tvi_for_diff[d]));
+            __m512i idx_1 = _mm512_add_epi32(idx_0, _mm512_set1_epi32(all_diffs[num_diffs + d + 1] * width));
+            __m512i idx_2 = _mm512_add_epi32(idx_0, _mm512_set1_epi32(all_diffs[num_diffs - d - 1] * width));
+            __m512i p_1 = _mm512_and_si512(_mm512_i32gather_epi32(idx_1, hist, 2), bin_mask);
+            __m512i p_2 = _mm512_and_si512(_mm512_i32gather_epi32(idx_2, hist, 2), bin_mask);
+            __m512i p = _mm512_max_epi32(p_1, p_2);
+
+            __m512i num = _mm512_mullo_epi32(_mm512_mullo_epi32(_mm512_set1_epi32(diff_weights[d]), p_0), p);
+            __m512 val = _mm512_div_ps(_mm512_cvtepi32_ps(num),
+                                       _mm512_cvtepi32_ps(_mm512_add_epi32(p, p_0)));
+            __mmask16 update = _mm512_mask_cmp_ps_mask(in_tvi, val, c_value, _CMP_GT_OQ);
+            c_value = _mm512_mask_blend_ps(update, c_value, val);
+        }
+
+        _mm512_mask_storeu_ps(&c_values[col], masked, c_value);
+    }
+
+    for (; col < width; col++) {
+        if (!mask[col]) continue;
+        uint16_t value = image[col] + num_diffs;
+        uint16_t p_0 = histograms[value * width + col];
+        float val, c_value = 0.0;
+        for (uint16_t d = 0; d < num_diffs; d++) {
+            if (value <= tvi_for_diff[d]) {
+                uint16_t p_1 = histograms[(value + all_diffs[num_diffs + d + 1]) * width + col];
+                uint16_t p_2 = histograms[(value + all_diffs[num_diffs - d - 1]) * width + col];
+                uint16_t p = p_1 > p_2 ? p_1 : p_2;
+                val = (float)(diff_weights[d] * p_0 * p) / (p + p_0);
+                if (val > c_value) c_value = val;
+            }
+        }
+        c_values[col] = c_value;
+    }
+}
+
+void cambi_mode3_row_avx512(uint16_t *dst, const uint16_t *a, const uint16_t *b,
+                            const uint16_t *c, int width) {
+    int col = 0;
+    for (; col + 31 < width; col += 32) {
+        __m512i va = _mm512_loadu_si512((const __m512i*) &a[col]);
+        __m512i vb = _mm512_loadu_si512((const __m512i*) &b[col]);
+        __m512i vc = _mm512_loadu_si512((const __m512i*) &c[col]);
+        __m512i mode = _mm512_min_epu16(_mm512_min_epu16(va, vb), vc);
+        mode = _mm512_mask_blend_epi16(_mm512_cmpeq_epi16_mask(vb, vc), mode, vb);
+        __mmask32 a_eq = _mm512_cmpeq_epi16_mask(va, vb) | _mm512_cmpeq_epi16_mask(va, vc);
+        mode = _mm512_mask_blend_epi16(a_eq, mode, va);
+        _mm512_storeu_si512((__m512i*) &dst[col], mode);
+    }
+    for (; col < width; col++) {
+        dst[col] = mode3(a[col], b[col], c[col]);
+    }
+}
+
+/* dst may be src: the loads of each step are ahead of its stores. */
+void cambi_decimate_row_avx512(uint16_t *dst, const uint16_t *src, int width) {
+    static const uint16_t even_idx[32] = {
+         0,  2,  4,  6,  8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30,
+        32, 34, 36, 38, 40, 42, 44, 46, 48, 50, 52, 54, 56, 58, 60, 62,
+    };
+    const __m512i even = _mm512_loadu_si512((const __m512i*) even_idx);
+    int col = 0;
+    for (; col + 32 < width; col += 32) {
+        __m512i lo = _mm512_loadu_si512((const __m512i*) &src[2 * col]);
+        __m512i hi = _mm512_loadu_si512((const __m512i*) &src[2 * col + 32]);
+        _mm512_storeu_si512((__m512i*) &dst[col], _mm512_permutex2var_epi16(lo, even, hi));
+    }
+    for (; col < width; col++) {
+        dst[col] = src[col << 1];
+    }
+}
@@ -0,0 +1,40 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef X86_AVX512_CAMBI_H_
+#define X86_AVX512_CAMBI_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+void cambi_increment_range_avx512(uint16_t *arr, int left, int right);
+
+void cambi_decrement_range_avx512(uint16_t *arr, int left, int right);
+
+void cambi_c_values_row_avx512(float *c_values, const uint16_t *histograms,
+                               const uint16_t *image, const uint16_t *mask,
+                               int width, uint16_t num_diffs,
+                               const uint16_t *tvi_for_diff,
+                               const int *diff_weights, const int *all_diffs);
+
+void cambi_mode3_row_avx512(uint16_t *dst, const uint16_t *a, const uint16_t *b,
+                            const uint16_t *c, int width);
+
+void cambi_decimate_row_avx512(uint16_t *dst, const uint16_t *src, int width);
+
+#endif /* X86_AVX512_CAMBI_H_ */
@@ -0,0 +1,388 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+
+#include <immintrin.h>
+#include <math.h>
+
+#include "ciede_avx2.h"
+
+/*
+ * Single precision versions of the libm functions used by the scalar
+ * ciede2000(), following the cephes polynomials.
+ */
+
+static inline __m256 log_ps(__m256 x)
+{
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256i i = _mm256_castps_si256(x);
+    __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(i, 23),
+                                                   _mm256_set1_epi32(126)));
+    __m256 m = _mm256_castsi256_ps(
+        _mm256_or_si256(_mm256_and_si256(i, _mm256_set1_epi32(0x007fffff)),
+                        _mm256_set1_epi32(0x3f000000)));
+
+    // m in [sqrt(0.5), sqrt(2)), minus one
+    const __m256 lt =
+        _mm256_cmp_ps(m, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+    e = _mm256_sub_ps(e, _mm256_and_ps(lt, one));
+    m = _mm256_add_ps(_mm256_sub_ps(m, one), _mm256_and_ps(lt, m));
+
+    const __m256 z = _mm256_mul_ps(m, m);
+    __m256 y = _mm256_set1_ps(7.0376836292e-2f);
+    y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(-1.1514610310e-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(1.1676998740e-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(-1.2420140846e-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(1.4249322787e-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(-1.6668057665e-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(2.0000714765e-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(-2.4999993993e-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(3.3333331174e-1f));
+    y = _mm256_mul_ps(_mm256_mul_ps(y, m), z);
+
+    y = _mm256_add_ps(y, _mm256_mul_ps(e, _mm256_set1_ps(-2.12194440e-4f)));
+    y = _mm256_sub_ps(y, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+    return _mm256_add_ps(_mm256_add_ps(m, y),
+                         _mm256_mul_ps(e, _mm256_set1_ps(0.693359375f)));
+}
+
+static inline __m256 exp_ps(__m256 x)
+{
+    x = _mm256_min_ps(x, _mm256_set1_ps(88.3762626647949f));
+    x = _mm256_max_ps(x, _mm256_set1_ps(-87.3365447504f));
+
+    const __m256 n = _mm256_round_ps(
+        _mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)),
+        _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    x = _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(0.693359375f)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(-2.12194440e-4f)));
+
+    const __m256 z = _mm256_mul_ps(x, x);
+    __m256 y = _mm256_set1_ps(1.9875691500e-4f);
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.3981999507e-3f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(8.3334519073e-3f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(4.1665795894e-2f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.6666665459e-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(5.0000001201e-1f));
+    y = _mm256_add_ps(_mm256_mul_ps(y, z), x);
+    y = _mm256_add_ps(y, _mm256_set1_ps(1.f));
+
+    const __m256i e = _mm256_slli_epi32(
+        _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(e));
+}
+
+// sine and cosine of x >= 0
+static inline void sincos_ps(__m256 x, __m256 *s, __m256 *c)
+{
+    __m256i j = _mm256_cvttps_epi32(
+        _mm256_mul_ps(x, _mm256_set1_ps(1.27323954473516f)));
+    j = _mm256_and_si256(_mm256_add_epi32(j, _mm256_set1_epi32(1)),
+                         _mm256_set1_epi32(~1));
+    const __m256 y = _mm256_cvtepi32_ps(j);
+    x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(0.78515625f)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(2.4187564849853515625e-4f)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(3.77489497744594108e-8f)));
+
+    const __m256 z = _mm256_mul_ps(x, x);
+    __m256 ps = _mm256_set1_ps(-1.9515295891e-4f);
+    ps = _mm256_add_ps(_mm256_mul_ps(ps, z), _mm256_set1_ps(8.3321608736e-3f));
+    ps = _mm256_add_ps(_mm256_mul_ps(ps, z), _mm256_set1_ps(-1.6666654611e-1f));
+    ps = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(ps, z), x), x);
+    __m256 pc = _mm256_set1_ps(2.443315711809948e-5f);
+    pc = _mm256_add_ps(_mm256_mul_ps(pc, z), _mm256_set1_ps(-1.388731625493765e-3f));
+    pc = _mm256_add_ps(_mm256_mul_ps(pc, z), _mm256_set1_ps(4.166664568298827e-2f));
+    pc = _mm256_mul_ps(_mm256_mul_ps(pc, z), z);
+    pc = _mm256_sub_ps(pc, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+    pc = _mm256_add_ps(pc, _mm256_set1_ps(1.f));
+
+    // octant j in { 0, 2, 4, 6 } picks the polynomial and the signs
+    const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+        _mm256_and_si256(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(2)));
+    const __m256 sign_s = _mm256_castsi256_ps(_mm256_slli_epi32(
+        _mm256_and_si256(j, _mm256_set1_epi32(4)), 29));
+    const __m256 sign_c = _mm256_castsi256_ps(_mm256_slli_epi32(
+        _mm256_and_si256(_mm256_add_epi32(j, _mm256_set1_epi32(2)),
+                         _mm256_set1_epi32(4)), 29));
+    *s = _mm256_xor_ps(_mm256_blendv_ps(ps, pc, swap), sign_s);
+    *c = _mm256_xor_ps(_mm256_blendv_ps(pc, ps, swap), sign_c);
+}
+
+static inline __m256 abs_ps(__m256 x)
+{
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.f), x);
+}
+
+// get_h_prime(): atan2(x, y) mapped to [0, 2 pi)
+static inline __m256 h_prime_ps(__m256 x, __m256 y)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 ax = abs_ps(x);
+    const __m256 ay = abs_ps(y);
+    const __m256 mx = _mm256_max_ps(ax, ay);
+    __m256 t = _mm256_div_ps(_mm256_min_ps(ax, ay), mx);
+
+    // atan(t) for t in [0, 1]
+    const __m256 big =
+        _mm256_cmp_ps(t, _mm256_set1_ps(0.4142135623730950f), _CMP_GT_OQ);
+    t = _mm256_blendv_ps(t, _mm256_div_ps(_mm256_sub_ps(t, _mm256_set1_ps(1.f)),
+                                          _mm256_add_ps(t, _mm256_set1_ps(1.f))),
+                         big);
+    const __m256 z = _mm256_mul_ps(t, t);
+    __m256 r = _mm256_set1_ps(8.05374449538e-2f);
+    r = _mm256_add_ps(_mm256_mul_ps(r, z), _mm256_set1_ps(-1.38776856032e-1f));
+    r = _mm256_add_ps(_mm256_mul_ps(r, z), _mm256_set1_ps(1.99777106478e-1f));
+    r = _mm256_add_ps(_mm256_mul_ps(r, z), _mm256_set1_ps(-3.33329491539e-1f));
+    r = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(r, z), t), t);
+    r = _mm256_add_ps(r, _mm256_and_ps(big, _mm256_set1_ps(M_PI / 4)));
+
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(M_PI / 2), r),
+                         _mm256_cmp_ps(ax, ay, _CMP_GT_OQ));
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(M_PI), r),
+                         _mm256_cmp_ps(y, zero, _CMP_LT_OQ));
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(2 * M_PI), r),
+                         _mm256_cmp_ps(x, zero, _CMP_LT_OQ));
+    return _mm256_andnot_ps(_mm256_cmp_ps(mx, zero, _CMP_EQ_OQ), r);
+}
+
+// sqrt(c^7 / (c^7 + 25^7))
+static inline __m256 c7_ps(__m256 c)
+{
+    const __m256 c2 = _mm256_mul_ps(c, c);
+    const __m256 c7 = _mm256_mul_ps(_mm256_mul_ps(c2, c2), _mm256_mul_ps(c2, c));
+    return _mm256_sqrt_ps(_mm256_div_ps(c7,
+                          _mm256_add_ps(c7, _mm256_set1_ps(6103515625.f))));
+}
+
+// rgb_to_xyz_map()
+static inline __m256 linearize_ps(__m256 c)
+{
+    const __m256 p = exp_ps(_mm256_mul_ps(_mm256_set1_ps(2.4f), log_ps(
+        _mm256_mul_ps(_mm256_add_ps(c, _mm256_set1_ps(0.055f)),
+                      _mm256_set1_ps(1. / 1.055)))));
+    return _mm256_blendv_ps(_mm256_mul_ps(c, _mm256_set1_ps(1. / 12.92)), p,
+                            _mm256_cmp_ps(c, _mm256_set1_ps(10. / 255.),
+                                          _CMP_GT_OQ));
+}
+
+// xyz_to_lab_map()
+static inline __m256 lab_map_ps(__m256 c)
+{
+    const __m256 p = exp_ps(_mm256_mul_ps(log_ps(c), _mm256_set1_ps(1. / 3.)));
+    const __m256 l = _mm256_mul_ps(
+        _mm256_add_ps(_mm256_mul_ps(c, _mm256_set1_ps(24389. / 27.)),
+                      _mm256_set1_ps(16.f)),
+        _mm256_set1_ps(1. / 116.));
+    return _mm256_blendv_ps(l, p, _mm256_cmp_ps(c, _mm256_set1_ps(216. / 24389.),
+                                                _CMP_GT_OQ));
+}
+
+// get_lab_color(), on normalized components
+static inline void lab_ps(__m256 y, __m256 u, __m256 v,
+                          __m256 *l, __m256 *a, __m256 *b)
+{
+    const __m256 r = linearize_ps(
+        _mm256_add_ps(y, _mm256_mul_ps(v, _mm256_set1_ps(1.28033f))));
+    const __m256 g = linearize_ps(_mm256_sub_ps(_mm256_sub_ps(y,
+        _mm256_mul_ps(u, _mm256_set1_ps(0.21482f))),
+        _mm256_mul_ps(v, _mm256_set1_ps(0.38059f))));
+    const __m256 bl = linearize_ps(
+        _mm256_add_ps(y, _mm256_mul_ps(u, _mm256_set1_ps(2.12798f))));
+
+#define DOT(r0, r1, r2) \
+    _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r, _mm256_set1_ps(r0)), \
+                                _mm256_mul_ps(g, _mm256_set1_ps(r1))), \
+                  _mm256_mul_ps(bl, _mm256_set1_ps(r2)))
+    const __m256 fx = lab_map_ps(DOT(0.4124564390896921 / 0.95047,
+                                     0.357576077643909 / 0.95047,
+                                     0.18043748326639894 / 0.95047));
+    const __m256 fy = lab_map_ps(DOT(0.21267285140562248,
+                                     0.715152155287818,
+                                     0.07217499330655958));
+    const __m256 fz = lab_map_ps(DOT(0.019333895582329317 / 1.08883,
+                                     0.119192025881303 / 1.08883,
+                                     0.9503040785363677 / 1.08883));
+#undef DOT
+
+    *l = _mm256_sub_ps(_mm256_mul_ps(fy, _mm256_set1_ps(116.f)),
+                       _mm256_set1_ps(16.f));
+    *a = _mm256_mul_ps(_mm256_sub_ps(fx, fy), _mm256_set1_ps(500.f));
+    *b = _mm256_mul_ps(_mm256_sub_ps(fy, fz), _mm256_set1_ps(200.f));
+}
+
+// ciede2000() with the default ksub of the extractor
+static inline __m256 de00_ps(__m256 l1, __m256 a1, __m256 b1,
+                             __m256 l2, __m256 a2, __m256 b2)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 pi = _mm256_set1_ps(M_PI);
+    const __m256 two_pi = _mm256_set1_ps(2 * M_PI);
+
+    const __m256 c1 = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(a1, a1),
+                                                   _mm256_mul_ps(b1, b1)));
+    const __m256 c2 = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(a2, a2),
+                                                   _mm256_mul_ps(b2, b2)));
+    const __m256 g = _mm256_mul_ps(_mm256_sub_ps(one,
+        c7_ps(_mm256_mul_ps(_mm256_add_ps(c1, c2), half))), half);
+    const __m256 ap1 = _mm256_add_ps(a1, _mm256_mul_ps(a1, g));
+    const __m256 ap2 = _mm256_add_ps(a2, _mm256_mul_ps(a2, g));
+    const __m256 cp1 = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(ap1, ap1),
+                                                    _mm256_mul_ps(b1, b1)));
+    const __m256 cp2 = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(ap2, ap2),
+                                                    _mm256_mul_ps(b2, b2)));
+    const __m256 c_bar_p = _mm256_mul_ps(_mm256_add_ps(cp1, cp2), half);
+
+    const __m256 dl = _mm256_sub_ps(l2, l1);
+    const __m256 l_bar = _mm256_sub_ps(_mm256_mul_ps(_mm256_add_ps(l1, l2), half),
+                                       _mm256_set1_ps(50.f));
+    const __m256 l_bar2 = _mm256_mul_ps(l_bar, l_bar);
+    const __m256 s_l = _mm256_add_ps(one, _mm256_div_ps(
+        _mm256_mul_ps(l_bar2, _mm256_set1_ps(0.015f)),
+        _mm256_sqrt_ps(_mm256_add_ps(l_bar2, _mm256_set1_ps(20.f)))));
+    const __m256 s_c = _mm256_add_ps(one,
+        _mm256_mul_ps(c_bar_p, _mm256_set1_ps(0.045f)));
+
+    const __m256 h1 = h_prime_ps(b1, ap1);
+    const __m256 h2 = h_prime_ps(b2, ap2);
+    const __m256 dh_abs = abs_ps(_mm256_sub_ps(h1, h2));
+    const __m256 wrap = _mm256_cmp_ps(dh_abs, pi, _CMP_GT_OQ);
+
+    // get_delta_h_prime()
+    __m256 dh = _mm256_sub_ps(h2, h1);
+    dh = _mm256_blendv_ps(dh, _mm256_blendv_ps(_mm256_sub_ps(dh, two_pi),
+                                               _mm256_add_ps(dh, two_pi),
+                                               _mm256_cmp_ps(h2, h1, _CMP_LE_OQ)),
+                          wrap);
+    dh = _mm256_andnot_ps(_mm256_or_ps(_mm256_cmp_ps(c1, zero, _CMP_EQ_OQ),
+                                       _mm256_cmp_ps(c2, zero, _CMP_EQ_OQ)), dh);
+    dh = _mm256_mul_ps(dh, half);
+    __m256 sin_dh, cos_dh;
+    sincos_ps(abs_ps(dh), &sin_dh, &cos_dh);
+    sin_dh = _mm256_xor_ps(sin_dh, _mm256_and_ps(dh, _mm256_set1_ps(-0.f)));
+    const __m256 dh_up = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(2.f),
+        _mm256_sqrt_ps(_mm256_mul_ps(cp1, cp2))), sin_dh);
+
+    // get_upcase_h_bar_prime() and get_upcase_t(), by multiple angles
+    const __m256 h_bar = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(h1, h2),
+                                       _mm256_and_ps(wrap, two_pi)), half);
+    __m256 s1, k1;
+    sincos_ps(h_bar, &s1, &k1);
+    const __m256 k2 = _mm256_sub_ps(_mm256_mul_ps(_mm256_add_ps(k1, k1), k1), one);
+    const __m256 s2 = _mm256_mul_ps(_mm256_add_ps(s1, s1), k1);
+    const __m256 k3 = _mm256_sub_ps(_mm256_mul_ps(_mm256_add_ps(k2, k2), k1), k1);
+    const __m256 s3 = _mm256_sub_ps(_mm256_mul_ps(_mm256_add_ps(k1, k1), s2), s1);
+    const __m256 k4 = _mm256_sub_ps(_mm256_mul_ps(_mm256_add_ps(k2, k2), k2), one);
+    const __m256 s4 = _mm256_mul_ps(_mm256_add_ps(s2, s2), k2);
+
+#define COS_SUM(k, s, phi) \
+    _mm256_sub_ps(_mm256_mul_ps(k, _mm256_set1_ps(cos(phi))), \
+                  _mm256_mul_ps(s, _mm256_set1_ps(sin(phi))))
+    __m256 t = _mm256_sub_ps(one, _mm256_mul_ps(_mm256_set1_ps(0.17f),
+                                                COS_SUM(k1, s1, -M_PI / 6.0)));
+    t = _mm256_add_ps(t, _mm256_mul_ps(_mm256_set1_ps(0.24f), k2));
+    t = _mm256_add_ps(t, _mm256_mul_ps(_mm256_set1_ps(0.32f),
+                                       COS_SUM(k3, s3, M_PI / 30.0)));
+    t = _mm256_sub_ps(t, _mm256_mul_ps(_mm256_set1_ps(0.20f),
+                                       COS_SUM(k4, s4, -7.0 * M_PI / 20.0)));
+#undef COS_SUM
+    const __m256 s_h = _mm256_add_ps(one,
+        _mm256_mul_ps(_mm256_mul_ps(c_bar_p, _mm256_set1_ps(0.015f)), t));
+
+    // get_r_sub_t()
+    const __m256 d = _mm256_mul_ps(_mm256_sub_ps(
+        _mm256_mul_ps(h_bar, _mm256_set1_ps(180.0 / M_PI)),
+        _mm256_set1_ps(275.f)), _mm256_set1_ps(1.0 / 25.0));
+    const __m256 angle = _mm256_mul_ps(
+        exp_ps(_mm256_sub_ps(zero, _mm256_mul_ps(d, d))),
+        _mm256_set1_ps(60.0 * M_PI / 180.0));
+    __m256 sin_angle, cos_angle;
+    sincos_ps(angle, &sin_angle, &cos_angle);
+    const __m256 r_t = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(-2.f),
+                                                   c7_ps(c_bar_p)), sin_angle);
+
+    const __m256 lightness = _mm256_div_ps(dl,
+        _mm256_mul_ps(s_l, _mm256_set1_ps(0.65f)));
+    const __m256 chroma = _mm256_div_ps(_mm256_sub_ps(cp2, cp1), s_c);
+    const __m256 hue = _mm256_div_ps(dh_up,
+        _mm256_mul_ps(s_h, _mm256_set1_ps(4.f)));
+
+    __m256 de = _mm256_add_ps(_mm256_mul_ps(lightness, lightness),
+                              _mm256_mul_ps(chroma, chroma));
+    de = _mm256_add_ps(de, _mm256_mul_ps(hue, hue));
+    de = _mm256_add_ps(de, _mm256_mul_ps(_mm256_mul_ps(r_t, chroma), hue));
+    return _mm256_sqrt_ps(_mm256_max_ps(de, zero));
+}
+
+static inline __m256 de00_pixels(const float *ry, const float *ru,
+                                 const float *rv, const float *dy,
+                                 const float *du, const float *dv)
+{
+    __m256 l1, a1, b1, l2, a2, b2;
+    lab_ps(_mm256_loadu_ps(ry), _mm256_loadu_ps(ru), _mm256_loadu_ps(rv),
+           &l1, &a1, &b1);
+    lab_ps(_mm256_loadu_ps(dy), _mm256_loadu_ps(du), _mm256_loadu_ps(dv),
+           &l2, &a2, &b2);
+    return de00_ps(l1, a1, b1, l2, a2, b2);
+}
+
+static inline __m256d sum_pd(__m256d sum, __m256 de)
+{
+    sum = _mm256_add_pd(sum, _mm256_cvtps_pd(_mm256_castps256_ps128(de)));
+    return _mm256_add_pd(sum, _mm256_cvtps_pd(_mm256_extractf128_ps(de, 1)));
+}
+
+void ciede_de00_row_avx2(const float *const ref[3], const float *const dist[3],
+                         unsigned w, unsigned bpc, double *de00_sum)
+{
+    (void) bpc;
+
+    // near neutral colors drive the hue terms into denormals, which are
+    // slow and carry no weight in the result
+    const unsigned csr = _mm_getcsr();
+    _mm_setcsr(csr | _MM_FLUSH_ZERO_ON | _MM_DENORMALS_ZERO_ON);
+
+    __m256d sum = _mm256_setzero_pd();
+    unsigned j = 0;
+    for (; j + 8 <= w; j += 8) {
+        const __m256 de = de00_pixels(ref[0] + j, ref[1] + j, ref[2] + j,
+                                      dist[0] + j, dist[1] + j, dist[2] + j);
+        sum = sum_pd(sum, de);
+    }
+
+    if (j < w) {
+        float tail[6][8] = { { 0 } };
+        for (unsigned k = 0; k < w - j; k++) {
+            for (unsigned p = 0; p < 3; p++) {
+                tail[p][k] = ref[p][j + k];
+                tail[p + 3][k] = dist[p][j + k];
+            }
+        }
+        // zero padding in both pictures yields a zero difference
+        const __m256 de = de00_pixels(tail[0], tail[1], tail[2],
+                                      tail[3], tail[4], tail[5]);
+        sum = sum_pd(sum, de);
+    }
+
+    double s[4];
+    _mm256_storeu_pd(s, sum);
+    *de00_sum += (s[0] + s[1]) + (s[2] + s[3]);
+
+    _mm_setcsr(csr);
+}
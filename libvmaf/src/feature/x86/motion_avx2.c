@@ -19,6 +19,7 @@
 #include <immintrin.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdlib.h>
 
 #include "feature/integer_motion.h"
 #include "feature/common/alignment.h"
@@ -132,3 +133,138 @@ void x_convolution_16_avx2(const uint16_t *src, uint16_t *dst, unsigned width,
         }
     }
 }
+
+// the 5 taps of 16 pixels, as 32 bit products of the unsigned 16 bit pixels
+// and coefficients, rounded and shifted back to 16 bits
+static inline __m256i y_convolution_px16(const __m256i *src, __m256i add,
+                                         __m128i shift)
+{
+    __m256i accum_lo = add;
+    __m256i accum_hi = add;
+
+    for (unsigned k = 0; k < filter_width; ++k) {
+        const __m256i kernel = _mm256_set1_epi16(filter[k]);
+        const __m256i prod_lo = _mm256_mullo_epi16(src[k], kernel);
+        const __m256i prod_hi = _mm256_mulhi_epu16(src[k], kernel);
+        accum_lo = _mm256_add_epi32(accum_lo,
+                                    _mm256_unpacklo_epi16(prod_lo, prod_hi));
+        accum_hi = _mm256_add_epi32(accum_hi,
+                                    _mm256_unpackhi_epi16(prod_lo, prod_hi));
+    }
+
+    accum_lo = _mm256_srl_epi32(accum_lo, shift);
+    accum_hi = _mm256_srl_epi32(accum_hi, shift);
+    return _mm256_packus_epi32(accum_lo, accum_hi);
+}
+
+void y_convolution_8_avx2(void *src, uint16_t *dst, unsigned width,
+                          unsigned height, ptrdiff_t src_stride,
+                          ptrdiff_t dst_stride, unsigned inp_size_bits,
+                          unsigned row_begin, unsigned row_end)
+{
+    (void) inp_size_bits;
+    const unsigned shift_var = 8;
+    const unsigned add_before_shift = 1u << (shift_var - 1);
+    const __m256i add = _mm256_set1_epi32(add_before_shift);
+    const __m128i shift = _mm_cvtsi32_si128(shift_var);
+
+    for (unsigned i = row_begin; i < row_end; i++) {
+        int rows[5];
+        y_tap_rows(i, height, rows);
+        const uint8_t *src_p[5];
+        for (unsigned k = 0; k < filter_width; ++k)
+            src_p[k] = (const uint8_t *) src + rows[k] * src_stride;
+        uint16_t *dst_p = dst + (i - row_begin) * dst_stride;
+
+        unsigned j = 0;
+        for (; j + 16 <= width; j += 16) {
+            __m256i s[5];
+            for (unsigned k = 0; k < filter_width; ++k) {
+                s[k] = _mm256_cvtepu8_epi16(
+                    _mm_loadu_si128((const __m128i *) (src_p[k] + j)));
+            }
+            _mm256_storeu_si256((__m256i *) (dst_p + j),
+                                y_convolution_px16(s, add, shift));
+        }
+
+        for (; j < width; j++) {
+            uint32_t accum = 0;
+            for (unsigned k = 0; k < filter_width; ++k)
+                accum += filter[k] * src_p[k][j];
+            dst_p[j] = (accum + add_before_shift) >> shift_var;
+        }
+    }
+}
+
+void y_convolution_16_avx2(void *src, uint16_t *dst, unsigned width,
+                           unsigned height, ptrdiff_t src_stride,
+                           ptrdiff_t dst_stride, unsigned inp_size_bits,
+                           unsigned row_begin, unsigned row_end)
+{
+    const unsigned shift_var = inp_size_bits;
+    const unsigned add_before_shift = 1u << (shift_var - 1);
+    const __m256i add = _mm256_set1_epi32(add_before_shift);
+    const __m128i shift = _mm_cvtsi32_si128(shift_var);
+
+    for (unsigned i = row_begin; i < row_end; i++) {
+        int rows[5];
+        y_tap_rows(i, height, rows);
+        const uint16_t *src_p[5];
+        for (unsigned k = 0; k < filter_width; ++k)
+            src_p[k] = (const uint16_t *) src + rows[k] * src_stride;
+        uint16_t *dst_p = dst + (i - row_begin) * dst_stride;
+
+        unsigned j = 0;
+        for (; j + 16 <= width; j += 16) {
+            __m256i s[5];
+            for (unsigned k = 0; k < filter_width; ++k)
+                s[k] = _mm256_loadu_si256((const __m256i *) (src_p[k] + j));
+            _mm256_storeu_si256((__m256i *) (dst_p + j),
+                                y_convolution_px16(s, add, shift));
+        }
+
+        for (; j < width; j++) {
+            uint32_t accum = 0;
+            for (unsigned k = 0; k < filter_width; ++k)
+                accum += filter[k] * src_p[k][j];
+            dst_p[j] = (accum + add_before_shift) >> shift_var;
+        }
+    }
+}
+
+uint64_t sad_avx2(const uint16_t *a, ptrdiff_t a_stride,
+                  const uint16_t *b, ptrdiff_t b_stride,
+                  unsigned w, unsigned h)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    uint64_t sad = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        // the row sums wrap around like the uint32_t ones of sad_c()
+        __m256i row_sad = zero;
+        unsigned j = 0;
+        for (; j + 16 <= w; j += 16) {
+            const __m256i va = _mm256_loadu_si256((const __m256i *) (a + j));
+            const __m256i vb = _mm256_loadu_si256((const __m256i *) (b + j));
+            const __m256i d = _mm256_or_si256(_mm256_subs_epu16(va, vb),
+                                              _mm256_subs_epu16(vb, va));
+            row_sad = _mm256_add_epi32(row_sad, _mm256_unpacklo_epi16(d, zero));
+            row_sad = _mm256_add_epi32(row_sad, _mm256_unpackhi_epi16(d, zero));
+        }
+
+        __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(row_sad),
+                                    _mm256_extracti128_si256(row_sad, 1));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+        uint32_t inner_sad = _mm_cvtsi128_si32(sum);
+
+        for (; j < w; j++)
+            inner_sad += abs(a[j] - b[j]);
+
+        sad += inner_sad;
+        a += a_stride;
+        b += b_stride;
+    }
+
+    return sad;
+}
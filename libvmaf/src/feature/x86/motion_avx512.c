@@ -20,6 +20,7 @@
 #include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "feature/integer_motion.h"
@@ -135,3 +136,133 @@ void x_convolution_16_avx512(const uint16_t *src, uint16_t *dst, unsigned width,
         }
     }
 }
+
+// the 5 taps of 32 pixels, as 32 bit products of the unsigned 16 bit pixels
+// and coefficients, rounded and shifted back to 16 bits
+static inline __m512i y_convolution_px32(const __m512i *src, __m512i add,
+                                         __m128i shift)
+{
+    __m512i accum_lo = add;
+    __m512i accum_hi = add;
+
+    for (unsigned k = 0; k < filter_width; ++k) {
+        const __m512i kernel = _mm512_set1_epi16(filter[k]);
+        const __m512i prod_lo = _mm512_mullo_epi16(src[k], kernel);
+        const __m512i prod_hi = _mm512_mulhi_epu16(src[k], kernel);
+        accum_lo = _mm512_add_epi32(accum_lo,
+                                    _mm512_unpacklo_epi16(prod_lo, prod_hi));
+        accum_hi = _mm512_add_epi32(accum_hi,
+                                    _mm512_unpackhi_epi16(prod_lo, prod_hi));
+    }
+
+    accum_lo = _mm512_srl_epi32(accum_lo, shift);
+    accum_hi = _mm512_srl_epi32(accum_hi, shift);
+    return _mm512_packus_epi32(accum_lo, accum_hi);
+}
+
+void y_convolution_8_avx512(void *src, uint16_t *dst, unsigned width,
+                            unsigned height, ptrdiff_t src_stride,
+                            ptrdiff_t dst_stride, unsigned inp_size_bits,
+                            unsigned row_begin, unsigned row_end)
+{
+    (void) inp_size_bits;
+    const unsigned shift_var = 8;
+    const unsigned add_before_shift = 1u << (shift_var - 1);
+    const __m512i add = _mm512_set1_epi32(add_before_shift);
+    const __m128i shift = _mm_cvtsi32_si128(shift_var);
+
+    for (unsigned i = row_begin; i < row_end; i++) {
+        int rows[5];
+        y_tap_rows(i, height, rows);
+        const uint8_t *src_p[5];
+        for (unsigned k = 0; k < filter_width; ++k)
+            src_p[k] = (const uint8_t *) src + rows[k] * src_stride;
+        uint16_t *dst_p = dst + (i - row_begin) * dst_stride;
+
+        unsigned j = 0;
+        for (; j + 32 <= width; j += 32) {
+            __m512i s[5];
+            for (unsigned k = 0; k < filter_width; ++k) {
+                s[k] = _mm512_cvtepu8_epi16(
+                    _mm256_loadu_si256((const __m256i *) (src_p[k] + j)));
+            }
+            _mm512_storeu_si512((__m512i *) (dst_p + j),
+                                y_convolution_px32(s, add, shift));
+        }
+
+        for (; j < width; j++) {
+            uint32_t accum = 0;
+            for (unsigned k = 0; k < filter_width; ++k)
+                accum += filter[k] * src_p[k][j];
+            dst_p[j] = (accum + add_before_shift) >> shift_var;
+        }
+    }
+}
+
+void y_convolution_16_avx512(void *src, uint16_t *dst, unsigned width,
+                             unsigned height, ptrdiff_t src_stride,
+                             ptrdiff_t dst_stride, unsigned inp_size_bits,
+                             unsigned row_begin, unsigned row_end)
+{
+    const unsigned shift_var = inp_size_bits;
+    const unsigned add_before_shift = 1u << (shift_var - 1);
+    const __m512i add = _mm512_set1_epi32(add_before_shift);
+    const __m128i shift = _mm_cvtsi32_si128(shift_var);
+
+    for (unsigned i = row_begin; i < row_end; i++) {
+        int rows[5];
+        y_tap_rows(i, height, rows);
+        const uint16_t *src_p[5];
+        for (unsigned k = 0; k < filter_width; ++k)
+            src_p[k] = (const uint16_t *) src + rows[k] * src_stride;
+        uint16_t *dst_p = dst + (i - row_begin) * dst_stride;
+
+        unsigned j = 0;
+        for (; j + 32 <= width; j += 32) {
+            __m512i s[5];
+            for (unsigned k = 0; k < filter_width; ++k)
+                s[k] = _mm512_loadu_si512((const __m512i *) (src_p[k] + j));
+            _mm512_storeu_si512((__m512i *) (dst_p + j),
+                                y_convolution_px32(s, add, shift));
+        }
+
+        for (; j < width; j++) {
+            uint32_t accum = 0;
+            for (unsigned k = 0; k < filter_width; ++k)
+                accum += filter[k] * src_p[k][j];
+            dst_p[j] = (accum + add_before_shift) >> shift_var;
+        }
+    }
+}
+
+uint64_t sad_avx512(const uint16_t *a, ptrdiff_t a_stride,
+                    const uint16_t *b, ptrdiff_t b_stride,
+                    unsigned w, unsigned h)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    uint64_t sad = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        // the row sums wrap around like the uint32_t ones of sad_c()
+        __m512i row_sad = zero;
+        unsigned j = 0;
+        for (; j + 32 <= w; j += 32) {
+            const __m512i va = _mm512_loadu_si512((const __m512i *) (a + j));
+            const __m512i vb = _mm512_loadu_si512((const __m512i *) (b + j));
+            const __m512i d = _mm512_or_si512(_mm512_subs_epu16(va, vb),
+                                              _mm512_subs_epu16(vb, va));
+            row_sad = _mm512_add_epi32(row_sad, _mm512_unpacklo_epi16(d, zero));
+            row_sad = _mm512_add_epi32(row_sad, _mm512_unpackhi_epi16(d, zero));
+        }
+        uint32_t inner_sad = _mm512_reduce_add_epi32(row_sad);
+
+        for (; j < w; j++)
+            inner_sad += abs(a[j] - b[j]);
+
+        sad += inner_sad;
+        a += a_stride;
+        b += b_stride;
+    }
+
+    return sad;
+}
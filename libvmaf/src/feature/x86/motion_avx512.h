@@ -19,10 +19,25 @@
 #ifndef X86_AVX512_MOTION_H_
 #define X86_AVX512_MOTION_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 void x_convolution_16_avx512(const uint16_t *src, uint16_t *dst, unsigned width,
                              unsigned height, ptrdiff_t src_stride,
                              ptrdiff_t dst_stride);
 
+void y_convolution_8_avx512(void *src, uint16_t *dst, unsigned width,
+                            unsigned height, ptrdiff_t src_stride,
+                            ptrdiff_t dst_stride, unsigned inp_size_bits,
+                            unsigned row_begin, unsigned row_end);
+
+void y_convolution_16_avx512(void *src, uint16_t *dst, unsigned width,
+                             unsigned height, ptrdiff_t src_stride,
+                             ptrdiff_t dst_stride, unsigned inp_size_bits,
+                             unsigned row_begin, unsigned row_end);
+
+uint64_t sad_avx512(const uint16_t *a, ptrdiff_t a_stride,
+                    const uint16_t *b, ptrdiff_t b_stride,
+                    unsigned w, unsigned h);
+
 #endif /* X86_AVX512_MOTION_H_ */
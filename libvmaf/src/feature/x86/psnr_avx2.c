@@ -0,0 +1,139 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "psnr_avx2.h"
+
+static inline __m256i widen_epu32(__m256i v)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    return _mm256_add_epi64(_mm256_unpacklo_epi32(v, zero),
+                            _mm256_unpackhi_epi32(v, zero));
+}
+
+static inline uint64_t hsum_epi64(__m256i v)
+{
+    const __m128i s = _mm_add_epi64(_mm256_castsi256_si128(v),
+                                    _mm256_extracti128_si256(v, 1));
+    return (uint64_t)_mm_cvtsi128_si64(s) + (uint64_t)_mm_extract_epi64(s, 1);
+}
+
+uint64_t psnr_sse_8_avx2(const uint8_t *ref, ptrdiff_t ref_stride,
+                         const uint8_t *dis, ptrdiff_t dis_stride,
+                         unsigned w, unsigned h)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i sse = zero;
+    uint64_t sse_tail = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        // a 32 bit lane gains at most 4 * 255^2 per 32 pixels,
+        // so it holds rows of up to 500k pixels
+        __m256i sse_row = zero;
+        unsigned j = 0;
+        for (; j + 32 <= w; j += 32) {
+            const __m256i r = _mm256_loadu_si256((const __m256i *)(ref + j));
+            const __m256i d = _mm256_loadu_si256((const __m256i *)(dis + j));
+            const __m256i e = _mm256_or_si256(_mm256_subs_epu8(r, d),
+                                              _mm256_subs_epu8(d, r));
+            const __m256i e_lo = _mm256_unpacklo_epi8(e, zero);
+            const __m256i e_hi = _mm256_unpackhi_epi8(e, zero);
+            sse_row = _mm256_add_epi32(sse_row, _mm256_madd_epi16(e_lo, e_lo));
+            sse_row = _mm256_add_epi32(sse_row, _mm256_madd_epi16(e_hi, e_hi));
+        }
+        sse = _mm256_add_epi64(sse, widen_epu32(sse_row));
+
+        uint32_t sse_inner = 0;
+        for (; j < w; j++) {
+            const int16_t e = ref[j] - dis[j];
+            sse_inner += e * e;
+        }
+        sse_tail += sse_inner;
+
+        ref += ref_stride;
+        dis += dis_stride;
+    }
+
+    return hsum_epi64(sse) + sse_tail;
+}
+
+uint64_t psnr_sse_16_avx2(const uint16_t *ref, ptrdiff_t ref_stride,
+                          const uint16_t *dis, ptrdiff_t dis_stride,
+                          unsigned w, unsigned h, unsigned bpc)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i sse = zero;
+    uint64_t sse_tail = 0;
+
+    // below 16 bits, the signed 16 bit differences are squared and summed
+    // in pairs with madd, into 32 bit lanes flushed to 64 bits every
+    // blk_cnt vectors, before they can overflow
+    const uint32_t e_max = (1u << bpc) - 1;
+    const unsigned blk_cnt =
+        bpc < 16 ? UINT32_MAX / (2 * e_max * e_max) : 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        unsigned j = 0;
+        if (blk_cnt) {
+            __m256i sse_blk = zero;
+            unsigned cnt = 0;
+            for (; j + 16 <= w; j += 16) {
+                const __m256i r = _mm256_loadu_si256((const __m256i *)(ref + j));
+                const __m256i d = _mm256_loadu_si256((const __m256i *)(dis + j));
+                const __m256i e = _mm256_sub_epi16(r, d);
+                sse_blk = _mm256_add_epi32(sse_blk, _mm256_madd_epi16(e, e));
+                if (++cnt == blk_cnt) {
+                    sse = _mm256_add_epi64(sse, widen_epu32(sse_blk));
+                    sse_blk = zero;
+                    cnt = 0;
+                }
+            }
+            sse = _mm256_add_epi64(sse, widen_epu32(sse_blk));
+        } else {
+            // 16 bit: unsigned differences, squared to 64 bits
+            for (; j + 16 <= w; j += 16) {
+                const __m256i r = _mm256_loadu_si256((const __m256i *)(ref + j));
+                const __m256i d = _mm256_loadu_si256((const __m256i *)(dis + j));
+                const __m256i e = _mm256_or_si256(_mm256_subs_epu16(r, d),
+                                                  _mm256_subs_epu16(d, r));
+                const __m256i e_lo = _mm256_unpacklo_epi16(e, zero);
+                const __m256i e_hi = _mm256_unpackhi_epi16(e, zero);
+                const __m256i e_lo_odd = _mm256_srli_epi64(e_lo, 32);
+                const __m256i e_hi_odd = _mm256_srli_epi64(e_hi, 32);
+                sse = _mm256_add_epi64(sse, _mm256_mul_epu32(e_lo, e_lo));
+                sse = _mm256_add_epi64(sse, _mm256_mul_epu32(e_lo_odd, e_lo_odd));
+                sse = _mm256_add_epi64(sse, _mm256_mul_epu32(e_hi, e_hi));
+                sse = _mm256_add_epi64(sse, _mm256_mul_epu32(e_hi_odd, e_hi_odd));
+            }
+        }
+
+        for (; j < w; j++) {
+            const uint32_t e = ref[j] > dis[j] ? ref[j] - dis[j] : dis[j] - ref[j];
+            sse_tail += e * e;
+        }
+
+        ref += ref_stride / 2;
+        dis += dis_stride / 2;
+    }
+
+    return hsum_epi64(sse) + sse_tail;
+}
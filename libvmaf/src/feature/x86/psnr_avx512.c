@@ -0,0 +1,137 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "psnr_avx512.h"
+
+static inline __m512i widen_epu32(__m512i v)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    return _mm512_add_epi64(_mm512_unpacklo_epi32(v, zero),
+                            _mm512_unpackhi_epi32(v, zero));
+}
+
+static inline uint64_t hsum_epi64(__m512i v)
+{
+    return (uint64_t)_mm512_reduce_add_epi64(v);
+}
+
+uint64_t psnr_sse_8_avx512(const uint8_t *ref, ptrdiff_t ref_stride,
+                           const uint8_t *dis, ptrdiff_t dis_stride,
+                           unsigned w, unsigned h)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i sse = zero;
+    uint64_t sse_tail = 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        // a 32 bit lane gains at most 4 * 255^2 per 64 pixels,
+        // so it holds rows of up to 1M pixels
+        __m512i sse_row = zero;
+        unsigned j = 0;
+        for (; j + 64 <= w; j += 64) {
+            const __m512i r = _mm512_loadu_si512((const void *)(ref + j));
+            const __m512i d = _mm512_loadu_si512((const void *)(dis + j));
+            const __m512i e = _mm512_or_si512(_mm512_subs_epu8(r, d),
+                                              _mm512_subs_epu8(d, r));
+            const __m512i e_lo = _mm512_unpacklo_epi8(e, zero);
+            const __m512i e_hi = _mm512_unpackhi_epi8(e, zero);
+            sse_row = _mm512_add_epi32(sse_row, _mm512_madd_epi16(e_lo, e_lo));
+            sse_row = _mm512_add_epi32(sse_row, _mm512_madd_epi16(e_hi, e_hi));
+        }
+        sse = _mm512_add_epi64(sse, widen_epu32(sse_row));
+
+        uint32_t sse_inner = 0;
+        for (; j < w; j++) {
+            const int16_t e = ref[j] - dis[j];
+            sse_inner += e * e;
+        }
+        sse_tail += sse_inner;
+
+        ref += ref_stride;
+        dis += dis_stride;
+    }
+
+    return hsum_epi64(sse) + sse_tail;
+}
+
+uint64_t psnr_sse_16_avx512(const uint16_t *ref, ptrdiff_t ref_stride,
+                            const uint16_t *dis, ptrdiff_t dis_stride,
+                            unsigned w, unsigned h, unsigned bpc)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i sse = zero;
+    uint64_t sse_tail = 0;
+
+    // below 16 bits, the signed 16 bit differences are squared and summed
+    // in pairs with madd, into 32 bit lanes flushed to 64 bits every
+    // blk_cnt vectors, before they can overflow
+    const uint32_t e_max = (1u << bpc) - 1;
+    const unsigned blk_cnt =
+        bpc < 16 ? UINT32_MAX / (2 * e_max * e_max) : 0;
+
+    for (unsigned i = 0; i < h; i++) {
+        unsigned j = 0;
+        if (blk_cnt) {
+            __m512i sse_blk = zero;
+            unsigned cnt = 0;
+            for (; j + 32 <= w; j += 32) {
+                const __m512i r = _mm512_loadu_si512((const void *)(ref + j));
+                const __m512i d = _mm512_loadu_si512((const void *)(dis + j));
+                const __m512i e = _mm512_sub_epi16(r, d);
+                sse_blk = _mm512_add_epi32(sse_blk, _mm512_madd_epi16(e, e));
+                if (++cnt == blk_cnt) {
+                    sse = _mm512_add_epi64(sse, widen_epu32(sse_blk));
+                    sse_blk = zero;
+                    cnt = 0;
+                }
+            }
+            sse = _mm512_add_epi64(sse, widen_epu32(sse_blk));
+        } else {
+            // 16 bit: unsigned differences, squared to 64 bits
+            for (; j + 32 <= w; j += 32) {
+                const __m512i r = _mm512_loadu_si512((const void *)(ref + j));
+                const __m512i d = _mm512_loadu_si512((const void *)(dis + j));
+                const __m512i e = _mm512_or_si512(_mm512_subs_epu16(r, d),
+                                                  _mm512_subs_epu16(d, r));
+                const __m512i e_lo = _mm512_unpacklo_epi16(e, zero);
+                const __m512i e_hi = _mm512_unpackhi_epi16(e, zero);
+                const __m512i e_lo_odd = _mm512_srli_epi64(e_lo, 32);
+                const __m512i e_hi_odd = _mm512_srli_epi64(e_hi, 32);
+                sse = _mm512_add_epi64(sse, _mm512_mul_epu32(e_lo, e_lo));
+                sse = _mm512_add_epi64(sse, _mm512_mul_epu32(e_lo_odd, e_lo_odd));
+                sse = _mm512_add_epi64(sse, _mm512_mul_epu32(e_hi, e_hi));
+                sse = _mm512_add_epi64(sse, _mm512_mul_epu32(e_hi_odd, e_hi_odd));
+            }
+        }
+
+        for (; j < w; j++) {
+            const uint32_t e = ref[j] > dis[j] ? ref[j] - dis[j] : dis[j] - ref[j];
+            sse_tail += e * e;
+        }
+
+        ref += ref_stride / 2;
+        dis += dis_stride / 2;
+    }
+
+    return hsum_epi64(sse) + sse_tail;
+}
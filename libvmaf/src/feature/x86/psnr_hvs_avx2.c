@@ -0,0 +1,228 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+
+#include <immintrin.h>
+
+#include "psnr_hvs_avx2.h"
+
+/*
+ * Lane k of every vector below belongs to the 8x8 block k * step pixels to
+ * the right of src/dst. Each step repeats the scalar calc_block() per lane,
+ * with the same operations in the same order, so the results are bit-exact.
+ */
+
+#define OD_DCT_RSHIFT(a, b) \
+    _mm256_srai_epi32(_mm256_add_epi32(_mm256_srli_epi32(a, 32 - (b)), a), b)
+
+#define OD_DCT_MUL(a, m, r, s) \
+    _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(a, \
+                      _mm256_set1_epi32(m)), _mm256_set1_epi32(r)), s)
+
+static inline void od_bin_fdct8(__m256i y[8], const __m256i *x, int xstride)
+{
+    __m256i t0 = x[0 * xstride];
+    __m256i t4 = x[1 * xstride];
+    __m256i t2 = x[2 * xstride];
+    __m256i t6 = x[3 * xstride];
+    __m256i t7 = x[4 * xstride];
+    __m256i t3 = x[5 * xstride];
+    __m256i t5 = x[6 * xstride];
+    __m256i t1 = x[7 * xstride];
+    __m256i t1h, t4h, t6h;
+
+    t1 = _mm256_sub_epi32(t0, t1);
+    t1h = OD_DCT_RSHIFT(t1, 1);
+    t0 = _mm256_sub_epi32(t0, t1h);
+    t4 = _mm256_add_epi32(t4, t5);
+    t4h = OD_DCT_RSHIFT(t4, 1);
+    t5 = _mm256_sub_epi32(t5, t4h);
+    t3 = _mm256_sub_epi32(t2, t3);
+    t2 = _mm256_sub_epi32(t2, OD_DCT_RSHIFT(t3, 1));
+    t6 = _mm256_add_epi32(t6, t7);
+    t6h = OD_DCT_RSHIFT(t6, 1);
+    t7 = _mm256_sub_epi32(t6h, t7);
+    t0 = _mm256_add_epi32(t0, t6h);
+    t6 = _mm256_sub_epi32(t0, t6);
+    t2 = _mm256_sub_epi32(t4h, t2);
+    t4 = _mm256_sub_epi32(t2, t4);
+    t0 = _mm256_sub_epi32(t0, OD_DCT_MUL(t4, 13573, 16384, 15));
+    t4 = _mm256_add_epi32(t4, OD_DCT_MUL(t0, 11585, 8192, 14));
+    t0 = _mm256_sub_epi32(t0, OD_DCT_MUL(t4, 13573, 16384, 15));
+    t6 = _mm256_sub_epi32(t6, OD_DCT_MUL(t2, 21895, 16384, 15));
+    t2 = _mm256_add_epi32(t2, OD_DCT_MUL(t6, 15137, 8192, 14));
+    t6 = _mm256_sub_epi32(t6, OD_DCT_MUL(t2, 21895, 16384, 15));
+    t3 = _mm256_add_epi32(t3, OD_DCT_MUL(t5, 19195, 16384, 15));
+    t5 = _mm256_add_epi32(t5, OD_DCT_MUL(t3, 11585, 8192, 14));
+    t3 = _mm256_sub_epi32(t3, OD_DCT_MUL(t5, 7489, 4096, 13));
+    t7 = _mm256_sub_epi32(OD_DCT_RSHIFT(t5, 1), t7);
+    t5 = _mm256_sub_epi32(t5, t7);
+    t3 = _mm256_sub_epi32(t1h, t3);
+    t1 = _mm256_sub_epi32(t1, t3);
+    t7 = _mm256_add_epi32(t7, OD_DCT_MUL(t1, 3227, 16384, 15));
+    t1 = _mm256_sub_epi32(t1, OD_DCT_MUL(t7, 6393, 16384, 15));
+    t7 = _mm256_add_epi32(t7, OD_DCT_MUL(t1, 3227, 16384, 15));
+    t5 = _mm256_add_epi32(t5, OD_DCT_MUL(t3, 2485, 4096, 13));
+    t3 = _mm256_sub_epi32(t3, OD_DCT_MUL(t5, 18205, 16384, 15));
+    t5 = _mm256_add_epi32(t5, OD_DCT_MUL(t3, 2485, 4096, 13));
+    y[0] = t0;
+    y[1] = t1;
+    y[2] = t2;
+    y[3] = t3;
+    y[4] = t4;
+    y[5] = t5;
+    y[6] = t6;
+    y[7] = t7;
+}
+
+static inline void od_bin_fdct8x8(__m256i x[64])
+{
+    __m256i z[64];
+    for (int i = 0; i < 8; i++)
+        od_bin_fdct8(z + 8 * i, x + i, 8);
+    for (int i = 0; i < 8; i++)
+        od_bin_fdct8(x + 8 * i, z + i, 8);
+}
+
+static inline void load_blocks(__m256i x[64], const unsigned char *p,
+                               int stride, int depth, int step)
+{
+    const int lane_stride = depth > 8 ? 2 * step : step;
+    for (int i = 0; i < 8; i++) {
+        __m128i r[8], a[8], b[8];
+        for (int k = 0; k < 8; k++) {
+            const unsigned char *q = p + i * stride + k * lane_stride;
+            r[k] = depth > 8 ? _mm_loadu_si128((const __m128i *)q) :
+                   _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)q));
+        }
+        for (int k = 0; k < 4; k++) {
+            a[2 * k] = _mm_unpacklo_epi16(r[2 * k], r[2 * k + 1]);
+            a[2 * k + 1] = _mm_unpackhi_epi16(r[2 * k], r[2 * k + 1]);
+        }
+        for (int k = 0; k < 2; k++) {
+            b[4 * k + 0] = _mm_unpacklo_epi32(a[4 * k + 0], a[4 * k + 2]);
+            b[4 * k + 1] = _mm_unpackhi_epi32(a[4 * k + 0], a[4 * k + 2]);
+            b[4 * k + 2] = _mm_unpacklo_epi32(a[4 * k + 1], a[4 * k + 3]);
+            b[4 * k + 3] = _mm_unpackhi_epi32(a[4 * k + 1], a[4 * k + 3]);
+        }
+        for (int j = 0; j < 4; j++) {
+            x[i * 8 + 2 * j] =
+                _mm256_cvtepu16_epi32(_mm_unpacklo_epi64(b[j], b[j + 4]));
+            x[i * 8 + 2 * j + 1] =
+                _mm256_cvtepu16_epi32(_mm_unpackhi_epi64(b[j], b[j + 4]));
+        }
+    }
+}
+
+/*
+ * Transforms x in place and returns the contrast masking threshold,
+ * sqrt(sum(x^2 * mask) * var(x) / sum(var(quadrants))) / 32, of each lane.
+ */
+static inline __m256 block_mask(__m256i x[64], float mask[8][8])
+{
+    __m256i gsum = _mm256_setzero_si256();
+    __m256i sum[4];
+    __m256 gmean, means[4];
+    __m256 gvar = _mm256_setzero_ps();
+    __m256 vars[4];
+    __m256 m = _mm256_setzero_ps();
+
+    for (int n = 0; n < 4; n++) {
+        sum[n] = _mm256_setzero_si256();
+        vars[n] = _mm256_setzero_ps();
+    }
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 8; j++) {
+            const int sub = ((i & 12) >> 2) + ((j & 12) >> 1);
+            gsum = _mm256_add_epi32(gsum, x[i * 8 + j]);
+            sum[sub] = _mm256_add_epi32(sum[sub], x[i * 8 + j]);
+        }
+    }
+    // the sums are exact in float, as are the scalar running sums
+    gmean = _mm256_div_ps(_mm256_cvtepi32_ps(gsum), _mm256_set1_ps(64.f));
+    for (int n = 0; n < 4; n++)
+        means[n] = _mm256_div_ps(_mm256_cvtepi32_ps(sum[n]),
+                                 _mm256_set1_ps(16.f));
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 8; j++) {
+            const int sub = ((i & 12) >> 2) + ((j & 12) >> 1);
+            const __m256 v = _mm256_cvtepi32_ps(x[i * 8 + j]);
+            const __m256 dg = _mm256_sub_ps(v, gmean);
+            const __m256 ds = _mm256_sub_ps(v, means[sub]);
+            gvar = _mm256_add_ps(gvar, _mm256_mul_ps(dg, dg));
+            vars[sub] = _mm256_add_ps(vars[sub], _mm256_mul_ps(ds, ds));
+        }
+    }
+    gvar = _mm256_mul_ps(gvar, _mm256_set1_ps(1 / 63.f * 64));
+    for (int n = 0; n < 4; n++)
+        vars[n] = _mm256_mul_ps(vars[n], _mm256_set1_ps(1 / 15.f * 16));
+    const __m256 vsum = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(vars[0],
+                                      vars[1]), vars[2]), vars[3]);
+    gvar = _mm256_blendv_ps(gvar, _mm256_div_ps(vsum, gvar),
+                            _mm256_cmp_ps(gvar, _mm256_setzero_ps(),
+                                          _CMP_GT_OQ));
+
+    od_bin_fdct8x8(x);
+    for (int i = 0; i < 8; i++) {
+        for (int j = (i == 0); j < 8; j++) {
+            const __m256 sq =
+                _mm256_cvtepi32_ps(_mm256_mullo_epi32(x[i * 8 + j],
+                                                      x[i * 8 + j]));
+            m = _mm256_add_ps(m, _mm256_mul_ps(sq,
+                                               _mm256_set1_ps(mask[i][j])));
+        }
+    }
+    // a double sqrt rounded to float equals sqrtf, and / 32 is exact
+    return _mm256_mul_ps(_mm256_sqrt_ps(_mm256_mul_ps(m, gvar)),
+                         _mm256_set1_ps(1 / 32.f));
+}
+
+void psnr_hvs_calc_blocks_avx2(const unsigned char *src, int src_stride,
+                               const unsigned char *dst, int dst_stride,
+                               int depth, int step, float mask[8][8],
+                               float csf[8][8], float *ret)
+{
+    __m256i s[64], d[64];
+    float terms[64][8];
+
+    load_blocks(s, src, src_stride, depth, step);
+    load_blocks(d, dst, dst_stride, depth, step);
+    const __m256 s_mask = block_mask(s, mask);
+    const __m256 d_mask = block_mask(d, mask);
+    const __m256 m = _mm256_max_ps(d_mask, s_mask);
+
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 8; j++) {
+            __m256 err = _mm256_cvtepi32_ps(
+                _mm256_abs_epi32(_mm256_sub_epi32(s[i * 8 + j], d[i * 8 + j])));
+            if (i != 0 || j != 0) {
+                const __m256 t = _mm256_div_ps(m, _mm256_set1_ps(mask[i][j]));
+                err = _mm256_andnot_ps(_mm256_cmp_ps(err, t, _CMP_LT_OQ),
+                                       _mm256_sub_ps(err, t));
+            }
+            err = _mm256_mul_ps(err, _mm256_set1_ps(csf[i][j]));
+            _mm256_storeu_ps(terms[i * 8 + j], _mm256_mul_ps(err, err));
+        }
+    }
+
+    float r = *ret;
+    for (int k = 0; k < 8; k++)
+        for (int n = 0; n < 64; n++)
+            r += terms[n][k];
+    *ret = r;
+}
@@ -0,0 +1,28 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+
+#ifndef X86_AVX2_PSNR_HVS_H_
+#define X86_AVX2_PSNR_HVS_H_
+
+void psnr_hvs_calc_blocks_avx2(const unsigned char *src, int src_stride,
+                               const unsigned char *dst, int dst_stride,
+                               int depth, int step, float mask[8][8],
+                               float csf[8][8], float *ret);
+
+#endif /* X86_AVX2_PSNR_HVS_H_ */
@@ -0,0 +1,190 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+
+#include <immintrin.h>
+
+#include "feature/iqa/ssim_tools.h"
+#include "ssim_avx512.h"
+
+/* Products are rounded to float and summed as double, like the C kernels */
+static inline void acc_pd(__m512d *lo, __m512d *hi, __m512 p)
+{
+    *lo = _mm512_add_pd(*lo, _mm512_cvtps_pd(_mm512_castps512_ps256(p)));
+    *hi = _mm512_add_pd(*hi, _mm512_cvtps_pd(_mm512_extractf32x8_ps(p, 1)));
+}
+
+static inline __m512 cvt_ps(__m512d lo, __m512d hi)
+{
+    return _mm512_insertf32x8(_mm512_castps256_ps512(_mm512_cvtpd_ps(lo)),
+                              _mm512_cvtpd_ps(hi), 1);
+}
+
+void ssim_filter_h_avx512(const float *ref, const float *cmp, int w,
+                          const float *k, int k_len,
+                          float *const dst[SSIM_MAP_CNT])
+{
+    int x = 0;
+    for (; x + 16 <= w; x += 16) {
+        __m512d lo[SSIM_MAP_CNT], hi[SSIM_MAP_CNT];
+        for (int m = 0; m < SSIM_MAP_CNT; m++)
+            lo[m] = hi[m] = _mm512_setzero_pd();
+
+        for (int u = 0; u < k_len; u++) {
+            const __m512 kv = _mm512_set1_ps(k[u]);
+            const __m512 r = _mm512_loadu_ps(ref + x + u);
+            const __m512 c = _mm512_loadu_ps(cmp + x + u);
+            acc_pd(&lo[0], &hi[0], _mm512_mul_ps(r, kv));
+            acc_pd(&lo[1], &hi[1], _mm512_mul_ps(c, kv));
+            acc_pd(&lo[2], &hi[2], _mm512_mul_ps(_mm512_mul_ps(r, r), kv));
+            acc_pd(&lo[3], &hi[3], _mm512_mul_ps(_mm512_mul_ps(c, c), kv));
+            acc_pd(&lo[4], &hi[4], _mm512_mul_ps(_mm512_mul_ps(r, c), kv));
+        }
+
+        for (int m = 0; m < SSIM_MAP_CNT; m++)
+            _mm512_storeu_ps(dst[m] + x, cvt_ps(lo[m], hi[m]));
+    }
+
+    if (x < w) {
+        float *const tail[SSIM_MAP_CNT] = {
+            dst[0] + x, dst[1] + x, dst[2] + x, dst[3] + x, dst[4] + x,
+        };
+        _ssim_filter_h_c(ref + x, cmp + x, w - x, k, k_len, tail);
+    }
+}
+
+/* SSIM, luminance, contrast and structure of 8 pixels, in double */
+static inline void lcs_pd(__m256 ref_mu, __m256 cmp_mu,
+                          __m256 sigma_ref_sigma_cmp, __m256 l_den,
+                          __m256 c_den, __m256 s, const float C[3],
+                          double lcs[4][16], int i)
+{
+    const __m512d two = _mm512_set1_pd(2.0);
+    const __m512d l_num =
+        _mm512_add_pd(_mm512_mul_pd(_mm512_mul_pd(two, _mm512_cvtps_pd(ref_mu)),
+                                    _mm512_cvtps_pd(cmp_mu)),
+                      _mm512_set1_pd(C[0]));
+    const __m512d c_num =
+        _mm512_add_pd(_mm512_mul_pd(two, _mm512_cvtps_pd(sigma_ref_sigma_cmp)),
+                      _mm512_set1_pd(C[1]));
+    const __m512d l = _mm512_div_pd(l_num, _mm512_cvtps_pd(l_den));
+    const __m512d c = _mm512_div_pd(c_num, _mm512_cvtps_pd(c_den));
+    const __m512d sd = _mm512_cvtps_pd(s);
+    _mm512_storeu_pd(&lcs[0][i], _mm512_mul_pd(_mm512_mul_pd(l, c), sd));
+    _mm512_storeu_pd(&lcs[1][i], l);
+    _mm512_storeu_pd(&lcs[2][i], c);
+    _mm512_storeu_pd(&lcs[3][i], sd);
+}
+
+void ssim_filter_v_avx512(const float *const *src, int w,
+                          const float *k, int k_len,
+                          const float C[3], double sum[4])
+{
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 c1 = _mm512_set1_ps(C[0]);
+    const __m512 c2 = _mm512_set1_ps(C[1]);
+    const __m512 c3 = _mm512_set1_ps(C[2]);
+
+    for (int x = 0; x < w; x += 16) {
+        __m512 f[SSIM_MAP_CNT];
+        for (int m = 0; m < SSIM_MAP_CNT; m++) {
+            __m512d lo = _mm512_setzero_pd(), hi = _mm512_setzero_pd();
+            for (int v = 0; v < k_len; v++) {
+                const __m512 p = _mm512_mul_ps(_mm512_loadu_ps(src[m * k_len + v] + x),
+                                               _mm512_set1_ps(k[v]));
+                acc_pd(&lo, &hi, p);
+            }
+            f[m] = cvt_ps(lo, hi);
+        }
+
+        const __m512 ref_mu = f[0];
+        const __m512 cmp_mu = f[1];
+        const __m512 ref_mu_sqd = _mm512_mul_ps(ref_mu, ref_mu);
+        const __m512 cmp_mu_sqd = _mm512_mul_ps(cmp_mu, cmp_mu);
+        const __m512 ref_sigma_sqd =
+            _mm512_max_ps(zero, _mm512_sub_ps(f[2], ref_mu_sqd));
+        const __m512 cmp_sigma_sqd =
+            _mm512_max_ps(zero, _mm512_sub_ps(f[3], cmp_mu_sqd));
+        const __m512 sigma_both =
+            _mm512_sub_ps(f[4], _mm512_mul_ps(ref_mu, cmp_mu));
+        const __m512 sigma_ref_sigma_cmp =
+            _mm512_sqrt_ps(_mm512_mul_ps(ref_sigma_sqd, cmp_sigma_sqd));
+
+        const __m512 l_den =
+            _mm512_add_ps(_mm512_add_ps(ref_mu_sqd, cmp_mu_sqd), c1);
+        const __m512 c_den =
+            _mm512_add_ps(_mm512_add_ps(ref_sigma_sqd, cmp_sigma_sqd), c2);
+        const __mmask16 clamp =
+            _mm512_cmp_ps_mask(sigma_both, zero, _CMP_LT_OQ) &
+            _mm512_cmp_ps_mask(sigma_ref_sigma_cmp, zero, _CMP_LE_OQ);
+        const __m512 s =
+            _mm512_div_ps(_mm512_add_ps(_mm512_maskz_mov_ps(~clamp, sigma_both), c3),
+                          _mm512_add_ps(sigma_ref_sigma_cmp, c3));
+
+        double lcs[4][16];
+        lcs_pd(_mm512_castps512_ps256(ref_mu), _mm512_castps512_ps256(cmp_mu),
+               _mm512_castps512_ps256(sigma_ref_sigma_cmp),
+               _mm512_castps512_ps256(l_den), _mm512_castps512_ps256(c_den),
+               _mm512_castps512_ps256(s), C, lcs, 0);
+        lcs_pd(_mm512_extractf32x8_ps(ref_mu, 1), _mm512_extractf32x8_ps(cmp_mu, 1),
+               _mm512_extractf32x8_ps(sigma_ref_sigma_cmp, 1),
+               _mm512_extractf32x8_ps(l_den, 1), _mm512_extractf32x8_ps(c_den, 1),
+               _mm512_extractf32x8_ps(s, 1), C, lcs, 8);
+
+        /* summed in pixel order, as in the C kernel */
+        const int n = w - x < 16 ? w - x : 16;
+        for (int i = 0; i < n; i++) {
+            sum[0] += lcs[0][i];
+            sum[1] += lcs[1][i];
+            sum[2] += lcs[2][i];
+            sum[3] += lcs[3][i];
+        }
+    }
+}
+
+void ssim_decimate_row_avx512(const float *img, int w,
+                              const struct _kernel *k, int y,
+                              int x0, int x1, float *dst)
+{
+    const int uc = k->w / 2;
+    const int vc = k->h / 2;
+    const int u_end = uc - !(k->w & 1);
+    const int v_end = vc - !(k->h & 1);
+    const __m512i even_idx = _mm512_set_epi32(30, 28, 26, 24, 22, 20, 18, 16,
+                                              14, 12, 10, 8, 6, 4, 2, 0);
+
+    int x = x0;
+    /* the even columns of 32 floats per tap, all within the row */
+    for (; x + 16 <= x1 && 2 * x + 31 + u_end < w; x += 16) {
+        __m512d lo = _mm512_setzero_pd(), hi = _mm512_setzero_pd();
+        const float *kernel = k->kernel;
+        for (int v = -vc; v <= v_end; v++) {
+            const float *row = img + (2 * y + v) * w + 2 * x;
+            for (int u = -uc; u <= u_end; u++) {
+                const __m512 even =
+                    _mm512_permutex2var_ps(_mm512_loadu_ps(row + u), even_idx,
+                                           _mm512_loadu_ps(row + u + 16));
+                acc_pd(&lo, &hi, _mm512_mul_ps(even, _mm512_set1_ps(*kernel++)));
+            }
+        }
+        _mm512_storeu_ps(dst + x, cvt_ps(lo, hi));
+    }
+
+    if (x < x1)
+        _ssim_decimate_row_c(img, w, k, y, x, x1, dst);
+}
@@ -0,0 +1,37 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+
+#ifndef X86_AVX512_SSIM_H_
+#define X86_AVX512_SSIM_H_
+
+#include "feature/iqa/ssim_tools.h"
+
+void ssim_filter_h_avx512(const float *ref, const float *cmp, int w,
+                          const float *k, int k_len,
+                          float *const dst[SSIM_MAP_CNT]);
+
+void ssim_filter_v_avx512(const float *const *src, int w,
+                          const float *k, int k_len,
+                          const float C[3], double sum[4]);
+
+void ssim_decimate_row_avx512(const float *img, int w,
+                              const struct _kernel *k, int y,
+                              int x0, int x1, float *dst);
+
+#endif /* X86_AVX512_SSIM_H_ */
@@ -118,7 +118,7 @@ acc_right = _mm256_madd_epi16(_mm256_unpackhi_epi16(r0, zero), f); \
 }
 
 
-void vif_statistic_8_avx2(struct VifPublicState *s, float *num, float *den, unsigned w, unsigned h) {
+void vif_statistic_8_avx2(struct VifPublicState *s, VifResiduals *residuals_out, unsigned w, unsigned h) {
     assert(vif_filter1d_width[0] == 17);
     static const unsigned fwidth = 17;
     const uint16_t *vif_filt_s0 = vif_filter1d_table[0];
@@ -500,12 +500,14 @@ void vif_statistic_8_avx2(struct VifPublicState *s, float *num, float *den, unsi
     //den[0] = accum_den_log / 2048.0 + accum_den_non_log;
 
     //changed calculation to increase performance
-    num[0] = accum_num_log / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
-    den[0] = accum_den_log / 2048.0 + accum_den_non_log;
+    residuals_out->accum_num_log = accum_num_log;
+    residuals_out->accum_den_log = accum_den_log;
+    residuals_out->accum_num_non_log = accum_num_non_log;
+    residuals_out->accum_den_non_log = accum_den_non_log;
 
 }
 
-void vif_statistic_16_avx2(struct VifPublicState *s, float *num, float *den, unsigned w, unsigned h, int bpc, int scale) {
+void vif_statistic_16_avx2(struct VifPublicState *s, VifResiduals *residuals_out, unsigned w, unsigned h, int bpc, int scale) {
     const unsigned fwidth = vif_filter1d_width[scale];
     const uint16_t *vif_filt = vif_filter1d_table[scale];
     VifBuffer buf = s->buf;
@@ -1055,8 +1057,13 @@ void vif_statistic_16_avx2(struct VifPublicState *s, float *num, float *den, uns
         }
     }
 
-    num[0] = accum_num_log / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
-    den[0] = accum_den_log / 2048.0 + accum_den_non_log;
+    residuals_out->accum_num_log = accum_num_log;
+
+    residuals_out->accum_den_log = accum_den_log;
+
+    residuals_out->accum_num_non_log = accum_num_non_log;
+
+    residuals_out->accum_den_non_log = accum_den_non_log;
 }
 
 void vif_subsample_rd_8_avx2(VifBuffer buf, unsigned w, unsigned h) {
@@ -141,7 +141,7 @@ static inline void vif_statistic_avx512(Residuals512 *out, __m512i xx, __m512i x
     out->maccum_den_non_log = maccum_den_non_log;
 }
 
-void vif_statistic_8_avx512(struct VifPublicState *s, float *num, float *den, unsigned w, unsigned h) {
+void vif_statistic_8_avx512(struct VifPublicState *s, VifResiduals *residuals_out, unsigned w, unsigned h) {
     const unsigned fwidth = vif_filter1d_width[0];
     const uint16_t *vif_filt = vif_filter1d_table[0];
     VifBuffer buf = s->buf;
@@ -347,11 +347,13 @@ void vif_statistic_8_avx512(struct VifPublicState *s, float *num, float *den, un
     accum_den_log = _mm512_reduce_add_epi64(residuals.maccum_den_log);
     accum_num_non_log = _mm512_reduce_add_epi64(residuals.maccum_num_non_log);
     accum_den_non_log = _mm512_reduce_add_epi64(residuals.maccum_den_non_log);
-    num[0] = accum_num_log / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
-    den[0] = accum_den_log / 2048.0 + accum_den_non_log;
+    residuals_out->accum_num_log = accum_num_log;
+    residuals_out->accum_den_log = accum_den_log;
+    residuals_out->accum_num_non_log = accum_num_non_log;
+    residuals_out->accum_den_non_log = accum_den_non_log;
 }
 
-void vif_statistic_16_avx512(struct VifPublicState *s, float *num, float *den, unsigned w, unsigned h, int bpc, int scale) {
+void vif_statistic_16_avx512(struct VifPublicState *s, VifResiduals *residuals_out, unsigned w, unsigned h, int bpc, int scale) {
     const unsigned fwidth = vif_filter1d_width[scale];
     const uint16_t *vif_filt = vif_filter1d_table[scale];
     VifBuffer buf = s->buf;
@@ -728,8 +730,10 @@ void vif_statistic_16_avx512(struct VifPublicState *s, float *num, float *den, u
     //den[0] = accum_den_log / 2048.0 + accum_den_non_log;
 
     //changed calculation to increase performance
-    num[0] = accum_num_log / 2048.0 + (accum_den_non_log - ((accum_num_non_log) / 16384.0) / (65025.0));
-    den[0] = accum_den_log / 2048.0 + accum_den_non_log;
+    residuals_out->accum_num_log = accum_num_log;
+    residuals_out->accum_den_log = accum_den_log;
+    residuals_out->accum_num_non_log = accum_num_non_log;
+    residuals_out->accum_den_non_log = accum_den_non_log;
 }
 
 void vif_subsample_rd_8_avx512(VifBuffer buf, unsigned w, unsigned h)
@@ -17,6 +17,7 @@
  */
 
 #include <errno.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
@@ -35,16 +36,31 @@
 #include "model.h"
 #include "output.h"
 #include "picture.h"
+#include "picture_cache.h"
 #include "predict.h"
 #include "thread_pool.h"
 #include "vcs_version.h"
 
+/*
+ * Tracks the work which writes scores of a picture. Each queued extraction
+ * holds a count, and so do the temporal extractions of the next picture,
+ * which also write scores of this one. One more count is held until the
+ * next picture is queued, or the context is flushed.
+ */
+typedef struct VmafFrame {
+    VmafContext *vmaf;
+    unsigned index;
+    atomic_uint pending;
+    struct VmafFrame *prev;
+} VmafFrame;
+
 typedef struct VmafContext {
     VmafConfiguration cfg;
     VmafFeatureCollector *feature_collector;
     RegisteredFeatureExtractors registered_feature_extractors;
     VmafFeatureExtractorContextPool *fex_ctx_pool;
     VmafThreadPool *thread_pool;
+    VmafPictureCache *picture_cache;
     struct {
         unsigned w, h;
         enum VmafPixelFormat pix_fmt;
@@ -52,6 +68,19 @@ typedef struct VmafContext {
     } pic_params;
     unsigned pic_cnt;
     bool flushed;
+    VmafModel **model;
+    unsigned model_cnt;
+    struct {
+        unsigned window;
+        unsigned index_low, index_high;
+    } stream;
+    struct {
+        VmafFrameCallback callback;
+        void *cookie;
+        unsigned flags;
+        VmafFrame *last;
+    } frame;
+    VmafOutputStream *output_stream;
 } VmafContext;
 
 int vmaf_init(VmafContext **vmaf, VmafConfiguration cfg)
@@ -73,10 +102,12 @@ int vmaf_init(VmafContext **vmaf, VmafConfiguration cfg)
     if (err) goto free_v;
     err = feature_extractor_vector_init(&(v->registered_feature_extractors));
     if (err) goto free_feature_collector;
+    err = vmaf_picture_cache_init(&v->picture_cache);
+    if (err) goto free_feature_extractor_vector;
 
     if (v->cfg.n_threads > 0) {
         err = vmaf_thread_pool_create(&v->thread_pool, v->cfg.n_threads);
-        if (err) goto free_feature_extractor_vector;
+        if (err) goto free_picture_cache;
         err = vmaf_fex_ctx_pool_create(&v->fex_ctx_pool, v->cfg.n_threads);
         if (err) goto free_thread_pool;
     }
@@ -85,6 +116,8 @@ int vmaf_init(VmafContext **vmaf, VmafConfiguration cfg)
 
 free_thread_pool:
     vmaf_thread_pool_destroy(v->thread_pool);
+free_picture_cache:
+    vmaf_picture_cache_destroy(v->picture_cache);
 free_feature_extractor_vector:
     feature_extractor_vector_destroy(&(v->registered_feature_extractors));
 free_feature_collector:
@@ -104,11 +137,79 @@ int vmaf_close(VmafContext *vmaf)
     vmaf_feature_collector_destroy(vmaf->feature_collector);
     vmaf_thread_pool_destroy(vmaf->thread_pool);
     vmaf_fex_ctx_pool_destroy(vmaf->fex_ctx_pool);
+    vmaf_picture_cache_destroy(vmaf->picture_cache);
+    free(vmaf->model);
+    // unflushed, the last picture is still waiting for its successor
+    free(vmaf->frame.last);
+    if (vmaf->output_stream)
+        vmaf_output_stream_close(vmaf->output_stream);
     free(vmaf);
 
     return 0;
 }
 
+int vmaf_set_score_window(VmafContext *vmaf, unsigned window,
+                          VmafScoreConsumer consumer, void *cookie)
+{
+    if (!vmaf) return -EINVAL;
+    if (!window) return -EINVAL;
+    if (window > (1u << 29)) return -EINVAL;
+    if (vmaf->registered_feature_extractors.cnt) return -EINVAL;
+
+    // scores are released in batches of window pictures, see stream_release()
+    int err = vmaf_feature_collector_set_stream(vmaf->feature_collector,
+                                                2 * window,
+                                                vmaf->cfg.n_subsample,
+                                                consumer, cookie);
+    if (err) return err;
+
+    vmaf->stream.window = window;
+    return 0;
+}
+
+int vmaf_set_frame_callback(VmafContext *vmaf, VmafFrameCallback callback,
+                            void *cookie, unsigned flags)
+{
+    if (!vmaf) return -EINVAL;
+    if (!callback) return -EINVAL;
+    if (vmaf->pic_cnt) return -EINVAL;
+
+    vmaf->frame.callback = callback;
+    vmaf->frame.cookie = cookie;
+    vmaf->frame.flags = flags;
+    return 0;
+}
+
+int vmaf_set_output_stream(VmafContext *vmaf, const char *output_path,
+                           enum VmafOutputFormat fmt)
+{
+    if (!vmaf) return -EINVAL;
+    if (!output_path) return -EINVAL;
+    if (vmaf->pic_cnt) return -EINVAL;
+    if (vmaf->output_stream) return -EINVAL;
+
+    return vmaf_output_stream_open(&vmaf->output_stream, output_path, fmt,
+                                   vmaf->cfg.n_subsample,
+                                   vmaf->feature_collector);
+}
+
+// models are predicted as their features complete, see frame_complete()
+// and stream_release_below()
+static int use_model(VmafContext *vmaf, VmafModel *model)
+{
+    for (unsigned i = 0; i < vmaf->model_cnt; i++) {
+        if (vmaf->model[i] == model)
+            return 0;
+    }
+
+    const size_t sz = sizeof(*(vmaf->model)) * (vmaf->model_cnt + 1);
+    VmafModel **m = realloc(vmaf->model, sz);
+    if (!m) return -ENOMEM;
+    m[vmaf->model_cnt++] = model;
+    vmaf->model = m;
+    return 0;
+}
+
 int vmaf_import_feature_score(VmafContext *vmaf, const char *feature_name,
                               double value, unsigned index)
 {
@@ -186,7 +287,8 @@ int vmaf_use_features_from_model(VmafContext *vmaf, VmafModel *model)
             return err;
         }
     }
-    return 0;
+
+    return use_model(vmaf, model);
 }
 
 int vmaf_use_features_from_model_collection(VmafContext *vmaf,
@@ -202,10 +304,135 @@ int vmaf_use_features_from_model_collection(VmafContext *vmaf,
     return err;
 }
 
+// predict the frames without a score in runs, rather than one by one
+static int predict_missing(VmafContext *vmaf, VmafModel *model,
+                           unsigned index_low, unsigned index_high)
+{
+    FeatureVector *predicted = NULL;
+    unsigned id;
+    if (!vmaf_feature_collector_get_id(vmaf->feature_collector, model->name,
+                                       &id))
+    {
+        predicted = vmaf_feature_collector_get_vector(vmaf->feature_collector,
+                                                      id);
+    }
+
+    const unsigned step =
+        vmaf->cfg.n_subsample > 1 ? vmaf->cfg.n_subsample : 1;
+    const unsigned first = (index_low + step - 1) / step * step;
+    for (unsigned i = first; i <= index_high && i >= first; i += step) {
+        if (predicted && feature_vector_get_score(predicted, i, NULL))
+            continue;
+
+        unsigned last = i;
+        while (index_high - last >= step &&
+               !(predicted &&
+                 feature_vector_get_score(predicted, last + step, NULL)))
+        {
+            last += step;
+        }
+
+        int err = vmaf_predict_scores_range(model, vmaf->feature_collector,
+                                            i, last, step, NULL, true, 0);
+        if (err) return err;
+        i = last;
+    }
+
+    return 0;
+}
+
+static void frame_complete(VmafContext *vmaf, unsigned index)
+{
+    const unsigned step =
+        vmaf->cfg.n_subsample > 1 ? vmaf->cfg.n_subsample : 1;
+
+    const bool predict = (vmaf->frame.flags & VMAF_FRAME_CALLBACK_PREDICT) ||
+                         vmaf->output_stream;
+
+    if (predict && !(index % step)) {
+        for (unsigned i = 0; i < vmaf->model_cnt; i++) {
+            int err = predict_missing(vmaf, vmaf->model[i], index, index);
+            if (err) {
+                vmaf_log(VMAF_LOG_LEVEL_WARNING,
+                         "problem predicting model \"%s\" at index %d\n",
+                         vmaf->model[i]->name, index);
+            }
+        }
+    }
+
+    if (vmaf->output_stream &&
+        vmaf_output_stream_frame(vmaf->output_stream, index))
+    {
+        vmaf_log(VMAF_LOG_LEVEL_WARNING,
+                 "problem writing output at index %d\n", index);
+    }
+
+    if (vmaf->frame.callback)
+        vmaf->frame.callback(vmaf->frame.cookie, index);
+}
+
+static void frame_release(VmafFrame *frame, unsigned cnt)
+{
+    if (atomic_fetch_sub(&frame->pending, cnt) != cnt)
+        return;
+
+    frame_complete(frame->vmaf, frame->index);
+    free(frame);
+}
+
+// count one extraction of the picture, which for a temporal extractor also
+// writes scores of the previous picture
+static void frame_hold(VmafFrame *frame, bool temporal)
+{
+    if (!frame) return;
+    atomic_fetch_add(&frame->pending, 1);
+    if (temporal && frame->prev)
+        atomic_fetch_add(&frame->prev->pending, 1);
+}
+
+static void frame_unhold(VmafFrame *frame, bool temporal)
+{
+    if (!frame) return;
+    VmafFrame *prev = frame->prev;
+    frame_release(frame, 1);
+    if (temporal && prev)
+        frame_release(prev, 1);
+}
+
+static void frame_unhold_temporal(void *cookie)
+{
+    frame_unhold(cookie, true);
+}
+
+/*
+ * Start tracking the picture at index. Until frame_close(), it holds a
+ * count of its own, and keeps the previous picture from completing.
+ */
+static int frame_open(VmafContext *vmaf, unsigned index, VmafFrame **frame)
+{
+    VmafFrame *const f = *frame = malloc(sizeof(*f));
+    if (!f) return -ENOMEM;
+    f->vmaf = vmaf;
+    f->index = index;
+    atomic_init(&f->pending, 2);
+    f->prev = vmaf->frame.last;
+    return 0;
+}
+
+static void frame_close(VmafContext *vmaf, VmafFrame *frame)
+{
+    if (frame->prev)
+        frame_release(frame->prev, 1);
+    vmaf->frame.last = frame;
+    frame_release(frame, 1);
+}
+
 struct ThreadData {
     VmafFeatureExtractorContext *fex_ctx;
     VmafPicture ref, dist;
     unsigned index;
+    unsigned seq;
+    VmafFrame *frame;
     VmafFeatureCollector *feature_collector;
     VmafFeatureExtractorContextPool *fex_ctx_pool;
     int err;
@@ -214,17 +441,28 @@ struct ThreadData {
 static void threaded_extract_func(void *e)
 {
     struct ThreadData *f = e;
-
-    f->err = vmaf_feature_extractor_context_extract(f->fex_ctx, &f->ref, NULL,
-                                                    &f->dist, NULL, f->index,
-                                                    f->feature_collector);
+    const bool temporal =
+        f->fex_ctx->fex->flags & VMAF_FEATURE_EXTRACTOR_TEMPORAL;
+
+    // the ordered stage of a temporal extraction may run on another thread
+    if (temporal) {
+        f->err = vmaf_feature_extractor_context_extract_ordered(f->fex_ctx,
+                        &f->ref, &f->dist, f->index, f->seq,
+                        f->feature_collector,
+                        f->frame ? frame_unhold_temporal : NULL, f->frame);
+    } else {
+        f->err = vmaf_feature_extractor_context_extract(f->fex_ctx, &f->ref,
+                        NULL, &f->dist, NULL, f->index, f->feature_collector);
+    }
     f->err = vmaf_fex_ctx_pool_release(f->fex_ctx_pool, f->fex_ctx);
     vmaf_picture_unref(&f->ref);
     vmaf_picture_unref(&f->dist);
+    if (!temporal) frame_unhold(f->frame, false);
 }
 
 static int threaded_read_pictures(VmafContext *vmaf, VmafPicture *ref,
-                                  VmafPicture *dist, unsigned index)
+                                  VmafPicture *dist, unsigned index,
+                                  VmafFrame *frame)
 {
     if (!vmaf) return -EINVAL;
     if (!ref) return -EINVAL;
@@ -248,6 +486,17 @@ static int threaded_read_pictures(VmafContext *vmaf, VmafPicture *ref,
         err = vmaf_fex_ctx_pool_aquire(vmaf->fex_ctx_pool, fex, opts_dict,
                                        &fex_ctx);
         if (err) return err;
+        // temporal contexts are shared between frames in flight
+        if (!fex_ctx->fex->thread_pool)
+            fex_ctx->fex->thread_pool = vmaf->thread_pool;
+
+        const bool temporal = fex->flags & VMAF_FEATURE_EXTRACTOR_TEMPORAL;
+        unsigned seq = 0;
+        if (temporal) {
+            err = vmaf_feature_extractor_context_submit(fex_ctx, ref, dist,
+                                                        &seq);
+            if (err) return err;
+        }
 
         VmafPicture pic_a, pic_b;
         vmaf_picture_ref(&pic_a, ref);
@@ -258,14 +507,19 @@ static int threaded_read_pictures(VmafContext *vmaf, VmafPicture *ref,
             .ref = pic_a,
             .dist = pic_b,
             .index = index,
+            .seq = seq,
+            .frame = frame,
             .feature_collector = vmaf->feature_collector,
             .fex_ctx_pool = vmaf->fex_ctx_pool,
             .err = 0,
         };
 
+        frame_hold(frame, temporal);
         err = vmaf_thread_pool_enqueue(vmaf->thread_pool, threaded_extract_func,
                                        &data, sizeof(data));
         if (err) {
+            if (temporal) vmaf_feature_extractor_context_cancel(fex_ctx, seq);
+            frame_unhold(frame, temporal);
             vmaf_picture_unref(&pic_a);
             vmaf_picture_unref(&pic_b);
             return err;
@@ -275,6 +529,35 @@ static int threaded_read_pictures(VmafContext *vmaf, VmafPicture *ref,
     return vmaf_picture_unref(ref) | vmaf_picture_unref(dist);
 }
 
+static int read_pictures(VmafContext *vmaf, VmafPicture *ref,
+                         VmafPicture *dist, unsigned index)
+{
+    int err = 0;
+
+    for (unsigned i = 0; i < vmaf->registered_feature_extractors.cnt; i++) {
+        VmafFeatureExtractorContext *fex_ctx =
+            vmaf->registered_feature_extractors.fex_ctx[i];
+
+        if ((vmaf->cfg.n_subsample > 1) && (index % vmaf->cfg.n_subsample) &&
+            !(fex_ctx->fex->flags & VMAF_FEATURE_EXTRACTOR_TEMPORAL))
+        {
+            continue;
+        }
+
+        err = vmaf_feature_extractor_context_extract(fex_ctx, ref, NULL, dist,
+                                                     NULL, index,
+                                                     vmaf->feature_collector);
+        if (err) return err;
+    }
+
+    err = vmaf_picture_unref(ref);
+    if (err) return err;
+    err = vmaf_picture_unref(dist);
+    if (err) return err;
+
+    return 0;
+}
+
 static int validate_pic_params(VmafContext *vmaf, VmafPicture *ref,
                                VmafPicture *dist)
 {
@@ -300,11 +583,59 @@ static int validate_pic_params(VmafContext *vmaf, VmafPicture *ref,
     return 0;
 }
 
+/*
+ * Release the scores of the pictures below index, after predicting the
+ * models which use them and streaming out their rows.
+ */
+static int stream_release_below(VmafContext *vmaf, unsigned index)
+{
+    const unsigned released = vmaf->feature_collector->stream.released;
+    const unsigned index_low =
+        vmaf->stream.index_low > released ? vmaf->stream.index_low : released;
+
+    if (vmaf->pic_cnt && index > index_low) {
+        for (unsigned i = 0; i < vmaf->model_cnt; i++) {
+            int err = predict_missing(vmaf, vmaf->model[i], index_low,
+                                      index - 1);
+            if (err) return err;
+        }
+    }
+
+    if (vmaf->output_stream) {
+        int err = vmaf_output_stream_skip(vmaf->output_stream, index);
+        if (err) return err;
+    }
+
+    return vmaf_feature_collector_release(vmaf->feature_collector, index);
+}
+
+/*
+ * Called before extracting the picture at index. Once 2 * window pictures
+ * are held, the older half is released. These pictures are complete once
+ * all queued extraction is: temporal extractors write the scores of a
+ * picture no later than while extracting the next one.
+ */
+static int stream_release(VmafContext *vmaf, unsigned index)
+{
+    const unsigned window = vmaf->stream.window;
+    const unsigned released = vmaf->feature_collector->stream.released;
+    if (index < released || index - released < 2 * window)
+        return 0;
+
+    if (vmaf->thread_pool) {
+        int err = vmaf_thread_pool_wait(vmaf->thread_pool);
+        if (err) return err;
+    }
+
+    return stream_release_below(vmaf, index - window);
+}
+
 static int flush_context_threaded(VmafContext *vmaf)
 {
     int err = 0;
     err |= vmaf_thread_pool_wait(vmaf->thread_pool);
     err |= vmaf_fex_ctx_pool_flush(vmaf->fex_ctx_pool, vmaf->feature_collector);
+    vmaf->feature_collector->timer.end = clock();
 
     if (!err) vmaf->flushed = true;
     return err;
@@ -322,6 +653,7 @@ static int flush_context(VmafContext *vmaf)
         err |= vmaf_feature_extractor_context_flush(rfe.fex_ctx[i],
                                                     vmaf->feature_collector);
     }
+    vmaf->feature_collector->timer.end = clock();
 
     if (!err) vmaf->flushed = true;
     return err;
@@ -334,39 +666,102 @@ int vmaf_read_pictures(VmafContext *vmaf, VmafPicture *ref, VmafPicture *dist,
     if (!vmaf) return -EINVAL;
     if (vmaf->flushed) return -EINVAL;
     if (!ref != !dist) return -EINVAL;
-    if (!ref && !dist) return flush_context(vmaf);
+    if (!ref && !dist) {
+        int err = flush_context(vmaf);
+        if (!err && vmaf->frame.last) {
+            frame_release(vmaf->frame.last, 1);
+            vmaf->frame.last = NULL;
+        }
+        if (!err && vmaf->output_stream) {
+            err = vmaf_output_stream_close(vmaf->output_stream);
+            vmaf->output_stream = NULL;
+        }
+        if (!err && vmaf->stream.window)
+            err = stream_release_below(vmaf, vmaf->stream.index_high + 1);
+        return err;
+    }
 
     int err = 0;
 
+    if (vmaf->stream.window) {
+        err = stream_release(vmaf, index);
+        if (err) return err;
+        if (!vmaf->pic_cnt || index < vmaf->stream.index_low)
+            vmaf->stream.index_low = index;
+        if (!vmaf->pic_cnt || index > vmaf->stream.index_high)
+            vmaf->stream.index_high = index;
+    }
+
     vmaf->pic_cnt++;
     err = validate_pic_params(vmaf, ref, dist);
     if (err) return err;
 
+    // extractors share what they derive from these pictures, see
+    // vmaf_picture_cache_get()
+    err = vmaf_picture_cache_attach(vmaf->picture_cache, ref);
+    if (err) return err;
+    err = vmaf_picture_cache_attach(vmaf->picture_cache, dist);
+    if (err) return err;
+
+    VmafFrame *frame = NULL;
+    if (vmaf->frame.callback || vmaf->output_stream) {
+        err = frame_open(vmaf, index, &frame);
+        if (err) return err;
+    }
+
     if (vmaf->thread_pool)
-        return threaded_read_pictures(vmaf, ref, dist, index);
+        err = threaded_read_pictures(vmaf, ref, dist, index, frame);
+    else
+        err = read_pictures(vmaf, ref, dist, index);
 
-    for (unsigned i = 0; i < vmaf->registered_feature_extractors.cnt; i++) {
-        VmafFeatureExtractorContext *fex_ctx =
-            vmaf->registered_feature_extractors.fex_ctx[i];
+    if (frame) frame_close(vmaf, frame);
+    return err;
+}
 
-        if ((vmaf->cfg.n_subsample > 1) && (index % vmaf->cfg.n_subsample) &&
-            !(fex_ctx->fex->flags & VMAF_FEATURE_EXTRACTOR_TEMPORAL))
-        {
-            continue;
-        }
+int vmaf_read_pictures_multi(VmafContext **vmaf, unsigned cnt,
+                             VmafPicture *ref, VmafPicture *dist,
+                             unsigned index)
+{
+    if (!vmaf) return -EINVAL;
+    if (!cnt) return -EINVAL;
+    if (!ref != !dist) return -EINVAL;
+    for (unsigned i = 0; i < cnt; i++)
+        if (!vmaf[i]) return -EINVAL;
 
-        err = vmaf_feature_extractor_context_extract(fex_ctx, ref, NULL, dist,
-                                                     NULL, index,
-                                                     vmaf->feature_collector);
-        if (err) return err;
+    int err = 0;
+    if (!ref && !dist) {
+        for (unsigned i = 0; i < cnt; i++)
+            err |= vmaf_read_pictures(vmaf[i], NULL, NULL, 0);
+        return err;
     }
 
-    err = vmaf_picture_unref(ref);
-    if (err) return err;
-    err = vmaf_picture_unref(dist);
-    if (err) return err;
+    // every context holds a reference of its own, the data derived from
+    // ref is shared through the cache of the picture
+    unsigned i = 0;
+    if (cnt > 1) {
+        err = vmaf_picture_cache_share(ref);
+        if (err) goto release;
+    }
+    for (; i < cnt; i++) {
+        VmafPicture pic;
+        err = vmaf_picture_ref(&pic, ref);
+        if (err) goto release;
+        err = vmaf_read_pictures(vmaf[i], &pic, &dist[i], index);
+        if (err) {
+            // a failed read leaves both pictures with us
+            if (pic.ref) vmaf_picture_unref(&pic);
+            goto release;
+        }
+    }
 
-    return 0;
+    return vmaf_picture_unref(ref);
+
+release:
+    // the pictures no context has taken are still ours to release
+    for (; i < cnt; i++)
+        if (dist[i].ref) vmaf_picture_unref(&dist[i]);
+    vmaf_picture_unref(ref);
+    return err;
 }
 
 int vmaf_feature_score_at_index(VmafContext *vmaf, const char *feature_name,
@@ -422,35 +817,44 @@ int vmaf_feature_score_pooled(VmafContext *vmaf, const char *feature_name,
     if (index_low > index_high) return -EINVAL;
     if (!pool_method) return -EINVAL;
 
-    unsigned pic_cnt = 0;
-    double min = 0., max = 0., sum = 0., i_sum = 0.;
-    for (unsigned i = index_low; i <= index_high; i++) {
-        if ((vmaf->cfg.n_subsample > 1) && (i % vmaf->cfg.n_subsample))
-            continue;
-        pic_cnt++;
-        double s;
-        int err = vmaf_feature_score_at_index(vmaf, feature_name, &s, i);
+    FeatureScoreStats stats = { 0 };
+    unsigned i = index_low;
+
+    // the released scores of a streaming context are only available as
+    // running aggregates, which pool intervals covering all of them
+    FeatureScoreStats released;
+    if (vmaf->stream.window &&
+        !vmaf_feature_collector_get_released(vmaf->feature_collector,
+                                             feature_name, &released) &&
+        released.cnt)
+    {
+        if (index_low > released.index_low) return -EINVAL;
+        if (index_high < released.index_high) return -EINVAL;
+        stats = released;
+        i = vmaf->feature_collector->stream.released;
+    }
+
+    if (i <= index_high) {
+        const unsigned step =
+            vmaf->cfg.n_subsample > 1 ? vmaf->cfg.n_subsample : 1;
+        int err = vmaf_feature_collector_pool(vmaf->feature_collector,
+                                              feature_name, i, index_high,
+                                              step, &stats);
         if (err) return err;
-        sum += s;
-        i_sum += 1. / (s + 1.);
-        if ((i == index_low) || (s < min))
-            min = s;
-        if ((i == index_low) || (s > max))
-            max = s;
     }
 
     switch (pool_method) {
     case VMAF_POOL_METHOD_MEAN:
-        *score = sum / pic_cnt;
+        *score = stats.sum / stats.cnt;
         break;
     case VMAF_POOL_METHOD_MIN:
-        *score = min;
+        *score = stats.min;
         break;
     case VMAF_POOL_METHOD_MAX:
-        *score = max;
+        *score = stats.max;
         break;
     case VMAF_POOL_METHOD_HARMONIC_MEAN:
-        *score = pic_cnt / i_sum - 1.0;
+        *score = stats.cnt / stats.i_sum - 1.0;
         break;
     default:
         return -EINVAL;
@@ -469,11 +873,12 @@ int vmaf_score_pooled(VmafContext *vmaf, VmafModel *model,
     if (index_low > index_high) return -EINVAL;
     if (!pool_method) return -EINVAL;
 
-    for (unsigned i = index_low; i <= index_high; i++) {
-        if ((vmaf->cfg.n_subsample > 1) && (i % vmaf->cfg.n_subsample))
-            continue;
-        double vmaf_score;
-        int err = vmaf_score_at_index(vmaf, model, &vmaf_score, i);
+    // released pictures have been predicted before their release
+    const unsigned released = vmaf->feature_collector->stream.released;
+    if (index_high >= released) {
+        int err = predict_missing(vmaf, model,
+                                  index_low > released ? index_low : released,
+                                  index_high);
         if (err) return err;
     }
 
@@ -575,6 +980,10 @@ int vmaf_write_output(VmafContext *vmaf, const char *output_path,
         ret = vmaf_write_output_sub(vmaf->feature_collector, outfile,
                                     vmaf->cfg.n_subsample);
         break;
+    case VMAF_OUTPUT_FORMAT_BIN:
+        ret = vmaf_write_output_bin(vmaf, vmaf->feature_collector, outfile,
+                                    vmaf->cfg.n_subsample, vmaf->pic_cnt);
+        break;
     default:
         ret = -EINVAL;
         break;
@@ -6,9 +6,11 @@
 
 #include <libvmaf/model.h>
 
+#include "binary_model.h"
 #include "config.h"
 #include "feature/feature_extractor.h"
 #include "log.h"
+#include "mem.h"
 #include "model.h"
 #include "read_json_model.h"
 #include "svm.h"
@@ -141,7 +143,9 @@ char *vmaf_model_generate_name(VmafModelConfig *cfg)
 int vmaf_model_load_from_path(VmafModel **model, VmafModelConfig *cfg,
                               const char *path)
 {
-    int err = vmaf_read_json_model_from_path(model, cfg, path);
+    int err = vmaf_binary_model_probe(path) ?
+              vmaf_read_binary_model_from_path(model, cfg, path) :
+              vmaf_read_json_model_from_path(model, cfg, path);
     if (err) {
         vmaf_log(VMAF_LOG_LEVEL_ERROR,
                  "could not read model from path: \"%s\"\n", path);
@@ -177,6 +181,8 @@ int vmaf_model_feature_overload(VmafModel *model, const char *feature_name,
         err = vmaf_dictionary_free(&model->feature[i].opts_dict);
         if (err) goto exit;
         model->feature[i].opts_dict = d;
+        free(model->feature[i].score_name);
+        model->feature[i].score_name = NULL;
     }
 
 exit:
@@ -192,13 +198,61 @@ void vmaf_model_destroy(VmafModel *model)
     svm_free_and_destroy_model(&(model->svm));
     for (unsigned i = 0; i < model->n_features; i++) {
         free(model->feature[i].name);
+        free(model->feature[i].score_name);
         vmaf_dictionary_free(&model->feature[i].opts_dict);
     }
     free(model->feature);
+    if (model->map)
+        vmaf_model_map_unref(model->map);
+    else
+        aligned_free((double *) model->sv_coef);
     free(model->score_transform.knots.list);
     free(model);
 }
 
+int vmaf_model_dense_support_vectors(const VmafModel *model, double **sv_coef,
+                                     unsigned *sv_dim, unsigned *sv_stride)
+{
+    const struct svm_model *svm = model->svm;
+
+    unsigned dim = model->n_features;
+    for (int i = 0; i < svm->l; i++) {
+        for (const struct svm_node *n = svm->SV[i]; n->index != -1; n++) {
+            if (n->index < 1) return -EINVAL;
+            if ((unsigned) n->index > dim) dim = n->index;
+        }
+    }
+    const unsigned a = VMAF_MODEL_SV_ALIGN;
+    const unsigned stride = svm->l ? (svm->l + a - 1) / a * a : a;
+
+    const size_t sz = sizeof(**sv_coef) * stride * (dim + 1);
+    double *const d = aligned_malloc(sz, sizeof(**sv_coef) * a);
+    if (!d) return -ENOMEM;
+    memset(d, 0, sz);
+    for (int i = 0; i < svm->l; i++) {
+        d[i] = svm->sv_coef[0][i];
+        for (const struct svm_node *n = svm->SV[i]; n->index != -1; n++)
+            d[n->index * stride + i] = n->value;
+    }
+
+    *sv_coef = d;
+    *sv_dim = dim;
+    *sv_stride = stride;
+    return 0;
+}
+
+int vmaf_model_write_binary(VmafModel *model,
+                            VmafModelCollection *model_collection,
+                            const char *path)
+{
+    int err = vmaf_write_binary_model(model, model_collection, path);
+    if (err) {
+        vmaf_log(VMAF_LOG_LEVEL_ERROR,
+                 "could not write binary model to path: \"%s\"\n", path);
+    }
+    return err;
+}
+
 int vmaf_model_collection_append(VmafModelCollection **model_collection,
                                  VmafModel *model)
 {
@@ -286,7 +340,9 @@ int vmaf_model_collection_load_from_path(VmafModel **model,
                                          VmafModelConfig *cfg,
                                          const char *path)
 {
-    int err =
+    int err = vmaf_binary_model_probe(path) ?
+        vmaf_read_binary_model_collection_from_path(model, model_collection,
+                                                    cfg, path) :
         vmaf_read_json_model_collection_from_path(model, model_collection,
                                                   cfg, path);
     if (err) {
@@ -41,6 +41,7 @@ typedef struct {
     char *name;
     double slope, intercept;
     VmafDictionary *opts_dict;
+    char *score_name; ///< resolved from name and opts_dict, see predict.c
 } VmafModelFeature;
 
 typedef struct {
@@ -74,6 +75,11 @@ typedef struct VmafModel {
         bool out_lte_in, out_gte_in;
     } score_transform;
     struct svm_model *svm;
+    // dense copy of svm, see vmaf_model_dense_support_vectors()
+    const double *sv_coef; ///< sv_stride coefficients, zero past svm->l
+    const double *sv; ///< sv_dim rows of sv_stride support vector values
+    unsigned sv_dim, sv_stride;
+    struct VmafModelMap *map; ///< holds sv of a compiled model, see binary_model.h
 } VmafModel;
 
 typedef struct VmafModelCollection {
@@ -85,6 +91,19 @@ typedef struct VmafModelCollection {
 
 char *vmaf_model_generate_name(VmafModelConfig *cfg);
 
+// support vector count padding, a multiple of the widest SIMD evaluator
+#define VMAF_MODEL_SV_ALIGN 8
+
+/**
+ * Copy the coefficients and support vectors of model->svm into one aligned
+ * block, to be released with aligned_free(): sv_stride coefficients, then
+ * sv_dim rows of sv_stride values, one column per support vector. sv_dim
+ * covers both the features and the largest support vector index, padding
+ * is zero.
+ */
+int vmaf_model_dense_support_vectors(const VmafModel *model, double **sv_coef,
+                                     unsigned *sv_dim, unsigned *sv_stride);
+
 int vmaf_model_collection_append(VmafModelCollection **model_collection,
                                  VmafModel *model);
 
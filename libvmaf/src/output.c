@@ -18,25 +18,214 @@
 
 #include <errno.h>
 #include <math.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "feature/alias.h"
 #include "feature/feature_collector.h"
 
 #include "libvmaf/libvmaf.h"
+#include "output.h"
+
+/*
+ * Output is formatted into a buffer, which is written out once full,
+ * rather than passing each value through stdio.
+ */
+typedef struct {
+    FILE *outfile;
+    size_t len;
+    int err;
+    char data[1 << 16];
+} OutputBuffer;
+
+static OutputBuffer *output_buffer_open(FILE *outfile)
+{
+    OutputBuffer *ob = malloc(sizeof(*ob));
+    if (!ob) return NULL;
+    ob->outfile = outfile;
+    ob->len = 0;
+    ob->err = 0;
+    return ob;
+}
+
+static void output_buffer_flush(OutputBuffer *ob)
+{
+    if (ob->len && fwrite(ob->data, ob->len, 1, ob->outfile) != 1)
+        ob->err = -EIO;
+    ob->len = 0;
+}
+
+static int output_buffer_close(OutputBuffer *ob)
+{
+    output_buffer_flush(ob);
+    const int err = ob->err;
+    free(ob);
+    return err;
+}
+
+// room for n more bytes
+static char *output_buffer_reserve(OutputBuffer *ob, size_t n)
+{
+    if (ob->len + n > sizeof(ob->data))
+        output_buffer_flush(ob);
+    return n <= sizeof(ob->data) ? ob->data + ob->len : NULL;
+}
+
+static void output_buffer_write(OutputBuffer *ob, const void *data, size_t n)
+{
+    char *dst = output_buffer_reserve(ob, n);
+    if (!dst) {
+        if (fwrite(data, n, 1, ob->outfile) != 1)
+            ob->err = -EIO;
+        return;
+    }
+    memcpy(dst, data, n);
+    ob->len += n;
+}
+
+static void output_buffer_str(OutputBuffer *ob, const char *str)
+{
+    output_buffer_write(ob, str, strlen(str));
+}
+
+static void output_buffer_printf(OutputBuffer *ob, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    char *dst = output_buffer_reserve(ob, 256);
+    int n = vsnprintf(dst, 256, fmt, args);
+    va_end(args);
+    if (n < 0) {
+        ob->err = -EINVAL;
+    } else if (n < 256) {
+        ob->len += n;
+    } else {
+        char *str = malloc(n + 1);
+        if (!str) {
+            ob->err = -ENOMEM;
+            return;
+        }
+        va_start(args, fmt);
+        vsnprintf(str, n + 1, fmt, args);
+        va_end(args);
+        output_buffer_write(ob, str, n);
+        free(str);
+    }
+}
+
+static void output_buffer_uint(OutputBuffer *ob, unsigned value)
+{
+    char digits[10];
+    unsigned n = 0;
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+
+    char *dst = output_buffer_reserve(ob, n);
+    for (unsigned i = 0; i < n; i++)
+        dst[i] = digits[n - 1 - i];
+    ob->len += n;
+}
+
+/*
+ * Same as "%.6f". The value is scaled and rounded in double precision, and
+ * the exact remainder from fma() tells whether that rounding is the one
+ * printf would make. Values near a tie, or too large, go through printf.
+ */
+static void output_buffer_score(OutputBuffer *ob, double score)
+{
+    const double q = nearbyint(score * 1e6);
+    if (!(fabs(score) < 1e9) || !(fabs(fma(score, 1e6, -q)) < 0.4999)) {
+        output_buffer_printf(ob, "%.6f", score);
+        return;
+    }
+
+    uint64_t v = fabs(q);
+    char *dst = output_buffer_reserve(ob, 32);
+    char *p = dst;
+    if (signbit(score)) *p++ = '-';
+
+    char digits[16];
+    unsigned n = 0;
+    for (unsigned i = 0; i < 6; i++, v /= 10)
+        digits[n++] = '0' + v % 10;
+    digits[n++] = '.';
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+
+    while (n) *p++ = digits[--n];
+    ob->len += p - dst;
+}
 
 static unsigned max_capacity(VmafFeatureCollector *fc)
 {
     unsigned capacity = 0;
 
     for (unsigned j = 0; j < fc->cnt; j++) {
-        if (fc->feature_vector[j]->capacity > capacity)
-            capacity = fc->feature_vector[j]->capacity;
+        FeatureVector *fv = vmaf_feature_collector_get_vector(fc, j);
+        if (fv->capacity > capacity)
+            capacity = fv->capacity;
     }
 
     return capacity;
 }
 
+/*
+ * The feature vectors of fc, with room for one score per feature, which
+ * frame_scores() fills in. The scores are copies, as the slots of a
+ * streaming collector are reused once released.
+ */
+typedef struct {
+    unsigned cnt;
+    FeatureVector **fv;
+    double *score;
+    bool *written;
+} FrameRow;
+
+static int frame_row_init(FrameRow *row, VmafFeatureCollector *fc)
+{
+    row->cnt = fc->cnt;
+    row->fv = malloc(sizeof(*row->fv) * (row->cnt + 1));
+    row->score = malloc(sizeof(*row->score) * (row->cnt + 1));
+    row->written = malloc(sizeof(*row->written) * (row->cnt + 1));
+    if (!row->fv || !row->score || !row->written) {
+        free(row->fv);
+        free(row->score);
+        free(row->written);
+        return -ENOMEM;
+    }
+    for (unsigned j = 0; j < row->cnt; j++)
+        row->fv[j] = vmaf_feature_collector_get_vector(fc, j);
+    return 0;
+}
+
+static void frame_row_destroy(FrameRow *row)
+{
+    free(row->fv);
+    free(row->score);
+    free(row->written);
+}
+
+// gather the scores of picture index, returns how many there are
+static unsigned frame_scores(FrameRow *row, unsigned index)
+{
+    unsigned cnt = 0;
+    for (unsigned j = 0; j < row->cnt; j++) {
+        row->written[j] =
+            feature_vector_get_score(row->fv[j], index, &row->score[j]);
+        cnt += row->written[j];
+    }
+    return cnt;
+}
+
 static const char *pool_method_name[] = {
     [VMAF_POOL_METHOD_MIN] = "min",
     [VMAF_POOL_METHOD_MAX] = "max",
@@ -52,263 +241,565 @@ int vmaf_write_output_xml(VmafContext *vmaf, VmafFeatureCollector *fc,
     if (!fc) return -EINVAL;
     if (!outfile) return -EINVAL;
 
-    fprintf(outfile, "<VMAF version=\"%s\">\n", vmaf_version());
-    fprintf(outfile, "  <params qualityWidth=\"%d\" qualityHeight=\"%d\" />\n",
+    FrameRow row;
+    int err = frame_row_init(&row, fc);
+    if (err) return err;
+    OutputBuffer *ob = output_buffer_open(outfile);
+    if (!ob) {
+        frame_row_destroy(&row);
+        return -ENOMEM;
+    }
+
+    output_buffer_printf(ob, "<VMAF version=\"%s\">\n", vmaf_version());
+    output_buffer_printf(ob,
+            "  <params qualityWidth=\"%d\" qualityHeight=\"%d\" />\n",
             width, height);
-    fprintf(outfile, "  <fyi fps=\"%.2f\" />\n", fps);
+    output_buffer_printf(ob, "  <fyi fps=\"%.2f\" />\n", fps);
 
     unsigned n_frames = 0;
-    fprintf(outfile, "  <frames>\n");
-    for (unsigned i = 0 ; i < max_capacity(fc); i++) {
+    output_buffer_str(ob, "  <frames>\n");
+    const unsigned capacity = max_capacity(fc);
+    for (unsigned i = 0 ; i < capacity; i++) {
         if ((subsample > 1) && (i % subsample))
             continue;
 
-        unsigned cnt = 0;
-        for (unsigned j = 0; j < fc->cnt; j++) {
-            if (i > fc->feature_vector[j]->capacity)
-                continue;
-            if (fc->feature_vector[j]->score[i].written)
-                cnt++;
-        }
-        if (!cnt) continue;
-
-        fprintf(outfile, "    <frame frameNum=\"%d\" ", i);
-        for (unsigned j = 0; j < fc->cnt; j++) {
-            if (i > fc->feature_vector[j]->capacity)
-                continue;
-            if (!fc->feature_vector[j]->score[i].written)
-                continue;
-            fprintf(outfile, "%s=\"%.6f\" ",
-                vmaf_feature_name_alias(fc->feature_vector[j]->name),
-                fc->feature_vector[j]->score[i].value
-            );
+        if (!frame_scores(&row, i)) continue;
+
+        output_buffer_str(ob, "    <frame frameNum=\"");
+        output_buffer_uint(ob, i);
+        output_buffer_str(ob, "\" ");
+        for (unsigned j = 0; j < row.cnt; j++) {
+            if (!row.written[j]) continue;
+            output_buffer_str(ob, vmaf_feature_name_alias(row.fv[j]->name));
+            output_buffer_str(ob, "=\"");
+            output_buffer_score(ob, row.score[j]);
+            output_buffer_str(ob, "\" ");
         }
         n_frames++;
-        fprintf(outfile, "/>\n");
+        output_buffer_str(ob, "/>\n");
     }
-    fprintf(outfile, "  </frames>\n");
+    output_buffer_str(ob, "  </frames>\n");
 
-    fprintf(outfile, "  <pooled_metrics>\n");
-    for (unsigned i = 0; i < fc->cnt; i++) {
-        const char *feature_name = fc->feature_vector[i]->name;
-        fprintf(outfile, "    <metric name=\"%s\" ",
-                vmaf_feature_name_alias(feature_name));
+    output_buffer_str(ob, "  <pooled_metrics>\n");
+    for (unsigned i = 0; i < row.cnt; i++) {
+        const char *feature_name = row.fv[i]->name;
+        output_buffer_printf(ob, "    <metric name=\"%s\" ",
+                             vmaf_feature_name_alias(feature_name));
 
         for (unsigned j = 1; j < VMAF_POOL_METHOD_NB; j++) {
             double score;
             int err = vmaf_feature_score_pooled(vmaf, feature_name, j, &score,
                                                 0, pic_cnt - 1);
-            if (!err)
-                fprintf(outfile, "%s=\"%.6f\" ", pool_method_name[j], score);
+            if (!err) {
+                output_buffer_printf(ob, "%s=\"", pool_method_name[j]);
+                output_buffer_score(ob, score);
+                output_buffer_str(ob, "\" ");
+            }
         }
-        fprintf(outfile, "/>\n");
+        output_buffer_str(ob, "/>\n");
     }
-    fprintf(outfile, "  </pooled_metrics>\n");
+    output_buffer_str(ob, "  </pooled_metrics>\n");
 
 
-    fprintf(outfile, "  <aggregate_metrics ");
+    output_buffer_str(ob, "  <aggregate_metrics ");
     for (unsigned i = 0; i < fc->aggregate_vector.cnt; i++) {
-        fprintf(outfile, "%s=\"%.6f\" ",
-                fc->aggregate_vector.metric[i].name,
-                fc->aggregate_vector.metric[i].value);
+        output_buffer_printf(ob, "%s=\"", fc->aggregate_vector.metric[i].name);
+        output_buffer_score(ob, fc->aggregate_vector.metric[i].value);
+        output_buffer_str(ob, "\" ");
     }
-    fprintf(outfile, "/>\n");
+    output_buffer_str(ob, "/>\n");
 
-    fprintf(outfile, "</VMAF>\n");
+    output_buffer_str(ob, "</VMAF>\n");
 
-    return 0;
+    frame_row_destroy(&row);
+    return output_buffer_close(ob);
+}
+
+// JSON has no literal for non-finite numbers
+static void output_buffer_json_score(OutputBuffer *ob, double score)
+{
+    switch(fpclassify(score)) {
+    case FP_NORMAL:
+    case FP_ZERO:
+    case FP_SUBNORMAL:
+        output_buffer_score(ob, score);
+        break;
+    case FP_INFINITE:
+    case FP_NAN:
+        output_buffer_str(ob, "null");
+        break;
+    }
 }
 
 int vmaf_write_output_json(VmafContext *vmaf, VmafFeatureCollector *fc,
                            FILE *outfile, unsigned subsample, double fps,
                            unsigned pic_cnt)
 {
-    fprintf(outfile, "{\n");
-    fprintf(outfile, "  \"version\": \"%s\",\n", vmaf_version());
+    FrameRow row;
+    int err = frame_row_init(&row, fc);
+    if (err) return err;
+    OutputBuffer *ob = output_buffer_open(outfile);
+    if (!ob) {
+        frame_row_destroy(&row);
+        return -ENOMEM;
+    }
+
+    output_buffer_str(ob, "{\n");
+    output_buffer_printf(ob, "  \"version\": \"%s\",\n", vmaf_version());
     switch(fpclassify(fps)) {
     case FP_NORMAL:
     case FP_ZERO:
     case FP_SUBNORMAL:
-        fprintf(outfile, "  \"fps\": %.2f,\n", fps);
+        output_buffer_printf(ob, "  \"fps\": %.2f,\n", fps);
         break;
     case FP_INFINITE:
     case FP_NAN:
-        fprintf(outfile, "  \"fps\": null,\n");
+        output_buffer_str(ob, "  \"fps\": null,\n");
     }
 
     unsigned n_frames = 0;
-    fprintf(outfile, "  \"frames\": [");
-    for (unsigned i = 0 ; i < max_capacity(fc); i++) {
+    output_buffer_str(ob, "  \"frames\": [");
+    const unsigned capacity = max_capacity(fc);
+    for (unsigned i = 0 ; i < capacity; i++) {
         if ((subsample > 1) && (i % subsample))
             continue;
 
-        unsigned cnt = 0;
-        for (unsigned j = 0; j < fc->cnt; j++) {
-            if (i > fc->feature_vector[j]->capacity)
-                continue;
-            if (fc->feature_vector[j]->score[i].written)
-                cnt++;
-        }
+        const unsigned cnt = frame_scores(&row, i);
         if (!cnt) continue;
-        fprintf(outfile, "%s", i > 0 ? ",\n" : "\n");
+        output_buffer_str(ob, i > 0 ? ",\n" : "\n");
 
-        fprintf(outfile, "    {\n");
-        fprintf(outfile, "      \"frameNum\": %d,\n", i);
-        fprintf(outfile, "      \"metrics\": {\n");
+        output_buffer_str(ob, "    {\n");
+        output_buffer_str(ob, "      \"frameNum\": ");
+        output_buffer_uint(ob, i);
+        output_buffer_str(ob, ",\n");
+        output_buffer_str(ob, "      \"metrics\": {\n");
 
         unsigned cnt2 = 0;
-        for (unsigned j = 0; j < fc->cnt; j++) {
-            if (i > fc->feature_vector[j]->capacity)
-                continue;
-            if (!fc->feature_vector[j]->score[i].written)
-                continue;
+        for (unsigned j = 0; j < row.cnt; j++) {
+            if (!row.written[j]) continue;
             cnt2++;
-            switch(fpclassify(fc->feature_vector[j]->score[i].value)) {
-            case FP_NORMAL:
-            case FP_ZERO:
-            case FP_SUBNORMAL:
-                fprintf(outfile, "        \"%s\": %.6f%s\n",
-                    vmaf_feature_name_alias(fc->feature_vector[j]->name),
-                    fc->feature_vector[j]->score[i].value,
-                    cnt2 < cnt ? "," : ""
-                );
-                break;
-            case FP_INFINITE:
-            case FP_NAN:
-                fprintf(outfile, "        \"%s\": null%s",
-                        vmaf_feature_name_alias(fc->feature_vector[j]->name),
-                        cnt2 < cnt ? "," : "");
-                break;
-            }
+            output_buffer_str(ob, "        \"");
+            output_buffer_str(ob, vmaf_feature_name_alias(row.fv[j]->name));
+            output_buffer_str(ob, "\": ");
+            output_buffer_json_score(ob, row.score[j]);
+            output_buffer_str(ob, cnt2 < cnt ? "," : "");
+            if (isfinite(row.score[j]))
+                output_buffer_str(ob, "\n");
         }
-        fprintf(outfile, "      }\n");
-        fprintf(outfile, "    }");
+        output_buffer_str(ob, "      }\n");
+        output_buffer_str(ob, "    }");
         n_frames++;
     }
-    fprintf(outfile, "\n  ],\n");
-
-    fprintf(outfile, "  \"pooled_metrics\": {");
-    for (unsigned i = 0; i < fc->cnt; i++) {
-        const char *feature_name = fc->feature_vector[i]->name;
-        fprintf(outfile, "%s", i > 0 ? ",\n" : "\n");
-        fprintf(outfile, "    \"%s\": {",
-                vmaf_feature_name_alias(feature_name));
+    output_buffer_str(ob, "\n  ],\n");
+
+    output_buffer_str(ob, "  \"pooled_metrics\": {");
+    for (unsigned i = 0; i < row.cnt; i++) {
+        const char *feature_name = row.fv[i]->name;
+        output_buffer_str(ob, i > 0 ? ",\n" : "\n");
+        output_buffer_printf(ob, "    \"%s\": {",
+                             vmaf_feature_name_alias(feature_name));
         for (unsigned j = 1; j < VMAF_POOL_METHOD_NB; j++) {
             double score;
             int err = vmaf_feature_score_pooled(vmaf, feature_name, j, &score,
                                                 0, pic_cnt - 1);
             if (!err) {
-                fprintf(outfile, "%s", j > 1 ? ",\n" : "\n");
-                switch(fpclassify(score)) {
-                case FP_NORMAL:
-                case FP_ZERO:
-                case FP_SUBNORMAL:
-                    fprintf(outfile, "      \"%s\": %.6f",
-                            pool_method_name[j], score);
-                    break;
-                case FP_INFINITE:
-                case FP_NAN:
-                    fprintf(outfile, "      \"%s\": null",
-                            pool_method_name[j]);
-                    break;
-                }
+                output_buffer_str(ob, j > 1 ? ",\n" : "\n");
+                output_buffer_printf(ob, "      \"%s\": ", pool_method_name[j]);
+                output_buffer_json_score(ob, score);
             }
         }
-        fprintf(outfile, "\n");
-        fprintf(outfile, "    }");
+        output_buffer_str(ob, "\n");
+        output_buffer_str(ob, "    }");
     }
-    fprintf(outfile, "\n  },\n");
+    output_buffer_str(ob, "\n  },\n");
 
-    fprintf(outfile, "  \"aggregate_metrics\": {");
+    output_buffer_str(ob, "  \"aggregate_metrics\": {");
     for (unsigned i = 0; i < fc->aggregate_vector.cnt; i++) {
-        switch(fpclassify(fc->aggregate_vector.metric[i].value)) {
-        case FP_NORMAL:
-        case FP_ZERO:
-        case FP_SUBNORMAL:
-            fprintf(outfile, "\n    \"%s\": %.6f",
-                    fc->aggregate_vector.metric[i].name,
-                    fc->aggregate_vector.metric[i].value);
-            break;
-        case FP_INFINITE:
-        case FP_NAN:
-            fprintf(outfile, "\n    \"%s\": null",
-                    fc->aggregate_vector.metric[i].name);
-            break;
-        }
-        fprintf(outfile, "%s", i < fc->aggregate_vector.cnt - 1 ? "," : "");
+        output_buffer_printf(ob, "\n    \"%s\": ",
+                             fc->aggregate_vector.metric[i].name);
+        output_buffer_json_score(ob, fc->aggregate_vector.metric[i].value);
+        output_buffer_str(ob, i < fc->aggregate_vector.cnt - 1 ? "," : "");
     }
-    fprintf(outfile, "\n  }\n");
-    fprintf(outfile, "}\n");
-    
-    return 0;
+    output_buffer_str(ob, "\n  }\n");
+    output_buffer_str(ob, "}\n");
+
+    frame_row_destroy(&row);
+    return output_buffer_close(ob);
+}
+
+static void write_csv_header(OutputBuffer *ob, FrameRow *row)
+{
+    output_buffer_str(ob, "Frame,");
+    for (unsigned i = 0; i < row->cnt; i++) {
+        output_buffer_str(ob, vmaf_feature_name_alias(row->fv[i]->name));
+        output_buffer_str(ob, ",");
+    }
+    output_buffer_str(ob, "\n");
+}
+
+static void write_csv_frame(OutputBuffer *ob, FrameRow *row, unsigned index)
+{
+    output_buffer_uint(ob, index);
+    output_buffer_str(ob, ",");
+    for (unsigned j = 0; j < row->cnt; j++) {
+        if (!row->written[j]) continue;
+        output_buffer_score(ob, row->score[j]);
+        output_buffer_str(ob, ",");
+    }
+    output_buffer_str(ob, "\n");
+}
+
+static void write_sub_frame(OutputBuffer *ob, FrameRow *row, unsigned index)
+{
+    output_buffer_str(ob, "{");
+    output_buffer_uint(ob, index);
+    output_buffer_str(ob, "}{");
+    output_buffer_uint(ob, index + 1);
+    output_buffer_str(ob, "}frame: ");
+    output_buffer_uint(ob, index);
+    output_buffer_str(ob, "|");
+    for (unsigned j = 0; j < row->cnt; j++) {
+        if (!row->written[j]) continue;
+        output_buffer_str(ob, vmaf_feature_name_alias(row->fv[j]->name));
+        output_buffer_str(ob, ": ");
+        output_buffer_score(ob, row->score[j]);
+        output_buffer_str(ob, "|");
+    }
+    output_buffer_str(ob, "\n");
 }
 
 int vmaf_write_output_csv(VmafFeatureCollector *fc, FILE *outfile,
                            unsigned subsample)
 {
+    FrameRow row;
+    int err = frame_row_init(&row, fc);
+    if (err) return err;
+    OutputBuffer *ob = output_buffer_open(outfile);
+    if (!ob) {
+        frame_row_destroy(&row);
+        return -ENOMEM;
+    }
+
+    write_csv_header(ob, &row);
+
+    const unsigned capacity = max_capacity(fc);
+    for (unsigned i = 0 ; i < capacity; i++) {
+        if ((subsample > 1) && (i % subsample))
+            continue;
+        if (!frame_scores(&row, i)) continue;
+        write_csv_frame(ob, &row, i);
+    }
+
+    frame_row_destroy(&row);
+    return output_buffer_close(ob);
+}
+
+int vmaf_write_output_sub(VmafFeatureCollector *fc, FILE *outfile,
+                          unsigned subsample)
+{
+    FrameRow row;
+    int err = frame_row_init(&row, fc);
+    if (err) return err;
+    OutputBuffer *ob = output_buffer_open(outfile);
+    if (!ob) {
+        frame_row_destroy(&row);
+        return -ENOMEM;
+    }
 
-    fprintf(outfile, "Frame,");
-    for (unsigned i = 0; i < fc->cnt; i++) {
-        fprintf(outfile, "%s,",
-                vmaf_feature_name_alias(fc->feature_vector[i]->name));
+    const unsigned capacity = max_capacity(fc);
+    for (unsigned i = 0 ; i < capacity; i++) {
+        if ((subsample > 1) && (i % subsample))
+            continue;
+        if (!frame_scores(&row, i)) continue;
+        write_sub_frame(ob, &row, i);
     }
-    fprintf(outfile, "\n");
 
-    for (unsigned i = 0 ; i < max_capacity(fc); i++) {
+    frame_row_destroy(&row);
+    return output_buffer_close(ob);
+}
+
+static void output_buffer_u32(OutputBuffer *ob, uint32_t value)
+{
+    uint8_t le[4];
+    for (unsigned i = 0; i < 4; i++)
+        le[i] = value >> (8 * i);
+    output_buffer_write(ob, le, sizeof(le));
+}
+
+static void output_buffer_f64(OutputBuffer *ob, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint8_t le[8];
+    for (unsigned i = 0; i < 8; i++)
+        le[i] = bits >> (8 * i);
+    output_buffer_write(ob, le, sizeof(le));
+}
+
+int vmaf_write_output_bin(VmafContext *vmaf, VmafFeatureCollector *fc,
+                          FILE *outfile, unsigned subsample, unsigned pic_cnt)
+{
+    if (!vmaf) return -EINVAL;
+    if (!fc) return -EINVAL;
+    if (!outfile) return -EINVAL;
+
+    FrameRow row;
+    int err = frame_row_init(&row, fc);
+    if (err) return err;
+    OutputBuffer *ob = output_buffer_open(outfile);
+    if (!ob) {
+        frame_row_destroy(&row);
+        return -ENOMEM;
+    }
+
+    // the frames which have any score, as in the text formats
+    const unsigned capacity = max_capacity(fc);
+    unsigned *frame = malloc(sizeof(*frame) * (capacity + 1));
+    if (!frame) {
+        frame_row_destroy(&row);
+        output_buffer_close(ob);
+        return -ENOMEM;
+    }
+    unsigned n_frames = 0;
+    for (unsigned i = 0; i < capacity; i++) {
         if ((subsample > 1) && (i % subsample))
             continue;
+        if (frame_scores(&row, i))
+            frame[n_frames++] = i;
+    }
+
+    output_buffer_write(ob, VMAF_OUTPUT_BIN_MAGIC, 8);
+    output_buffer_u32(ob, VMAF_OUTPUT_BIN_VERSION);
+    output_buffer_u32(ob, row.cnt);
+    output_buffer_u32(ob, n_frames);
+    output_buffer_u32(ob, VMAF_POOL_METHOD_NB - 1);
+
+    for (unsigned j = 0; j < row.cnt; j++) {
+        const char *name = vmaf_feature_name_alias(row.fv[j]->name);
+        output_buffer_u32(ob, strlen(name));
+        output_buffer_str(ob, name);
+    }
+
+    for (unsigned i = 0; i < n_frames; i++)
+        output_buffer_u32(ob, frame[i]);
 
-        unsigned cnt = 0;
-        for (unsigned j = 0; j < fc->cnt; j++) {
-            if (i > fc->feature_vector[j]->capacity)
-                continue;
-            if (fc->feature_vector[j]->score[i].written)
-                cnt++;
+    for (unsigned j = 0; j < row.cnt; j++) {
+        for (unsigned i = 0; i < n_frames; i++) {
+            double score;
+            const bool written =
+                feature_vector_get_score(row.fv[j], frame[i], &score);
+            output_buffer_f64(ob, written ? score : NAN);
         }
-        if (!cnt) continue;
+    }
 
-        fprintf(outfile, "%d,", i);
-        for (unsigned j = 0; j < fc->cnt; j++) {
-            if (i > fc->feature_vector[j]->capacity)
-                continue;
-            if (!fc->feature_vector[j]->score[i].written)
-                continue;
-            fprintf(outfile, "%.6f,", fc->feature_vector[j]->score[i].value);
+    for (unsigned j = 0; j < row.cnt; j++) {
+        for (unsigned k = 1; k < VMAF_POOL_METHOD_NB; k++) {
+            double score;
+            int err = vmaf_feature_score_pooled(vmaf, row.fv[j]->name, k,
+                                                &score, 0, pic_cnt - 1);
+            output_buffer_f64(ob, err ? NAN : score);
         }
-        fprintf(outfile, "\n");
     }
 
+    free(frame);
+    frame_row_destroy(&row);
+    return output_buffer_close(ob);
+}
+
+struct VmafOutputStream {
+    pthread_mutex_t lock;
+    FILE *outfile;
+    OutputBuffer *ob;
+    enum VmafOutputFormat fmt;
+    unsigned subsample;
+    VmafFeatureCollector *fc;
+    // columns are fixed by the features present at the first written frame
+    FrameRow row;
+    bool row_init;
+    // lowest index not written yet, and a ring of the completed indices
+    // from there on, index i at bit i % (64 * complete_sz)
+    unsigned next;
+    uint64_t *complete;
+    unsigned complete_sz;
+};
+
+int vmaf_output_stream_open(VmafOutputStream **stream, const char *output_path,
+                            enum VmafOutputFormat fmt, unsigned subsample,
+                            VmafFeatureCollector *fc)
+{
+    if (!stream) return -EINVAL;
+    if (!output_path) return -EINVAL;
+    if (!fc) return -EINVAL;
+    if (fmt != VMAF_OUTPUT_FORMAT_CSV && fmt != VMAF_OUTPUT_FORMAT_SUB)
+        return -EINVAL;
+
+    VmafOutputStream *const s = *stream = malloc(sizeof(*s));
+    if (!s) goto fail;
+    memset(s, 0, sizeof(*s));
+    s->fmt = fmt;
+    s->subsample = subsample;
+    s->fc = fc;
+
+    s->outfile = fopen(output_path, "w");
+    if (!s->outfile) goto free_s;
+    s->ob = output_buffer_open(s->outfile);
+    if (!s->ob) goto close_outfile;
+    pthread_mutex_init(&(s->lock), NULL);
     return 0;
+
+close_outfile:
+    fclose(s->outfile);
+free_s:
+    free(s);
+fail:
+    *stream = NULL;
+    return -ENOMEM;
 }
 
-int vmaf_write_output_sub(VmafFeatureCollector *fc, FILE *outfile,
-                          unsigned subsample)
+static void stream_write_frame(VmafOutputStream *s, unsigned index)
 {
-    for (unsigned i = 0 ; i < max_capacity(fc); i++) {
-        if ((subsample > 1) && (i % subsample))
-            continue;
+    if ((s->subsample > 1) && (index % s->subsample))
+        return;
 
-        unsigned cnt = 0;
-        for (unsigned j = 0; j < fc->cnt; j++) {
-            if (i > fc->feature_vector[j]->capacity)
-                continue;
-            if (fc->feature_vector[j]->score[i].written)
-                cnt++;
+    if (!s->row_init) {
+        if (frame_row_init(&s->row, s->fc)) {
+            s->ob->err = -ENOMEM;
+            return;
         }
-        if (!cnt) continue;
+        s->row_init = true;
+        if (s->fmt == VMAF_OUTPUT_FORMAT_CSV)
+            write_csv_header(s->ob, &s->row);
+    }
 
-        fprintf(outfile, "{%d}{%d}frame: %d|", i, i + 1, i);
-        for (unsigned j = 0; j < fc->cnt; j++) {
-            if (i > fc->feature_vector[j]->capacity)
-                continue;
-            if (!fc->feature_vector[j]->score[i].written)
-                continue;
-            fprintf(outfile, "%s: %.6f|",
-                    vmaf_feature_name_alias(fc->feature_vector[j]->name),
-                    fc->feature_vector[j]->score[i].value);
-        }
-        fprintf(outfile, "\n");
+    if (!frame_scores(&s->row, index)) return;
+
+    if (s->fmt == VMAF_OUTPUT_FORMAT_CSV)
+        write_csv_frame(s->ob, &s->row, index);
+    else
+        write_sub_frame(s->ob, &s->row, index);
+}
+
+static bool stream_is_complete(VmafOutputStream *s, unsigned index)
+{
+    if (!s->complete_sz) return false;
+    const unsigned bit = index % (64 * s->complete_sz);
+    return index - s->next < 64 * s->complete_sz &&
+           s->complete[bit / 64] & (1ull << (bit % 64));
+}
+
+static void stream_clear(VmafOutputStream *s, unsigned index)
+{
+    const unsigned bit = index % (64 * s->complete_sz);
+    s->complete[bit / 64] &= ~(1ull << (bit % 64));
+}
+
+static void stream_write_complete(VmafOutputStream *s)
+{
+    while (stream_is_complete(s, s->next)) {
+        stream_clear(s, s->next);
+        stream_write_frame(s, s->next++);
     }
+}
+
+// write the completed indices below index, and move on past the others
+static void stream_skip(VmafOutputStream *s, unsigned index)
+{
+    if (index <= s->next) return;
+
+    // only the ring can hold completed indices
+    const unsigned cap = 64 * s->complete_sz;
+    const unsigned end = index - s->next < cap ? index : s->next + cap;
+    for (unsigned i = s->next; i < end; i++) {
+        if (!stream_is_complete(s, i)) continue;
+        stream_clear(s, i);
+        stream_write_frame(s, i);
+    }
+    s->next = index;
+    stream_write_complete(s);
+}
 
+/*
+ * Make room in the ring for index, which is at least s->next. The ring
+ * covers the score window of the collector: an index completing further
+ * ahead gives up on those a window behind it, whose scores are released by
+ * then. Without a score window, the ring grows.
+ */
+static int stream_reserve(VmafOutputStream *s, unsigned index)
+{
+    const unsigned capacity = s->fc->stream.capacity;
+    unsigned sz = s->complete_sz ? s->complete_sz : 1;
+    while (64 * sz < capacity)
+        sz <<= 1;
+    if (capacity && index - s->next >= 64 * sz)
+        stream_skip(s, index - 64 * sz + 1);
+    while (index - s->next >= 64 * sz) {
+        if (sz >= 1u << 25) return -ENOMEM;
+        sz <<= 1;
+    }
+    if (sz == s->complete_sz) return 0;
+
+    uint64_t *const complete = calloc(sz, sizeof(*complete));
+    if (!complete) return -ENOMEM;
+    for (unsigned i = s->next; i - s->next < 64 * s->complete_sz; i++) {
+        if (!stream_is_complete(s, i)) continue;
+        const unsigned bit = i % (64 * sz);
+        complete[bit / 64] |= 1ull << (bit % 64);
+    }
+    free(s->complete);
+    s->complete = complete;
+    s->complete_sz = sz;
     return 0;
 }
+
+int vmaf_output_stream_frame(VmafOutputStream *stream, unsigned index)
+{
+    if (!stream) return -EINVAL;
+
+    int err = 0;
+    pthread_mutex_lock(&(stream->lock));
+
+    // indices below next were skipped, see stream_skip()
+    if (index < stream->next) goto unlock;
+
+    err = stream_reserve(stream, index);
+    if (err) goto unlock;
+    const unsigned bit = index % (64 * stream->complete_sz);
+    stream->complete[bit / 64] |= 1ull << (bit % 64);
+
+    stream_write_complete(stream);
+    err = stream->ob->err;
+
+unlock:
+    pthread_mutex_unlock(&(stream->lock));
+    return err;
+}
+
+int vmaf_output_stream_skip(VmafOutputStream *stream, unsigned index)
+{
+    if (!stream) return -EINVAL;
+
+    pthread_mutex_lock(&(stream->lock));
+    stream_skip(stream, index);
+    const int err = stream->ob->err;
+    pthread_mutex_unlock(&(stream->lock));
+    return err;
+}
+
+int vmaf_output_stream_close(VmafOutputStream *stream)
+{
+    if (!stream) return -EINVAL;
+
+    // indices which were never read leave gaps, write what lies beyond
+    for (unsigned i = 0; i < 64 * stream->complete_sz; i++) {
+        if (stream_is_complete(stream, stream->next + i))
+            stream_write_frame(stream, stream->next + i);
+    }
+
+    int err = output_buffer_close(stream->ob);
+    if (fclose(stream->outfile)) err = -EIO;
+    if (stream->row_init) frame_row_destroy(&stream->row);
+    free(stream->complete);
+    pthread_mutex_destroy(&(stream->lock));
+    free(stream);
+    return err;
+}
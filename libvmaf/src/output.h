@@ -19,6 +19,9 @@
 #ifndef __VMAF_OUTPUT_H__
 #define __VMAF_OUTPUT_H__
 
+#define VMAF_OUTPUT_BIN_MAGIC "VMAFBIN\0"
+#define VMAF_OUTPUT_BIN_VERSION 1
+
 int vmaf_write_output_xml(VmafContext *vmaf, VmafFeatureCollector *fc, FILE *outfile,
                           unsigned subsample, unsigned width, unsigned height,
                           double fps, unsigned pic_cnt);
@@ -33,4 +36,28 @@ int vmaf_write_output_csv(VmafFeatureCollector *fc, FILE *outfile,
 int vmaf_write_output_sub(VmafFeatureCollector *fc, FILE *outfile,
                           unsigned subsample);
 
+int vmaf_write_output_bin(VmafContext *vmaf, VmafFeatureCollector *fc,
+                          FILE *outfile, unsigned subsample, unsigned pic_cnt);
+
+/**
+ * Writes the frames of the line-oriented formats, CSV and SUB, while they
+ * complete. Frames are written in index order, each once all lower indices
+ * have completed; closing writes the rest.
+ */
+typedef struct VmafOutputStream VmafOutputStream;
+
+int vmaf_output_stream_open(VmafOutputStream **stream, const char *output_path,
+                            enum VmafOutputFormat fmt, unsigned subsample,
+                            VmafFeatureCollector *fc);
+
+int vmaf_output_stream_frame(VmafOutputStream *stream, unsigned index);
+
+/**
+ * Give up on the indices below index which have not completed, as their
+ * scores are about to be released, and write the completed ones.
+ */
+int vmaf_output_stream_skip(VmafOutputStream *stream, unsigned index);
+
+int vmaf_output_stream_close(VmafOutputStream *stream);
+
 #endif /* __VMAF_OUTPUT_H__ */
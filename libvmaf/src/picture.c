@@ -17,23 +17,22 @@
  */
 
 #include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "mem.h"
 #include "picture.h"
+#include "picture_cache.h"
 #include "ref.h"
 
 #define DATA_ALIGN 32
 
-int vmaf_picture_alloc(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
-                       unsigned bpc, unsigned w, unsigned h)
+static void picture_geometry(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
+                             unsigned bpc, unsigned w, unsigned h)
 {
-    if (!pic) return -EINVAL;
-    if (!pix_fmt) return -EINVAL;
-    if (bpc < 8 || bpc > 16) return -EINVAL;
-
     memset(pic, 0, sizeof(*pic));
     pic->pix_fmt = pix_fmt;
     pic->bpc = bpc;
@@ -45,6 +44,16 @@ int vmaf_picture_alloc(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
     pic->h[1] = pic->h[2] = h >> ss_ver;
     if (pic->pix_fmt == VMAF_PIX_FMT_YUV400P)
         pic->w[1] = pic->w[2] = pic->h[1] = pic->h[2] = 0;
+}
+
+int vmaf_picture_alloc(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
+                       unsigned bpc, unsigned w, unsigned h)
+{
+    if (!pic) return -EINVAL;
+    if (!pix_fmt) return -EINVAL;
+    if (bpc < 8 || bpc > 16) return -EINVAL;
+
+    picture_geometry(pic, pix_fmt, bpc, w, h);
 
     const int aligned_y = (pic->w[0] + DATA_ALIGN - 1) & ~(DATA_ALIGN - 1);
     const int aligned_c = (pic->w[1] + DATA_ALIGN - 1) & ~(DATA_ALIGN - 1);
@@ -75,6 +84,82 @@ fail:
     return -ENOMEM;
 }
 
+typedef struct VmafPictureWrap {
+    VmafPictureReleaseCallback release;
+    void *cookie;
+} VmafPictureWrap;
+
+static void wrap_release(VmafPicture *pic, void *cookie)
+{
+    VmafPictureWrap *wrap = cookie;
+    VmafRef *ref = pic->ref;
+    if (wrap->release) wrap->release(pic, wrap->cookie);
+    free(wrap);
+    vmaf_ref_close(ref);
+}
+
+int vmaf_picture_wrap(VmafPicture *pic, enum VmafPixelFormat pix_fmt,
+                      unsigned bpc, unsigned w, unsigned h,
+                      void *const data[3], const ptrdiff_t stride[3],
+                      VmafPictureReleaseCallback release, void *cookie)
+{
+    if (!pic) return -EINVAL;
+    if (!pix_fmt) return -EINVAL;
+    if (bpc < 8 || bpc > 16) return -EINVAL;
+    if (!data || !stride) return -EINVAL;
+
+    VmafPicture wrapped;
+    picture_geometry(&wrapped, pix_fmt, bpc, w, h);
+
+    const int hbd = bpc > 8;
+    const unsigned plane_cnt = pix_fmt == VMAF_PIX_FMT_YUV400P ? 1 : 3;
+    bool aligned = true;
+    for (unsigned i = 0; i < plane_cnt; i++) {
+        if (!data[i]) return -EINVAL;
+        if (stride[i] < (ptrdiff_t) (wrapped.w[i] << hbd)) return -EINVAL;
+        wrapped.data[i] = data[i];
+        wrapped.stride[i] = stride[i];
+        // same layout as vmaf_picture_alloc(), which the SIMD paths rely on
+        const ptrdiff_t aligned_w =
+            (wrapped.w[i] + DATA_ALIGN - 1) & ~(DATA_ALIGN - 1);
+        aligned &= !((uintptr_t) data[i] % DATA_ALIGN) &&
+                   !(stride[i] % DATA_ALIGN) &&
+                   stride[i] >= aligned_w << hbd;
+    }
+
+    if (!aligned) {
+        int err = vmaf_picture_alloc(pic, pix_fmt, bpc, w, h);
+        if (err) return err;
+        for (unsigned i = 0; i < plane_cnt; i++) {
+            uint8_t *src = wrapped.data[i];
+            uint8_t *dst = pic->data[i];
+            for (unsigned j = 0; j < wrapped.h[i]; j++) {
+                memcpy(dst, src, wrapped.w[i] << hbd);
+                src += wrapped.stride[i];
+                dst += pic->stride[i];
+            }
+        }
+        if (release) release(&wrapped, cookie);
+        return 0;
+    }
+
+    VmafPictureWrap *const wrap = malloc(sizeof(*wrap));
+    if (!wrap) return -ENOMEM;
+    wrap->release = release;
+    wrap->cookie = cookie;
+
+    int err = vmaf_ref_init(&wrapped.ref);
+    if (err) {
+        free(wrap);
+        return err;
+    }
+    wrapped.ref->release = wrap_release;
+    wrapped.ref->cookie = wrap;
+
+    memcpy(pic, &wrapped, sizeof(*pic));
+    return 0;
+}
+
 int vmaf_picture_ref(VmafPicture *dst, VmafPicture *src) {
     if (!dst || !src) return -EINVAL;
 
@@ -87,11 +172,165 @@ int vmaf_picture_unref(VmafPicture *pic) {
     if (!pic) return -EINVAL;
     if (!pic->ref) return -EINVAL;
 
-    vmaf_ref_fetch_decrement(pic->ref);
-    if (vmaf_ref_load(pic->ref) == 0) {
-        aligned_free(pic->data[0]);
-        vmaf_ref_close(pic->ref);
+    // the caller dropping the last reference is the one to free it
+    if (vmaf_ref_fetch_decrement(pic->ref) == 1) {
+        vmaf_picture_cache_release(pic->ref);
+        if (pic->ref->release) {
+            pic->ref->release(pic, pic->ref->cookie);
+        } else {
+            aligned_free(pic->data[0]);
+            vmaf_ref_close(pic->ref);
+        }
     }
     memset(pic, 0, sizeof(*pic));
     return 0;
 }
+
+typedef struct VmafPicturePool {
+    pthread_mutex_t lock;
+    pthread_cond_t available;
+    VmafPicture *pic;
+    unsigned pic_cnt;
+    unsigned *free;
+    unsigned free_cnt;
+    unsigned waiter_cnt;
+    bool closed;
+} VmafPicturePool;
+
+static void pool_free(VmafPicturePool *pool)
+{
+    for (unsigned i = 0; i < pool->pic_cnt; i++) {
+        if (!pool->pic[i].ref) continue;
+        aligned_free(pool->pic[i].data[0]);
+        vmaf_ref_close(pool->pic[i].ref);
+    }
+    pthread_cond_destroy(&(pool->available));
+    pthread_mutex_destroy(&(pool->lock));
+    free(pool->free);
+    free(pool->pic);
+    free(pool);
+}
+
+static void pool_release(VmafPicture *pic, void *cookie)
+{
+    VmafPicturePool *pool = cookie;
+
+    pthread_mutex_lock(&(pool->lock));
+    unsigned i = 0;
+    while (pool->pic[i].ref != pic->ref)
+        i++;
+    pool->free[pool->free_cnt++] = i;
+    const bool done = pool->closed && pool->free_cnt == pool->pic_cnt &&
+                      !pool->waiter_cnt;
+    pthread_cond_signal(&(pool->available));
+    pthread_mutex_unlock(&(pool->lock));
+
+    // the last picture returned to a closed pool takes it down
+    if (done) pool_free(pool);
+}
+
+int vmaf_picture_pool_init(VmafPicturePool **pool,
+                           enum VmafPixelFormat pix_fmt, unsigned bpc,
+                           unsigned w, unsigned h, unsigned pic_cnt)
+{
+    if (!pool) return -EINVAL;
+    if (!pic_cnt) return -EINVAL;
+
+    VmafPicturePool *const p = *pool = malloc(sizeof(*p));
+    if (!p) goto fail;
+    memset(p, 0, sizeof(*p));
+    p->pic = malloc(sizeof(*p->pic) * pic_cnt);
+    if (!p->pic) goto free_p;
+    memset(p->pic, 0, sizeof(*p->pic) * pic_cnt);
+    p->free = malloc(sizeof(*p->free) * pic_cnt);
+    if (!p->free) goto free_pic;
+    pthread_mutex_init(&(p->lock), NULL);
+    pthread_cond_init(&(p->available), NULL);
+    p->pic_cnt = pic_cnt;
+
+    for (unsigned i = 0; i < pic_cnt; i++) {
+        int err = vmaf_picture_alloc(&p->pic[i], pix_fmt, bpc, w, h);
+        if (err) {
+            pool_free(p);
+            *pool = NULL;
+            return err;
+        }
+        p->pic[i].ref->release = pool_release;
+        p->pic[i].ref->cookie = p;
+        // handed out with a count of zero, see vmaf_picture_pool_get()
+        vmaf_ref_fetch_decrement(p->pic[i].ref);
+        p->free[p->free_cnt++] = i;
+    }
+
+    return 0;
+
+free_pic:
+    free(p->pic);
+free_p:
+    free(p);
+    *pool = NULL;
+fail:
+    return -ENOMEM;
+}
+
+static int pool_get(VmafPicturePool *pool, VmafPicture *pic, bool wait)
+{
+    if (!pool) return -EINVAL;
+    if (!pic) return -EINVAL;
+
+    pthread_mutex_lock(&(pool->lock));
+    if (pool->closed) {
+        pthread_mutex_unlock(&(pool->lock));
+        return -EINVAL;
+    }
+    if (!wait && !pool->free_cnt) {
+        pthread_mutex_unlock(&(pool->lock));
+        return -EAGAIN;
+    }
+    while (!pool->free_cnt && !pool->closed) {
+        pool->waiter_cnt++;
+        pthread_cond_wait(&(pool->available), &(pool->lock));
+        pool->waiter_cnt--;
+    }
+    if (pool->closed) {
+        // the last waiter woken by vmaf_picture_pool_close() may be the one
+        // to take the pool down
+        const bool done = pool->free_cnt == pool->pic_cnt &&
+                          !pool->waiter_cnt;
+        pthread_mutex_unlock(&(pool->lock));
+        if (done) pool_free(pool);
+        return -EINVAL;
+    }
+    const unsigned i = pool->free[--pool->free_cnt];
+    pthread_mutex_unlock(&(pool->lock));
+
+    memcpy(pic, &pool->pic[i], sizeof(*pic));
+    vmaf_ref_fetch_increment(pic->ref);
+    return 0;
+}
+
+int vmaf_picture_pool_get(VmafPicturePool *pool, VmafPicture *pic)
+{
+    return pool_get(pool, pic, true);
+}
+
+int vmaf_picture_pool_try_get(VmafPicturePool *pool, VmafPicture *pic)
+{
+    return pool_get(pool, pic, false);
+}
+
+int vmaf_picture_pool_close(VmafPicturePool *pool)
+{
+    if (!pool) return -EINVAL;
+
+    pthread_mutex_lock(&(pool->lock));
+    pool->closed = true;
+    pthread_cond_broadcast(&(pool->available));
+    const bool done = pool->free_cnt == pool->pic_cnt && !pool->waiter_cnt;
+    pthread_mutex_unlock(&(pool->lock));
+
+    // pictures still in flight and waiters keep the pool alive, see
+    // pool_release() and pool_get()
+    if (done) pool_free(pool);
+    return 0;
+}
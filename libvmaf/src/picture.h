@@ -23,4 +23,10 @@
 
 int vmaf_picture_ref(VmafPicture *dst, VmafPicture *src);
 
+/**
+ * Like vmaf_picture_pool_get(), but returns -EAGAIN instead of waiting when
+ * all the pictures of the pool are in use.
+ */
+int vmaf_picture_pool_try_get(VmafPicturePool *pool, VmafPicture *pic);
+
 #endif /* __VMAF_SRC_PICTURE_H__ */
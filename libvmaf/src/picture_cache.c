@@ -0,0 +1,252 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem.h"
+#include "picture.h"
+#include "picture_cache.h"
+#include "ref.h"
+
+typedef struct VmafPictureCacheEntry {
+    enum VmafPictureCacheKind kind;
+    int param;
+    size_t sz;
+    void *data;
+    bool done;
+    pthread_mutex_t lock;
+    struct VmafPictureCacheEntry *next;
+} VmafPictureCacheEntry;
+
+typedef struct VmafPictureCacheFrame {
+    pthread_mutex_t lock;
+    VmafPictureCacheEntry *entry;
+    VmafPictureCache *cache;
+    atomic_bool shared;
+} VmafPictureCacheFrame;
+
+typedef struct VmafPictureCache {
+    pthread_mutex_t lock;
+    atomic_int ref_cnt;
+    VmafPictureCacheEntry *free;
+} VmafPictureCache;
+
+int vmaf_picture_cache_init(VmafPictureCache **cache)
+{
+    if (!cache) return -EINVAL;
+
+    VmafPictureCache *const c = *cache = malloc(sizeof(*c));
+    if (!c) return -ENOMEM;
+    memset(c, 0, sizeof(*c));
+    pthread_mutex_init(&(c->lock), NULL);
+    atomic_init(&c->ref_cnt, 1);
+    return 0;
+}
+
+static void entry_free(VmafPictureCacheEntry *entry)
+{
+    if (entry->data) aligned_free(entry->data);
+    pthread_mutex_destroy(&(entry->lock));
+    free(entry);
+}
+
+static void cache_unref(VmafPictureCache *cache)
+{
+    if (atomic_fetch_sub(&cache->ref_cnt, 1) != 1) return;
+
+    VmafPictureCacheEntry *entry = cache->free;
+    while (entry) {
+        VmafPictureCacheEntry *next = entry->next;
+        entry_free(entry);
+        entry = next;
+    }
+    pthread_mutex_destroy(&(cache->lock));
+    free(cache);
+}
+
+int vmaf_picture_cache_destroy(VmafPictureCache *cache)
+{
+    if (!cache) return -EINVAL;
+    cache_unref(cache);
+    return 0;
+}
+
+static bool kind_holds_picture(enum VmafPictureCacheKind kind)
+{
+    return kind == VMAF_PICTURE_CACHE_MOTION_BLUR;
+}
+
+static void frame_free(VmafPictureCacheFrame *frame)
+{
+    pthread_mutex_destroy(&(frame->lock));
+    free(frame);
+}
+
+// VmafRef.cache is set up by whoever gets to it first, the others drop
+// theirs and take the winner's
+static VmafPictureCacheFrame *frame_get(VmafRef *ref)
+{
+    VmafPictureCacheFrame *frame = atomic_load(&ref->cache);
+    if (frame) return frame;
+
+    VmafPictureCacheFrame *const f = malloc(sizeof(*f));
+    if (!f) return NULL;
+    memset(f, 0, sizeof(*f));
+    pthread_mutex_init(&(f->lock), NULL);
+    atomic_init(&f->shared, false);
+
+    if (atomic_compare_exchange_strong(&ref->cache, &frame, f))
+        return f;
+    frame_free(f);
+    return frame;
+}
+
+int vmaf_picture_cache_attach(VmafPictureCache *cache, VmafPicture *pic)
+{
+    if (!cache) return -EINVAL;
+    if (!pic) return -EINVAL;
+    if (!pic->ref) return -EINVAL;
+
+    VmafPictureCacheFrame *frame = frame_get(pic->ref);
+    if (!frame) return -ENOMEM;
+
+    pthread_mutex_lock(&(frame->lock));
+    if (!frame->cache) {
+        atomic_fetch_add(&cache->ref_cnt, 1);
+        frame->cache = cache;
+    }
+    pthread_mutex_unlock(&(frame->lock));
+    return 0;
+}
+
+int vmaf_picture_cache_share(VmafPicture *pic)
+{
+    if (!pic) return -EINVAL;
+    if (!pic->ref) return -EINVAL;
+
+    VmafPictureCacheFrame *frame = frame_get(pic->ref);
+    if (!frame) return -ENOMEM;
+    atomic_store(&frame->shared, true);
+    return 0;
+}
+
+bool vmaf_picture_cache_shared(VmafPicture *pic)
+{
+    if (!pic || !pic->ref) return false;
+
+    VmafPictureCacheFrame *frame = atomic_load(&pic->ref->cache);
+    return frame && atomic_load(&frame->shared);
+}
+
+static VmafPictureCacheEntry *entry_get(VmafPictureCacheFrame *frame,
+                                        enum VmafPictureCacheKind kind,
+                                        int param, size_t sz)
+{
+    VmafPictureCacheEntry *entry;
+    for (entry = frame->entry; entry; entry = entry->next) {
+        if (entry->kind == kind && entry->param == param && entry->sz == sz)
+            return entry;
+    }
+
+    VmafPictureCache *cache = frame->cache;
+    if (cache) {
+        pthread_mutex_lock(&(cache->lock));
+        VmafPictureCacheEntry **e = &cache->free;
+        while (*e && (*e)->sz != sz)
+            e = &(*e)->next;
+        if ((entry = *e))
+            *e = entry->next;
+        pthread_mutex_unlock(&(cache->lock));
+    }
+
+    if (!entry) {
+        entry = malloc(sizeof(*entry));
+        if (!entry) return NULL;
+        memset(entry, 0, sizeof(*entry));
+        pthread_mutex_init(&(entry->lock), NULL);
+        entry->sz = sz;
+    }
+
+    entry->kind = kind;
+    entry->param = param;
+    entry->done = false;
+    entry->next = frame->entry;
+    frame->entry = entry;
+    return entry;
+}
+
+const void *vmaf_picture_cache_get(VmafPicture *pic,
+                                   enum VmafPictureCacheKind kind, int param,
+                                   size_t sz, VmafPictureCacheFill fill,
+                                   void *cookie)
+{
+    if (!pic) return NULL;
+    if (!pic->ref) return NULL;
+    if (!fill) return NULL;
+
+    VmafPictureCacheFrame *frame = frame_get(pic->ref);
+    if (!frame) return NULL;
+
+    pthread_mutex_lock(&(frame->lock));
+    VmafPictureCacheEntry *entry = entry_get(frame, kind, param, sz);
+    pthread_mutex_unlock(&(frame->lock));
+    if (!entry) return NULL;
+
+    pthread_mutex_lock(&(entry->lock));
+    if (!entry->done) {
+        if (!entry->data)
+            entry->data = aligned_malloc(sz, MAX_ALIGN);
+        if (entry->data)
+            entry->done = !fill(pic, param, entry->data, cookie);
+    }
+    const void *data = entry->done ? entry->data : NULL;
+    pthread_mutex_unlock(&(entry->lock));
+    return data;
+}
+
+void vmaf_picture_cache_release(VmafRef *ref)
+{
+    VmafPictureCacheFrame *frame = atomic_load(&ref->cache);
+    if (!frame) return;
+
+    VmafPictureCache *cache = frame->cache;
+    VmafPictureCacheEntry *entry = frame->entry;
+    while (entry) {
+        VmafPictureCacheEntry *next = entry->next;
+        if (entry->done && kind_holds_picture(entry->kind))
+            vmaf_picture_unref(entry->data);
+        if (cache && entry->data) {
+            pthread_mutex_lock(&(cache->lock));
+            entry->next = cache->free;
+            cache->free = entry;
+            pthread_mutex_unlock(&(cache->lock));
+        } else {
+            entry_free(entry);
+        }
+        entry = next;
+    }
+
+    if (cache) cache_unref(cache);
+    frame_free(frame);
+    atomic_store(&ref->cache, NULL);
+}
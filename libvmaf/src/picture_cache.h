@@ -0,0 +1,103 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_SRC_PICTURE_CACHE_H__
+#define __VMAF_SRC_PICTURE_CACHE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "libvmaf/picture.h"
+#include "ref.h"
+
+/**
+ * Kinds of data derived from a VmafPicture. Together with an integer
+ * parameter, a kind identifies one cache entry of a picture.
+ */
+enum VmafPictureCacheKind {
+    VMAF_PICTURE_CACHE_FLOAT_LUMA, ///< param: offset, see picture_copy()
+    VMAF_PICTURE_CACHE_MOTION_BLUR, ///< a VmafPicture, see integer_motion.c
+    VMAF_PICTURE_CACHE_CAMBI_SOURCE, ///< see cambi.c
+    VMAF_PICTURE_CACHE_ADM_REF_DWT, ///< see integer_adm.c
+};
+
+/**
+ * Fill callback of a cache entry, writes the derived data of pic to data.
+ * Entries of a kind holding a VmafPicture own a reference to it, which is
+ * dropped with the entry.
+ *
+ * @return 0 on success, or < 0 (a negative errno code) on error, in which
+ *         case the next caller fills the entry again.
+ */
+typedef int (*VmafPictureCacheFill)(VmafPicture *pic, int param, void *data,
+                                    void *cookie);
+
+/**
+ * Recycles the buffers of cache entries between pictures. Shared by all
+ * pictures attached to it, which keep it alive until they are released.
+ */
+typedef struct VmafPictureCache VmafPictureCache;
+
+int vmaf_picture_cache_init(VmafPictureCache **cache);
+
+/**
+ * Let the cache entries of pic draw their buffers from cache, and return
+ * them there when pic is released.
+ */
+int vmaf_picture_cache_attach(VmafPictureCache *cache, VmafPicture *pic);
+
+int vmaf_picture_cache_destroy(VmafPictureCache *cache);
+
+/**
+ * Mark pic as read by several contexts, see vmaf_read_pictures_multi().
+ * Some derived data is only worth caching for such pictures, as computing
+ * it as part of the extraction is cheaper for a single reader.
+ */
+int vmaf_picture_cache_share(VmafPicture *pic);
+
+/**
+ * Whether pic was marked with vmaf_picture_cache_share().
+ */
+bool vmaf_picture_cache_shared(VmafPicture *pic);
+
+/**
+ * Derived data of pic. The first caller for a (kind, param) pair computes
+ * it with fill, concurrent callers wait for it, later callers get it
+ * right away. The data stays valid while a reference to pic is held.
+ *
+ * @param   pic  Source VmafPicture.
+ * @param  kind  Kind of derived data.
+ * @param param  Parameter of the kind.
+ * @param    sz  Size of the derived data in bytes.
+ * @param  fill  Callback computing the derived data.
+ * @param cookie Passed on to fill.
+ *
+ * @return the derived data, or NULL if it could not be allocated or fill
+ *         failed.
+ */
+const void *vmaf_picture_cache_get(VmafPicture *pic,
+                                   enum VmafPictureCacheKind kind, int param,
+                                   size_t sz, VmafPictureCacheFill fill,
+                                   void *cookie);
+
+/**
+ * Release the cache entries of a picture, once its last reference is gone.
+ */
+void vmaf_picture_cache_release(VmafRef *ref);
+
+#endif /* __VMAF_SRC_PICTURE_CACHE_H__ */
@@ -18,10 +18,12 @@
 
 #include <errno.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "cpu.h"
 #include "dict.h"
 #include "feature/alias.h"
 #include "feature/feature_collector.h"
@@ -32,6 +34,15 @@
 #include "predict.h"
 #include "svm.h"
 
+#if ARCH_X86
+#include "x86/svm_avx2.h"
+#if HAVE_AVX512
+#include "x86/svm_avx512.h"
+#endif
+#elif ARCH_AARCH64
+#include "arm/svm_neon.h"
+#endif
+
 static int normalize(const VmafModel *model, double slope, double intercept,
                      double *feature_score)
 {
@@ -223,110 +234,289 @@ static int clip(const VmafModel *model, double *prediction,
     return 0;
 }
 
-int vmaf_predict_score_at_index(VmafModel *model,
-                                VmafFeatureCollector *feature_collector,
-                                unsigned index, double *vmaf_score,
-                                bool write_prediction,
-                                enum VmafModelFlags flags)
+// frames predicted together, see svm_predict_batch()
+#define PREDICT_BATCH_CNT 64
+
+// guards the lazily resolved per-model state used by prediction
+static pthread_mutex_t predict_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int resolve_score_name(VmafModelFeature *feature)
 {
-    if (!model) return -EINVAL;
-    if (!feature_collector) return -EINVAL;
-    if (!vmaf_score) return -EINVAL;
+    VmafFeatureExtractor *fex =
+        vmaf_get_feature_extractor_by_feature_name(feature->name);
 
-    int err = 0;
+    if (!fex) {
+        vmaf_log(VMAF_LOG_LEVEL_ERROR,
+                 "vmaf_predict_scores_range(): no feature extractor "
+                 "providing feature '%s'\n", feature->name);
+        return -EINVAL;
+    }
+
+    VmafDictionary *opts_dict = NULL;
+    if (feature->opts_dict) {
+        int err = vmaf_dictionary_copy(&feature->opts_dict, &opts_dict);
+        if (err) return err;
+    }
 
-    struct svm_node *node = malloc(sizeof(*node) * (model->n_features + 1));
-    if (!node) return -ENOMEM;
+    VmafFeatureExtractorContext *fex_ctx;
+    int err = vmaf_feature_extractor_context_create(&fex_ctx, fex, opts_dict);
+    if (err) {
+        vmaf_log(VMAF_LOG_LEVEL_ERROR,
+                 "vmaf_predict_scores_range(): could not generate "
+                 "feature extractor context\n");
+        vmaf_dictionary_free(&opts_dict);
+        return err;
+    }
+
+    feature->score_name =
+        vmaf_feature_name_from_options(feature->name, fex_ctx->fex->options,
+                                       fex_ctx->fex->priv);
+
+    vmaf_feature_extractor_context_destroy(fex_ctx);
+
+    if (!feature->score_name) {
+        vmaf_log(VMAF_LOG_LEVEL_ERROR,
+                 "vmaf_predict_scores_range(): could not generate "
+                 "feature name\n");
+        return -ENOMEM;
+    }
+
+    return 0;
+}
+
+static int pack_support_vectors(VmafModel *model)
+{
+    double *sv_coef;
+    unsigned dim, stride;
+    int err = vmaf_model_dense_support_vectors(model, &sv_coef, &dim, &stride);
+    if (err) return err;
+
+    model->sv_coef = sv_coef;
+    model->sv = sv_coef + stride;
+    model->sv_dim = dim;
+    model->sv_stride = stride;
+    return 0;
+}
+
+static int predict_init(VmafModel *model)
+{
+    int err = 0;
+    pthread_mutex_lock(&predict_lock);
 
     for (unsigned i = 0; i < model->n_features; i++) {
-        VmafFeatureExtractor *fex =
-            vmaf_get_feature_extractor_by_feature_name(model->feature[i].name);
+        if (model->feature[i].score_name) continue;
+        err = resolve_score_name(&model->feature[i]);
+        if (err) goto unlock;
+    }
 
-        if (!fex) {
-            vmaf_log(VMAF_LOG_LEVEL_ERROR,
-                     "vmaf_predict_score_at_index(): no feature extractor "
-                     "providing feature '%s'\n", model->feature[i].name);
-            err = -EINVAL;
-            goto free_node;
-        }
+    // other kernels and svm types fall back to svm_predict()
+    const struct svm_model *svm = model->svm;
+    if (!model->sv && svm->param.kernel_type == RBF &&
+        (svm->param.svm_type == NU_SVR || svm->param.svm_type == EPSILON_SVR))
+    {
+        err = pack_support_vectors(model);
+    }
 
-        VmafDictionary *opts_dict = NULL;
-        if (model->feature[i].opts_dict) {
-            err = vmaf_dictionary_copy(&model->feature[i].opts_dict, &opts_dict);
-            if (err) return err;
+unlock:
+    pthread_mutex_unlock(&predict_lock);
+    return err;
+}
+
+/*  Kernel sums of the dense RBF kernel for cnt feature vectors x of dim
+    values each: y[c] = sum_i sv_coef[i] * exp(-gamma * |x_c - sv_i|^2).
+    Sums over the support vectors in order, as svm_predict_values() does,
+    so that predictions match it exactly. The SIMD variants match it to
+    within rounding.
+ */
+static void svm_rbf(const double *sv_coef, const double *sv, unsigned dim,
+                    unsigned stride, double gamma, const double *x,
+                    unsigned cnt, double *y)
+{
+    for (unsigned c = 0; c < cnt; c++)
+        y[c] = 0.;
+
+    for (unsigned i = 0; i < stride; i++) {
+        if (!sv_coef[i]) continue;
+        for (unsigned c = 0; c < cnt; c++) {
+            const double *xc = &x[c * dim];
+            double sum = 0.;
+            for (unsigned j = 0; j < dim; j++) {
+                const double d = xc[j] - sv[j * stride + i];
+                sum += d * d;
+            }
+            y[c] += sv_coef[i] * exp(-gamma * sum);
         }
+    }
+}
 
-        VmafFeatureExtractorContext *fex_ctx;
-        err = vmaf_feature_extractor_context_create(&fex_ctx, fex, opts_dict);
-        if (err) {
-            vmaf_log(VMAF_LOG_LEVEL_ERROR,
-                     "vmaf_predict_score_at_index(): could not generate "
-                     "feature extractor context\n");
-            vmaf_dictionary_free(&opts_dict);
-            return err;
+/*  Evaluates the decision function of svm for cnt feature vectors x of
+    sv_dim values each.
+ */
+static void svm_predict_batch(const VmafModel *model, const double *x,
+                              unsigned cnt, double *y, struct svm_node *node)
+{
+    const struct svm_model *svm = model->svm;
+    const unsigned dim = model->sv_dim;
+
+    if (!model->sv) {
+        for (unsigned c = 0; c < cnt; c++) {
+            for (unsigned j = 0; j < model->n_features; j++) {
+                node[j].index = j + 1;
+                node[j].value = x[c * dim + j];
+            }
+            node[model->n_features].index = -1;
+            y[c] = svm_predict(svm, node);
         }
+        return;
+    }
+
+    void (*rbf)(const double *sv_coef, const double *sv, unsigned dim,
+                unsigned stride, double gamma, const double *x, unsigned cnt,
+                double *y) = svm_rbf;
+#if ARCH_X86
+    const unsigned flags = vmaf_get_cpu_flags();
+    if (flags & VMAF_X86_CPU_FLAG_AVX2)
+        rbf = svm_rbf_avx2;
+#if HAVE_AVX512
+    if (flags & VMAF_X86_CPU_FLAG_AVX512)
+        rbf = svm_rbf_avx512;
+#endif
+#elif ARCH_AARCH64
+    if (vmaf_get_cpu_flags() & VMAF_ARM_CPU_FLAG_NEON)
+        rbf = svm_rbf_neon;
+#endif
+
+    rbf(model->sv_coef, model->sv, dim, model->sv_stride, svm->param.gamma, x,
+        cnt, y);
+
+    for (unsigned c = 0; c < cnt; c++)
+        y[c] -= svm->rho[0];
+}
 
-        char *feature_name =
-            vmaf_feature_name_from_options(model->feature[i].name,
-                    fex_ctx->fex->options, fex_ctx->fex->priv);
+int vmaf_predict_scores_range(VmafModel *model,
+                              VmafFeatureCollector *feature_collector,
+                              unsigned index_low, unsigned index_high,
+                              unsigned step, double *scores,
+                              bool write_prediction,
+                              enum VmafModelFlags flags)
+{
+    if (!model) return -EINVAL;
+    if (!feature_collector) return -EINVAL;
+    if (index_low > index_high) return -EINVAL;
+    if (!step) return -EINVAL;
 
-        vmaf_feature_extractor_context_destroy(fex_ctx);
+    int err = predict_init(model);
+    if (err) return err;
 
-        if (!feature_name) {
-            vmaf_log(VMAF_LOG_LEVEL_ERROR,
-                     "vmaf_predict_score_at_index(): could not generate "
-                     "feature name\n");
-            err = -ENOMEM;
-            goto free_node;
-        }
+    const unsigned n_features = model->n_features;
+    const unsigned dim = model->sv ? model->sv_dim : n_features;
 
-        double feature_score;
-        err = vmaf_feature_collector_get_score(feature_collector,
-                                               feature_name, &feature_score,
-                                               index);
+    FeatureVector **fv = malloc(sizeof(*fv) * (n_features + 1));
+    if (!fv) return -ENOMEM;
+    double *x = malloc(sizeof(*x) * PREDICT_BATCH_CNT * (dim + 1));
+    if (!x) {
+        err = -ENOMEM;
+        goto free_fv;
+    }
+    struct svm_node *node = malloc(sizeof(*node) * (n_features + 1));
+    if (!node) {
+        err = -ENOMEM;
+        goto free_x;
+    }
+    memset(x, 0, sizeof(*x) * PREDICT_BATCH_CNT * (dim + 1));
 
+    for (unsigned i = 0; i < n_features; i++) {
+        unsigned id;
+        err = vmaf_feature_collector_get_id(feature_collector,
+                                            model->feature[i].score_name, &id);
         if (err) {
             vmaf_log(VMAF_LOG_LEVEL_ERROR,
-                     "vmaf_predict_score_at_index(): no feature '%s' "
-                     "at index %d\n", feature_name, index);
-            free(feature_name);
+                     "vmaf_predict_scores_range(): no feature '%s'\n",
+                     model->feature[i].score_name);
             goto free_node;
         }
-        free(feature_name);
+        fv[i] = vmaf_feature_collector_get_vector(feature_collector, id);
+    }
 
-        err = normalize(model, model->feature[i].slope,
-                        model->feature[i].intercept, &feature_score);
+    unsigned prediction_id = 0;
+    if (write_prediction) {
+        err = vmaf_feature_collector_register(feature_collector, model->name,
+                                              &prediction_id);
         if (err) goto free_node;
-
-        node[i].index = i + 1;
-        node[i].value = feature_score;
     }
-    node[model->n_features].index = -1;
 
-    double prediction = svm_predict(model->svm, node);
+    const unsigned cnt = (index_high - index_low) / step + 1;
+    for (unsigned k = 0; k < cnt; k += PREDICT_BATCH_CNT) {
+        const unsigned batch_cnt =
+            cnt - k < PREDICT_BATCH_CNT ? cnt - k : PREDICT_BATCH_CNT;
+        double y[PREDICT_BATCH_CNT];
+
+        for (unsigned c = 0; c < batch_cnt; c++) {
+            const unsigned index = index_low + (k + c) * step;
+            for (unsigned i = 0; i < n_features; i++) {
+                double feature_score;
+                if (!feature_vector_get_score(fv[i], index, &feature_score)) {
+                    vmaf_log(VMAF_LOG_LEVEL_ERROR,
+                             "vmaf_predict_scores_range(): no feature '%s' "
+                             "at index %d\n", model->feature[i].score_name,
+                             index);
+                    err = -EINVAL;
+                    goto free_node;
+                }
+                err = normalize(model, model->feature[i].slope,
+                                model->feature[i].intercept, &feature_score);
+                if (err) goto free_node;
+                x[c * dim + i] = feature_score;
+            }
+        }
+
+        svm_predict_batch(model, x, batch_cnt, y, node);
 
-    err = denormalize(model, &prediction);
-    if (err) goto free_node;
+        for (unsigned c = 0; c < batch_cnt; c++) {
+            const unsigned index = index_low + (k + c) * step;
+            double prediction = y[c];
 
-    err = transform(model, &prediction, flags);
-    if (err) goto free_node;
+            err = denormalize(model, &prediction);
+            if (err) goto free_node;
 
-    err = clip(model, &prediction, flags);
-    if (err) goto free_node;
+            err = transform(model, &prediction, flags);
+            if (err) goto free_node;
 
-    if (write_prediction) {
-        err = vmaf_feature_collector_append(feature_collector, model->name,
-                                            prediction, index);
-        if (err) goto free_node;
-    }
+            err = clip(model, &prediction, flags);
+            if (err) goto free_node;
 
-    *vmaf_score = prediction;
+            if (write_prediction) {
+                err = vmaf_feature_collector_append_by_id(feature_collector,
+                                                          prediction_id,
+                                                          prediction, index);
+                if (err) goto free_node;
+            }
+
+            if (scores) scores[k + c] = prediction;
+        }
+    }
 
 free_node:
     free(node);
+free_x:
+    free(x);
+free_fv:
+    free(fv);
     return err;
 }
 
+int vmaf_predict_score_at_index(VmafModel *model,
+                                VmafFeatureCollector *feature_collector,
+                                unsigned index, double *vmaf_score,
+                                bool write_prediction,
+                                enum VmafModelFlags flags)
+{
+    if (!vmaf_score) return -EINVAL;
+
+    return vmaf_predict_scores_range(model, feature_collector, index, index,
+                                     1, vmaf_score, write_prediction, flags);
+}
+
 
 static int score_compare(const void *a, const void *b)
 {
@@ -370,10 +560,14 @@ static int vmaf_bootstrap_predict_score_at_index(
 
         // do not override the model's transform/clip behavior
         // write the scores to the feature collector
-        double score;
-        err = vmaf_predict_score_at_index(model_collection->model[i],
-                                          feature_collector, index,
-                                          &score, true, 0);
+        double score = scores[i];
+        err = transform(model_collection->model[i], &score, 0);
+        if (err) return err;
+        err = clip(model_collection->model[i], &score, 0);
+        if (err) return err;
+        err = vmaf_feature_collector_append(feature_collector,
+                                            model_collection->model[i]->name,
+                                            score, index);
         if (err) return err;
     }
 
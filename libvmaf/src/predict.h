@@ -28,6 +28,19 @@ int vmaf_predict_score_at_index(VmafModel *model,
                                 bool write_prediction,
                                 enum VmafModelFlags flags);
 
+/**
+ * Predict the scores of frames index_low, index_low + step, ... up to
+ * index_high, evaluating the model on batches of frames at once.
+ *
+ * @param scores Receives one prediction per predicted frame, may be NULL.
+ */
+int vmaf_predict_scores_range(VmafModel *model,
+                              VmafFeatureCollector *feature_collector,
+                              unsigned index_low, unsigned index_high,
+                              unsigned step, double *scores,
+                              bool write_prediction,
+                              enum VmafModelFlags flags);
+
 int vmaf_predict_score_at_index_model_collection(
                                 VmafModelCollection *model_collection,
                                 VmafFeatureCollector *feature_collector,
@@ -21,13 +21,20 @@
 
 #include <stdatomic.h>
 
+#include "libvmaf/picture.h"
+
 typedef struct VmafRef {
     atomic_int cnt;
+    // set up by whoever gets to it first, see vmaf_picture_cache_get()
+    _Atomic(struct VmafPictureCacheFrame *) cache;
+    // called instead of freeing the picture data, once cnt drops to zero
+    VmafPictureReleaseCallback release;
+    void *cookie;
 } VmafRef;
 
 int vmaf_ref_init(VmafRef **ref);
 void vmaf_ref_fetch_increment(VmafRef *ref);
-void vmaf_ref_fetch_decrement(VmafRef *ref);
+long vmaf_ref_fetch_decrement(VmafRef *ref);
 long vmaf_ref_load(VmafRef *ref);
 int vmaf_ref_close(VmafRef *ref);
 
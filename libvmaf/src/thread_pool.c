@@ -18,80 +18,213 @@
 
 #include <errno.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "thread_pool.h"
+
+#define JOB_RING_INITIAL_CAPACITY 64
+
 typedef struct VmafThreadPoolJob {
     void (*func)(void *data);
-    void *data;
-    struct VmafThreadPoolJob *next;
+    void *heap_data;
+    union {
+        unsigned char buf[VMAF_THREAD_POOL_JOB_DATA_SZ];
+        uint64_t u;
+        double d;
+        void *p;
+    } data;
 } VmafThreadPoolJob;
 
-typedef struct VmafTreadPool {
+typedef struct VmafThreadPoolWorker {
+    pthread_mutex_t lock;
+    pthread_cond_t wake_cond;
+    VmafThreadPoolJob *job;
+    unsigned head, capacity;
+    atomic_uint cnt;
+    bool sleeping, wake;
+    unsigned id;
+    pthread_t thread;
+    struct VmafThreadPool *pool;
+} VmafThreadPoolWorker;
+
+typedef struct VmafThreadPool {
+    VmafThreadPoolWorker *worker;
+    unsigned n_threads;
+    atomic_uint next_worker;
+    atomic_int n_pending, n_sleeping, stop;
     struct {
         pthread_mutex_t lock;
-        pthread_cond_t empty;
-        VmafThreadPoolJob *head, *tail;
-    } queue;
-    pthread_cond_t working;
-    unsigned n_threads;
-    unsigned n_working;
-    bool stop;
+        pthread_cond_t done;
+    } wait;
+    pthread_key_t self;
 } VmafThreadPool;
 
-static VmafThreadPoolJob *vmaf_thread_pool_fetch_job(VmafThreadPool *pool)
+static void *job_data(VmafThreadPoolJob *job)
 {
-    if (!pool) return NULL;
-    if (!pool->queue.head) return NULL;
+    return job->heap_data ? job->heap_data : job->data.buf;
+}
 
-    VmafThreadPoolJob *job = pool->queue.head;
-    if (!job->next) {
-        pool->queue.head = NULL;
-        pool->queue.tail = NULL;
-    } else {
-        pool->queue.head = job->next;
-    }
+static int job_ring_grow(VmafThreadPoolWorker *w)
+{
+    const unsigned capacity = w->capacity * 2;
+    VmafThreadPoolJob *job = malloc(sizeof(*job) * capacity);
+    if (!job) return -ENOMEM;
+
+    const unsigned cnt = atomic_load(&w->cnt);
+    for (unsigned i = 0; i < cnt; i++)
+        job[i] = w->job[(w->head + i) % w->capacity];
+
+    free(w->job);
+    w->job = job;
+    w->head = 0;
+    w->capacity = capacity;
+    return 0;
+}
+
+/* caller holds w->lock */
+static VmafThreadPoolJob *job_ring_push(VmafThreadPoolWorker *w)
+{
+    const unsigned cnt = atomic_load(&w->cnt);
+    if (cnt == w->capacity && job_ring_grow(w))
+        return NULL;
+
+    VmafThreadPoolJob *job = &w->job[(w->head + cnt) % w->capacity];
+    atomic_store(&w->cnt, cnt + 1);
     return job;
 }
 
-static void vmaf_thread_pool_job_destroy(VmafThreadPoolJob *job)
+/* caller holds w->lock, owner takes the oldest job */
+static void job_ring_pop_front(VmafThreadPoolWorker *w, VmafThreadPoolJob *job)
 {
-    if (!job) return;
-    if (job->data) free(job->data);
-    free(job);
+    *job = w->job[w->head];
+    w->head = (w->head + 1) % w->capacity;
+    atomic_store(&w->cnt, atomic_load(&w->cnt) - 1);
 }
 
-static void *vmaf_thread_pool_runner(void *p)
+/* caller holds w->lock, thieves take the newest job */
+static void job_ring_pop_back(VmafThreadPoolWorker *w, VmafThreadPoolJob *job)
+{
+    const unsigned cnt = atomic_load(&w->cnt) - 1;
+    *job = w->job[(w->head + cnt) % w->capacity];
+    atomic_store(&w->cnt, cnt);
+}
+
+static bool vmaf_thread_pool_pop_job(VmafThreadPoolWorker *w,
+                                     VmafThreadPoolJob *job)
+{
+    if (!atomic_load(&w->cnt)) return false;
+
+    bool found = false;
+    pthread_mutex_lock(&(w->lock));
+    if (atomic_load(&w->cnt)) {
+        job_ring_pop_front(w, job);
+        found = true;
+    }
+    pthread_mutex_unlock(&(w->lock));
+    return found;
+}
+
+static bool vmaf_thread_pool_steal_job(VmafThreadPool *pool,
+                                       VmafThreadPoolWorker *self,
+                                       VmafThreadPoolJob *job)
 {
-    VmafThreadPool *pool = p;
-
-    for (;;) {
-        pthread_mutex_lock(&(pool->queue.lock));
-        if (!pool->queue.head && !pool->stop)
-            pthread_cond_wait(&(pool->queue.empty), &(pool->queue.lock));
-        if (pool->stop) break;
-        VmafThreadPoolJob *job = vmaf_thread_pool_fetch_job(pool);
-        pool->n_working++;
-        pthread_mutex_unlock(&(pool->queue.lock));
-        if (job) {
-            job->func(job->data);
-            vmaf_thread_pool_job_destroy(job);
+    for (unsigned i = 1; i < pool->n_threads; i++) {
+        VmafThreadPoolWorker *w =
+            &pool->worker[(self->id + i) % pool->n_threads];
+        if (!atomic_load(&w->cnt)) continue;
+
+        bool found = false;
+        pthread_mutex_lock(&(w->lock));
+        if (atomic_load(&w->cnt)) {
+            job_ring_pop_back(w, job);
+            found = true;
         }
-        pthread_mutex_lock(&(pool->queue.lock));
-        pool->n_working--;
-        if (!pool->stop && pool->n_working == 0 && !pool->queue.head)
-            pthread_cond_signal(&(pool->working));
-        pthread_mutex_unlock(&(pool->queue.lock));
+        pthread_mutex_unlock(&(w->lock));
+        if (found) return true;
     }
+    return false;
+}
+
+static void vmaf_thread_pool_job_done(VmafThreadPool *pool)
+{
+    if (atomic_fetch_sub(&pool->n_pending, 1) != 1) return;
+
+    pthread_mutex_lock(&(pool->wait.lock));
+    pthread_cond_broadcast(&(pool->wait.done));
+    pthread_mutex_unlock(&(pool->wait.lock));
+}
+
+static bool vmaf_thread_pool_has_job(VmafThreadPool *pool)
+{
+    for (unsigned i = 0; i < pool->n_threads; i++) {
+        if (atomic_load(&pool->worker[i].cnt)) return true;
+    }
+    return false;
+}
+
+static void *vmaf_thread_pool_runner(void *p)
+{
+    VmafThreadPoolWorker *w = p;
+    VmafThreadPool *pool = w->pool;
+    pthread_setspecific(pool->self, w);
 
-    if (--(pool->n_threads) == 0)
-        pthread_cond_signal(&(pool->working));
+    VmafThreadPoolJob job;
+    while (!atomic_load(&pool->stop)) {
+        if (vmaf_thread_pool_pop_job(w, &job) ||
+            vmaf_thread_pool_steal_job(pool, w, &job))
+        {
+            job.func(job_data(&job));
+            free(job.heap_data);
+            vmaf_thread_pool_job_done(pool);
+            continue;
+        }
+
+        pthread_mutex_lock(&(w->lock));
+        if (!atomic_load(&w->cnt) && !w->wake && !atomic_load(&pool->stop)) {
+            w->sleeping = true;
+            atomic_fetch_add(&pool->n_sleeping, 1);
+            // an enqueue which read n_sleeping before the increment above
+            // has published its job before, so it is seen here
+            while (!atomic_load(&w->cnt) && !w->wake &&
+                   !atomic_load(&pool->stop) &&
+                   !vmaf_thread_pool_has_job(pool))
+            {
+                pthread_cond_wait(&(w->wake_cond), &(w->lock));
+            }
+            atomic_fetch_sub(&pool->n_sleeping, 1);
+            w->sleeping = false;
+        }
+        w->wake = false;
+        pthread_mutex_unlock(&(w->lock));
+    }
 
-    pthread_mutex_unlock(&(pool->queue.lock));
     return NULL;
 }
 
+static void vmaf_thread_pool_wake_sleeper(VmafThreadPool *pool,
+                                          VmafThreadPoolWorker *busy)
+{
+    for (unsigned i = 1; i < pool->n_threads; i++) {
+        VmafThreadPoolWorker *w =
+            &pool->worker[(busy->id + i) % pool->n_threads];
+
+        // a worker woken already but not yet running counts as awake, so
+        // that each job wakes a worker of its own
+        pthread_mutex_lock(&(w->lock));
+        const bool sleeping = w->sleeping && !w->wake;
+        if (sleeping) {
+            w->wake = true;
+            pthread_cond_signal(&(w->wake_cond));
+        }
+        pthread_mutex_unlock(&(w->lock));
+        if (sleeping) return;
+    }
+}
+
 int vmaf_thread_pool_create(VmafThreadPool **pool, unsigned n_threads)
 {
     if (!pool) return -EINVAL;
@@ -101,18 +234,50 @@ int vmaf_thread_pool_create(VmafThreadPool **pool, unsigned n_threads)
     if (!p) return -ENOMEM;
     memset(p, 0, sizeof(*p));
     p->n_threads = n_threads;
+    atomic_init(&p->next_worker, 0);
+    atomic_init(&p->n_pending, 0);
+    atomic_init(&p->n_sleeping, 0);
+    atomic_init(&p->stop, 0);
 
-    pthread_mutex_init(&(p->queue.lock), NULL);
-    pthread_cond_init(&(p->queue.empty), NULL);
-    pthread_cond_init(&(p->working), NULL);
+    const size_t worker_sz = sizeof(*(p->worker)) * n_threads;
+    p->worker = malloc(worker_sz);
+    if (!p->worker) goto free_p;
+    memset(p->worker, 0, worker_sz);
 
     for (unsigned i = 0; i < n_threads; i++) {
-        pthread_t thread;
-        pthread_create(&thread, NULL, vmaf_thread_pool_runner, p);
-        pthread_detach(thread);
+        VmafThreadPoolWorker *w = &p->worker[i];
+        w->capacity = JOB_RING_INITIAL_CAPACITY;
+        w->job = malloc(sizeof(*(w->job)) * w->capacity);
+        if (!w->job) goto free_jobs;
+    }
+
+    if (pthread_key_create(&p->self, NULL)) goto free_jobs;
+    pthread_mutex_init(&(p->wait.lock), NULL);
+    pthread_cond_init(&(p->wait.done), NULL);
+
+    for (unsigned i = 0; i < n_threads; i++) {
+        VmafThreadPoolWorker *w = &p->worker[i];
+        w->id = i;
+        w->pool = p;
+        atomic_init(&w->cnt, 0);
+        pthread_mutex_init(&(w->lock), NULL);
+        pthread_cond_init(&(w->wake_cond), NULL);
+    }
+
+    for (unsigned i = 0; i < n_threads; i++) {
+        VmafThreadPoolWorker *w = &p->worker[i];
+        pthread_create(&w->thread, NULL, vmaf_thread_pool_runner, w);
     }
 
     return 0;
+
+free_jobs:
+    for (unsigned i = 0; i < n_threads; i++)
+        free(p->worker[i].job);
+    free(p->worker);
+free_p:
+    free(p);
+    return -ENOMEM;
 }
 
 int vmaf_thread_pool_enqueue(VmafThreadPool *pool, void (*func)(void *data),
@@ -121,67 +286,182 @@ int vmaf_thread_pool_enqueue(VmafThreadPool *pool, void (*func)(void *data),
     if (!pool) return -EINVAL;
     if (!func) return -EINVAL;
 
-    VmafThreadPoolJob *job = malloc(sizeof(*job));
-    if (!job) return -ENOMEM;
-    memset(job, 0, sizeof(*job));
-    job->func = func;
-    if (data) {
-        job->data = malloc(data_sz);
-        if (!job->data) goto free_job;
-        memcpy(job->data, data, data_sz);
+    void *heap_data = NULL;
+    if (data && data_sz > VMAF_THREAD_POOL_JOB_DATA_SZ) {
+        heap_data = malloc(data_sz);
+        if (!heap_data) return -ENOMEM;
+        memcpy(heap_data, data, data_sz);
+    }
+
+    // jobs enqueued from a worker stay local, others are spread round robin
+    VmafThreadPoolWorker *w = pthread_getspecific(pool->self);
+    if (!w || w->pool != pool) {
+        const unsigned next = atomic_fetch_add(&pool->next_worker, 1);
+        w = &pool->worker[next % pool->n_threads];
     }
 
-    pthread_mutex_lock(&(pool->queue.lock));
+    atomic_fetch_add(&pool->n_pending, 1);
+    pthread_mutex_lock(&(w->lock));
 
-    if (!pool->queue.head) {
-        pool->queue.head = job;
-        pool->queue.tail = pool->queue.head;
-    } else {
-        pool->queue.tail->next = job;
-        pool->queue.tail = job;
+    VmafThreadPoolJob *job = job_ring_push(w);
+    if (!job) {
+        pthread_mutex_unlock(&(w->lock));
+        atomic_fetch_sub(&pool->n_pending, 1);
+        free(heap_data);
+        return -ENOMEM;
     }
 
-    pthread_cond_broadcast(&(pool->queue.empty));
-    pthread_mutex_unlock(&(pool->queue.lock));
+    job->func = func;
+    job->heap_data = heap_data;
+    if (data && !heap_data)
+        memcpy(job->data.buf, data, data_sz);
 
-    return 0;
+    const bool sleeping = w->sleeping;
+    if (sleeping)
+        pthread_cond_signal(&(w->wake_cond));
+    pthread_mutex_unlock(&(w->lock));
 
-free_job:
-    free(job);
-    return -ENOMEM;
+    // the job is published before n_sleeping is read: a worker going to
+    // sleep either is counted here, or sees the job, see the runner
+    if (!sleeping && atomic_load(&pool->n_sleeping))
+        vmaf_thread_pool_wake_sleeper(pool, w);
+
+    return 0;
 }
 
 int vmaf_thread_pool_wait(VmafThreadPool *pool)
 {
     if (!pool) return -EINVAL;
 
-    pthread_mutex_lock(&(pool->queue.lock));
-    while((!pool->stop && (pool->n_working || pool->queue.head)) ||
-          (pool->stop && pool->n_threads))
-        pthread_cond_wait(&(pool->working), &(pool->queue.lock));
-    pthread_mutex_unlock(&(pool->queue.lock));
+    pthread_mutex_lock(&(pool->wait.lock));
+    while (atomic_load(&pool->n_pending))
+        pthread_cond_wait(&(pool->wait.done), &(pool->wait.lock));
+    pthread_mutex_unlock(&(pool->wait.lock));
     return 0;
 }
+
+unsigned vmaf_thread_pool_n_threads(VmafThreadPool *pool)
+{
+    return pool ? pool->n_threads : 0;
+}
+
+typedef struct ParallelFor {
+    void (*func)(void *data, unsigned i);
+    void *data;
+    unsigned n;
+    atomic_uint next, done;
+    atomic_int ref_cnt;
+    pthread_mutex_t lock;
+    pthread_cond_t finished;
+} ParallelFor;
+
+static void parallel_for_unref(ParallelFor *pf)
+{
+    if (atomic_fetch_sub(&pf->ref_cnt, 1) != 1) return;
+
+    pthread_mutex_destroy(&(pf->lock));
+    pthread_cond_destroy(&(pf->finished));
+    free(pf);
+}
+
+static void parallel_for_run(ParallelFor *pf)
+{
+    unsigned i;
+    while ((i = atomic_fetch_add(&pf->next, 1)) < pf->n) {
+        pf->func(pf->data, i);
+        if (atomic_fetch_add(&pf->done, 1) + 1 != pf->n) continue;
+
+        pthread_mutex_lock(&(pf->lock));
+        pthread_cond_signal(&(pf->finished));
+        pthread_mutex_unlock(&(pf->lock));
+    }
+}
+
+static void parallel_for_helper(void *data)
+{
+    ParallelFor *pf = *(ParallelFor **)data;
+    parallel_for_run(pf);
+    parallel_for_unref(pf);
+}
+
+int vmaf_thread_pool_parallel_for(VmafThreadPool *pool, unsigned n,
+                                  void (*func)(void *data, unsigned i),
+                                  void *data)
+{
+    if (!pool) return -EINVAL;
+    if (!func) return -EINVAL;
+    if (!n) return 0;
+
+    if (n == 1) {
+        func(data, 0);
+        return 0;
+    }
+
+    ParallelFor *pf = malloc(sizeof(*pf));
+    if (!pf) return -ENOMEM;
+    pf->func = func;
+    pf->data = data;
+    pf->n = n;
+    atomic_init(&pf->next, 0);
+    atomic_init(&pf->done, 0);
+    atomic_init(&pf->ref_cnt, 1);
+    pthread_mutex_init(&(pf->lock), NULL);
+    pthread_cond_init(&(pf->finished), NULL);
+
+    // helpers that start after all indices are claimed return immediately
+    const unsigned n_helpers =
+        n - 1 < pool->n_threads ? n - 1 : pool->n_threads;
+    for (unsigned i = 0; i < n_helpers; i++) {
+        atomic_fetch_add(&pf->ref_cnt, 1);
+        int err = vmaf_thread_pool_enqueue(pool, parallel_for_helper,
+                                           &pf, sizeof(pf));
+        if (err) {
+            atomic_fetch_sub(&pf->ref_cnt, 1);
+            break;
+        }
+    }
+
+    parallel_for_run(pf);
+
+    pthread_mutex_lock(&(pf->lock));
+    while (atomic_load(&pf->done) != n)
+        pthread_cond_wait(&(pf->finished), &(pf->lock));
+    pthread_mutex_unlock(&(pf->lock));
+
+    parallel_for_unref(pf);
+    return 0;
+}
+
 int vmaf_thread_pool_destroy(VmafThreadPool *pool)
 {
     if (!pool) return -EINVAL;
-    pthread_mutex_lock(&(pool->queue.lock));
 
-    VmafThreadPoolJob *job = pool->queue.head;
-    while (job) {
-        VmafThreadPoolJob *next_job = job->next;
-        vmaf_thread_pool_job_destroy(job);
-        job = next_job;
+    atomic_store(&pool->stop, 1);
+    for (unsigned i = 0; i < pool->n_threads; i++) {
+        VmafThreadPoolWorker *w = &pool->worker[i];
+        pthread_mutex_lock(&(w->lock));
+        pthread_cond_signal(&(w->wake_cond));
+        pthread_mutex_unlock(&(w->lock));
     }
 
-    pool->stop = true;
-    pthread_cond_broadcast(&(pool->queue.empty));
-    pthread_mutex_unlock(&(pool->queue.lock));
-    vmaf_thread_pool_wait(pool);
-    pthread_mutex_destroy(&(pool->queue.lock));
-    pthread_cond_destroy(&(pool->queue.empty));
-    pthread_cond_destroy(&(pool->working));
+    for (unsigned i = 0; i < pool->n_threads; i++) {
+        VmafThreadPoolWorker *w = &pool->worker[i];
+        pthread_join(w->thread, NULL);
+
+        VmafThreadPoolJob job;
+        while (atomic_load(&w->cnt)) {
+            job_ring_pop_front(w, &job);
+            free(job.heap_data);
+        }
+        free(w->job);
+        pthread_mutex_destroy(&(w->lock));
+        pthread_cond_destroy(&(w->wake_cond));
+    }
 
+    pthread_key_delete(pool->self);
+    pthread_mutex_destroy(&(pool->wait.lock));
+    pthread_cond_destroy(&(pool->wait.done));
+    free(pool->worker);
     free(pool);
     return 0;
 }
@@ -20,6 +20,10 @@
 #define __VMAF_THREAD_POOL_H__
 
 #include <pthread.h>
+#include <stddef.h>
+
+/* job payloads up to this size are stored inline without allocation */
+#define VMAF_THREAD_POOL_JOB_DATA_SZ 256
 
 typedef struct VmafThreadPool VmafThreadPool;
 
@@ -30,6 +34,17 @@ int vmaf_thread_pool_enqueue(VmafThreadPool *pool, void (*func)(void *data),
 
 int vmaf_thread_pool_wait(VmafThreadPool *pool);
 
+unsigned vmaf_thread_pool_n_threads(VmafThreadPool *pool);
+
+/**
+ * Call func(data, i) for every i in [0, n) and return once all calls are
+ * done. The calling thread takes part, so this may be used from inside a
+ * job without waiting on unrelated work in the pool.
+ */
+int vmaf_thread_pool_parallel_for(VmafThreadPool *pool, unsigned n,
+                                  void (*func)(void *data, unsigned i),
+                                  void *data);
+
 int vmaf_thread_pool_destroy(VmafThreadPool *tpool);
 
 #endif /* __VMAF_THREAD_POOL_H__ */
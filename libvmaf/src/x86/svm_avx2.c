@@ -0,0 +1,96 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+
+#include <immintrin.h>
+
+#include "svm_avx2.h"
+
+// Taylor coefficients of exp(r), 1 / 12! down to 1 / 0!
+static const double exp_coef[] = {
+    2.08767569878680989792e-9, 2.50521083854417187751e-8,
+    2.75573192239858906526e-7, 2.75573192239858906526e-6,
+    2.48015873015873015873e-5, 1.98412698412698412698e-4,
+    1.38888888888888888889e-3, 8.33333333333333333333e-3,
+    4.16666666666666666667e-2, 1.66666666666666666667e-1,
+    5.00000000000000000000e-1, 1.0, 1.0,
+};
+
+// exp(x) for x <= 0, within a few ulp, or nan for nan
+static inline __m256d exp_neg_pd(__m256d x)
+{
+    // below this, 2^n would be subnormal and the kernel term is negligible
+    x = _mm256_max_pd(_mm256_set1_pd(-708.), x);
+
+    const __m256d t = _mm256_mul_pd(x, _mm256_set1_pd(1.44269504088896341));
+    const __m256d n =
+        _mm256_round_pd(t, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    const __m256d ln2_hi = _mm256_set1_pd(6.93145751953125e-1);
+    const __m256d ln2_lo = _mm256_set1_pd(1.42860682030941723212e-6);
+    __m256d r = _mm256_sub_pd(x, _mm256_mul_pd(n, ln2_hi));
+    r = _mm256_sub_pd(r, _mm256_mul_pd(n, ln2_lo));
+
+    __m256d p = _mm256_set1_pd(exp_coef[0]);
+    for (unsigned k = 1; k < sizeof(exp_coef) / sizeof(exp_coef[0]); k++)
+        p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(exp_coef[k]));
+
+    // 2^n, n + 1023 ends up in the low mantissa bits of 2^52 + n + 1023
+    const __m256d bias = _mm256_set1_pd(4503599627370496. + 1023.);
+    const __m256i e =
+        _mm256_slli_epi64(_mm256_castpd_si256(_mm256_add_pd(n, bias)), 52);
+    return _mm256_mul_pd(p, _mm256_castsi256_pd(e));
+}
+
+void svm_rbf_avx2(const double *sv_coef, const double *sv, unsigned dim,
+                  unsigned stride, double gamma, const double *x,
+                  unsigned cnt, double *y)
+{
+    const __m256d neg_gamma = _mm256_set1_pd(-gamma);
+
+    for (unsigned c = 0; c < cnt; c++) {
+        const double *xc = &x[c * dim];
+        __m256d acc0 = _mm256_setzero_pd();
+        __m256d acc1 = _mm256_setzero_pd();
+
+        // stride is a multiple of 8, two blocks of 4 per iteration
+        for (unsigned i = 0; i < stride; i += 8) {
+            __m256d sum0 = _mm256_setzero_pd();
+            __m256d sum1 = _mm256_setzero_pd();
+            for (unsigned j = 0; j < dim; j++) {
+                const __m256d xj = _mm256_set1_pd(xc[j]);
+                const __m256d d0 =
+                    _mm256_sub_pd(xj, _mm256_loadu_pd(&sv[j * stride + i]));
+                const __m256d d1 =
+                    _mm256_sub_pd(xj, _mm256_loadu_pd(&sv[j * stride + i + 4]));
+                sum0 = _mm256_add_pd(sum0, _mm256_mul_pd(d0, d0));
+                sum1 = _mm256_add_pd(sum1, _mm256_mul_pd(d1, d1));
+            }
+            const __m256d k0 = exp_neg_pd(_mm256_mul_pd(neg_gamma, sum0));
+            const __m256d k1 = exp_neg_pd(_mm256_mul_pd(neg_gamma, sum1));
+            const __m256d w0 = _mm256_loadu_pd(&sv_coef[i]);
+            const __m256d w1 = _mm256_loadu_pd(&sv_coef[i + 4]);
+            acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(w0, k0));
+            acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(w1, k1));
+        }
+
+        const __m256d acc = _mm256_add_pd(acc0, acc1);
+        const __m128d h = _mm_add_pd(_mm256_castpd256_pd128(acc),
+                                     _mm256_extractf128_pd(acc, 1));
+        y[c] = _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+    }
+}
@@ -0,0 +1,77 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+
+#include <immintrin.h>
+
+#include "svm_avx512.h"
+
+// Taylor coefficients of exp(r), 1 / 12! down to 1 / 0!
+static const double exp_coef[] = {
+    2.08767569878680989792e-9, 2.50521083854417187751e-8,
+    2.75573192239858906526e-7, 2.75573192239858906526e-6,
+    2.48015873015873015873e-5, 1.98412698412698412698e-4,
+    1.38888888888888888889e-3, 8.33333333333333333333e-3,
+    4.16666666666666666667e-2, 1.66666666666666666667e-1,
+    5.00000000000000000000e-1, 1.0, 1.0,
+};
+
+// exp(x) for x <= 0, within a few ulp, or nan for nan
+static inline __m512d exp_neg_pd(__m512d x)
+{
+    // below this, 2^n would be subnormal and the kernel term is negligible
+    x = _mm512_max_pd(_mm512_set1_pd(-708.), x);
+
+    const __m512d t = _mm512_mul_pd(x, _mm512_set1_pd(1.44269504088896341));
+    const __m512d n =
+        _mm512_roundscale_pd(t, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512d r = _mm512_fnmadd_pd(n, _mm512_set1_pd(6.93145751953125e-1), x);
+    r = _mm512_fnmadd_pd(n, _mm512_set1_pd(1.42860682030941723212e-6), r);
+
+    __m512d p = _mm512_set1_pd(exp_coef[0]);
+    for (unsigned k = 1; k < sizeof(exp_coef) / sizeof(exp_coef[0]); k++)
+        p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(exp_coef[k]));
+
+    return _mm512_scalef_pd(p, n);
+}
+
+void svm_rbf_avx512(const double *sv_coef, const double *sv, unsigned dim,
+                    unsigned stride, double gamma, const double *x,
+                    unsigned cnt, double *y)
+{
+    const __m512d neg_gamma = _mm512_set1_pd(-gamma);
+
+    for (unsigned c = 0; c < cnt; c++) {
+        const double *xc = &x[c * dim];
+        __m512d acc = _mm512_setzero_pd();
+
+        // stride is a multiple of 8
+        for (unsigned i = 0; i < stride; i += 8) {
+            __m512d sum = _mm512_setzero_pd();
+            for (unsigned j = 0; j < dim; j++) {
+                const __m512d v = _mm512_loadu_pd(&sv[j * stride + i]);
+                const __m512d d = _mm512_sub_pd(_mm512_set1_pd(xc[j]), v);
+                sum = _mm512_fmadd_pd(d, d, sum);
+            }
+            const __m512d k = exp_neg_pd(_mm512_mul_pd(neg_gamma, sum));
+            acc = _mm512_fmadd_pd(_mm512_loadu_pd(&sv_coef[i]), k, acc);
+        }
+
+        y[c] = _mm512_reduce_add_pd(acc);
+    }
+}
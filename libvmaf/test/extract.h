@@ -0,0 +1,78 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#ifndef __VMAF_TEST_EXTRACT_H__
+#define __VMAF_TEST_EXTRACT_H__
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "dict.h"
+#include "feature/feature_collector.h"
+#include "feature/feature_extractor.h"
+#include "feature/feature_name.h"
+#include "libvmaf/picture.h"
+
+/**
+ * Run the feature extractor fex_name with opts, which it takes, on one pair
+ * of pictures and read the cnt scores named in score_name. Non-default
+ * options show up in the feature names, as they do in the collector.
+ *
+ * The extractor picks its kernels from vmaf_get_cpu_flags() when it is
+ * initialized, so this is also how the tests reach each SIMD version.
+ */
+static inline int extract_scores(const char *fex_name, VmafDictionary *opts,
+                                 VmafPicture *ref, VmafPicture *dist,
+                                 const char *const *score_name, unsigned cnt,
+                                 double *scores)
+{
+    int err = 0;
+
+    VmafFeatureExtractor *fex = vmaf_get_feature_extractor_by_name(fex_name);
+    if (!fex) return -EINVAL;
+    VmafFeatureExtractorContext *fex_ctx;
+    err = vmaf_feature_extractor_context_create(&fex_ctx, fex, opts);
+    if (err) return err;
+    VmafFeatureCollector *vfc;
+    err = vmaf_feature_collector_init(&vfc);
+    if (err) {
+        vmaf_feature_extractor_context_destroy(fex_ctx);
+        return err;
+    }
+
+    err = vmaf_feature_extractor_context_extract(fex_ctx, ref, NULL, dist,
+                                                 NULL, 0, vfc);
+    for (unsigned i = 0; !err && i < cnt; i++) {
+        char *name = vmaf_feature_name_from_options(score_name[i],
+                                                    fex->options,
+                                                    fex_ctx->fex->priv);
+        if (!name) {
+            err = -ENOMEM;
+            break;
+        }
+        err = vmaf_feature_collector_get_score(vfc, name, &scores[i], 0);
+        free(name);
+    }
+
+    err |= vmaf_feature_extractor_context_close(fex_ctx);
+    err |= vmaf_feature_extractor_context_destroy(fex_ctx);
+    vmaf_feature_collector_destroy(vfc);
+    return err;
+}
+
+#endif /* __VMAF_TEST_EXTRACT_H__ */
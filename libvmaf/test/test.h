@@ -16,8 +16,11 @@
  *
  */
 
+#include <stdint.h>
 #include <stdio.h>
 
+#include "libvmaf/picture.h"
+
 // http://www.jera.com/techinfo/jtns/jtn002.html
 
 #define mu_assert(message, test) \
@@ -41,3 +44,62 @@
 
 extern int mu_tests_run;
 char *run_tests(void);
+
+/**
+ * Next value of a linear congruential generator, for test data that is
+ * random looking but the same on every run.
+ */
+static inline uint32_t lcg_next(uint32_t *seed)
+{
+    return *seed = *seed * 1664525u + 1013904223u;
+}
+
+/**
+ * Set sample (x, y) of plane p of pic to val, clamped to the range of its
+ * bit depth.
+ */
+static inline void put_sample(VmafPicture *pic, unsigned p, unsigned x,
+                              unsigned y, int val)
+{
+    const int max = (1 << pic->bpc) - 1;
+    val = val < 0 ? 0 : val > max ? max : val;
+    if (pic->bpc == 8) {
+        uint8_t *data = pic->data[p];
+        data[y * pic->stride[p] + x] = val;
+    } else {
+        uint16_t *data = pic->data[p];
+        data[y * (pic->stride[p] / 2) + x] = val;
+    }
+}
+
+/**
+ * Set pixel (x, y) of the first plane of pic to val, clamped to the range
+ * of its bit depth.
+ */
+static inline void put_pixel(VmafPicture *pic, unsigned x, unsigned y,
+                             int val)
+{
+    put_sample(pic, 0, x, y, val);
+}
+
+/**
+ * mask with its highest flag dropped.
+ */
+static inline unsigned next_cpu_mask(unsigned mask)
+{
+    unsigned top = 1;
+    while (top <= mask >> 1)
+        top <<= 1;
+    return mask & ~top;
+}
+
+/**
+ * Run the statement that follows with mask going from cpu_flags down to 0,
+ * dropping the highest flag each time, so that every kernel gets its turn
+ * and the scalar code comes last. Pass each mask to
+ * vmaf_set_cpu_flags_mask().
+ */
+#define for_each_cpu_mask(mask, cpu_flags)                        \
+    for (unsigned mask = (cpu_flags), mask##_done = 0;            \
+         !mask##_done;                                            \
+         mask##_done = !mask, mask = next_cpu_mask(mask))
@@ -0,0 +1,179 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu.h"
+#include "dict.h"
+#include "feature/feature_collector.h"
+#include "feature/feature_extractor.h"
+#include "feature/feature_name.h"
+#include "test.h"
+#include "libvmaf/picture.h"
+
+#define ADM_SCORE_CNT 16
+
+static const char *adm_score_name[ADM_SCORE_CNT] = {
+    "VMAF_integer_feature_adm2_score",
+    "integer_adm_scale0",
+    "integer_adm_scale1",
+    "integer_adm_scale2",
+    "integer_adm_scale3",
+    "integer_adm",
+    "integer_adm_num",
+    "integer_adm_den",
+    "integer_adm_num_scale0",
+    "integer_adm_den_scale0",
+    "integer_adm_num_scale1",
+    "integer_adm_den_scale1",
+    "integer_adm_num_scale2",
+    "integer_adm_den_scale2",
+    "integer_adm_num_scale3",
+    "integer_adm_den_scale3",
+};
+
+// a textured reference, and a distorted picture which is contrast enhanced
+// on its left half and attenuated and noisy on its right half, so that the
+// enhancement gain limit and the decoupling both have work to do
+static void fill_pictures(VmafPicture *ref, VmafPicture *dist)
+{
+    const int max = (1 << ref->bpc) - 1;
+    const int mid = (max + 1) / 2;
+    uint32_t seed = 1;
+
+    for (unsigned y = 0; y < ref->h[0]; y++) {
+        for (unsigned x = 0; x < ref->w[0]; x++) {
+            seed = seed * 1664525 + 1013904223;
+            const int noise = (int)(seed >> 24) - 128;
+            const int texture = ((x * 7 + y * 3) % 37) * 2 - 37 +
+                                (((x / 9) + (y / 5)) % 2) * 40 - 20;
+            const int r = mid + texture * max / 255 + noise * max / 1024;
+            put_pixel(ref, x, y, r);
+
+            int d;
+            if (x < ref->w[0] / 2)
+                d = mid + (r - mid) * 5 / 4;
+            else
+                d = mid + (r - mid) * 2 / 3 + noise * max / 512;
+            put_pixel(dist, x, y, d);
+        }
+    }
+}
+
+static int adm_scores(VmafPicture *ref, VmafPicture *dist, const char *egl,
+                      const char *nvd, double *scores)
+{
+    int err = 0;
+
+    VmafDictionary *opts = NULL;
+    err |= vmaf_dictionary_set(&opts, "debug", "true", 0);
+    err |= vmaf_dictionary_set(&opts, "adm_enhn_gain_limit", egl, 0);
+    err |= vmaf_dictionary_set(&opts, "adm_norm_view_dist", nvd, 0);
+    if (err) return err;
+
+    VmafFeatureExtractor *fex = vmaf_get_feature_extractor_by_name("adm");
+    if (!fex) return -EINVAL;
+    VmafFeatureExtractorContext *fex_ctx;
+    err = vmaf_feature_extractor_context_create(&fex_ctx, fex, opts);
+    if (err) return err;
+    VmafFeatureCollector *vfc;
+    err = vmaf_feature_collector_init(&vfc);
+    if (err) return err;
+
+    err = vmaf_feature_extractor_context_extract(fex_ctx, ref, NULL, dist,
+                                                 NULL, 0, vfc);
+    // non-default feature parameters show up in the feature names
+    for (unsigned i = 0; !err && i < ADM_SCORE_CNT; i++) {
+        char *name = vmaf_feature_name_from_options(adm_score_name[i],
+                                                    fex->options,
+                                                    fex_ctx->fex->priv);
+        if (!name) {
+            err = -ENOMEM;
+            break;
+        }
+        err = vmaf_feature_collector_get_score(vfc, name, &scores[i], 0);
+        free(name);
+    }
+
+    err |= vmaf_feature_extractor_context_close(fex_ctx);
+    err |= vmaf_feature_extractor_context_destroy(fex_ctx);
+    vmaf_feature_collector_destroy(vfc);
+    return err;
+}
+
+static char *test_adm_simd_bitexact()
+{
+    int err = 0;
+
+    // odd dimensions, so that every kernel has leftover columns, and a tall
+    // picture whose scales are processed in several strips
+    const unsigned w[] = { 181, 97 }, h[] = { 97, 421 };
+    const unsigned bpc[] = { 8, 10, 12 };
+    const char *egl[] = { "100.0", "1.2" };
+    const char *nvd[] = { "3.0", "4.5" };
+
+    vmaf_init_cpu();
+    const unsigned cpu_flags = vmaf_get_cpu_flags();
+
+    for (unsigned p = 0; p < 2; p++) {
+        for (unsigned b = 0; b < 3; b++) {
+            VmafPicture ref, dist;
+            err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, bpc[b],
+                                     w[p], h[p]);
+            mu_assert("problem during vmaf_picture_alloc", !err);
+            err = vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, bpc[b],
+                                     w[p], h[p]);
+            mu_assert("problem during vmaf_picture_alloc", !err);
+            fill_pictures(&ref, &dist);
+
+            for (unsigned o = 0; o < 2; o++) {
+                double expected[ADM_SCORE_CNT], scores[ADM_SCORE_CNT];
+                vmaf_set_cpu_flags_mask(0);
+                err = adm_scores(&ref, &dist, egl[o], nvd[o], expected);
+                mu_assert("problem during adm_scores", !err);
+                mu_assert("adm should see the distortion", expected[0] != 1.);
+
+                // compare against the scalar code
+                for_each_cpu_mask(mask, cpu_flags) {
+                    vmaf_set_cpu_flags_mask(mask);
+                    err = adm_scores(&ref, &dist, egl[o], nvd[o], scores);
+                    mu_assert("problem during adm_scores", !err);
+                    for (unsigned i = 0; i < ADM_SCORE_CNT; i++) {
+                        mu_assert("vectorized adm does not match the scalar code",
+                                  scores[i] == expected[i]);
+                    }
+                }
+            }
+
+            vmaf_picture_unref(&ref);
+            vmaf_picture_unref(&dist);
+        }
+    }
+    vmaf_set_cpu_flags_mask(-1);
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_adm_simd_bitexact);
+    return NULL;
+}
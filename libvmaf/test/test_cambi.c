@@ -147,7 +147,7 @@ static char *test_decimate()
     uint16_t width = pic.w[0]>>1;
     uint16_t height = pic.h[0]>>1;
 
-    decimate(&pic, width, height);
+    decimate(&pic, width, height, &cambi_kernels_c);
 
     mu_assert("decimate pic wrong pixel value (0,0)", data[0]==1);
     mu_assert("decimate pic wrong pixel value (1,0)", data[1]==0);
@@ -250,12 +250,12 @@ static char *test_filter_mode()
     data[1 * stride + 2] = 1; data[2 * stride + 2] = 1;
     data[1 * stride + 3] = 1; data[3 * stride + 3] = 1;
     memcpy(filtered_data, data, stride * h * sizeof(uint16_t));
-    filter_mode(&filtered_image, w, h, buffer);
+    filter_mode(&filtered_image, w, h, buffer, &cambi_kernels_c);
     mu_assert("filter_mode: all zeros", data_pic_sum(&filtered_image)==0);
 
     data[3 * stride + 4] = 1;
     memcpy(filtered_data, data, stride * h * sizeof(uint16_t));
-    filter_mode(&filtered_image, w, h, buffer);
+    filter_mode(&filtered_image, w, h, buffer, &cambi_kernels_c);
 
     mu_assert("filter_mode: one one sum check", data_pic_sum(&filtered_image)==1);
     mu_assert("filter_mode: zero (3,3) check", filtered_data[3 * output_stride + 3]==0);
@@ -264,15 +264,15 @@ static char *test_filter_mode()
     data[0 * stride + 0] = 2;
     data[0 * stride + 1] = 1;
     memcpy(filtered_data, data, stride * h * sizeof(uint16_t));
-    filter_mode(&filtered_image, w, h, buffer);
+    filter_mode(&filtered_image, w, h, buffer, &cambi_kernels_c);
     mu_assert("filter_mode: two in the corner check", filtered_data[0 * output_stride + 0]==2);
     data[1 * stride + 0] = 1;
     memcpy(filtered_data, data, stride * h * sizeof(uint16_t));
-    filter_mode(&filtered_image, w, h, buffer);
+    filter_mode(&filtered_image, w, h, buffer, &cambi_kernels_c);
     mu_assert("filter_mode: two in the corner and adjacent one check", filtered_data[0 * output_stride + 1]==1);
     data[2 * stride + 0] = 2;
     memcpy(filtered_data, data, stride * h * sizeof(uint16_t));
-    filter_mode(&filtered_image, w, h, buffer);
+    filter_mode(&filtered_image, w, h, buffer, &cambi_kernels_c);
     mu_assert("filter_mode: two in corner and edge check", filtered_data[1 * output_stride + 0]==2);
 
     vmaf_picture_unref(&image);
@@ -318,22 +318,28 @@ static char *test_get_spatial_mask_for_index()
     get_sample_image(&image, 3);
     get_sample_image(&mask, 3);
 
-    get_spatial_mask_for_index(&image, &mask, mask_dp, 2, filter_size, width, height);
+    get_spatial_mask_for_index(&image, &mask, mask_dp, 2, filter_size, width, height,
+                               0, height, &cambi_kernels_c);
     mu_assert("spatial_mask_for_index wrong mask for index=2, image=3", data_pic_sum(&mask)==14);
-    get_spatial_mask_for_index(&image, &mask, mask_dp, 1, filter_size, width, height);
+    get_spatial_mask_for_index(&image, &mask, mask_dp, 1, filter_size, width, height,
+                               0, height, &cambi_kernels_c);
     mu_assert("spatial_mask_for_index wrong mask for index=1, image=3", data_pic_sum(&mask)==16);
-    get_spatial_mask_for_index(&image, &mask, mask_dp, 0, filter_size, width, height);
+    get_spatial_mask_for_index(&image, &mask, mask_dp, 0, filter_size, width, height,
+                               0, height, &cambi_kernels_c);
     mu_assert("spatial_mask_for_index wrong mask for index=0, image=3", data_pic_sum(&mask)==16);
 
     vmaf_picture_unref(&image);
 
     get_sample_image(&image, 4);
 
-    get_spatial_mask_for_index(&image, &mask, mask_dp, 3, filter_size, width, height);
+    get_spatial_mask_for_index(&image, &mask, mask_dp, 3, filter_size, width, height,
+                               0, height, &cambi_kernels_c);
     mu_assert("spatial_mask_for_index wrong mask for index=3, image=4", data_pic_sum(&mask)==0);
-    get_spatial_mask_for_index(&image, &mask, mask_dp, 2, filter_size, width, height);
+    get_spatial_mask_for_index(&image, &mask, mask_dp, 2, filter_size, width, height,
+                               0, height, &cambi_kernels_c);
     mu_assert("spatial_mask_for_index wrong mask for index=2, image=4", data_pic_sum(&mask)==6);
-    get_spatial_mask_for_index(&image, &mask, mask_dp, 1, filter_size, width, height);
+    get_spatial_mask_for_index(&image, &mask, mask_dp, 1, filter_size, width, height,
+                               0, height, &cambi_kernels_c);
     mu_assert("spatial_mask_for_index wrong mask for index=1, image=4", data_pic_sum(&mask)==9);
 
     vmaf_picture_unref(&image);
@@ -362,8 +368,8 @@ static char *test_calculate_c_values()
     get_sample_image(&input, 0);
     get_sample_image(&mask, 8);
     calculate_c_values(&input, &mask, combined_c_values, histograms, window_size,
-                       num_diffs, tvi_for_diff, diff_weights, all_diffs, width, height, 
-                       increment_range, decrement_range);
+                       num_diffs, tvi_for_diff, diff_weights, all_diffs, width, height,
+                       0, height, &cambi_kernels_c);
 
     for (unsigned i=0; i<16; i++) {
         mu_assert("calculate_c_values error ws=3",
@@ -377,8 +383,8 @@ static char *test_calculate_c_values()
     window_size = 9;
     uint16_t histograms_8x8[8*1032];
     calculate_c_values(&input_8x8, &mask_8x8, combined_c_values_8x8, histograms_8x8,
-                       window_size, num_diffs, tvi_for_diff, diff_weights, all_diffs, 8, 8, 
-                       increment_range, decrement_range);
+                       window_size, num_diffs, tvi_for_diff, diff_weights, all_diffs, 8, 8,
+                       0, 8, &cambi_kernels_c);
 
     double sum = 0;
     for (unsigned i=0; i<64; i++)
@@ -393,6 +399,134 @@ static char *test_calculate_c_values()
     return NULL;
 }
 
+// a smooth gradient quantized into plateaus, with a sprinkle of noise so that
+// the spatial mask has holes in it
+static void get_banded_image(VmafPicture *pic, unsigned width, unsigned height)
+{
+    vmaf_picture_alloc(pic, VMAF_PIX_FMT_YUV400P, 10, width, height);
+    uint16_t *data = (uint16_t *) pic->data[0];
+    ptrdiff_t stride = pic->stride[0] >> 1;
+    uint32_t seed = 1;
+    for (unsigned i=0; i<height; i++) {
+        for (unsigned j=0; j<width; j++) {
+            seed = seed * 1664525 + 1013904223;
+            int val = 200 + (j * 3 + i) / 5 + ((seed >> 24) < 8 ? (seed >> 28) : 0);
+            data[i * stride + j] = val > 1023 ? 1023 : val;
+        }
+    }
+}
+
+static bool pic_copy_equality(VmafPicture *pic, VmafPicture *pic2, unsigned w, unsigned h)
+{
+    uint16_t *data = pic->data[0], *data2 = pic2->data[0];
+    ptrdiff_t stride = pic->stride[0] >> 1, stride2 = pic2->stride[0] >> 1;
+    for (unsigned i=0; i<h; i++)
+        for (unsigned j=0; j<w; j++)
+            if (data[i * stride + j] != data2[i * stride2 + j])
+                return 0;
+    return 1;
+}
+
+static char *test_kernels_simd_bitexact()
+{
+    // odd sizes, so that every kernel has leftover columns
+    const unsigned width = 203, height = 157;
+    const unsigned band_cnt = 3;
+    const unsigned half_width = (width + 1) >> 1, half_height = (height + 1) >> 1;
+    const uint16_t num_diffs = 4;
+    uint16_t tvi_for_diff[4] = {178, 305, 432, 559};
+
+    uint16_t *diffs_to_consider;
+    int *diff_weights;
+    int *all_diffs;
+    set_contrast_arrays(num_diffs, &diffs_to_consider, &diff_weights, &all_diffs);
+    const uint16_t num_bins = 1024 + (all_diffs[2*num_diffs] - all_diffs[0]);
+
+    const int pad_size = MASK_FILTER_SIZE >> 1;
+    const size_t dp_size = (width + 2 * pad_size + 1) * (2 * pad_size + 2);
+    uint32_t *mask_dp = malloc(dp_size * sizeof(uint32_t));
+    uint16_t *histograms = malloc(width * num_bins * sizeof(uint16_t) * band_cnt);
+    uint16_t *buffer = malloc(3 * width * sizeof(uint16_t));
+    float *expected_c_values = malloc(width * height * sizeof(float));
+    float *c_values = malloc(width * height * sizeof(float));
+    mu_assert("problem during malloc",
+              mask_dp && histograms && buffer && expected_c_values && c_values);
+
+    VmafPicture expected_image, expected_mask;
+    get_banded_image(&expected_image, width, height);
+    get_banded_image(&expected_mask, width, height);
+
+    // the scalar kernels over the whole picture in one go
+    const uint16_t mask_index = get_mask_index(width, height, MASK_FILTER_SIZE);
+    get_spatial_mask_for_index(&expected_image, &expected_mask, mask_dp, mask_index,
+                               MASK_FILTER_SIZE, width, height, 0, height, &cambi_kernels_c);
+    calculate_c_values(&expected_image, &expected_mask, expected_c_values, histograms, 9,
+                       num_diffs, tvi_for_diff, diff_weights, all_diffs, width, height,
+                       0, height, &cambi_kernels_c);
+    filter_mode(&expected_image, width, height, buffer, &cambi_kernels_c);
+    decimate(&expected_image, half_width, half_height, &cambi_kernels_c);
+
+    double sum = 0;
+    for (unsigned i=0; i<width*height; i++)
+        sum += expected_c_values[i];
+    mu_assert("banded image should have c-values", sum > 0);
+
+    vmaf_init_cpu();
+    const unsigned cpu_flags = vmaf_get_cpu_flags();
+
+    // run the spatial mask and the c-values in bands
+    for_each_cpu_mask(m, cpu_flags) {
+        vmaf_set_cpu_flags_mask(m);
+        CambiKernels kernels;
+        init_kernels(&kernels);
+
+        VmafPicture band_image, band_mask;
+        get_banded_image(&band_image, width, height);
+        get_banded_image(&band_mask, width, height);
+
+        for (unsigned band=0; band<band_cnt; band++) {
+            get_spatial_mask_for_index(&band_image, &band_mask, mask_dp, mask_index,
+                                       MASK_FILTER_SIZE, width, height,
+                                       height * band / band_cnt,
+                                       height * (band + 1) / band_cnt, &kernels);
+        }
+        mu_assert("banded spatial mask does not match the scalar code",
+                  pic_copy_equality(&band_mask, &expected_mask, width, height));
+
+        for (unsigned band=0; band<band_cnt; band++) {
+            calculate_c_values(&band_image, &band_mask, c_values,
+                               &histograms[band * width * num_bins], 9, num_diffs,
+                               tvi_for_diff, diff_weights, all_diffs, width, height,
+                               height * band / band_cnt, height * (band + 1) / band_cnt,
+                               &kernels);
+        }
+        mu_assert("banded c-values do not match the scalar code",
+                  !memcmp(c_values, expected_c_values, width * height * sizeof(float)));
+
+        filter_mode(&band_image, width, height, buffer, &kernels);
+        decimate(&band_image, half_width, half_height, &kernels);
+        mu_assert("filter_mode and decimate do not match the scalar code",
+                  pic_copy_equality(&band_image, &expected_image, half_width, half_height));
+
+        vmaf_picture_unref(&band_image);
+        vmaf_picture_unref(&band_mask);
+    }
+    vmaf_set_cpu_flags_mask(-1);
+
+    vmaf_picture_unref(&expected_image);
+    vmaf_picture_unref(&expected_mask);
+    free(mask_dp);
+    free(histograms);
+    free(buffer);
+    free(expected_c_values);
+    free(c_values);
+    aligned_free(diffs_to_consider);
+    aligned_free(diff_weights);
+    aligned_free(all_diffs);
+
+    return NULL;
+}
+
 static char *test_c_value_pixel()
 {
     uint16_t histogram[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
@@ -685,6 +819,7 @@ char *run_tests()
     mu_run_test(test_get_spatial_mask_for_index);
 
     mu_run_test(test_calculate_c_values);
+    mu_run_test(test_kernels_simd_bitexact);
     mu_run_test(test_c_value_pixel);
     mu_run_test(test_update_range);
 
@@ -16,7 +16,10 @@
  *
  */
 
+#include <stdint.h>
+
 #include "test.h"
+#include "extract.h"
 #include "feature/ciede.c"
 
 static int close_enough(float a, float b)
@@ -75,11 +78,86 @@ static char *test_ciede4()
     return NULL;
 }
 
+// mostly small distortions, as in encoded video, and a few large ones
+static void fill_pictures(VmafPicture *ref, VmafPicture *dist, uint32_t seed)
+{
+    const int max = (1 << ref->bpc) - 1;
+    for (unsigned p = 0; p < 3; p++) {
+        for (unsigned i = 0; i < ref->h[p]; i++) {
+            for (unsigned j = 0; j < ref->w[p]; j++) {
+                lcg_next(&seed);
+                const int r = (seed >> 8) & max;
+                const int noise = j % 4 ? (int) ((seed >> 4) & 7) - 4 : 0;
+                const int d = j % 8 == 7 ? (int) (seed & max) : r + noise;
+                put_sample(ref, p, j, i, r);
+                put_sample(dist, p, j, i, d);
+            }
+        }
+    }
+}
+
+static char *test_ciede_simd()
+{
+    static const enum VmafPixelFormat pix_fmt[] = {
+        VMAF_PIX_FMT_YUV444P, VMAF_PIX_FMT_YUV420P,
+    };
+    static const unsigned bpc[] = { 8, 10, 12, 16 };
+    // widths with leftover columns for every vector length
+    static const unsigned dim[][2] = { { 9, 2 }, { 67, 9 }, { 203, 4 } };
+    const char *score_name[] = { "ciede2000" };
+
+    vmaf_init_cpu();
+    const unsigned cpu_flags = vmaf_get_cpu_flags();
+
+    for (unsigned f = 0; f < sizeof(pix_fmt) / sizeof(pix_fmt[0]); f++) {
+        for (unsigned b = 0; b < sizeof(bpc) / sizeof(bpc[0]); b++) {
+            for (unsigned k = 0; k < sizeof(dim) / sizeof(dim[0]); k++) {
+                VmafPicture ref, dist;
+                int err = vmaf_picture_alloc(&ref, pix_fmt[f], bpc[b],
+                                             dim[k][0], dim[k][1]);
+                mu_assert("problem during vmaf_picture_alloc", !err);
+                err = vmaf_picture_alloc(&dist, pix_fmt[f], bpc[b],
+                                         dim[k][0], dim[k][1]);
+                if (err) vmaf_picture_unref(&ref);
+                mu_assert("problem during vmaf_picture_alloc", !err);
+                fill_pictures(&ref, &dist, bpc[b] * 7 + k);
+
+                double expected = 0., score;
+                bool match = true;
+                vmaf_set_cpu_flags_mask(0);
+                err = extract_scores("ciede", NULL, &ref, &dist, score_name, 1,
+                                     &expected);
+                // a per pixel de00 within 5e-4 of the scalar one bounds the
+                // relative error of the mean de00, 20 / ln(10) scales it to
+                // the score
+                const double mean = pow(10., (45. - expected) / 20.);
+                const double tolerance = 8.69 * 5e-4 / mean;
+                for_each_cpu_mask(mask, cpu_flags) {
+                    if (err) break;
+                    vmaf_set_cpu_flags_mask(mask);
+                    err = extract_scores("ciede", NULL, &ref, &dist,
+                                         score_name, 1, &score);
+                    match &= fabs(score - expected) < tolerance;
+                }
+                vmaf_set_cpu_flags_mask(-1);
+                vmaf_picture_unref(&ref);
+                vmaf_picture_unref(&dist);
+                mu_assert("problem during extract_scores", !err);
+                mu_assert("SIMD ciede2000 deviates from the scalar score",
+                          match);
+            }
+        }
+    }
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_ciede);
     mu_run_test(test_ciede2);
     mu_run_test(test_ciede3);
     mu_run_test(test_ciede4);
+    mu_run_test(test_ciede_simd);
     return NULL;
 }
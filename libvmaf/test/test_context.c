@@ -16,6 +16,14 @@
  *
  */
 
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "test.h"
 #include "libvmaf/libvmaf.h"
 
@@ -70,9 +78,498 @@ static char *test_get_feature_score()
     return NULL;
 }
 
+#define FRAME_CNT 8
+
+typedef struct FrameLog {
+    VmafContext *vmaf;
+    const char *feature_name;
+    pthread_mutex_t lock;
+    unsigned cnt[FRAME_CNT];
+    unsigned complete;
+} FrameLog;
+
+static void log_frame(void *cookie, unsigned index)
+{
+    FrameLog *log = cookie;
+    double score;
+
+    // motion2 of a picture is written while extracting the next one
+    const bool complete =
+        index < FRAME_CNT &&
+        !vmaf_feature_score_at_index(log->vmaf, log->feature_name, &score,
+                                     index) &&
+        !vmaf_feature_score_at_index(log->vmaf,
+                "VMAF_integer_feature_motion2_score", &score, index);
+
+    pthread_mutex_lock(&log->lock);
+    if (index < FRAME_CNT) log->cnt[index]++;
+    log->complete += complete;
+    pthread_mutex_unlock(&log->lock);
+}
+
+static char *run_frame_callback(unsigned n_threads, VmafModel *model)
+{
+    int err = 0;
+    VmafContext *vmaf;
+    VmafConfiguration cfg = { .n_threads = n_threads };
+
+    err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+
+    FrameLog log = {
+        .vmaf = vmaf,
+        .feature_name = model ? "vmaf" : "float_ssim",
+    };
+    pthread_mutex_init(&log.lock, NULL);
+    err = vmaf_set_frame_callback(vmaf, log_frame, &log,
+                                  model ? VMAF_FRAME_CALLBACK_PREDICT : 0);
+    mu_assert("problem during vmaf_set_frame_callback", !err);
+    if (model) {
+        err = vmaf_use_features_from_model(vmaf, model);
+        mu_assert("problem during vmaf_use_features_from_model", !err);
+    } else {
+        err = vmaf_use_feature(vmaf, "float_ssim", NULL);
+        err |= vmaf_use_feature(vmaf, "motion", NULL);
+        mu_assert("problem during vmaf_use_feature", !err);
+    }
+
+    for (unsigned i = 0; i < FRAME_CNT; i++) {
+        VmafPicture ref, dist;
+        err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+        err |= vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+        mu_assert("problem during vmaf_picture_alloc", !err);
+        memset(ref.data[0], i * 16, ref.stride[0] * ref.h[0]);
+        memset(dist.data[0], i * 8, dist.stride[0] * dist.h[0]);
+        err = vmaf_read_pictures(vmaf, &ref, &dist, i);
+        mu_assert("problem during vmaf_read_pictures", !err);
+    }
+
+    err = vmaf_set_frame_callback(vmaf, log_frame, &log, 0);
+    mu_assert("the callback should be set before reading", err);
+
+    err = vmaf_read_pictures(vmaf, NULL, NULL, 0);
+    mu_assert("problem during vmaf_read_pictures", !err);
+
+    for (unsigned i = 0; i < FRAME_CNT; i++)
+        mu_assert("each picture should complete once", log.cnt[i] == 1);
+    mu_assert("pictures should be complete when the callback fires",
+              log.complete == FRAME_CNT);
+
+    pthread_mutex_destroy(&log.lock);
+    err = vmaf_close(vmaf);
+    mu_assert("problem during vmaf_close", !err);
+
+    return NULL;
+}
+
+static char *test_frame_callback()
+{
+    char *msg;
+    if ((msg = run_frame_callback(0, NULL))) return msg;
+    if ((msg = run_frame_callback(4, NULL))) return msg;
+
+    VmafModel *model;
+    VmafModelConfig cfg = { .name = "vmaf" };
+    int err = vmaf_model_load(&model, &cfg, "vmaf_v0.6.1");
+    mu_assert("problem during vmaf_model_load", !err);
+    msg = run_frame_callback(4, model);
+    vmaf_model_destroy(model);
+    return msg;
+}
+
+#define MULTI_DIST_CNT 3
+#define MULTI_FRAME_CNT 5
+
+static const char *multi_feature_name[] = {
+    "VMAF_integer_feature_motion2_score", "cambi", "cambi_source",
+    "cambi_full_reference", "VMAF_feature_vif_scale0_score",
+    "VMAF_integer_feature_adm2_score", "integer_adm_scale0",
+    "integer_adm_scale3",
+};
+
+static void fill_plane(VmafPicture *pic, unsigned seed)
+{
+    uint8_t *data = pic->data[0];
+    for (unsigned i = 0; i < pic->h[0]; i++) {
+        for (unsigned j = 0; j < pic->w[0]; j++) {
+            const unsigned x = (i * 7 + j * 3 + seed * 13) ^ (seed * 29);
+            data[i * pic->stride[0] + j] = (i / 8 + j / 16) * 4 + x % 5;
+        }
+    }
+}
+
+static char *init_multi_context(VmafContext **vmaf, unsigned n_threads)
+{
+    VmafConfiguration cfg = { .n_threads = n_threads };
+    int err = vmaf_init(vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+
+    VmafFeatureDictionary *opts = NULL;
+    err = vmaf_feature_dictionary_set(&opts, "full_ref", "true");
+    mu_assert("problem during vmaf_feature_dictionary_set", !err);
+    err = vmaf_use_feature(*vmaf, "cambi", opts);
+    err |= vmaf_use_feature(*vmaf, "motion", NULL);
+    err |= vmaf_use_feature(*vmaf, "float_vif", NULL);
+    err |= vmaf_use_feature(*vmaf, "adm", NULL);
+    mu_assert("problem during vmaf_use_feature", !err);
+    return NULL;
+}
+
+static char *alloc_multi_picture(VmafPicture *pic, unsigned seed)
+{
+    int err = vmaf_picture_alloc(pic, VMAF_PIX_FMT_YUV420P, 8, 320, 240);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    fill_plane(pic, seed);
+    return NULL;
+}
+
+static char *run_multi(unsigned n_threads)
+{
+    char *msg;
+    int err;
+
+    VmafContext *multi[MULTI_DIST_CNT], *single[MULTI_DIST_CNT];
+    for (unsigned d = 0; d < MULTI_DIST_CNT; d++) {
+        if ((msg = init_multi_context(&multi[d], n_threads))) return msg;
+        if ((msg = init_multi_context(&single[d], n_threads))) return msg;
+    }
+
+    for (unsigned i = 0; i < MULTI_FRAME_CNT; i++) {
+        VmafPicture ref, dist[MULTI_DIST_CNT];
+        if ((msg = alloc_multi_picture(&ref, i))) return msg;
+        for (unsigned d = 0; d < MULTI_DIST_CNT; d++) {
+            if ((msg = alloc_multi_picture(&dist[d], i + 7 * (d + 1))))
+                return msg;
+        }
+
+        // the same pictures, scored by one context per distorted picture
+        for (unsigned d = 0; d < MULTI_DIST_CNT; d++) {
+            VmafPicture ref_copy, dist_copy;
+            if ((msg = alloc_multi_picture(&ref_copy, i))) return msg;
+            if ((msg = alloc_multi_picture(&dist_copy, i + 7 * (d + 1))))
+                return msg;
+            err = vmaf_read_pictures(single[d], &ref_copy, &dist_copy, i);
+            mu_assert("problem during vmaf_read_pictures", !err);
+        }
+
+        err = vmaf_read_pictures_multi(multi, MULTI_DIST_CNT, &ref, dist, i);
+        mu_assert("problem during vmaf_read_pictures_multi", !err);
+    }
+
+    err = vmaf_read_pictures_multi(multi, MULTI_DIST_CNT, NULL, NULL, 0);
+    mu_assert("problem flushing with vmaf_read_pictures_multi", !err);
+
+    for (unsigned d = 0; d < MULTI_DIST_CNT; d++) {
+        err = vmaf_read_pictures(single[d], NULL, NULL, 0);
+        mu_assert("problem during vmaf_read_pictures", !err);
+
+        for (unsigned i = 0; i < MULTI_FRAME_CNT; i++) {
+            const unsigned feature_cnt =
+                sizeof(multi_feature_name) / sizeof(multi_feature_name[0]);
+            for (unsigned f = 0; f < feature_cnt; f++) {
+                double a, b;
+                err = vmaf_feature_score_at_index(multi[d],
+                                                  multi_feature_name[f], &a, i);
+                err |= vmaf_feature_score_at_index(single[d],
+                                                   multi_feature_name[f], &b,
+                                                   i);
+                mu_assert("problem during vmaf_feature_score_at_index", !err);
+                mu_assert("shared reference scores should match", a == b);
+            }
+        }
+
+        err = vmaf_close(multi[d]);
+        err |= vmaf_close(single[d]);
+        mu_assert("problem during vmaf_close", !err);
+    }
+
+    return NULL;
+}
+
+static char *test_read_pictures_multi()
+{
+    char *msg;
+    if ((msg = run_multi(0))) return msg;
+    if ((msg = run_multi(3))) return msg;
+
+    VmafContext *vmaf;
+    VmafConfiguration cfg = { 0 };
+    int err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+    VmafPicture ref, dist;
+    err = vmaf_read_pictures_multi(&vmaf, 0, &ref, &dist, 0);
+    mu_assert("zero contexts should be an error", err);
+    err = vmaf_read_pictures_multi(&vmaf, 1, &ref, NULL, 0);
+    mu_assert("a reference without distorted pictures should be an error",
+              err);
+    err = vmaf_close(vmaf);
+    mu_assert("problem during vmaf_close", !err);
+
+    // the second context rejects its distorted picture, the first one has
+    // read the pair already and every picture is released
+    VmafContext *multi[MULTI_DIST_CNT];
+    for (unsigned d = 0; d < MULTI_DIST_CNT; d++)
+        if ((msg = init_multi_context(&multi[d], 0))) return msg;
+    VmafPicture dists[MULTI_DIST_CNT];
+    if ((msg = alloc_multi_picture(&ref, 0))) return msg;
+    for (unsigned d = 0; d < MULTI_DIST_CNT; d++) {
+        if (d == 1) {
+            err = vmaf_picture_alloc(&dists[d], VMAF_PIX_FMT_YUV420P, 8,
+                                     160, 120);
+            mu_assert("problem during vmaf_picture_alloc", !err);
+        } else if ((msg = alloc_multi_picture(&dists[d], d))) {
+            return msg;
+        }
+    }
+    err = vmaf_read_pictures_multi(multi, MULTI_DIST_CNT, &ref, dists, 0);
+    mu_assert("a mismatched distorted picture should be an error", err);
+    mu_assert("the reference should be released", !ref.ref);
+    for (unsigned d = 0; d < MULTI_DIST_CNT; d++)
+        mu_assert("every distorted picture should be released", !dists[d].ref);
+
+    err = vmaf_read_pictures(multi[0], NULL, NULL, 0);
+    mu_assert("problem during vmaf_read_pictures", !err);
+    double score;
+    err = vmaf_feature_score_at_index(multi[0], multi_feature_name[0], &score,
+                                      0);
+    mu_assert("the first context should have scored the picture", !err);
+    for (unsigned d = 0; d < MULTI_DIST_CNT; d++) {
+        err = vmaf_close(multi[d]);
+        mu_assert("problem during vmaf_close", !err);
+    }
+
+    return NULL;
+}
+
+static char *read_file(const char *path, size_t *sz)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    *sz = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *data = malloc(*sz + 1);
+    if (data && fread(data, 1, *sz, f) != *sz) {
+        free(data);
+        data = NULL;
+    }
+    if (data) data[*sz] = '\0';
+    fclose(f);
+    remove(path);
+    return data;
+}
+
+static uint32_t read_u32(const char **p)
+{
+    const uint8_t *b = (const uint8_t *) *p;
+    *p += 4;
+    return b[0] | b[1] << 8 | b[2] << 16 | (uint32_t) b[3] << 24;
+}
+
+static double read_f64(const char **p)
+{
+    uint64_t bits = 0;
+    for (unsigned i = 0; i < 8; i++)
+        bits |= (uint64_t) (uint8_t) (*p)[i] << (8 * i);
+    *p += 8;
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static char *test_write_output()
+{
+    int err = 0;
+    VmafContext *vmaf;
+    VmafConfiguration cfg = { 0 };
+
+    err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+
+    // ties and values around them, which printf has to round
+    const double value[] = {
+        0., -0., 1.5, 0.0000005, 0.0000015, 0.0000025, 1234.5678915,
+        -2.0000005, 1e-7, -1e-7, 123456789.123456, 3e12, 0.1, 2.675,
+        99.9999995, 7.0000004999,
+    };
+    const unsigned n = sizeof(value) / sizeof(value[0]);
+    for (unsigned i = 0; i < n; i++) {
+        err = vmaf_import_feature_score(vmaf, "feature_a", value[i], i);
+        mu_assert("problem during vmaf_import_feature_score", !err);
+    }
+
+    const char *path = "test_context_output";
+    err = vmaf_write_output(vmaf, path, VMAF_OUTPUT_FORMAT_CSV);
+    mu_assert("problem during vmaf_write_output", !err);
+    size_t sz;
+    char *csv = read_file(path, &sz);
+    mu_assert("problem reading the output", csv);
+
+    char expected[2048];
+    int len = sprintf(expected, "Frame,feature_a,\n");
+    for (unsigned i = 0; i < n; i++)
+        len += sprintf(expected + len, "%d,%.6f,\n", i, value[i]);
+    mu_assert("CSV output should match printf", !strcmp(csv, expected));
+    free(csv);
+
+    err = vmaf_write_output(vmaf, path, VMAF_OUTPUT_FORMAT_BIN);
+    mu_assert("problem during vmaf_write_output", !err);
+    char *bin = read_file(path, &sz);
+    mu_assert("problem reading the output", bin);
+
+    const char *p = bin;
+    mu_assert("binary output should start with its magic",
+              !memcmp(p, "VMAFBIN\0", 8));
+    p += 8;
+    mu_assert("binary output has version 1", read_u32(&p) == 1);
+    mu_assert("binary output has 1 feature", read_u32(&p) == 1);
+    mu_assert("binary output has all frames", read_u32(&p) == n);
+    const unsigned pool_cnt = read_u32(&p);
+    mu_assert("binary output has all pooling methods",
+              pool_cnt == VMAF_POOL_METHOD_NB - 1);
+    mu_assert("binary output should name the feature",
+              read_u32(&p) == 9 && !memcmp(p, "feature_a", 9));
+    p += 9;
+    for (unsigned i = 0; i < n; i++)
+        mu_assert("binary output frame numbers", read_u32(&p) == i);
+    for (unsigned i = 0; i < n; i++) {
+        const double v = read_f64(&p);
+        mu_assert("binary output scores should be exact",
+                  !memcmp(&v, &value[i], sizeof(v)));
+    }
+    // no pictures were read, so there is no range to pool over
+    for (unsigned j = 0; j < pool_cnt; j++)
+        mu_assert("binary output pooled scores", isnan(read_f64(&p)));
+    mu_assert("binary output size", (size_t) (p - bin) == sz);
+    free(bin);
+
+    err = vmaf_close(vmaf);
+    mu_assert("problem during vmaf_close", !err);
+
+    return NULL;
+}
+
+static char *test_output_stream()
+{
+    int err = 0;
+    VmafContext *vmaf;
+    VmafConfiguration cfg = { .n_threads = 4 };
+
+    err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+
+    const char *stream_path = "test_context_output_stream";
+    err = vmaf_set_output_stream(vmaf, stream_path, VMAF_OUTPUT_FORMAT_JSON);
+    mu_assert("only line-oriented formats should stream", err);
+    err = vmaf_set_output_stream(vmaf, stream_path, VMAF_OUTPUT_FORMAT_CSV);
+    mu_assert("problem during vmaf_set_output_stream", !err);
+    err = vmaf_use_feature(vmaf, "float_ssim", NULL);
+    err |= vmaf_use_feature(vmaf, "motion", NULL);
+    mu_assert("problem during vmaf_use_feature", !err);
+
+    for (unsigned i = 0; i < FRAME_CNT; i++) {
+        VmafPicture ref, dist;
+        err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+        err |= vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+        mu_assert("problem during vmaf_picture_alloc", !err);
+        memset(ref.data[0], i * 16, ref.stride[0] * ref.h[0]);
+        memset(dist.data[0], i * 8, dist.stride[0] * dist.h[0]);
+        err = vmaf_read_pictures(vmaf, &ref, &dist, i);
+        mu_assert("problem during vmaf_read_pictures", !err);
+    }
+    err = vmaf_read_pictures(vmaf, NULL, NULL, 0);
+    mu_assert("problem during vmaf_read_pictures", !err);
+
+    const char *path = "test_context_output";
+    err = vmaf_write_output(vmaf, path, VMAF_OUTPUT_FORMAT_CSV);
+    mu_assert("problem during vmaf_write_output", !err);
+
+    size_t sz, stream_sz;
+    char *csv = read_file(path, &sz);
+    char *stream_csv = read_file(stream_path, &stream_sz);
+    mu_assert("problem reading the output", csv && stream_csv);
+    mu_assert("streamed output should match the final output",
+              sz == stream_sz && !strcmp(csv, stream_csv));
+    free(csv);
+    free(stream_csv);
+
+    err = vmaf_close(vmaf);
+    mu_assert("problem during vmaf_close", !err);
+
+    return NULL;
+}
+
+static char *test_output_stream_window()
+{
+    int err = 0;
+    VmafContext *vmaf;
+    VmafConfiguration cfg = { .n_threads = 2 };
+
+    err = vmaf_init(&vmaf, cfg);
+    mu_assert("problem during vmaf_init", !err);
+    err = vmaf_set_score_window(vmaf, 2, NULL, NULL);
+    mu_assert("problem during vmaf_set_score_window", !err);
+    const char *stream_path = "test_context_output_stream_window";
+    err = vmaf_set_output_stream(vmaf, stream_path, VMAF_OUTPUT_FORMAT_CSV);
+    mu_assert("problem during vmaf_set_output_stream", !err);
+    err = vmaf_use_feature(vmaf, "psnr", NULL);
+    mu_assert("problem during vmaf_use_feature", !err);
+
+    // index 1 is never read, which may not hold back the rows of the others
+    // until their scores are released
+    unsigned index[4 * FRAME_CNT];
+    unsigned index_cnt = 0;
+    index[index_cnt++] = 0;
+    for (unsigned i = 2; i < 4 * FRAME_CNT; i++)
+        index[index_cnt++] = i;
+
+    for (unsigned i = 0; i < index_cnt; i++) {
+        VmafPicture ref, dist;
+        err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+        err |= vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+        mu_assert("problem during vmaf_picture_alloc", !err);
+        memset(ref.data[0], i * 4, ref.stride[0] * ref.h[0]);
+        memset(dist.data[0], i * 2, dist.stride[0] * dist.h[0]);
+        err = vmaf_read_pictures(vmaf, &ref, &dist, index[i]);
+        mu_assert("problem during vmaf_read_pictures", !err);
+    }
+    err = vmaf_read_pictures(vmaf, NULL, NULL, 0);
+    mu_assert("problem during vmaf_read_pictures", !err);
+
+    size_t sz;
+    char *csv = read_file(stream_path, &sz);
+    mu_assert("problem reading the output", csv);
+    // one row per index read, in order, after the header
+    char *line = strchr(csv, '\n');
+    unsigned row_cnt = 0;
+    bool match = !!line;
+    while (match && line[1]) {
+        char *end;
+        const unsigned long i = strtoul(line + 1, &end, 10);
+        match = row_cnt < index_cnt && i == index[row_cnt] && *end == ',' &&
+                end[1] != '\n';
+        row_cnt++;
+        line = strchr(line + 1, '\n');
+        match &= !!line;
+    }
+    free(csv);
+    mu_assert("streamed rows should cover the indices read",
+              match && row_cnt == index_cnt);
+
+    err = vmaf_close(vmaf);
+    mu_assert("problem during vmaf_close", !err);
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_context_init_and_close);
     mu_run_test(test_get_feature_score);
+    mu_run_test(test_frame_callback);
+    mu_run_test(test_read_pictures_multi);
+    mu_run_test(test_write_output);
+    mu_run_test(test_output_stream);
+    mu_run_test(test_output_stream_window);
     return NULL;
 }
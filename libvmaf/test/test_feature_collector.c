@@ -16,6 +16,9 @@
  *
  */
 
+#include <math.h>
+#include <pthread.h>
+
 #include "test.h"
 #include "feature_collector.c"
 
@@ -68,16 +71,18 @@ static char *test_feature_vector_init_append_and_destroy()
 
     unsigned initial_capacity = feature_vector->capacity;
     for (int j = initial_capacity - 1; j >= 0; j--) {
-        err = feature_vector_append(feature_vector, j, 60.);
+        err = feature_vector_append_locked(feature_vector, j, 60., NULL);
         mu_assert("problem during feature_vector_append", !err);
     }
     mu_assert("feature_vector->capacity should not have changed",
               feature_vector->capacity == initial_capacity);
-    err = feature_vector_append(feature_vector, initial_capacity, 60.);
+    err = feature_vector_append_locked(feature_vector, initial_capacity, 60.,
+                                       NULL);
     mu_assert("problem during feature_vector_append", !err);
     mu_assert("feature_vector->capacity did not double its allocation",
               feature_vector->capacity == initial_capacity * 2);
-    err = feature_vector_append(feature_vector, initial_capacity, 60.);
+    err = feature_vector_append_locked(feature_vector, initial_capacity, 60.,
+                                       NULL);
     mu_assert("feature_vector_append should not overwrite", err);
 
     feature_vector_destroy(feature_vector);
@@ -156,10 +161,401 @@ static char *test_feature_collector_init_append_get_and_destroy()
     return NULL;
 }
 
+static char *test_feature_collector_register_and_append_by_id()
+{
+    int err;
+
+    VmafFeatureCollector *feature_collector;
+    err = vmaf_feature_collector_init(&feature_collector);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+
+    unsigned id_a, id_b, id_c;
+    err  = vmaf_feature_collector_register(feature_collector, "feature_a",
+                                           &id_a);
+    err |= vmaf_feature_collector_register(feature_collector, "feature_b",
+                                           &id_b);
+    err |= vmaf_feature_collector_register(feature_collector, "feature_a",
+                                           &id_c);
+    mu_assert("problem during vmaf_feature_collector_register", !err);
+    mu_assert("feature ids should be unique per feature name", id_a != id_b);
+    mu_assert("registering a feature twice should return the same id",
+              id_a == id_c);
+    mu_assert("feature_collector should contain two feature vectors",
+              feature_collector->cnt == 2);
+
+    err = vmaf_feature_collector_append_by_id(feature_collector, id_b, 1., 0);
+    err |= vmaf_feature_collector_append_by_id(feature_collector, id_b, 2.,
+                                               1000);
+    mu_assert("problem during vmaf_feature_collector_append_by_id", !err);
+    err = vmaf_feature_collector_append_by_id(feature_collector, id_b, 3., 0);
+    mu_assert("vmaf_feature_collector_append_by_id should not overwrite", err);
+    err = vmaf_feature_collector_append_by_id(feature_collector, 2, 3., 0);
+    mu_assert("vmaf_feature_collector_append_by_id should fail with bad id",
+              err);
+
+    double score;
+    err = vmaf_feature_collector_get_score(feature_collector, "feature_b",
+                                           &score, 1000);
+    mu_assert("problem during vmaf_feature_collector_get_score", !err);
+    mu_assert("vmaf_feature_collector_get_score did not get the expected score",
+              score == 2.);
+    err = vmaf_feature_collector_get_score(feature_collector, "feature_b",
+                                           &score, 999);
+    mu_assert("vmaf_feature_collector_get_score did not fail with bad index",
+              err);
+    err = vmaf_feature_collector_get_score(feature_collector, "feature_a",
+                                           &score, 0);
+    mu_assert("vmaf_feature_collector_get_score did not fail without score",
+              err);
+
+    vmaf_feature_collector_destroy(feature_collector);
+    return NULL;
+}
+
+#define THREADED_APPEND_N_THREADS 8
+#define THREADED_APPEND_N_FRAMES 4096
+
+typedef struct {
+    VmafFeatureCollector *feature_collector;
+    unsigned thread_id;
+    int err;
+} ThreadedAppendData;
+
+static void *threaded_append(void *data)
+{
+    ThreadedAppendData *d = data;
+    char name[32];
+    snprintf(name, sizeof(name), "feature%d", d->thread_id % 3);
+
+    unsigned id;
+    d->err = vmaf_feature_collector_register(d->feature_collector, name, &id);
+    for (unsigned i = d->thread_id; i < THREADED_APPEND_N_FRAMES;
+         i += THREADED_APPEND_N_THREADS)
+    {
+        d->err |= vmaf_feature_collector_append_by_id(d->feature_collector,
+                                                      id, i, i);
+        d->err |= vmaf_feature_collector_append(d->feature_collector,
+                                                "shared", i, i);
+    }
+    return NULL;
+}
+
+static char *test_feature_collector_threaded_append()
+{
+    int err;
+
+    VmafFeatureCollector *feature_collector;
+    err = vmaf_feature_collector_init(&feature_collector);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+
+    pthread_t thread[THREADED_APPEND_N_THREADS];
+    ThreadedAppendData data[THREADED_APPEND_N_THREADS];
+    for (unsigned i = 0; i < THREADED_APPEND_N_THREADS; i++) {
+        data[i] = (ThreadedAppendData) {
+            .feature_collector = feature_collector,
+            .thread_id = i,
+        };
+        pthread_create(&thread[i], NULL, threaded_append, &data[i]);
+    }
+    for (unsigned i = 0; i < THREADED_APPEND_N_THREADS; i++) {
+        pthread_join(thread[i], NULL);
+        mu_assert("problem during threaded append", !data[i].err);
+    }
+
+    mu_assert("feature_collector should contain four feature vectors",
+              feature_collector->cnt == 4);
+
+    for (unsigned i = 0; i < THREADED_APPEND_N_FRAMES; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "feature%d",
+                 (i % THREADED_APPEND_N_THREADS) % 3);
+        double score;
+        err = vmaf_feature_collector_get_score(feature_collector, name,
+                                               &score, i);
+        mu_assert("problem during vmaf_feature_collector_get_score", !err);
+        mu_assert("unexpected score after threaded append", score == i);
+        err = vmaf_feature_collector_get_score(feature_collector, "shared",
+                                               &score, i);
+        mu_assert("problem during vmaf_feature_collector_get_score", !err);
+        mu_assert("unexpected score after threaded append", score == i);
+    }
+
+    vmaf_feature_collector_destroy(feature_collector);
+    return NULL;
+}
+
+typedef struct {
+    unsigned cnt;
+    unsigned index[64];
+    double score[64];
+} StreamConsumerData;
+
+static void stream_consumer(void *cookie, const char *feature_name,
+                            double score, unsigned index)
+{
+    StreamConsumerData *data = cookie;
+    if (strcmp(feature_name, "feature") || data->cnt >= 64) return;
+    data->index[data->cnt] = index;
+    data->score[data->cnt++] = score;
+}
+
+static char *test_feature_collector_stream()
+{
+    int err;
+
+    VmafFeatureCollector *feature_collector;
+    err = vmaf_feature_collector_init(&feature_collector);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+
+    StreamConsumerData data = { 0 };
+    err = vmaf_feature_collector_set_stream(feature_collector, 6, 2,
+                                            stream_consumer, &data);
+    mu_assert("problem during vmaf_feature_collector_set_stream", !err);
+
+    for (unsigned i = 0; i < 6; i++) {
+        err = vmaf_feature_collector_append(feature_collector, "feature",
+                                            10. + i, i);
+        mu_assert("problem during vmaf_feature_collector_append", !err);
+    }
+    err = vmaf_feature_collector_append(feature_collector, "feature", 16., 6);
+    mu_assert("append beyond the capacity should fail", err);
+
+    err = vmaf_feature_collector_release(feature_collector, 4);
+    mu_assert("problem during vmaf_feature_collector_release", !err);
+    mu_assert("consumer should have received the released scores in order",
+              data.cnt == 4 && data.index[0] == 0 && data.score[0] == 10. &&
+              data.index[3] == 3 && data.score[3] == 13.);
+
+    double score;
+    err = vmaf_feature_collector_get_score(feature_collector, "feature",
+                                           &score, 3);
+    mu_assert("released score should not be available", err);
+    err = vmaf_feature_collector_get_score(feature_collector, "feature",
+                                           &score, 4);
+    mu_assert("kept score should be available", !err && score == 14.);
+
+    for (unsigned i = 6; i < 10; i++) {
+        err = vmaf_feature_collector_append(feature_collector, "feature",
+                                            10. + i, i);
+        mu_assert("problem during vmaf_feature_collector_append", !err);
+    }
+    err = vmaf_feature_collector_get_score(feature_collector, "feature",
+                                           &score, 9);
+    mu_assert("score in a reused slot should be available",
+              !err && score == 19.);
+
+    err = vmaf_feature_collector_append(feature_collector, "feature", 1., 1);
+    mu_assert("a late score should be accepted", !err);
+    mu_assert("a late score should be released right away",
+              data.cnt == 5 && data.index[4] == 1 && data.score[4] == 1.);
+
+    // the late score at index 1 is not pooled, due to the subsample factor
+    FeatureScoreStats stats;
+    err = vmaf_feature_collector_get_released(feature_collector, "feature",
+                                              &stats);
+    mu_assert("problem during vmaf_feature_collector_get_released", !err);
+    mu_assert("running aggregates are off",
+              stats.cnt == 2 && stats.sum == 22. && stats.min == 10. &&
+              stats.max == 12. && stats.index_low == 0 &&
+              stats.index_high == 2 &&
+              stats.i_sum == 1. / 11. + 1. / 13.);
+
+    err = vmaf_feature_collector_release(feature_collector, 100);
+    mu_assert("problem during vmaf_feature_collector_release", !err);
+    mu_assert("consumer should have received all scores", data.cnt == 11);
+    err = vmaf_feature_collector_get_released(feature_collector, "feature",
+                                              &stats);
+    mu_assert("running aggregates are off",
+              !err && stats.cnt == 5 && stats.index_high == 8);
+
+    err = vmaf_feature_collector_set_stream(feature_collector, 6, 1, NULL,
+                                            NULL);
+    mu_assert("streaming should only be set up before registration", err);
+
+    vmaf_feature_collector_destroy(feature_collector);
+    return NULL;
+}
+
+#define STREAM_REUSE_N_FRAMES 100000
+
+typedef struct {
+    VmafFeatureCollector *feature_collector;
+    atomic_uint latest;
+    int err;
+} StreamReuseData;
+
+static void *stream_reuse_append(void *data)
+{
+    StreamReuseData *d = data;
+    for (unsigned i = 1; i < STREAM_REUSE_N_FRAMES; i++) {
+        // each append reuses the slot of the score released just before
+        if (i >= 2)
+            d->err |= vmaf_feature_collector_release(d->feature_collector,
+                                                     i - 1);
+        d->err |= vmaf_feature_collector_append(d->feature_collector,
+                                                "feature", i, i);
+        atomic_store(&d->latest, i);
+    }
+    return NULL;
+}
+
+static char *test_feature_collector_stream_reuse()
+{
+    int err;
+
+    VmafFeatureCollector *feature_collector;
+    err = vmaf_feature_collector_init(&feature_collector);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+    err = vmaf_feature_collector_set_stream(feature_collector, 2, 1, NULL,
+                                            NULL);
+    mu_assert("problem during vmaf_feature_collector_set_stream", !err);
+    err = vmaf_feature_collector_append(feature_collector, "feature", 0., 0);
+    mu_assert("problem during vmaf_feature_collector_append", !err);
+
+    StreamReuseData data = { .feature_collector = feature_collector };
+    atomic_init(&data.latest, 0);
+    pthread_t thread;
+    pthread_create(&thread, NULL, stream_reuse_append, &data);
+
+    // read the scores being released, whose slots are about to be reused
+    bool match = true;
+    unsigned latest;
+    do {
+        latest = atomic_load(&data.latest);
+        for (unsigned i = latest > 2 ? latest - 2 : 0; i <= latest; i++) {
+            double score;
+            err = vmaf_feature_collector_get_score(feature_collector,
+                                                   "feature", &score, i);
+            match &= err || score == i;
+        }
+    } while (latest < STREAM_REUSE_N_FRAMES - 1);
+
+    pthread_join(thread, NULL);
+    mu_assert("problem during the streaming appends", !data.err);
+    mu_assert("a reader should never see the score of a reused slot", match);
+
+    vmaf_feature_collector_destroy(feature_collector);
+    return NULL;
+}
+
+static char *test_feature_collector_pool()
+{
+    int err = 0;
+
+    VmafFeatureCollector *feature_collector;
+    err = vmaf_feature_collector_init(&feature_collector);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+
+    // scores at 1000 and beyond are written after the first pooling
+    const unsigned n = 1500;
+    for (unsigned i = 0; i < 1000; i++) {
+        err = vmaf_feature_collector_append(feature_collector, "feature",
+                                            (i * 37 % 101) / 4., i);
+        mu_assert("problem during vmaf_feature_collector_append", !err);
+    }
+
+    const unsigned range[][2] = {
+        { 0, 999 }, { 0, 0 }, { 5, 6 }, { 3, 700 }, { 8, 15 }, { 9, 998 },
+        { 63, 64 }, { 100, 611 }, { 0, 1499 }, { 17, 1234 }, { 999, 1499 },
+    };
+    for (unsigned r = 0; r < sizeof(range) / sizeof(range[0]); r++) {
+        const unsigned lo = range[r][0], hi = range[r][1];
+        if (r == 8) {
+            for (unsigned i = 1000; i < n; i++) {
+                err = vmaf_feature_collector_append(feature_collector,
+                                                    "feature",
+                                                    (i * 37 % 101) / 4., i);
+                mu_assert("problem during vmaf_feature_collector_append",
+                          !err);
+            }
+        }
+
+        for (unsigned step = 1; step <= 3; step += 2) {
+            FeatureScoreStats stats = { 0 }, expected = { 0 };
+            for (unsigned i = lo; i <= hi; i++) {
+                if (!(i % step))
+                    stats_fold(&expected, (i * 37 % 101) / 4., i);
+            }
+            err = vmaf_feature_collector_pool(feature_collector, "feature",
+                                              lo, hi, step, &stats);
+            mu_assert("problem during vmaf_feature_collector_pool", !err);
+            mu_assert("pooled count does not match",
+                      stats.cnt == expected.cnt);
+            mu_assert("pooled interval does not match",
+                      stats.index_low == expected.index_low &&
+                      stats.index_high == expected.index_high);
+            mu_assert("pooled min/max do not match",
+                      stats.min == expected.min && stats.max == expected.max);
+            mu_assert("pooled sums do not match",
+                      fabs(stats.sum - expected.sum) < 1e-9 &&
+                      fabs(stats.i_sum - expected.i_sum) < 1e-12);
+            if (!lo) {
+                mu_assert("pooling from 0 should keep the summation order",
+                          stats.sum == expected.sum &&
+                          stats.i_sum == expected.i_sum);
+            }
+        }
+    }
+
+    FeatureScoreStats stats = { 0 };
+    err = vmaf_feature_collector_pool(feature_collector, "feature", 0, n, 1,
+                                      &stats);
+    mu_assert("pooling a missing score should fail", err);
+    err = vmaf_feature_collector_pool(feature_collector, "missing", 0, 1, 1,
+                                      &stats);
+    mu_assert("pooling a missing feature should fail", err);
+
+    vmaf_feature_collector_destroy(feature_collector);
+    return NULL;
+}
+
+static char *test_feature_collector_pool_late()
+{
+    int err = 0;
+
+    VmafFeatureCollector *feature_collector;
+    err = vmaf_feature_collector_init(&feature_collector);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+
+    // large scores up front, which running sums carry into every later range
+    const unsigned n = 1 << 14, late = n - 1000;
+    for (unsigned i = 0; i < n; i++) {
+        const double score = i < late ? 1e9 + i / 7. : (i * 37 % 101) / 3.;
+        err = vmaf_feature_collector_append(feature_collector, "feature",
+                                            score, i);
+        mu_assert("problem during vmaf_feature_collector_append", !err);
+    }
+
+    const unsigned range[][2] = {
+        { late, n - 1 }, { late + 3, n - 5 }, { late + 64, late + 575 },
+    };
+    for (unsigned r = 0; r < sizeof(range) / sizeof(range[0]); r++) {
+        FeatureScoreStats stats = { 0 }, expected = { 0 };
+        for (unsigned i = range[r][0]; i <= range[r][1]; i++)
+            stats_fold(&expected, (i * 37 % 101) / 3., i);
+        err = vmaf_feature_collector_pool(feature_collector, "feature",
+                                          range[r][0], range[r][1], 1, &stats);
+        mu_assert("problem during vmaf_feature_collector_pool", !err);
+        mu_assert("pooled count does not match", stats.cnt == expected.cnt);
+        mu_assert("late pooled sums should match the direct sums",
+                  fabs(stats.sum - expected.sum) < 1e-9 &&
+                  fabs(stats.i_sum - expected.i_sum) < 1e-12);
+    }
+
+    vmaf_feature_collector_destroy(feature_collector);
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_feature_vector_init_append_and_destroy);
     mu_run_test(test_feature_collector_init_append_get_and_destroy);
     mu_run_test(test_aggregate_vector_init_append_and_destroy);
+    mu_run_test(test_feature_collector_register_and_append_by_id);
+    mu_run_test(test_feature_collector_threaded_append);
+    mu_run_test(test_feature_collector_stream);
+    mu_run_test(test_feature_collector_stream_reuse);
+    mu_run_test(test_feature_collector_pool);
+    mu_run_test(test_feature_collector_pool_late);
     return NULL;
 }
@@ -128,6 +128,147 @@ static char *test_feature_extractor_flush()
     return NULL;
 }
 
+static void count_done(void *cookie)
+{
+    (*(unsigned *)cookie)++;
+}
+
+static char *test_feature_extractor_extract_ordered()
+{
+    int err = 0;
+
+    VmafFeatureExtractor *fex = vmaf_get_feature_extractor_by_name("motion");
+    mu_assert("problem during vmaf_get_feature_extractor_by_name", fex);
+    mu_assert("motion should provide a prepare/reduce pair",
+              fex->prepare && fex->reduce);
+    VmafFeatureExtractorContext *fex_ctx;
+    err = vmaf_feature_extractor_context_create(&fex_ctx, fex, NULL);
+    mu_assert("problem during vmaf_feature_extractor_context_create", !err);
+
+    VmafPicture ref, dist;
+    err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+
+    VmafFeatureCollector *vfc;
+    err = vmaf_feature_collector_init(&vfc);
+    mu_assert("vmaf_feature_collector_init", !err);
+
+    unsigned seq[2];
+    for (unsigned i = 0; i < 2; i++) {
+        err = vmaf_feature_extractor_context_submit(fex_ctx, &ref, &dist,
+                                                    &seq[i]);
+        mu_assert("problem during vmaf_feature_extractor_context_submit",
+                  !err);
+    }
+    mu_assert("submission sequence should be monotonic",
+              seq[0] == 0 && seq[1] == 1);
+
+    double score;
+    unsigned done_cnt = 0;
+    err = vmaf_feature_extractor_context_extract_ordered(fex_ctx, &ref, &dist,
+                                                         1, seq[1], vfc,
+                                                         count_done, &done_cnt);
+    mu_assert("problem during vmaf_feature_extractor_context_extract_ordered",
+              !err);
+    err = vmaf_feature_collector_get_score(vfc,
+                "VMAF_integer_feature_motion2_score", &score, 0);
+    mu_assert("frame 1 should wait for frame 0 to be reduced", err);
+    mu_assert("frame 1 should not be done yet", done_cnt == 0);
+
+    err = vmaf_feature_extractor_context_extract_ordered(fex_ctx, &ref, &dist,
+                                                         0, seq[0], vfc,
+                                                         count_done, &done_cnt);
+    mu_assert("problem during vmaf_feature_extractor_context_extract_ordered",
+              !err);
+    err = vmaf_feature_collector_get_score(vfc,
+                "VMAF_integer_feature_motion2_score", &score, 0);
+    mu_assert("frame 0 should have been reduced", !err && score == 0.);
+    mu_assert("frames 0 and 1 should be done", done_cnt == 2);
+
+    err = vmaf_feature_extractor_context_flush(fex_ctx, vfc);
+    mu_assert("problem during vmaf_feature_extractor_context_flush", !err);
+    err = vmaf_feature_collector_get_score(vfc,
+                "VMAF_integer_feature_motion2_score", &score, 1);
+    mu_assert("frame 1 should have been reduced", !err && score == 0.);
+
+    err = vmaf_feature_extractor_context_close(fex_ctx);
+    mu_assert("problem during vmaf_feature_extractor_context_close", !err);
+    err = vmaf_feature_extractor_context_destroy(fex_ctx);
+    mu_assert("problem during vmaf_feature_extractor_context_destroy", !err);
+
+    vmaf_feature_collector_destroy(vfc);
+    vmaf_picture_unref(&ref);
+    vmaf_picture_unref(&dist);
+
+    return NULL;
+}
+
+static char *test_feature_extractor_extract_ordered_failed_slot()
+{
+    int err = 0;
+
+    VmafFeatureExtractor *fex = vmaf_get_feature_extractor_by_name("motion");
+    mu_assert("problem during vmaf_get_feature_extractor_by_name", fex);
+    VmafFeatureExtractorContext *fex_ctx;
+    err = vmaf_feature_extractor_context_create(&fex_ctx, fex, NULL);
+    mu_assert("problem during vmaf_feature_extractor_context_create", !err);
+
+    VmafPicture ref, dist;
+    err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+
+    VmafFeatureCollector *vfc;
+    err = vmaf_feature_collector_init(&vfc);
+    mu_assert("vmaf_feature_collector_init", !err);
+
+    unsigned seq[3];
+    for (unsigned i = 0; i < 3; i++) {
+        err = vmaf_feature_extractor_context_submit(fex_ctx, &ref, &dist,
+                                                    &seq[i]);
+        mu_assert("problem during vmaf_feature_extractor_context_submit",
+                  !err);
+    }
+
+    // slot 2 waits for slot 0, which fails, and slot 1, which is cancelled
+    unsigned done_cnt = 0;
+    err = vmaf_feature_extractor_context_extract_ordered(fex_ctx, &ref, &dist,
+                                                         2, seq[2], vfc,
+                                                         count_done, &done_cnt);
+    mu_assert("problem during vmaf_feature_extractor_context_extract_ordered",
+              !err);
+    mu_assert("frame 2 should not be done yet", done_cnt == 0);
+
+    err = vmaf_feature_extractor_context_extract_ordered(fex_ctx, &ref, NULL,
+                                                         0, seq[0], vfc,
+                                                         count_done, &done_cnt);
+    mu_assert("a slot without a distorted picture should fail", err);
+    mu_assert("a failed slot should be done", done_cnt == 1);
+    mu_assert("frame 2 should wait for frame 1", fex_ctx->pipeline.pending);
+
+    err = vmaf_feature_extractor_context_cancel(fex_ctx, seq[1]);
+    mu_assert("problem during vmaf_feature_extractor_context_cancel", !err);
+    mu_assert("frame 2 should be done", done_cnt == 2);
+    mu_assert("no slot should be left", !fex_ctx->pipeline.pending);
+
+    err = vmaf_feature_extractor_context_cancel(fex_ctx, seq[1]);
+    mu_assert("a slot can only be completed once", err);
+
+    err = vmaf_feature_extractor_context_close(fex_ctx);
+    mu_assert("problem during vmaf_feature_extractor_context_close", !err);
+    err = vmaf_feature_extractor_context_destroy(fex_ctx);
+    mu_assert("problem during vmaf_feature_extractor_context_destroy", !err);
+
+    vmaf_feature_collector_destroy(vfc);
+    vmaf_picture_unref(&ref);
+    vmaf_picture_unref(&dist);
+
+    return NULL;
+}
+
 static char *test_feature_extractor_initialization_options()
 {
     int err = 0;
@@ -175,11 +316,93 @@ static char *test_feature_extractor_initialization_options()
     return NULL;
 }
 
+typedef struct BandRows {
+    unsigned char row[1000];
+    unsigned band_of_row[1000];
+} BandRows;
+
+static void fn_band(void *data, unsigned band, unsigned row_begin,
+                    unsigned row_end)
+{
+    BandRows *rows = data;
+    for (unsigned i = row_begin; i < row_end; i++) {
+        rows->row[i]++;
+        rows->band_of_row[i] = band;
+    }
+}
+
+typedef struct NestedBands {
+    VmafFeatureExtractor *fex;
+    BandRows *rows;
+    int *err;
+} NestedBands;
+
+static void fn_nested_bands(void *data)
+{
+    NestedBands *n = data;
+    *n->err = vmaf_feature_extractor_run_bands(n->fex, 1000, 4, fn_band,
+                                              n->rows);
+}
+
+static char *test_feature_extractor_run_bands()
+{
+    int err = 0;
+
+    VmafFeatureExtractor fex = { .name = "bands" };
+    mu_assert("without a thread pool there should be a single band",
+              vmaf_feature_extractor_band_cnt(&fex, 1000) == 1);
+
+    VmafThreadPool *pool;
+    err = vmaf_thread_pool_create(&pool, 4);
+    mu_assert("problem during vmaf_thread_pool_create", !err);
+    fex.thread_pool = pool;
+
+    const unsigned band_cnt = vmaf_feature_extractor_band_cnt(&fex, 1000);
+    mu_assert("band count should follow the thread count", band_cnt == 4);
+    mu_assert("short planes should not be split",
+              vmaf_feature_extractor_band_cnt(&fex, 8) == 1);
+
+    static BandRows rows;
+    memset(&rows, 0, sizeof(rows));
+    err = vmaf_feature_extractor_run_bands(&fex, 1000, band_cnt, fn_band,
+                                           &rows);
+    mu_assert("problem during vmaf_feature_extractor_run_bands", !err);
+    for (unsigned i = 0; i < 1000; i++) {
+        mu_assert("every row should be visited exactly once",
+                  rows.row[i] == 1);
+        mu_assert("bands should be contiguous and in order",
+                  !i || rows.band_of_row[i] >= rows.band_of_row[i - 1]);
+    }
+    mu_assert("every band should run", rows.band_of_row[999] == 3);
+
+    memset(&rows, 0, sizeof(rows));
+    int nested_err = -1;
+    NestedBands nested = { .fex = &fex, .rows = &rows, .err = &nested_err };
+    err = vmaf_thread_pool_enqueue(pool, fn_nested_bands, &nested,
+                                   sizeof(nested));
+    mu_assert("problem during vmaf_thread_pool_enqueue", !err);
+    err = vmaf_thread_pool_wait(pool);
+    mu_assert("problem during vmaf_thread_pool_wait", !err);
+    mu_assert("bands run from a pool job should not fail", !nested_err);
+    for (unsigned i = 0; i < 1000; i++) {
+        mu_assert("every row should be visited exactly once",
+                  rows.row[i] == 1);
+    }
+
+    err = vmaf_thread_pool_destroy(pool);
+    mu_assert("problem during vmaf_thread_pool_destroy", !err);
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_get_feature_extractor_by_name_and_feature_name);
     mu_run_test(test_feature_extractor_context_pool);
     mu_run_test(test_feature_extractor_flush);
+    mu_run_test(test_feature_extractor_extract_ordered);
+    mu_run_test(test_feature_extractor_extract_ordered_failed_slot);
     mu_run_test(test_feature_extractor_initialization_options);
+    mu_run_test(test_feature_extractor_run_bands);
     return NULL;
 }
@@ -21,6 +21,7 @@
 #include "config.h"
 #include "test.h"
 #include "model.c"
+#include "binary_model.h"
 #include "read_json_model.h"
 
 static int model_compare(VmafModel *model_a, VmafModel *model_b)
@@ -371,6 +372,208 @@ static char *test_model_set_flags()
     return NULL;
 }
 
+static int model_compare_compiled(VmafModel *model_a, VmafModel *model_b)
+{
+    int err = model_compare(model_a, model_b);
+
+    err += strcmp(model_a->name, model_b->name) != 0;
+    err += model_a->type != model_b->type;
+    for (unsigned i = 0; i < model_a->n_features; i++) {
+        err += strcmp(model_a->feature[i].name, model_b->feature[i].name) != 0;
+        err += vmaf_dictionary_compare(model_a->feature[i].opts_dict,
+                                       model_b->feature[i].opts_dict) != 0;
+    }
+    err += model_a->score_transform.knots.n_knots !=
+           model_b->score_transform.knots.n_knots;
+
+    const struct svm_model *svm_a = model_a->svm, *svm_b = model_b->svm;
+    err += svm_a->l != svm_b->l;
+    err += svm_a->param.svm_type != svm_b->param.svm_type;
+    err += svm_a->param.gamma != svm_b->param.gamma;
+    err += svm_a->rho[0] != svm_b->rho[0];
+    if (err) return err;
+
+    double *sv_coef;
+    unsigned sv_dim, sv_stride;
+    if (vmaf_model_dense_support_vectors(model_a, &sv_coef, &sv_dim,
+                                         &sv_stride))
+    {
+        return 1;
+    }
+    err += sv_dim != model_b->sv_dim;
+    err += sv_stride != model_b->sv_stride;
+    err += model_b->sv != model_b->sv_coef + sv_stride;
+    if (!err) {
+        err += memcmp(sv_coef, model_b->sv_coef,
+                      sizeof(*sv_coef) * sv_stride * (sv_dim + 1)) != 0;
+    }
+    aligned_free(sv_coef);
+
+    return err;
+}
+
+static void put_le(uint8_t *dst, uint64_t value, unsigned sz)
+{
+    for (unsigned i = 0; i < sz; i++)
+        dst[i] = value >> (8 * i);
+}
+
+// rewrites the single model file at path as a collection of cnt copies
+static int write_binary_model_copies(const char *path, uint32_t cnt)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return -EINVAL;
+    uint8_t in[1 << 16];
+    const size_t in_sz = fread(in, 1, sizeof(in), f);
+    fclose(f);
+    if (in_sz < 32 || in_sz == sizeof(in)) return -EINVAL;
+
+    uint64_t record = 0;
+    for (unsigned i = 0; i < 8; i++)
+        record |= (uint64_t) in[24 + i] << (8 * i);
+    const size_t offset = (24 + 8 * (size_t) cnt + 63) / 64 * 64;
+    const size_t sz = offset + in_sz - record;
+    uint8_t *out = calloc(sz, 1);
+    if (!out) return -ENOMEM;
+    memcpy(out, in, 12);
+    put_le(out + 12, cnt, 4);
+    put_le(out + 16, sz, 8);
+    for (uint32_t i = 0; i < cnt; i++)
+        put_le(out + 24 + 8 * i, offset, 8);
+    memcpy(out + offset, in + record, in_sz - record);
+
+    int err = 0;
+    f = fopen(path, "wb");
+    if (!f || fwrite(out, 1, sz, f) != sz) err = -EIO;
+    if (f) fclose(f);
+    free(out);
+    return err;
+}
+
+static char *test_binary_model()
+{
+    int err;
+
+    const char *path = "test_model_binary";
+    const char *json[] = {
+        "vmaf_v0.6.1.json", "vmaf_float_v0.6.1neg.json",
+        "vmaf_4k_v0.6.1.json",
+    };
+    const uint64_t flags[] = {
+        VMAF_MODEL_FLAGS_DEFAULT, VMAF_MODEL_FLAG_DISABLE_CLIP,
+        VMAF_MODEL_FLAG_ENABLE_TRANSFORM,
+    };
+
+    for (unsigned i = 0; i < sizeof(json) / sizeof(json[0]); i++) {
+        char json_path[256];
+        snprintf(json_path, sizeof(json_path), "%s%s", JSON_MODEL_PATH,
+                 json[i]);
+
+        VmafModel *model;
+        VmafModelConfig cfg = { 0 };
+        err = vmaf_model_load_from_path(&model, &cfg, json_path);
+        mu_assert("problem during vmaf_model_load_from_path", !err);
+        err = vmaf_model_write_binary(model, NULL, path);
+        mu_assert("problem during vmaf_model_write_binary", !err);
+        vmaf_model_destroy(model);
+        mu_assert("binary model should be detected",
+                  vmaf_binary_model_probe(path));
+
+        for (unsigned j = 0; j < sizeof(flags) / sizeof(flags[0]); j++) {
+            VmafModel *model_json, *model_binary;
+            VmafModelConfig cfg = { .name = "some_vmaf", .flags = flags[j] };
+            err = vmaf_model_load_from_path(&model_json, &cfg, json_path);
+            mu_assert("problem during vmaf_model_load_from_path", !err);
+            err = vmaf_model_load_from_path(&model_binary, &cfg, path);
+            mu_assert("problem during vmaf_model_load_from_path", !err);
+            mu_assert("binary model support vectors should be mapped",
+                      model_binary->map && model_binary->sv);
+            err = model_compare_compiled(model_json, model_binary);
+            mu_assert("parsed json/binary models do not match", !err);
+            vmaf_model_destroy(model_json);
+            vmaf_model_destroy(model_binary);
+        }
+
+        VmafModel *model_collection_first;
+        VmafModelCollection *model_collection;
+        err = vmaf_model_collection_load_from_path(&model_collection_first,
+                                                   &model_collection, &cfg,
+                                                   path);
+        mu_assert("a single model should not load as a collection", err);
+    }
+    remove(path);
+
+    VmafModel *model_json, *model_binary;
+    VmafModelCollection *mc_json, *mc_binary;
+    VmafModelConfig cfg = { 0 };
+    const char *json_path = JSON_MODEL_PATH"vmaf_b_v0.6.3.json";
+    err = vmaf_model_collection_load_from_path(&model_json, &mc_json, &cfg,
+                                               json_path);
+    mu_assert("problem during vmaf_model_collection_load_from_path", !err);
+    err = vmaf_model_write_binary(model_json, mc_json, path);
+    mu_assert("problem during vmaf_model_write_binary", !err);
+    err = vmaf_model_collection_load_from_path(&model_binary, &mc_binary,
+                                               &cfg, path);
+    mu_assert("problem during vmaf_model_collection_load_from_path", !err);
+    err = vmaf_model_load_from_path(&model_binary, &cfg, path);
+    mu_assert("a collection should not load as a single model", err);
+    remove(path);
+
+    err = model_compare_compiled(model_json, model_binary);
+    mu_assert("parsed json/binary models do not match", !err);
+    mu_assert("model collections should have the same size",
+              mc_json->cnt == mc_binary->cnt && mc_json->cnt);
+    mu_assert("model collections should have the same name",
+              !strcmp(mc_json->name, mc_binary->name));
+    for (unsigned i = 0; i < mc_json->cnt; i++) {
+        err = model_compare_compiled(mc_json->model[i], mc_binary->model[i]);
+        mu_assert("parsed json/binary collections do not match", !err);
+    }
+
+    vmaf_model_destroy(model_json);
+    vmaf_model_destroy(model_binary);
+    vmaf_model_collection_destroy(mc_json);
+    vmaf_model_collection_destroy(mc_binary);
+
+    err = vmaf_model_load_from_path(&model_binary, &cfg, path);
+    mu_assert("a missing model file should be an error", err);
+
+    err = vmaf_model_load_from_path(&model_json, &cfg,
+                                    JSON_MODEL_PATH"vmaf_v0.6.1.json");
+    mu_assert("problem during vmaf_model_load_from_path", !err);
+    err = vmaf_model_write_binary(model_json, NULL, path);
+    mu_assert("problem during vmaf_model_write_binary", !err);
+    vmaf_model_destroy(model_json);
+    err = write_binary_model_copies(path, VMAF_BINARY_MODEL_MAX_CNT);
+    mu_assert("problem during write_binary_model_copies", !err);
+    err = vmaf_model_collection_load_from_path(&model_binary, &mc_binary,
+                                               &cfg, path);
+    mu_assert("problem during vmaf_model_collection_load_from_path", !err);
+    mu_assert("collection should hold all but the first model",
+              mc_binary->cnt == VMAF_BINARY_MODEL_MAX_CNT - 1);
+    mu_assert("last model of the collection has the wrong name",
+              !strcmp(mc_binary->model[mc_binary->cnt - 1]->name,
+                      "vmaf_9999"));
+    vmaf_model_destroy(model_binary);
+    vmaf_model_collection_destroy(mc_binary);
+
+    err = vmaf_model_load_from_path(&model_json, &cfg,
+                                    JSON_MODEL_PATH"vmaf_v0.6.1.json");
+    mu_assert("problem during vmaf_model_load_from_path", !err);
+    err = vmaf_model_write_binary(model_json, NULL, path);
+    mu_assert("problem during vmaf_model_write_binary", !err);
+    vmaf_model_destroy(model_json);
+    err = write_binary_model_copies(path, VMAF_BINARY_MODEL_MAX_CNT + 1);
+    mu_assert("problem during write_binary_model_copies", !err);
+    err = vmaf_model_collection_load_from_path(&model_binary, &mc_binary,
+                                               &cfg, path);
+    mu_assert("a collection over VMAF_BINARY_MODEL_MAX_CNT should be an error",
+              err);
+    remove(path);
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_json_model);
@@ -382,5 +585,6 @@ char *run_tests()
     mu_run_test(test_model_check_default_behavior_set_flags);
     mu_run_test(test_model_set_flags);
     mu_run_test(test_model_feature);
+    mu_run_test(test_binary_model);
     return NULL;
 }
@@ -0,0 +1,222 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu.h"
+#include "dict.h"
+#include "feature/feature_collector.h"
+#include "feature/feature_extractor.h"
+#include "test.h"
+#include "libvmaf/picture.h"
+
+#define FRAME_CNT 5
+
+// a noisy texture which pans by a few pixels from one frame to the next,
+// and changes its speed, so that motion and motion2 differ
+static void fill_picture(VmafPicture *pic, unsigned frame)
+{
+    const int max = (1 << pic->bpc) - 1;
+    const int mid = (max + 1) / 2;
+    const unsigned pan = frame * frame + 3 * frame;
+    uint32_t seed = frame + 1;
+
+    for (unsigned y = 0; y < pic->h[0]; y++) {
+        for (unsigned x = 0; x < pic->w[0]; x++) {
+            seed = seed * 1664525 + 1013904223;
+            const int noise = (int)(seed >> 24) - 128;
+            const unsigned u = x + pan;
+            const int texture = ((u * 7 + y * 3) % 37) * 2 - 37 +
+                                (((u / 9) + (y / 5)) % 2) * 40 - 20;
+            put_pixel(pic, x, y, mid + texture * max / 255 + noise * max / 2048);
+        }
+    }
+}
+
+static int motion_scores(VmafPicture *pic, const char *fused_sad,
+                         double *motion, double *motion2)
+{
+    int err = 0;
+
+    VmafDictionary *opts = NULL;
+    err |= vmaf_dictionary_set(&opts, "debug", "true", 0);
+    err |= vmaf_dictionary_set(&opts, "fused_sad", fused_sad, 0);
+    if (err) return err;
+
+    VmafFeatureExtractor *fex = vmaf_get_feature_extractor_by_name("motion");
+    if (!fex) return -EINVAL;
+    VmafFeatureExtractorContext *fex_ctx;
+    err = vmaf_feature_extractor_context_create(&fex_ctx, fex, opts);
+    if (err) return err;
+    VmafFeatureCollector *vfc;
+    err = vmaf_feature_collector_init(&vfc);
+    if (err) return err;
+
+    for (unsigned i = 0; !err && i < FRAME_CNT; i++) {
+        err = vmaf_feature_extractor_context_extract(fex_ctx, &pic[i], NULL,
+                                                     &pic[i], NULL, i, vfc);
+    }
+    if (!err)
+        err = vmaf_feature_extractor_context_flush(fex_ctx, vfc);
+    for (unsigned i = 0; !err && i < FRAME_CNT; i++) {
+        err = vmaf_feature_collector_get_score(vfc,
+                  "VMAF_integer_feature_motion_score", &motion[i], i);
+        err |= vmaf_feature_collector_get_score(vfc,
+                  "VMAF_integer_feature_motion2_score", &motion2[i], i);
+    }
+
+    err |= vmaf_feature_extractor_context_close(fex_ctx);
+    err |= vmaf_feature_extractor_context_destroy(fex_ctx);
+    vmaf_feature_collector_destroy(vfc);
+    return err;
+}
+
+static char *test_motion_simd_bitexact()
+{
+    int err = 0;
+
+    // odd dimensions, so that every kernel has leftover columns
+    const unsigned w[] = { 181, 97 }, h[] = { 97, 61 };
+    const unsigned bpc[] = { 8, 10, 12 };
+
+    vmaf_init_cpu();
+    const unsigned cpu_flags = vmaf_get_cpu_flags();
+
+    for (unsigned p = 0; p < 2; p++) {
+        for (unsigned b = 0; b < 3; b++) {
+            VmafPicture pic[FRAME_CNT];
+            for (unsigned i = 0; i < FRAME_CNT; i++) {
+                err = vmaf_picture_alloc(&pic[i], VMAF_PIX_FMT_YUV420P,
+                                         bpc[b], w[p], h[p]);
+                mu_assert("problem during vmaf_picture_alloc", !err);
+                fill_picture(&pic[i], i);
+            }
+
+            double expected[FRAME_CNT], expected2[FRAME_CNT];
+            vmaf_set_cpu_flags_mask(0);
+            err = motion_scores(pic, "false", expected, expected2);
+            mu_assert("problem during motion_scores", !err);
+            mu_assert("motion should see the pan", expected[FRAME_CNT - 1] > 0.);
+
+            // compare both ways of taking the sad against the scalar code
+            for_each_cpu_mask(mask, cpu_flags) {
+                vmaf_set_cpu_flags_mask(mask);
+                for (unsigned f = 0; f < 2; f++) {
+                    double motion[FRAME_CNT], motion2[FRAME_CNT];
+                    err = motion_scores(pic, f ? "true" : "false",
+                                        motion, motion2);
+                    mu_assert("problem during motion_scores", !err);
+                    for (unsigned i = 0; i < FRAME_CNT; i++) {
+                        mu_assert("motion does not match the scalar code",
+                                  motion[i] == expected[i]);
+                        mu_assert("motion2 does not match the scalar code",
+                                  motion2[i] == expected2[i]);
+                    }
+                }
+            }
+
+            for (unsigned i = 0; i < FRAME_CNT; i++)
+                vmaf_picture_unref(&pic[i]);
+        }
+    }
+    vmaf_set_cpu_flags_mask(-1);
+
+    return NULL;
+}
+
+static char *test_motion_prepare_ahead()
+{
+    int err = 0;
+
+    VmafPicture pic[FRAME_CNT];
+    for (unsigned i = 0; i < FRAME_CNT; i++) {
+        err = vmaf_picture_alloc(&pic[i], VMAF_PIX_FMT_YUV420P, 8, 181, 97);
+        mu_assert("problem during vmaf_picture_alloc", !err);
+        fill_picture(&pic[i], i);
+    }
+
+    double expected[FRAME_CNT], expected2[FRAME_CNT];
+    err = motion_scores(pic, "false", expected, expected2);
+    mu_assert("problem during motion_scores", !err);
+
+    VmafDictionary *opts = NULL;
+    err = vmaf_dictionary_set(&opts, "debug", "true", 0);
+    mu_assert("problem during vmaf_dictionary_set", !err);
+    VmafFeatureExtractor *fex = vmaf_get_feature_extractor_by_name("motion");
+    mu_assert("problem during vmaf_get_feature_extractor_by_name", fex);
+    VmafFeatureExtractorContext *fex_ctx;
+    err = vmaf_feature_extractor_context_create(&fex_ctx, fex, opts);
+    mu_assert("problem during vmaf_feature_extractor_context_create", !err);
+    VmafFeatureCollector *vfc;
+    err = vmaf_feature_collector_init(&vfc);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+
+    unsigned seq[FRAME_CNT];
+    for (unsigned i = 0; i < FRAME_CNT; i++) {
+        err = vmaf_feature_extractor_context_submit(fex_ctx, &pic[i], &pic[i],
+                                                    &seq[i]);
+        mu_assert("problem during vmaf_feature_extractor_context_submit",
+                  !err);
+    }
+
+    // the last picture first, so that every picture is blurred before any
+    // of them is reduced, which holds more blurred pictures than the pool of
+    // a context without a thread pool
+    for (unsigned i = FRAME_CNT; i--; ) {
+        err = vmaf_feature_extractor_context_extract_ordered(fex_ctx, &pic[i],
+                  &pic[i], i, seq[i], vfc, NULL, NULL);
+        mu_assert("problem during vmaf_feature_extractor_context_extract_ordered",
+                  !err);
+    }
+    err = vmaf_feature_extractor_context_flush(fex_ctx, vfc);
+    mu_assert("problem during vmaf_feature_extractor_context_flush", !err);
+
+    for (unsigned i = 0; i < FRAME_CNT; i++) {
+        double motion, motion2;
+        err = vmaf_feature_collector_get_score(vfc,
+                  "VMAF_integer_feature_motion_score", &motion, i);
+        err |= vmaf_feature_collector_get_score(vfc,
+                  "VMAF_integer_feature_motion2_score", &motion2, i);
+        mu_assert("problem during vmaf_feature_collector_get_score", !err);
+        mu_assert("motion does not match in order extraction",
+                  motion == expected[i] && motion2 == expected2[i]);
+    }
+
+    err = vmaf_feature_extractor_context_close(fex_ctx);
+    mu_assert("problem during vmaf_feature_extractor_context_close", !err);
+    err = vmaf_feature_extractor_context_destroy(fex_ctx);
+    mu_assert("problem during vmaf_feature_extractor_context_destroy", !err);
+    vmaf_feature_collector_destroy(vfc);
+
+    // the blurred pictures are cached on the pictures, and go back to the
+    // closed pool only now
+    for (unsigned i = 0; i < FRAME_CNT; i++)
+        vmaf_picture_unref(&pic[i]);
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_motion_simd_bitexact);
+    mu_run_test(test_motion_prepare_ahead);
+    return NULL;
+}
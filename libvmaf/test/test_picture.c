@@ -16,10 +16,17 @@
  *
  */
 
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdint.h>
+#include <string.h>
+#include <time.h>
 
 #include "test.h"
 #include "picture.h"
+#include "picture_cache.h"
 #include "libvmaf/picture.h"
 #include "ref.h"
 
@@ -65,9 +72,383 @@ static char *test_picture_data_alignment()
     return NULL;
 }
 
+static unsigned fill_cnt;
+
+static int fill_param(VmafPicture *pic, int param, void *data, void *cookie)
+{
+    (void) pic;
+    (void) cookie;
+    fill_cnt++;
+    *(int *) data = param;
+    return 0;
+}
+
+static int fill_fail(VmafPicture *pic, int param, void *data, void *cookie)
+{
+    (void) pic;
+    (void) param;
+    (void) data;
+    (void) cookie;
+    fill_cnt++;
+    return -ENOMEM;
+}
+
+static char *test_picture_cache()
+{
+    int err;
+
+    VmafPictureCache *cache;
+    err = vmaf_picture_cache_init(&cache);
+    mu_assert("problem during vmaf_picture_cache_init", !err);
+
+    VmafPicture pic_a, pic_b;
+    err = vmaf_picture_alloc(&pic_a, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_picture_cache_attach(cache, &pic_a);
+    mu_assert("problem during vmaf_picture_cache_attach", !err);
+    err = vmaf_picture_ref(&pic_b, &pic_a);
+    mu_assert("problem during vmaf_picture_ref", !err);
+
+    fill_cnt = 0;
+    const int *a = vmaf_picture_cache_get(&pic_a, VMAF_PICTURE_CACHE_FLOAT_LUMA,
+                                          1, sizeof(int), fill_param, NULL);
+    const int *b = vmaf_picture_cache_get(&pic_b, VMAF_PICTURE_CACHE_FLOAT_LUMA,
+                                          1, sizeof(int), fill_param, NULL);
+    mu_assert("references of a picture should share an entry",
+              a && a == b && *a == 1 && fill_cnt == 1);
+    const int *c = vmaf_picture_cache_get(&pic_a, VMAF_PICTURE_CACHE_FLOAT_LUMA,
+                                          2, sizeof(int), fill_param, NULL);
+    mu_assert("another param should get its own entry",
+              c && c != a && *c == 2 && fill_cnt == 2);
+    const int *e = vmaf_picture_cache_get(&pic_a, VMAF_PICTURE_CACHE_FLOAT_LUMA,
+                                          4, sizeof(int), fill_fail, NULL);
+    mu_assert("a failed fill should not return data", !e && fill_cnt == 3);
+    e = vmaf_picture_cache_get(&pic_b, VMAF_PICTURE_CACHE_FLOAT_LUMA, 4,
+                               sizeof(int), fill_param, NULL);
+    mu_assert("a failed fill should be retried",
+              e && *e == 4 && fill_cnt == 4);
+
+    err = vmaf_picture_unref(&pic_a);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    err = vmaf_picture_unref(&pic_b);
+    mu_assert("problem during vmaf_picture_unref", !err);
+
+    // the next picture reuses the buffers released to the cache
+    err = vmaf_picture_alloc(&pic_a, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    err = vmaf_picture_cache_attach(cache, &pic_a);
+    mu_assert("problem during vmaf_picture_cache_attach", !err);
+    const int *d = vmaf_picture_cache_get(&pic_a, VMAF_PICTURE_CACHE_FLOAT_LUMA,
+                                          3, sizeof(int), fill_param, NULL);
+    mu_assert("released buffers should be recycled",
+              (d == a || d == c || d == e) && *d == 3 && fill_cnt == 5);
+
+    // the picture keeps the cache alive past its destruction
+    err = vmaf_picture_cache_destroy(cache);
+    mu_assert("problem during vmaf_picture_cache_destroy", !err);
+    err = vmaf_picture_unref(&pic_a);
+    mu_assert("problem during vmaf_picture_unref", !err);
+
+    return NULL;
+}
+
+static char *test_picture_cache_share()
+{
+    int err = 0;
+
+    VmafPicture pic, pic_ref;
+    err = vmaf_picture_alloc(&pic, VMAF_PIX_FMT_YUV400P, 8, 16, 16);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    mu_assert("a new picture should not be shared",
+              !vmaf_picture_cache_shared(&pic));
+
+    err = vmaf_picture_cache_share(&pic);
+    mu_assert("problem during vmaf_picture_cache_share", !err);
+    err = vmaf_picture_ref(&pic_ref, &pic);
+    mu_assert("problem during vmaf_picture_ref", !err);
+    mu_assert("every reference should see the picture as shared",
+              vmaf_picture_cache_shared(&pic) &&
+              vmaf_picture_cache_shared(&pic_ref));
+
+    err = vmaf_picture_unref(&pic_ref);
+    err |= vmaf_picture_unref(&pic);
+    mu_assert("problem during vmaf_picture_unref", !err);
+
+    return NULL;
+}
+
+#define CACHE_THREAD_CNT 8
+
+typedef struct CacheRace {
+    VmafPicture *pic;
+    VmafPictureCache *cache;
+    atomic_uint thread_cnt, fill_cnt;
+    const void *data[CACHE_THREAD_CNT];
+} CacheRace;
+
+static int fill_cnt_atomic(VmafPicture *pic, int param, void *data,
+                           void *cookie)
+{
+    (void) pic;
+    atomic_fetch_add(&((CacheRace *) cookie)->fill_cnt, 1);
+    *(int *) data = param;
+    return 0;
+}
+
+static void *cache_race_thread(void *arg)
+{
+    CacheRace *race = arg;
+    const unsigned i = atomic_fetch_add(&race->thread_cnt, 1);
+    vmaf_picture_cache_attach(race->cache, race->pic);
+    race->data[i] = vmaf_picture_cache_get(race->pic,
+                                           VMAF_PICTURE_CACHE_FLOAT_LUMA, 7,
+                                           sizeof(int), fill_cnt_atomic, race);
+    return NULL;
+}
+
+static char *test_picture_cache_concurrent()
+{
+    int err = 0;
+
+    VmafPictureCache *cache;
+    err = vmaf_picture_cache_init(&cache);
+    mu_assert("problem during vmaf_picture_cache_init", !err);
+
+    // threads racing to set up the cache of a fresh picture all end up
+    // with the same entry, filled once
+    for (unsigned n = 0; n < 16; n++) {
+        VmafPicture pic;
+        err = vmaf_picture_alloc(&pic, VMAF_PIX_FMT_YUV400P, 8, 16, 16);
+        mu_assert("problem during vmaf_picture_alloc", !err);
+
+        CacheRace race = { .pic = &pic, .cache = cache };
+        atomic_init(&race.thread_cnt, 0);
+        atomic_init(&race.fill_cnt, 0);
+        pthread_t thread[CACHE_THREAD_CNT];
+        for (unsigned i = 0; i < CACHE_THREAD_CNT; i++)
+            pthread_create(&thread[i], NULL, cache_race_thread, &race);
+        for (unsigned i = 0; i < CACHE_THREAD_CNT; i++)
+            pthread_join(thread[i], NULL);
+
+        mu_assert("the entry should be filled once",
+                  atomic_load(&race.fill_cnt) == 1);
+        for (unsigned i = 0; i < CACHE_THREAD_CNT; i++) {
+            mu_assert("every thread should get the same entry",
+                      race.data[i] && race.data[i] == race.data[0] &&
+                      *(const int *) race.data[i] == 7);
+        }
+        vmaf_picture_unref(&pic);
+    }
+
+    err = vmaf_picture_cache_destroy(cache);
+    mu_assert("problem during vmaf_picture_cache_destroy", !err);
+
+    return NULL;
+}
+
+static int fill_picture(VmafPicture *pic, int param, void *data,
+                        void *cookie)
+{
+    (void) param;
+    (void) cookie;
+    fill_cnt++;
+    return vmaf_picture_alloc(data, VMAF_PIX_FMT_YUV400P, 16, pic->w[0],
+                              pic->h[0]);
+}
+
+static char *test_picture_cache_picture()
+{
+    int err;
+
+    VmafPicture pic, held;
+    err = vmaf_picture_alloc(&pic, VMAF_PIX_FMT_YUV420P, 8, 64, 64);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+
+    fill_cnt = 0;
+    const VmafPicture *a =
+        vmaf_picture_cache_get(&pic, VMAF_PICTURE_CACHE_MOTION_BLUR, 0,
+                               sizeof(*a), fill_picture, NULL);
+    const VmafPicture *b =
+        vmaf_picture_cache_get(&pic, VMAF_PICTURE_CACHE_MOTION_BLUR, 0,
+                               sizeof(*b), fill_picture, NULL);
+    mu_assert("the picture should be derived once",
+              a && a == b && fill_cnt == 1 && a->w[0] == 64);
+    err = vmaf_picture_ref(&held, (VmafPicture *) a);
+    mu_assert("problem during vmaf_picture_ref", !err);
+
+    // the entry drops its reference, held stays valid
+    err = vmaf_picture_unref(&pic);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    memset(held.data[0], 0, held.stride[0] * held.h[0]);
+    err = vmaf_picture_unref(&held);
+    mu_assert("problem during vmaf_picture_unref", !err);
+
+    return NULL;
+}
+
+static char *test_picture_pool()
+{
+    int err;
+
+    VmafPicturePool *pool;
+    err = vmaf_picture_pool_init(&pool, VMAF_PIX_FMT_YUV420P, 10, 64, 48, 2);
+    mu_assert("problem during vmaf_picture_pool_init", !err);
+
+    VmafPicture pic_a, pic_b, pic_c;
+    err = vmaf_picture_pool_get(pool, &pic_a);
+    mu_assert("problem during vmaf_picture_pool_get", !err);
+    err = vmaf_picture_pool_get(pool, &pic_b);
+    mu_assert("problem during vmaf_picture_pool_get", !err);
+    mu_assert("pooled picture has the wrong geometry",
+              pic_a.pix_fmt == VMAF_PIX_FMT_YUV420P && pic_a.bpc == 10 &&
+              pic_a.w[0] == 64 && pic_a.h[0] == 48 &&
+              pic_a.w[1] == 32 && pic_a.h[1] == 24);
+    mu_assert("pooled pictures should not share data",
+              pic_a.data[0] != pic_b.data[0]);
+
+    // the last unref returns the picture to the pool
+    void *data_a = pic_a.data[0];
+    err = vmaf_picture_ref(&pic_c, &pic_a);
+    mu_assert("problem during vmaf_picture_ref", !err);
+    err = vmaf_picture_unref(&pic_a);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    err = vmaf_picture_unref(&pic_c);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    err = vmaf_picture_pool_get(pool, &pic_a);
+    mu_assert("problem during vmaf_picture_pool_get", !err);
+    mu_assert("returned picture should be reused", pic_a.data[0] == data_a);
+
+    // pictures in flight keep the pool alive past its closing
+    err = vmaf_picture_pool_close(pool);
+    mu_assert("problem during vmaf_picture_pool_close", !err);
+    err = vmaf_picture_unref(&pic_a);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    err = vmaf_picture_unref(&pic_b);
+    mu_assert("problem during vmaf_picture_unref", !err);
+
+    return NULL;
+}
+
+typedef struct PoolWaiter {
+    VmafPicturePool *pool;
+    atomic_bool waiting;
+    int err;
+} PoolWaiter;
+
+static void *pool_waiter(void *data)
+{
+    PoolWaiter *w = data;
+    VmafPicture pic;
+    atomic_store(&w->waiting, true);
+    w->err = vmaf_picture_pool_get(w->pool, &pic);
+    if (!w->err) vmaf_picture_unref(&pic);
+    return NULL;
+}
+
+static char *test_picture_pool_close_waiting()
+{
+    int err;
+
+    // closing wakes the threads waiting for a picture and the pool outlives
+    // them, even when the last picture comes back in between
+    PoolWaiter w = { .waiting = false };
+    err = vmaf_picture_pool_init(&w.pool, VMAF_PIX_FMT_YUV400P, 8, 16, 16, 1);
+    mu_assert("problem during vmaf_picture_pool_init", !err);
+    VmafPicture pic;
+    err = vmaf_picture_pool_get(w.pool, &pic);
+    mu_assert("problem during vmaf_picture_pool_get", !err);
+
+    pthread_t thread;
+    err = pthread_create(&thread, NULL, pool_waiter, &w);
+    mu_assert("problem during pthread_create", !err);
+    while (!atomic_load(&w.waiting))
+        sched_yield();
+    nanosleep(&(struct timespec) { .tv_nsec = 10000000 }, NULL);
+    err = vmaf_picture_pool_close(w.pool);
+    mu_assert("problem during vmaf_picture_pool_close", !err);
+    err = vmaf_picture_unref(&pic);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    pthread_join(thread, NULL);
+    mu_assert("a get waiting on a closed pool should fail", w.err == -EINVAL);
+
+    return NULL;
+}
+
+static void release_cnt(VmafPicture *pic, void *cookie)
+{
+    (void) pic;
+    (*(unsigned *) cookie)++;
+}
+
+static char *test_picture_wrap()
+{
+    int err;
+
+    VmafPicture buf;
+    err = vmaf_picture_alloc(&buf, VMAF_PIX_FMT_YUV420P, 8, 64, 48);
+    mu_assert("problem during vmaf_picture_alloc", !err);
+    for (unsigned i = 0; i < 3; i++)
+        memset(buf.data[i], i + 1, buf.stride[i] * buf.h[i]);
+
+    // data with the layout of vmaf_picture_alloc() is not copied
+    unsigned release_cnt_a = 0;
+    VmafPicture pic_a, pic_b;
+    err = vmaf_picture_wrap(&pic_a, VMAF_PIX_FMT_YUV420P, 8, 64, 48,
+                            buf.data, buf.stride, release_cnt, &release_cnt_a);
+    mu_assert("problem during vmaf_picture_wrap", !err);
+    mu_assert("aligned data should be wrapped as is",
+              pic_a.data[0] == buf.data[0] && pic_a.data[2] == buf.data[2] &&
+              pic_a.stride[1] == buf.stride[1] && pic_a.w[1] == 32);
+    err = vmaf_picture_ref(&pic_b, &pic_a);
+    mu_assert("problem during vmaf_picture_ref", !err);
+    err = vmaf_picture_unref(&pic_a);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    mu_assert("release should wait for the last reference", !release_cnt_a);
+    err = vmaf_picture_unref(&pic_b);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    mu_assert("release should be called once", release_cnt_a == 1);
+
+    // unaligned data is copied and handed back right away
+    unsigned release_cnt_b = 0;
+    void *data[3] = {
+        (uint8_t *) buf.data[0] + 1, (uint8_t *) buf.data[1] + 1,
+        (uint8_t *) buf.data[2] + 1,
+    };
+    err = vmaf_picture_wrap(&pic_a, VMAF_PIX_FMT_YUV420P, 8, 62, 46,
+                            data, buf.stride, release_cnt, &release_cnt_b);
+    mu_assert("problem during vmaf_picture_wrap", !err);
+    mu_assert("unaligned data should be copied",
+              pic_a.data[0] != data[0] && release_cnt_b == 1);
+    mu_assert("copied data should match",
+              ((uint8_t *) pic_a.data[0])[61] == 1 &&
+              ((uint8_t *) pic_a.data[1])[30] == 2 &&
+              ((uint8_t *) pic_a.data[2])[pic_a.stride[2] * 22] == 3);
+    err = vmaf_picture_unref(&pic_a);
+    mu_assert("problem during vmaf_picture_unref", !err);
+    mu_assert("copied data should not be released twice", release_cnt_b == 1);
+
+    err = vmaf_picture_wrap(&pic_a, VMAF_PIX_FMT_YUV420P, 8, 64, 48,
+                            buf.data, buf.stride, NULL, NULL);
+    mu_assert("problem during vmaf_picture_wrap", !err);
+    err = vmaf_picture_unref(&pic_a);
+    mu_assert("problem during vmaf_picture_unref", !err);
+
+    err = vmaf_picture_unref(&buf);
+    mu_assert("problem during vmaf_picture_unref", !err);
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_picture_alloc_ref_and_unref);
     mu_run_test(test_picture_data_alignment);
+    mu_run_test(test_picture_cache);
+    mu_run_test(test_picture_cache_picture);
+    mu_run_test(test_picture_cache_concurrent);
+    mu_run_test(test_picture_cache_share);
+    mu_run_test(test_picture_pool);
+    mu_run_test(test_picture_pool_close_waiting);
+    mu_run_test(test_picture_wrap);
     return NULL;
 }
@@ -57,6 +57,143 @@ static char *test_predict_score_at_index()
     return NULL;
 }
 
+static char *test_predict_scores_range()
+{
+    int err;
+
+    VmafFeatureCollector *feature_collector;
+    err = vmaf_feature_collector_init(&feature_collector);
+    mu_assert("problem during vmaf_feature_collector_init", !err);
+
+    VmafModel *model;
+    VmafModelConfig cfg = {
+        .name = "vmaf",
+        .flags = VMAF_MODEL_FLAGS_DEFAULT,
+    };
+    err = vmaf_model_load(&model, &cfg, "vmaf_v0.6.1");
+    mu_assert("problem during vmaf_model_load", !err);
+
+    const unsigned frame_cnt = 150;
+    for (unsigned i = 0; i < model->n_features; i++) {
+        for (unsigned j = 0; j < frame_cnt; j++) {
+            const double score = (i + 1) * 0.1 + j * 0.01 + (j % 7) * 0.05;
+            err = vmaf_feature_collector_append(feature_collector,
+                                                model->feature[i].name,
+                                                score, j);
+            mu_assert("problem during vmaf_feature_collector_append", !err);
+        }
+    }
+
+    double scores[150];
+    err = vmaf_predict_scores_range(model, feature_collector, 0, frame_cnt - 1,
+                                    1, scores, false, 0);
+    mu_assert("problem during vmaf_predict_scores_range", !err);
+    mu_assert("dense support vectors should be used for the RBF kernel",
+              model->sv != NULL);
+
+    // batches should match the libsvm prediction of single frames exactly
+    struct svm_node node[32];
+    mu_assert("too many model features", model->n_features < 32);
+    for (unsigned j = 0; j < frame_cnt; j++) {
+        for (unsigned i = 0; i < model->n_features; i++) {
+            double score;
+            err = vmaf_feature_collector_get_score(feature_collector,
+                                                   model->feature[i].name,
+                                                   &score, j);
+            mu_assert("problem during vmaf_feature_collector_get_score", !err);
+            normalize(model, model->feature[i].slope,
+                      model->feature[i].intercept, &score);
+            node[i].index = i + 1;
+            node[i].value = score;
+        }
+        node[model->n_features].index = -1;
+        double prediction = svm_predict(model->svm, node);
+        denormalize(model, &prediction);
+        transform(model, &prediction, 0);
+        clip(model, &prediction, 0);
+        mu_assert("batched prediction does not match svm_predict()",
+                  scores[j] == prediction);
+    }
+
+    double stepped[50];
+    err = vmaf_predict_scores_range(model, feature_collector, 1, frame_cnt - 1,
+                                    3, stepped, true, 0);
+    mu_assert("problem during vmaf_predict_scores_range", !err);
+    for (unsigned j = 0; j < 50; j++) {
+        double score;
+        err = vmaf_feature_collector_get_score(feature_collector, "vmaf",
+                                               &score, 1 + j * 3);
+        mu_assert("prediction was not written", !err);
+        mu_assert("stepped prediction does not match",
+                  stepped[j] == scores[1 + j * 3] && score == stepped[j]);
+    }
+
+    err = vmaf_predict_scores_range(model, feature_collector, 0, frame_cnt, 1,
+                                    scores, false, 0);
+    mu_assert("missing features should be an error", err);
+
+    vmaf_model_destroy(model);
+    vmaf_feature_collector_destroy(feature_collector);
+    return NULL;
+}
+
+static char *test_predict_batch_simd()
+{
+    int err;
+
+    VmafModel *model;
+    VmafModelConfig cfg = {
+        .name = "vmaf",
+        .flags = VMAF_MODEL_FLAGS_DEFAULT,
+    };
+    err = vmaf_model_load(&model, &cfg, "vmaf_4k_v0.6.1");
+    mu_assert("problem during vmaf_model_load", !err);
+    err = predict_init(model);
+    mu_assert("problem during predict_init", !err);
+    mu_assert("dense support vectors should be padded",
+              model->sv_stride % VMAF_MODEL_SV_ALIGN == 0 &&
+              model->sv_stride >= (unsigned) model->svm->l);
+
+    const unsigned cnt = 37, dim = model->sv_dim;
+    double x[37 * 8], y[37];
+    struct svm_node node[8];
+    mu_assert("too many model features", dim < 8);
+    for (unsigned c = 0; c < cnt; c++) {
+        for (unsigned i = 0; i < dim; i++)
+            x[c * dim + i] = (c % 11) * 0.3 - 1. + i * 0.07 + (c == 5) * 40.;
+    }
+
+    // the vectorized kernels match libsvm up to rounding, unlike the
+    // scalar one they do not sum the support vectors in order
+    vmaf_init_cpu();
+    const unsigned cpu_flags = vmaf_get_cpu_flags();
+    for_each_cpu_mask(mask, cpu_flags) {
+        vmaf_set_cpu_flags_mask(mask);
+        svm_predict_batch(model, x, cnt, y, node);
+        for (unsigned c = 0; c < cnt; c++) {
+            for (unsigned i = 0; i < dim; i++) {
+                node[i].index = i + 1;
+                node[i].value = x[c * dim + i];
+            }
+            node[dim].index = -1;
+            const double prediction = svm_predict(model->svm, node);
+            if (!mask) {
+                mu_assert("scalar prediction does not match svm_predict()",
+                          y[c] == prediction);
+            } else {
+                mu_assert("vectorized prediction does not match "
+                          "svm_predict()",
+                          fabs(y[c] - prediction) <=
+                          1e-12 * (1. + fabs(prediction)));
+            }
+        }
+    }
+    vmaf_set_cpu_flags_mask(-1);
+
+    vmaf_model_destroy(model);
+    return NULL;
+}
+
 static char *test_find_linear_function_parameters()
 {
     int err;
@@ -171,6 +308,8 @@ static char *test_piecewise_linear_mapping()
 char *run_tests()
 {
     mu_run_test(test_predict_score_at_index);
+    mu_run_test(test_predict_scores_range);
+    mu_run_test(test_predict_batch_simd);
     mu_run_test(test_find_linear_function_parameters);
     mu_run_test(test_piecewise_linear_mapping);
     return NULL;
@@ -0,0 +1,115 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "test.h"
+#include "extract.h"
+
+#include "cpu.h"
+
+static uint64_t sse_ref(const VmafPicture *ref, const VmafPicture *dis)
+{
+    uint64_t sse = 0;
+    for (unsigned i = 0; i < ref->h[0]; i++) {
+        for (unsigned j = 0; j < ref->w[0]; j++) {
+            int64_t r, d;
+            if (ref->bpc == 8) {
+                r = ((const uint8_t *)ref->data[0])[i * ref->stride[0] + j];
+                d = ((const uint8_t *)dis->data[0])[i * dis->stride[0] + j];
+            } else {
+                r = ((const uint16_t *)ref->data[0])[i * ref->stride[0] / 2 + j];
+                d = ((const uint16_t *)dis->data[0])[i * dis->stride[0] / 2 + j];
+            }
+            sse += (r - d) * (r - d);
+        }
+    }
+    return sse;
+}
+
+static void fill_pictures(VmafPicture *ref, VmafPicture *dis, uint32_t seed)
+{
+    const int max = (1 << ref->bpc) - 1;
+    for (unsigned i = 0; i < ref->h[0]; i++) {
+        for (unsigned j = 0; j < ref->w[0]; j++) {
+            lcg_next(&seed);
+            int r = (seed >> 8) & max, d = (seed >> 12) & max;
+            // rows of maximal differences stress the accumulator widths
+            if (i % 4 == 1) r = max, d = 0;
+            if (i % 4 == 2) r = 0, d = max;
+            put_pixel(ref, j, i, r);
+            put_pixel(dis, j, i, d);
+        }
+    }
+}
+
+static char *test_psnr_sse_simd()
+{
+    static const unsigned bpc[] = { 8, 10, 12, 16 };
+    static const unsigned dim[][2] = {
+        { 1, 1 }, { 7, 3 }, { 65, 9 }, { 351, 17 }, { 1920, 12 }, { 4099, 5 },
+    };
+    const char *mse_name[] = { "mse_y" };
+
+    vmaf_init_cpu();
+    const unsigned cpu_flags = vmaf_get_cpu_flags();
+
+    for (unsigned b = 0; b < sizeof(bpc) / sizeof(bpc[0]); b++) {
+        for (unsigned k = 0; k < sizeof(dim) / sizeof(dim[0]); k++) {
+            const unsigned w = dim[k][0], h = dim[k][1];
+            VmafPicture ref, dis;
+            int err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV400P, bpc[b],
+                                         w, h);
+            mu_assert("problem during vmaf_picture_alloc", !err);
+            err = vmaf_picture_alloc(&dis, VMAF_PIX_FMT_YUV400P, bpc[b], w, h);
+            if (err) vmaf_picture_unref(&ref);
+            mu_assert("problem during vmaf_picture_alloc", !err);
+            fill_pictures(&ref, &dis, w * 31 + bpc[b]);
+
+            // the scalar code runs last, with a mask of 0
+            const double expected = (double) sse_ref(&ref, &dis) / (w * h);
+            bool match = true;
+            for_each_cpu_mask(mask, cpu_flags) {
+                vmaf_set_cpu_flags_mask(mask);
+                VmafDictionary *opts = NULL;
+                double mse;
+                err = vmaf_dictionary_set(&opts, "enable_mse", "true", 0);
+                if (!err) {
+                    err = extract_scores("psnr", opts, &ref, &dis, mse_name,
+                                         1, &mse);
+                }
+                if (err) break;
+                match &= mse == expected;
+            }
+            vmaf_set_cpu_flags_mask(-1);
+            vmaf_picture_unref(&ref);
+            vmaf_picture_unref(&dis);
+            mu_assert("problem during extract_scores", !err);
+            mu_assert("sse does not match the reference", match);
+        }
+    }
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_psnr_sse_simd);
+    return NULL;
+}
@@ -0,0 +1,103 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "test.h"
+#include "extract.h"
+
+#include "cpu.h"
+
+static void fill_pictures(VmafPicture *ref, VmafPicture *dist, uint32_t seed)
+{
+    const int max = (1 << ref->bpc) - 1;
+    for (unsigned p = 0; p < 3; p++) {
+        for (unsigned i = 0; i < ref->h[p]; i++) {
+            for (unsigned j = 0; j < ref->w[p]; j++) {
+                lcg_next(&seed);
+                // a gradient with texture in some places, so that both the
+                // masked and the unmasked paths of the error terms are taken
+                int r = (int) ((i * 7 + j * 3) << (ref->bpc - 8)) & max;
+                if ((i / 8 + j / 8) % 3 == 0) r = (seed >> 8) & max;
+                int d = r;
+                if ((i / 8 + j / 16) % 2) d += (int) ((seed >> 4) & 31) - 16;
+                if (i % 16 == 5 && j % 5 == 0) d = (seed >> 12) & max;
+                put_sample(ref, p, j, i, r);
+                put_sample(dist, p, j, i, d);
+            }
+        }
+    }
+}
+
+static char *test_psnr_hvs_simd()
+{
+    enum { W = 181, H = 45 };
+    static const unsigned bpc[] = { 8, 10, 12 };
+    const char *score_name[] = {
+        "psnr_hvs_y", "psnr_hvs_cb", "psnr_hvs_cr", "psnr_hvs",
+    };
+
+    vmaf_init_cpu();
+    const unsigned cpu_flags = vmaf_get_cpu_flags();
+
+    for (unsigned b = 0; b < sizeof(bpc) / sizeof(bpc[0]); b++) {
+        // every count of leftover 8x8 blocks per row, for each vector width
+        for (unsigned w = W - 16; w <= W; w += 4) {
+            VmafPicture ref, dist;
+            int err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV420P, bpc[b],
+                                         w, H);
+            mu_assert("problem during vmaf_picture_alloc", !err);
+            err = vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV420P, bpc[b],
+                                     w, H);
+            if (err) vmaf_picture_unref(&ref);
+            mu_assert("problem during vmaf_picture_alloc", !err);
+            fill_pictures(&ref, &dist, w + bpc[b]);
+
+            double expected[4], scores[4];
+            bool match = true;
+            vmaf_set_cpu_flags_mask(0);
+            err = extract_scores("psnr_hvs", NULL, &ref, &dist, score_name, 4,
+                                 expected);
+            // compare against the scalar code
+            for_each_cpu_mask(mask, cpu_flags) {
+                if (err) break;
+                vmaf_set_cpu_flags_mask(mask);
+                err = extract_scores("psnr_hvs", NULL, &ref, &dist,
+                                     score_name, 4, scores);
+                for (unsigned i = 0; i < 4; i++)
+                    match &= scores[i] == expected[i];
+            }
+            vmaf_set_cpu_flags_mask(-1);
+            vmaf_picture_unref(&ref);
+            vmaf_picture_unref(&dist);
+            mu_assert("problem during extract_scores", !err);
+            mu_assert("SIMD psnr_hvs does not match the scalar psnr_hvs",
+                      match);
+        }
+    }
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_psnr_hvs_simd);
+    return NULL;
+}
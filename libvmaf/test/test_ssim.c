@@ -0,0 +1,253 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "extract.h"
+
+#include "cpu.h"
+#include "feature/iqa/decimate.h"
+#include "feature/iqa/ssim_tools.h"
+
+static void fill(float *ref, float *cmp, int w, int h, int stride,
+                 uint32_t seed)
+{
+    for (int i = 0; i < h; i++) {
+        for (int j = 0; j < w; j++) {
+            lcg_next(&seed);
+            const float r = (i / 16 + j / 16) % 3 ? (seed >> 24) : 128.f;
+            ref[i * stride + j] = r;
+            // identical flat areas in cmp exercise the corner cases of s
+            cmp[i * stride + j] = (i / 8) % 2 ? r : r + ((seed >> 8) & 15);
+        }
+    }
+}
+
+static char *check_engine(struct _ssim_engine *e, int w, int h, int stride,
+                          const struct _kernel *k)
+{
+    float *ref = malloc(sizeof(float) * stride * h);
+    float *cmp = malloc(sizeof(float) * stride * h);
+    float *ref_p = malloc(sizeof(float) * w * h);
+    float *cmp_p = malloc(sizeof(float) * w * h);
+    mu_assert("malloc failed", ref && cmp && ref_p && cmp_p);
+    fill(ref, cmp, w, h, stride, w * h);
+    for (int i = 0; i < h; i++) {
+        memcpy(ref_p + i * w, ref + i * stride, sizeof(float) * w);
+        memcpy(cmp_p + i * w, cmp + i * stride, sizeof(float) * w);
+    }
+
+    float l0, c0, s0, l, c, s;
+    const float ssim0 = _iqa_ssim(ref_p, cmp_p, w, h, k, NULL, NULL,
+                                  &l0, &c0, &s0);
+    const float ssim = _iqa_ssim_fused(e, ref, cmp, w, h, stride, k,
+                                       &l, &c, &s);
+
+    free(ref);
+    free(cmp);
+    free(ref_p);
+    free(cmp_p);
+
+    mu_assert("ssim should be a valid score", ssim0 > 0.f && ssim0 < 1.f);
+    mu_assert("fused ssim should match _iqa_ssim() exactly", ssim == ssim0);
+    mu_assert("fused l should match _iqa_ssim() exactly", l == l0);
+    mu_assert("fused c should match _iqa_ssim() exactly", c == c0);
+    mu_assert("fused s should match _iqa_ssim() exactly", s == s0);
+    return NULL;
+}
+
+static char *check_decimate(struct _ssim_engine *e, int w, int h,
+                            const struct _kernel *k)
+{
+    const int sw = w / 2 + (w & 1), sh = h / 2 + (h & 1);
+    float *img = malloc(sizeof(float) * w * h * 2);
+    float *dst0 = malloc(sizeof(float) * sw * sh);
+    float *dst = malloc(sizeof(float) * sw * sh);
+    mu_assert("malloc failed", img && dst0 && dst);
+    fill(img, img + w * h, w, h, w, w + h);
+
+    int rw, rh;
+    _iqa_decimate(img, w, h, 2, k, dst0, NULL, NULL);
+    _iqa_ssim_decimate(e, img, w, h, k, dst, &rw, &rh);
+    const int same = !memcmp(dst, dst0, sizeof(float) * sw * sh);
+
+    free(img);
+    free(dst0);
+    free(dst);
+
+    mu_assert("decimated size should be rounded up", rw == sw && rh == sh);
+    mu_assert("decimation should match _iqa_decimate() exactly", same);
+    return NULL;
+}
+
+static char *test_ssim_fused()
+{
+    float lpf[9 * 9], lpf_4[4 * 4];
+    for (unsigned i = 0; i < 9 * 9; i++)
+        lpf[i] = (float)((i * 37) % 19) / 81.f - 0.1f;
+    for (unsigned i = 0; i < 4 * 4; i++)
+        lpf_4[i] = 1.f / (i + 7);
+    const struct _kernel decimation[] = {
+        { .kernel = lpf, .w = 9, .h = 9, .normalized = 1,
+          .bnd_opt = KBND_SYMMETRIC },
+        { .kernel = lpf_4, .w = 4, .h = 4, .normalized = 1,
+          .bnd_opt = KBND_SYMMETRIC },
+    };
+
+    const struct _kernel gaussian = {
+        .kernel = (float *)g_gaussian_window,
+        .kernel_h = (float *)g_gaussian_window_h,
+        .kernel_v = (float *)g_gaussian_window_v,
+        .w = GAUSSIAN_LEN, .h = GAUSSIAN_LEN,
+        .normalized = 1, .bnd_opt = KBND_SYMMETRIC,
+    };
+    const int size[][3] = { { 352, 288, 352 }, { 97, 61, 104 }, { 11, 11, 16 } };
+
+    for (unsigned i = 0; i < sizeof(size) / sizeof(size[0]); i++) {
+        struct _ssim_engine e;
+        int err = _iqa_ssim_engine_init(&e, size[i][0], size[i][1]);
+        mu_assert("problem during _iqa_ssim_engine_init", !err);
+
+        char *msg = check_engine(&e, size[i][0], size[i][1], size[i][2],
+                                 &gaussian);
+        for (unsigned j = 0; !msg && j < 2; j++)
+            msg = check_decimate(&e, size[i][0], size[i][1], &decimation[j]);
+        _iqa_ssim_engine_close(&e);
+        if (msg) return msg;
+    }
+    return NULL;
+}
+
+#define SSIM_SCORE_CNT 4
+#define MS_SSIM_SCORE_CNT 16
+
+static const char *ssim_score_name[SSIM_SCORE_CNT] = {
+    "float_ssim", "float_ssim_l", "float_ssim_c", "float_ssim_s",
+};
+
+static const char *ms_ssim_score_name[MS_SSIM_SCORE_CNT] = {
+    "float_ms_ssim",
+    "float_ms_ssim_l_scale0", "float_ms_ssim_l_scale1",
+    "float_ms_ssim_l_scale2", "float_ms_ssim_l_scale3",
+    "float_ms_ssim_l_scale4",
+    "float_ms_ssim_c_scale0", "float_ms_ssim_c_scale1",
+    "float_ms_ssim_c_scale2", "float_ms_ssim_c_scale3",
+    "float_ms_ssim_c_scale4",
+    "float_ms_ssim_s_scale0", "float_ms_ssim_s_scale1",
+    "float_ms_ssim_s_scale2", "float_ms_ssim_s_scale3",
+    "float_ms_ssim_s_scale4",
+};
+
+// like fill(), in the picture sample range
+static void fill_pictures(VmafPicture *ref, VmafPicture *dist)
+{
+    const unsigned shift = ref->bpc - 8;
+    uint32_t seed = ref->w[0] * ref->h[0];
+
+    for (unsigned i = 0; i < ref->h[0]; i++) {
+        for (unsigned j = 0; j < ref->w[0]; j++) {
+            lcg_next(&seed);
+            const int r = (i / 16 + j / 16) % 3 ? (seed >> 24) : 128;
+            const int d = (i / 8) % 2 ? r : r + ((seed >> 8) & 15);
+            put_pixel(ref, j, i, r << shift);
+            put_pixel(dist, j, i, d << shift);
+        }
+    }
+}
+
+static int ssim_scores(VmafPicture *ref, VmafPicture *dist, double *ssim,
+                       double *ms_ssim)
+{
+    VmafDictionary *opts = NULL;
+    int err = vmaf_dictionary_set(&opts, "enable_lcs", "true", 0);
+    if (err) return err;
+    err = extract_scores("float_ssim", opts, ref, dist, ssim_score_name,
+                         SSIM_SCORE_CNT, ssim);
+    if (err) return err;
+
+    opts = NULL;
+    err = vmaf_dictionary_set(&opts, "enable_lcs", "true", 0);
+    if (err) return err;
+    return extract_scores("float_ms_ssim", opts, ref, dist,
+                          ms_ssim_score_name, MS_SSIM_SCORE_CNT, ms_ssim);
+}
+
+static char *test_ssim_simd()
+{
+    int err = 0;
+
+    // ms_ssim needs 176 pixels for its five scales
+    const unsigned w[] = { 352, 181 }, h[] = { 288, 177 };
+    const unsigned bpc[] = { 8, 10 };
+
+    vmaf_init_cpu();
+    const unsigned cpu_flags = vmaf_get_cpu_flags();
+
+    for (unsigned p = 0; p < sizeof(w) / sizeof(w[0]); p++) {
+        for (unsigned b = 0; b < sizeof(bpc) / sizeof(bpc[0]); b++) {
+            VmafPicture ref, dist;
+            err = vmaf_picture_alloc(&ref, VMAF_PIX_FMT_YUV400P, bpc[b],
+                                     w[p], h[p]);
+            mu_assert("problem during vmaf_picture_alloc", !err);
+            err = vmaf_picture_alloc(&dist, VMAF_PIX_FMT_YUV400P, bpc[b],
+                                     w[p], h[p]);
+            mu_assert("problem during vmaf_picture_alloc", !err);
+            fill_pictures(&ref, &dist);
+
+            double ssim0[SSIM_SCORE_CNT], ms_ssim0[MS_SSIM_SCORE_CNT];
+            vmaf_set_cpu_flags_mask(0);
+            err = ssim_scores(&ref, &dist, ssim0, ms_ssim0);
+            mu_assert("problem during ssim_scores", !err);
+            mu_assert("ssim should see the distortion",
+                      ssim0[0] > 0. && ssim0[0] < 1.);
+
+            // compare against the scalar code
+            for_each_cpu_mask(mask, cpu_flags) {
+                double ssim[SSIM_SCORE_CNT], ms_ssim[MS_SSIM_SCORE_CNT];
+                vmaf_set_cpu_flags_mask(mask);
+                err = ssim_scores(&ref, &dist, ssim, ms_ssim);
+                mu_assert("problem during ssim_scores", !err);
+                for (unsigned i = 0; i < SSIM_SCORE_CNT; i++) {
+                    mu_assert("vectorized ssim does not match the scalar code",
+                              ssim[i] == ssim0[i]);
+                }
+                for (unsigned i = 0; i < MS_SSIM_SCORE_CNT; i++) {
+                    mu_assert("vectorized ms_ssim does not match the scalar code",
+                              ms_ssim[i] == ms_ssim0[i]);
+                }
+            }
+
+            vmaf_picture_unref(&ref);
+            vmaf_picture_unref(&dist);
+        }
+    }
+    vmaf_set_cpu_flags_mask(-1);
+
+    return NULL;
+}
+
+char *run_tests()
+{
+    mu_run_test(test_ssim_fused);
+    mu_run_test(test_ssim_simd);
+    return NULL;
+}
@@ -16,7 +16,13 @@
  *
  */
 
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "test.h"
 #include "thread_pool.h"
@@ -77,8 +83,147 @@ static char *test_thread_pool_create_enqueue_wait_and_destroy()
     return NULL;
 }
 
+typedef struct Counter {
+    atomic_int *cnt;
+    unsigned char pad[2 * VMAF_THREAD_POOL_JOB_DATA_SZ];
+} Counter;
+
+static void fn_count(void *data)
+{
+    Counter *c = data;
+    for (unsigned i = 0; i < sizeof(c->pad); i++) {
+        if (c->pad[i] != (unsigned char) i) return;
+    }
+    atomic_fetch_add(c->cnt, 1);
+}
+
+typedef struct Nested {
+    VmafThreadPool *pool;
+    atomic_int *cnt;
+    unsigned depth;
+} Nested;
+
+static void fn_nested(void *data)
+{
+    Nested *n = data;
+    atomic_fetch_add(n->cnt, 1);
+    if (!n->depth) return;
+    Nested child = { n->pool, n->cnt, n->depth - 1 };
+    vmaf_thread_pool_enqueue(n->pool, fn_nested, &child, sizeof(child));
+    vmaf_thread_pool_enqueue(n->pool, fn_nested, &child, sizeof(child));
+}
+
+static char *test_thread_pool_large_payload_and_nested_enqueue()
+{
+    int err;
+
+    VmafThreadPool *pool;
+    err = vmaf_thread_pool_create(&pool, 4);
+    mu_assert("problem during vmaf_thread_pool_init", !err);
+
+    atomic_int cnt;
+    atomic_init(&cnt, 0);
+    Counter c = { .cnt = &cnt };
+    for (unsigned i = 0; i < sizeof(c.pad); i++)
+        c.pad[i] = i;
+    const unsigned n_jobs = 1000;
+    for (unsigned i = 0; i < n_jobs; i++) {
+        err = vmaf_thread_pool_enqueue(pool, fn_count, &c, sizeof(c));
+        mu_assert("problem during vmaf_thread_pool_enqueue", !err);
+    }
+    err = vmaf_thread_pool_wait(pool);
+    mu_assert("problem during vmaf_thread_pool_wait", !err);
+    mu_assert("large payloads should be passed intact",
+              atomic_load(&cnt) == n_jobs);
+
+    atomic_store(&cnt, 0);
+    Nested n = { pool, &cnt, 10 };
+    err = vmaf_thread_pool_enqueue(pool, fn_nested, &n, sizeof(n));
+    mu_assert("problem during vmaf_thread_pool_enqueue", !err);
+    err = vmaf_thread_pool_wait(pool);
+    mu_assert("problem during vmaf_thread_pool_wait", !err);
+    mu_assert("nested jobs should complete before wait returns",
+              atomic_load(&cnt) == (1 << 11) - 1);
+
+    err = vmaf_thread_pool_destroy(pool);
+    mu_assert("problem during vmaf_thread_pool_destroy", !err);
+
+    return NULL;
+}
+
+typedef struct Rendezvous {
+    VmafThreadPool *pool;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned cnt, target;
+    bool timeout;
+} Rendezvous;
+
+// blocks until target jobs are running at once, or a timeout
+static void fn_rendezvous(void *data)
+{
+    Rendezvous *r = *(Rendezvous **) data;
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 5;
+
+    pthread_mutex_lock(&(r->lock));
+    if (++r->cnt == r->target)
+        pthread_cond_broadcast(&(r->cond));
+    while (r->cnt < r->target && !r->timeout) {
+        if (pthread_cond_timedwait(&(r->cond), &(r->lock), &deadline))
+            r->timeout = true;
+    }
+    pthread_mutex_unlock(&(r->lock));
+}
+
+// enqueues the other jobs on its own worker, which they have to be stolen from
+static void fn_rendezvous_spawn(void *data)
+{
+    Rendezvous *r = *(Rendezvous **) data;
+    for (unsigned i = 1; i < r->target; i++)
+        vmaf_thread_pool_enqueue(r->pool, fn_rendezvous, &r, sizeof(r));
+    fn_rendezvous(data);
+}
+
+static char *test_thread_pool_wake_sleeping_workers()
+{
+    int err;
+    const unsigned n_threads = 4;
+
+    VmafThreadPool *pool;
+    err = vmaf_thread_pool_create(&pool, n_threads);
+    mu_assert("problem during vmaf_thread_pool_init", !err);
+
+    Rendezvous rendezvous = { .pool = pool, .target = n_threads };
+    Rendezvous *r = &rendezvous;
+    pthread_mutex_init(&(r->lock), NULL);
+    pthread_cond_init(&(r->cond), NULL);
+
+    // workers go to sleep between the rounds, and each round needs all of
+    // them: a lost wakeup leaves a job queued behind a blocked worker
+    for (unsigned i = 0; i < 200 && !r->timeout; i++) {
+        r->cnt = 0;
+        err = vmaf_thread_pool_enqueue(pool, fn_rendezvous_spawn, &r,
+                                       sizeof(r));
+        mu_assert("problem during vmaf_thread_pool_enqueue", !err);
+        err = vmaf_thread_pool_wait(pool);
+        mu_assert("problem during vmaf_thread_pool_wait", !err);
+    }
+
+    err = vmaf_thread_pool_destroy(pool);
+    mu_assert("problem during vmaf_thread_pool_destroy", !err);
+    pthread_cond_destroy(&(r->cond));
+    pthread_mutex_destroy(&(r->lock));
+    mu_assert("every worker should be woken for the queued jobs", !r->timeout);
+
+    return NULL;
+}
+
 char *run_tests()
 {
     mu_run_test(test_thread_pool_create_enqueue_wait_and_destroy);
+    mu_run_test(test_thread_pool_large_payload_and_nested_enqueue);
+    mu_run_test(test_thread_pool_wake_sleeping_workers);
     return NULL;
 }
@@ -19,6 +19,7 @@ enum {
     ARG_OUTPUT_JSON,
     ARG_OUTPUT_CSV,
     ARG_OUTPUT_SUB,
+    ARG_OUTPUT_BIN,
     ARG_THREADS,
     ARG_FEATURE,
     ARG_SUBSAMPLE,
@@ -28,6 +29,8 @@ enum {
     ARG_FRAME_CNT,
     ARG_FRAME_SKIP_REF,
     ARG_FRAME_SKIP_DIST,
+    ARG_FRAME_RANGE,
+    ARG_READ_AHEAD,
 };
 
 static const struct option long_opts[] = {
@@ -43,6 +46,7 @@ static const struct option long_opts[] = {
     { "json",             0, NULL, ARG_OUTPUT_JSON },
     { "csv",              0, NULL, ARG_OUTPUT_CSV },
     { "sub",              0, NULL, ARG_OUTPUT_SUB },
+    { "bin",              0, NULL, ARG_OUTPUT_BIN },
     { "threads",          1, NULL, ARG_THREADS },
     { "feature",          1, NULL, ARG_FEATURE },
     { "subsample",        1, NULL, ARG_SUBSAMPLE },
@@ -52,6 +56,8 @@ static const struct option long_opts[] = {
     { "frame_cnt",        1, NULL, ARG_FRAME_CNT },
     { "frame_skip_ref",   1, NULL, ARG_FRAME_SKIP_REF },
     { "frame_skip_dist",  1, NULL, ARG_FRAME_SKIP_DIST },
+    { "frame_range",      1, NULL, ARG_FRAME_RANGE },
+    { "read_ahead",       1, NULL, ARG_READ_AHEAD },
     { "no_prediction",    0, NULL, 'n' },
     { "version",          0, NULL, 'v' },
     { "quiet",            0, NULL, 'q' },
@@ -83,13 +89,18 @@ static void usage(const char *const app, const char *const reason, ...) {
             " --json:                      write output file as JSON\n"
             " --csv:                       write output file as CSV\n"
             " --sub:                       write output file as subtitle\n"
+            " --bin:                       write output file as binary columns\n"
             " --threads $unsigned:         number of threads to use\n"
             " --feature $string:           additional feature\n"
             " --cpumask: $bitmask          restrict permitted CPU instruction sets\n"
             " --frame_cnt $unsigned:       maximum number of frames to process\n"
             " --frame_skip_ref $unsigned:  skip the first N frames in reference\n"
             " --frame_skip_dist $unsigned: skip the first N frames in distorted\n"
+            " --frame_range $first:$last:  only process frames first to last,\n"
+            "                              seeking past the frames before\n"
             " --subsample: $unsigned       compute scores only every N frames\n"
+            " --read_ahead $unsigned:      frames read ahead per input on a separate\n"
+            "                              thread (default 4, 0 to disable)\n"
             " --quiet/-q:                  disable FPS meter when run in a TTY\n"
             " --no_prediction/-n:          no prediction, extract features only\n"
             " --version/-v:                print version and exit\n"
@@ -126,6 +137,20 @@ static unsigned parse_unsigned(const char *const optarg, const int option,
     return res;
 }
 
+static void parse_frame_range(const char *const optarg, const int option,
+                              const char *const app, unsigned *first,
+                              unsigned *last)
+{
+    char *end;
+    *first = (unsigned) strtoul(optarg, &end, 0);
+    if (*end != ':' || end == optarg)
+        error(app, optarg, option, "a frame range ($first:$last)");
+    const char *const last_str = end + 1;
+    *last = (unsigned) strtoul(last_str, &end, 0);
+    if (*end || end == last_str || *last < *first)
+        error(app, optarg, option, "a frame range ($first:$last)");
+}
+
 static unsigned parse_bitdepth(const char *const optarg, const int option,
                                const char *const app)
 {
@@ -370,7 +395,10 @@ void cli_parse(const int argc, char *const *const argv,
                CLISettings *const settings)
 {
     memset(settings, 0, sizeof(*settings));
+    settings->read_ahead = 4;
     int o;
+    bool frame_range = false;
+    unsigned frame_first = 0, frame_last = 0;
 
     while ((o = getopt_long(argc, argv, short_opts, long_opts, NULL)) >= 0) {
         switch (o) {
@@ -411,6 +439,9 @@ void cli_parse(const int argc, char *const *const argv,
         case ARG_OUTPUT_SUB:
             settings->output_fmt = VMAF_OUTPUT_FORMAT_SUB;
             break;
+        case ARG_OUTPUT_BIN:
+            settings->output_fmt = VMAF_OUTPUT_FORMAT_BIN;
+            break;
         case 'm':
             if (settings->model_cnt == CLI_SETTINGS_STATIC_ARRAY_LEN) {
                 usage(argv[0], "A maximum of %d models are supported\n",
@@ -452,6 +483,15 @@ void cli_parse(const int argc, char *const *const argv,
         case ARG_FRAME_SKIP_DIST:
             settings->frame_skip_dist = parse_unsigned(optarg, ARG_FRAME_SKIP_DIST, argv[0]);
             break;
+        case ARG_READ_AHEAD:
+            settings->read_ahead =
+                parse_unsigned(optarg, ARG_READ_AHEAD, argv[0]);
+            break;
+        case ARG_FRAME_RANGE:
+            parse_frame_range(optarg, ARG_FRAME_RANGE, argv[0],
+                              &frame_first, &frame_last);
+            frame_range = true;
+            break;
         case 'n':
             settings->no_prediction = true;
             break;
@@ -466,6 +506,14 @@ void cli_parse(const int argc, char *const *const argv,
         }
     }
 
+    if (frame_range) {
+        const unsigned frame_cnt = frame_last - frame_first + 1;
+        settings->frame_skip_ref += frame_first;
+        settings->frame_skip_dist += frame_first;
+        if (!settings->frame_cnt || settings->frame_cnt > frame_cnt)
+            settings->frame_cnt = frame_cnt;
+    }
+
     if (!settings->output_fmt)
         settings->output_fmt = VMAF_OUTPUT_FORMAT_XML;
     if (!settings->path_ref)
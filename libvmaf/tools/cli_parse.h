@@ -46,6 +46,7 @@ typedef struct {
     enum VmafLogLevel log_level;
     unsigned subsample;
     unsigned thread_cnt;
+    unsigned read_ahead;
     bool no_prediction;
     bool quiet;
     unsigned cpumask;
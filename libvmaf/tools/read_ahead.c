@@ -0,0 +1,125 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "read_ahead.h"
+
+typedef struct ReadAhead {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    ReadAheadFetch fetch;
+    void *cookie;
+    VmafPicture *pic;
+    unsigned depth, head, cnt;
+    // result of the fetch that ended the input, once the queue drains
+    int end;
+    bool done, stop;
+} ReadAhead;
+
+static void *read_ahead_thread(void *data)
+{
+    ReadAhead *ra = data;
+
+    pthread_mutex_lock(&ra->lock);
+    while (!ra->stop) {
+        if (ra->cnt == ra->depth) {
+            pthread_cond_wait(&ra->cond, &ra->lock);
+            continue;
+        }
+        pthread_mutex_unlock(&ra->lock);
+
+        VmafPicture pic;
+        int ret = ra->fetch(ra->cookie, &pic);
+
+        pthread_mutex_lock(&ra->lock);
+        if (ret) {
+            ra->end = ret;
+            ra->done = true;
+        } else {
+            ra->pic[(ra->head + ra->cnt++) % ra->depth] = pic;
+        }
+        pthread_cond_broadcast(&ra->cond);
+        if (ra->done) break;
+    }
+    pthread_mutex_unlock(&ra->lock);
+
+    return NULL;
+}
+
+int read_ahead_init(ReadAhead **ra, unsigned depth, ReadAheadFetch fetch,
+                    void *cookie)
+{
+    if (!ra) return -EINVAL;
+    if (!depth) return -EINVAL;
+    if (!fetch) return -EINVAL;
+
+    ReadAhead *const r = *ra = malloc(sizeof(*r));
+    if (!r) goto fail;
+    memset(r, 0, sizeof(*r));
+    r->pic = malloc(sizeof(*r->pic) * depth);
+    if (!r->pic) goto free_r;
+    r->depth = depth;
+    r->fetch = fetch;
+    r->cookie = cookie;
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->cond, NULL);
+    if (pthread_create(&r->thread, NULL, read_ahead_thread, r))
+        goto free_pic;
+
+    return 0;
+
+free_pic:
+    pthread_cond_destroy(&r->cond);
+    pthread_mutex_destroy(&r->lock);
+    free(r->pic);
+free_r:
+    free(r);
+    *ra = NULL;
+fail:
+    return -ENOMEM;
+}
+
+int read_ahead_fetch(ReadAhead *ra, VmafPicture *pic)
+{
+    if (!ra) return -EINVAL;
+    if (!pic) return -EINVAL;
+
+    int ret = 0;
+    pthread_mutex_lock(&ra->lock);
+    while (!ra->cnt && !ra->done)
+        pthread_cond_wait(&ra->cond, &ra->lock);
+    if (ra->cnt) {
+        *pic = ra->pic[ra->head];
+        ra->head = (ra->head + 1) % ra->depth;
+        ra->cnt--;
+        pthread_cond_broadcast(&ra->cond);
+    } else {
+        ret = ra->end;
+    }
+    pthread_mutex_unlock(&ra->lock);
+
+    return ret;
+}
+
+void read_ahead_close(ReadAhead *ra)
+{
+    if (!ra) return;
+
+    pthread_mutex_lock(&ra->lock);
+    ra->stop = true;
+    pthread_cond_broadcast(&ra->cond);
+    pthread_mutex_unlock(&ra->lock);
+    pthread_join(ra->thread, NULL);
+
+    for (; ra->cnt; ra->cnt--) {
+        vmaf_picture_unref(&ra->pic[ra->head]);
+        ra->head = (ra->head + 1) % ra->depth;
+    }
+    pthread_cond_destroy(&ra->cond);
+    pthread_mutex_destroy(&ra->lock);
+    free(ra->pic);
+    free(ra);
+}
@@ -0,0 +1,34 @@
+#ifndef __VMAF_READ_AHEAD_H__
+#define __VMAF_READ_AHEAD_H__
+
+#include "libvmaf/picture.h"
+
+/**
+ * Fetch the next picture of an input.
+ *
+ * @return 0 on success, 1 at the end of the input, < 0 on error.
+ */
+typedef int (*ReadAheadFetch)(void *cookie, VmafPicture *pic);
+
+/**
+ * Reads an input on its own thread, up to `depth` pictures ahead of the
+ * caller.
+ */
+typedef struct ReadAhead ReadAhead;
+
+int read_ahead_init(ReadAhead **ra, unsigned depth, ReadAheadFetch fetch,
+                    void *cookie);
+
+/**
+ * Take the next picture off the queue, waiting for it to be read.
+ * Returns like ReadAheadFetch, the end of the input or an error is returned
+ * again by every later call.
+ */
+int read_ahead_fetch(ReadAhead *ra, VmafPicture *pic);
+
+/**
+ * Stop the reader thread and drop the pictures it has read ahead.
+ */
+void read_ahead_close(ReadAhead *ra);
+
+#endif /* __VMAF_READ_AHEAD_H__ */
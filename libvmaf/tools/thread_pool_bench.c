@@ -0,0 +1,91 @@
+/**
+ *
+ *  Copyright 2016-2020 Netflix, Inc.
+ *
+ *     Licensed under the BSD+Patent License (the "License");
+ *     you may not use this file except in compliance with the License.
+ *     You may obtain a copy of the License at
+ *
+ *         https://opensource.org/licenses/BSDplusPatent
+ *
+ *     Unless required by applicable law or agreed to in writing, software
+ *     distributed under the License is distributed on an "AS IS" BASIS,
+ *     WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *     See the License for the specific language governing permissions and
+ *     limitations under the License.
+ *
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "thread_pool.h"
+
+/*
+ * Throughput and enqueue-to-run latency of the thread pool, for 1 to 64
+ * threads. Run it by hand; the behaviour is covered by test_thread_pool.
+ */
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+typedef struct BenchJob {
+    double enqueued;
+    double *latency;
+    atomic_int *cnt;
+} BenchJob;
+
+static void fn_bench(void *data)
+{
+    BenchJob *job = data;
+    const int i = atomic_fetch_add(job->cnt, 1);
+    job->latency[i] = now_us() - job->enqueued;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    const double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(void)
+{
+    int err = 0;
+    const unsigned n_jobs = 20000;
+    double *latency = malloc(sizeof(*latency) * n_jobs);
+    if (!latency) return EXIT_FAILURE;
+
+    for (unsigned n_threads = 1; !err && n_threads <= 64; n_threads *= 2) {
+        VmafThreadPool *pool;
+        err = vmaf_thread_pool_create(&pool, n_threads);
+        if (err) break;
+
+        atomic_int cnt;
+        atomic_init(&cnt, 0);
+        const double begin = now_us();
+        for (unsigned i = 0; !err && i < n_jobs; i++) {
+            BenchJob job = { now_us(), latency, &cnt };
+            err = vmaf_thread_pool_enqueue(pool, fn_bench, &job, sizeof(job));
+        }
+        err |= vmaf_thread_pool_wait(pool);
+        const double elapsed = now_us() - begin;
+        err |= vmaf_thread_pool_destroy(pool);
+        if (err) break;
+
+        qsort(latency, n_jobs, sizeof(*latency), cmp_double);
+        printf("threads: %2u, jobs/sec: %9.0f, latency p50: %8.1fus, "
+               "p99: %8.1fus, max: %8.1fus\n", n_threads,
+               n_jobs / (elapsed / 1e6), latency[n_jobs / 2],
+               latency[n_jobs * 99 / 100], latency[n_jobs - 1]);
+    }
+
+    free(latency);
+    if (err) fprintf(stderr, "problem running the thread pool\n");
+    return err ? EXIT_FAILURE : EXIT_SUCCESS;
+}
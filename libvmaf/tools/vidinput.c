@@ -25,6 +25,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
 #include "vidinput.h"
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#if defined(HAVE_MMAP)
+# include <sys/mman.h>
+#endif
 
 extern video_input_vtbl Y4M_INPUT_VTBL;
 extern video_input_vtbl YUV_INPUT_VTBL;
@@ -67,6 +71,61 @@ int video_input_fetch_frame(video_input *_vid,
   return (*_vid->vtbl->fetch_frame)(_vid->ctx,_vid->fin,_ycbcr,_tag);
 }
 
+int video_input_skip_frame(video_input *_vid) {
+  return (*_vid->vtbl->skip_frame)(_vid->ctx,_vid->fin);
+}
+
+int video_input_mapped(video_input *_vid) {
+  return (*_vid->vtbl->mapped)(_vid->ctx);
+}
+
+int video_input_map_open(video_input_map *_map,FILE *_fin){
+  memset(_map,0,sizeof(*_map));
+#if defined(HAVE_MMAP)
+  {
+    struct stat st;
+    off_t       pos;
+    void       *data;
+    /*Pipes and other unseekable inputs are read the usual way.*/
+    if(fstat(fileno(_fin),&st)<0||!S_ISREG(st.st_mode)||st.st_size<=0){
+      return -1;
+    }
+    pos=ftello(_fin);
+    if(pos<0||pos>st.st_size)return -1;
+    data=mmap(NULL,(size_t)st.st_size,PROT_READ,MAP_PRIVATE,fileno(_fin),0);
+    if(data==MAP_FAILED)return -1;
+    madvise(data,(size_t)st.st_size,MADV_SEQUENTIAL);
+    _map->data=(unsigned char *)data;
+    _map->sz=(size_t)st.st_size;
+    _map->pos=(size_t)pos;
+    return 0;
+  }
+#else
+  (void)_fin;
+  return -1;
+#endif
+}
+
+int video_input_seek(FILE *_fin,size_t _sz){
+  struct stat st;
+  off_t       pos;
+  /*fseeko() happily moves past the end of the file, so check what is left
+     first, the way the mapped path does.*/
+  if(fstat(fileno(_fin),&st)<0||!S_ISREG(st.st_mode))return -2;
+  pos=ftello(_fin);
+  if(pos<0||pos>st.st_size)return -2;
+  if(pos==st.st_size)return 0;
+  if((size_t)(st.st_size-pos)<_sz)return -1;
+  return fseeko(_fin,(off_t)_sz,SEEK_CUR)?-2:1;
+}
+
+void video_input_map_close(video_input_map *_map){
+#if defined(HAVE_MMAP)
+  if(_map->data!=NULL)munmap(_map->data,_map->sz);
+#endif
+  memset(_map,0,sizeof(*_map));
+}
+
 void video_input_close(video_input *_vid) {
   (*_vid->vtbl->close)(_vid->ctx);
   free(_vid->ctx);
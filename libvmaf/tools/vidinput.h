@@ -51,10 +51,28 @@ struct video_input_plane {
 };
 typedef struct video_input_plane video_input_ycbcr[3];
 
+/*A read-only mapping of an input file, so that frames can be handed out
+   without reading them into a buffer first.*/
+typedef struct video_input_map{
+  unsigned char *data;
+  size_t         sz;
+  /*The offset of the next frame.*/
+  size_t         pos;
+}video_input_map;
+
+int video_input_map_open(video_input_map *_map,FILE *_fin);
+void video_input_map_close(video_input_map *_map);
+/*Seeks past _sz bytes of a regular file.
+  Return: 1 on success, 0 if the file ends right here, -1 if it ends before
+   _sz bytes, or -2 if the input cannot be seeked and has to be read.*/
+int video_input_seek(FILE *_fin,size_t _sz);
+
 typedef void* (*video_input_open_func)(FILE *_fin);
 typedef void (*video_input_get_info_func)(void *_ctx,video_input_info *_ti);
 typedef int (*video_input_fetch_frame_func)(void *_ctx,FILE *_fin,
  video_input_ycbcr _ycbcr,char _tag[5]);
+typedef int (*video_input_skip_frame_func)(void *_ctx,FILE *_fin);
+typedef int (*video_input_mapped_func)(void *_ctx);
 typedef void (*video_input_close_func)(void *_ctx);
 typedef void* (*raw_input_open_func)(FILE *_fin,
                                      unsigned width, unsigned height,
@@ -68,6 +86,8 @@ struct video_input_vtbl {
   video_input_get_info_func     get_info;
   video_input_fetch_frame_func  fetch_frame;
   video_input_close_func        close;
+  video_input_skip_frame_func   skip_frame;
+  video_input_mapped_func       mapped;
 };
 
 struct video_input {
@@ -86,6 +106,12 @@ void video_input_close(video_input *_vid);
 void video_input_get_info(video_input *_vid, video_input_info *_ti);
 int video_input_fetch_frame(video_input *_vid, video_input_ycbcr _ycbcr,
                             char _tag[5]);
+/*Skip a frame without reading its data where the input allows seeking.
+  Returns 1 on success, 0 at the end of the input, and -1 on error.*/
+int video_input_skip_frame(video_input *_vid);
+/*Whether the frames returned by video_input_fetch_frame() point into a
+   mapping of the input file, and so stay valid until it is closed.*/
+int video_input_mapped(video_input *_vid);
 
 typedef enum {
   /** Chroma decimation by 2 in both the X and Y directions (4:2:0).
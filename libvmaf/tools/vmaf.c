@@ -1,9 +1,12 @@
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
 
 #include "cli_parse.h"
+#include "read_ahead.h"
 #include "spinner.h"
 #include "vidinput.h"
 
@@ -65,62 +68,105 @@ static int validate_videos(video_input *vid1, video_input *vid2)
     return err_cnt;
 }
 
-static int fetch_picture(video_input *vid, VmafPicture *pic)
+// frames of a mapped input are handed to libvmaf in place when they have
+// the layout of vmaf_picture_alloc(), others are copied into a pooled picture
+static bool can_wrap(video_input_info *info, uint8_t *const data[3],
+                     const ptrdiff_t stride[3])
+{
+    for (unsigned i = 0; i < 3; i++) {
+        const unsigned w =
+            i && info->pixel_fmt != PF_444 ? info->pic_w >> 1 : info->pic_w;
+        const ptrdiff_t aligned_w = ((w + 31) & ~31) << (info->depth > 8);
+        if (((uintptr_t) data[i] % 32) || (stride[i] % 32) ||
+            stride[i] < aligned_w)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int fetch_picture(video_input *vid, VmafPicturePool *pool,
+                         VmafPicture *pic)
 {
     int ret;
     video_input_ycbcr ycbcr;
     video_input_info info;
 
     ret = video_input_fetch_frame(vid, ycbcr, NULL);
-    if (ret < 1) return !ret;
+    if (ret < 1) return ret ? -1 : 1;
 
     video_input_get_info(vid, &info);
-    ret = vmaf_picture_alloc(pic, pix_fmt_map(info.pixel_fmt), info.depth,
-                             info.pic_w, info.pic_h);
-    if (ret) {
-        fprintf(stderr, "problem allocating picture.\n");
-        return -1;
-    }
 
-    if (info.depth == 8) {
-        for (unsigned i = 0; i < 3; i++) {
-            int xdec = i&&!(info.pixel_fmt&1);
-            int ydec = i&&!(info.pixel_fmt&2);
-            int xstride = info.depth > 8 ? 2 : 1;
-            uint8_t *ycbcr_data = ycbcr[i].data +
+    uint8_t *data[3];
+    ptrdiff_t stride[3];
+    for (unsigned i = 0; i < 3; i++) {
+        int xdec = i&&!(info.pixel_fmt&1);
+        int ydec = i&&!(info.pixel_fmt&2);
+        int xstride = info.depth > 8 ? 2 : 1;
+        if (info.depth == 8) {
+            data[i] = ycbcr[i].data +
                 (info.pic_y >> ydec) * ycbcr[i].stride +
                 (info.pic_x * xstride >> xdec);
-            // ^ gross, but this is how the daala y4m API works. FIXME.
-            uint8_t *pic_data = pic->data[i];
+        } else {
+            data[i] = (uint8_t *) ((uint16_t*) ycbcr[i].data +
+                (info.pic_y >> ydec) * (ycbcr[i].stride / 2) +
+                (info.pic_x * xstride >> xdec));
+        }
+        // ^ gross, but this is how the daala y4m API works. FIXME.
+        stride[i] = ycbcr[i].stride;
+    }
 
-            for (unsigned j = 0; j < pic->h[i]; j++) {
-                memcpy(pic_data, ycbcr_data, sizeof(*pic_data) * pic->w[i]);
-                pic_data += pic->stride[i];
-                ycbcr_data += ycbcr[i].stride;
-            }
+    if (video_input_mapped(vid) && can_wrap(&info, data, stride)) {
+        ret = vmaf_picture_wrap(pic, pix_fmt_map(info.pixel_fmt), info.depth,
+                                info.pic_w, info.pic_h, (void **) data,
+                                stride, NULL, NULL);
+        if (ret) {
+            fprintf(stderr, "problem wrapping picture.\n");
+            return -1;
         }
-    } else {
-        for (unsigned i = 0; i < 3; i++) {
-            int xdec = i&&!(info.pixel_fmt&1);
-            int ydec = i&&!(info.pixel_fmt&2);
-            int xstride = info.depth > 8 ? 2 : 1;
-            uint16_t *ycbcr_data = (uint16_t*) ycbcr[i].data +
-                (info.pic_y >> ydec) * (ycbcr[i].stride / 2) +
-                (info.pic_x * xstride >> xdec);
-            // ^ gross, but this is how the daala y4m API works. FIXME.
-            uint16_t *pic_data = pic->data[i];
+        return 0;
+    }
 
-            for (unsigned j = 0; j < pic->h[i]; j++) {
-                memcpy(pic_data, ycbcr_data, sizeof(*pic_data) * pic->w[i]);
-                pic_data += pic->stride[i] / 2;
-                ycbcr_data += ycbcr[i].stride / 2;
-            }
+    ret = vmaf_picture_pool_get(pool, pic);
+    if (ret) {
+        fprintf(stderr, "problem fetching picture from pool.\n");
+        return -1;
+    }
+
+    const int hbd = info.depth > 8;
+    for (unsigned i = 0; i < 3; i++) {
+        uint8_t *ycbcr_data = data[i];
+        uint8_t *pic_data = pic->data[i];
+
+        for (unsigned j = 0; j < pic->h[i]; j++) {
+            memcpy(pic_data, ycbcr_data, pic->w[i] << hbd);
+            pic_data += pic->stride[i];
+            ycbcr_data += stride[i];
         }
     }
 
     return 0;
 }
 
+typedef struct {
+    video_input *vid;
+    VmafPicturePool *pool;
+    ReadAhead *ra;
+} Input;
+
+static int fetch_input(void *cookie, VmafPicture *pic)
+{
+    Input *in = cookie;
+    return fetch_picture(in->vid, in->pool, pic);
+}
+
+static int next_picture(Input *in, VmafPicture *pic)
+{
+    if (in->ra) return read_ahead_fetch(in->ra, pic);
+    return fetch_picture(in->vid, in->pool, pic);
+}
+
 int main(int argc, char *argv[])
 {
     int err = 0;
@@ -306,13 +352,39 @@ int main(int argc, char *argv[])
         }
     }
 
-    VmafPicture pic_ref, pic_dist;
+    // one picture pair per worker, plus one being read and one queued,
+    // and those read ahead bounds the number of frames in flight
+    video_input_info info;
+    video_input_get_info(&vid_ref, &info);
+    VmafPicturePool *pic_pool;
+    err = vmaf_picture_pool_init(&pic_pool, pix_fmt_map(info.pixel_fmt),
+                                 info.depth, info.pic_w, info.pic_h,
+                                 2 * (c.thread_cnt + 2) +
+                                 2 * (c.read_ahead + 1));
+    if (err) {
+        fprintf(stderr, "problem allocating picture pool\n");
+        return -1;
+    }
+
+    for (unsigned i = 0; i < c.frame_skip_ref; i++) {
+        if (video_input_skip_frame(&vid_ref) < 1) break;
+    }
 
-    for (unsigned i = 0; i < c.frame_skip_ref; i++)
-        fetch_picture(&vid_ref, &pic_ref);
+    for (unsigned i = 0; i < c.frame_skip_dist; i++) {
+        if (video_input_skip_frame(&vid_dist) < 1) break;
+    }
 
-    for (unsigned i = 0; i < c.frame_skip_dist; i++)
-        fetch_picture(&vid_dist, &pic_dist);
+    Input in_ref = { .vid = &vid_ref, .pool = pic_pool };
+    Input in_dist = { .vid = &vid_dist, .pool = pic_pool };
+    if (c.read_ahead) {
+        err = read_ahead_init(&in_ref.ra, c.read_ahead, fetch_input, &in_ref);
+        err |= read_ahead_init(&in_dist.ra, c.read_ahead, fetch_input,
+                               &in_dist);
+        if (err) {
+            fprintf(stderr, "problem starting read-ahead threads\n");
+            return -1;
+        }
+    }
 
     float fps = 0.;
     const time_t t0 = clock();
@@ -323,8 +395,8 @@ int main(int argc, char *argv[])
             break;
 
         VmafPicture pic_ref, pic_dist;
-        int ret1 = fetch_picture(&vid_ref, &pic_ref);
-        int ret2 = fetch_picture(&vid_dist, &pic_dist);
+        int ret1 = next_picture(&in_ref, &pic_ref);
+        int ret2 = next_picture(&in_dist, &pic_dist);
 
         if (ret1 && ret2) {
             break;
@@ -364,6 +436,9 @@ int main(int argc, char *argv[])
     if (istty && !c.quiet)
         fprintf(stderr, "\n");
 
+    read_ahead_close(in_ref.ra);
+    read_ahead_close(in_dist.ra);
+
     err |= vmaf_read_pictures(vmaf, NULL, NULL, 0);
     if (err) {
         fprintf(stderr, "problem flushing context\n");
@@ -425,9 +500,11 @@ int main(int argc, char *argv[])
         vmaf_model_collection_destroy(model_collection[i]);
     free(model_collection);
 
+    // wrapped pictures point into the inputs, close those last
+    vmaf_close(vmaf);
+    vmaf_picture_pool_close(pic_pool);
     video_input_close(&vid_ref);
     video_input_close(&vid_dist);
-    vmaf_close(vmaf);
     cli_free(&c);
     return err;
 }
@@ -0,0 +1,121 @@
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "libvmaf/model.h"
+
+static const char short_opts[] = "i:o:cb:";
+
+static const struct option long_opts[] = {
+    { "input",      1, NULL, 'i' },
+    { "output",     1, NULL, 'o' },
+    { "collection", 0, NULL, 'c' },
+    { "bench",      1, NULL, 'b' },
+    { NULL,         0, NULL, 0 },
+};
+
+static void usage(const char *const app)
+{
+    fprintf(stderr, "Usage: %s [options]\n\n", app);
+    fprintf(stderr, "Supported options:\n"
+            " --input/-i $path:      path to .json model\n"
+            " --output/-o $path:     path to compiled binary model\n"
+            " --collection/-c:       input is a model collection\n"
+            " --bench/-b $unsigned:  time N loads of the input and output\n"
+           );
+    exit(1);
+}
+
+typedef struct {
+    VmafModel *model;
+    VmafModelCollection *model_collection;
+} Models;
+
+static int load(Models *m, const char *path, bool collection)
+{
+    VmafModelConfig cfg = { .flags = VMAF_MODEL_FLAGS_DEFAULT };
+    m->model_collection = NULL;
+    if (collection) {
+        return vmaf_model_collection_load_from_path(&m->model,
+                                                    &m->model_collection,
+                                                    &cfg, path);
+    }
+    return vmaf_model_load_from_path(&m->model, &cfg, path);
+}
+
+static void unload(Models *m)
+{
+    vmaf_model_destroy(m->model);
+    vmaf_model_collection_destroy(m->model_collection);
+}
+
+static double bench(const char *path, bool collection, unsigned cnt)
+{
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned i = 0; i < cnt; i++) {
+        Models m;
+        if (load(&m, path, collection)) return -1.;
+        unload(&m);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    const double ms = (end.tv_sec - start.tv_sec) * 1e3 +
+                      (end.tv_nsec - start.tv_nsec) / 1e6;
+    return ms / cnt;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *input = NULL, *output = NULL;
+    bool collection = false;
+    unsigned bench_cnt = 0;
+
+    int o;
+    while ((o = getopt_long(argc, argv, short_opts, long_opts, NULL)) >= 0) {
+        switch (o) {
+        case 'i':
+            input = optarg;
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        case 'c':
+            collection = true;
+            break;
+        case 'b':
+            bench_cnt = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (!input || !output) usage(argv[0]);
+
+    Models m;
+    int err = load(&m, input, collection);
+    if (err) {
+        fprintf(stderr, "could not load model: %s\n", input);
+        return -1;
+    }
+    err = vmaf_model_write_binary(m.model, m.model_collection, output);
+    unload(&m);
+    if (err) {
+        fprintf(stderr, "could not write model: %s\n", output);
+        return -1;
+    }
+
+    if (bench_cnt) {
+        const double ms_input = bench(input, collection, bench_cnt);
+        const double ms_output = bench(output, collection, bench_cnt);
+        if (ms_input < 0. || ms_output < 0.) {
+            fprintf(stderr, "could not load model during benchmark\n");
+            return -1;
+        }
+        fprintf(stderr, "load time: %.3f ms %s, %.3f ms %s\n",
+                ms_input, input, ms_output, output);
+    }
+
+    return 0;
+}
@@ -73,6 +73,8 @@ struct y4m_input{
   y4m_convert_func  convert;
   unsigned char    *dst_buf;
   unsigned char    *aux_buf;
+  /*The input file, if it could be mapped.*/
+  video_input_map   map;
 };
 
 static int y4m_parse_tags(y4m_input *_y4m,char *_tags){
@@ -701,6 +703,7 @@ static int y4m_input_open_impl(y4m_input *_y4m,FILE *_fin){
   _y4m->pic_y=(_y4m->frame_h-_y4m->pic_h)>>1&~1;
   _y4m->dst_buf=(unsigned char *)malloc(_y4m->dst_buf_sz);
   _y4m->aux_buf=_y4m->aux_buf_sz?(unsigned char *)malloc(_y4m->aux_buf_sz):NULL;
+  video_input_map_open(&_y4m->map,_fin);
   return 0;
 }
 
@@ -734,9 +737,40 @@ static void y4m_input_get_info(y4m_input *_y4m,video_input_info *_info){
   _info->depth=_y4m->depth;
 }
 
+/*Read and skip the frame header.
+  Returns 1 on success, 0 at the end of the input, and -1 on error.*/
+static int y4m_input_skip_frame_header(y4m_input *_y4m,FILE *_fin){
+  video_input_map *map;
+  char             frame[6];
+  map=&_y4m->map;
+  if(map->data!=NULL){
+    if(map->sz-map->pos<6)return 0;
+    memcpy(frame,map->data+map->pos,6);
+    map->pos+=6;
+  }
+  else if(fread(frame,1,6,_fin)<6)return 0;
+  if(memcmp(frame,"FRAME",5)){
+    fprintf(stderr,"Loss of framing in YUV input data\n");
+    return -1;
+  }
+  if(frame[5]!='\n'){
+    char c;
+    int  j;
+    if(map->data!=NULL){
+      for(j=0;j<79&&map->pos<map->sz&&(c=map->data[map->pos++])!='\n';j++);
+    }
+    else for(j=0;j<79&&fread(&c,1,1,_fin)&&c!='\n';j++);
+    if(j==79){
+      fprintf(stderr,"Error parsing YUV frame header\n");
+      return -1;
+    }
+  }
+  return 1;
+}
+
 static int y4m_input_fetch_frame(y4m_input *_y4m,FILE *_fin,
  video_input_ycbcr _ycbcr,char _tag[5]){
-  char frame[6];
+  unsigned char *dst_buf;
   int  pic_sz;
   int  frame_c_w;
   int  frame_c_h;
@@ -752,43 +786,52 @@ static int y4m_input_fetch_frame(y4m_input *_y4m,FILE *_fin,
   c_w=(_y4m->pic_w+_y4m->dst_c_dec_h-1)/_y4m->dst_c_dec_h;
   c_h=(_y4m->pic_h+_y4m->dst_c_dec_v-1)/_y4m->dst_c_dec_v;
   c_sz=c_w*c_h*xstride;
-  /*Read and skip the frame header.*/
-  ret=fread(frame,1,6,_fin);
-  if(ret<6)return 0;
-  if(memcmp(frame,"FRAME",5)){
-    fprintf(stderr,"Loss of framing in YUV input data\n");
-    return -1;
-  }
-  if(frame[5]!='\n'){
-    char c;
-    int  j;
-    for(j=0;j<79&&fread(&c,1,1,_fin)&&c!='\n';j++);
-    if(j==79){
-      fprintf(stderr,"Error parsing YUV frame header\n");
+  ret=y4m_input_skip_frame_header(_y4m,_fin);
+  if(ret<1)return ret;
+  dst_buf=_y4m->dst_buf;
+  if(_y4m->map.data!=NULL){
+    video_input_map *map;
+    unsigned char   *src;
+    map=&_y4m->map;
+    if(map->sz-map->pos<_y4m->dst_buf_read_sz+_y4m->aux_buf_read_sz){
+      fprintf(stderr,"Error reading YUV frame data.\n");
       return -1;
     }
+    src=map->data+map->pos;
+    map->pos+=_y4m->dst_buf_read_sz+_y4m->aux_buf_read_sz;
+    /*Frames that need no conversion are used in place.*/
+    if(_y4m->convert==y4m_convert_null)dst_buf=src;
+    else{
+      memcpy(_y4m->dst_buf,src,_y4m->dst_buf_read_sz);
+      memcpy(_y4m->aux_buf,src+_y4m->dst_buf_read_sz,_y4m->aux_buf_read_sz);
+      (*_y4m->convert)(_y4m,_y4m->dst_buf,_y4m->aux_buf);
+    }
   }
-  /*Read the frame data that needs no conversion.*/
-  if(fread(_y4m->dst_buf,1,_y4m->dst_buf_read_sz,_fin)!=_y4m->dst_buf_read_sz){
-    fprintf(stderr,"Error reading YUV frame data.\n");
-    return -1;
-  }
-  /*Read the frame data that does need conversion.*/
-  if(fread(_y4m->aux_buf,1,_y4m->aux_buf_read_sz,_fin)!=_y4m->aux_buf_read_sz){
-    fprintf(stderr,"Error reading YUV frame data.\n");
-    return -1;
+  else{
+    /*Read the frame data that needs no conversion.*/
+    if(fread(_y4m->dst_buf,1,_y4m->dst_buf_read_sz,_fin)!=
+     _y4m->dst_buf_read_sz){
+      fprintf(stderr,"Error reading YUV frame data.\n");
+      return -1;
+    }
+    /*Read the frame data that does need conversion.*/
+    if(fread(_y4m->aux_buf,1,_y4m->aux_buf_read_sz,_fin)!=
+     _y4m->aux_buf_read_sz){
+      fprintf(stderr,"Error reading YUV frame data.\n");
+      return -1;
+    }
+    /*Now convert the just read frame.*/
+    (*_y4m->convert)(_y4m,_y4m->dst_buf,_y4m->aux_buf);
   }
-  /*Now convert the just read frame.*/
-  (*_y4m->convert)(_y4m,_y4m->dst_buf,_y4m->aux_buf);
   /*Fill in the frame buffer pointers.*/
   _ycbcr[0].width=_y4m->frame_w;
   _ycbcr[0].height=_y4m->frame_h;
   _ycbcr[0].stride=_y4m->pic_w*xstride;
-  _ycbcr[0].data=_y4m->dst_buf-(_y4m->pic_x+_y4m->pic_y*_y4m->pic_w)*xstride;
+  _ycbcr[0].data=dst_buf-(_y4m->pic_x+_y4m->pic_y*_y4m->pic_w)*xstride;
   _ycbcr[1].width=frame_c_w;
   _ycbcr[1].height=frame_c_h;
   _ycbcr[1].stride=c_w*xstride;
-  _ycbcr[1].data=_y4m->dst_buf+pic_sz-((_y4m->pic_x/_y4m->dst_c_dec_h)+
+  _ycbcr[1].data=dst_buf+pic_sz-((_y4m->pic_x/_y4m->dst_c_dec_h)+
    (_y4m->pic_y/_y4m->dst_c_dec_v)*c_w)*xstride;
   _ycbcr[2].width=frame_c_w;
   _ycbcr[2].height=frame_c_h;
@@ -798,9 +841,43 @@ static int y4m_input_fetch_frame(y4m_input *_y4m,FILE *_fin,
   return 1;
 }
 
+static int y4m_input_skip_frame(y4m_input *_y4m,FILE *_fin){
+  size_t frame_sz;
+  int    ret;
+  ret=y4m_input_skip_frame_header(_y4m,_fin);
+  if(ret<1)return ret;
+  frame_sz=_y4m->dst_buf_read_sz+_y4m->aux_buf_read_sz;
+  if(_y4m->map.data!=NULL){
+    if(_y4m->map.sz-_y4m->map.pos<frame_sz){
+      fprintf(stderr,"Error reading YUV frame data.\n");
+      return -1;
+    }
+    _y4m->map.pos+=frame_sz;
+    return 1;
+  }
+  ret=video_input_seek(_fin,frame_sz);
+  if(ret==1)return 1;
+  if(ret!=-2){
+    fprintf(stderr,"Error reading YUV frame data.\n");
+    return -1;
+  }
+  /*Not seekable, read the frame instead.*/
+  if(fread(_y4m->dst_buf,1,_y4m->dst_buf_read_sz,_fin)!=_y4m->dst_buf_read_sz||
+   fread(_y4m->aux_buf,1,_y4m->aux_buf_read_sz,_fin)!=_y4m->aux_buf_read_sz){
+    fprintf(stderr,"Error reading YUV frame data.\n");
+    return -1;
+  }
+  return 1;
+}
+
+static int y4m_input_mapped(y4m_input *_y4m){
+  return _y4m->map.data!=NULL;
+}
+
 static void y4m_input_close(y4m_input *_y4m){
   free(_y4m->dst_buf);
   free(_y4m->aux_buf);
+  video_input_map_close(&_y4m->map);
 }
 
 OC_EXTERN const video_input_vtbl Y4M_INPUT_VTBL={
@@ -808,5 +885,7 @@ OC_EXTERN const video_input_vtbl Y4M_INPUT_VTBL={
   (video_input_open_func)y4m_input_open,
   (video_input_get_info_func)y4m_input_get_info,
   (video_input_fetch_frame_func)y4m_input_fetch_frame,
-  (video_input_close_func)y4m_input_close
+  (video_input_close_func)y4m_input_close,
+  (video_input_skip_frame_func)y4m_input_skip_frame,
+  (video_input_mapped_func)y4m_input_mapped
 };
@@ -21,6 +21,7 @@ typedef struct yuv_input {
     unsigned bitdepth;
     size_t dst_buf_sz;
     uint8_t *dst_buf;
+    video_input_map map;
     int src_c_dec_v, src_c_dec_h;
     int dst_c_dec_h, dst_c_dec_v;
 } yuv_input;
@@ -64,6 +65,12 @@ static yuv_input *yuv_input_open(FILE *_fin,
         goto fail; 
     }
 
+    // frames of a mapped file are handed out in place
+    if (!video_input_map_open(&yuv->map, _fin)) {
+        yuv->dst_buf = NULL;
+        return yuv;
+    }
+
     yuv->dst_buf = malloc(yuv->dst_buf_sz);
     if (!yuv->dst_buf) {
         fprintf(stderr, "Could not allocate yuv reader buffer.\n");
@@ -100,16 +107,35 @@ static void yuv_input_get_info(yuv_input *_yuv, video_input_info *_info)
     _info->depth = _yuv->bitdepth;
 }
 
-static int yuv_input_fetch_frame(yuv_input *yuv, FILE *fin,
-                                 video_input_ycbcr _ycbcr, char _tag[5])
+static int yuv_input_map_frame(yuv_input *yuv, uint8_t **buf)
 {
-    size_t bytes_read = fread(yuv->dst_buf, 1, yuv->dst_buf_sz, fin); 
-    if (bytes_read == 0) return 0;
-    if (bytes_read != yuv->dst_buf_sz) {
+    const size_t left = yuv->map.sz - yuv->map.pos;
+    if (left == 0) return 0;
+    if (left < yuv->dst_buf_sz) {
         fprintf(stderr, "Error reading YUV frame data.\n");
         return -1;
     }
-    
+    *buf = yuv->map.data + yuv->map.pos;
+    yuv->map.pos += yuv->dst_buf_sz;
+    return 1;
+}
+
+static int yuv_input_fetch_frame(yuv_input *yuv, FILE *fin,
+                                 video_input_ycbcr _ycbcr, char _tag[5])
+{
+    uint8_t *buf = yuv->dst_buf;
+    if (yuv->map.data) {
+        int ret = yuv_input_map_frame(yuv, &buf);
+        if (ret < 1) return ret;
+    } else {
+        size_t bytes_read = fread(yuv->dst_buf, 1, yuv->dst_buf_sz, fin);
+        if (bytes_read == 0) return 0;
+        if (bytes_read != yuv->dst_buf_sz) {
+            fprintf(stderr, "Error reading YUV frame data.\n");
+            return -1;
+        }
+    }
+
     (void) _tag;
 
     unsigned xstride = (yuv->bitdepth>8) ? 2 : 1;
@@ -123,11 +149,11 @@ static int yuv_input_fetch_frame(yuv_input *yuv, FILE *fin,
     _ycbcr[0].width = yuv->width;
     _ycbcr[0].height = yuv->height;
     _ycbcr[0].stride = yuv->width*xstride;
-    _ycbcr[0].data = yuv->dst_buf;
+    _ycbcr[0].data = buf;
     _ycbcr[1].width = frame_c_w;
     _ycbcr[1].height = frame_c_h;
     _ycbcr[1].stride = c_w*xstride;
-    _ycbcr[1].data = yuv->dst_buf + pic_sz;
+    _ycbcr[1].data = buf + pic_sz;
     _ycbcr[2].width = frame_c_w;
     _ycbcr[2].height = frame_c_h;
     _ycbcr[2].stride = c_w*xstride;
@@ -136,8 +162,35 @@ static int yuv_input_fetch_frame(yuv_input *yuv, FILE *fin,
     return 1;
 }
 
+static int yuv_input_skip_frame(yuv_input *yuv, FILE *fin)
+{
+    if (yuv->map.data) {
+        uint8_t *buf;
+        return yuv_input_map_frame(yuv, &buf);
+    }
+
+    int ret = video_input_seek(fin, yuv->dst_buf_sz);
+    if (ret == -1) fprintf(stderr, "Error reading YUV frame data.\n");
+    if (ret != -2) return ret;
+
+    // not seekable, read the frame instead
+    size_t bytes_read = fread(yuv->dst_buf, 1, yuv->dst_buf_sz, fin);
+    if (bytes_read == 0) return 0;
+    if (bytes_read != yuv->dst_buf_sz) {
+        fprintf(stderr, "Error reading YUV frame data.\n");
+        return -1;
+    }
+    return 1;
+}
+
+static int yuv_input_mapped(yuv_input *yuv)
+{
+    return yuv->map.data != NULL;
+}
+
 static void yuv_input_close(yuv_input *_yuv){
   free(_yuv->dst_buf);
+  video_input_map_close(&_yuv->map);
 }
 
 OC_EXTERN const video_input_vtbl YUV_INPUT_VTBL={
@@ -145,5 +198,7 @@ OC_EXTERN const video_input_vtbl YUV_INPUT_VTBL={
   (video_input_open_func)NULL,
   (video_input_get_info_func)yuv_input_get_info,
   (video_input_fetch_frame_func)yuv_input_fetch_frame,
-  (video_input_close_func)yuv_input_close
+  (video_input_close_func)yuv_input_close,
+  (video_input_skip_frame_func)yuv_input_skip_frame,
+  (video_input_mapped_func)yuv_input_mapped
 };